@@ -0,0 +1,767 @@
+#include "dart/biomechanics/BatchedMarkerIK.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "dart/common/Console.hpp"
+#include "dart/common/WorkStealingPool.hpp"
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/CustomJoint.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/EulerFreeJoint.hpp"
+#include "dart/dynamics/EulerJoint.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/TranslationalJoint.hpp"
+#include "dart/dynamics/UniversalJoint.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+namespace {
+
+/// Everything we need from a CustomJoint to flatten it, independent of its
+/// Dimension
+struct CustomJointInfo
+{
+  dynamics::EulerJoint::AxisOrder axisOrder;
+  Eigen::Vector3s flipAxisMap;
+  const math::CustomFunction* functions[6];
+  int drivenByDof[6];
+};
+
+//==============================================================================
+template <std::size_t Dimension>
+bool getCustomJointInfo(dynamics::Joint* joint, CustomJointInfo& info)
+{
+  dynamics::CustomJoint<Dimension>* custom
+      = dynamic_cast<dynamics::CustomJoint<Dimension>*>(joint);
+  if (custom == nullptr)
+  {
+    return false;
+  }
+  info.axisOrder = custom->getAxisOrder();
+  info.flipAxisMap = custom->getFlipAxisMap();
+  for (int i = 0; i < 6; i++)
+  {
+    info.functions[i] = custom->getCustomFunction(i).get();
+    info.drivenByDof[i] = custom->getCustomFunctionDrivenByDof(i);
+  }
+  return true;
+}
+
+//==============================================================================
+bool getCustomJointInfo(dynamics::Joint* joint, CustomJointInfo& info)
+{
+  return getCustomJointInfo<1>(joint, info)
+         || getCustomJointInfo<2>(joint, info)
+         || getCustomJointInfo<3>(joint, info)
+         || getCustomJointInfo<4>(joint, info)
+         || getCustomJointInfo<5>(joint, info)
+         || getCustomJointInfo<6>(joint, info);
+}
+
+//==============================================================================
+/// This returns the axis of each of the 3 rotations of an Euler joint, in the
+/// order they're applied
+void getEulerAxes(
+    dynamics::EulerJoint::AxisOrder order, Eigen::Vector3s (&axes)[3])
+{
+  switch (order)
+  {
+    case dynamics::EulerJoint::AxisOrder::XYZ:
+      axes[0] = Eigen::Vector3s::UnitX();
+      axes[1] = Eigen::Vector3s::UnitY();
+      axes[2] = Eigen::Vector3s::UnitZ();
+      break;
+    case dynamics::EulerJoint::AxisOrder::ZYX:
+      axes[0] = Eigen::Vector3s::UnitZ();
+      axes[1] = Eigen::Vector3s::UnitY();
+      axes[2] = Eigen::Vector3s::UnitX();
+      break;
+    case dynamics::EulerJoint::AxisOrder::ZXY:
+      axes[0] = Eigen::Vector3s::UnitZ();
+      axes[1] = Eigen::Vector3s::UnitX();
+      axes[2] = Eigen::Vector3s::UnitY();
+      break;
+    case dynamics::EulerJoint::AxisOrder::XZY:
+      axes[0] = Eigen::Vector3s::UnitX();
+      axes[1] = Eigen::Vector3s::UnitZ();
+      axes[2] = Eigen::Vector3s::UnitY();
+      break;
+  }
+}
+
+//==============================================================================
+bool isSupportedJoint(dynamics::Joint* joint)
+{
+  const std::string& type = joint->getType();
+  if (type == dynamics::WeldJoint::getStaticType()
+      || type == dynamics::RevoluteJoint::getStaticType()
+      || type == dynamics::PrismaticJoint::getStaticType()
+      || type == dynamics::UniversalJoint::getStaticType()
+      || type == dynamics::TranslationalJoint::getStaticType()
+      || type == dynamics::BallJoint::getStaticType()
+      || type == dynamics::FreeJoint::getStaticType()
+      || type == dynamics::EulerJoint::getStaticType()
+      || type == dynamics::EulerFreeJoint::getStaticType())
+  {
+    return true;
+  }
+  CustomJointInfo info;
+  return getCustomJointInfo(joint, info);
+}
+
+} // namespace
+
+//==============================================================================
+BatchedMarkerIK::BatchedMarkerIK(
+    std::shared_ptr<dynamics::Skeleton> skeleton,
+    const dynamics::MarkerMap& markers)
+  : mSkeleton(skeleton),
+    mMaxIterations(20),
+    mMaxColdStartIterations(200),
+    mConvergenceTolerance(1e-10),
+    mMinFramesPerChunk(32),
+    mIgnoreJointLimits(false)
+{
+  for (auto& pair : markers)
+  {
+    assert(pair.second.first->getSkeleton() == mSkeleton);
+    mMarkerNames.push_back(pair.first);
+    mMarkerBodies.push_back(pair.second.first);
+    mMarkerUnscaledOffsets.push_back(pair.second.second);
+  }
+  mMarkerWeights = Eigen::VectorXs::Ones(mMarkerNames.size());
+
+  if (!isSupported(mSkeleton))
+  {
+    dterr << "[BatchedMarkerIK] Skeleton \"" << mSkeleton->getName()
+          << "\" has joint types we can't flatten. Those joints will be held "
+             "fixed at their zero position.\n";
+  }
+
+  refreshFromSkeleton();
+}
+
+//==============================================================================
+bool BatchedMarkerIK::isSupported(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton)
+{
+  for (int i = 0; i < skeleton->getNumJoints(); i++)
+  {
+    if (!isSupportedJoint(skeleton->getJoint(i)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//==============================================================================
+void BatchedMarkerIK::refreshFromSkeleton()
+{
+  flattenSkeleton();
+
+  mMarkerBodyIndices.clear();
+  mMarkerOffsets.clear();
+  mMarkerColumnStart.clear();
+  mMarkerColumns.clear();
+  for (int i = 0; i < mMarkerBodies.size(); i++)
+  {
+    dynamics::BodyNode* body = mMarkerBodies[i];
+    mMarkerBodyIndices.push_back(body->getIndexInSkeleton());
+    mMarkerOffsets.push_back(
+        body->getScale().cwiseProduct(mMarkerUnscaledOffsets[i]));
+
+    // Only the motions on the chain from the root to this marker's body can
+    // move it
+    mMarkerColumnStart.push_back(mMarkerColumns.size());
+    for (int link = mMarkerBodyIndices[i]; link != -1;
+         link = mLinks[link].parent)
+    {
+      const Link& l = mLinks[link];
+      if (l.numMotions == 0)
+      {
+        continue;
+      }
+      const int firstColumn = mMotionColumns[l.firstMotion];
+      const int lastMotion = l.firstMotion + l.numMotions - 1;
+      const int endColumn = mMotionColumns[lastMotion]
+                            + (mMotions[lastMotion].type == EXP_MAP ? 3 : 1);
+      for (int c = firstColumn; c < endColumn; c++)
+      {
+        mMarkerColumns.push_back(c);
+      }
+    }
+  }
+  mMarkerColumnStart.push_back(mMarkerColumns.size());
+
+  mPositionUpperLimits = mSkeleton->getPositionUpperLimits();
+  mPositionLowerLimits = mSkeleton->getPositionLowerLimits();
+}
+
+//==============================================================================
+const std::vector<std::string>& BatchedMarkerIK::getMarkerNames() const
+{
+  return mMarkerNames;
+}
+
+//==============================================================================
+void BatchedMarkerIK::setMarkerWeights(const Eigen::VectorXs& weights)
+{
+  assert(weights.size() == mMarkerNames.size());
+  mMarkerWeights = weights;
+}
+
+//==============================================================================
+void BatchedMarkerIK::setMarkerWeight(const std::string& name, s_t weight)
+{
+  for (int i = 0; i < mMarkerNames.size(); i++)
+  {
+    if (mMarkerNames[i] == name)
+    {
+      mMarkerWeights(i) = weight;
+      return;
+    }
+  }
+}
+
+//==============================================================================
+void BatchedMarkerIK::setMaxIterations(int iterations)
+{
+  mMaxIterations = iterations;
+}
+
+//==============================================================================
+void BatchedMarkerIK::setMaxColdStartIterations(int iterations)
+{
+  mMaxColdStartIterations = iterations;
+}
+
+//==============================================================================
+void BatchedMarkerIK::setConvergenceTolerance(s_t tolerance)
+{
+  mConvergenceTolerance = tolerance;
+}
+
+//==============================================================================
+void BatchedMarkerIK::setMinFramesPerChunk(int frames)
+{
+  mMinFramesPerChunk = std::max(1, frames);
+}
+
+//==============================================================================
+void BatchedMarkerIK::setIgnoreJointLimits(bool ignore)
+{
+  mIgnoreJointLimits = ignore;
+}
+
+//==============================================================================
+Eigen::MatrixXs BatchedMarkerIK::flattenObservations(
+    const std::vector<std::map<std::string, Eigen::Vector3s>>& observations)
+    const
+{
+  Eigen::MatrixXs flat = Eigen::MatrixXs::Constant(
+      mMarkerNames.size() * 3,
+      observations.size(),
+      std::numeric_limits<s_t>::quiet_NaN());
+  for (int t = 0; t < observations.size(); t++)
+  {
+    for (int i = 0; i < mMarkerNames.size(); i++)
+    {
+      auto it = observations[t].find(mMarkerNames[i]);
+      if (it != observations[t].end())
+      {
+        flat.block<3, 1>(i * 3, t) = it->second;
+      }
+    }
+  }
+  return flat;
+}
+
+//==============================================================================
+Eigen::MatrixXs BatchedMarkerIK::solve(
+    const Eigen::MatrixXs& markerObservations,
+    const Eigen::VectorXs& initialGuess,
+    Eigen::VectorXs* losses)
+{
+  const int numFrames = markerObservations.cols();
+  const int numDofs = mSkeleton->getNumDofs();
+  assert(markerObservations.rows() == mMarkerNames.size() * 3);
+  assert(initialGuess.size() == numDofs);
+
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(numDofs, numFrames);
+  if (losses != nullptr)
+  {
+    losses->resize(numFrames);
+  }
+  if (numFrames == 0)
+  {
+    return poses;
+  }
+
+  std::shared_ptr<common::WorkStealingPool> pool
+      = common::WorkStealingPool::getCurrentPool();
+  const int numSlots = pool->getNumSlots();
+  while (mWorkspaces.size() < numSlots)
+  {
+    mWorkspaces.emplace_back();
+    allocateWorkspace(mWorkspaces.back());
+  }
+
+  // Every chunk starts cold, so we don't want more chunks than we can run at
+  // once, or chunks so short that the cold starts dominate
+  const int numChunks = std::max(
+      1, std::min(numSlots, numFrames / std::max(1, mMinFramesPerChunk)));
+  const int chunkLength = (numFrames + numChunks - 1) / numChunks;
+
+  pool->parallelFor(
+      0, numChunks, 1, [&](int slot, int chunkBegin, int chunkEnd) {
+        Workspace& workspace = mWorkspaces[slot];
+        for (int chunk = chunkBegin; chunk < chunkEnd; chunk++)
+        {
+          const int start = chunk * chunkLength;
+          const int end = std::min(numFrames, start + chunkLength);
+          workspace.q = initialGuess;
+          for (int t = start; t < end; t++)
+          {
+            s_t loss = solveFrame(
+                markerObservations.col(t),
+                t == start ? mMaxColdStartIterations : mMaxIterations,
+                workspace);
+            poses.col(t) = workspace.q;
+            if (losses != nullptr)
+            {
+              (*losses)(t) = loss;
+            }
+          }
+        }
+      });
+
+  return poses;
+}
+
+//==============================================================================
+Eigen::MatrixXs BatchedMarkerIK::solve(
+    const std::vector<std::map<std::string, Eigen::Vector3s>>& observations,
+    const Eigen::VectorXs& initialGuess,
+    Eigen::VectorXs* losses)
+{
+  return solve(flattenObservations(observations), initialGuess, losses);
+}
+
+//==============================================================================
+Eigen::VectorXs BatchedMarkerIK::getMarkerWorldPositions(
+    const Eigen::VectorXs& positions)
+{
+  Workspace workspace;
+  allocateWorkspace(workspace);
+  computeForwardKinematics(positions, workspace);
+  return workspace.markerPositions;
+}
+
+//==============================================================================
+Eigen::MatrixXs
+BatchedMarkerIK::getMarkerWorldPositionsJacobianWrtJointPositions(
+    const Eigen::VectorXs& positions)
+{
+  Workspace workspace;
+  allocateWorkspace(workspace);
+  computeForwardKinematics(positions, workspace);
+  // Pretend every marker is observed, and ignore the weights
+  computeJacobian(
+      Eigen::VectorXs::Zero(mMarkerNames.size() * 3), false, workspace);
+  return workspace.jac;
+}
+
+//==============================================================================
+void BatchedMarkerIK::flattenSkeleton()
+{
+  mLinks.clear();
+  mMotions.clear();
+  mMotionColumns.clear();
+  mColumns.clear();
+
+  auto addMotion = [&](MotionType type,
+                       const Eigen::Vector3s& axis,
+                       int dof,
+                       s_t scale,
+                       const math::CustomFunction* fn) {
+    Motion motion;
+    motion.type = type;
+    motion.axis = axis;
+    motion.dof = dof;
+    motion.scale = scale;
+    motion.fn = fn;
+    mMotions.push_back(motion);
+    mMotionColumns.push_back(mColumns.size());
+    const int numColumns = type == EXP_MAP ? 3 : 1;
+    for (int i = 0; i < numColumns; i++)
+    {
+      JacobianColumn column;
+      column.dof = dof + i;
+      column.isRotation = type != TRANSLATION;
+      mColumns.push_back(column);
+    }
+  };
+
+  for (int i = 0; i < mSkeleton->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = mSkeleton->getBodyNode(i);
+    dynamics::Joint* joint = body->getParentJoint();
+
+    Link link;
+    link.parent = body->getParentBodyNode() == nullptr
+                      ? -1
+                      : body->getParentBodyNode()->getIndexInSkeleton();
+    assert(link.parent < i);
+    link.parentToJoint = joint->getTransformFromParentBodyNode();
+    link.jointToChild = joint->getTransformFromChildBodyNode().inverse();
+    link.firstMotion = mMotions.size();
+
+    const int dof = joint->getNumDofs() > 0
+                        ? joint->getDof(0)->getIndexInSkeleton()
+                        : -1;
+    const std::string& type = joint->getType();
+    CustomJointInfo custom;
+
+    if (type == dynamics::WeldJoint::getStaticType())
+    {
+      // No motions
+    }
+    else if (type == dynamics::RevoluteJoint::getStaticType())
+    {
+      addMotion(
+          ROTATION,
+          static_cast<dynamics::RevoluteJoint*>(joint)->getAxis(),
+          dof,
+          1.0,
+          nullptr);
+    }
+    else if (type == dynamics::PrismaticJoint::getStaticType())
+    {
+      addMotion(
+          TRANSLATION,
+          static_cast<dynamics::PrismaticJoint*>(joint)->getAxis(),
+          dof,
+          1.0,
+          nullptr);
+    }
+    else if (type == dynamics::UniversalJoint::getStaticType())
+    {
+      dynamics::UniversalJoint* universal
+          = static_cast<dynamics::UniversalJoint*>(joint);
+      addMotion(ROTATION, universal->getAxis1(), dof, 1.0, nullptr);
+      addMotion(ROTATION, universal->getAxis2(), dof + 1, 1.0, nullptr);
+    }
+    else if (type == dynamics::TranslationalJoint::getStaticType())
+    {
+      for (int axis = 0; axis < 3; axis++)
+      {
+        addMotion(
+            TRANSLATION, Eigen::Vector3s::Unit(axis), dof + axis, 1.0, nullptr);
+      }
+    }
+    else if (type == dynamics::BallJoint::getStaticType())
+    {
+      addMotion(EXP_MAP, Eigen::Vector3s::Zero(), dof, 1.0, nullptr);
+    }
+    else if (type == dynamics::FreeJoint::getStaticType())
+    {
+      // FreeJoint positions are [expmap, translation], and the translation is
+      // applied before the rotation
+      for (int axis = 0; axis < 3; axis++)
+      {
+        addMotion(
+            TRANSLATION,
+            Eigen::Vector3s::Unit(axis),
+            dof + 3 + axis,
+            1.0,
+            nullptr);
+      }
+      addMotion(EXP_MAP, Eigen::Vector3s::Zero(), dof, 1.0, nullptr);
+    }
+    else if (
+        type == dynamics::EulerJoint::getStaticType()
+        || type == dynamics::EulerFreeJoint::getStaticType())
+    {
+      dynamics::EulerJoint::AxisOrder order;
+      Eigen::Vector3s flips;
+      if (type == dynamics::EulerJoint::getStaticType())
+      {
+        dynamics::EulerJoint* euler = static_cast<dynamics::EulerJoint*>(joint);
+        order = euler->getAxisOrder();
+        flips = euler->getFlipAxisMap();
+      }
+      else
+      {
+        dynamics::EulerFreeJoint* euler
+            = static_cast<dynamics::EulerFreeJoint*>(joint);
+        order = euler->getAxisOrder();
+        flips = euler->getFlipAxisMap();
+        // EulerFreeJoint positions are [euler, translation], and the
+        // translation is applied before the rotation
+        for (int axis = 0; axis < 3; axis++)
+        {
+          addMotion(
+              TRANSLATION,
+              Eigen::Vector3s::Unit(axis),
+              dof + 3 + axis,
+              1.0,
+              nullptr);
+        }
+      }
+      Eigen::Vector3s axes[3];
+      getEulerAxes(order, axes);
+      for (int k = 0; k < 3; k++)
+      {
+        addMotion(ROTATION, axes[k], dof + k, flips(k), nullptr);
+      }
+    }
+    else if (getCustomJointInfo(joint, custom))
+    {
+      // CustomJoint maps its DOFs through 6 custom functions, to an Euler
+      // rotation and a translation that's applied before it
+      for (int axis = 0; axis < 3; axis++)
+      {
+        addMotion(
+            TRANSLATION,
+            Eigen::Vector3s::Unit(axis),
+            dof + custom.drivenByDof[3 + axis],
+            1.0,
+            custom.functions[3 + axis]);
+      }
+      Eigen::Vector3s axes[3];
+      getEulerAxes(custom.axisOrder, axes);
+      for (int k = 0; k < 3; k++)
+      {
+        addMotion(
+            ROTATION,
+            axes[k],
+            dof + custom.drivenByDof[k],
+            custom.flipAxisMap(k),
+            custom.functions[k]);
+      }
+    }
+
+    link.numMotions = mMotions.size() - link.firstMotion;
+    mLinks.push_back(link);
+  }
+}
+
+//==============================================================================
+void BatchedMarkerIK::allocateWorkspace(Workspace& workspace) const
+{
+  const int numDofs = mSkeleton->getNumDofs();
+  const int numRows = mMarkerNames.size() * 3;
+  workspace.bodyTransforms.resize(
+      mLinks.size(), Eigen::Isometry3s::Identity());
+  workspace.columnAxes = Eigen::Matrix<s_t, 3, Eigen::Dynamic>::Zero(
+      3, mColumns.size());
+  workspace.columnOrigins = Eigen::Matrix<s_t, 3, Eigen::Dynamic>::Zero(
+      3, mColumns.size());
+  workspace.markerPositions = Eigen::VectorXs::Zero(numRows);
+  workspace.residual = Eigen::VectorXs::Zero(numRows);
+  workspace.jac = Eigen::MatrixXs::Zero(numRows, numDofs);
+  workspace.hessian = Eigen::MatrixXs::Zero(numDofs, numDofs);
+  workspace.damped = Eigen::MatrixXs::Zero(numDofs, numDofs);
+  workspace.gradient = Eigen::VectorXs::Zero(numDofs);
+  workspace.step = Eigen::VectorXs::Zero(numDofs);
+  workspace.q = Eigen::VectorXs::Zero(numDofs);
+  workspace.candidate = Eigen::VectorXs::Zero(numDofs);
+  workspace.solver = Eigen::LDLT<Eigen::MatrixXs>(numDofs);
+}
+
+//==============================================================================
+void BatchedMarkerIK::computeForwardKinematics(
+    const Eigen::VectorXs& q, Workspace& workspace) const
+{
+  for (int i = 0; i < mLinks.size(); i++)
+  {
+    const Link& link = mLinks[i];
+    Eigen::Isometry3s frame
+        = link.parent == -1
+              ? link.parentToJoint
+              : workspace.bodyTransforms[link.parent] * link.parentToJoint;
+
+    for (int m = link.firstMotion; m < link.firstMotion + link.numMotions; m++)
+    {
+      const Motion& motion = mMotions[m];
+      const int column = mMotionColumns[m];
+
+      if (motion.type == EXP_MAP)
+      {
+        const Eigen::Vector3s expmap = q.segment<3>(motion.dof);
+        const Eigen::Matrix3s expJac = math::expMapJac(expmap);
+        for (int k = 0; k < 3; k++)
+        {
+          workspace.columnAxes.col(column + k)
+              = frame.linear() * expJac.col(k);
+          workspace.columnOrigins.col(column + k) = frame.translation();
+        }
+        frame.linear() = frame.linear() * math::expMapRot(expmap);
+        continue;
+      }
+
+      const s_t x = q(motion.dof);
+      s_t value = motion.scale * x;
+      s_t derivative = motion.scale;
+      if (motion.fn != nullptr)
+      {
+        value = motion.scale * motion.fn->calcValue(x);
+        derivative = motion.scale * motion.fn->calcDerivative(1, x);
+      }
+      const Eigen::Vector3s worldAxis = frame.linear() * motion.axis;
+      workspace.columnAxes.col(column) = worldAxis * derivative;
+      workspace.columnOrigins.col(column) = frame.translation();
+
+      if (motion.type == ROTATION)
+      {
+        frame.linear() = frame.linear() * math::expMapRot(motion.axis * value);
+      }
+      else
+      {
+        frame.translation() += worldAxis * value;
+      }
+    }
+
+    workspace.bodyTransforms[i] = frame * link.jointToChild;
+  }
+
+  for (int i = 0; i < mMarkerBodyIndices.size(); i++)
+  {
+    workspace.markerPositions.segment<3>(i * 3)
+        = workspace.bodyTransforms[mMarkerBodyIndices[i]] * mMarkerOffsets[i];
+  }
+}
+
+//==============================================================================
+void BatchedMarkerIK::computeJacobian(
+    const Eigen::Ref<const Eigen::VectorXs>& observation,
+    bool applyWeights,
+    Workspace& workspace) const
+{
+  workspace.jac.setZero();
+  for (int i = 0; i < mMarkerBodyIndices.size(); i++)
+  {
+    if (std::isnan(observation(i * 3)))
+    {
+      continue;
+    }
+    const s_t weight = applyWeights ? std::sqrt(mMarkerWeights(i)) : 1.0;
+    const Eigen::Vector3s marker = workspace.markerPositions.segment<3>(i * 3);
+    for (int c = mMarkerColumnStart[i]; c < mMarkerColumnStart[i + 1]; c++)
+    {
+      const int column = mMarkerColumns[c];
+      const Eigen::Vector3s axis = workspace.columnAxes.col(column);
+      if (mColumns[column].isRotation)
+      {
+        workspace.jac.block<3, 1>(i * 3, mColumns[column].dof)
+            += weight
+               * axis.cross(marker - workspace.columnOrigins.col(column));
+      }
+      else
+      {
+        workspace.jac.block<3, 1>(i * 3, mColumns[column].dof)
+            += weight * axis;
+      }
+    }
+  }
+}
+
+//==============================================================================
+s_t BatchedMarkerIK::computeResidual(
+    const Eigen::Ref<const Eigen::VectorXs>& observation,
+    Workspace& workspace) const
+{
+  for (int i = 0; i < mMarkerBodyIndices.size(); i++)
+  {
+    if (std::isnan(observation(i * 3)))
+    {
+      workspace.residual.segment<3>(i * 3).setZero();
+    }
+    else
+    {
+      workspace.residual.segment<3>(i * 3)
+          = std::sqrt(mMarkerWeights(i))
+            * (workspace.markerPositions.segment<3>(i * 3)
+               - observation.segment<3>(i * 3));
+    }
+  }
+  return workspace.residual.squaredNorm();
+}
+
+//==============================================================================
+void BatchedMarkerIK::clampToLimits(Eigen::VectorXs& q) const
+{
+  if (!mIgnoreJointLimits)
+  {
+    q = q.cwiseMax(mPositionLowerLimits).cwiseMin(mPositionUpperLimits);
+  }
+}
+
+//==============================================================================
+s_t BatchedMarkerIK::solveFrame(
+    const Eigen::Ref<const Eigen::VectorXs>& observation,
+    int maxIterations,
+    Workspace& workspace) const
+{
+  clampToLimits(workspace.q);
+  computeForwardKinematics(workspace.q, workspace);
+  s_t loss = computeResidual(observation, workspace);
+
+  s_t lambda = 1e-3;
+  for (int iteration = 0; iteration < maxIterations; iteration++)
+  {
+    computeJacobian(observation, true, workspace);
+    workspace.hessian.noalias() = workspace.jac.transpose() * workspace.jac;
+    workspace.gradient.noalias()
+        = workspace.jac.transpose() * workspace.residual;
+
+    // Levenberg-Marquardt: keep raising the damping until we find a step that
+    // lowers the loss, or give up on this frame
+    bool improved = false;
+    s_t improvement = 0.0;
+    while (!improved && lambda < 1e10)
+    {
+      workspace.damped = workspace.hessian;
+      workspace.damped.diagonal().array()
+          += lambda * (workspace.hessian.diagonal().array() + 1e-6);
+      workspace.solver.compute(workspace.damped);
+      workspace.step = workspace.solver.solve(workspace.gradient);
+      workspace.candidate = workspace.q - workspace.step;
+      clampToLimits(workspace.candidate);
+
+      computeForwardKinematics(workspace.candidate, workspace);
+      const s_t candidateLoss = computeResidual(observation, workspace);
+      if (candidateLoss < loss)
+      {
+        improved = true;
+        improvement = loss - candidateLoss;
+        loss = candidateLoss;
+        workspace.q.swap(workspace.candidate);
+        lambda = std::max(lambda * 0.1, 1e-9);
+      }
+      else
+      {
+        lambda *= 10;
+      }
+    }
+
+    if (!improved || improvement < mConvergenceTolerance)
+    {
+      break;
+    }
+  }
+
+  return loss;
+}
+
+} // namespace biomechanics
+} // namespace dart
@@ -0,0 +1,268 @@
+#ifndef DART_BIOMECH_BATCHED_MARKER_IK_HPP_
+#define DART_BIOMECH_BATCHED_MARKER_IK_HPP_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/CustomFunction.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+/**
+ * This is a dedicated IK engine for fitting a fixed skeleton (with fixed body
+ * scales) to a fixed set of markers, over many frames at once.
+ *
+ * MarkerFitter's IK goes through a cloned Skeleton for every solve, which
+ * means every iteration pays for the generic BodyNode transform updates and a
+ * handful of Eigen allocations. This instead pre-extracts the kinematic tree
+ * into flat arrays when it's constructed: one entry per body with its parent
+ * index and fixed joint offsets, and one entry per elementary motion (a
+ * rotation or translation about a fixed axis, or an exponential map rotation)
+ * that each joint is composed of. Forward kinematics and the marker Jacobian
+ * are then a single pass over those arrays, into per-thread workspaces that
+ * are allocated once up front.
+ *
+ * Frames are split into contiguous chunks, which are solved in parallel on the
+ * shared WorkStealingPool. Within a chunk, each frame is warm started from the
+ * solution to the previous frame.
+ *
+ * Supported joint types are WeldJoint, RevoluteJoint, PrismaticJoint,
+ * UniversalJoint, TranslationalJoint, BallJoint, FreeJoint, EulerJoint,
+ * EulerFreeJoint and CustomJoint. Use isSupported() to check a skeleton before
+ * relying on this.
+ *
+ * The engine copies the body scales and marker offsets when it's constructed,
+ * so call refreshFromSkeleton() after rescaling the skeleton.
+ */
+class BatchedMarkerIK
+{
+public:
+  BatchedMarkerIK(
+      std::shared_ptr<dynamics::Skeleton> skeleton,
+      const dynamics::MarkerMap& markers);
+
+  /// Returns true if every joint in `skeleton` is one that we know how to
+  /// flatten
+  static bool isSupported(const std::shared_ptr<dynamics::Skeleton>& skeleton);
+
+  /// This re-reads the joint offsets, body scales, marker offsets and joint
+  /// limits from the skeleton, without re-allocating anything. Call this after
+  /// changing the scales of the skeleton.
+  void refreshFromSkeleton();
+
+  /// The names of the markers, in the order used by every flattened marker
+  /// vector this class takes or returns
+  const std::vector<std::string>& getMarkerNames() const;
+
+  /// Sets the weight of each marker in the IK loss, in getMarkerNames() order.
+  /// The default is 1.0 for every marker.
+  void setMarkerWeights(const Eigen::VectorXs& weights);
+
+  /// Sets the weight of a single marker in the IK loss
+  void setMarkerWeight(const std::string& name, s_t weight);
+
+  /// The maximum number of Levenberg-Marquardt iterations per frame, for frames
+  /// that are warm started from the previous frame
+  void setMaxIterations(int iterations);
+
+  /// The first frame of every chunk has no previous frame to warm start from,
+  /// so it gets this many iterations instead
+  void setMaxColdStartIterations(int iterations);
+
+  /// We stop iterating on a frame once a step changes the loss by less than
+  /// this much
+  void setConvergenceTolerance(s_t tolerance);
+
+  /// Chunks of frames solved in parallel are at least this long, since the
+  /// first frame of every chunk has to be solved without a warm start
+  void setMinFramesPerChunk(int frames);
+
+  /// If true, we don't clamp solutions to the joint position limits
+  void setIgnoreJointLimits(bool ignore);
+
+  /// This flattens marker observations into a (3 * numMarkers) x numFrames
+  /// matrix, in getMarkerNames() order. Markers that weren't observed on a
+  /// frame are filled in with NaN.
+  Eigen::MatrixXs flattenObservations(
+      const std::vector<std::map<std::string, Eigen::Vector3s>>& observations)
+      const;
+
+  /// This solves IK for every column of `markerObservations`, which should be
+  /// (3 * numMarkers) x numFrames, in getMarkerNames() order. NaN entries are
+  /// treated as unobserved. Returns a numDofs x numFrames matrix of poses.
+  ///
+  /// If `losses` is not null, it's resized to numFrames and filled with the
+  /// final weighted sum of squared marker errors for each frame.
+  ///
+  /// This reuses per-thread scratch space owned by this object, so don't call
+  /// solve() on the same object from several threads at once.
+  Eigen::MatrixXs solve(
+      const Eigen::MatrixXs& markerObservations,
+      const Eigen::VectorXs& initialGuess,
+      Eigen::VectorXs* losses = nullptr);
+
+  /// This is the same as solve(), but takes observations in the same format
+  /// that MarkerFitter does
+  Eigen::MatrixXs solve(
+      const std::vector<std::map<std::string, Eigen::Vector3s>>& observations,
+      const Eigen::VectorXs& initialGuess,
+      Eigen::VectorXs* losses = nullptr);
+
+  /// This computes the world positions of the markers at `positions`, using
+  /// the flattened kinematics. This is mostly useful for testing against
+  /// Skeleton::getMarkerWorldPositions().
+  Eigen::VectorXs getMarkerWorldPositions(const Eigen::VectorXs& positions);
+
+  /// This computes the Jacobian of getMarkerWorldPositions() wrt the joint
+  /// positions, using the flattened kinematics. This is mostly useful for
+  /// testing against
+  /// Skeleton::getMarkerWorldPositionsJacobianWrtJointPositions().
+  Eigen::MatrixXs getMarkerWorldPositionsJacobianWrtJointPositions(
+      const Eigen::VectorXs& positions);
+
+protected:
+  enum MotionType
+  {
+    ROTATION,
+    TRANSLATION,
+    EXP_MAP
+  };
+
+  /// One elementary motion of a joint. Each joint's transform is the product
+  /// of its motions, applied in order.
+  struct Motion
+  {
+    MotionType type;
+    /// The axis to rotate about or translate along, in the frame after all the
+    /// earlier motions of the same joint. Unused for EXP_MAP.
+    Eigen::Vector3s axis;
+    /// The skeleton DOF that drives this motion. For EXP_MAP this is the first
+    /// of 3 consecutive DOFs.
+    int dof;
+    /// The motion's value is `scale * q(dof)`, or `scale * fn(q(dof))` if `fn`
+    /// is set. Unused for EXP_MAP.
+    s_t scale;
+    const math::CustomFunction* fn;
+  };
+
+  /// One body of the flattened tree. Bodies are stored in skeleton order, so
+  /// every body comes after its parent.
+  struct Link
+  {
+    /// The index of the parent body, or -1 if the parent is the world
+    int parent;
+    Eigen::Isometry3s parentToJoint;
+    Eigen::Isometry3s jointToChild;
+    int firstMotion;
+    int numMotions;
+  };
+
+  /// One column of the marker Jacobian contributed by a motion. EXP_MAP
+  /// motions contribute 3 columns, everything else contributes 1.
+  struct JacobianColumn
+  {
+    int dof;
+    bool isRotation;
+  };
+
+  /// Scratch space for solving a frame. There's one of these per pool slot,
+  /// allocated up front, so solving doesn't allocate.
+  struct Workspace
+  {
+    std::vector<Eigen::Isometry3s> bodyTransforms;
+    /// The world axis of each Jacobian column, scaled by the derivative of the
+    /// motion's value wrt its DOF
+    Eigen::Matrix<s_t, 3, Eigen::Dynamic> columnAxes;
+    /// A point on the world axis of each rotational Jacobian column
+    Eigen::Matrix<s_t, 3, Eigen::Dynamic> columnOrigins;
+    Eigen::VectorXs markerPositions;
+    Eigen::VectorXs residual;
+    Eigen::MatrixXs jac;
+    Eigen::MatrixXs hessian;
+    Eigen::MatrixXs damped;
+    Eigen::VectorXs gradient;
+    Eigen::VectorXs step;
+    Eigen::VectorXs q;
+    Eigen::VectorXs candidate;
+    Eigen::LDLT<Eigen::MatrixXs> solver;
+  };
+
+  /// This walks the skeleton and fills in mLinks and mMotions
+  void flattenSkeleton();
+
+  /// This sizes a workspace for this skeleton and marker set
+  void allocateWorkspace(Workspace& workspace) const;
+
+  /// This runs forward kinematics at `q`, filling in the body transforms,
+  /// Jacobian column axes, and marker world positions of `workspace`
+  void computeForwardKinematics(
+      const Eigen::VectorXs& q, Workspace& workspace) const;
+
+  /// This fills in `workspace.jac` from the last call to
+  /// computeForwardKinematics(), for the markers observed in `observation`.
+  /// If `applyWeights` is true, each marker's rows are scaled by the square
+  /// root of its weight, to match computeResidual().
+  void computeJacobian(
+      const Eigen::Ref<const Eigen::VectorXs>& observation,
+      bool applyWeights,
+      Workspace& workspace) const;
+
+  /// This fills in `workspace.residual` from the last call to
+  /// computeForwardKinematics(), and returns the weighted loss
+  s_t computeResidual(
+      const Eigen::Ref<const Eigen::VectorXs>& observation,
+      Workspace& workspace) const;
+
+  /// This clamps `q` to the joint limits, unless we're ignoring them
+  void clampToLimits(Eigen::VectorXs& q) const;
+
+  /// This runs Levenberg-Marquardt on a single frame, starting from (and
+  /// overwriting) `workspace.q`. Returns the final loss.
+  s_t solveFrame(
+      const Eigen::Ref<const Eigen::VectorXs>& observation,
+      int maxIterations,
+      Workspace& workspace) const;
+
+  std::shared_ptr<dynamics::Skeleton> mSkeleton;
+  std::vector<std::string> mMarkerNames;
+  std::vector<dynamics::BodyNode*> mMarkerBodies;
+  std::vector<Eigen::Vector3s> mMarkerUnscaledOffsets;
+
+  std::vector<Link> mLinks;
+  std::vector<Motion> mMotions;
+  /// The first Jacobian column of each motion
+  std::vector<int> mMotionColumns;
+  std::vector<JacobianColumn> mColumns;
+
+  /// The body index of each marker, and its offset scaled by the body scale
+  std::vector<int> mMarkerBodyIndices;
+  std::vector<Eigen::Vector3s> mMarkerOffsets;
+  /// For each marker, the Jacobian columns that can move it are
+  /// mMarkerColumns[mMarkerColumnStart[i]..mMarkerColumnStart[i+1]]
+  std::vector<int> mMarkerColumnStart;
+  std::vector<int> mMarkerColumns;
+  Eigen::VectorXs mMarkerWeights;
+
+  Eigen::VectorXs mPositionUpperLimits;
+  Eigen::VectorXs mPositionLowerLimits;
+
+  int mMaxIterations;
+  int mMaxColdStartIterations;
+  s_t mConvergenceTolerance;
+  int mMinFramesPerChunk;
+  bool mIgnoreJointLimits;
+
+  std::vector<Workspace> mWorkspaces;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -1,5 +1,6 @@
 #include "dart/biomechanics/CortexStreaming.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <future>
 #include <iostream>
@@ -18,6 +19,102 @@ using namespace biomechanics;
 
 #define XEMPTY 9999999.0f
 
+namespace {
+
+/// Each force plate sample is packed as 7 floats: X,Y,Z, fX,fY,fZ, mZ
+constexpr int kForcePlateSampleBytes = 7 * sizeof(float);
+
+/// This returns false if `nForcePlates` plates of `nForceSamples` samples each
+/// can't fit in the `nBytes` left in a packet. We check this before sizing any
+/// buffers, so a corrupt count can't make us allocate huge matrices.
+bool forcePlateCountsFit(int nForcePlates, int nForceSamples, int nBytes)
+{
+  if (nForcePlates < 0 || nForceSamples < 0
+      || nForcePlates > nBytes / kForcePlateSampleBytes)
+  {
+    return false;
+  }
+  // This can't overflow, since we just checked it's at most nBytes
+  const int plateBytes = kForcePlateSampleBytes * std::max(nForcePlates, 1);
+  return nForceSamples <= nBytes / plateBytes;
+}
+
+//==============================================================================
+/// This reads a value out of a Cortex packet and advances past it. Returns
+/// false, without reading anything, if there aren't enough bytes left.
+template <typename T>
+bool readPacketValue(char*& ptr, int& nBytes, T& value)
+{
+  if (nBytes < static_cast<int>(sizeof(T)))
+  {
+    return false;
+  }
+  memcpy(&value, ptr, sizeof(T));
+  ptr += sizeof(T);
+  nBytes -= sizeof(T);
+  return true;
+}
+
+//==============================================================================
+/// This skips over `numBytes` of a Cortex packet. Returns false if there
+/// aren't that many bytes left.
+bool skipPacketBytes(char*& ptr, int& nBytes, int numBytes)
+{
+  if (numBytes < 0 || nBytes < numBytes)
+  {
+    return false;
+  }
+  ptr += numBytes;
+  nBytes -= numBytes;
+  return true;
+}
+
+//==============================================================================
+/// This skips over `count` elements of `elementSize` bytes each. Returns false
+/// if `count` is negative or there aren't that many bytes left, checking
+/// before multiplying so a corrupt `count` can't overflow.
+bool skipPacketArray(char*& ptr, int& nBytes, int count, int elementSize)
+{
+  if (count < 0 || (elementSize > 0 && count > nBytes / elementSize))
+  {
+    return false;
+  }
+  return skipPacketBytes(ptr, nBytes, count * elementSize);
+}
+
+//==============================================================================
+/// This returns `prefix` + `index`, from a table that only grows, so that
+/// repeated lookups don't allocate
+const std::string& getPlaceholderName(
+    std::vector<std::string>& table, const char* prefix, int index)
+{
+  while (table.size() <= index)
+  {
+    table.push_back(prefix + std::to_string(table.size()));
+  }
+  return table[index];
+}
+
+//==============================================================================
+/// This appends a marker to a frame buffer, converting from Cortex's
+/// millimeters in a Z-up frame to meters in our Y-up frame
+void appendMarker(
+    CortexFrameBuffer& buffer, const std::string* name, const float* xyz)
+{
+  if (buffer.numMarkers == buffer.markers.cols())
+  {
+    const int capacity = std::max<int>(16, buffer.markers.cols() * 2);
+    buffer.markers.conservativeResize(3, capacity);
+    buffer.markerNames.resize(capacity);
+  }
+  buffer.markerNames[buffer.numMarkers] = name;
+  buffer.markers.col(buffer.numMarkers)
+      = Eigen::Vector3s(xyz[0] * 0.001, xyz[2] * 0.001, xyz[1] * 0.001);
+  buffer.numMarkers++;
+}
+
+} // namespace
+
 //==============================================================================
 CortexStreaming::CortexStreaming(
     std::string cortexNicAddress,
@@ -68,6 +165,15 @@ void CortexStreaming::setFrameHandler(
   mFrameHandler = handler;
 }
 
+//==============================================================================
+/// This sets a callback that gets called with each frame of data, decoded
+/// into a buffer that gets reused from frame to frame
+void CortexStreaming::setFrameBufferHandler(
+    std::function<void(const CortexFrameBuffer& frame)> handler)
+{
+  mFrameBufferHandler = handler;
+}
+
 //==============================================================================
 /// This is used for mocking the Cortex API server for local testing. This
 /// sets the current body defs and frame of data to send back to the client.
@@ -1251,6 +1357,19 @@ int CortexStreaming::parseAnalogDefs(
 //==============================================================================
 void CortexStreaming::parseAndHandleFrameOfData(char* data, int nBytes)
 {
+  if (mFrameBufferHandler != nullptr)
+  {
+    if (!parseFrameOfDataIntoBuffer(data, nBytes, mFrameBuffer))
+    {
+      std::cout << "ERROR in parseAndHandleFrameOfData(), dropping a malformed "
+                   "frame of data"
+                << std::endl;
+      return;
+    }
+    mFrameBufferHandler(mFrameBuffer);
+    return;
+  }
+
   auto result = parseFrameOfData(data, nBytes);
 
   std::vector<std::string> markerNames;
@@ -1360,6 +1479,10 @@ CortexFrameOfData CortexStreaming::parseFrameOfData(char* data, int nBytes)
     int consumedBytes = nBytes - pair.second;
     ptr += consumedBytes;
     nBytes = pair.second;
+    if (nBytes <= 0)
+    {
+      return result;
+    }
   }
 
   // Unnamed markers
@@ -1476,6 +1599,155 @@ CortexFrameOfData CortexStreaming::parseFrameOfData(char* data, int nBytes)
   */
 }
 
+//==============================================================================
+bool CortexStreaming::parseFrameOfDataIntoBuffer(
+    char* data, int nBytes, CortexFrameBuffer& buffer)
+{
+  buffer.numMarkers = 0;
+  buffer.numForcePlates = 0;
+
+  char* ptr = data;
+  int nBodies = 0;
+  if (!readPacketValue(ptr, nBytes, buffer.cortexFrameNumber)
+      || !readPacketValue(ptr, nBytes, nBodies))
+  {
+    return false;
+  }
+  if (nBodies < 0 || nBodies > MAX_N_BODIES)
+  {
+    std::cout << "nBodies parameter is out of range" << std::endl;
+    return false;
+  }
+
+  for (int iBody = 0; iBody < nBodies; iBody++)
+  {
+    // Skip the name of the object
+    if (!skipPacketBytes(ptr, nBytes, strnlen(ptr, nBytes) + 1))
+    {
+      return false;
+    }
+
+    const std::vector<std::string>* markerNames = nullptr;
+    if (iBody < mBodyDefs.bodyDefs.size())
+    {
+      markerNames = &mBodyDefs.bodyDefs[iBody].markerNames;
+    }
+    int nMarkers = 0;
+    if (!readPacketValue(ptr, nBytes, nMarkers))
+    {
+      return false;
+    }
+    for (int iMarker = 0; iMarker < nMarkers; iMarker++)
+    {
+      float xyz[3];
+      if (!readPacketValue(ptr, nBytes, xyz))
+      {
+        return false;
+      }
+      if (xyz[0] == XEMPTY)
+      {
+        continue;
+      }
+      const std::string* name
+          = (markerNames != nullptr && iMarker < markerNames->size())
+                ? &(*markerNames)[iMarker]
+                : &getPlaceholderName(mPlaceholderMarkerNames, "MKR_", iMarker);
+      appendMarker(buffer, name, xyz);
+    }
+
+    // Skip the segments and the DOFs
+    int nSegments = 0;
+    int nDofs = 0;
+    if (!readPacketValue(ptr, nBytes, nSegments)
+        || !skipPacketArray(ptr, nBytes, nSegments, sizeof(tSegmentData))
+        || !readPacketValue(ptr, nBytes, nDofs)
+        || !skipPacketArray(ptr, nBytes, nDofs, 4))
+    {
+      return false;
+    }
+  }
+
+  // Unnamed markers
+  int nMarkers = 0;
+  if (!readPacketValue(ptr, nBytes, nMarkers))
+  {
+    return false;
+  }
+  for (int iMarker = 0; iMarker < nMarkers; iMarker++)
+  {
+    float xyz[3];
+    if (!readPacketValue(ptr, nBytes, xyz))
+    {
+      return false;
+    }
+    if (xyz[0] == XEMPTY)
+    {
+      continue;
+    }
+    appendMarker(
+        buffer,
+        &getPlaceholderName(mUnidentifiedMarkerNames, "UNIDENTIFIED_", iMarker),
+        xyz);
+  }
+
+  // Skip the raw analog channels
+  int nChannels = 0;
+  int nSamples = 0;
+  if (!readPacketValue(ptr, nBytes, nChannels)
+      || !readPacketValue(ptr, nBytes, nSamples) || nChannels < 0
+      || nChannels > nBytes / 2
+      || !skipPacketArray(ptr, nBytes, nSamples, nChannels * 2))
+  {
+    return false;
+  }
+
+  // The force plates
+  int nForcePlates = 0;
+  int nForceSamples = 0;
+  if (!readPacketValue(ptr, nBytes, nForcePlates)
+      || !readPacketValue(ptr, nBytes, nForceSamples))
+  {
+    return false;
+  }
+  if (!forcePlateCountsFit(nForcePlates, nForceSamples, nBytes))
+  {
+    std::cout << "Force plate counts are out of range" << std::endl;
+    return false;
+  }
+  if (buffer.plateCopTorqueForce.size() < nForcePlates)
+  {
+    buffer.plateCopTorqueForce.resize(nForcePlates);
+  }
+  for (int iForcePlate = 0; iForcePlate < nForcePlates; iForcePlate++)
+  {
+    Eigen::MatrixXs& plate = buffer.plateCopTorqueForce[iForcePlate];
+    if (plate.rows() != nForceSamples || plate.cols() != 9)
+    {
+      plate.resize(nForceSamples, 9);
+    }
+    plate.setZero();
+  }
+  buffer.numForcePlates = nForcePlates;
+  for (int iForceSample = 0; iForceSample < nForceSamples; iForceSample++)
+  {
+    for (int iForcePlate = 0; iForcePlate < nForcePlates; iForcePlate++)
+    {
+      // X,Y,Z, fX,fY,fZ, mZ
+      float raw[7];
+      if (!readPacketValue(ptr, nBytes, raw))
+      {
+        return false;
+      }
+      Eigen::Matrix<s_t, 1, 9> row;
+      row << raw[0] * 0.001, raw[2] * 0.001, raw[1] * 0.001, 0, raw[6], 0,
+          raw[3], raw[5], raw[4];
+      buffer.plateCopTorqueForce[iForcePlate].row(iForceSample) = row;
+    }
+  }
+
+  return true;
+}
+
 //==============================================================================
 std::pair<CortexBodyData, int> CortexStreaming::parseBodyData(
     char* ptr, int nBytes, int iBody)
@@ -1560,10 +1832,18 @@ std::pair<CortexBodyData, int> CortexStreaming::parseBodyData(
     return std::make_pair(result, nBytes);
   }
 
+  if (nSegments < 0
+      || nSegments > nBytes / static_cast<int>(sizeof(tSegmentData)))
+  {
+    std::cout << "ERROR in parseBodyData(), nSegments is out of range"
+              << std::endl;
+    return std::make_pair(result, -1);
+  }
   int segmentBytes = nSegments * sizeof(tSegmentData);
 
   // Ignore the segments
 
+  ptr += segmentBytes;
   nBytes -= segmentBytes;
   if (nBytes <= 0)
   {
@@ -1655,6 +1935,13 @@ std::pair<CortexAnalogData, int> CortexStreaming::parseAnalogData(
   {
     return std::make_pair(result, nBytes);
   }
+  if (!forcePlateCountsFit(nForcePlates, nForceSamples, nBytes))
+  {
+    std::cout << "ERROR in parseAnalogData(), force plate counts are out of "
+                 "range"
+              << std::endl;
+    return std::make_pair(result, -1);
+  }
   result.numForcePlateSamplesPerFrame = nForceSamples;
 
   for (int iForcePlate = 0; iForcePlate < nForcePlates; iForcePlate++)
@@ -1,6 +1,7 @@
 #ifndef DART_CORTEX_STREAMING_HPP_
 #define DART_CORTEX_STREAMING_HPP_
 
+#include <functional>
 #include <future>
 #include <iostream>
 #include <string>
@@ -109,6 +110,32 @@ typedef struct CortexFrameOfData
 
 } CortexFrameOfData;
 
+/// This is a reusable buffer that frames of Cortex data get decoded into on
+/// the allocation free parsing path. Its vectors and matrices only ever grow,
+/// so once it has seen the largest frame of a session, decoding a frame doesn't
+/// touch the heap. Only the first `numMarkers` markers and `numForcePlates`
+/// force plates are valid for the current frame.
+typedef struct CortexFrameBuffer
+{
+  int cortexFrameNumber = 0;
+
+  /// The number of observed markers in this frame. Markers that Cortex reports
+  /// as missing are skipped.
+  int numMarkers = 0;
+  /// The name of each marker. These point into the body defs (or a table of
+  /// placeholder names), so they're only valid until the handler returns.
+  std::vector<const std::string*> markerNames;
+  /// Each column is a marker, already converted to meters and to our Y-up
+  /// frame
+  Eigen::Matrix<s_t, 3, Eigen::Dynamic> markers;
+
+  /// The number of force plates in this frame
+  int numForcePlates = 0;
+  /// Each force plate gets an Nx9 matrix of (CoP, torque, force) samples, where
+  /// each row is a sample, converted the same way as the markers
+  std::vector<Eigen::MatrixXs> plateCopTorqueForce;
+} CortexFrameBuffer;
+
 //////////////////////////////////////////////////////////
 // The actual implementation class
 class CortexStreaming
@@ -128,6 +155,14 @@ public:
           std::vector<Eigen::Vector3s> markers,
           std::vector<Eigen::MatrixXs> copTorqueForces)> handler);
 
+  /// This sets a callback that gets called with each frame of data, decoded
+  /// into a buffer that gets reused from frame to frame, so that parsing
+  /// doesn't allocate. The buffer (including the marker name pointers in it)
+  /// is only valid until the handler returns. If this is set, it's called
+  /// instead of the handler from setFrameHandler().
+  void setFrameBufferHandler(
+      std::function<void(const CortexFrameBuffer& frame)> handler);
+
   /// This is used for mocking the Cortex API server for local testing. This
   /// sets the current body defs and frame of data to send back to the client.
   void mockServerSetData(
@@ -211,6 +246,14 @@ public:
   std::pair<CortexBodyData, int> parseBodyData(
       char* ptr, int nBytes, int iBody);
   std::pair<CortexAnalogData, int> parseAnalogData(char* ptr, int nBytes);
+  /// This decodes a frame of data straight into `buffer`, skipping the parts
+  /// the frame handlers don't use (segments, DOFs and raw analog channels),
+  /// and applying the same unit and axis conversions that
+  /// parseAndHandleFrameOfData() does. Returns false if the packet was
+  /// truncated or has an out of range count, in which case `buffer` holds
+  /// whatever was decoded before that.
+  bool parseFrameOfDataIntoBuffer(
+      char* data, int nBytes, CortexFrameBuffer& buffer);
 
 protected:
   std::function<void(
@@ -218,6 +261,12 @@ protected:
       std::vector<Eigen::Vector3s> markers,
       std::vector<Eigen::MatrixXs> copTorqueForces)>
       mFrameHandler;
+  std::function<void(const CortexFrameBuffer& frame)> mFrameBufferHandler;
+  CortexFrameBuffer mFrameBuffer;
+  /// Names for markers that the body defs don't name, built as needed so
+  /// frame buffers can point to them
+  std::vector<std::string> mPlaceholderMarkerNames;
+  std::vector<std::string> mUnidentifiedMarkerNames;
 
   CortexBodyDefs mBodyDefs;
   CortexFrameOfData mFrameOfData;
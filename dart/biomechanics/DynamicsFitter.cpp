@@ -2,7 +2,6 @@
 
 #include <algorithm>
 #include <climits>
-#include <future>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -27,6 +26,7 @@
 #include "dart/biomechanics/ForcePlate.hpp"
 #include "dart/biomechanics/MarkerFitter.hpp"
 #include "dart/biomechanics/MarkerLabeller.hpp"
+#include "dart/biomechanics/SkeletonClonePool.hpp"
 #include "dart/biomechanics/SkeletonConverter.hpp"
 #include "dart/biomechanics/SubjectOnDisk.hpp"
 #include "dart/biomechanics/enums.hpp"
@@ -56,7 +56,7 @@ using namespace Ipopt;
 //==============================================================================
 ResidualForceHelper::ResidualForceHelper(
     std::shared_ptr<dynamics::Skeleton> skeleton, std::vector<int> forceBodies)
-  : mSkel(skeleton), mForceBodies(forceBodies)
+  : mSkel(skeleton), mForceBodies(forceBodies), mNumThreads(16)
 {
   for (int i : forceBodies)
   {
@@ -1969,26 +1969,17 @@ ResidualForceHelper::getRootTrajectoryLinearSystem(
   std::vector<Eigen::Matrix6s> dAcc_dOffsetVels;
   dAcc_dOffsetVels.resize(numTimesteps, Eigen::Matrix6s::Zero());
 
-  int numThreads = 16;
-  std::vector<std::future<void>> futures;
-  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
-  {
-    std::shared_ptr<dynamics::Skeleton> skel = mSkel->cloneSkeleton();
-    futures.push_back(std::async([skel,
-                                  threadIdx,
-                                  numTimesteps,
-                                  numThreads,
-                                  &qs,
-                                  &dqs,
-                                  &ddqs,
-                                  &forces,
-                                  &dAcc_dOffsetPoses,
-                                  &dAcc_dOffsetVels,
-                                  this] {
-      ResidualForceHelper threadHelper(skel, mForceBodies);
-      for (int t = 1; t < numTimesteps; t++)
-      {
-        if ((t - threadIdx) % numThreads == 0)
+  std::shared_ptr<common::WorkStealingPool> pool
+      = common::WorkStealingPool::getCurrentPool();
+  prepareThreadSkels(pool->getNumSlots(mNumThreads));
+  pool->parallelFor(
+      1,
+      numTimesteps,
+      0,
+      [&](int threadIdx, int chunkStart, int chunkEnd) {
+        std::shared_ptr<dynamics::Skeleton> skel = mThreadSkels[threadIdx];
+        ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
+        for (int t = chunkStart; t < chunkEnd; t++)
         {
           skel->setPositions(qs.col(t));
           skel->setVelocities(dqs.col(t));
@@ -2002,14 +1993,8 @@ ResidualForceHelper::getRootTrajectoryLinearSystem(
                     .calculateResidualFreeRootAccelerationJacobianWrtVelocity(
                         qs.col(t), dqs.col(t), ddqs.col(t), forces.col(t));
         }
-      }
-    }));
-  }
-
-  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
-  {
-    (void)futures[threadIdx].get();
-  }
+      },
+      mNumThreads);
 
   int missingCursor = 0;
   for (int t = 1; t < numTimesteps; t++)
@@ -3008,8 +2993,6 @@ ResidualForceHelper::getLinearTrajectoryLinearSystemParallel(
     accOffset.push_back(offset);
   }
 
-  int numThreads = 16;
-
   // This has one col each for start COM positions, start COM velocities,
   // It outputs the change in physically consistent X, Y, Z coordinates of COM
   // over time, given those initial offsets and residual velocities..
@@ -3114,51 +3097,21 @@ ResidualForceHelper::getLinearTrajectoryLinearSystemParallel(
   std::vector<Eigen::Matrix3s> angAccWrtVels;
   angAccWrtVels.resize(numTimesteps, Eigen::Matrix3s::Zero());
 
-  // Make sure there are enough copies of skeletons, and residuals helpers, to
-  // fill out all the parallel threads we need.
-  for (int threadIdx = mThreadSkels.size(); threadIdx < numThreads; threadIdx++)
-  {
-    mThreadSkels.push_back(mSkel->cloneSkeleton());
-  }
-  for (int threadIdx = mThreadHelpers.size(); threadIdx < numThreads;
-       threadIdx++)
-  {
-    mThreadHelpers.emplace_back(mThreadSkels[threadIdx], mForceBodies);
-  }
-  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
-  {
-    mThreadSkels[threadIdx]->setGroupScales(mSkel->getGroupScales());
-    mThreadSkels[threadIdx]->setGroupCOMs(mSkel->getGroupCOMs());
-    mThreadSkels[threadIdx]->setGroupMasses(mSkel->getGroupMasses());
-    mThreadSkels[threadIdx]->setGroupInertias(mSkel->getGroupInertias());
-  }
-
-  std::vector<std::future<void>> futures;
-  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  std::shared_ptr<common::WorkStealingPool> pool
+      = common::WorkStealingPool::getCurrentPool();
+  prepareThreadSkels(pool->getNumSlots(mNumThreads));
+  if (useReactionWheels)
   {
-    if (useReactionWheels)
-    {
-      futures.push_back(std::async([threadIdx,
-                                    numTimesteps,
-                                    numThreads,
-                                    &comOffset,
-                                    &coms,
-                                    &comVelOffset,
-                                    &qs,
-                                    &dqs,
-                                    &ddqs,
-                                    &forces,
-                                    &residualFreeAngularAccs,
-                                    &angAccWrtPoses,
-                                    &angAccWrtVels,
-                                    this] {
-        std::shared_ptr<dynamics::Skeleton> skel = mThreadSkels[threadIdx];
-        ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
-        s_t reactionWheelMOI = 100.0;
+    pool->parallelFor(
+        0,
+        numTimesteps,
+        0,
+        [&](int threadIdx, int chunkStart, int chunkEnd) {
+          std::shared_ptr<dynamics::Skeleton> skel = mThreadSkels[threadIdx];
+          ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
+          s_t reactionWheelMOI = 100.0;
 
-        for (int t = 0; t < numTimesteps; t++)
-        {
-          if ((t + threadIdx) % numThreads == 0)
+          for (int t = chunkStart; t < chunkEnd; t++)
           {
             Eigen::VectorXs q = qs.col(t);
             Eigen::Vector3s comMoves = comOffset.segment<3>(t * 3) - coms[t];
@@ -3185,30 +3138,19 @@ ResidualForceHelper::getLinearTrajectoryLinearSystemParallel(
                           qs.col(t), dqs.col(t), ddqs.col(t), forces.col(t))
                   * (1.0 / reactionWheelMOI);
           }
-        }
-      }));
-    }
-    else
-    {
-      futures.push_back(std::async([threadIdx,
-                                    numTimesteps,
-                                    numThreads,
-                                    &comOffset,
-                                    &coms,
-                                    &comVelOffset,
-                                    &qs,
-                                    &dqs,
-                                    &ddqs,
-                                    &forces,
-                                    &residualFreeAngularAccs,
-                                    &angAccWrtPoses,
-                                    &angAccWrtVels,
-                                    this] {
-        std::shared_ptr<dynamics::Skeleton> skel = mThreadSkels[threadIdx];
-        ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
-        for (int t = 0; t < numTimesteps; t++)
-        {
-          if ((t + threadIdx) % numThreads == 0)
+        },
+        mNumThreads);
+  }
+  else
+  {
+    pool->parallelFor(
+        0,
+        numTimesteps,
+        0,
+        [&](int threadIdx, int chunkStart, int chunkEnd) {
+          std::shared_ptr<dynamics::Skeleton> skel = mThreadSkels[threadIdx];
+          ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
+          for (int t = chunkStart; t < chunkEnd; t++)
           {
             Eigen::VectorXs q = qs.col(t);
             Eigen::Vector3s comMoves = comOffset.segment<3>(t * 3) - coms[t];
@@ -3231,14 +3173,8 @@ ResidualForceHelper::getLinearTrajectoryLinearSystemParallel(
                       .calculateResidualFreeRootAngularAccelerationJacobianWrtLinearVelocity(
                           qs.col(t), dqs.col(t), ddqs.col(t), forces.col(t));
           }
-        }
-      }));
-    }
-  }
-
-  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
-  {
-    (void)futures[threadIdx].get();
+        },
+        mNumThreads);
   }
 
   Eigen::Vector3s angularPos = Eigen::Vector3s::Zero();
@@ -4244,6 +4180,35 @@ int ResidualForceHelper::getExpectedForcesDim()
   return mForceBodies.size() * 6;
 }
 
+//==============================================================================
+void ResidualForceHelper::setNumThreads(int numThreads)
+{
+  mNumThreads = numThreads;
+}
+
+//==============================================================================
+void ResidualForceHelper::prepareThreadSkels(int numSlots)
+{
+  // Make sure there are enough copies of skeletons, and residuals helpers, to
+  // fill out all the parallel slots we need.
+  for (int threadIdx = mThreadSkels.size(); threadIdx < numSlots; threadIdx++)
+  {
+    mThreadSkels.push_back(SkeletonClonePool::getGlobalPool()->acquire(mSkel));
+  }
+  for (int threadIdx = mThreadHelpers.size(); threadIdx < numSlots;
+       threadIdx++)
+  {
+    mThreadHelpers.emplace_back(mThreadSkels[threadIdx], mForceBodies);
+  }
+  for (int threadIdx = 0; threadIdx < numSlots; threadIdx++)
+  {
+    mThreadSkels[threadIdx]->setGroupScales(mSkel->getGroupScales());
+    mThreadSkels[threadIdx]->setGroupCOMs(mSkel->getGroupCOMs());
+    mThreadSkels[threadIdx]->setGroupMasses(mSkel->getGroupMasses());
+    mThreadSkels[threadIdx]->setGroupInertias(mSkel->getGroupInertias());
+  }
+}
+
 //==============================================================================
 SpatialNewtonHelper::SpatialNewtonHelper(
     std::shared_ptr<dynamics::Skeleton> skeleton)
@@ -4683,9 +4648,12 @@ DynamicsFitProblem::DynamicsFitProblem(
       = std::make_shared<ResidualForceHelper>(mSkeleton, mInit->grfBodyIndices);
   mSpatialNewtonHelper = std::make_shared<SpatialNewtonHelper>(mSkeleton);
 
-  for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+  // Parallel loops run on up to mNumThreads pool workers, plus the calling
+  // thread, so we need one extra copy of everything
+  for (int threadIdx = 0; threadIdx < mConfig.mNumThreads + 1; threadIdx++)
   {
-    std::shared_ptr<dynamics::Skeleton> skelClone = mSkeleton->cloneSkeleton();
+    std::shared_ptr<dynamics::Skeleton> skelClone
+        = SkeletonClonePool::getGlobalPool()->acquire(mSkeleton);
     skelClone->setGravity(mSkeleton->getGravity());
     skelClone->setTimeStep(mSkeleton->getTimeStep());
     mThreadSkeletons.push_back(skelClone);
@@ -4746,6 +4714,8 @@ DynamicsFitProblem::DynamicsFitProblem(
   mBestObjectiveValueState = mInitX;
   mBestObjectiveValue = initialLoss;
   mBestObjectiveValueIteration = -1;
+  mSchedulingStatsAtLastIteration
+      = common::WorkStealingPool::getCurrentPool()->getStats();
 }
 
 //==============================================================================
@@ -5106,7 +5076,7 @@ void DynamicsFitProblem::unflatten(Eigen::VectorXs x)
   {
     int dim = mSkeleton->getNumScaleGroups();
     mSkeleton->setGroupMasses(x.segment(cursor, dim));
-    for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+    for (int threadIdx = 0; threadIdx < mThreadSkeletons.size(); threadIdx++)
     {
       mThreadSkeletons.at(threadIdx)->setGroupMasses(x.segment(cursor, dim));
     }
@@ -5116,7 +5086,7 @@ void DynamicsFitProblem::unflatten(Eigen::VectorXs x)
   {
     int dim = mSkeleton->getNumScaleGroups() * 3;
     mSkeleton->setGroupCOMs(x.segment(cursor, dim));
-    for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+    for (int threadIdx = 0; threadIdx < mThreadSkeletons.size(); threadIdx++)
     {
       mThreadSkeletons.at(threadIdx)->setGroupCOMs(x.segment(cursor, dim));
     }
@@ -5126,7 +5096,7 @@ void DynamicsFitProblem::unflatten(Eigen::VectorXs x)
   {
     int dim = mSkeleton->getNumScaleGroups() * 6;
     mSkeleton->setGroupInertias(x.segment(cursor, dim));
-    for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+    for (int threadIdx = 0; threadIdx < mThreadSkeletons.size(); threadIdx++)
     {
       mThreadSkeletons.at(threadIdx)->setGroupInertias(x.segment(cursor, dim));
     }
@@ -5136,7 +5106,7 @@ void DynamicsFitProblem::unflatten(Eigen::VectorXs x)
   {
     int dim = mSkeleton->getGroupScaleDim();
     mSkeleton->setGroupScales(x.segment(cursor, dim));
-    for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+    for (int threadIdx = 0; threadIdx < mThreadSkeletons.size(); threadIdx++)
     {
       mThreadSkeletons.at(threadIdx)->setGroupScales(x.segment(cursor, dim));
     }
@@ -5147,7 +5117,7 @@ void DynamicsFitProblem::unflatten(Eigen::VectorXs x)
     for (int i = 0; i < mMarkers.size(); i++)
     {
       mMarkers.at(i).second = x.segment(cursor, 3);
-      for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+      for (int threadIdx = 0; threadIdx < mThreadMarkers.size(); threadIdx++)
       {
         mThreadMarkers.at(threadIdx).at(i).second = x.segment(cursor, 3);
       }
@@ -5708,7 +5678,11 @@ s_t DynamicsFitProblem::computeLossParallel(
     }
   }
 
-  int numThreads = std::min((int)mBlocks.size(), mConfig.mNumThreads);
+  std::shared_ptr<common::WorkStealingPool> pool
+      = common::WorkStealingPool::getCurrentPool();
+  // Never hand out more slots than we have copies of the skeleton for
+  const int maxWorkers = (int)mThreadSkeletons.size() - 1;
+  int numThreads = pool->getNumSlots(maxWorkers);
 
   std::vector<struct LossExplanation> threadLossExplanations;
   for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
@@ -5726,489 +5700,472 @@ s_t DynamicsFitProblem::computeLossParallel(
     threadLoss.markerCount = 0;
   }
 
-  std::vector<std::future<void>> futures;
-  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
-  {
-    futures.push_back(std::async([&threadLossExplanations,
-                                  this,
-                                  threadIdx,
-                                  totalAccTimesteps,
-                                  totalTimesteps] {
-      if (threadLossExplanations.size() <= threadIdx)
+  auto lossOnBlocks = [&](int threadIdx, int chunkStart, int chunkEnd) {
+    if (threadLossExplanations.size() <= threadIdx)
+    {
+      std::cout << "INTERNAL ERROR" << std::endl;
+      std::cout << "threadLossExplanations.size() = "
+                << threadLossExplanations.size() << std::endl;
+      std::cout << "threadIdx = " << threadIdx << std::endl;
+      throw std::runtime_error("threadLossExplanations.size() <= threadIdx");
+    }
+    struct LossExplanation& threadLoss = threadLossExplanations.at(threadIdx);
+
+    if (mThreadSkeletons.size() <= threadIdx)
+    {
+      std::cout << "INTERNAL ERROR" << std::endl;
+      std::cout << "mThreadSkeletons.size() = " << mThreadSkeletons.size()
+                << std::endl;
+      std::cout << "threadIdx = " << threadIdx << std::endl;
+      throw std::runtime_error("mThreadSkeletons.size() <= threadIdx");
+    }
+    mThreadSkeletons.at(threadIdx)->clearExternalForces();
+
+    for (int blockIdx = chunkStart; blockIdx < chunkEnd; blockIdx++)
+    {
+      auto& block = mBlocks[blockIdx];
+
+      if (block.trial >= mInit->trialTimesteps.size())
       {
         std::cout << "INTERNAL ERROR" << std::endl;
-        std::cout << "threadLossExplanations.size() = "
-                  << threadLossExplanations.size() << std::endl;
-        std::cout << "threadIdx = " << threadIdx << std::endl;
-        throw std::runtime_error("threadLossExplanations.size() <= threadIdx");
+        std::cout << "block.trial = " << block.trial << std::endl;
+        std::cout << "mInit->trialTimesteps.size() = "
+                  << mInit->trialTimesteps.size() << std::endl;
+        throw std::runtime_error(
+            "block.trial >= mInit->trialTimesteps.size()");
+      }
+      else
+      {
+        mThreadSkeletons.at(threadIdx)->setTimeStep(
+            mInit->trialTimesteps.at(block.trial));
       }
-      struct LossExplanation& threadLoss = threadLossExplanations.at(threadIdx);
 
-      if (mThreadSkeletons.size() <= threadIdx)
+      if (block.pos.cols() != block.len)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "block.pos.cols() = " << block.pos.cols() << std::endl;
+        std::cout << "block.len = " << block.len << std::endl;
+        throw std::runtime_error("block.pos.cols() != block.len");
+      }
+      if (block.pos.rows() != mThreadSkeletons.at(threadIdx)->getNumDofs())
       {
         std::cout << "INTERNAL ERROR" << std::endl;
-        std::cout << "mThreadSkeletons.size() = " << mThreadSkeletons.size()
+        std::cout << "block.pos.rows() = " << block.pos.rows() << std::endl;
+        std::cout << "mThreadSkeletons.at(threadIdx)->getNumDofs() = "
+                  << mThreadSkeletons.at(threadIdx)->getNumDofs()
                   << std::endl;
-        std::cout << "threadIdx = " << threadIdx << std::endl;
-        throw std::runtime_error("mThreadSkeletons.size() <= threadIdx");
+        throw std::runtime_error(
+            "block.pos.rows() != "
+            "mThreadSkeletons.at(threadIdx)->getNumDofs()");
       }
-      mThreadSkeletons.at(threadIdx)->clearExternalForces();
-
-      for (int blockIdx = 0; blockIdx < mBlocks.size(); blockIdx++)
+      if (block.vel.cols() != block.len)
       {
-        if ((blockIdx + threadIdx) % mConfig.mNumThreads != 0)
-        {
-          continue;
-        }
-
-        auto& block = mBlocks[blockIdx];
-
-        if (block.trial >= mInit->trialTimesteps.size())
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.trial = " << block.trial << std::endl;
-          std::cout << "mInit->trialTimesteps.size() = "
-                    << mInit->trialTimesteps.size() << std::endl;
-          throw std::runtime_error(
-              "block.trial >= mInit->trialTimesteps.size()");
-        }
-        else
-        {
-          mThreadSkeletons.at(threadIdx)->setTimeStep(
-              mInit->trialTimesteps.at(block.trial));
-        }
-
-        if (block.pos.cols() != block.len)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.pos.cols() = " << block.pos.cols() << std::endl;
-          std::cout << "block.len = " << block.len << std::endl;
-          throw std::runtime_error("block.pos.cols() != block.len");
-        }
-        if (block.pos.rows() != mThreadSkeletons.at(threadIdx)->getNumDofs())
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "block.vel.cols() = " << block.vel.cols() << std::endl;
+        std::cout << "block.len = " << block.len << std::endl;
+        throw std::runtime_error("block.vel.cols() != block.len");
+      }
+      if (block.vel.rows() != mThreadSkeletons.at(threadIdx)->getNumDofs())
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "block.vel.rows() = " << block.vel.rows() << std::endl;
+        std::cout << "mThreadSkeletons.at(threadIdx)->getNumDofs() = "
+                  << mThreadSkeletons.at(threadIdx)->getNumDofs()
+                  << std::endl;
+        throw std::runtime_error(
+            "block.vel.rows() != "
+            "mThreadSkeletons.at(threadIdx)->getNumDofs()");
+      }
+      if (block.acc.cols() != block.len)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "block.acc.cols() = " << block.acc.cols() << std::endl;
+        std::cout << "block.len = " << block.len << std::endl;
+        throw std::runtime_error("block.acc.cols() != block.len");
+      }
+      if (block.acc.rows() != mThreadSkeletons.at(threadIdx)->getNumDofs())
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "block.acc.rows() = " << block.acc.rows() << std::endl;
+        std::cout << "mThreadSkeletons.at(threadIdx)->getNumDofs() = "
+                  << mThreadSkeletons.at(threadIdx)->getNumDofs()
+                  << std::endl;
+        throw std::runtime_error(
+            "block.acc.rows() != "
+            "mThreadSkeletons.at(threadIdx)->getNumDofs()");
+      }
+      if (block.grf.cols() != block.len)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "block.grf.cols() = " << block.grf.cols() << std::endl;
+        std::cout << "block.len = " << block.len << std::endl;
+        throw std::runtime_error("block.grf.cols() != block.len");
+      }
+      if (block.grf.rows()
+          != mThreadResidualHelpers.at(threadIdx)->getExpectedForcesDim())
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "block.grf.rows() = " << block.grf.rows() << std::endl;
+        std::cout
+            << "mThreadResidualHelpers.at(threadIdx)->getExpectedForcesDim() "
+               "= "
+            << mThreadResidualHelpers.at(threadIdx)->getExpectedForcesDim()
+            << std::endl;
+        throw std::runtime_error(
+            "block.grf.rows() != "
+            "mThreadResidualHelpers.at(threadIdx)->getExpectedForcesDim()");
+      }
+      if (mInit->markerObservationTrials.at(block.trial).size()
+          < block.start + block.len)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->markerObservationTrials[block.trial = "
+                  << block.trial << "].size() = "
+                  << mInit->markerObservationTrials[block.trial].size()
+                  << std::endl;
+        std::cout << "block.start + block.len = " << block.start + block.len
+                  << std::endl;
+        throw std::runtime_error(
+            "mInit->markerObservationTrials.at(block.trial).size() < "
+            "block.start + block.len");
+      }
+      if (mInit->jointCenters.size() <= block.trial)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->jointCenters.size() = "
+                  << mInit->jointCenters.size() << std::endl;
+        std::cout << "block.trial = " << block.trial << std::endl;
+        throw std::runtime_error("mInit->jointCenters.size() <= block.trial");
+      }
+      else
+      {
+        if (mInit->jointCenters.at(block.trial).cols()
+            < block.start + block.len)
         {
           std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.pos.rows() = " << block.pos.rows() << std::endl;
-          std::cout << "mThreadSkeletons.at(threadIdx)->getNumDofs() = "
-                    << mThreadSkeletons.at(threadIdx)->getNumDofs()
+          std::cout << "mInit->jointCenters[block.trial = " << block.trial
+                    << "].cols() = "
+                    << mInit->jointCenters.at(block.trial).cols()
                     << std::endl;
-          throw std::runtime_error(
-              "block.pos.rows() != "
-              "mThreadSkeletons.at(threadIdx)->getNumDofs()");
-        }
-        if (block.vel.cols() != block.len)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.vel.cols() = " << block.vel.cols() << std::endl;
-          std::cout << "block.len = " << block.len << std::endl;
-          throw std::runtime_error("block.vel.cols() != block.len");
-        }
-        if (block.vel.rows() != mThreadSkeletons.at(threadIdx)->getNumDofs())
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.vel.rows() = " << block.vel.rows() << std::endl;
-          std::cout << "mThreadSkeletons.at(threadIdx)->getNumDofs() = "
-                    << mThreadSkeletons.at(threadIdx)->getNumDofs()
+          std::cout << "block.start + block.len = " << block.start + block.len
                     << std::endl;
           throw std::runtime_error(
-              "block.vel.rows() != "
-              "mThreadSkeletons.at(threadIdx)->getNumDofs()");
-        }
-        if (block.acc.cols() != block.len)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.acc.cols() = " << block.acc.cols() << std::endl;
-          std::cout << "block.len = " << block.len << std::endl;
-          throw std::runtime_error("block.acc.cols() != block.len");
+              "mInit->jointCenters.at(block.trial).cols() < block.start + "
+              "block.len");
         }
-        if (block.acc.rows() != mThreadSkeletons.at(threadIdx)->getNumDofs())
+      }
+      if (mInit->jointAxis.size() <= block.trial)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->jointAxis.size() = " << mInit->jointAxis.size()
+                  << std::endl;
+        std::cout << "block.trial = " << block.trial << std::endl;
+        throw std::runtime_error("mInit->jointAxis.size() <= block.trial");
+      }
+      else
+      {
+        if (mInit->jointAxis.at(block.trial).cols() < block.start + block.len)
         {
           std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.acc.rows() = " << block.acc.rows() << std::endl;
-          std::cout << "mThreadSkeletons.at(threadIdx)->getNumDofs() = "
-                    << mThreadSkeletons.at(threadIdx)->getNumDofs()
+          std::cout << "mInit->jointAxis[block.trial = " << block.trial
+                    << "].cols() = "
+                    << mInit->jointAxis.at(block.trial).cols() << std::endl;
+          std::cout << "block.start + block.len = " << block.start + block.len
                     << std::endl;
           throw std::runtime_error(
-              "block.acc.rows() != "
-              "mThreadSkeletons.at(threadIdx)->getNumDofs()");
-        }
-        if (block.grf.cols() != block.len)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.grf.cols() = " << block.grf.cols() << std::endl;
-          std::cout << "block.len = " << block.len << std::endl;
-          throw std::runtime_error("block.grf.cols() != block.len");
-        }
-        if (block.grf.rows()
-            != mThreadResidualHelpers.at(threadIdx)->getExpectedForcesDim())
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "block.grf.rows() = " << block.grf.rows() << std::endl;
-          std::cout
-              << "mThreadResidualHelpers.at(threadIdx)->getExpectedForcesDim() "
-                 "= "
-              << mThreadResidualHelpers.at(threadIdx)->getExpectedForcesDim()
-              << std::endl;
-          throw std::runtime_error(
-              "block.grf.rows() != "
-              "mThreadResidualHelpers.at(threadIdx)->getExpectedForcesDim()");
+              "mInit->jointAxis.at(block.trial).cols() < block.start + "
+              "block.len");
         }
-        if (mInit->markerObservationTrials.at(block.trial).size()
+      }
+      if (mInit->regularizePosesTo.size() <= block.trial)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->regularizePosesTo.size() = "
+                  << mInit->regularizePosesTo.size() << std::endl;
+        std::cout << "block.trial = " << block.trial << std::endl;
+        throw std::runtime_error(
+            "mInit->regularizePosesTo.size() <= block.trial");
+      }
+      else
+      {
+        if (mInit->regularizePosesTo.at(block.trial).cols()
             < block.start + block.len)
         {
           std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->markerObservationTrials[block.trial = "
-                    << block.trial << "].size() = "
-                    << mInit->markerObservationTrials[block.trial].size()
+          std::cout << "mInit->regularizePosesTo[block.trial = "
+                    << block.trial << "].cols() = "
+                    << mInit->regularizePosesTo.at(block.trial).cols()
                     << std::endl;
           std::cout << "block.start + block.len = " << block.start + block.len
                     << std::endl;
           throw std::runtime_error(
-              "mInit->markerObservationTrials.at(block.trial).size() < "
-              "block.start + block.len");
-        }
-        if (mInit->jointCenters.size() <= block.trial)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->jointCenters.size() = "
-                    << mInit->jointCenters.size() << std::endl;
-          std::cout << "block.trial = " << block.trial << std::endl;
-          throw std::runtime_error("mInit->jointCenters.size() <= block.trial");
-        }
-        else
-        {
-          if (mInit->jointCenters.at(block.trial).cols()
-              < block.start + block.len)
-          {
-            std::cout << "INTERNAL ERROR" << std::endl;
-            std::cout << "mInit->jointCenters[block.trial = " << block.trial
-                      << "].cols() = "
-                      << mInit->jointCenters.at(block.trial).cols()
-                      << std::endl;
-            std::cout << "block.start + block.len = " << block.start + block.len
-                      << std::endl;
-            throw std::runtime_error(
-                "mInit->jointCenters.at(block.trial).cols() < block.start + "
-                "block.len");
-          }
-        }
-        if (mInit->jointAxis.size() <= block.trial)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->jointAxis.size() = " << mInit->jointAxis.size()
-                    << std::endl;
-          std::cout << "block.trial = " << block.trial << std::endl;
-          throw std::runtime_error("mInit->jointAxis.size() <= block.trial");
-        }
-        else
-        {
-          if (mInit->jointAxis.at(block.trial).cols() < block.start + block.len)
-          {
-            std::cout << "INTERNAL ERROR" << std::endl;
-            std::cout << "mInit->jointAxis[block.trial = " << block.trial
-                      << "].cols() = "
-                      << mInit->jointAxis.at(block.trial).cols() << std::endl;
-            std::cout << "block.start + block.len = " << block.start + block.len
-                      << std::endl;
-            throw std::runtime_error(
-                "mInit->jointAxis.at(block.trial).cols() < block.start + "
-                "block.len");
-          }
-        }
-        if (mInit->regularizePosesTo.size() <= block.trial)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->regularizePosesTo.size() = "
-                    << mInit->regularizePosesTo.size() << std::endl;
-          std::cout << "block.trial = " << block.trial << std::endl;
-          throw std::runtime_error(
-              "mInit->regularizePosesTo.size() <= block.trial");
-        }
-        else
-        {
-          if (mInit->regularizePosesTo.at(block.trial).cols()
-              < block.start + block.len)
-          {
-            std::cout << "INTERNAL ERROR" << std::endl;
-            std::cout << "mInit->regularizePosesTo[block.trial = "
-                      << block.trial << "].cols() = "
-                      << mInit->regularizePosesTo.at(block.trial).cols()
-                      << std::endl;
-            std::cout << "block.start + block.len = " << block.start + block.len
-                      << std::endl;
-            throw std::runtime_error(
-                "mInit->regularizePosesTo.at(block.trial).cols() < block.start "
-                "+ block.len");
-          }
-        }
-        for (auto* joint : mThreadJoints.at(threadIdx).at(block.trial))
-        {
-          if (!mThreadSkeletons[threadIdx]->hasJoint(joint))
-          {
-            std::cout << "INTERNAL ERROR" << std::endl;
-            std::cout << "mThreadSkeletons[threadIdx]->hasJoint(joint) = "
-                      << mThreadSkeletons[threadIdx]->hasJoint(joint)
-                      << std::endl;
-            throw std::runtime_error(
-                "!mThreadSkeletons[threadIdx]->hasJoint(joint)");
-          }
-        }
-        for (auto& pair : mThreadMarkers.at(threadIdx))
-        {
-          if (!mThreadSkeletons[threadIdx]->hasBodyNode(pair.first))
-          {
-            std::cout << "INTERNAL ERROR" << std::endl;
-            std::cout
-                << "mThreadSkeletons[threadIdx]->hasBodyNode(pair.first) = "
-                << mThreadSkeletons[threadIdx]->hasBodyNode(pair.first)
-                << std::endl;
-            throw std::runtime_error(
-                "!mThreadSkeletons[threadIdx]->hasBodyNode(pair.first)");
-          }
+              "mInit->regularizePosesTo.at(block.trial).cols() < block.start "
+              "+ block.len");
         }
-        if (mInit->jointWeights.at(block.trial).size()
-            > mThreadJoints.at(threadIdx).at(block.trial).size())
+      }
+      for (auto* joint : mThreadJoints.at(threadIdx).at(block.trial))
+      {
+        if (!mThreadSkeletons[threadIdx]->hasJoint(joint))
         {
           std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->jointWeights.at(block.trial).size() = "
-                    << mInit->jointWeights.at(block.trial).size() << std::endl;
-          std::cout << "mInit->joints.at(threadIdx).size() = "
-                    << mThreadJoints.at(threadIdx).at(block.trial).size()
+          std::cout << "mThreadSkeletons[threadIdx]->hasJoint(joint) = "
+                    << mThreadSkeletons[threadIdx]->hasJoint(joint)
                     << std::endl;
           throw std::runtime_error(
-              "mInit->jointWeights.at(block.trial).size() > "
-              "mInit->joints.at(threadIdx).size()");
+              "!mThreadSkeletons[threadIdx]->hasJoint(joint)");
         }
-        if (mInit->axisWeights.at(block.trial).size()
-            > mThreadJoints.at(threadIdx).at(block.trial).size())
+      }
+      for (auto& pair : mThreadMarkers.at(threadIdx))
+      {
+        if (!mThreadSkeletons[threadIdx]->hasBodyNode(pair.first))
         {
           std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->axisWeights.at(block.trial).size() = "
-                    << mInit->axisWeights.at(block.trial).size() << std::endl;
-          std::cout << "mInit->joints.at(threadIdx).size() = "
-                    << mThreadJoints.at(threadIdx).at(block.trial).size()
-                    << std::endl;
+          std::cout
+              << "mThreadSkeletons[threadIdx]->hasBodyNode(pair.first) = "
+              << mThreadSkeletons[threadIdx]->hasBodyNode(pair.first)
+              << std::endl;
           throw std::runtime_error(
-              "mInit->axisWeights.at(block.trial).size() > "
-              "mInit->joints.at(threadIdx).size()");
+              "!mThreadSkeletons[threadIdx]->hasBodyNode(pair.first)");
         }
-        if (mInit->jointCenters.at(block.trial).cols()
-            < block.start + block.len)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->jointCenters.at(block.trial).cols() = "
-                    << mInit->jointCenters.at(block.trial).cols() << std::endl;
-          std::cout << "block.start + block.len = " << block.start + block.len
-                    << std::endl;
-          throw std::runtime_error(
-              "mInit->jointCenters.at(block.trial).cols() < block.start + "
-              "block.len");
-        }
-        if (mInit->jointCenters.at(block.trial).rows()
-            != mThreadJoints.at(threadIdx).at(block.trial).size() * 3)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->jointCenters.at(block.trial).rows() = "
-                    << mInit->jointCenters.at(block.trial).rows() << std::endl;
-          std::cout << "mThreadJoints(threadIdx).size() * 3 = "
-                    << mThreadJoints.at(threadIdx).at(block.trial).size() * 3
-                    << std::endl;
-          throw std::runtime_error(
-              "mInit->jointCenters.at(block.trial).rows() != "
-              "mThreadJoints(threadIdx).size() * 3");
-        }
-        if (mInit->jointAxis.at(block.trial).cols() < block.start + block.len)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->jointAxis.at(block.trial).cols() = "
-                    << mInit->jointAxis.at(block.trial).cols() << std::endl;
-          std::cout << "block.start + block.len = " << block.start + block.len
-                    << std::endl;
-          throw std::runtime_error(
-              "mInit->jointAxis.at(block.trial).cols() < block.start + "
-              "block.len");
-        }
-        if (mInit->jointAxis.at(block.trial).rows()
-            != mThreadJoints.at(threadIdx).at(block.trial).size() * 6)
-        {
-          std::cout << "INTERNAL ERROR" << std::endl;
-          std::cout << "mInit->jointAxis.at(block.trial).rows() = "
-                    << mInit->jointAxis.at(block.trial).rows() << std::endl;
-          std::cout << "mThreadJoints(threadIdx).size() * 6 = "
-                    << mThreadJoints.at(threadIdx).at(block.trial).size() * 6
-                    << std::endl;
-          throw std::runtime_error(
-              "mInit->jointAxis.at(block.trial).rows() != "
-              "mThreadJoints(threadIdx).size() * 6");
-        }
-
-        if (block.pos.cols() == block.len
-            && block.pos.rows() == mThreadSkeletons.at(threadIdx)->getNumDofs()
-            && block.vel.cols() == block.len
-            && block.vel.rows() == mThreadSkeletons.at(threadIdx)->getNumDofs()
-            && block.acc.cols() == block.len
-            && block.acc.rows() == mThreadSkeletons.at(threadIdx)->getNumDofs()
-            && block.grf.cols() == block.len
-            && block.grf.rows()
-                   == mThreadResidualHelpers.at(threadIdx)
-                          ->getExpectedForcesDim()
-            && mInit->markerObservationTrials.at(block.trial).size()
-                   >= block.start + block.len
-            && mInit->jointCenters.size() > block.trial
-            && mInit->jointCenters.at(block.trial).cols()
-                   >= block.start + block.len
-            && mInit->jointAxis.size() > block.trial
-            && mInit->jointAxis.at(block.trial).cols()
-                   >= block.start + block.len
-            && mInit->regularizePosesTo.size() > block.trial
-            && mInit->regularizePosesTo.at(block.trial).cols()
-                   >= block.start + block.len
-            && mInit->jointWeights.at(block.trial).size()
-                   <= mThreadJoints.at(threadIdx).at(block.trial).size()
-            && mInit->axisWeights.at(block.trial).size()
-                   <= mThreadJoints.at(threadIdx).at(block.trial).size()
-            && mInit->jointCenters.at(block.trial).rows()
-                   == mThreadJoints.at(threadIdx).at(block.trial).size() * 3
-            && mInit->jointAxis.at(block.trial).rows()
-                   == mThreadJoints.at(threadIdx).at(block.trial).size() * 6)
+      }
+      if (mInit->jointWeights.at(block.trial).size()
+          > mThreadJoints.at(threadIdx).at(block.trial).size())
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->jointWeights.at(block.trial).size() = "
+                  << mInit->jointWeights.at(block.trial).size() << std::endl;
+        std::cout << "mInit->joints.at(threadIdx).size() = "
+                  << mThreadJoints.at(threadIdx).at(block.trial).size()
+                  << std::endl;
+        throw std::runtime_error(
+            "mInit->jointWeights.at(block.trial).size() > "
+            "mInit->joints.at(threadIdx).size()");
+      }
+      if (mInit->axisWeights.at(block.trial).size()
+          > mThreadJoints.at(threadIdx).at(block.trial).size())
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->axisWeights.at(block.trial).size() = "
+                  << mInit->axisWeights.at(block.trial).size() << std::endl;
+        std::cout << "mInit->joints.at(threadIdx).size() = "
+                  << mThreadJoints.at(threadIdx).at(block.trial).size()
+                  << std::endl;
+        throw std::runtime_error(
+            "mInit->axisWeights.at(block.trial).size() > "
+            "mInit->joints.at(threadIdx).size()");
+      }
+      if (mInit->jointCenters.at(block.trial).cols()
+          < block.start + block.len)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->jointCenters.at(block.trial).cols() = "
+                  << mInit->jointCenters.at(block.trial).cols() << std::endl;
+        std::cout << "block.start + block.len = " << block.start + block.len
+                  << std::endl;
+        throw std::runtime_error(
+            "mInit->jointCenters.at(block.trial).cols() < block.start + "
+            "block.len");
+      }
+      if (mInit->jointCenters.at(block.trial).rows()
+          != mThreadJoints.at(threadIdx).at(block.trial).size() * 3)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->jointCenters.at(block.trial).rows() = "
+                  << mInit->jointCenters.at(block.trial).rows() << std::endl;
+        std::cout << "mThreadJoints(threadIdx).size() * 3 = "
+                  << mThreadJoints.at(threadIdx).at(block.trial).size() * 3
+                  << std::endl;
+        throw std::runtime_error(
+            "mInit->jointCenters.at(block.trial).rows() != "
+            "mThreadJoints(threadIdx).size() * 3");
+      }
+      if (mInit->jointAxis.at(block.trial).cols() < block.start + block.len)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->jointAxis.at(block.trial).cols() = "
+                  << mInit->jointAxis.at(block.trial).cols() << std::endl;
+        std::cout << "block.start + block.len = " << block.start + block.len
+                  << std::endl;
+        throw std::runtime_error(
+            "mInit->jointAxis.at(block.trial).cols() < block.start + "
+            "block.len");
+      }
+      if (mInit->jointAxis.at(block.trial).rows()
+          != mThreadJoints.at(threadIdx).at(block.trial).size() * 6)
+      {
+        std::cout << "INTERNAL ERROR" << std::endl;
+        std::cout << "mInit->jointAxis.at(block.trial).rows() = "
+                  << mInit->jointAxis.at(block.trial).rows() << std::endl;
+        std::cout << "mThreadJoints(threadIdx).size() * 6 = "
+                  << mThreadJoints.at(threadIdx).at(block.trial).size() * 6
+                  << std::endl;
+        throw std::runtime_error(
+            "mInit->jointAxis.at(block.trial).rows() != "
+            "mThreadJoints(threadIdx).size() * 6");
+      }
+
+      if (block.pos.cols() == block.len
+          && block.pos.rows() == mThreadSkeletons.at(threadIdx)->getNumDofs()
+          && block.vel.cols() == block.len
+          && block.vel.rows() == mThreadSkeletons.at(threadIdx)->getNumDofs()
+          && block.acc.cols() == block.len
+          && block.acc.rows() == mThreadSkeletons.at(threadIdx)->getNumDofs()
+          && block.grf.cols() == block.len
+          && block.grf.rows()
+                 == mThreadResidualHelpers.at(threadIdx)
+                        ->getExpectedForcesDim()
+          && mInit->markerObservationTrials.at(block.trial).size()
+                 >= block.start + block.len
+          && mInit->jointCenters.size() > block.trial
+          && mInit->jointCenters.at(block.trial).cols()
+                 >= block.start + block.len
+          && mInit->jointAxis.size() > block.trial
+          && mInit->jointAxis.at(block.trial).cols()
+                 >= block.start + block.len
+          && mInit->regularizePosesTo.size() > block.trial
+          && mInit->regularizePosesTo.at(block.trial).cols()
+                 >= block.start + block.len
+          && mInit->jointWeights.at(block.trial).size()
+                 <= mThreadJoints.at(threadIdx).at(block.trial).size()
+          && mInit->axisWeights.at(block.trial).size()
+                 <= mThreadJoints.at(threadIdx).at(block.trial).size()
+          && mInit->jointCenters.at(block.trial).rows()
+                 == mThreadJoints.at(threadIdx).at(block.trial).size() * 3
+          && mInit->jointAxis.at(block.trial).rows()
+                 == mThreadJoints.at(threadIdx).at(block.trial).size() * 6)
+      {
+        for (int t = 0; t < block.len; t++)
         {
-          for (int t = 0; t < block.len; t++)
-          {
-            int realT = block.start + t;
+          int realT = block.start + t;
 
-            mThreadSkeletons.at(threadIdx)->setPositions(block.pos.col(t));
+          mThreadSkeletons.at(threadIdx)->setPositions(block.pos.col(t));
 
-            // Add force residual RMS errors to all the middle timesteps
-            if (realT > 0
-                && realT < mInit->poseTrials.at(block.trial).cols() - 1
-                && mInit->probablyMissingGRF.at(block.trial).at(realT) != yes)
+          // Add force residual RMS errors to all the middle timesteps
+          if (realT > 0
+              && realT < mInit->poseTrials.at(block.trial).cols() - 1
+              && mInit->probablyMissingGRF.at(block.trial).at(realT) != yes)
+          {
+            if (mConfig.mLinearNewtonWeight > 0)
             {
-              if (mConfig.mLinearNewtonWeight > 0)
-              {
-                s_t cost = mConfig.mLinearNewtonWeight
-                           * (1.0 / totalAccTimesteps)
-                           * mThreadSpatialNewtonHelpers.at(threadIdx)
-                                 ->calculateLinearForceGapNorm(
-                                     block.pos.col(t),
-                                     block.vel.col(t),
-                                     block.acc.col(t),
-                                     block.grf.col(t),
-                                     mConfig.mLinearNewtonUseL1);
-                threadLoss.linearNewtonError += cost;
-                assert(!isnan(threadLoss.linearNewtonError));
-              }
-              if (mConfig.mResidualWeight > 0)
-              {
-                s_t cost = mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
-                           * mThreadResidualHelpers.at(threadIdx)
-                                 ->calculateResidualNorm(
-                                     block.pos.col(t),
-                                     block.vel.col(t),
-                                     block.acc.col(t),
-                                     block.grf.col(t),
-                                     mConfig.mResidualTorqueMultiple,
-                                     mConfig.mResidualUseL1);
-                threadLoss.residualRMS += cost;
-                assert(!isnan(threadLoss.residualRMS));
-              }
-              if (mConfig.mRegularizeAcc > 0)
-              {
-                s_t cost = mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
-                           * mThreadSpatialNewtonHelpers.at(threadIdx)
-                                 ->calculateAccelerationNorm(
-                                     block.pos.col(t),
-                                     block.vel.col(t),
-                                     block.acc.col(t),
-                                     mConfig.mRegularizeAccBodyWeights,
-                                     mConfig.mRegularizeAccUseL1);
-                threadLoss.accRegularization += cost;
-                assert(!isnan(threadLoss.accRegularization));
-              }
-              if (mConfig.mRegularizeJointAcc > 0)
-              {
-                threadLoss.jointAccRegularization
-                    += mConfig.mRegularizeJointAcc * (1.0 / totalAccTimesteps)
-                       * block.acc.col(t).squaredNorm();
-                assert(!isnan(threadLoss.jointAccRegularization));
-              }
+              s_t cost = mConfig.mLinearNewtonWeight
+                         * (1.0 / totalAccTimesteps)
+                         * mThreadSpatialNewtonHelpers.at(threadIdx)
+                               ->calculateLinearForceGapNorm(
+                                   block.pos.col(t),
+                                   block.vel.col(t),
+                                   block.acc.col(t),
+                                   block.grf.col(t),
+                                   mConfig.mLinearNewtonUseL1);
+              threadLoss.linearNewtonError += cost;
+              assert(!isnan(threadLoss.linearNewtonError));
             }
-
-            // Add marker RMS errors to every timestep
-            auto markerPoses
-                = mThreadSkeletons.at(threadIdx)->getMarkerWorldPositions(
-                    mThreadMarkers.at(threadIdx));
-            auto observedMarkerPoses
-                = mInit->markerObservationTrials.at(block.trial).at(realT);
-            for (int i = 0; i < mMarkerNames.size(); i++)
+            if (mConfig.mResidualWeight > 0)
             {
-              Eigen::Vector3s marker = markerPoses.segment<3>(i * 3);
-              if (observedMarkerPoses.count(mMarkerNames.at(i)))
-              {
-                Eigen::Vector3s diff
-                    = observedMarkerPoses.at(mMarkerNames.at(i)) - marker;
-                s_t thisMarkerCost;
-                if (mConfig.mMarkerUseL1)
-                {
-                  thisMarkerCost = diff.norm();
-                }
-                else
-                {
-                  thisMarkerCost = diff.squaredNorm();
-                }
-                threadLoss.markerRMS += thisMarkerCost;
-                threadLoss.markerCount++;
-                assert(!isnan(threadLoss.markerRMS));
-              }
+              s_t cost = mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
+                         * mThreadResidualHelpers.at(threadIdx)
+                               ->calculateResidualNorm(
+                                   block.pos.col(t),
+                                   block.vel.col(t),
+                                   block.acc.col(t),
+                                   block.grf.col(t),
+                                   mConfig.mResidualTorqueMultiple,
+                                   mConfig.mResidualUseL1);
+              threadLoss.residualRMS += cost;
+              assert(!isnan(threadLoss.residualRMS));
             }
-
-            // Add joints
-            // if (mThreadJoints.at(threadIdx).at(block.trial).size() > 0) {
-            Eigen::VectorXs jointPoses
-                = mThreadSkeletons.at(threadIdx)->getJointWorldPositions(
-                    mThreadJoints.at(threadIdx).at(block.trial));
-            Eigen::VectorXs jointCenters
-                = mInit->jointCenters.at(block.trial).col(realT);
-            Eigen::VectorXs jointDiff = jointPoses - jointCenters;
-            for (int i = 0; i < mInit->jointWeights.at(block.trial).size(); i++)
+            if (mConfig.mRegularizeAcc > 0)
             {
-              threadLoss.jointRMS += (jointPoses.segment<3>(i * 3)
-                                      - jointCenters.segment<3>(i * 3))
-                                         .squaredNorm()
-                                     * mInit->jointWeights.at(block.trial)(i);
+              s_t cost = mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
+                         * mThreadSpatialNewtonHelpers.at(threadIdx)
+                               ->calculateAccelerationNorm(
+                                   block.pos.col(t),
+                                   block.vel.col(t),
+                                   block.acc.col(t),
+                                   mConfig.mRegularizeAccBodyWeights,
+                                   mConfig.mRegularizeAccUseL1);
+              threadLoss.accRegularization += cost;
+              assert(!isnan(threadLoss.accRegularization));
             }
-            Eigen::VectorXs jointAxis
-                = mInit->jointAxis.at(block.trial).col(realT);
-            for (int i = 0; i < mInit->axisWeights.at(block.trial).size(); i++)
+            if (mConfig.mRegularizeJointAcc > 0)
             {
-              Eigen::Vector3s axisCenter = jointAxis.segment<3>(i * 6);
-              Eigen::Vector3s axisDir
-                  = jointAxis.segment<3>(i * 6 + 3).normalized();
-              Eigen::Vector3s actualJointPos = jointPoses.segment<3>(i * 3);
-              // Subtract out any component parallel to the axis
-              Eigen::Vector3s jointDiff = actualJointPos - axisCenter;
-              jointDiff -= jointDiff.dot(axisDir) * axisDir;
-              threadLoss.axisRMS += jointDiff.squaredNorm()
-                                    * mInit->axisWeights.at(block.trial)(i);
+              threadLoss.jointAccRegularization
+                  += mConfig.mRegularizeJointAcc * (1.0 / totalAccTimesteps)
+                     * block.acc.col(t).squaredNorm();
+              assert(!isnan(threadLoss.jointAccRegularization));
             }
-            // }
+          }
 
-            // Add regularization
-            threadLoss.poseRegularization
-                += mConfig.mRegularizePoses * (1.0 / totalTimesteps)
-                   * (block.pos.col(t)
-                      - mInit->regularizePosesTo.at(block.trial).col(realT))
-                         .squaredNorm();
-            assert(!isnan(threadLoss.poseRegularization));
+          // Add marker RMS errors to every timestep
+          auto markerPoses
+              = mThreadSkeletons.at(threadIdx)->getMarkerWorldPositions(
+                  mThreadMarkers.at(threadIdx));
+          auto observedMarkerPoses
+              = mInit->markerObservationTrials.at(block.trial).at(realT);
+          for (int i = 0; i < mMarkerNames.size(); i++)
+          {
+            Eigen::Vector3s marker = markerPoses.segment<3>(i * 3);
+            if (observedMarkerPoses.count(mMarkerNames.at(i)))
+            {
+              Eigen::Vector3s diff
+                  = observedMarkerPoses.at(mMarkerNames.at(i)) - marker;
+              s_t thisMarkerCost;
+              if (mConfig.mMarkerUseL1)
+              {
+                thisMarkerCost = diff.norm();
+              }
+              else
+              {
+                thisMarkerCost = diff.squaredNorm();
+              }
+              threadLoss.markerRMS += thisMarkerCost;
+              threadLoss.markerCount++;
+              assert(!isnan(threadLoss.markerRMS));
+            }
           }
+
+          // Add joints
+          // if (mThreadJoints.at(threadIdx).at(block.trial).size() > 0) {
+          Eigen::VectorXs jointPoses
+              = mThreadSkeletons.at(threadIdx)->getJointWorldPositions(
+                  mThreadJoints.at(threadIdx).at(block.trial));
+          Eigen::VectorXs jointCenters
+              = mInit->jointCenters.at(block.trial).col(realT);
+          Eigen::VectorXs jointDiff = jointPoses - jointCenters;
+          for (int i = 0; i < mInit->jointWeights.at(block.trial).size(); i++)
+          {
+            threadLoss.jointRMS += (jointPoses.segment<3>(i * 3)
+                                    - jointCenters.segment<3>(i * 3))
+                                       .squaredNorm()
+                                   * mInit->jointWeights.at(block.trial)(i);
+          }
+          Eigen::VectorXs jointAxis
+              = mInit->jointAxis.at(block.trial).col(realT);
+          for (int i = 0; i < mInit->axisWeights.at(block.trial).size(); i++)
+          {
+            Eigen::Vector3s axisCenter = jointAxis.segment<3>(i * 6);
+            Eigen::Vector3s axisDir
+                = jointAxis.segment<3>(i * 6 + 3).normalized();
+            Eigen::Vector3s actualJointPos = jointPoses.segment<3>(i * 3);
+            // Subtract out any component parallel to the axis
+            Eigen::Vector3s jointDiff = actualJointPos - axisCenter;
+            jointDiff -= jointDiff.dot(axisDir) * axisDir;
+            threadLoss.axisRMS += jointDiff.squaredNorm()
+                                  * mInit->axisWeights.at(block.trial)(i);
+          }
+          // }
+
+          // Add regularization
+          threadLoss.poseRegularization
+              += mConfig.mRegularizePoses * (1.0 / totalTimesteps)
+                 * (block.pos.col(t)
+                    - mInit->regularizePosesTo.at(block.trial).col(realT))
+                       .squaredNorm();
+          assert(!isnan(threadLoss.poseRegularization));
         }
       }
-    }));
-  }
-
-  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
-  {
-    (void)futures.at(threadIdx).get();
-  }
+    }
+  };
+  pool->parallelFor(0, mBlocks.size(), 1, lossOnBlocks, maxWorkers);
 
   s_t linearNewtonError = 0.0;
   s_t residualRMS = 0.0;
@@ -7141,564 +7098,555 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
     }
   }
 
-  int initialPosesCursor = posesCursor;
-  std::vector<std::future<Eigen::VectorXs>> futures;
-  int gradSize = grad.size();
-  for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+  // Work out where each block's poses start in the gradient up front, so that
+  // blocks can be processed in any order
+  std::vector<int> blockStarts;
+  for (auto& block : mBlocks)
   {
-    futures.push_back(std::async([initialPosesCursor,
-                                  this,
-                                  threadIdx,
-                                  dofs,
-                                  start,
-                                  dims,
-                                  gradSize,
-                                  markerCount,
-                                  totalAccTimesteps,
-                                  totalTimesteps] {
-      int posesCursor = initialPosesCursor;
-      Eigen::VectorXs threadGrad = Eigen::VectorXs::Zero(gradSize);
-      for (int blockIdx = 0; blockIdx < mBlocks.size(); blockIdx++)
+    blockStarts.push_back(posesCursor);
+    posesCursor += (2 + block.len) * dims;
+  }
+  assert(posesCursor == grad.size());
+
+  std::shared_ptr<common::WorkStealingPool> pool
+      = common::WorkStealingPool::getCurrentPool();
+  // Never hand out more slots than we have copies of the skeleton for
+  const int maxWorkers = (int)mThreadSkeletons.size() - 1;
+  std::vector<Eigen::VectorXs> threadGrads(
+      pool->getNumSlots(maxWorkers), Eigen::VectorXs::Zero(grad.size()));
+  auto gradOnBlocks = [&](int threadIdx, int chunkStart, int chunkEnd) {
+    Eigen::VectorXs& threadGrad = threadGrads[threadIdx];
+    for (int blockIdx = chunkStart; blockIdx < chunkEnd; blockIdx++)
+    {
+      auto& block = mBlocks[blockIdx];
+      s_t dt = block.dt;
+      const int blockStart = blockStarts[blockIdx];
+
+      for (int t = 0; t < block.len; t++)
       {
-        auto& block = mBlocks[blockIdx];
-        s_t dt = block.dt;
-        const int blockStart = posesCursor;
+        int realT = block.start + t;
 
-        if ((blockIdx + threadIdx) % mConfig.mNumThreads != 0)
+        mThreadSkeletons[threadIdx]->setPositions(block.pos.col(t));
+        Eigen::VectorXs lossGradWrtMarkerError
+            = Eigen::VectorXs::Zero(mThreadMarkers[threadIdx].size() * 3);
+        auto& markerObservations
+            = mInit->markerObservationTrials[block.trial][realT];
+        auto markerPoses
+            = mThreadSkeletons[threadIdx]->getMarkerWorldPositions(
+                mThreadMarkers[threadIdx]);
+        for (int i = 0; i < mThreadMarkers[threadIdx].size(); i++)
         {
-          posesCursor += (2 + block.len) * dims;
-          continue;
+          if (markerObservations.count(mMarkerNames[i]))
+          {
+            Eigen::Vector3s markerOffset
+                = markerPoses.segment<3>(i * 3)
+                  - markerObservations.at(mMarkerNames[i]);
+            if (mConfig.mMarkerUseL1)
+            {
+              markerOffset.normalize();
+            }
+            else
+            {
+              markerOffset *= 2;
+            }
+            lossGradWrtMarkerError.segment<3>(i * 3)
+                = (mConfig.mMarkerWeight / markerCount) * markerOffset;
+          }
         }
 
-        for (int t = 0; t < block.len; t++)
+        Eigen::VectorXs jointGrad
+            = Eigen::VectorXs::Zero(mInit->joints.at(block.trial).size() * 3);
+        Eigen::VectorXs worldJoints
+            = mThreadSkeletons.at(threadIdx)->getJointWorldPositions(
+                mThreadJoints.at(threadIdx).at(block.trial));
+        Eigen::VectorXs targetJoints
+            = mInit->jointCenters[block.trial].col(realT);
+        Eigen::VectorXs targetAxis = mInit->jointAxis[block.trial].col(realT);
+        for (int i = 0; i < mInit->joints.at(block.trial).size(); i++)
         {
-          int realT = block.start + t;
+          Eigen::Vector3s worldDiff = worldJoints.segment<3>(i * 3)
+                                      - targetJoints.segment<3>(i * 3);
+          jointGrad.segment<3>(i * 3)
+              += 2 * worldDiff * mInit->jointWeights.at(block.trial)(i);
+
+          Eigen::Vector3s axisDiff
+              = worldJoints.segment<3>(i * 3) - targetAxis.segment<3>(i * 6);
+          Eigen::Vector3s axis
+              = targetAxis.segment<3>(i * 6 + 3).normalized();
+          axisDiff -= axisDiff.dot(axis) * axis;
+          jointGrad.segment<3>(i * 3)
+              += 2 * axisDiff * mInit->axisWeights.at(block.trial)(i);
+        }
+        jointGrad *= mConfig.mJointWeight;
 
-          mThreadSkeletons[threadIdx]->setPositions(block.pos.col(t));
-          Eigen::VectorXs lossGradWrtMarkerError
-              = Eigen::VectorXs::Zero(mThreadMarkers[threadIdx].size() * 3);
-          auto& markerObservations
-              = mInit->markerObservationTrials[block.trial][realT];
-          auto markerPoses
-              = mThreadSkeletons[threadIdx]->getMarkerWorldPositions(
-                  mThreadMarkers[threadIdx]);
-          for (int i = 0; i < mThreadMarkers[threadIdx].size(); i++)
+        // We only compute the residual on middle t's, since we can't finite
+        // difference acceleration at the edges of the clip
+        if (realT > 0 && realT < mInit->poseTrials[block.trial].cols() - 1)
+        {
+          int cursor = 0;
+          if (mConfig.mIncludeMasses)
           {
-            if (markerObservations.count(mMarkerNames[i]))
+            int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups();
+            if (mInit->probablyMissingGRF[block.trial][realT] != yes)
             {
-              Eigen::Vector3s markerOffset
-                  = markerPoses.segment<3>(i * 3)
-                    - markerObservations.at(mMarkerNames[i]);
-              if (mConfig.mMarkerUseL1)
+              if (mConfig.mResidualWeight > 0)
               {
-                markerOffset.normalize();
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
+                       * mThreadResidualHelpers[threadIdx]
+                             ->calculateResidualNormGradientWrt(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 block.grf.col(t),
+                                 neural::WithRespectTo::GROUP_MASSES,
+                                 mConfig.mResidualTorqueMultiple,
+                                 mConfig.mResidualUseL1);
               }
-              else
+              if (mConfig.mLinearNewtonWeight > 0)
               {
-                markerOffset *= 2;
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
+                       * mThreadSpatialNewtonHelpers[threadIdx]
+                             ->calculateLinearForceGapNormGradientWrt(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 block.grf.col(t),
+                                 neural::WithRespectTo::GROUP_MASSES,
+                                 mConfig.mLinearNewtonUseL1);
               }
-              lossGradWrtMarkerError.segment<3>(i * 3)
-                  = (mConfig.mMarkerWeight / markerCount) * markerOffset;
+              /*
+              // This should always be 0, and therefore not necessary
+              if (mRegularizeAcc > 0)
+              {
+                grad.segment(cursor, dim)
+                    += mRegularizeAcc * (1.0 / totalAccTimesteps)
+                       * mSpatialNewtonHelper->calculateAccelerationNormGradient(
+                           mPoses[trial].col(t),
+                           mVels[trial].col(t),
+                           mAccs[trial].col(t),
+                           mRegularizeAccBodyWeights,
+                           neural::WithRespectTo::GROUP_MASSES,
+                           mRegularizeAccUseL1);
+              }
+              */
             }
+            cursor += dim;
           }
-
-          Eigen::VectorXs jointGrad
-              = Eigen::VectorXs::Zero(mInit->joints.at(block.trial).size() * 3);
-          Eigen::VectorXs worldJoints
-              = mThreadSkeletons.at(threadIdx)->getJointWorldPositions(
-                  mThreadJoints.at(threadIdx).at(block.trial));
-          Eigen::VectorXs targetJoints
-              = mInit->jointCenters[block.trial].col(realT);
-          Eigen::VectorXs targetAxis = mInit->jointAxis[block.trial].col(realT);
-          for (int i = 0; i < mInit->joints.at(block.trial).size(); i++)
+          if (mConfig.mIncludeCOMs)
           {
-            Eigen::Vector3s worldDiff = worldJoints.segment<3>(i * 3)
-                                        - targetJoints.segment<3>(i * 3);
-            jointGrad.segment<3>(i * 3)
-                += 2 * worldDiff * mInit->jointWeights.at(block.trial)(i);
-
-            Eigen::Vector3s axisDiff
-                = worldJoints.segment<3>(i * 3) - targetAxis.segment<3>(i * 6);
-            Eigen::Vector3s axis
-                = targetAxis.segment<3>(i * 6 + 3).normalized();
-            axisDiff -= axisDiff.dot(axis) * axis;
-            jointGrad.segment<3>(i * 3)
-                += 2 * axisDiff * mInit->axisWeights.at(block.trial)(i);
-          }
-          jointGrad *= mConfig.mJointWeight;
-
-          // We only compute the residual on middle t's, since we can't finite
-          // difference acceleration at the edges of the clip
-          if (realT > 0 && realT < mInit->poseTrials[block.trial].cols() - 1)
-          {
-            int cursor = 0;
-            if (mConfig.mIncludeMasses)
+            int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups() * 3;
+            if (mInit->probablyMissingGRF[block.trial][realT] != yes)
             {
-              int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups();
-              if (mInit->probablyMissingGRF[block.trial][realT] != yes)
+              if (mConfig.mResidualWeight > 0)
               {
-                if (mConfig.mResidualWeight > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
-                         * mThreadResidualHelpers[threadIdx]
-                               ->calculateResidualNormGradientWrt(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   block.grf.col(t),
-                                   neural::WithRespectTo::GROUP_MASSES,
-                                   mConfig.mResidualTorqueMultiple,
-                                   mConfig.mResidualUseL1);
-                }
-                if (mConfig.mLinearNewtonWeight > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
-                         * mThreadSpatialNewtonHelpers[threadIdx]
-                               ->calculateLinearForceGapNormGradientWrt(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   block.grf.col(t),
-                                   neural::WithRespectTo::GROUP_MASSES,
-                                   mConfig.mLinearNewtonUseL1);
-                }
-                /*
-                // This should always be 0, and therefore not necessary
-                if (mRegularizeAcc > 0)
-                {
-                  grad.segment(cursor, dim)
-                      += mRegularizeAcc * (1.0 / totalAccTimesteps)
-                         * mSpatialNewtonHelper->calculateAccelerationNormGradient(
-                             mPoses[trial].col(t),
-                             mVels[trial].col(t),
-                             mAccs[trial].col(t),
-                             mRegularizeAccBodyWeights,
-                             neural::WithRespectTo::GROUP_MASSES,
-                             mRegularizeAccUseL1);
-                }
-                */
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
+                       * mThreadResidualHelpers[threadIdx]
+                             ->calculateResidualNormGradientWrt(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 block.grf.col(t),
+                                 neural::WithRespectTo::GROUP_COMS,
+                                 mConfig.mResidualTorqueMultiple,
+                                 mConfig.mResidualUseL1);
               }
-              cursor += dim;
-            }
-            if (mConfig.mIncludeCOMs)
-            {
-              int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups() * 3;
-              if (mInit->probablyMissingGRF[block.trial][realT] != yes)
+              if (mConfig.mLinearNewtonWeight > 0)
               {
-                if (mConfig.mResidualWeight > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
-                         * mThreadResidualHelpers[threadIdx]
-                               ->calculateResidualNormGradientWrt(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   block.grf.col(t),
-                                   neural::WithRespectTo::GROUP_COMS,
-                                   mConfig.mResidualTorqueMultiple,
-                                   mConfig.mResidualUseL1);
-                }
-                if (mConfig.mLinearNewtonWeight > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
-                         * mThreadSpatialNewtonHelpers[threadIdx]
-                               ->calculateLinearForceGapNormGradientWrt(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   block.grf.col(t),
-                                   neural::WithRespectTo::GROUP_COMS,
-                                   mConfig.mLinearNewtonUseL1);
-                }
-                if (mConfig.mRegularizeAcc > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
-                         * mThreadSpatialNewtonHelpers[threadIdx]
-                               ->calculateAccelerationNormGradient(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   mConfig.mRegularizeAccBodyWeights,
-                                   neural::WithRespectTo::GROUP_COMS,
-                                   mConfig.mRegularizeAccUseL1);
-                }
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
+                       * mThreadSpatialNewtonHelpers[threadIdx]
+                             ->calculateLinearForceGapNormGradientWrt(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 block.grf.col(t),
+                                 neural::WithRespectTo::GROUP_COMS,
+                                 mConfig.mLinearNewtonUseL1);
               }
-              cursor += dim;
-            }
-            if (mConfig.mIncludeInertias)
-            {
-              int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups() * 6;
-              if (mInit->probablyMissingGRF[block.trial][realT] != yes)
+              if (mConfig.mRegularizeAcc > 0)
               {
-                if (mConfig.mResidualWeight > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
-                         * mThreadResidualHelpers[threadIdx]
-                               ->calculateResidualNormGradientWrt(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   block.grf.col(t),
-                                   neural::WithRespectTo::GROUP_INERTIAS,
-                                   mConfig.mResidualTorqueMultiple,
-                                   mConfig.mResidualUseL1);
-                }
-                /*
-                // This should always be 0, and therefore not necessary
-
-                if (mLinearNewtonWeight > 0)
-                {
-                  grad.segment(cursor, dim)
-                      += mLinearNewtonWeight * (1.0 / totalAccTimesteps)
-                         * mSpatialNewtonHelper
-                               ->calculateLinearForceGapNormGradientWrt(
-                                   mPoses[trial].col(t),
-                                   mVels[trial].col(t),
-                                   mAccs[trial].col(t),
-                                   mInit->grfTrials[trial].col(t),
-                                   neural::WithRespectTo::GROUP_INERTIAS,
-                                   mLinearNewtonUseL1);
-                }
-                if (mRegularizeAcc > 0)
-                {
-                  grad.segment(cursor, dim)
-                      += mRegularizeAcc * (1.0 / totalAccTimesteps)
-                         * mSpatialNewtonHelper->calculateAccelerationNormGradient(
-                             mPoses[trial].col(t),
-                             mVels[trial].col(t),
-                             mAccs[trial].col(t),
-                             mRegularizeAccBodyWeights,
-                             neural::WithRespectTo::GROUP_INERTIAS,
-                             mRegularizeAccUseL1);
-                }
-                */
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
+                       * mThreadSpatialNewtonHelpers[threadIdx]
+                             ->calculateAccelerationNormGradient(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 mConfig.mRegularizeAccBodyWeights,
+                                 neural::WithRespectTo::GROUP_COMS,
+                                 mConfig.mRegularizeAccUseL1);
               }
-              cursor += dim;
             }
-            if (mConfig.mIncludeBodyScales)
+            cursor += dim;
+          }
+          if (mConfig.mIncludeInertias)
+          {
+            int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups() * 6;
+            if (mInit->probablyMissingGRF[block.trial][realT] != yes)
             {
-              int dim = mThreadSkeletons[threadIdx]->getGroupScaleDim();
-              if (mInit->probablyMissingGRF[block.trial][realT] != yes)
+              if (mConfig.mResidualWeight > 0)
               {
-                if (mConfig.mResidualWeight > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
-                         * mThreadResidualHelpers[threadIdx]
-                               ->calculateResidualNormGradientWrt(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   block.grf.col(t),
-                                   neural::WithRespectTo::GROUP_SCALES,
-                                   mConfig.mResidualTorqueMultiple,
-                                   mConfig.mResidualUseL1);
-                }
-                if (mConfig.mLinearNewtonWeight > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
-                         * mThreadSpatialNewtonHelpers[threadIdx]
-                               ->calculateLinearForceGapNormGradientWrt(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   block.grf.col(t),
-                                   neural::WithRespectTo::GROUP_SCALES,
-                                   mConfig.mLinearNewtonUseL1);
-                }
-                if (mConfig.mRegularizeAcc > 0)
-                {
-                  threadGrad.segment(cursor, dim)
-                      += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
-                         * mThreadSpatialNewtonHelpers[threadIdx]
-                               ->calculateAccelerationNormGradient(
-                                   block.pos.col(t),
-                                   block.vel.col(t),
-                                   block.acc.col(t),
-                                   mConfig.mRegularizeAccBodyWeights,
-                                   neural::WithRespectTo::GROUP_SCALES,
-                                   mConfig.mRegularizeAccUseL1);
-                }
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
+                       * mThreadResidualHelpers[threadIdx]
+                             ->calculateResidualNormGradientWrt(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 block.grf.col(t),
+                                 neural::WithRespectTo::GROUP_INERTIAS,
+                                 mConfig.mResidualTorqueMultiple,
+                                 mConfig.mResidualUseL1);
               }
+              /*
+              // This should always be 0, and therefore not necessary
 
-              // Record marker gradients
-              threadGrad.segment(cursor, dim)
-                  += MarkerFitter::getMarkerLossGradientWrtGroupScales(
-                      mThreadSkeletons[threadIdx],
-                      mThreadMarkers[threadIdx],
-                      lossGradWrtMarkerError);
-
-              // Record joint gradients
-              threadGrad.segment(cursor, dim)
-                  += mThreadSkeletons.at(threadIdx)
-                         ->getJointWorldPositionsJacobianWrtGroupScales(
-                             mThreadJoints.at(threadIdx).at(block.trial))
-                         .transpose()
-                     * jointGrad;
-
-              cursor += dim;
-            }
-            if (mConfig.mIncludeMarkerOffsets)
-            {
-              int dim = mThreadMarkers[threadIdx].size() * 3;
-              threadGrad.segment(cursor, dim)
-                  += MarkerFitter::getMarkerLossGradientWrtMarkerOffsets(
-                      mThreadSkeletons[threadIdx],
-                      mThreadMarkers[threadIdx],
-                      lossGradWrtMarkerError);
-              cursor += dim;
-            }
-
-            if (mConfig.mIncludePoses)
-            {
-              Eigen::VectorXs posGrad = Eigen::VectorXs::Zero(dofs);
-              Eigen::VectorXs velGrad = Eigen::VectorXs::Zero(dofs);
-              Eigen::VectorXs accGrad = Eigen::VectorXs::Zero(dofs);
-              if (mInit->probablyMissingGRF[block.trial][realT] != yes)
+              if (mLinearNewtonWeight > 0)
               {
-                if (mConfig.mResidualWeight > 0)
-                {
-                  posGrad += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
-                             * mThreadResidualHelpers[threadIdx]
-                                   ->calculateResidualNormGradientWrt(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       block.grf.col(t),
-                                       neural::WithRespectTo::POSITION,
-                                       mConfig.mResidualTorqueMultiple,
-                                       mConfig.mResidualUseL1);
-                  velGrad += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
-                             * mThreadResidualHelpers[threadIdx]
-                                   ->calculateResidualNormGradientWrt(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       block.grf.col(t),
-                                       neural::WithRespectTo::VELOCITY,
-                                       mConfig.mResidualTorqueMultiple,
-                                       mConfig.mResidualUseL1);
-                  accGrad += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
-                             * mThreadResidualHelpers[threadIdx]
-                                   ->calculateResidualNormGradientWrt(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       block.grf.col(t),
-                                       neural::WithRespectTo::ACCELERATION,
-                                       mConfig.mResidualTorqueMultiple,
-                                       mConfig.mResidualUseL1);
-                }
-                if (mConfig.mLinearNewtonWeight > 0)
-                {
-                  posGrad += mConfig.mLinearNewtonWeight
-                             * (1.0 / totalAccTimesteps)
-                             * mThreadSpatialNewtonHelpers[threadIdx]
-                                   ->calculateLinearForceGapNormGradientWrt(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       block.grf.col(t),
-                                       neural::WithRespectTo::POSITION,
-                                       mConfig.mLinearNewtonUseL1);
-                  velGrad += mConfig.mLinearNewtonWeight
-                             * (1.0 / totalAccTimesteps)
-                             * mThreadSpatialNewtonHelpers[threadIdx]
-                                   ->calculateLinearForceGapNormGradientWrt(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       block.grf.col(t),
-                                       neural::WithRespectTo::VELOCITY,
-                                       mConfig.mLinearNewtonUseL1);
-                  accGrad += mConfig.mLinearNewtonWeight
-                             * (1.0 / totalAccTimesteps)
-                             * mThreadSpatialNewtonHelpers[threadIdx]
-                                   ->calculateLinearForceGapNormGradientWrt(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       block.grf.col(t),
-                                       neural::WithRespectTo::ACCELERATION,
-                                       mConfig.mLinearNewtonUseL1);
-                }
-                if (mConfig.mRegularizeAcc > 0)
-                {
-                  posGrad += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
-                             * mThreadSpatialNewtonHelpers[threadIdx]
-                                   ->calculateAccelerationNormGradient(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       mConfig.mRegularizeAccBodyWeights,
-                                       neural::WithRespectTo::POSITION,
-                                       mConfig.mRegularizeAccUseL1);
-                  velGrad += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
-                             * mThreadSpatialNewtonHelpers[threadIdx]
-                                   ->calculateAccelerationNormGradient(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       mConfig.mRegularizeAccBodyWeights,
-                                       neural::WithRespectTo::VELOCITY,
-                                       mConfig.mRegularizeAccUseL1);
-                  accGrad += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
-                             * mThreadSpatialNewtonHelpers[threadIdx]
-                                   ->calculateAccelerationNormGradient(
-                                       block.pos.col(t),
-                                       block.vel.col(t),
-                                       block.acc.col(t),
-                                       mConfig.mRegularizeAccBodyWeights,
-                                       neural::WithRespectTo::ACCELERATION,
-                                       mConfig.mRegularizeAccUseL1);
-                }
-                if (mConfig.mRegularizeJointAcc > 0)
-                {
-                  accGrad += mConfig.mRegularizeJointAcc
-                             * (2.0 / totalAccTimesteps) * block.acc.col(t);
-                }
+                grad.segment(cursor, dim)
+                    += mLinearNewtonWeight * (1.0 / totalAccTimesteps)
+                       * mSpatialNewtonHelper
+                             ->calculateLinearForceGapNormGradientWrt(
+                                 mPoses[trial].col(t),
+                                 mVels[trial].col(t),
+                                 mAccs[trial].col(t),
+                                 mInit->grfTrials[trial].col(t),
+                                 neural::WithRespectTo::GROUP_INERTIAS,
+                                 mLinearNewtonUseL1);
               }
-
-              // Record marker gradients
-              posGrad += MarkerFitter::getMarkerLossGradientWrtJoints(
-                  mThreadSkeletons.at(threadIdx),
-                  mThreadMarkers.at(threadIdx),
-                  lossGradWrtMarkerError);
-
-              // Record regularization
-              posGrad += mConfig.mRegularizePoses * 2 * (1.0 / totalTimesteps)
-                         * (block.pos.col(t)
-                            - mInit->regularizePosesTo[block.trial].col(realT));
-
-              // Record joint gradients
-              posGrad += mThreadSkeletons.at(threadIdx)
-                             ->getJointWorldPositionsJacobianWrtJointPositions(
-                                 mThreadJoints.at(threadIdx).at(block.trial))
-                             .transpose()
-                         * jointGrad;
-
-              threadGrad.segment(blockStart, dims)
-                  += posGrad.segment(start, dims);
-              threadGrad.segment(blockStart + dims, dims)
-                  += velGrad.segment(start, dims);
-              // Initial velocity also has a linear effect on position, so
-              // reflect that in the gradients
-              threadGrad.segment(blockStart + dims, dims)
-                  += posGrad.segment(start, dims) * dt * t;
-
-              threadGrad.segment(blockStart + (dims * (2 + t)), dims)
-                  += accGrad.segment(start, dims);
-
-              for (int pastAccStep = 0; pastAccStep < t; pastAccStep++)
+              if (mRegularizeAcc > 0)
               {
-                threadGrad.segment(
-                    blockStart + (dims * (2 + pastAccStep)), dims)
-                    += dt * velGrad.segment(start, dims);
-                int stepsSinceAcc = t - pastAccStep;
-                threadGrad.segment(
-                    blockStart + (dims * (2 + pastAccStep)), dims)
-                    += dt * dt * stepsSinceAcc * posGrad.segment(start, dims);
+                grad.segment(cursor, dim)
+                    += mRegularizeAcc * (1.0 / totalAccTimesteps)
+                       * mSpatialNewtonHelper->calculateAccelerationNormGradient(
+                           mPoses[trial].col(t),
+                           mVels[trial].col(t),
+                           mAccs[trial].col(t),
+                           mRegularizeAccBodyWeights,
+                           neural::WithRespectTo::GROUP_INERTIAS,
+                           mRegularizeAccUseL1);
               }
+              */
             }
+            cursor += dim;
           }
-          else
+          if (mConfig.mIncludeBodyScales)
           {
-            int cursor = 0;
-            if (mConfig.mIncludeMasses)
+            int dim = mThreadSkeletons[threadIdx]->getGroupScaleDim();
+            if (mInit->probablyMissingGRF[block.trial][realT] != yes)
             {
-              int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups();
-              cursor += dim;
-            }
-            if (mConfig.mIncludeCOMs)
-            {
-              int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups() * 3;
-              cursor += dim;
+              if (mConfig.mResidualWeight > 0)
+              {
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
+                       * mThreadResidualHelpers[threadIdx]
+                             ->calculateResidualNormGradientWrt(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 block.grf.col(t),
+                                 neural::WithRespectTo::GROUP_SCALES,
+                                 mConfig.mResidualTorqueMultiple,
+                                 mConfig.mResidualUseL1);
+              }
+              if (mConfig.mLinearNewtonWeight > 0)
+              {
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
+                       * mThreadSpatialNewtonHelpers[threadIdx]
+                             ->calculateLinearForceGapNormGradientWrt(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 block.grf.col(t),
+                                 neural::WithRespectTo::GROUP_SCALES,
+                                 mConfig.mLinearNewtonUseL1);
+              }
+              if (mConfig.mRegularizeAcc > 0)
+              {
+                threadGrad.segment(cursor, dim)
+                    += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
+                       * mThreadSpatialNewtonHelpers[threadIdx]
+                             ->calculateAccelerationNormGradient(
+                                 block.pos.col(t),
+                                 block.vel.col(t),
+                                 block.acc.col(t),
+                                 mConfig.mRegularizeAccBodyWeights,
+                                 neural::WithRespectTo::GROUP_SCALES,
+                                 mConfig.mRegularizeAccUseL1);
+              }
             }
-            if (mConfig.mIncludeInertias)
+
+            // Record marker gradients
+            threadGrad.segment(cursor, dim)
+                += MarkerFitter::getMarkerLossGradientWrtGroupScales(
+                    mThreadSkeletons[threadIdx],
+                    mThreadMarkers[threadIdx],
+                    lossGradWrtMarkerError);
+
+            // Record joint gradients
+            threadGrad.segment(cursor, dim)
+                += mThreadSkeletons.at(threadIdx)
+                       ->getJointWorldPositionsJacobianWrtGroupScales(
+                           mThreadJoints.at(threadIdx).at(block.trial))
+                       .transpose()
+                   * jointGrad;
+
+            cursor += dim;
+          }
+          if (mConfig.mIncludeMarkerOffsets)
+          {
+            int dim = mThreadMarkers[threadIdx].size() * 3;
+            threadGrad.segment(cursor, dim)
+                += MarkerFitter::getMarkerLossGradientWrtMarkerOffsets(
+                    mThreadSkeletons[threadIdx],
+                    mThreadMarkers[threadIdx],
+                    lossGradWrtMarkerError);
+            cursor += dim;
+          }
+
+          if (mConfig.mIncludePoses)
+          {
+            Eigen::VectorXs posGrad = Eigen::VectorXs::Zero(dofs);
+            Eigen::VectorXs velGrad = Eigen::VectorXs::Zero(dofs);
+            Eigen::VectorXs accGrad = Eigen::VectorXs::Zero(dofs);
+            if (mInit->probablyMissingGRF[block.trial][realT] != yes)
             {
-              int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups() * 6;
-              cursor += dim;
+              if (mConfig.mResidualWeight > 0)
+              {
+                posGrad += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
+                           * mThreadResidualHelpers[threadIdx]
+                                 ->calculateResidualNormGradientWrt(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     block.grf.col(t),
+                                     neural::WithRespectTo::POSITION,
+                                     mConfig.mResidualTorqueMultiple,
+                                     mConfig.mResidualUseL1);
+                velGrad += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
+                           * mThreadResidualHelpers[threadIdx]
+                                 ->calculateResidualNormGradientWrt(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     block.grf.col(t),
+                                     neural::WithRespectTo::VELOCITY,
+                                     mConfig.mResidualTorqueMultiple,
+                                     mConfig.mResidualUseL1);
+                accGrad += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
+                           * mThreadResidualHelpers[threadIdx]
+                                 ->calculateResidualNormGradientWrt(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     block.grf.col(t),
+                                     neural::WithRespectTo::ACCELERATION,
+                                     mConfig.mResidualTorqueMultiple,
+                                     mConfig.mResidualUseL1);
+              }
+              if (mConfig.mLinearNewtonWeight > 0)
+              {
+                posGrad += mConfig.mLinearNewtonWeight
+                           * (1.0 / totalAccTimesteps)
+                           * mThreadSpatialNewtonHelpers[threadIdx]
+                                 ->calculateLinearForceGapNormGradientWrt(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     block.grf.col(t),
+                                     neural::WithRespectTo::POSITION,
+                                     mConfig.mLinearNewtonUseL1);
+                velGrad += mConfig.mLinearNewtonWeight
+                           * (1.0 / totalAccTimesteps)
+                           * mThreadSpatialNewtonHelpers[threadIdx]
+                                 ->calculateLinearForceGapNormGradientWrt(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     block.grf.col(t),
+                                     neural::WithRespectTo::VELOCITY,
+                                     mConfig.mLinearNewtonUseL1);
+                accGrad += mConfig.mLinearNewtonWeight
+                           * (1.0 / totalAccTimesteps)
+                           * mThreadSpatialNewtonHelpers[threadIdx]
+                                 ->calculateLinearForceGapNormGradientWrt(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     block.grf.col(t),
+                                     neural::WithRespectTo::ACCELERATION,
+                                     mConfig.mLinearNewtonUseL1);
+              }
+              if (mConfig.mRegularizeAcc > 0)
+              {
+                posGrad += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
+                           * mThreadSpatialNewtonHelpers[threadIdx]
+                                 ->calculateAccelerationNormGradient(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     mConfig.mRegularizeAccBodyWeights,
+                                     neural::WithRespectTo::POSITION,
+                                     mConfig.mRegularizeAccUseL1);
+                velGrad += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
+                           * mThreadSpatialNewtonHelpers[threadIdx]
+                                 ->calculateAccelerationNormGradient(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     mConfig.mRegularizeAccBodyWeights,
+                                     neural::WithRespectTo::VELOCITY,
+                                     mConfig.mRegularizeAccUseL1);
+                accGrad += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
+                           * mThreadSpatialNewtonHelpers[threadIdx]
+                                 ->calculateAccelerationNormGradient(
+                                     block.pos.col(t),
+                                     block.vel.col(t),
+                                     block.acc.col(t),
+                                     mConfig.mRegularizeAccBodyWeights,
+                                     neural::WithRespectTo::ACCELERATION,
+                                     mConfig.mRegularizeAccUseL1);
+              }
+              if (mConfig.mRegularizeJointAcc > 0)
+              {
+                accGrad += mConfig.mRegularizeJointAcc
+                           * (2.0 / totalAccTimesteps) * block.acc.col(t);
+              }
             }
-            if (mConfig.mIncludeBodyScales)
-            {
-              int dim = mThreadSkeletons.at(threadIdx)->getGroupScaleDim();
-              // Record marker gradients
-              threadGrad.segment(cursor, dim)
-                  += MarkerFitter::getMarkerLossGradientWrtGroupScales(
-                      mThreadSkeletons.at(threadIdx),
-                      mThreadMarkers.at(threadIdx),
-                      lossGradWrtMarkerError);
-              // Record joint gradients
-              threadGrad.segment(cursor, dim)
-                  += mThreadSkeletons.at(threadIdx)
-                         ->getJointWorldPositionsJacobianWrtGroupScales(
-                             mThreadJoints.at(threadIdx).at(block.trial))
-                         .transpose()
-                     * jointGrad;
 
-              cursor += dim;
-            }
-            if (mConfig.mIncludeMarkerOffsets)
+            // Record marker gradients
+            posGrad += MarkerFitter::getMarkerLossGradientWrtJoints(
+                mThreadSkeletons.at(threadIdx),
+                mThreadMarkers.at(threadIdx),
+                lossGradWrtMarkerError);
+
+            // Record regularization
+            posGrad += mConfig.mRegularizePoses * 2 * (1.0 / totalTimesteps)
+                       * (block.pos.col(t)
+                          - mInit->regularizePosesTo[block.trial].col(realT));
+
+            // Record joint gradients
+            posGrad += mThreadSkeletons.at(threadIdx)
+                           ->getJointWorldPositionsJacobianWrtJointPositions(
+                               mThreadJoints.at(threadIdx).at(block.trial))
+                           .transpose()
+                       * jointGrad;
+
+            threadGrad.segment(blockStart, dims)
+                += posGrad.segment(start, dims);
+            threadGrad.segment(blockStart + dims, dims)
+                += velGrad.segment(start, dims);
+            // Initial velocity also has a linear effect on position, so
+            // reflect that in the gradients
+            threadGrad.segment(blockStart + dims, dims)
+                += posGrad.segment(start, dims) * dt * t;
+
+            threadGrad.segment(blockStart + (dims * (2 + t)), dims)
+                += accGrad.segment(start, dims);
+
+            for (int pastAccStep = 0; pastAccStep < t; pastAccStep++)
             {
-              int dim = mThreadMarkers[threadIdx].size() * 3;
-              threadGrad.segment(cursor, dim)
-                  += MarkerFitter::getMarkerLossGradientWrtMarkerOffsets(
-                      mThreadSkeletons[threadIdx],
-                      mThreadMarkers[threadIdx],
-                      lossGradWrtMarkerError);
-              cursor += dim;
+              threadGrad.segment(
+                  blockStart + (dims * (2 + pastAccStep)), dims)
+                  += dt * velGrad.segment(start, dims);
+              int stepsSinceAcc = t - pastAccStep;
+              threadGrad.segment(
+                  blockStart + (dims * (2 + pastAccStep)), dims)
+                  += dt * dt * stepsSinceAcc * posGrad.segment(start, dims);
             }
-            if (mConfig.mIncludePoses)
+          }
+        }
+        else
+        {
+          int cursor = 0;
+          if (mConfig.mIncludeMasses)
+          {
+            int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups();
+            cursor += dim;
+          }
+          if (mConfig.mIncludeCOMs)
+          {
+            int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups() * 3;
+            cursor += dim;
+          }
+          if (mConfig.mIncludeInertias)
+          {
+            int dim = mThreadSkeletons[threadIdx]->getNumScaleGroups() * 6;
+            cursor += dim;
+          }
+          if (mConfig.mIncludeBodyScales)
+          {
+            int dim = mThreadSkeletons.at(threadIdx)->getGroupScaleDim();
+            // Record marker gradients
+            threadGrad.segment(cursor, dim)
+                += MarkerFitter::getMarkerLossGradientWrtGroupScales(
+                    mThreadSkeletons.at(threadIdx),
+                    mThreadMarkers.at(threadIdx),
+                    lossGradWrtMarkerError);
+            // Record joint gradients
+            threadGrad.segment(cursor, dim)
+                += mThreadSkeletons.at(threadIdx)
+                       ->getJointWorldPositionsJacobianWrtGroupScales(
+                           mThreadJoints.at(threadIdx).at(block.trial))
+                       .transpose()
+                   * jointGrad;
+
+            cursor += dim;
+          }
+          if (mConfig.mIncludeMarkerOffsets)
+          {
+            int dim = mThreadMarkers[threadIdx].size() * 3;
+            threadGrad.segment(cursor, dim)
+                += MarkerFitter::getMarkerLossGradientWrtMarkerOffsets(
+                    mThreadSkeletons[threadIdx],
+                    mThreadMarkers[threadIdx],
+                    lossGradWrtMarkerError);
+            cursor += dim;
+          }
+          if (mConfig.mIncludePoses)
+          {
+            Eigen::VectorXs posGrad = Eigen::VectorXs::Zero(dofs);
+            // Record marker gradients
+            posGrad += MarkerFitter::getMarkerLossGradientWrtJoints(
+                mThreadSkeletons[threadIdx],
+                mThreadMarkers[threadIdx],
+                lossGradWrtMarkerError);
+            // Record regularization
+            posGrad += mConfig.mRegularizePoses * 2 * (1.0 / totalTimesteps)
+                       * (block.pos.col(t)
+                          - mInit->regularizePosesTo[block.trial].col(realT));
+            // Record joint gradients
+            posGrad += mThreadSkeletons[threadIdx]
+                           ->getJointWorldPositionsJacobianWrtJointPositions(
+                               mThreadJoints.at(threadIdx).at(block.trial))
+                           .transpose()
+                       * jointGrad;
+
+            threadGrad.segment(blockStart, dims)
+                += posGrad.segment(start, dims);
+            threadGrad.segment(blockStart + dims, dims)
+                += posGrad.segment(start, dims) * dt * t;
+
+            for (int pastAccStep = 0; pastAccStep < t; pastAccStep++)
             {
-              Eigen::VectorXs posGrad = Eigen::VectorXs::Zero(dofs);
-              // Record marker gradients
-              posGrad += MarkerFitter::getMarkerLossGradientWrtJoints(
-                  mThreadSkeletons[threadIdx],
-                  mThreadMarkers[threadIdx],
-                  lossGradWrtMarkerError);
-              // Record regularization
-              posGrad += mConfig.mRegularizePoses * 2 * (1.0 / totalTimesteps)
-                         * (block.pos.col(t)
-                            - mInit->regularizePosesTo[block.trial].col(realT));
-              // Record joint gradients
-              posGrad += mThreadSkeletons[threadIdx]
-                             ->getJointWorldPositionsJacobianWrtJointPositions(
-                                 mThreadJoints.at(threadIdx).at(block.trial))
-                             .transpose()
-                         * jointGrad;
-
-              threadGrad.segment(blockStart, dims)
-                  += posGrad.segment(start, dims);
-              threadGrad.segment(blockStart + dims, dims)
-                  += posGrad.segment(start, dims) * dt * t;
-
-              for (int pastAccStep = 0; pastAccStep < t; pastAccStep++)
-              {
-                int stepsSinceAcc = t - pastAccStep;
-                threadGrad.segment(
-                    blockStart + (dims * (2 + pastAccStep)), dims)
-                    += dt * dt * stepsSinceAcc * posGrad.segment(start, dims);
-              }
+              int stepsSinceAcc = t - pastAccStep;
+              threadGrad.segment(
+                  blockStart + (dims * (2 + pastAccStep)), dims)
+                  += dt * dt * stepsSinceAcc * posGrad.segment(start, dims);
             }
           }
         }
-
-        posesCursor += (2 + block.len) * dims;
       }
-      assert(posesCursor == gradSize);
-      return threadGrad;
-    }));
-  }
-  for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+    }
+  };
+  pool->parallelFor(0, mBlocks.size(), 1, gradOnBlocks, maxWorkers);
+  for (const Eigen::VectorXs& threadGrad : threadGrads)
   {
-    grad += futures[threadIdx].get();
+    grad += threadGrad;
   }
 
   // // Check against single-threaded
@@ -8528,7 +8476,8 @@ DynamicsFitProblemConfig::DynamicsFitProblemConfig(
     mMaxNumTrials(-1),
     mOnlyOneTrial(-1),
     mMaxNumBlocksPerTrial(-1),
-    mNumThreads(16)
+    mNumThreads(16),
+    mLogSchedulingOverhead(false)
 // mResidualWeight(0.1),
 // mLinearNewtonWeight(0.1),
 // mMarkerWeight(1.0),
@@ -8904,6 +8853,14 @@ DynamicsFitProblemConfig& DynamicsFitProblemConfig::setNumThreads(int value)
   return *(this);
 }
 
+//==============================================================================
+DynamicsFitProblemConfig& DynamicsFitProblemConfig::setLogSchedulingOverhead(
+    bool value)
+{
+  mLogSchedulingOverhead = value;
+  return *(this);
+}
+
 //------------------------- Ipopt::TNLP --------------------------------------
 
 //==============================================================================
@@ -9304,9 +9261,38 @@ bool DynamicsFitProblem::intermediate_callback(
     mBestObjectiveValueState = mLastX;
   }
 
+  common::WorkStealingPool::Stats schedulingStats
+      = common::WorkStealingPool::getCurrentPool()->getStats();
+  mLastIterationSchedulingStats
+      = schedulingStats.since(mSchedulingStatsAtLastIteration);
+  mSchedulingStatsAtLastIteration = schedulingStats;
+  if (mConfig.mLogSchedulingOverhead)
+  {
+    const common::WorkStealingPool::Stats& stats
+        = mLastIterationSchedulingStats;
+    std::cout << "[scheduling] iter=" << iter << ",loops=" << stats.numLoops
+              << ",chunks=" << stats.numChunks << ",steals=" << stats.numSteals
+              << ",wall=" << stats.wallSeconds << "s"
+              << ",busy=" << stats.busySeconds << "s"
+              << ",overhead=" << stats.overheadSeconds << "s";
+    if (stats.wallSeconds > 0)
+    {
+      std::cout << " (" << (100.0 * stats.overheadSeconds / stats.wallSeconds)
+                << "%)";
+    }
+    std::cout << std::endl;
+  }
+
   return true;
 }
 
+//==============================================================================
+common::WorkStealingPool::Stats
+DynamicsFitProblem::getLastIterationSchedulingStats()
+{
+  return mLastIterationSchedulingStats;
+}
+
 //==============================================================================
 DynamicsFitter::DynamicsFitter(
     std::shared_ptr<dynamics::Skeleton> skeleton,
@@ -11,6 +11,7 @@
 #include "dart/biomechanics/ForcePlate.hpp"
 #include "dart/biomechanics/MarkerFitter.hpp"
 #include "dart/biomechanics/enums.hpp"
+#include "dart/common/WorkStealingPool.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -681,13 +682,24 @@ public:
 
   int getExpectedForcesDim();
 
+  /// This caps the number of pool workers (on top of the calling thread) that
+  /// the parallel linear system builders use, and so the number of skeleton
+  /// copies this helper keeps around. The default is 16.
+  void setNumThreads(int numThreads);
+
 protected:
+  /// This makes sure there are at least `numSlots` copies of the skeleton (and
+  /// helpers wrapping them) for parallel loops to use, and syncs their body
+  /// parameters with mSkel.
+  void prepareThreadSkels(int numSlots);
+
   std::shared_ptr<dynamics::Skeleton> mSkel;
   std::vector<int> mForceBodies;
   std::vector<neural::DifferentiableExternalForce> mForces;
 
   std::vector<std::shared_ptr<dynamics::Skeleton>> mThreadSkels;
   std::vector<ResidualForceHelper> mThreadHelpers;
+  int mNumThreads;
 };
 
 /**
@@ -937,6 +949,7 @@ public:
   DynamicsFitProblemConfig& setMaxNumBlocksPerTrial(int value);
 
   DynamicsFitProblemConfig& setNumThreads(int value);
+  DynamicsFitProblemConfig& setLogSchedulingOverhead(bool value);
 
 public:
   friend class DynamicsFitProblem;
@@ -989,7 +1002,12 @@ public:
   int mOnlyOneTrial;
   int mMaxNumBlocksPerTrial;
 
+  // This caps how many workers of the shared WorkStealingPool each parallel
+  // loss or gradient evaluation will use
   int mNumThreads;
+  // If true, this prints how much time the thread pool spent scheduling work
+  // on every iteration of the optimization
+  bool mLogSchedulingOverhead;
 };
 
 /**
@@ -1067,6 +1085,10 @@ public:
   // This gets the gradient of the loss function
   Eigen::VectorXs computeGradientParallel(Eigen::VectorXs x);
 
+  // This returns how much time the shared thread pool spent running work, and
+  // scheduling it, between the last two calls to intermediate_callback()
+  common::WorkStealingPool::Stats getLastIterationSchedulingStats();
+
   // This gets the gradient of the loss function
   Eigen::VectorXs finiteDifferenceGradient(
       Eigen::VectorXs x, bool useRidders = true);
@@ -1240,6 +1262,9 @@ public:
   std::vector<std::shared_ptr<ResidualForceHelper>> mThreadResidualHelpers;
   std::vector<std::shared_ptr<SpatialNewtonHelper>> mThreadSpatialNewtonHelpers;
 
+  common::WorkStealingPool::Stats mSchedulingStatsAtLastIteration;
+  common::WorkStealingPool::Stats mLastIterationSchedulingStats;
+
   int mBestObjectiveValueIteration;
   s_t mBestObjectiveValue;
   Eigen::VectorXs mInitX;
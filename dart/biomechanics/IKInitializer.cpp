@@ -1871,12 +1871,20 @@ s_t IKInitializer::recenterAxisJointsBasedOnBoneAngles(bool logOutput)
       {
         markerObservationsOverSweep.push_back(std::vector<Eigen::Vector3s>());
       }
+      // Only the bodies below the swept joint move, so we keep the body
+      // transforms in a buffer and only recompute that subtree at each step
+      std::vector<Eigen::Isometry3s> bodyTransforms;
+      mSkel->getBodyWorldTransforms(bodyTransforms);
+      std::vector<std::size_t> sweepDofs;
+      sweepDofs.push_back(revoluteJoint->getDof(0)->getIndexInSkeleton());
+      Eigen::VectorXs sweepPos = Eigen::VectorXs::Zero(1);
       for (int i = 0; i < steps; i++)
       {
-        s_t pos = min + stepSize * i;
-        revoluteJoint->setPosition(0, pos);
+        sweepPos(0) = min + stepSize * i;
+        mSkel->setPositionsAndUpdateBodyWorldTransforms(
+            sweepDofs, sweepPos, bodyTransforms);
         Eigen::VectorXs markerWorldPos
-            = mSkel->getMarkerWorldPositions(markers);
+            = mSkel->getMarkerWorldPositions(markers, bodyTransforms);
         for (int j = 0; j < markers.size(); j++)
         {
           markerObservationsOverSweep[j].push_back(
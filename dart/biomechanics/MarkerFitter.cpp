@@ -1,6 +1,7 @@
 #include "dart/biomechanics/MarkerFitter.hpp"
 
 #include <fstream>
+#include <functional>
 #include <future>
 #include <iostream>
 #include <limits>
@@ -18,7 +19,9 @@
 #include "dart/biomechanics/IKInitializer.hpp"
 #include "dart/biomechanics/MarkerFixer.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/biomechanics/SkeletonClonePool.hpp"
 #include "dart/biomechanics/macros.hpp"
+#include "dart/common/WorkStealingPool.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/Joint.hpp"
@@ -41,6 +44,26 @@ namespace biomechanics {
 
 using namespace Ipopt;
 
+namespace {
+
+//==============================================================================
+/// This runs a list of independent fits on the shared thread pool, one per
+/// chunk, and blocks until they've all finished. Sharing the pool (rather than
+/// spawning a thread per fit) keeps many fitters running at once from
+/// over-subscribing the machine.
+void runOnSharedPool(const std::vector<std::function<void()>>& tasks)
+{
+  common::WorkStealingPool::getCurrentPool()->parallelFor(
+      0, tasks.size(), 1, [&](int, int taskStart, int taskEnd) {
+        for (int task = taskStart; task < taskEnd; task++)
+        {
+          tasks[task]();
+        }
+      });
+}
+
+} // namespace
+
 //==============================================================================
 /// This unflattens an input vector, given some information about the problm
 MarkerFitterState::MarkerFitterState(
@@ -3187,7 +3210,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
                "between our sampled indices..."
             << std::endl;
 
-  std::vector<std::future<void>> blockFitFutures;
+  std::vector<std::function<void()>> blockFits;
 
   // 2. Do a forward pass starting at each sample index and guessing forward to
   // the next index
@@ -3254,7 +3277,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
         forwardScores.segment(thisIndex, segmentLength),
         false);
         */
-    blockFitFutures.push_back(std::async(
+    blockFits.push_back(std::bind(
         &MarkerFitter::fitTrajectory,
         this,
         solution->groupScales,
@@ -3339,7 +3362,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
         backwardScores.segment(thisIndex, segmentLength),
         true);
         */
-    blockFitFutures.push_back(std::async(
+    blockFits.push_back(std::bind(
         &MarkerFitter::fitTrajectory,
         this,
         solution->groupScales,
@@ -3359,11 +3382,8 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
         true));
   }
 
-  // 4. Wait for all the threads to finish
-  for (int i = 0; i < blockFitFutures.size(); i++)
-  {
-    blockFitFutures[i].get();
-  }
+  // 4. Run all the fits on the shared thread pool, and wait for them to finish
+  runOnSharedPool(blockFits);
 
   // 5. Merge the pose guesses by taking the best guess from forward and
   // backwards passes
@@ -3671,13 +3691,13 @@ MarkerInitialization MarkerFitter::fineTuneIK(
       mSkeleton->getNumDofs(), markerObservations.size());
   result.poseScores = Eigen::VectorXs::Zero(markerObservations.size());
 
-  std::vector<std::future<void>> blockFitFutures;
+  std::vector<std::function<void()>> blockFits;
   for (int i = 0; i < numBlocks; i++)
   {
     std::cout << "Starting fit for whole block " << i << "/" << numBlocks
               << std::endl;
 
-    blockFitFutures.push_back(std::async(
+    blockFits.push_back(std::bind(
         &MarkerFitter::fitTrajectory,
         this,
         result.groupScales,
@@ -3699,12 +3719,9 @@ MarkerInitialization MarkerFitter::fineTuneIK(
         result.poseScores.segment(blockStartIndices[i], blockSizeIndices[i]),
         false));
   }
-  for (int i = 0; i < numBlocks; i++)
-  {
-    blockFitFutures[i].get();
-    std::cout << "Finished fit for whole block " << i << "/" << numBlocks
-              << std::endl;
-  }
+  runOnSharedPool(blockFits);
+  std::cout << "Finished fit for all " << numBlocks << " whole blocks"
+            << std::endl;
 
   return result;
 }
@@ -4846,7 +4863,7 @@ MarkerInitialization MarkerFitter::getInitialization(
     // at most numBlocks times
     for (int k = 0; k < params.numIKTries; k++)
     {
-      std::vector<std::future<void>> blockFitFutures;
+      std::vector<std::function<void()>> blockFits;
       for (int i = 0; i < numBlocks; i++)
       {
         std::cout << "Starting fit for whole block " << i << "/" << numBlocks
@@ -4854,7 +4871,7 @@ MarkerInitialization MarkerFitter::getInitialization(
 
         if (shouldProcessBlock[i])
         {
-          blockFitFutures.push_back(std::async(
+          blockFits.push_back(std::bind(
               &MarkerFitter::fitTrajectory,
               this,
               result.groupScales,
@@ -4877,17 +4894,10 @@ MarkerInitialization MarkerFitter::getInitialization(
                   blockStartIndices[i], blockSizeIndices[i]),
               false));
         }
-        else
-        {
-          blockFitFutures.push_back(std::async([]() {}));
-        }
-      }
-      for (int i = 0; i < numBlocks; i++)
-      {
-        blockFitFutures[i].get();
-        std::cout << "Finished fit for whole block " << i << "/" << numBlocks
-                  << std::endl;
       }
+      runOnSharedPool(blockFits);
+      std::cout << "Finished fit for all " << numBlocks << " whole blocks"
+                << std::endl;
 
       bool foundGap = false;
       for (int i = 1; i < numBlocks; i++)
@@ -6293,7 +6303,7 @@ void MarkerFitter::fitTrajectory(
   {
     const std::lock_guard<std::mutex> lock(
         *(const_cast<std::mutex*>(&fitter->mGlobalLock)));
-    skeleton = fitter->mSkeleton->clone();
+    skeleton = SkeletonClonePool::getGlobalPool()->acquire(fitter->mSkeleton);
   }
   skeleton->setGroupScales(groupScales);
 
@@ -6343,7 +6353,8 @@ void MarkerFitter::fitTrajectory(
           threadJointsForSkeletonBallJoints;
       for (int t = 0; t < numThreads; t++)
       {
-        threadSkeleton.push_back(skeleton->cloneSkeleton());
+        threadSkeleton.push_back(
+            SkeletonClonePool::getGlobalPool()->acquire(skeleton));
         threadSkeletonBallJoints.push_back(skeletonBallJoints->cloneSkeleton());
         std::vector<dynamics::Joint*> jointsForThreadSkeletonBallJoints;
         for (auto joint : joints)
@@ -6362,7 +6373,7 @@ void MarkerFitter::fitTrajectory(
         int warpEndExclusive
             = min((int)(warp + 1) * numThreads, (int)markerObservations.size());
 
-        std::vector<std::future<Eigen::VectorXs>> warpFutures;
+        std::vector<std::function<Eigen::VectorXs()>> warpTasks;
         // 2. Run through each observation in sequence, and do a best fit
         for (int j = warpStart; j < warpEndExclusive; j++)
         {
@@ -6373,23 +6384,23 @@ void MarkerFitter::fitTrajectory(
             i = markerObservations.size() - 1 - j;
           }
 
-          warpFutures.push_back(std::async([i,
-                                            &markerObservations,
-                                            &jointCenters,
-                                            &jointWeights,
-                                            &jointAxis,
-                                            &axisWeights,
-                                            &markerWeights,
-                                            &markerOffsets,
-                                            &fitter,
-                                            &joints,
-                                            &result,
-                                            &resultScores,
-                                            initialGuess,
-                                            threadIdx,
-                                            &threadSkeleton,
-                                            &threadSkeletonBallJoints,
-                                            &threadJointsForSkeletonBallJoints] {
+          warpTasks.push_back([i,
+                               &markerObservations,
+                               &jointCenters,
+                               &jointWeights,
+                               &jointAxis,
+                               &axisWeights,
+                               &markerWeights,
+                               &markerOffsets,
+                               &fitter,
+                               &joints,
+                               &result,
+                               &resultScores,
+                               initialGuess,
+                               threadIdx,
+                               &threadSkeleton,
+                               &threadSkeletonBallJoints,
+                               &threadJointsForSkeletonBallJoints] {
             // 2.0. Grab the skeleton copies for this thread
             std::shared_ptr<dynamics::Skeleton> skeleton
                 = threadSkeleton[threadIdx];
@@ -6589,13 +6600,22 @@ void MarkerFitter::fitTrajectory(
             // 2.4. Set up for the next iteration, by setting the initial guess
             // to the current solve
             return skeletonBallJoints->getPositions();
-          }));
+          });
         }
 
-        // Block until all these warps have finished
-        for (auto& warpFuture : warpFutures)
+        // Run the warp on the shared thread pool, and block until it has
+        // finished
+        std::vector<Eigen::VectorXs> warpResults(warpTasks.size());
+        common::WorkStealingPool::getCurrentPool()->parallelFor(
+            0, warpTasks.size(), 1, [&](int, int taskStart, int taskEnd) {
+              for (int task = taskStart; task < taskEnd; task++)
+              {
+                warpResults[task] = warpTasks[task]();
+              }
+            });
+        if (warpResults.size() > 0)
         {
-          initialGuess = warpFuture.get();
+          initialGuess = warpResults[warpResults.size() - 1];
         }
       }
     }
@@ -7810,6 +7830,31 @@ Eigen::VectorXs MarkerFitter::getMarkerError(
   return observedMarkerDiffs;
 }
 
+//==============================================================================
+/// This is the same as getMarkerError(), but reads the body transforms out of
+/// a buffer kept up to date by Skeleton::getBodyWorldTransforms() or
+/// Skeleton::setPositionsAndUpdateBodyWorldTransforms()
+Eigen::VectorXs MarkerFitter::getMarkerError(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const std::vector<std::pair<int, Eigen::Vector3s>>& visibleMarkerWorldPoses,
+    const std::vector<Eigen::Isometry3s>& bodyWorldTransforms)
+{
+  Eigen::VectorXs observedMarkerDiffs
+      = Eigen::VectorXs::Zero(mMarkers.size() * 3);
+
+  Eigen::VectorXs adjustedMarkerWorldPoses
+      = skeleton->getMarkerWorldPositions(markers, bodyWorldTransforms);
+
+  for (auto pair : visibleMarkerWorldPoses)
+  {
+    observedMarkerDiffs.segment<3>(pair.first * 3)
+        = adjustedMarkerWorldPoses.segment<3>(pair.first * 3) - pair.second;
+  }
+
+  return observedMarkerDiffs;
+}
+
 //==============================================================================
 /// This gets the overall objective term for the MarkerFitter for a single
 /// timestep. The MarkerFitter is trying to do a bilevel optimization to
@@ -8085,7 +8130,8 @@ Eigen::VectorXs MarkerFitter::getMarkerLossGradientWrtJoints(
     const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
     Eigen::VectorXs lossGradWrtMarkerError)
 {
-  return skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers)
+  return skeleton->getSparseMarkerWorldPositionsJacobianWrtJointPositions(
+             markers)
              .transpose()
          * lossGradWrtMarkerError;
 }
@@ -8103,27 +8149,35 @@ MarkerFitter::finiteDifferenceSquaredMarkerLossGradientWrtJoints(
 
   const s_t EPS = 1e-7;
 
-  Eigen::VectorXs perturbed = originalPos;
+  // Each perturbation only moves the bodies below a single DOF, so we keep the
+  // body transforms in a buffer and only recompute those subtrees
+  std::vector<Eigen::Isometry3s> bodyTransforms;
+  skeleton->getBodyWorldTransforms(bodyTransforms);
+  std::vector<std::size_t> dofs(1);
+  Eigen::VectorXs perturbed = Eigen::VectorXs::Zero(1);
   for (int i = 0; i < originalPos.size(); i++)
   {
-    perturbed = originalPos;
-    perturbed(i) += EPS;
-    skeleton->setPositions(perturbed);
+    dofs[0] = i;
+    perturbed(0) = originalPos(i) + EPS;
+    skeleton->setPositionsAndUpdateBodyWorldTransforms(
+        dofs, perturbed, bodyTransforms);
 
-    s_t plus = computeIKLoss(
-        getMarkerError(skeleton, markers, visibleMarkerWorldPoses));
+    s_t plus = computeIKLoss(getMarkerError(
+        skeleton, markers, visibleMarkerWorldPoses, bodyTransforms));
 
-    perturbed = originalPos;
-    perturbed(i) -= EPS;
-    skeleton->setPositions(perturbed);
+    perturbed(0) = originalPos(i) - EPS;
+    skeleton->setPositionsAndUpdateBodyWorldTransforms(
+        dofs, perturbed, bodyTransforms);
 
-    s_t minus = computeIKLoss(
-        getMarkerError(skeleton, markers, visibleMarkerWorldPoses));
+    s_t minus = computeIKLoss(getMarkerError(
+        skeleton, markers, visibleMarkerWorldPoses, bodyTransforms));
 
     grad(i) = (plus - minus) / (2 * EPS);
-  }
 
-  skeleton->setPositions(originalPos);
+    perturbed(0) = originalPos(i);
+    skeleton->setPositionsAndUpdateBodyWorldTransforms(
+        dofs, perturbed, bodyTransforms);
+  }
 
   return grad;
 }
@@ -8324,8 +8378,9 @@ Eigen::MatrixXs MarkerFitter::getIKLossGradientWrtJointsJacobianWrtJoints(
     const Eigen::VectorXs& markerError,
     const std::vector<int>& sparsityMap)
 {
-  Eigen::MatrixXs firstOrderJac
-      = skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+  const Eigen::SparseMatrix<s_t, Eigen::RowMajor> firstOrderJac
+      = skeleton->getSparseMarkerWorldPositionsJacobianWrtJointPositions(
+          markers);
 
   // First order grad:
   // 2 * markerError.transpose() * firstOrderJac
@@ -8461,8 +8516,9 @@ Eigen::MatrixXs MarkerFitter::getIKLossGradientWrtJointsJacobianWrtGroupScales(
     const Eigen::VectorXs& markerError,
     const std::vector<int>& sparsityMap)
 {
-  Eigen::MatrixXs firstOrderJac
-      = skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+  const Eigen::SparseMatrix<s_t, Eigen::RowMajor> firstOrderJac
+      = skeleton->getSparseMarkerWorldPositionsJacobianWrtJointPositions(
+          markers);
 
   // First order grad:
   // 2 * markerError.transpose() * firstOrderJac
@@ -8603,8 +8659,9 @@ MarkerFitter::getIKLossGradientWrtJointsJacobianWrtMarkerOffsets(
     const Eigen::VectorXs& markerError,
     const std::vector<int>& sparsityMap)
 {
-  Eigen::MatrixXs firstOrderJac
-      = skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+  const Eigen::SparseMatrix<s_t, Eigen::RowMajor> firstOrderJac
+      = skeleton->getSparseMarkerWorldPositionsJacobianWrtJointPositions(
+          markers);
 
   // First order grad:
   // 2 * markerError.transpose() * firstOrderJac
@@ -1105,6 +1105,17 @@ public:
       const std::vector<std::pair<int, Eigen::Vector3s>>&
           visibleMarkerWorldPoses);
 
+  /// This is the same as getMarkerError(), but reads the body transforms out
+  /// of a buffer kept up to date by Skeleton::getBodyWorldTransforms() or
+  /// Skeleton::setPositionsAndUpdateBodyWorldTransforms()
+  Eigen::VectorXs getMarkerError(
+      const std::shared_ptr<dynamics::Skeleton>& skeleton,
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const std::vector<std::pair<int, Eigen::Vector3s>>&
+          visibleMarkerWorldPoses,
+      const std::vector<Eigen::Isometry3s>& bodyWorldTransforms);
+
   /// This gets the overall objective term for the MarkerFitter for a single
   /// timestep. The MarkerFitter is trying to do a bilevel optimization to
   /// minimize this term.
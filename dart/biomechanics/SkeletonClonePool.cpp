@@ -0,0 +1,252 @@
+#include "dart/biomechanics/SkeletonClonePool.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/Marker.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+namespace {
+
+void hashCombine(std::size_t& seed, std::size_t value)
+{
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+} // namespace
+
+//==============================================================================
+SkeletonClonePool::SkeletonClonePool(int maxIdlePerSkeleton)
+  : mMaxIdlePerSkeleton(std::max(0, maxIdlePerSkeleton)),
+    mNumClonesCreated(0),
+    mNumClonesReused(0)
+{
+}
+
+//==============================================================================
+std::shared_ptr<SkeletonClonePool> SkeletonClonePool::getGlobalPool()
+{
+  static std::shared_ptr<SkeletonClonePool> globalPool
+      = std::make_shared<SkeletonClonePool>();
+  return globalPool;
+}
+
+//==============================================================================
+std::shared_ptr<dynamics::Skeleton> SkeletonClonePool::acquire(
+    std::shared_ptr<dynamics::Skeleton> source)
+{
+  const std::size_t signature = getStructureSignature(source);
+
+  std::shared_ptr<dynamics::Skeleton> clone;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    pruneExpired();
+    SourceClones& entry = mClones[source];
+    if (entry.clones.empty() || entry.signature != signature)
+    {
+      // Either this is the first time we've seen this source, or it's been
+      // restructured since we made its clones, so they're useless to us now
+      entry.signature = signature;
+      entry.clones.clear();
+    }
+
+    int numIdle = 0;
+    for (auto it = entry.clones.begin(); it != entry.clones.end();)
+    {
+      // The pool's reference is the only one left, so nobody is using it
+      if (it->use_count() == 1)
+      {
+        if (!clone)
+        {
+          // Copying the pointer here, under the lock, marks it as in use
+          clone = *it;
+        }
+        else if (numIdle >= mMaxIdlePerSkeleton)
+        {
+          it = entry.clones.erase(it);
+          continue;
+        }
+        else
+        {
+          numIdle++;
+        }
+      }
+      ++it;
+    }
+    if (clone)
+    {
+      mNumClonesReused++;
+    }
+  }
+
+  if (clone)
+  {
+    // Syncing touches every body, so do it outside the lock
+    syncClone(source, clone);
+    return clone;
+  }
+
+  clone = source->cloneSkeleton();
+  std::unique_lock<std::mutex> lock(mMutex);
+  mNumClonesCreated++;
+  SourceClones& entry = mClones[source];
+  if (entry.signature == signature)
+  {
+    entry.clones.push_back(clone);
+  }
+  return clone;
+}
+
+//==============================================================================
+void SkeletonClonePool::clear()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mClones.clear();
+}
+
+//==============================================================================
+int SkeletonClonePool::getNumClonesCreated()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mNumClonesCreated;
+}
+
+//==============================================================================
+int SkeletonClonePool::getNumClonesReused()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mNumClonesReused;
+}
+
+//==============================================================================
+int SkeletonClonePool::getNumIdleClones()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  int count = 0;
+  for (auto& pair : mClones)
+  {
+    if (pair.first.expired())
+    {
+      continue;
+    }
+    for (auto& clone : pair.second.clones)
+    {
+      if (clone.use_count() == 1)
+      {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+//==============================================================================
+std::size_t SkeletonClonePool::getStructureSignature(
+    const std::shared_ptr<dynamics::Skeleton>& skel)
+{
+  std::hash<std::string> hashString;
+  std::size_t signature = 0;
+  hashCombine(signature, skel->getNumBodyNodes());
+  hashCombine(signature, skel->getNumDofs());
+  hashCombine(signature, skel->getNumScaleGroups());
+  for (int i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = skel->getBodyNode(i);
+    hashCombine(signature, hashString(body->getName()));
+    dynamics::BodyNode* parent = body->getParentBodyNode();
+    hashCombine(
+        signature, parent == nullptr ? 0 : parent->getIndexInSkeleton() + 1);
+    dynamics::Joint* joint = body->getParentJoint();
+    hashCombine(signature, hashString(joint->getType()));
+    hashCombine(signature, joint->getNumDofs());
+    hashCombine(signature, skel->getScaleGroupIndex(body));
+    hashCombine(signature, body->getNumMarkers());
+  }
+  for (int i = 0; i < skel->getNumDofs(); i++)
+  {
+    hashCombine(signature, hashString(skel->getDof(i)->getName()));
+  }
+  return signature;
+}
+
+//==============================================================================
+void SkeletonClonePool::syncClone(
+    const std::shared_ptr<dynamics::Skeleton>& source,
+    const std::shared_ptr<dynamics::Skeleton>& clone)
+{
+  // Copy these a link at a time, like World::clone() does, since they may
+  // have been set on single links rather than on whole scale groups
+  clone->setBodyScales(source->getBodyScales());
+  clone->setLinkMasses(source->getLinkMasses());
+  clone->setLinkCOMs(source->getLinkCOMs());
+  clone->setLinkMOIs(source->getLinkMOIs());
+  clone->setLinkBetas(source->getLinkBetas());
+
+  // Scaling only moves the joints along with their bodies, so copy the joint
+  // offsets over too in case they've been edited directly. The setters take
+  // the unscaled offsets, and apply the scales we just copied.
+  for (int i = 0; i < source->getNumJoints(); i++)
+  {
+    const dynamics::Joint* sourceJoint = source->getJoint(i);
+    dynamics::Joint* cloneJoint = clone->getJoint(i);
+    Eigen::Isometry3s fromParent = sourceJoint->getTransformFromParentBodyNode();
+    fromParent.translation()
+        = sourceJoint->getOriginalTransformFromParentBodyNode();
+    cloneJoint->setTransformFromParentBodyNode(fromParent);
+    Eigen::Isometry3s fromChild = sourceJoint->getTransformFromChildBodyNode();
+    fromChild.translation()
+        = sourceJoint->getOriginalTransformFromChildBodyNode();
+    cloneJoint->setTransformFromChildBodyNode(fromChild);
+  }
+  for (int i = 0; i < source->getNumDofs(); i++)
+  {
+    const dynamics::DegreeOfFreedom* sourceDof = source->getDof(i);
+    dynamics::DegreeOfFreedom* cloneDof = clone->getDof(i);
+    cloneDof->setSpringStiffness(sourceDof->getSpringStiffness());
+    cloneDof->setRestPosition(sourceDof->getRestPosition());
+    cloneDof->setDampingCoefficient(sourceDof->getDampingCoefficient());
+    cloneDof->setCoulombFriction(sourceDof->getCoulombFriction());
+  }
+  // The signature checks that every body has the same number of markers
+  for (int i = 0; i < source->getNumMarkers(); i++)
+  {
+    clone->getMarker(i)->setLocalPosition(
+        source->getMarker(i)->getLocalPosition());
+  }
+
+  clone->setPositionUpperLimits(source->getPositionUpperLimits());
+  clone->setPositionLowerLimits(source->getPositionLowerLimits());
+  clone->setVelocityUpperLimits(source->getVelocityUpperLimits());
+  clone->setVelocityLowerLimits(source->getVelocityLowerLimits());
+
+  clone->setGravity(source->getGravity());
+  clone->setTimeStep(source->getTimeStep());
+  clone->setPositions(source->getPositions());
+  clone->setVelocities(source->getVelocities());
+  clone->clearExternalForces();
+}
+
+//==============================================================================
+void SkeletonClonePool::pruneExpired()
+{
+  for (auto it = mClones.begin(); it != mClones.end();)
+  {
+    if (it->first.expired())
+    {
+      it = mClones.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+} // namespace biomechanics
+} // namespace dart
@@ -0,0 +1,107 @@
+#ifndef DART_BIOMECH_SKELETON_CLONE_POOL_HPP_
+#define DART_BIOMECH_SKELETON_CLONE_POOL_HPP_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+/**
+ * Cloning a full body skeleton is surprisingly expensive, and the fitters clone
+ * a copy per thread every time they set up a parallel problem. This keeps
+ * clones around once they're no longer in use, so that the next problem built
+ * on the same source skeleton can pick up an existing clone instead of
+ * allocating a fresh one.
+ *
+ * acquire() hands out the clone's own shared_ptr, the same one its getPtr()
+ * returns. The pool keeps a reference too, and treats a clone as idle once the
+ * pool's reference is the only one left. So anything that keeps the clone
+ * alive (the pointer acquire() returned, getPtr(), a BodyNodePtr) also keeps
+ * it from being handed out again.
+ *
+ * Clones are kept per source skeleton, and tagged with a signature of the
+ * source's structure (its bodies, joints, DOFs and scale groups). If the
+ * source is restructured, the old clones are dropped rather than reused.
+ */
+class SkeletonClonePool : public std::enable_shared_from_this<SkeletonClonePool>
+{
+public:
+  /// `maxIdlePerSkeleton` caps how many unused clones we hold on to for each
+  /// source skeleton, so a one-off burst of parallelism doesn't pin memory
+  /// forever. Extra idle clones are dropped the next time acquire() is called
+  /// for that source.
+  SkeletonClonePool(int maxIdlePerSkeleton = 64);
+
+  /// Returns the shared, process-wide clone pool
+  static std::shared_ptr<SkeletonClonePool> getGlobalPool();
+
+  /// This returns a clone of `source`, reusing an idle one if we have one.
+  /// Reused clones get the source's per-link scales, masses, COMs, inertias
+  /// and betas, joint offsets, DOF springs, damping and friction, marker
+  /// offsets, joint limits, gravity, time step, positions and velocities
+  /// copied over, so they are interchangeable with a fresh cloneSkeleton() for
+  /// the fitters' needs.
+  std::shared_ptr<dynamics::Skeleton> acquire(
+      std::shared_ptr<dynamics::Skeleton> source);
+
+  /// Drops all the idle clones
+  void clear();
+
+  /// The number of clones we've had to create from scratch
+  int getNumClonesCreated();
+
+  /// The number of times acquire() was able to hand out an idle clone
+  int getNumClonesReused();
+
+  /// The number of idle clones currently held, across all source skeletons
+  int getNumIdleClones();
+
+  /// This returns a hash of the structure of `skel`: the names and parents of
+  /// its bodies, the types and DOF counts of its joints, the names of its DOFs,
+  /// which scale group each body is in, and how many markers it has. Clones
+  /// made at one signature are never handed out for a source at a different
+  /// signature.
+  static std::size_t getStructureSignature(
+      const std::shared_ptr<dynamics::Skeleton>& skel);
+
+protected:
+  /// All the clones we've made of one source skeleton, whether they're idle
+  /// or currently in use
+  struct SourceClones
+  {
+    std::size_t signature;
+    std::vector<std::shared_ptr<dynamics::Skeleton>> clones;
+  };
+
+  /// Copies over the state that the fitters change on their source skeletons
+  /// between problems
+  static void syncClone(
+      const std::shared_ptr<dynamics::Skeleton>& source,
+      const std::shared_ptr<dynamics::Skeleton>& clone);
+
+  /// Drops the clones of any source skeleton that has been destroyed. Clones
+  /// that are still in use stay alive with their users.
+  void pruneExpired();
+
+  int mMaxIdlePerSkeleton;
+  std::mutex mMutex;
+  // Keyed on the identity of the source (not its address, which could be
+  // reused by a later skeleton)
+  std::map<
+      std::weak_ptr<dynamics::Skeleton>,
+      SourceClones,
+      std::owner_less<std::weak_ptr<dynamics::Skeleton>>>
+      mClones;
+  int mNumClonesCreated;
+  int mNumClonesReused;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
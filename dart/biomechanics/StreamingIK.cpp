@@ -14,6 +14,22 @@ using namespace math;
 
 namespace biomechanics {
 
+namespace {
+
+/// This returns the time from `from` to `to`, in microseconds, or 0 if `to` is
+/// before `from`
+uint64_t microsBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to)
+{
+  const long micros
+      = std::chrono::duration_cast<std::chrono::microseconds>(to - from)
+            .count();
+  return micros > 0 ? static_cast<uint64_t>(micros) : 0;
+}
+
+} // namespace
+
 /// This class manages a thread that runs the IK continuously, and updates as
 /// we get new marker/joint observations.
 StreamingIK::StreamingIK(
@@ -23,7 +39,13 @@ StreamingIK::StreamingIK(
     mMarkers(markers),
     mSolverThreadRunning(false),
     mNumBodyNodes(skeleton->getNumBodyNodes()),
-    mLastTimestamp(0)
+    mLastTimestamp(0),
+    mFrameBudgetMicros(0),
+    mStaleFrameMicros(50000),
+    mFrameSequence(0),
+    mLastHandledFrame(0),
+    mNumFramesSolved(0),
+    mNumFramesDropped(0)
 {
   mLastMarkerObservations = Eigen::VectorXs(mMarkers.size() * 3);
   mLastMarkerObservationWeights = Eigen::VectorXs(mMarkers.size() * 3);
@@ -40,6 +62,7 @@ StreamingIK::StreamingIK(
 StreamingIK::~StreamingIK()
 {
   mSolverThreadRunning = false;
+  mNewFrame.notify_all();
   if (mSolverThread.valid())
   {
     mSolverThread.get();
@@ -87,8 +110,60 @@ void StreamingIK::startSolverThread()
     s_t lastError = std::numeric_limits<s_t>::infinity();
     s_t lr = 1e-3;
 
+    // In real time mode, this is the frame we're currently refining, or -1 if
+    // we're waiting for the next one
+    long solvingFrame = -1;
+    bool solvingFrameAnswered = false;
+    std::chrono::steady_clock::time_point solvingArrival;
+
     while (mSolverThreadRunning)
     {
+      // These can be changed while we're running, so re-read them every time
+      const std::chrono::microseconds frameBudget(mFrameBudgetMicros.load());
+      const std::chrono::microseconds staleFrame(mStaleFrameMicros.load());
+      const bool realTime = frameBudget.count() > 0;
+
+      if (!realTime && solvingFrame != -1)
+      {
+        // We've switched to free running partway through a frame. If we
+        // haven't published a pose for it yet, leave it for the free running
+        // bookkeeping below to answer.
+        if (!solvingFrameAnswered)
+        {
+          const std::lock_guard<std::mutex> lock(mGlobalLock);
+          mLastHandledFrame = solvingFrame - 1;
+        }
+        solvingFrame = -1;
+      }
+
+      if (realTime && solvingFrame == -1)
+      {
+        std::unique_lock<std::mutex> lock(mGlobalLock);
+        // Time out every so often, so we notice if the thread gets stopped
+        mNewFrame.wait_for(lock, std::chrono::milliseconds(10), [&]() {
+          return mFrameSequence != mLastHandledFrame || !mSolverThreadRunning;
+        });
+        if (mFrameSequence == mLastHandledFrame)
+        {
+          continue;
+        }
+        // Every frame between the last one we handled and the newest one got
+        // overwritten before we could get to it
+        mNumFramesDropped += mFrameSequence - mLastHandledFrame - 1;
+        mLastHandledFrame = mFrameSequence;
+        if (std::chrono::steady_clock::now() - mFrameArrivalTime > staleFrame)
+        {
+          mNumFramesDropped++;
+          continue;
+        }
+        solvingFrame = mFrameSequence;
+        solvingFrameAnswered = false;
+        solvingArrival = mFrameArrivalTime;
+        // Don't let the jump in error from the new markers throttle the
+        // learning rate
+        lastError = std::numeric_limits<s_t>::infinity();
+      }
+
       J.block(0, 0, mMarkers.size() * 3, mSkeletonBallJoints->getNumDofs())
           = mSkeletonBallJoints
                 ->getMarkerWorldPositionsJacobianWrtJointPositions(
@@ -111,6 +186,16 @@ void StreamingIK::startSolverThread()
 
       if (mLastMarkerObservationWeights.isZero())
       {
+        if (solvingFrame != -1)
+        {
+          // There's nothing to fit on this frame
+          if (!solvingFrameAnswered)
+          {
+            const std::lock_guard<std::mutex> lock(mGlobalLock);
+            mNumFramesDropped++;
+          }
+          solvingFrame = -1;
+        }
         continue;
       }
 
@@ -220,6 +305,35 @@ void StreamingIK::startSolverThread()
         mSkeleton->setGroupScales(x.segment(
             mSkeletonBallJoints->getNumDofs(),
             mSkeletonBallJoints->getGroupScaleDim()));
+
+        const std::chrono::steady_clock::time_point now
+            = std::chrono::steady_clock::now();
+        // In both modes, the first pose we publish after a frame arrives is
+        // the one that answers it, so that's what we measure latency to
+        if (solvingFrame != -1)
+        {
+          if (!solvingFrameAnswered)
+          {
+            mLatencies.record(microsBetween(solvingArrival, now));
+            mNumFramesSolved++;
+            solvingFrameAnswered = true;
+          }
+          // This is an anytime solver, so we keep refining until we run out of
+          // budget, converge, or have a newer frame to move on to
+          if (now - solvingArrival >= frameBudget
+              || mFrameSequence != solvingFrame
+              || std::abs(errorChange) < 1e-12)
+          {
+            solvingFrame = -1;
+          }
+        }
+        else if (!realTime && mFrameSequence != mLastHandledFrame)
+        {
+          mNumFramesDropped += mFrameSequence - mLastHandledFrame - 1;
+          mLastHandledFrame = mFrameSequence;
+          mLatencies.record(microsBetween(mFrameArrivalTime, now));
+          mNumFramesSolved++;
+        }
       }
     }
   });
@@ -298,7 +412,8 @@ void StreamingIK::observeMarkers(
     std::vector<Eigen::Vector3s>& markers,
     std::vector<int> classes,
     long timestamp,
-    std::vector<Eigen::Vector9s>& copTorqueForces)
+    std::vector<Eigen::Vector9s>& copTorqueForces,
+    std::chrono::steady_clock::time_point arrivalTime)
 {
   Eigen::VectorXs pose;
 
@@ -326,7 +441,11 @@ void StreamingIK::observeMarkers(
     }
 
     pose = mLastPose;
+
+    mFrameSequence++;
+    mFrameArrivalTime = arrivalTime;
   }
+  mNewFrame.notify_one();
 
   mLastCopTorqueForces = copTorqueForces;
 
@@ -365,6 +484,7 @@ void StreamingIK::setAnthropometricPrior(
 void StreamingIK::reset(std::shared_ptr<server::GUIStateMachine> gui)
 {
   mSolverThreadRunning = false;
+  mNewFrame.notify_all();
   if (mSolverThread.valid())
   {
     mSolverThread.get();
@@ -389,6 +509,55 @@ void StreamingIK::reset(std::shared_ptr<server::GUIStateMachine> gui)
   startSolverThread();
 }
 
+/// This puts the solver into real time mode, with a fixed time budget for each
+/// frame
+void StreamingIK::setRealTimeMode(long frameBudgetMicros, long staleFrameMicros)
+{
+  mFrameBudgetMicros = frameBudgetMicros;
+  mStaleFrameMicros = staleFrameMicros;
+  // Don't leave the solver waiting on a frame if it should be free running now
+  mNewFrame.notify_all();
+}
+
+/// This returns a copy of the histogram of latencies, in microseconds, from
+/// when each frame arrived to the first pose we published after it
+performance::PerformanceHistogram StreamingIK::getLatencyHistogram()
+{
+  const std::lock_guard<std::mutex> lock(mGlobalLock);
+  return mLatencies;
+}
+
+/// This returns the most recent pose the solver has published
+Eigen::VectorXs StreamingIK::getLastPose()
+{
+  const std::lock_guard<std::mutex> lock(mGlobalLock);
+  return mLastPose;
+}
+
+/// This returns the number of frames we've published a pose for
+long StreamingIK::getNumFramesSolved()
+{
+  const std::lock_guard<std::mutex> lock(mGlobalLock);
+  return mNumFramesSolved;
+}
+
+/// This returns the number of frames we skipped, because they were stale or
+/// had been overwritten by a newer frame before we got to them
+long StreamingIK::getNumFramesDropped()
+{
+  const std::lock_guard<std::mutex> lock(mGlobalLock);
+  return mNumFramesDropped;
+}
+
+/// This clears the latency histogram and the frame counts
+void StreamingIK::resetLatencyStats()
+{
+  const std::lock_guard<std::mutex> lock(mGlobalLock);
+  mLatencies.clear();
+  mNumFramesSolved = 0;
+  mNumFramesDropped = 0;
+}
+
 /// This method uses the recent history of poses to estimate the current state
 /// of the skeleton, including velocity and acceleration.
 void StreamingIK::estimateState(long now, int numHistory, int polynomialDegree)
@@ -1,8 +1,12 @@
 #ifndef DART_BIOMECH_STREAMING_IK
 #define DART_BIOMECH_STREAMING_IK
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <tuple>
 #include <vector>
 
@@ -10,6 +14,7 @@
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/dynamics/SmartPointer.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/performance/PerformanceLog.hpp"
 #include "dart/server/GUIStateMachine.hpp"
 
 namespace dart {
@@ -43,11 +48,45 @@ public:
 
   /// This method takes in a set of markers, along with their assigned classes,
   /// and updates the targets for the IK to match the observed markers.
+  /// `arrivalTime` is when the frame reached us, which is what we measure
+  /// latency from. Callers that do work on a frame before handing it to the IK
+  /// (like classifying the markers) should pass in the time the frame arrived.
   void observeMarkers(
       std::vector<Eigen::Vector3s>& markers,
       std::vector<int> classes,
       long timestamp,
-      std::vector<Eigen::Vector9s>& copTorqueForces);
+      std::vector<Eigen::Vector9s>& copTorqueForces,
+      std::chrono::steady_clock::time_point arrivalTime
+      = std::chrono::steady_clock::now());
+
+  /// This puts the solver into real time mode. Instead of iterating freely, the
+  /// solver waits for each new frame of markers, and refines the pose (warm
+  /// started from the last pose) until `frameBudgetMicros` after the frame
+  /// arrived. It stops sooner if the solve converges, or if a newer frame shows
+  /// up, and then idles until the next frame. Frames that are already older
+  /// than `staleFrameMicros` by the time the solver gets to them are dropped,
+  /// as are frames that get overwritten by a newer frame before the solver gets
+  /// to them. Pass a budget of 0 to go back to free running. This is safe to
+  /// call while the solver thread is running, and takes effect on its next
+  /// iteration.
+  void setRealTimeMode(long frameBudgetMicros, long staleFrameMicros = 50000);
+
+  /// This returns a copy of the histogram of latencies, in microseconds, from
+  /// when each frame arrived to the first pose we published after it
+  performance::PerformanceHistogram getLatencyHistogram();
+
+  /// This returns the most recent pose the solver has published
+  Eigen::VectorXs getLastPose();
+
+  /// This returns the number of frames we've published a pose for
+  long getNumFramesSolved();
+
+  /// This returns the number of frames we skipped, because they were stale or
+  /// had been overwritten by a newer frame before we got to them
+  long getNumFramesDropped();
+
+  /// This clears the latency histogram and the frame counts
+  void resetLatencyStats();
 
   /// This sets an anthropometric prior used to help condition the body to
   /// keep reasonable scalings.
@@ -100,6 +139,23 @@ protected:
   std::vector<Eigen::Vector9s> mLastCopTorqueForces;
   std::vector<Eigen::VectorXs> mPoseHistory;
   std::vector<long> mTimestampHistory;
+
+  /// Real time mode settings. A budget of 0 means we're free running. The
+  /// solver thread re-reads these every iteration.
+  std::atomic<long> mFrameBudgetMicros;
+  std::atomic<long> mStaleFrameMicros;
+
+  /// This is bumped by every call to observeMarkers(), and wakes up the solver
+  /// in real time mode
+  long mFrameSequence;
+  std::chrono::steady_clock::time_point mFrameArrivalTime;
+  std::condition_variable mNewFrame;
+  /// The last frame the solver either published a pose for or dropped
+  long mLastHandledFrame;
+
+  performance::PerformanceHistogram mLatencies;
+  long mNumFramesSolved;
+  long mNumFramesDropped;
 };
 
 } // namespace biomechanics
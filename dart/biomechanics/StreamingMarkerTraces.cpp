@@ -10,11 +10,47 @@
 #include <utility>
 #include <vector>
 
+#include "dart/math/AssignmentMatcher.hpp"
 #include "dart/math/MathTypes.hpp"
 
 namespace dart {
 namespace biomechanics {
 
+namespace {
+
+/// This is the integer coordinate of the grid cell containing `coord`. We
+/// clamp far away points, which can only put extra traces into a cell, and
+/// never drop any, since every candidate is checked against the real distance.
+long long getGridCoord(s_t coord, s_t cellSize)
+{
+  const s_t cell = std::floor(coord / cellSize);
+  if (!(cell > -1e6))
+    return -1000000;
+  if (!(cell < 1e6))
+    return 1000000;
+  return static_cast<long long>(cell);
+}
+
+/// This packs the integer coordinates of a grid cell into a single sortable key
+long long getGridKey(long long x, long long y, long long z)
+{
+  const long long mask = (1LL << 21) - 1;
+  return ((x & mask) << 42) | ((y & mask) << 21) | (z & mask);
+}
+
+/// This finds the root of a union-find forest, with path halving
+int findGroup(std::vector<int>& parents, int i)
+{
+  while (parents[i] != i)
+  {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  }
+  return i;
+}
+
+} // namespace
+
 Trace::Trace(
     const Eigen::Vector3s& first_point,
     long trace_time,
@@ -262,38 +298,23 @@ StreamingMarkerTraces::observeMarkers(
   mTraces.erase(it, mTraces.end());
 
   // 2. Assign markers to traces
-  std::vector<bool> markers_assigned(markers.size(), false);
-  Eigen::MatrixXs dists = Eigen::MatrixXs::Zero(mTraces.size(), markers.size());
-  for (size_t i = 0; i < mTraces.size(); ++i)
-  {
-    const Eigen::Vector3s projected_marker = mTraces[i].project_to(now);
-    // const Eigen::Vector3s projected_marker = mTraces[i].points.back();
-    for (size_t j = 0; j < markers.size(); ++j)
-    {
-      dists(i, j) = (projected_marker - markers[j]).norm();
-    }
-  }
-  for (size_t k = 0; k < std::min(markers.size(), mTraces.size()); ++k)
+  std::vector<int> markerTraces;
+  assignMarkersToTraces(markers, now, markerTraces);
+  for (size_t j = 0; j < markers.size(); ++j)
   {
-    // Find the closest pair
-    Eigen::MatrixXf::Index minRow, minCol;
-    s_t minDist = dists.minCoeff(&minRow, &minCol);
-    if (minDist > mTraceMaxJoinDistance)
+    const int i = markerTraces[j];
+    if (i != -1)
     {
-      break;
+      mTraces[i].add_point(markers[j], now);
+      resultTraceTags[j] = mTraces[i].uuid;
+      resultClasses[j] = mTraces[i].get_predicted_class();
     }
-    markers_assigned[minCol] = true;
-    mTraces[minRow].add_point(markers[minCol], now);
-    resultTraceTags[minCol] = mTraces[minRow].uuid;
-    resultClasses[minCol] = mTraces[minRow].get_predicted_class();
-    dists.row(minRow).setConstant(std::numeric_limits<s_t>::infinity());
-    dists.col(minCol).setConstant(std::numeric_limits<s_t>::infinity());
   }
 
   // 3. Add any remaining markers as new traces
   for (size_t j = 0; j < markers.size(); ++j)
   {
-    if (!markers_assigned[j])
+    if (markerTraces[j] == -1)
     {
       mTraces.emplace_back(markers[j], now, mNumClasses, mNumBodies);
     }
@@ -302,6 +323,185 @@ StreamingMarkerTraces::observeMarkers(
   return std::make_pair(resultClasses, resultTraceTags);
 }
 
+//==============================================================================
+/// This fills in `markerTraces` with the index into mTraces that each marker
+/// should be appended to, or -1 if it should start a new trace. Traces are
+/// projected to `now`, and bucketed into a uniform grid with cells
+/// mTraceMaxJoinDistance wide, so each marker only needs to be compared
+/// against the traces in its own and neighboring cells. Markers and traces
+/// within mTraceMaxJoinDistance of each other are then split into connected
+/// groups, and each group is assigned with math::AssignmentMatcher.
+void StreamingMarkerTraces::assignMarkersToTraces(
+    const std::vector<Eigen::Vector3s>& markers,
+    long now,
+    std::vector<int>& markerTraces)
+{
+  const int numTraces = mTraces.size();
+  const int numMarkers = markers.size();
+  markerTraces.assign(numMarkers, -1);
+  if (numTraces == 0 || numMarkers == 0)
+  {
+    return;
+  }
+
+  // Bucket the projected trace heads by grid cell. Sorting by cell key lets us
+  // find all the traces in a cell with a binary search.
+  const s_t cellSize = std::max(mTraceMaxJoinDistance, (s_t)1e-6);
+  mProjectedTraces.resize(numTraces);
+  mTraceCells.clear();
+  for (int i = 0; i < numTraces; i++)
+  {
+    mProjectedTraces[i] = mTraces[i].project_to(now);
+    const Eigen::Vector3s& p = mProjectedTraces[i];
+    if (!p.allFinite())
+      continue;
+    mTraceCells.emplace_back(
+        getGridKey(
+            getGridCoord(p(0), cellSize),
+            getGridCoord(p(1), cellSize),
+            getGridCoord(p(2), cellSize)),
+        i);
+  }
+  std::sort(mTraceCells.begin(), mTraceCells.end());
+
+  // Collect every (trace, marker) pair close enough to join, and union them
+  // into connected groups as we go. Traces are nodes [0, numTraces), and
+  // markers are nodes [numTraces, numTraces + numMarkers).
+  mCandidatePairs.clear();
+  mGroupParents.resize(numTraces + numMarkers);
+  for (int i = 0; i < numTraces + numMarkers; i++)
+  {
+    mGroupParents[i] = i;
+  }
+  for (int j = 0; j < numMarkers; j++)
+  {
+    const Eigen::Vector3s& marker = markers[j];
+    if (!marker.allFinite())
+      continue;
+    const long long x = getGridCoord(marker(0), cellSize);
+    const long long y = getGridCoord(marker(1), cellSize);
+    const long long z = getGridCoord(marker(2), cellSize);
+    for (int dx = -1; dx <= 1; dx++)
+    {
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+          const long long key = getGridKey(x + dx, y + dy, z + dz);
+          auto it = std::lower_bound(
+              mTraceCells.begin(),
+              mTraceCells.end(),
+              std::make_pair(key, std::numeric_limits<int>::min()));
+          for (; it != mTraceCells.end() && it->first == key; ++it)
+          {
+            const int i = it->second;
+            const s_t dist = (mProjectedTraces[i] - marker).norm();
+            if (dist > mTraceMaxJoinDistance)
+              continue;
+            mCandidatePairs.push_back(CandidatePair{i, j, dist, -1});
+            const int a = findGroup(mGroupParents, i);
+            const int b = findGroup(mGroupParents, numTraces + j);
+            if (a != b)
+            {
+              mGroupParents[a] = b;
+            }
+          }
+        }
+      }
+    }
+  }
+  if (mCandidatePairs.empty())
+  {
+    return;
+  }
+
+  // Sort the candidates so that each group's pairs are contiguous
+  for (CandidatePair& pair : mCandidatePairs)
+  {
+    pair.group = findGroup(mGroupParents, pair.trace);
+  }
+  std::sort(
+      mCandidatePairs.begin(),
+      mCandidatePairs.end(),
+      [](const CandidatePair& a, const CandidatePair& b) {
+        return a.group < b.group;
+      });
+
+  // Assign each group on its own. Running AssignmentMatcher on the negated
+  // distances greedily takes the closest remaining pair, which is what a
+  // greedy pass over the whole traces x markers distance matrix would do, since
+  // taking a pair in one group never changes what's available in another.
+  mLocalIndex.assign(numTraces + numMarkers, -1);
+  size_t start = 0;
+  while (start < mCandidatePairs.size())
+  {
+    size_t end = start + 1;
+    while (end < mCandidatePairs.size()
+           && mCandidatePairs[end].group == mCandidatePairs[start].group)
+    {
+      end++;
+    }
+
+    // The common case, with well separated markers, is a lone pair
+    if (end - start == 1)
+    {
+      markerTraces[mCandidatePairs[start].marker]
+          = mCandidatePairs[start].trace;
+      start = end;
+      continue;
+    }
+
+    mGroupTraces.clear();
+    mGroupMarkers.clear();
+    for (size_t k = start; k < end; k++)
+    {
+      const CandidatePair& pair = mCandidatePairs[k];
+      if (mLocalIndex[pair.trace] == -1)
+      {
+        mLocalIndex[pair.trace] = mGroupTraces.size();
+        mGroupTraces.push_back(pair.trace);
+      }
+      if (mLocalIndex[numTraces + pair.marker] == -1)
+      {
+        mLocalIndex[numTraces + pair.marker] = mGroupMarkers.size();
+        mGroupMarkers.push_back(pair.marker);
+      }
+    }
+
+    // Pairs that are too far apart to join get -inf, which AssignmentMatcher
+    // never picks. Resizing only reallocates when the group's shape changes,
+    // and most groups are the same couple of markers swapping back and forth.
+    mGroupWeights.resize(mGroupTraces.size(), mGroupMarkers.size());
+    mGroupWeights.setConstant(-std::numeric_limits<s_t>::infinity());
+    for (size_t k = start; k < end; k++)
+    {
+      const CandidatePair& pair = mCandidatePairs[k];
+      mGroupWeights(
+          mLocalIndex[pair.trace], mLocalIndex[numTraces + pair.marker])
+          = -pair.dist;
+    }
+    Eigen::VectorXi assignment
+        = math::AssignmentMatcher::assignRowsToColumns(mGroupWeights);
+    for (int row = 0; row < assignment.size(); row++)
+    {
+      if (assignment(row) != -1)
+      {
+        markerTraces[mGroupMarkers[assignment(row)]] = mGroupTraces[row];
+      }
+    }
+
+    for (int trace : mGroupTraces)
+    {
+      mLocalIndex[trace] = -1;
+    }
+    for (int marker : mGroupMarkers)
+    {
+      mLocalIndex[numTraces + marker] = -1;
+    }
+    start = end;
+  }
+}
+
 //==============================================================================
 /// This method returns the features that we used to predict the classes of
 /// the markers. The first element of the pair is the features (which are
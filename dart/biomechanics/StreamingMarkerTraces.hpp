@@ -114,6 +114,18 @@ public:
   void renderTracesToGUI(std::shared_ptr<server::GUIStateMachine> gui);
 
 protected:
+  /// This fills in `markerTraces` with the index into mTraces that each marker
+  /// should be appended to, or -1 if it should start a new trace. Traces are
+  /// projected to `now`, and bucketed into a uniform grid with cells
+  /// mTraceMaxJoinDistance wide, so each marker only needs to be compared
+  /// against the traces in its own and neighboring cells. Markers and traces
+  /// within mTraceMaxJoinDistance of each other are then split into connected
+  /// groups, and each group is assigned with math::AssignmentMatcher.
+  void assignMarkersToTraces(
+      const std::vector<Eigen::Vector3s>& markers,
+      long now,
+      std::vector<int>& markerTraces);
+
   std::mutex mGlobalLock;
 
   int mNumClasses;
@@ -125,6 +137,24 @@ protected:
   long mTraceTimeoutMillis;
   s_t mTraceMaxJoinDistance;
   int mFeatureMaxStrideToleranceMillis;
+
+  // This is scratch space for assignMarkersToTraces(), which we keep around so
+  // that we don't reallocate it on every frame
+  struct CandidatePair
+  {
+    int trace;
+    int marker;
+    s_t dist;
+    int group;
+  };
+  std::vector<Eigen::Vector3s> mProjectedTraces;
+  std::vector<std::pair<long long, int>> mTraceCells;
+  std::vector<CandidatePair> mCandidatePairs;
+  std::vector<int> mGroupParents;
+  std::vector<int> mGroupTraces;
+  std::vector<int> mGroupMarkers;
+  std::vector<int> mLocalIndex;
+  Eigen::MatrixXs mGroupWeights;
 };
 
 } // namespace biomechanics
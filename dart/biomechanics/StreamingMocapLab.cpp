@@ -1,5 +1,6 @@
 #include "dart/biomechanics/StreamingMocapLab.hpp"
 
+#include <chrono>
 #include <cmath>
 #include <limits>
 #include <string>
@@ -59,20 +60,24 @@ void StreamingMocapLab::listenToCortex(
 {
   mCortex = std::make_shared<CortexStreaming>(
       host, cortexMulticastPort, cortexRequestsPort);
-  mCortex->setFrameHandler([&](std::vector<std::string> markerNames,
-                               std::vector<Eigen::Vector3s> markers,
-                               std::vector<Eigen::MatrixXs> copTorqueForces) {
-    (void)markerNames;
-    (void)copTorqueForces;
+  mCortex->setFrameBufferHandler([&](const CortexFrameBuffer& frame) {
     long timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                          std::chrono::system_clock::now().time_since_epoch())
                          .count();
-    std::vector<Eigen::Vector9s> copTorqueForcesAvg;
-    for (int i = 0; i < copTorqueForces.size(); i++)
+    // These are reused from frame to frame, so they only allocate while
+    // they're growing to fit the largest frame
+    mCortexMarkers.resize(frame.numMarkers);
+    for (int i = 0; i < frame.numMarkers; i++)
     {
-      copTorqueForcesAvg.push_back(copTorqueForces[i].colwise().mean());
+      mCortexMarkers[i] = frame.markers.col(i);
     }
-    manuallyObserveMarkers(markers, timestamp, copTorqueForcesAvg);
+    mCortexCopTorqueForces.resize(frame.numForcePlates);
+    for (int i = 0; i < frame.numForcePlates; i++)
+    {
+      mCortexCopTorqueForces[i]
+          = frame.plateCopTorqueForce[i].colwise().mean();
+    }
+    manuallyObserveMarkers(mCortexMarkers, timestamp, mCortexCopTorqueForces);
   });
   mCortex->initialize();
 }
@@ -84,12 +89,16 @@ void StreamingMocapLab::manuallyObserveMarkers(
     long timestamp,
     std::vector<Eigen::Vector9s>& copTorqueForces)
 {
+  // Latency is measured from here, so it includes classifying the markers
+  std::chrono::steady_clock::time_point arrivalTime
+      = std::chrono::steady_clock::now();
   auto pair = mMarkerTraces->observeMarkers(markers, timestamp);
   if (mGui)
   {
     mMarkerTraces->renderTracesToGUI(mGui);
   }
-  mIK->observeMarkers(markers, pair.first, timestamp, copTorqueForces);
+  mIK->observeMarkers(
+      markers, pair.first, timestamp, copTorqueForces, arrivalTime);
 }
 
 /// This method returns the features that we used to predict the classes of
@@ -121,6 +130,22 @@ void StreamingMocapLab::reset(std::shared_ptr<server::GUIStateMachine> gui)
   mMarkerTraces->reset();
 }
 
+/// This puts the IK solver into real time mode, with a fixed time budget for
+/// each frame
+void StreamingMocapLab::setRealTimeMode(
+    long frameBudgetMicros, long staleFrameMicros)
+{
+  mIK->setRealTimeMode(frameBudgetMicros, staleFrameMicros);
+}
+
+/// This returns a copy of the histogram of latencies, in microseconds, from
+/// when a frame of markers arrived to when the IK first published a pose after
+/// it
+performance::PerformanceHistogram StreamingMocapLab::getLatencyHistogram()
+{
+  return mIK->getLatencyHistogram();
+}
+
 /// This method returns the IK solver that this mocap lab is using
 std::shared_ptr<StreamingIK> StreamingMocapLab::getIK()
 {
@@ -13,6 +13,7 @@
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/dynamics/SmartPointer.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/performance/PerformanceLog.hpp"
 #include "dart/server/GUIStateMachine.hpp"
 
 namespace dart {
@@ -81,6 +82,16 @@ public:
   /// marker traces
   void reset(std::shared_ptr<server::GUIStateMachine> gui);
 
+  /// This puts the IK solver into real time mode, with a fixed time budget for
+  /// each frame. This takes effect immediately, even if the solver is already
+  /// running. See StreamingIK::setRealTimeMode() for details.
+  void setRealTimeMode(long frameBudgetMicros, long staleFrameMicros = 50000);
+
+  /// This returns a copy of the histogram of latencies, in microseconds, from
+  /// when a frame of markers arrived to when the IK first published a pose
+  /// after it
+  performance::PerformanceHistogram getLatencyHistogram();
+
   /// This method returns the IK solver that this mocap lab is using
   std::shared_ptr<StreamingIK> getIK();
 
@@ -97,6 +108,10 @@ protected:
   std::shared_ptr<StreamingIK> mIK;
   std::shared_ptr<CortexStreaming> mCortex;
   std::shared_ptr<server::GUIStateMachine> mGui;
+
+  /// Scratch space for handing frames from Cortex to the IK
+  std::vector<Eigen::Vector3s> mCortexMarkers;
+  std::vector<Eigen::Vector9s> mCortexCopTorqueForces;
 };
 
 } // namespace biomechanics
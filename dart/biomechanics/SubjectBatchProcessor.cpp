@@ -0,0 +1,224 @@
+#include "dart/biomechanics/SubjectBatchProcessor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <thread>
+
+namespace dart {
+namespace biomechanics {
+
+//==============================================================================
+SubjectBatchProcessor::SubjectBatchProcessor(
+    int numCores, int maxSubjectsInFlight)
+  : mNumCores(numCores),
+    mMaxSubjectsInFlight(maxSubjectsInFlight),
+    mWallSeconds(0.0)
+{
+  if (mNumCores <= 0)
+  {
+    mNumCores = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+  if (mMaxSubjectsInFlight <= 0)
+  {
+    // Most of the work in a fit is in parallel loops, so we only need a few
+    // subjects in flight to soak up the serial sections of the others
+    mMaxSubjectsInFlight = std::max(1, mNumCores / 4);
+  }
+  mMaxSubjectsInFlight = std::min(mMaxSubjectsInFlight, mNumCores);
+}
+
+//==============================================================================
+void SubjectBatchProcessor::addSubject(SubjectBatchJob job)
+{
+  mJobs.push_back(job);
+}
+
+//==============================================================================
+void SubjectBatchProcessor::addSubject(
+    std::string name,
+    std::function<void()> kinematics,
+    std::function<void()> dynamics)
+{
+  SubjectBatchJob job;
+  job.name = name;
+  job.kinematics = kinematics;
+  job.dynamics = dynamics;
+  mJobs.push_back(job);
+}
+
+//==============================================================================
+int SubjectBatchProcessor::getNumSubjects()
+{
+  return mJobs.size();
+}
+
+//==============================================================================
+int SubjectBatchProcessor::getNumCores()
+{
+  return mNumCores;
+}
+
+//==============================================================================
+int SubjectBatchProcessor::getMaxSubjectsInFlight()
+{
+  return mMaxSubjectsInFlight;
+}
+
+//==============================================================================
+std::vector<SubjectBatchResult> SubjectBatchProcessor::run()
+{
+  const auto startTime = std::chrono::steady_clock::now();
+
+  {
+    std::unique_lock<std::mutex> lock(mResultsMutex);
+    mResults.clear();
+    for (SubjectBatchJob& job : mJobs)
+    {
+      SubjectBatchResult result;
+      result.name = job.name;
+      result.success = false;
+      result.kinematicsSeconds = 0.0;
+      result.dynamicsSeconds = 0.0;
+      mResults.push_back(result);
+    }
+  }
+
+  const int numCoordinators
+      = std::min(mMaxSubjectsInFlight, (int)mJobs.size());
+
+  // Coordinators run chunks of their own loops while they wait on the pool, so
+  // they count against the core budget too. This pool is our own, rather than
+  // a resized global pool, so that anyone else using the global pool at the
+  // same time isn't affected.
+  std::shared_ptr<common::WorkStealingPool> pool
+      = std::make_shared<common::WorkStealingPool>(
+          std::max(0, mNumCores - std::max(1, numCoordinators)));
+
+  std::atomic<int> nextJob(0);
+  auto runStage = [](const std::function<void()>& stage,
+                     s_t& seconds,
+                     std::string& error) {
+    if (!stage)
+    {
+      return true;
+    }
+    const auto stageStart = std::chrono::steady_clock::now();
+    bool success = true;
+    try
+    {
+      stage();
+    }
+    catch (const std::exception& e)
+    {
+      error = e.what();
+      success = false;
+    }
+    catch (...)
+    {
+      error = "unknown exception";
+      success = false;
+    }
+    seconds = std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - stageStart)
+                  .count();
+    return success;
+  };
+  auto coordinator = [&]() {
+    // The fitters run their loops on getCurrentPool(), so this routes all of
+    // this subject's parallel work onto our pool
+    common::WorkStealingPool::ScopedPool scopedPool(pool);
+    while (true)
+    {
+      const int jobIdx = nextJob++;
+      if (jobIdx >= mJobs.size())
+      {
+        return;
+      }
+      SubjectBatchJob& job = mJobs[jobIdx];
+      std::cout << "Starting subject " << jobIdx << "/" << mJobs.size() << ": "
+                << job.name << std::endl;
+
+      SubjectBatchResult result;
+      result.name = job.name;
+      result.kinematicsSeconds = 0.0;
+      result.dynamicsSeconds = 0.0;
+      result.success
+          = runStage(job.kinematics, result.kinematicsSeconds, result.error)
+            && runStage(job.dynamics, result.dynamicsSeconds, result.error);
+      if (!result.success)
+      {
+        std::cout << "Subject " << job.name << " failed: " << result.error
+                  << std::endl;
+      }
+
+      std::unique_lock<std::mutex> lock(mResultsMutex);
+      mResults[jobIdx] = result;
+    }
+  };
+
+  std::vector<std::thread> coordinators;
+  for (int i = 0; i < numCoordinators; i++)
+  {
+    coordinators.emplace_back(coordinator);
+  }
+  for (std::thread& thread : coordinators)
+  {
+    thread.join();
+  }
+
+  mSchedulingStats = pool->getStats();
+  pool = nullptr;
+
+  mWallSeconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - startTime)
+                     .count();
+  std::cout << "Processed " << getNumSucceeded() << "/" << mJobs.size()
+            << " subjects in " << mWallSeconds << "s ("
+            << getSubjectsPerHour() << " subjects/hour)" << std::endl;
+
+  std::unique_lock<std::mutex> lock(mResultsMutex);
+  return mResults;
+}
+
+//==============================================================================
+int SubjectBatchProcessor::getNumSucceeded()
+{
+  std::unique_lock<std::mutex> lock(mResultsMutex);
+  int numSucceeded = 0;
+  for (SubjectBatchResult& result : mResults)
+  {
+    if (result.success)
+    {
+      numSucceeded++;
+    }
+  }
+  return numSucceeded;
+}
+
+//==============================================================================
+s_t SubjectBatchProcessor::getWallSeconds()
+{
+  return mWallSeconds;
+}
+
+//==============================================================================
+s_t SubjectBatchProcessor::getSubjectsPerHour()
+{
+  if (mWallSeconds <= 0)
+  {
+    return 0.0;
+  }
+  return getNumSucceeded() * 3600.0 / mWallSeconds;
+}
+
+//==============================================================================
+common::WorkStealingPool::Stats SubjectBatchProcessor::getSchedulingStats()
+{
+  return mSchedulingStats;
+}
+
+} // namespace biomechanics
+} // namespace dart
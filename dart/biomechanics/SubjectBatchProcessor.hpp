@@ -0,0 +1,116 @@
+#ifndef DART_BIOMECH_SUBJECT_BATCH_PROCESSOR_HPP_
+#define DART_BIOMECH_SUBJECT_BATCH_PROCESSOR_HPP_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dart/common/WorkStealingPool.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+/// This is one subject's worth of work for the SubjectBatchProcessor. The
+/// `kinematics` stage (typically MarkerFitter::runMultiTrialKinematicsPipeline)
+/// always finishes before the `dynamics` stage (typically a series of
+/// DynamicsFitter passes) starts. Either stage may be left empty.
+struct SubjectBatchJob
+{
+  std::string name;
+  std::function<void()> kinematics;
+  std::function<void()> dynamics;
+};
+
+/// This is what happened to a single SubjectBatchJob
+struct SubjectBatchResult
+{
+  std::string name;
+  bool success;
+  // If a stage threw, this is the exception's message
+  std::string error;
+  s_t kinematicsSeconds;
+  s_t dynamicsSeconds;
+};
+
+/**
+ * This runs the kinematics and dynamics fits for many subjects at once, on a
+ * single shared core budget.
+ *
+ * Each subject is driven by its own coordinator thread, so the serial parts of
+ * one subject's fit (IPOPT's linear algebra, setting up problems, etc) overlap
+ * with the parallel parts of other subjects' fits. All of the parallel inner
+ * loops of the MarkerFitter and DynamicsFitter (the IK blocks, and the
+ * dynamics loss and gradient blocks) run on a WorkStealingPool owned by run(),
+ * which is bound as the current pool on every coordinator thread, and is sized
+ * so that the pool workers plus the coordinators exactly fill the core budget.
+ * The global pool is left alone, so other fits running at the same time keep
+ * their own thread counts. Skeleton copies the fitters make for their threads come from the
+ * global SkeletonClonePool, so they get reused from one problem (and one
+ * subject) to the next, instead of being re-cloned every time.
+ */
+class SubjectBatchProcessor
+{
+public:
+  /// `numCores` is the total number of threads we're allowed to keep busy, or
+  /// -1 to use every hardware thread. `maxSubjectsInFlight` is how many
+  /// subjects we work on at once, or -1 to pick automatically.
+  SubjectBatchProcessor(int numCores = -1, int maxSubjectsInFlight = -1);
+
+  /// This queues up a subject to be processed by the next call to run()
+  void addSubject(SubjectBatchJob job);
+
+  /// This queues up a subject to be processed by the next call to run()
+  void addSubject(
+      std::string name,
+      std::function<void()> kinematics,
+      std::function<void()> dynamics);
+
+  /// This returns the number of subjects queued up
+  int getNumSubjects();
+
+  /// This returns the total number of threads we're allowed to keep busy
+  int getNumCores();
+
+  /// This returns how many subjects run() works on at once
+  int getMaxSubjectsInFlight();
+
+  /// This processes all the queued subjects, blocking until they're all
+  /// finished, and returns one result per subject in the order they were
+  /// added. A subject whose stage throws is marked as failed, and doesn't
+  /// stop the rest of the batch.
+  std::vector<SubjectBatchResult> run();
+
+  /// This returns the number of subjects that finished successfully on the
+  /// last call to run()
+  int getNumSucceeded();
+
+  /// This returns the wall clock duration of the last call to run(), in
+  /// seconds
+  s_t getWallSeconds();
+
+  /// This returns the throughput of the last call to run(), in successfully
+  /// processed subjects per hour
+  s_t getSubjectsPerHour();
+
+  /// This returns how much time run()'s thread pool spent running, and
+  /// scheduling, work during the last call to run()
+  common::WorkStealingPool::Stats getSchedulingStats();
+
+protected:
+  int mNumCores;
+  int mMaxSubjectsInFlight;
+  std::vector<SubjectBatchJob> mJobs;
+
+  std::mutex mResultsMutex;
+  std::vector<SubjectBatchResult> mResults;
+  s_t mWallSeconds;
+  common::WorkStealingPool::Stats mSchedulingStats;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -1,13 +1,17 @@
 #include "dart/biomechanics/SubjectOnDisk.hpp"
 
+#include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <memory>
 #include <vector>
 
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
 #include <stdio.h>
 #include <tinyxml2.h>
 
@@ -294,7 +298,7 @@ proto::DetectedTrialFeature detectedTrialFeatureToProto(
 }
 
 SubjectOnDisk::SubjectOnDisk(const std::string& path)
-  : mPath(path), mLoadedAllFrames(false)
+  : mPath(path), mLoadedAllFrames(false), mColumnar(false)
 {
   // 1. Open the file
   FILE* file = fopen(path.c_str(), "r");
@@ -363,6 +367,44 @@ SubjectOnDisk::SubjectOnDisk(const std::string& path)
   mSensorFrameSize = header.raw_sensor_frame_size();
   mProcessingPassFrameSize = header.processing_pass_frame_size();
   mDataSectionStart = sizeof(int64_t) + headerSize;
+  mColumnar = header.version() >= 5;
+  if (mColumnar)
+  {
+    mSensorColumns.resize(getNumTrials());
+    mPassColumns.resize(getNumTrials());
+    for (int i = 0; i < getNumTrials(); i++)
+    {
+      mPassColumns[i].resize(getTrialNumProcessingPasses(i));
+    }
+    for (int i = 0; i < header.column_size(); i++)
+    {
+      const proto::SubjectOnDiskColumn& columnProto = header.column(i);
+      const int trial = columnProto.trial();
+      const int pass = columnProto.pass();
+      if (trial < 0 || trial >= getNumTrials() || pass < -1
+          || pass >= getTrialNumProcessingPasses(trial))
+      {
+        std::cout << "SubjectOnDisk found an out of bounds column \""
+                  << columnProto.name() << "\" for trial " << trial
+                  << " and pass " << pass << " in " << path
+                  << ", ignoring it." << std::endl;
+        continue;
+      }
+      ColumnLocation column;
+      column.rows = columnProto.rows();
+      column.offset = columnProto.offset();
+      if (pass == -1)
+      {
+        mSensorColumns[trial][columnProto.name()] = column;
+      }
+      else
+      {
+        mPassColumns[trial][pass][columnProto.name()] = column;
+      }
+    }
+  }
+
+  computeTrialDataOffsets();
 
   fclose(file);
 }
@@ -371,15 +413,40 @@ SubjectOnDisk::SubjectOnDisk(std::shared_ptr<SubjectOnDiskHeader> header)
 {
   mHeader = header;
   mLoadedAllFrames = true;
+  mColumnar = false;
   mSensorFrameSize = 0;
   mProcessingPassFrameSize = 0;
   mDataSectionStart = 0;
+  computeTrialDataOffsets();
+}
+
+/// This fills in mTrialDataOffsets from the header and the frame sizes
+void SubjectOnDisk::computeTrialDataOffsets()
+{
+  mTrialDataOffsets.clear();
+  long trialDataOffset = 0;
+  for (int i = 0; i < getNumTrials(); i++)
+  {
+    mTrialDataOffsets.push_back(trialDataOffset);
+    const long trialFrameSize
+        = (mSensorFrameSize
+           + (getTrialNumProcessingPasses(i) * mProcessingPassFrameSize));
+    trialDataOffset += getTrialLength(i) * trialFrameSize;
+  }
 }
 
 /// This will write a B3D file to disk
 void SubjectOnDisk::writeB3D(
-    const std::string& outputPath, std::shared_ptr<SubjectOnDiskHeader> header)
+    const std::string& outputPath,
+    std::shared_ptr<SubjectOnDiskHeader> header,
+    bool columnar)
 {
+  if (columnar)
+  {
+    writeColumnarB3D(outputPath, header);
+    return;
+  }
+
   // 0. Open the file
   FILE* file = fopen(outputPath.c_str(), "wb");
   if (file == nullptr)
@@ -524,6 +591,215 @@ void SubjectOnDisk::writeB3D(
   fclose(file);
 }
 
+namespace {
+
+/// This copies every repeated double field of `message` onto the end of the
+/// matching column in `columns` (indexed by field index), fixing the number of
+/// rows of each column on the first frame.
+void appendFrameToColumns(
+    const google::protobuf::Message& message,
+    std::vector<std::vector<float64_t>>& columns,
+    std::vector<int>& rows)
+{
+  const google::protobuf::Descriptor* descriptor = message.GetDescriptor();
+  const google::protobuf::Reflection* reflection = message.GetReflection();
+  const bool firstFrame = columns.size() == 0;
+  if (firstFrame)
+  {
+    columns.resize(descriptor->field_count());
+    rows.resize(descriptor->field_count(), 0);
+  }
+  for (int i = 0; i < descriptor->field_count(); i++)
+  {
+    const google::protobuf::FieldDescriptor* field = descriptor->field(i);
+    if (!field->is_repeated()
+        || field->cpp_type()
+               != google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE)
+    {
+      continue;
+    }
+    const int size = reflection->FieldSize(message, field);
+    if (firstFrame)
+    {
+      rows[i] = size;
+    }
+    else if (size != rows[i])
+    {
+      std::cout << "SubjectOnDisk::writeB3D() got a frame where column \""
+                << field->name() << "\" has " << size
+                << " values, but earlier frames had " << rows[i]
+                << ". Padding with NaNs or truncating to match." << std::endl;
+    }
+    for (int row = 0; row < rows[i]; row++)
+    {
+      columns[i].push_back(
+          row < size ? reflection->GetRepeatedDouble(message, field, row)
+                     : std::nan(""));
+    }
+  }
+}
+
+/// This records the location of each column in `columns` in the header proto,
+/// and moves the data onto the end of `columnData` to be written out later.
+void recordColumns(
+    proto::SubjectOnDiskHeader* headerProto,
+    const google::protobuf::Descriptor* descriptor,
+    int trial,
+    int pass,
+    std::vector<std::vector<float64_t>>& columns,
+    std::vector<int>& rows,
+    int64_t& offset,
+    std::vector<std::vector<float64_t>>& columnData)
+{
+  for (int i = 0; i < columns.size(); i++)
+  {
+    const google::protobuf::FieldDescriptor* field = descriptor->field(i);
+    if (rows[i] == 0)
+    {
+      continue;
+    }
+    proto::SubjectOnDiskColumn* column = headerProto->add_column();
+    column->set_trial(trial);
+    column->set_pass(pass);
+    column->set_name(field->name());
+    column->set_rows(rows[i]);
+    column->set_offset(offset);
+    offset += columns[i].size() * sizeof(float64_t);
+    columnData.push_back(std::move(columns[i]));
+  }
+}
+
+} // namespace
+
+/// This writes a columnar (version 5) B3D file, where each channel of each
+/// trial and pass is stored contiguously.
+void SubjectOnDisk::writeColumnarB3D(
+    const std::string& outputPath, std::shared_ptr<SubjectOnDiskHeader> header)
+{
+  // 0. Open the file
+  FILE* file = fopen(outputPath.c_str(), "wb");
+  if (file == nullptr)
+  {
+    std::cout
+        << "SubjectOnDiskBuilder::writeB3D() failed to open output file at "
+        << outputPath << ". Do you have permissions to write that file?"
+        << std::endl;
+    return;
+  }
+
+  // 1. Create the header proto
+  proto::SubjectOnDiskHeader headerProto;
+  header->write(&headerProto);
+  headerProto.set_version(5);
+  // There are no fixed size frames in a columnar file
+  headerProto.set_raw_sensor_frame_size(0);
+  headerProto.set_processing_pass_frame_size(0);
+
+  int maxNumForcePlates = 0;
+  for (int trial = 0; trial < header->mTrials.size(); trial++)
+  {
+    if (header->mTrials[trial]->mForcePlates.size() > maxNumForcePlates)
+    {
+      maxNumForcePlates = header->mTrials[trial]->mForcePlates.size();
+    }
+  }
+
+  // 2. Gather all the columns in memory, so that we know where each column
+  // will land before we write out the header
+  std::vector<std::vector<float64_t>> columnData;
+  int64_t offset = 0;
+  bool wroteAnyFrames = false;
+  for (int trial = 0; trial < header->mTrials.size(); trial++)
+  {
+    const int trialLength = header->mTrials[trial]->mMarkerObservations.size();
+    if (trialLength > 0)
+    {
+      wroteAnyFrames = true;
+    }
+
+    // 2.1. The raw sensor columns
+    std::vector<std::vector<float64_t>> sensorColumns;
+    std::vector<int> sensorRows;
+    for (int t = 0; t < trialLength; t++)
+    {
+      proto::SubjectOnDiskSensorFrame sensorsFrameProto;
+      header->writeSensorsFrame(
+          &sensorsFrameProto, trial, t, maxNumForcePlates);
+      appendFrameToColumns(sensorsFrameProto, sensorColumns, sensorRows);
+    }
+    recordColumns(
+        &headerProto,
+        proto::SubjectOnDiskSensorFrame::descriptor(),
+        trial,
+        -1,
+        sensorColumns,
+        sensorRows,
+        offset,
+        columnData);
+
+    // 2.2. The processing pass columns
+    for (int pass = 0; pass < header->mTrials[trial]->mTrialPasses.size();
+         pass++)
+    {
+      std::vector<std::vector<float64_t>> passColumns;
+      std::vector<int> passRows;
+      for (int t = 0; t < trialLength; t++)
+      {
+        proto::SubjectOnDiskProcessingPassFrame passFrameProto;
+        header->writeProcessingPassFrame(&passFrameProto, trial, t, pass);
+        appendFrameToColumns(passFrameProto, passColumns, passRows);
+      }
+      recordColumns(
+          &headerProto,
+          proto::SubjectOnDiskProcessingPassFrame::descriptor(),
+          trial,
+          pass,
+          passColumns,
+          passRows,
+          offset,
+          columnData);
+    }
+  }
+
+  if (!wroteAnyFrames)
+  {
+    std::cout << "SubjectOnDiskBuilder::writeB3D() failed to write any frames "
+                 "of data."
+              << std::endl;
+    fclose(file);
+    return;
+  }
+
+  if (!headerProto.IsInitialized())
+  {
+    std::cerr << "All required fields are not set:\n"
+              << headerProto.InitializationErrorString() << std::endl;
+    fclose(file);
+    return;
+  }
+
+  // 3. Serialize and write the header
+  std::string headerSerialized = "";
+  bool success = headerProto.SerializeToString(&headerSerialized);
+  if (!success)
+  {
+    std::cerr << "Failed to serialize the protobuf message." << std::endl;
+    fclose(file);
+    return;
+  }
+  int64_t headerSize = headerSerialized.size();
+  fwrite(&headerSize, sizeof(int64_t), 1, file);
+  fwrite(headerSerialized.c_str(), sizeof(char), headerSize, file);
+
+  // 4. Write out the columns, in the same order we recorded their offsets
+  for (std::vector<float64_t>& column : columnData)
+  {
+    fwrite(column.data(), sizeof(float64_t), column.size(), file);
+  }
+
+  fclose(file);
+}
+
 /// This loads all the frames of data, and fills in the processing pass data
 /// matrices in the proto header classes.
 void SubjectOnDisk::loadAllFrames(bool doNotStandardizeForcePlateData)
@@ -718,6 +994,41 @@ bool SubjectOnDisk::hasLoadedAllFrames()
   return mLoadedAllFrames;
 }
 
+bool SubjectOnDisk::setUseMemoryMap(bool useMemoryMap)
+{
+  if (!useMemoryMap)
+  {
+    mMappedFile = nullptr;
+    return false;
+  }
+  if (mMappedFile)
+  {
+    return true;
+  }
+  if (mPath == "")
+  {
+    std::cout << "SubjectOnDisk::setUseMemoryMap() called on a subject that "
+                 "was not loaded from a file, ignoring."
+              << std::endl;
+    return false;
+  }
+  std::shared_ptr<common::MemoryMappedFile> mappedFile
+      = std::make_shared<common::MemoryMappedFile>(mPath);
+  if (!mappedFile->isGood())
+  {
+    std::cout << "SubjectOnDisk::setUseMemoryMap() failed to map " << mPath
+              << ", falling back to buffered reads." << std::endl;
+    return false;
+  }
+  mMappedFile = mappedFile;
+  return true;
+}
+
+bool SubjectOnDisk::getUseMemoryMap()
+{
+  return mMappedFile != nullptr;
+}
+
 /// This returns the raw proto header for this subject, which can be used to
 /// write out a new B3D file
 std::shared_ptr<SubjectOnDiskHeader> SubjectOnDisk::getHeaderProto()
@@ -946,30 +1257,15 @@ std::vector<std::shared_ptr<Frame>> SubjectOnDisk::readFrames(
     int stride,
     s_t contactThreshold)
 {
-  (void)trial;
-  (void)startFrame;
-  (void)stride;
-  (void)numFramesToRead;
-  (void)includeSensorData;
-  (void)includeProcessingPasses;
-
   std::vector<std::shared_ptr<Frame>> result;
 
-  // 1. Open the file
-  FILE* file = fopen(mPath.c_str(), "r");
-
-  long linearFrameStart = 0;
-  for (int i = 0; i < trial; i++)
+  if (trial < 0 || trial >= (int)mTrialDataOffsets.size())
   {
-    const int pastTrialNumPasses = getTrialNumProcessingPasses(i);
-    const int pastTrialFrameSize
-        = (mSensorFrameSize + (pastTrialNumPasses * mProcessingPassFrameSize));
-    linearFrameStart += getTrialLength(i) * pastTrialFrameSize;
+    std::cout << "SubjectOnDisk::readFrames() passed an out of bounds trial "
+              << trial << ", only have " << mTrialDataOffsets.size()
+              << " trials." << std::endl;
+    return result;
   }
-  const int numPasses = getTrialNumProcessingPasses(trial);
-  const long frameSize
-      = (mSensorFrameSize + (numPasses * mProcessingPassFrameSize));
-  linearFrameStart += startFrame * frameSize;
 
   int remainingFrames = getTrialLength(trial) - startFrame;
   if (remainingFrames < numFramesToRead * stride)
@@ -980,28 +1276,68 @@ std::vector<std::shared_ptr<Frame>> SubjectOnDisk::readFrames(
   if (numFramesToRead <= 0)
   {
     // return an empty result
-    fclose(file);
     return result;
   }
 
+  // 1. Open the file, unless we're reading straight out of a memory map
+  FILE* file = nullptr;
+  if (!mMappedFile)
+  {
+    file = fopen(mPath.c_str(), "r");
+    if (file == nullptr)
+    {
+      std::cout << "SubjectOnDisk::readFrames() failed to open file " << mPath
+                << std::endl;
+      return result;
+    }
+  }
+
+  if (mColumnar)
+  {
+    result = readColumnarFrames(
+        file,
+        trial,
+        startFrame,
+        numFramesToRead,
+        includeSensorData,
+        includeProcessingPasses,
+        stride,
+        contactThreshold);
+    if (file != nullptr)
+    {
+      fclose(file);
+    }
+    return result;
+  }
+
+  long linearFrameStart = mTrialDataOffsets[trial];
+  const int numPasses = getTrialNumProcessingPasses(trial);
+  const long frameSize
+      = (mSensorFrameSize + (numPasses * mProcessingPassFrameSize));
+  linearFrameStart += startFrame * frameSize;
+
+  // These buffers are only used when we're not memory mapped, and are reused
+  // across all the frames in this read.
+  std::vector<char> serializedFrame;
+  std::vector<char> serializedPassFrame;
+  // Reuse the proto objects across frames, so that their internal repeated
+  // fields keep their capacity rather than getting reallocated on every parse
+  proto::SubjectOnDiskSensorFrame sensorProto;
+  proto::SubjectOnDiskProcessingPassFrame passProto;
+
   for (int i = 0; i < numFramesToRead; i++)
   {
-    // 2. Seek to the right place in the file to read this frame
+    // 2. Find the right place in the file to read this frame
     long offsetBytes
         = mDataSectionStart + (linearFrameStart + (i * stride * frameSize));
 
     std::shared_ptr<Frame> frame = std::make_shared<Frame>();
     if (includeSensorData)
     {
-      fseek(file, offsetBytes, SEEK_SET);
-
-      // 3. Allocate a buffer to hold the serialized data
-      std::vector<char> serializedFrame(mSensorFrameSize);
-
-      // 4. Read the serialized data from the file
-      int64_t bytesRead
-          = fread(serializedFrame.data(), sizeof(char), mSensorFrameSize, file);
-      if (bytesRead != mSensorFrameSize)
+      // 3. Read the serialized data from the file (or the memory map)
+      const char* sensorFrameData
+          = readBytes(file, offsetBytes, mSensorFrameSize, serializedFrame);
+      if (sensorFrameData == nullptr)
       {
         std::cout
             << "SubjectOnDisk attempting to read a corrupted binary file at "
@@ -1009,15 +1345,16 @@ std::vector<std::shared_ptr<Frame>> SubjectOnDisk::readFrames(
             << mSensorFrameSize << " at offset " << (offsetBytes)
             << ", corresponding to sensor data frame for trial " << trial
             << " and frame " << startFrame + (i * stride) << " (" << i * stride
-            << " into a " << numFramesToRead
-            << " frame read), instead only got " << bytesRead << " bytes."
-            << std::endl;
+            << " into a " << numFramesToRead << " frame read)." << std::endl;
+        if (file != nullptr)
+        {
+          fclose(file);
+        }
         throw new std::exception();
       }
-      // 5. Deserialize the data into a protobuf object
-      proto::SubjectOnDiskSensorFrame proto;
-      bool parseSuccess = proto.ParseFromArray(
-          serializedFrame.data(), serializedFrame.size());
+      // 4. Deserialize the data into a protobuf object
+      bool parseSuccess
+          = sensorProto.ParseFromArray(sensorFrameData, mSensorFrameSize);
       if (!parseSuccess)
       {
         std::cout
@@ -1026,64 +1363,66 @@ std::vector<std::shared_ptr<Frame>> SubjectOnDisk::readFrames(
             << ", corresponding to sensor data frame for trial " << trial
             << " and frame " << startFrame + (i * stride) << " (" << i * stride
             << " into a " << numFramesToRead << " frame read)." << std::endl;
+        if (file != nullptr)
+        {
+          fclose(file);
+        }
         throw new std::exception();
       }
 
-      // 6. Copy the results out into a frame
+      // 5. Copy the results out into a frame
       frame->readSensorsFromProto(
-          &proto, *mHeader.get(), trial, startFrame + (i * stride));
+          &sensorProto, *mHeader.get(), trial, startFrame + (i * stride));
     }
     if (includeProcessingPasses)
     {
-      fseek(file, offsetBytes + mSensorFrameSize, SEEK_SET);
-
-      // 3. Allocate a buffer to hold the serialized data
-      std::vector<char> serializedPassFrame(mProcessingPassFrameSize);
-
-      for (int pass = 0; pass < getTrialNumProcessingPasses(trial); pass++)
+      for (int pass = 0; pass < numPasses; pass++)
       {
-        int64_t bytesRead = fread(
-            serializedPassFrame.data(),
-            sizeof(char),
-            mProcessingPassFrameSize,
-            file);
-        if (bytesRead != mProcessingPassFrameSize)
+        // 3. Read the serialized data from the file (or the memory map)
+        const long passOffsetBytes = offsetBytes + mSensorFrameSize
+                                     + (pass * mProcessingPassFrameSize);
+        const char* passFrameData = readBytes(
+            file, passOffsetBytes, mProcessingPassFrameSize, serializedPassFrame);
+        if (passFrameData == nullptr)
         {
           std::cout
               << "SubjectOnDisk attempting to read a corrupted binary file at "
               << mPath << ": was unable to read full requested frame size "
-              << mProcessingPassFrameSize << " at offset "
-              << (offsetBytes + mSensorFrameSize
-                  + (i * stride * mProcessingPassFrameSize))
+              << mProcessingPassFrameSize << " at offset " << passOffsetBytes
               << ", corresponding to trial " << trial
               << " and processing pass frame " << startFrame + (i * stride)
               << " (" << i * stride << " into a " << numFramesToRead
-              << " frame read), processing pass " << pass
-              << ", instead only got " << bytesRead << " bytes." << std::endl;
+              << " frame read), processing pass " << pass << "." << std::endl;
+          if (file != nullptr)
+          {
+            fclose(file);
+          }
           throw new std::exception();
         }
-        // 5. Deserialize the data into a protobuf object
-        proto::SubjectOnDiskProcessingPassFrame proto;
-        bool parseSuccess = proto.ParseFromArray(
-            serializedPassFrame.data(), serializedPassFrame.size());
+        // 4. Deserialize the data into a protobuf object
+        bool parseSuccess = passProto.ParseFromArray(
+            passFrameData, mProcessingPassFrameSize);
         if (!parseSuccess)
         {
           std::cout
               << "SubjectOnDisk attempting to read a corrupted binary file at "
               << mPath
               << ": got an error parsing processing pass frame at offset "
-              << (offsetBytes + i * stride * mSensorFrameSize)
-              << ", corresponding to trial " << trial << " and frame "
-              << startFrame + (i * stride) << " (" << i * stride << " into a "
-              << numFramesToRead << " frame read), processing pass " << pass
-              << "." << std::endl;
+              << passOffsetBytes << ", corresponding to trial " << trial
+              << " and frame " << startFrame + (i * stride) << " ("
+              << i * stride << " into a " << numFramesToRead
+              << " frame read), processing pass " << pass << "." << std::endl;
+          if (file != nullptr)
+          {
+            fclose(file);
+          }
           throw new std::exception();
         }
 
-        // 6. Copy the results out into a frame
+        // 5. Copy the results out into a frame
         frame->processingPasses.push_back(std::make_shared<FramePass>());
         frame->processingPasses[pass]->readFromProto(
-            &proto,
+            &passProto,
             *mHeader.get(),
             trial,
             startFrame + (i * stride),
@@ -1091,16 +1430,399 @@ std::vector<std::shared_ptr<Frame>> SubjectOnDisk::readFrames(
             contactThreshold);
       }
     }
-    // TODO: read the processing passes separately
 
     result.push_back(frame);
   }
 
-  fclose(file);
+  if (file != nullptr)
+  {
+    fclose(file);
+  }
 
   return result;
 }
 
+/// This reads the same Frame objects as readFrames(), but out of a columnar
+/// (version 5+) file. We read each column's window of frames with a single
+/// contiguous read, and then reassemble the frame protos so that we can reuse
+/// the exact same conversion code as row-oriented files.
+std::vector<std::shared_ptr<Frame>> SubjectOnDisk::readColumnarFrames(
+    FILE* file,
+    int trial,
+    int startFrame,
+    int numFramesToRead,
+    bool includeSensorData,
+    bool includeProcessingPasses,
+    int stride,
+    s_t contactThreshold)
+{
+  std::vector<std::shared_ptr<Frame>> result;
+  for (int i = 0; i < numFramesToRead; i++)
+  {
+    result.push_back(std::make_shared<Frame>());
+  }
+  std::vector<char> buffer;
+
+  if (includeSensorData)
+  {
+    std::vector<std::pair<const google::protobuf::FieldDescriptor*, Eigen::MatrixXs>>
+        windows = readColumnWindows(
+            file,
+            mSensorColumns[trial],
+            proto::SubjectOnDiskSensorFrame::descriptor(),
+            startFrame,
+            numFramesToRead,
+            stride,
+            buffer);
+    proto::SubjectOnDiskSensorFrame sensorProto;
+    const google::protobuf::Reflection* reflection
+        = sensorProto.GetReflection();
+    for (int i = 0; i < numFramesToRead; i++)
+    {
+      sensorProto.Clear();
+      for (auto& window : windows)
+      {
+        for (int row = 0; row < window.second.rows(); row++)
+        {
+          reflection->AddDouble(
+              &sensorProto, window.first, window.second(row, i));
+        }
+      }
+      result[i]->readSensorsFromProto(
+          &sensorProto, *mHeader.get(), trial, startFrame + (i * stride));
+    }
+  }
+
+  if (includeProcessingPasses)
+  {
+    proto::SubjectOnDiskProcessingPassFrame passProto;
+    const google::protobuf::Reflection* reflection = passProto.GetReflection();
+    for (int pass = 0; pass < getTrialNumProcessingPasses(trial); pass++)
+    {
+      std::vector<
+          std::pair<const google::protobuf::FieldDescriptor*, Eigen::MatrixXs>>
+          windows = readColumnWindows(
+              file,
+              mPassColumns[trial][pass],
+              proto::SubjectOnDiskProcessingPassFrame::descriptor(),
+              startFrame,
+              numFramesToRead,
+              stride,
+              buffer);
+      for (int i = 0; i < numFramesToRead; i++)
+      {
+        passProto.Clear();
+        for (auto& window : windows)
+        {
+          for (int row = 0; row < window.second.rows(); row++)
+          {
+            reflection->AddDouble(
+                &passProto, window.first, window.second(row, i));
+          }
+        }
+        result[i]->processingPasses.push_back(std::make_shared<FramePass>());
+        result[i]->processingPasses[pass]->readFromProto(
+            &passProto,
+            *mHeader.get(),
+            trial,
+            startFrame + (i * stride),
+            pass,
+            contactThreshold);
+      }
+    }
+  }
+
+  return result;
+}
+
+/// This reads the requested window of frames out of every column in `columns`
+/// that corresponds to a field on the `descriptor` message. Columns we don't
+/// recognize (for example, ones written by a newer version of the format) are
+/// skipped.
+std::vector<std::pair<const google::protobuf::FieldDescriptor*, Eigen::MatrixXs>>
+SubjectOnDisk::readColumnWindows(
+    FILE* file,
+    const std::map<std::string, ColumnLocation>& columns,
+    const google::protobuf::Descriptor* descriptor,
+    int startFrame,
+    int numFramesToRead,
+    int stride,
+    std::vector<char>& buffer)
+{
+  std::vector<std::pair<const google::protobuf::FieldDescriptor*, Eigen::MatrixXs>>
+      windows;
+  for (auto& pair : columns)
+  {
+    const google::protobuf::FieldDescriptor* field
+        = descriptor->FindFieldByName(pair.first);
+    if (field == nullptr || !field->is_repeated()
+        || field->cpp_type()
+               != google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE)
+    {
+      continue;
+    }
+    windows.emplace_back(
+        field,
+        readColumnWindow(
+            file, pair.second, startFrame, numFramesToRead, stride, buffer));
+  }
+  return windows;
+}
+
+/// This reads a window of `numFramesToRead` frames, spaced `stride` apart,
+/// out of a single column, with one contiguous read.
+Eigen::MatrixXs SubjectOnDisk::readColumnWindow(
+    FILE* file,
+    const ColumnLocation& column,
+    int startFrame,
+    int numFramesToRead,
+    int stride,
+    std::vector<char>& buffer)
+{
+  Eigen::MatrixXs result = Eigen::MatrixXs::Zero(column.rows, numFramesToRead);
+  if (column.rows == 0 || numFramesToRead <= 0)
+  {
+    return result;
+  }
+  const long frameBytes = column.rows * sizeof(float64_t);
+  const long windowFrames = ((numFramesToRead - 1) * stride) + 1;
+  const long offsetBytes
+      = mDataSectionStart + column.offset + (startFrame * frameBytes);
+  const char* data
+      = readBytes(file, offsetBytes, windowFrames * frameBytes, buffer);
+  if (data == nullptr)
+  {
+    std::cout << "SubjectOnDisk attempting to read a corrupted binary file at "
+              << mPath << ": was unable to read "
+              << windowFrames * frameBytes << " bytes of column data at offset "
+              << offsetBytes << "." << std::endl;
+    if (file != nullptr)
+    {
+      fclose(file);
+    }
+    throw new std::exception();
+  }
+  static_assert(
+      sizeof(s_t) == sizeof(float64_t),
+      "Columnar B3D reads assume s_t is a 64 bit float");
+  if (stride == 1)
+  {
+    std::memcpy(result.data(), data, numFramesToRead * frameBytes);
+  }
+  else
+  {
+    for (int i = 0; i < numFramesToRead; i++)
+    {
+      std::memcpy(
+          result.col(i).data(), data + (i * stride * frameBytes), frameBytes);
+    }
+  }
+  return result;
+}
+
+/// This reads `size` bytes at `offset` in the file. If we're memory mapped,
+/// this just returns a pointer into the mapped pages. Otherwise, it reads into
+/// `buffer` (growing it if necessary) and returns a pointer to that. Returns
+/// nullptr if we're unable to read the full range.
+const char* SubjectOnDisk::readBytes(
+    FILE* file, long offset, long size, std::vector<char>& buffer)
+{
+  if (mMappedFile)
+  {
+    return mMappedFile->getRange(offset, size);
+  }
+  if (buffer.size() < size)
+  {
+    buffer.resize(size);
+  }
+  if (fseek(file, offset, SEEK_SET) != 0)
+  {
+    return nullptr;
+  }
+  int64_t bytesRead = fread(buffer.data(), sizeof(char), size, file);
+  if (bytesRead != size)
+  {
+    return nullptr;
+  }
+  return buffer.data();
+}
+
+/// This reads a window of a single processing pass channel (for example
+/// "pos" or "tau") for a trial, as a matrix with one column per frame.
+Eigen::MatrixXs SubjectOnDisk::readProcessingPassColumn(
+    int trial,
+    int processingPass,
+    const std::string& columnName,
+    int startFrame,
+    int numFramesToRead,
+    int stride)
+{
+  if (trial < 0 || trial >= getNumTrials() || processingPass < 0
+      || processingPass >= getTrialNumProcessingPasses(trial))
+  {
+    std::cout << "SubjectOnDisk::readProcessingPassColumn() passed an out of "
+                 "bounds trial "
+              << trial << " or processing pass " << processingPass
+              << ", returning an empty matrix." << std::endl;
+    return Eigen::MatrixXs::Zero(0, 0);
+  }
+  return readColumn(
+      trial,
+      processingPass,
+      columnName,
+      startFrame,
+      numFramesToRead,
+      stride);
+}
+
+/// This reads a window of a single raw sensor channel (for example
+/// "marker_obs") for a trial, as a matrix with one column per frame.
+Eigen::MatrixXs SubjectOnDisk::readSensorColumn(
+    int trial,
+    const std::string& columnName,
+    int startFrame,
+    int numFramesToRead,
+    int stride)
+{
+  if (trial < 0 || trial >= getNumTrials())
+  {
+    std::cout << "SubjectOnDisk::readSensorColumn() passed an out of bounds "
+                 "trial "
+              << trial << ", returning an empty matrix." << std::endl;
+    return Eigen::MatrixXs::Zero(0, 0);
+  }
+  return readColumn(
+      trial, -1, columnName, startFrame, numFramesToRead, stride);
+}
+
+/// This is the shared implementation of readProcessingPassColumn() and
+/// readSensorColumn(), where `processingPass` is -1 for sensor data. On
+/// columnar files this is a single contiguous read, and on older row-oriented
+/// files we fall back to parsing each frame and picking out the field.
+Eigen::MatrixXs SubjectOnDisk::readColumn(
+    int trial,
+    int processingPass,
+    const std::string& columnName,
+    int startFrame,
+    int numFramesToRead,
+    int stride)
+{
+  const google::protobuf::Descriptor* descriptor
+      = processingPass == -1
+            ? proto::SubjectOnDiskSensorFrame::descriptor()
+            : proto::SubjectOnDiskProcessingPassFrame::descriptor();
+  const google::protobuf::FieldDescriptor* field
+      = descriptor->FindFieldByName(columnName);
+  if (field == nullptr || !field->is_repeated()
+      || field->cpp_type() != google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE)
+  {
+    std::cout << "SubjectOnDisk::readColumn() passed an unrecognized column \""
+              << columnName << "\" for " << descriptor->name()
+              << ", returning an empty matrix." << std::endl;
+    return Eigen::MatrixXs::Zero(0, 0);
+  }
+
+  int remainingFrames = getTrialLength(trial) - startFrame;
+  if (remainingFrames < numFramesToRead * stride)
+  {
+    numFramesToRead = (int)floor((s_t)remainingFrames / stride);
+  }
+  if (numFramesToRead <= 0 || startFrame < 0)
+  {
+    return Eigen::MatrixXs::Zero(0, 0);
+  }
+
+  FILE* file = nullptr;
+  if (!mMappedFile)
+  {
+    file = fopen(mPath.c_str(), "r");
+    if (file == nullptr)
+    {
+      std::cout << "SubjectOnDisk::readColumn() failed to open file " << mPath
+                << std::endl;
+      return Eigen::MatrixXs::Zero(0, 0);
+    }
+  }
+
+  Eigen::MatrixXs result = Eigen::MatrixXs::Zero(0, 0);
+  std::vector<char> buffer;
+  if (mColumnar)
+  {
+    const std::map<std::string, ColumnLocation>& columns
+        = processingPass == -1 ? mSensorColumns[trial]
+                               : mPassColumns[trial][processingPass];
+    auto column = columns.find(columnName);
+    if (column != columns.end())
+    {
+      result = readColumnWindow(
+          file, column->second, startFrame, numFramesToRead, stride, buffer);
+    }
+  }
+  else
+  {
+    const int numPasses = getTrialNumProcessingPasses(trial);
+    const long frameSize
+        = (mSensorFrameSize + (numPasses * mProcessingPassFrameSize));
+    assert(trial >= 0 && trial < (int)mTrialDataOffsets.size());
+    const long linearFrameStart
+        = mTrialDataOffsets[trial] + (startFrame * frameSize);
+    const long sizeBytes = processingPass == -1 ? mSensorFrameSize
+                                                : mProcessingPassFrameSize;
+    std::unique_ptr<google::protobuf::Message> message(
+        processingPass == -1 ? static_cast<google::protobuf::Message*>(
+            new proto::SubjectOnDiskSensorFrame())
+                             : static_cast<google::protobuf::Message*>(
+                                 new proto::SubjectOnDiskProcessingPassFrame()));
+    const google::protobuf::Reflection* reflection = message->GetReflection();
+    for (int i = 0; i < numFramesToRead; i++)
+    {
+      long offsetBytes
+          = mDataSectionStart + linearFrameStart + (i * stride * frameSize);
+      if (processingPass != -1)
+      {
+        offsetBytes
+            += mSensorFrameSize + (processingPass * mProcessingPassFrameSize);
+      }
+      const char* data = readBytes(file, offsetBytes, sizeBytes, buffer);
+      if (data == nullptr || !message->ParseFromArray(data, sizeBytes))
+      {
+        std::cout
+            << "SubjectOnDisk attempting to read a corrupted binary file at "
+            << mPath << ": got an error reading frame at offset "
+            << offsetBytes << " for column \"" << columnName << "\"."
+            << std::endl;
+        if (file != nullptr)
+        {
+          fclose(file);
+        }
+        throw new std::exception();
+      }
+      const int rows = reflection->FieldSize(*message, field);
+      if (i == 0)
+      {
+        result = Eigen::MatrixXs::Zero(rows, numFramesToRead);
+      }
+      for (int row = 0; row < rows && row < result.rows(); row++)
+      {
+        result(row, i) = reflection->GetRepeatedDouble(*message, field, row);
+      }
+    }
+  }
+
+  if (file != nullptr)
+  {
+    fclose(file);
+  }
+  return result;
+}
+
+/// This returns true if this subject was loaded from a columnar (version 5+)
+/// B3D file
+bool SubjectOnDisk::isColumnar()
+{
+  return mColumnar;
+}
+
 void Frame::readSensorsFromProto(
     dart::proto::SubjectOnDiskSensorFrame* proto,
     const SubjectOnDiskHeader& header,
@@ -3993,7 +4715,7 @@ void SubjectOnDiskHeader::write(dart::proto::SubjectOnDiskHeader* header)
 
 void SubjectOnDiskHeader::read(const dart::proto::SubjectOnDiskHeader& proto)
 {
-  if (proto.version() > 4)
+  if (proto.version() > 5)
   {
     throw std::runtime_error(
         "SubjectOnDiskHeader::read() can't read file version "
@@ -1,8 +1,11 @@
 #ifndef BIOMECH_SUBJECT_ON_DISK
 #define BIOMECH_SUBJECT_ON_DISK
 
+#include <cstdio>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -10,6 +13,7 @@
 #include "dart/biomechanics/ForcePlate.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/biomechanics/enums.hpp"
+#include "dart/common/MemoryMappedFile.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/MathTypes.hpp"
 #include "dart/proto/SubjectOnDisk.pb.h"
@@ -550,9 +554,16 @@ public:
 
   SubjectOnDisk(std::shared_ptr<SubjectOnDiskHeader> header);
 
-  /// This will write a B3D file to disk
+  /// This will write a B3D file to disk. If `columnar` is true, this writes a
+  /// version 5 file, where each channel of each trial and processing pass is
+  /// stored as a contiguous column, so readProcessingPassColumn() and
+  /// readSensorColumn() can pull a window of a single channel with one
+  /// contiguous read. Otherwise this writes the row-oriented format, where
+  /// each frame is a separate serialized proto.
   static void writeB3D(
-      const std::string& path, std::shared_ptr<SubjectOnDiskHeader> header);
+      const std::string& path,
+      std::shared_ptr<SubjectOnDiskHeader> header,
+      bool columnar = false);
 
   /// This loads all the frames of data, and fills in the processing pass data
   /// matrices in the proto header classes.
@@ -560,6 +571,20 @@ public:
 
   bool hasLoadedAllFrames();
 
+  /// This opts in to (or out of) reading frames from a read-only memory map of
+  /// the B3D file. When enabled, the file is mapped once, and readFrames()
+  /// parses frames straight out of the mapped pages, without opening the file
+  /// or allocating a copy buffer on every call. This is intended for training
+  /// data loaders that call readFrames() many times on the same subject.
+  ///
+  /// Returns true if memory mapped reads are now active. If the file can't be
+  /// mapped, this prints a warning, returns false, and readFrames() keeps
+  /// using regular buffered reads.
+  bool setUseMemoryMap(bool useMemoryMap);
+
+  /// This returns true if readFrames() is reading out of a memory map.
+  bool getUseMemoryMap();
+
   /// This returns the raw proto header for this subject, which can be used to
   /// write out a new B3D file
   std::shared_ptr<SubjectOnDiskHeader> getHeaderProto();
@@ -613,6 +638,41 @@ public:
       int stride = 1,
       s_t contactThreshold = 1.0);
 
+  /// This reads a window of a single processing pass channel for a trial, as
+  /// a matrix with one column per frame. The `columnName` is the name of the
+  /// field on `SubjectOnDiskProcessingPassFrame` in SubjectOnDisk.proto, like
+  /// "pos", "vel", "acc", "tau" or "ground_contact_wrench".
+  ///
+  /// On columnar files this is a single contiguous read that doesn't decode
+  /// any other channel. On row-oriented files this falls back to parsing each
+  /// frame. On OOB access or an unknown column, prints an error and returns an
+  /// empty matrix.
+  Eigen::MatrixXs readProcessingPassColumn(
+      int trial,
+      int processingPass,
+      const std::string& columnName,
+      int startFrame,
+      int numFramesToRead = 1,
+      int stride = 1);
+
+  /// This reads a window of a single raw sensor channel for a trial, as a
+  /// matrix with one column per frame. The `columnName` is the name of the
+  /// field on `SubjectOnDiskSensorFrame` in SubjectOnDisk.proto, like
+  /// "marker_obs", "acc_obs" or "raw_force_plate_force".
+  ///
+  /// On OOB access or an unknown column, prints an error and returns an empty
+  /// matrix.
+  Eigen::MatrixXs readSensorColumn(
+      int trial,
+      const std::string& columnName,
+      int startFrame,
+      int numFramesToRead = 1,
+      int stride = 1);
+
+  /// This returns true if this subject was loaded from a columnar (version 5+)
+  /// B3D file
+  bool isColumnar();
+
   /// This returns the number of trials on the subject
   int getNumTrials();
 
@@ -708,13 +768,81 @@ public:
   std::string getNotes();
 
 protected:
+  // This is where a single column lives in a columnar (version 5+) file
+  struct ColumnLocation
+  {
+    // How many values are stored per frame
+    int rows;
+    // The byte offset of the first frame, relative to mDataSectionStart
+    long offset;
+  };
+
+  static void writeColumnarB3D(
+      const std::string& path, std::shared_ptr<SubjectOnDiskHeader> header);
+
+  std::vector<std::shared_ptr<Frame>> readColumnarFrames(
+      FILE* file,
+      int trial,
+      int startFrame,
+      int numFramesToRead,
+      bool includeSensorData,
+      bool includeProcessingPasses,
+      int stride,
+      s_t contactThreshold);
+
+  std::vector<
+      std::pair<const google::protobuf::FieldDescriptor*, Eigen::MatrixXs>>
+  readColumnWindows(
+      FILE* file,
+      const std::map<std::string, ColumnLocation>& columns,
+      const google::protobuf::Descriptor* descriptor,
+      int startFrame,
+      int numFramesToRead,
+      int stride,
+      std::vector<char>& buffer);
+
+  Eigen::MatrixXs readColumnWindow(
+      FILE* file,
+      const ColumnLocation& column,
+      int startFrame,
+      int numFramesToRead,
+      int stride,
+      std::vector<char>& buffer);
+
+  Eigen::MatrixXs readColumn(
+      int trial,
+      int processingPass,
+      const std::string& columnName,
+      int startFrame,
+      int numFramesToRead,
+      int stride);
+
+  const char* readBytes(
+      FILE* file, long offset, long size, std::vector<char>& buffer);
+
+  /// This fills in mTrialDataOffsets from the header and the frame sizes
+  void computeTrialDataOffsets();
+
   std::string mPath;
   // We cache some very basic data about the accessible bounds of on-disk data,
   // so we don't have to look that up every time.
   long mDataSectionStart;
   long mSensorFrameSize;
   long mProcessingPassFrameSize;
+  // This is the offset (relative to mDataSectionStart) of the first frame of
+  // each trial, so that we don't have to sum over previous trials on every
+  // readFrames() call
+  std::vector<long> mTrialDataOffsets;
   bool mLoadedAllFrames;
+  // If memory mapped reads are enabled, this is the read-only map of the whole
+  // file. It's a shared_ptr so that copies of this object share one mapping.
+  std::shared_ptr<common::MemoryMappedFile> mMappedFile;
+  // If this is a columnar (version 5+) file, these are the locations of the
+  // sensor columns for each trial, and the pass columns for each trial and
+  // pass, keyed by the name of the frame proto field they store.
+  bool mColumnar;
+  std::vector<std::map<std::string, ColumnLocation>> mSensorColumns;
+  std::vector<std::vector<std::map<std::string, ColumnLocation>>> mPassColumns;
 
   std::shared_ptr<SubjectOnDiskHeader> mHeader;
 };
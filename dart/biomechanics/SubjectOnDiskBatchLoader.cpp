@@ -0,0 +1,290 @@
+#include "dart/biomechanics/SubjectOnDiskBatchLoader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace dart {
+namespace biomechanics {
+
+SubjectOnDiskBatchLoader::SubjectOnDiskBatchLoader(
+    std::vector<std::shared_ptr<SubjectOnDisk>> subjects,
+    std::vector<SubjectOnDiskSample> samplingPlan,
+    int batchSize,
+    int windowSize,
+    int stride,
+    int processingPass,
+    std::vector<std::string> passColumns,
+    std::vector<std::string> sensorColumns,
+    int numThreads,
+    int maxReadyBatches)
+  : mSubjects(subjects),
+    mSamplingPlan(samplingPlan),
+    mBatchSize(std::max(1, batchSize)),
+    mWindowSize(std::max(1, windowSize)),
+    mStride(std::max(1, stride)),
+    mProcessingPass(processingPass),
+    mPassColumns(passColumns),
+    mSensorColumns(sensorColumns),
+    mNumThreads(std::max(1, numThreads)),
+    mMaxReadyBatches(std::max(1, maxReadyBatches)),
+    mNextBatchToDecode(0),
+    mNextBatchToReturn(0),
+    mRunning(false)
+{
+  // Probe the channel dimensions from the first valid sample, so that every
+  // batch has the same shape
+  mPassColumnDims.resize(mPassColumns.size(), 0);
+  mSensorColumnDims.resize(mSensorColumns.size(), 0);
+  for (const SubjectOnDiskSample& sample : mSamplingPlan)
+  {
+    if (sample.subject < 0 || sample.subject >= mSubjects.size())
+    {
+      continue;
+    }
+    std::shared_ptr<SubjectOnDisk> subject = mSubjects[sample.subject];
+    for (int i = 0; i < mPassColumns.size(); i++)
+    {
+      mPassColumnDims[i]
+          = subject
+                ->readProcessingPassColumn(
+                    sample.trial, mProcessingPass, mPassColumns[i], 0, 1)
+                .rows();
+    }
+    for (int i = 0; i < mSensorColumns.size(); i++)
+    {
+      mSensorColumnDims[i]
+          = subject->readSensorColumn(sample.trial, mSensorColumns[i], 0, 1)
+                .rows();
+    }
+    break;
+  }
+}
+
+SubjectOnDiskBatchLoader::~SubjectOnDiskBatchLoader()
+{
+  stop();
+}
+
+void SubjectOnDiskBatchLoader::start()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (mRunning)
+  {
+    return;
+  }
+  mRunning = true;
+  // If we were stopped part way through, re-decode anything we threw away
+  mNextBatchToDecode = mNextBatchToReturn;
+  for (int i = 0; i < mNumThreads; i++)
+  {
+    mWorkers.emplace_back(&SubjectOnDiskBatchLoader::workerLoop, this);
+  }
+}
+
+std::shared_ptr<SubjectOnDiskBatch> SubjectOnDiskBatchLoader::nextBatch()
+{
+  start();
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (mNextBatchToReturn >= getNumBatches())
+  {
+    return nullptr;
+  }
+  const int batchIndex = mNextBatchToReturn;
+  mBatchReady.wait(lock, [&] {
+    return !mRunning || mReadyBatches.count(batchIndex) > 0
+           || mFailedBatches.count(batchIndex) > 0;
+  });
+  auto failed = mFailedBatches.find(batchIndex);
+  if (failed != mFailedBatches.end())
+  {
+    std::exception_ptr error = failed->second;
+    mFailedBatches.erase(failed);
+    mNextBatchToReturn++;
+    lock.unlock();
+    mSpaceAvailable.notify_all();
+    std::rethrow_exception(error);
+  }
+  auto it = mReadyBatches.find(batchIndex);
+  if (it == mReadyBatches.end())
+  {
+    // We were stopped while waiting
+    return nullptr;
+  }
+  std::shared_ptr<SubjectOnDiskBatch> batch = it->second;
+  mReadyBatches.erase(it);
+  mNextBatchToReturn++;
+  lock.unlock();
+  mSpaceAvailable.notify_all();
+  return batch;
+}
+
+void SubjectOnDiskBatchLoader::stop()
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!mRunning)
+    {
+      return;
+    }
+    mRunning = false;
+  }
+  mSpaceAvailable.notify_all();
+  mBatchReady.notify_all();
+  for (std::thread& worker : mWorkers)
+  {
+    worker.join();
+  }
+  mWorkers.clear();
+  mReadyBatches.clear();
+  mFailedBatches.clear();
+}
+
+int SubjectOnDiskBatchLoader::getNumBatches()
+{
+  return (mSamplingPlan.size() + mBatchSize - 1) / mBatchSize;
+}
+
+std::vector<int> SubjectOnDiskBatchLoader::getPassColumnDims()
+{
+  return mPassColumnDims;
+}
+
+std::vector<int> SubjectOnDiskBatchLoader::getSensorColumnDims()
+{
+  return mSensorColumnDims;
+}
+
+void SubjectOnDiskBatchLoader::workerLoop()
+{
+  while (true)
+  {
+    int batchIndex;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      // Wait until there's room in the queue for another batch, so that we
+      // don't run arbitrarily far ahead of the consumer
+      mSpaceAvailable.wait(lock, [&] {
+        return !mRunning
+               || mNextBatchToDecode
+                      < mNextBatchToReturn + mMaxReadyBatches;
+      });
+      if (!mRunning || mNextBatchToDecode >= getNumBatches())
+      {
+        return;
+      }
+      batchIndex = mNextBatchToDecode;
+      mNextBatchToDecode++;
+    }
+
+    // An exception escaping this thread would terminate the whole process, so
+    // we hand it to the consumer to rethrow from nextBatch() instead
+    std::shared_ptr<SubjectOnDiskBatch> batch;
+    std::exception_ptr error;
+    try
+    {
+      batch = decodeBatch(batchIndex);
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      if (!mRunning)
+      {
+        return;
+      }
+      if (error)
+      {
+        mFailedBatches[batchIndex] = error;
+      }
+      else
+      {
+        mReadyBatches[batchIndex] = batch;
+      }
+    }
+    mBatchReady.notify_all();
+  }
+}
+
+std::shared_ptr<SubjectOnDiskBatch> SubjectOnDiskBatchLoader::decodeBatch(
+    int batchIndex)
+{
+  std::shared_ptr<SubjectOnDiskBatch> batch
+      = std::make_shared<SubjectOnDiskBatch>();
+  const int start = batchIndex * mBatchSize;
+  const int end = std::min((int)mSamplingPlan.size(), start + mBatchSize);
+  const int numSamples = std::max(0, end - start);
+  for (int i = start; i < end; i++)
+  {
+    batch->samples.push_back(mSamplingPlan[i]);
+  }
+
+  // Allocate all the output up front, so each sample is decoded straight into
+  // its column of the batch
+  for (int dim : mPassColumnDims)
+  {
+    batch->passColumns.push_back(Eigen::MatrixXs::Constant(
+        dim * mWindowSize, numSamples, std::nan("")));
+  }
+  for (int dim : mSensorColumnDims)
+  {
+    batch->sensorColumns.push_back(Eigen::MatrixXs::Constant(
+        dim * mWindowSize, numSamples, std::nan("")));
+  }
+
+  for (int s = 0; s < numSamples; s++)
+  {
+    const SubjectOnDiskSample& sample = batch->samples[s];
+    if (sample.subject < 0 || sample.subject >= mSubjects.size())
+    {
+      std::cout << "SubjectOnDiskBatchLoader got an out of bounds subject "
+                << sample.subject << " in its sampling plan, leaving NaNs."
+                << std::endl;
+      continue;
+    }
+    std::shared_ptr<SubjectOnDisk> subject = mSubjects[sample.subject];
+
+    for (int i = 0; i < mPassColumns.size(); i++)
+    {
+      Eigen::MatrixXs window = subject->readProcessingPassColumn(
+          sample.trial,
+          mProcessingPass,
+          mPassColumns[i],
+          sample.startFrame,
+          mWindowSize,
+          mStride);
+      const int dim = mPassColumnDims[i];
+      const int rows = std::min((int)window.rows(), dim);
+      for (int t = 0; t < window.cols(); t++)
+      {
+        batch->passColumns[i].block(t * dim, s, rows, 1)
+            = window.block(0, t, rows, 1);
+      }
+    }
+    for (int i = 0; i < mSensorColumns.size(); i++)
+    {
+      Eigen::MatrixXs window = subject->readSensorColumn(
+          sample.trial,
+          mSensorColumns[i],
+          sample.startFrame,
+          mWindowSize,
+          mStride);
+      const int dim = mSensorColumnDims[i];
+      const int rows = std::min((int)window.rows(), dim);
+      for (int t = 0; t < window.cols(); t++)
+      {
+        batch->sensorColumns[i].block(t * dim, s, rows, 1)
+            = window.block(0, t, rows, 1);
+      }
+    }
+  }
+
+  return batch;
+}
+
+} // namespace biomechanics
+} // namespace dart
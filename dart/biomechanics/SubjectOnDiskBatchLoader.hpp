@@ -0,0 +1,141 @@
+#ifndef BIOMECH_SUBJECT_ON_DISK_BATCH_LOADER
+#define BIOMECH_SUBJECT_ON_DISK_BATCH_LOADER
+
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/biomechanics/SubjectOnDisk.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+/// This is a single entry in a sampling plan: a window of frames starting at
+/// `startFrame` on `trial` of the `subject`-th SubjectOnDisk in the loader.
+struct SubjectOnDiskSample
+{
+  int subject;
+  int trial;
+  int startFrame;
+};
+
+/// This is a decoded batch of windows. Each requested channel is a single
+/// contiguous matrix with one column per sample. Each column holds the whole
+/// window for that sample, frame-major, so it has (channel dim * window size)
+/// rows, and column `i` can be reshaped to (channel dim x window size).
+struct SubjectOnDiskBatch
+{
+  std::vector<SubjectOnDiskSample> samples;
+  // One matrix per processing pass column requested from the loader, in order
+  std::vector<Eigen::MatrixXs> passColumns;
+  // One matrix per sensor column requested from the loader, in order
+  std::vector<Eigen::MatrixXs> sensorColumns;
+};
+
+/**
+ * This decodes windows of frames out of many SubjectOnDisk files on a pool of
+ * worker threads, following a fixed sampling plan. Decoded batches are held in
+ * a bounded queue, so that a training loop can pull ready batches without
+ * waiting on disk I/O and protobuf decoding, and without the workers getting
+ * too far ahead and eating all the memory on the machine.
+ *
+ * Batches are always returned in the order of the sampling plan, regardless
+ * of which worker finishes first, so runs are reproducible.
+ *
+ * All the subjects are expected to share the same model, so that the channel
+ * dimensions (like the number of DOFs) match. Samples with mismatched
+ * dimensions are padded with NaNs (or truncated) to fit.
+ */
+class SubjectOnDiskBatchLoader
+{
+public:
+  SubjectOnDiskBatchLoader(
+      std::vector<std::shared_ptr<SubjectOnDisk>> subjects,
+      std::vector<SubjectOnDiskSample> samplingPlan,
+      int batchSize,
+      int windowSize,
+      int stride = 1,
+      int processingPass = 0,
+      std::vector<std::string> passColumns
+      = std::vector<std::string>({"pos", "vel", "acc", "tau"}),
+      std::vector<std::string> sensorColumns = std::vector<std::string>(),
+      int numThreads = 4,
+      int maxReadyBatches = 8);
+
+  /// This stops and joins the worker threads
+  ~SubjectOnDiskBatchLoader();
+
+  /// This starts the worker threads decoding batches in the background. This
+  /// is a no-op if the workers are already running.
+  void start();
+
+  /// This blocks until the next batch in the sampling plan is ready, and
+  /// returns it. This starts the workers if they haven't been started yet.
+  /// Returns nullptr once the whole sampling plan has been returned.
+  ///
+  /// If decoding the batch threw (for example, because a file is corrupted),
+  /// this rethrows that exception here, on the calling thread, and moves on to
+  /// the following batch.
+  std::shared_ptr<SubjectOnDiskBatch> nextBatch();
+
+  /// This stops the worker threads, discarding any batches that have been
+  /// decoded but not returned yet.
+  void stop();
+
+  /// This returns the total number of batches in the sampling plan
+  int getNumBatches();
+
+  /// This returns the number of rows per frame of each of the requested
+  /// processing pass columns
+  std::vector<int> getPassColumnDims();
+
+  /// This returns the number of rows per frame of each of the requested
+  /// sensor columns
+  std::vector<int> getSensorColumnDims();
+
+  /// This decodes a single batch synchronously on the calling thread. This is
+  /// what the workers call, and is exposed mostly for testing.
+  std::shared_ptr<SubjectOnDiskBatch> decodeBatch(int batchIndex);
+
+protected:
+  void workerLoop();
+
+  std::vector<std::shared_ptr<SubjectOnDisk>> mSubjects;
+  std::vector<SubjectOnDiskSample> mSamplingPlan;
+  int mBatchSize;
+  int mWindowSize;
+  int mStride;
+  int mProcessingPass;
+  std::vector<std::string> mPassColumns;
+  std::vector<std::string> mSensorColumns;
+  std::vector<int> mPassColumnDims;
+  std::vector<int> mSensorColumnDims;
+  int mNumThreads;
+  int mMaxReadyBatches;
+
+  std::mutex mMutex;
+  // This is signalled whenever a batch finishes decoding
+  std::condition_variable mBatchReady;
+  // This is signalled whenever a batch is returned, or we're stopping
+  std::condition_variable mSpaceAvailable;
+  std::map<int, std::shared_ptr<SubjectOnDiskBatch>> mReadyBatches;
+  // If decoding a batch threw, this holds the exception in place of the batch
+  std::map<int, std::exception_ptr> mFailedBatches;
+  int mNextBatchToDecode;
+  int mNextBatchToReturn;
+  bool mRunning;
+  std::vector<std::thread> mWorkers;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/collision/dart/DARTBroadphase.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "dart/collision/CollisionObject.hpp"
+#include "dart/dynamics/Shape.hpp"
+
+namespace dart {
+namespace collision {
+
+//==============================================================================
+DARTBroadphase::DARTBroadphase(s_t margin) : mMargin(margin), mNextOrder(0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+void DARTBroadphase::addObject(CollisionObject* object)
+{
+  for (const Entry& entry : mEntries)
+  {
+    if (entry.object == object)
+      return;
+  }
+
+  Entry entry;
+  entry.object = object;
+  entry.order = mNextOrder++;
+  computeAabb(object, mMargin, entry.min, entry.max);
+  mEntries.push_back(entry);
+}
+
+//==============================================================================
+void DARTBroadphase::removeObject(CollisionObject* object)
+{
+  mEntries.erase(
+      std::remove_if(
+          mEntries.begin(),
+          mEntries.end(),
+          [object](const Entry& entry) { return entry.object == object; }),
+      mEntries.end());
+}
+
+//==============================================================================
+void DARTBroadphase::clear()
+{
+  mEntries.clear();
+  mNextOrder = 0;
+}
+
+//==============================================================================
+std::size_t DARTBroadphase::getNumObjects() const
+{
+  return mEntries.size();
+}
+
+//==============================================================================
+void DARTBroadphase::update()
+{
+  for (Entry& entry : mEntries)
+    computeAabb(entry.object, mMargin, entry.min, entry.max);
+
+  // Insertion sort, because the order barely changes from one call to the next
+  for (std::size_t i = 1; i < mEntries.size(); ++i)
+  {
+    if (mEntries[i - 1].min.x() <= mEntries[i].min.x())
+      continue;
+
+    Entry entry = mEntries[i];
+    std::size_t j = i;
+    while (j > 0 && mEntries[j - 1].min.x() > entry.min.x())
+    {
+      mEntries[j] = mEntries[j - 1];
+      --j;
+    }
+    mEntries[j] = entry;
+  }
+}
+
+//==============================================================================
+bool DARTBroadphase::overlapsYZ(const Entry& a, const Entry& b)
+{
+  return a.min.y() <= b.max.y() && b.min.y() <= a.max.y()
+         && a.min.z() <= b.max.z() && b.min.z() <= a.max.z();
+}
+
+//==============================================================================
+void DARTBroadphase::computeOverlappingPairs(std::vector<Pair>& pairs) const
+{
+  pairs.clear();
+
+  // Sweep along X, recording the order of each object alongside the pair so
+  // that we can sort them deterministically afterwards
+  std::vector<std::pair<std::pair<std::size_t, std::size_t>, Pair>> found;
+  for (std::size_t i = 0; i < mEntries.size(); ++i)
+  {
+    const Entry& a = mEntries[i];
+    for (std::size_t j = i + 1; j < mEntries.size(); ++j)
+    {
+      const Entry& b = mEntries[j];
+      if (b.min.x() > a.max.x())
+        break;
+      if (!overlapsYZ(a, b))
+        continue;
+
+      if (a.order < b.order)
+        found.emplace_back(
+            std::make_pair(a.order, b.order), Pair(a.object, b.object));
+      else
+        found.emplace_back(
+            std::make_pair(b.order, a.order), Pair(b.object, a.object));
+    }
+  }
+
+  std::sort(
+      found.begin(), found.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+      });
+  pairs.reserve(found.size());
+  for (const auto& entry : found)
+    pairs.push_back(entry.second);
+}
+
+//==============================================================================
+void DARTBroadphase::computeOverlappingPairs(
+    const DARTBroadphase& other, std::vector<Pair>& pairs) const
+{
+  pairs.clear();
+
+  const std::vector<Entry>& entries1 = mEntries;
+  const std::vector<Entry>& entries2 = other.mEntries;
+
+  // Merge the two sorted sweeps. Whichever entry starts first along X gets
+  // tested against everything in the other list that starts before it ends.
+  std::vector<std::pair<std::pair<std::size_t, std::size_t>, Pair>> found;
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < entries1.size() && j < entries2.size())
+  {
+    if (entries1[i].min.x() <= entries2[j].min.x())
+    {
+      const Entry& a = entries1[i];
+      for (std::size_t k = j; k < entries2.size(); ++k)
+      {
+        const Entry& b = entries2[k];
+        if (b.min.x() > a.max.x())
+          break;
+        if (overlapsYZ(a, b))
+          found.emplace_back(
+              std::make_pair(a.order, b.order), Pair(a.object, b.object));
+      }
+      ++i;
+    }
+    else
+    {
+      const Entry& b = entries2[j];
+      for (std::size_t k = i; k < entries1.size(); ++k)
+      {
+        const Entry& a = entries1[k];
+        if (a.min.x() > b.max.x())
+          break;
+        if (overlapsYZ(a, b))
+          found.emplace_back(
+              std::make_pair(a.order, b.order), Pair(a.object, b.object));
+      }
+      ++j;
+    }
+  }
+
+  std::sort(
+      found.begin(), found.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+      });
+  pairs.reserve(found.size());
+  for (const auto& entry : found)
+    pairs.push_back(entry.second);
+}
+
+//==============================================================================
+void DARTBroadphase::raycast(
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    std::vector<CollisionObject*>& objects) const
+{
+  objects.clear();
+
+  const Eigen::Vector3s dir = to - from;
+  std::vector<std::pair<std::size_t, CollisionObject*>> found;
+  for (const Entry& entry : mEntries)
+  {
+    // Standard slab test, clipped to the segment
+    s_t tMin = 0.0;
+    s_t tMax = 1.0;
+    bool hit = true;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (std::abs(dir(axis)) < std::numeric_limits<s_t>::epsilon())
+      {
+        if (from(axis) < entry.min(axis) || from(axis) > entry.max(axis))
+        {
+          hit = false;
+          break;
+        }
+        continue;
+      }
+      s_t t1 = (entry.min(axis) - from(axis)) / dir(axis);
+      s_t t2 = (entry.max(axis) - from(axis)) / dir(axis);
+      if (t1 > t2)
+        std::swap(t1, t2);
+      tMin = std::max(tMin, t1);
+      tMax = std::min(tMax, t2);
+      if (tMin > tMax)
+      {
+        hit = false;
+        break;
+      }
+    }
+    if (hit)
+      found.emplace_back(entry.order, entry.object);
+  }
+
+  std::sort(found.begin(), found.end());
+  objects.reserve(found.size());
+  for (const auto& entry : found)
+    objects.push_back(entry.second);
+}
+
+//==============================================================================
+void DARTBroadphase::queryAabb(
+    const Eigen::Vector3s& min,
+    const Eigen::Vector3s& max,
+    s_t distance,
+    std::vector<CollisionObject*>& objects) const
+{
+  objects.clear();
+
+  std::vector<std::pair<std::size_t, CollisionObject*>> found;
+  for (const Entry& entry : mEntries)
+  {
+    if (entry.min.x() > max.x() + distance)
+      break;
+
+    Eigen::Vector3s gap = (entry.min - max)
+                              .cwiseMax(min - entry.max)
+                              .cwiseMax(Eigen::Vector3s::Zero());
+    if (gap.squaredNorm() <= distance * distance)
+      found.emplace_back(entry.order, entry.object);
+  }
+
+  std::sort(found.begin(), found.end());
+  objects.reserve(found.size());
+  for (const auto& entry : found)
+    objects.push_back(entry.second);
+}
+
+//==============================================================================
+void DARTBroadphase::computeAabb(
+    const CollisionObject* object,
+    s_t margin,
+    Eigen::Vector3s& min,
+    Eigen::Vector3s& max)
+{
+  const math::BoundingBox& box = object->getShape()->getBoundingBox();
+  if (!box.getMin().allFinite() || !box.getMax().allFinite())
+  {
+    min = Eigen::Vector3s::Constant(-std::numeric_limits<s_t>::infinity());
+    max = Eigen::Vector3s::Constant(std::numeric_limits<s_t>::infinity());
+    return;
+  }
+
+  const Eigen::Isometry3s& T = object->getTransform();
+  const Eigen::Vector3s center = T * box.computeCenter();
+  const Eigen::Vector3s halfExtents
+      = T.linear().cwiseAbs() * box.computeHalfExtents()
+        + Eigen::Vector3s::Constant(margin);
+  min = center - halfExtents;
+  max = center + halfExtents;
+}
+
+} // namespace collision
+} // namespace dart
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COLLISION_DART_DARTBROADPHASE_HPP_
+#define DART_COLLISION_DART_DARTBROADPHASE_HPP_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace collision {
+
+class CollisionObject;
+
+/// This is an incremental sweep-and-prune broadphase over the world space
+/// AABBs of a set of CollisionObjects. Each DARTCollisionGroup keeps one, so
+/// that the narrowphase in DARTCollide.cpp only runs on pairs of objects whose
+/// bounding boxes actually overlap.
+///
+/// Objects are kept sorted by the lower bound of their AABB along the X axis.
+/// Between timesteps objects only move a little, so re-sorting with an
+/// insertion sort in update() is close to linear in the number of objects.
+class DARTBroadphase
+{
+public:
+  using Pair = std::pair<CollisionObject*, CollisionObject*>;
+
+  /// `margin` is added on every side of every AABB, so that the broadphase
+  /// stays conservative in the face of round-off in the narrowphase.
+  DARTBroadphase(s_t margin = 1e-4);
+
+  /// Adds an object, if it isn't already in the broadphase. Objects keep the
+  /// order they were added in, which is the order pairs get reported in.
+  void addObject(CollisionObject* object);
+
+  /// Removes an object, if it's in the broadphase
+  void removeObject(CollisionObject* object);
+
+  /// Removes all the objects
+  void clear();
+
+  /// Returns the number of objects in the broadphase
+  std::size_t getNumObjects() const;
+
+  /// Recomputes the AABBs of all the objects from their current transforms and
+  /// shapes, and re-sorts the sweep axis. Call this before any queries once
+  /// objects have moved.
+  void update();
+
+  /// Finds all the pairs of objects in this broadphase whose AABBs overlap.
+  /// Each pair is reported once, with the object that was added first as
+  /// `first`, and pairs are sorted in the order a nested loop over the objects
+  /// would have visited them.
+  void computeOverlappingPairs(std::vector<Pair>& pairs) const;
+
+  /// Finds all the pairs of objects (one from this broadphase as `first`, one
+  /// from `other` as `second`) whose AABBs overlap, sorted in the order a
+  /// nested loop over this broadphase then `other` would have visited them.
+  void computeOverlappingPairs(
+      const DARTBroadphase& other, std::vector<Pair>& pairs) const;
+
+  /// Finds all the objects whose AABBs the segment from `from` to `to`
+  /// passes through, in the order they were added.
+  void raycast(
+      const Eigen::Vector3s& from,
+      const Eigen::Vector3s& to,
+      std::vector<CollisionObject*>& objects) const;
+
+  /// Finds all the objects whose AABBs come within `distance` of the box
+  /// [`min`, `max`], in the order they were added. This is useful for culling
+  /// distance queries.
+  void queryAabb(
+      const Eigen::Vector3s& min,
+      const Eigen::Vector3s& max,
+      s_t distance,
+      std::vector<CollisionObject*>& objects) const;
+
+  /// This computes the world space AABB of an object's shape, padded by
+  /// `margin`. Shapes with unbounded extents (like planes) get an infinite box.
+  static void computeAabb(
+      const CollisionObject* object,
+      s_t margin,
+      Eigen::Vector3s& min,
+      Eigen::Vector3s& max);
+
+protected:
+  struct Entry
+  {
+    CollisionObject* object;
+    /// The order this object was added in, used to report results
+    /// deterministically regardless of where objects are on the sweep axis
+    std::size_t order;
+    Eigen::Vector3s min;
+    Eigen::Vector3s max;
+  };
+
+  static bool overlapsYZ(const Entry& a, const Entry& b);
+
+  s_t mMargin;
+
+  /// Sorted by min.x() after each update()
+  std::vector<Entry> mEntries;
+
+  std::size_t mNextOrder;
+};
+
+} // namespace collision
+} // namespace dart
+
+#endif // DART_COLLISION_DART_DARTBROADPHASE_HPP_
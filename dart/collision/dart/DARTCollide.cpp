@@ -33,7 +33,6 @@
 #include "dart/collision/dart/DARTCollide.hpp"
 
 #include <memory>
-#include <thread>
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/dynamics/BodyNode.hpp"
@@ -1950,20 +1949,31 @@ void ccdSupportMesh(const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out)
   s_t maxDot = -std::numeric_limits<s_t>::infinity();
   Eigen::Vector3s maxDotPoint = Eigen::Vector3s::Zero();
 
-  for (int i = 0; i < mesh->mesh->mNumMeshes; i++)
+  if (mesh->hull != nullptr && mesh->hull->getNumVertices() > 0)
   {
-    aiMesh* m = mesh->mesh->mMeshes[i];
-    for (int k = 0; k < m->mNumVertices; k++)
+    // Hill-climb across the precomputed hull, starting from wherever the last
+    // query on this mesh ended up
+    mesh->supportHint
+        = mesh->hull->getSupportVertex(localDir, mesh->supportHint);
+    maxDotPoint = mesh->hull->getVertex(mesh->supportHint);
+  }
+  else
+  {
+    for (int i = 0; i < mesh->mesh->mNumMeshes; i++)
     {
-      s_t dot = m->mVertices[k].x * localDir(0)
-                + m->mVertices[k].y * localDir(1)
-                + m->mVertices[k].z * localDir(2);
-      if (dot > maxDot)
+      aiMesh* m = mesh->mesh->mMeshes[i];
+      for (int k = 0; k < m->mNumVertices; k++)
       {
-        maxDot = dot;
-        maxDotPoint(0) = m->mVertices[k].x;
-        maxDotPoint(1) = m->mVertices[k].y;
-        maxDotPoint(2) = m->mVertices[k].z;
+        s_t dot = m->mVertices[k].x * localDir(0)
+                  + m->mVertices[k].y * localDir(1)
+                  + m->mVertices[k].z * localDir(2);
+        if (dot > maxDot)
+        {
+          maxDot = dot;
+          maxDotPoint(0) = m->mVertices[k].x;
+          maxDotPoint(1) = m->mVertices[k].y;
+          maxDotPoint(2) = m->mVertices[k].z;
+        }
       }
     }
   }
@@ -3707,11 +3717,7 @@ inline void setCcdDefaultSettings(ccd_t& ccd)
 /// cacheing
 void clearCcdCache()
 {
-  const std::thread::id tid = std::this_thread::get_id();
-  _ccdDirCache[tid].clear();
-  _ccdPosCache[tid].clear();
-  // _ccdDirCache.clear();
-  // _ccdPosCache.clear();
+  DARTCollisionContext::getCurrent().clear();
 }
 
 /*
@@ -3868,22 +3874,22 @@ bool get2DLineIntersection(
   return false; // No collision
 }
 
+// Get the `dir` and `pos` vecs for CCD for this pair of objects
+CcdWarmStart& getCcdWarmStart(CollisionObject* o1, CollisionObject* o2)
+{
+  return DARTCollisionContext::getCurrent().getWarmStart(o1, o2);
+}
+
 // Get the `pos` vec for CCD for this pair of objects
 ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2)
 {
-  long key = (long)o1 ^ (long)o2;
-  const std::thread::id tid = std::this_thread::get_id();
-  ccd_vec3_t& pos = _ccdPosCache[tid][key];
-  return pos;
+  return getCcdWarmStart(o1, o2).pos;
 }
 
 // Get the `dir` vec for CCD for this pair of objects
 ccd_vec3_t& getCachedCcdDir(CollisionObject* o1, CollisionObject* o2)
 {
-  long key = (long)o1 ^ (long)o2;
-  const std::thread::id tid = std::this_thread::get_id();
-  ccd_vec3_t& dir = _ccdDirCache[tid][key];
-  return dir;
+  return getCcdWarmStart(o1, o2).dir;
 }
 
 int collideBoxBoxAsMesh(
@@ -3915,8 +3921,9 @@ int collideBoxBoxAsMesh(
   box2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&box1, &box2, &ccd, &depth, &dir, &pos);
   if (depth > option.contactClippingDepth)
     return 0;
@@ -3941,7 +3948,8 @@ int collideMeshBox(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::ConvexHull3D* hull0)
 {
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
@@ -3957,14 +3965,16 @@ int collideMeshBox(
   mesh1.mesh = mesh0;
   mesh1.transform = &c0;
   mesh1.scale = &size0;
+  mesh1.hull = hull0;
 
   ccdBox box2;
   box2.size = &size1;
   box2.transform = &c1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&mesh1, &box2, &ccd, &depth, &dir, &pos);
   if (depth > option.contactClippingDepth)
     return 0;
@@ -3989,7 +3999,8 @@ int collideBoxMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::ConvexHull3D* hull1)
 {
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
@@ -4009,10 +4020,12 @@ int collideBoxMesh(
   mesh2.mesh = m1;
   mesh2.transform = &c1;
   mesh2.scale = &size1;
+  mesh2.hull = hull1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&box1, &mesh2, &ccd, &depth, &dir, &pos);
   if (depth > option.contactClippingDepth)
     return 0;
@@ -4044,7 +4057,8 @@ int collideMeshSphere(
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
     CollisionResult& result,
-    ClipSphereHalfspace /* halfspace */)
+    ClipSphereHalfspace /* halfspace */,
+    const math::ConvexHull3D* hull0)
 {
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
@@ -4053,6 +4067,7 @@ int collideMeshSphere(
   mesh.mesh = mesh0;
   mesh.transform = &c0;
   mesh.scale = &size0;
+  mesh.hull = hull0;
 
   ccdSphere sphere;
   sphere.radius = r1;
@@ -4066,8 +4081,9 @@ int collideMeshSphere(
   setCcdDefaultSettings(ccd);      // maximal tolerance
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&mesh, &sphere, &ccd, &depth, &dir, &pos);
   if (depth > option.contactClippingDepth)
     return 0;
@@ -4092,7 +4108,8 @@ int collideSphereMesh(
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
     CollisionResult& result,
-    ClipSphereHalfspace /* halfspace */)
+    ClipSphereHalfspace /* halfspace */,
+    const math::ConvexHull3D* hull1)
 {
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
@@ -4105,6 +4122,7 @@ int collideSphereMesh(
   mesh.mesh = mesh1;
   mesh.transform = &c1;
   mesh.scale = &size1;
+  mesh.hull = hull1;
 
   // set up ccd_t struct
   ccd.support1 = ccdSupportSphere; // support function for first object
@@ -4114,8 +4132,9 @@ int collideSphereMesh(
   setCcdDefaultSettings(ccd);      // maximal tolerance
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&sphere, &mesh, &ccd, &depth, &dir, &pos);
   if (depth > option.contactClippingDepth)
     return 0;
@@ -4140,7 +4159,9 @@ int collideMeshMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::ConvexHull3D* hull0,
+    const math::ConvexHull3D* hull1)
 {
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
@@ -4156,15 +4177,18 @@ int collideMeshMesh(
   mesh1.mesh = m0;
   mesh1.transform = &c0;
   mesh1.scale = &size0;
+  mesh1.hull = hull0;
 
   ccdMesh mesh2;
   mesh2.mesh = m1;
   mesh2.transform = &c1;
   mesh2.scale = &size1;
+  mesh2.hull = hull1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&mesh1, &mesh2, &ccd, &depth, &dir, &pos);
   if (depth > option.contactClippingDepth)
     return 0;
@@ -4450,8 +4474,9 @@ int collideBoxCapsule(
   capsule2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&box1, &capsule2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -4561,8 +4586,9 @@ int collideCapsuleBox(
   box2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect = ccdMPRPenetration(&capsule1, &box2, &ccd, &depth, &dir, &pos);
   if (intersect == 0)
   {
@@ -4654,7 +4680,8 @@ int collideMeshCapsule(
     s_t radius1,
     const Eigen::Isometry3s& T1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::ConvexHull3D* hull0)
 {
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
@@ -4670,6 +4697,7 @@ int collideMeshCapsule(
   mesh1.mesh = m0;
   mesh1.transform = &T0;
   mesh1.scale = &size0;
+  mesh1.hull = hull0;
 
   ccdCapsule capsule2;
   capsule2.height = height1;
@@ -4677,8 +4705,9 @@ int collideMeshCapsule(
   capsule2.transform = &T1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect
       = ccdMPRPenetration(&mesh1, &capsule2, &ccd, &depth, &dir, &pos);
   if (depth > option.contactClippingDepth)
@@ -4704,7 +4733,8 @@ int collideMeshCapsule(
           T1 * sphereTransform,
           option,
           result,
-          ClipSphereHalfspace::TOP);
+          ClipSphereHalfspace::TOP,
+          hull0);
     }
     else if (localPos(2) < -height1 / 2)
     {
@@ -4720,7 +4750,8 @@ int collideMeshCapsule(
           T1 * sphereTransform,
           option,
           result,
-          ClipSphereHalfspace::BOTTOM);
+          ClipSphereHalfspace::BOTTOM,
+          hull0);
     }
 
     // Otherwise we're on an edge, and have to handle the pipe collisions
@@ -4762,7 +4793,8 @@ int collideCapsuleMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& T1,
     const CollisionOption& option,
-    CollisionResult& result)
+    CollisionResult& result,
+    const math::ConvexHull3D* hull1)
 {
   ccd_t ccd;
   CCD_INIT(&ccd); // initialize ccd_t struct
@@ -4783,10 +4815,12 @@ int collideCapsuleMesh(
   mesh2.mesh = m1;
   mesh2.scale = &size1;
   mesh2.transform = &T1;
+  mesh2.hull = hull1;
 
   ccd_real_t depth;
-  ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
-  ccd_vec3_t& pos = getCachedCcdPos(o1, o2);
+  CcdWarmStart& warmStart = getCcdWarmStart(o1, o2);
+  ccd_vec3_t& dir = warmStart.dir;
+  ccd_vec3_t& pos = warmStart.pos;
   int intersect
       = ccdMPRPenetration(&capsule1, &mesh2, &ccd, &depth, &dir, &pos);
   if (depth > option.contactClippingDepth)
@@ -4812,7 +4846,8 @@ int collideCapsuleMesh(
           T1,
           option,
           result,
-          ClipSphereHalfspace::TOP);
+          ClipSphereHalfspace::TOP,
+          hull1);
     }
     else if (localPos(2) < -height0 / 2)
     {
@@ -4828,7 +4863,8 @@ int collideCapsuleMesh(
           T1,
           option,
           result,
-          ClipSphereHalfspace::BOTTOM);
+          ClipSphereHalfspace::BOTTOM,
+          hull1);
     }
 
     // Otherwise we're on an edge, and have to handle the pipe collisions
@@ -5107,7 +5143,9 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh1->getConvexHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5312,7 +5350,8 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          mesh1->getConvexHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5393,7 +5432,9 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh1->getConvexHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5429,7 +5470,8 @@ int collide(
           box1->getSize(),
           T2,
           option,
-          result);
+          result,
+          mesh0->getConvexHull().get());
     }
     else if (dynamics::SphereShape::getStaticType() == shapeType2)
     {
@@ -5445,7 +5487,9 @@ int collide(
           sphere1->getRadius(),
           T2,
           option,
-          result);
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh0->getConvexHull().get());
     }
     else if (dynamics::EllipsoidShape::getStaticType() == shapeType2)
     {
@@ -5461,7 +5505,9 @@ int collide(
           ellipsoid1->getRadii()[0],
           T2,
           option,
-          result);
+          result,
+          ClipSphereHalfspace::BOTH,
+          mesh0->getConvexHull().get());
     }
     else if (dynamics::MeshShape::getStaticType() == shapeType2)
     {
@@ -5477,7 +5523,9 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          mesh0->getConvexHull().get(),
+          mesh1->getConvexHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -5494,7 +5542,8 @@ int collide(
           capsule1->getRadius(),
           T2,
           option,
-          result);
+          result,
+          mesh0->getConvexHull().get());
     }
   }
   else if (dynamics::CapsuleShape::getStaticType() == shapeType1)
@@ -5563,7 +5612,8 @@ int collide(
           mesh1->getScale(),
           T2,
           option,
-          result);
+          result,
+          mesh1->getConvexHull().get());
     }
     else if (dynamics::CapsuleShape::getStaticType() == shapeType2)
     {
@@ -33,8 +33,6 @@
 #ifndef DART_COLLISION_DART_DARTCOLLIDE_HPP_
 #define DART_COLLISION_DART_DARTCOLLIDE_HPP_
 
-#include <thread>
-#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -43,6 +41,8 @@
 #include <ccd/vec3.h>
 
 #include "dart/collision/CollisionDetector.hpp"
+#include "dart/collision/dart/DARTCollisionContext.hpp"
+#include "dart/math/ConvexHull3D.hpp"
 
 namespace dart {
 namespace collision {
@@ -139,7 +139,8 @@ int collideMeshBox(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::ConvexHull3D* hull0 = nullptr);
 
 int collideBoxMesh(
     CollisionObject* o1,
@@ -150,7 +151,8 @@ int collideBoxMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::ConvexHull3D* hull1 = nullptr);
 
 int collideMeshSphere(
     CollisionObject* o1,
@@ -162,7 +164,8 @@ int collideMeshSphere(
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
     CollisionResult& result,
-    ClipSphereHalfspace halfspace = ClipSphereHalfspace::BOTH);
+    ClipSphereHalfspace halfspace = ClipSphereHalfspace::BOTH,
+    const math::ConvexHull3D* hull0 = nullptr);
 
 int collideSphereMesh(
     CollisionObject* o1,
@@ -174,7 +177,8 @@ int collideSphereMesh(
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
     CollisionResult& result,
-    ClipSphereHalfspace halfspace = ClipSphereHalfspace::BOTH);
+    ClipSphereHalfspace halfspace = ClipSphereHalfspace::BOTH,
+    const math::ConvexHull3D* hull1 = nullptr);
 
 int collideMeshMesh(
     CollisionObject* o1,
@@ -186,7 +190,9 @@ int collideMeshMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& c1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::ConvexHull3D* hull0 = nullptr,
+    const math::ConvexHull3D* hull1 = nullptr);
 
 int collideCapsuleCapsule(
     CollisionObject* o1,
@@ -254,7 +260,8 @@ int collideMeshCapsule(
     s_t radius1,
     const Eigen::Isometry3s& T1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::ConvexHull3D* hull0 = nullptr);
 
 int collideCapsuleMesh(
     CollisionObject* o1,
@@ -266,7 +273,8 @@ int collideCapsuleMesh(
     const Eigen::Vector3s& size1,
     const Eigen::Isometry3s& T1,
     const CollisionOption& option,
-    CollisionResult& result);
+    CollisionResult& result,
+    const math::ConvexHull3D* hull1 = nullptr);
 
 int collideCylinderSphere(
     CollisionObject* o1,
@@ -295,6 +303,10 @@ int collideCylinderPlane(
 // Interface with libccd:
 /////////////////////////////////////////////////////////////////////
 
+// Get the `dir` and `pos` vecs for CCD for this pair of objects, from the
+// DARTCollisionContext bound to the current thread
+CcdWarmStart& getCcdWarmStart(CollisionObject* o1, CollisionObject* o2);
+
 // Get the `pos` vec for CCD for this pair of objects
 ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2);
 
@@ -320,6 +332,12 @@ struct ccdMesh
   const aiScene* mesh;
   const Eigen::Isometry3s* transform;
   const Eigen::Vector3s* scale;
+  /// If this is set, support queries hill-climb across this hull (which must be
+  /// the hull of `mesh`) instead of scanning every vertex of `mesh`
+  const math::ConvexHull3D* hull = nullptr;
+  /// The hull vertex returned by the last support query, which we start the
+  /// next one from
+  int supportHint = 0;
 };
 
 struct ccdCapsule
@@ -462,15 +480,9 @@ bool get2DLineIntersection(
 inline void setCcdDefaultSettings(ccd_t& ccd);
 
 /// This allows us to prevent weird effects where we don't want to carry over
-/// cacheing
+/// cacheing. This clears the DARTCollisionContext bound to the current thread.
 void clearCcdCache();
 
-/// This is the static cache for all the CCD collision search data
-static std::unordered_map<std::thread::id, std::unordered_map<long, ccd_vec3_t>>
-    _ccdDirCache;
-static std::unordered_map<std::thread::id, std::unordered_map<long, ccd_vec3_t>>
-    _ccdPosCache;
-
 } // namespace collision
 } // namespace dart
 
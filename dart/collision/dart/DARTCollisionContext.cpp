@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/collision/dart/DARTCollisionContext.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dart {
+namespace collision {
+
+namespace {
+
+/// The context bound by the innermost live ScopedBind on this thread, if any
+thread_local DARTCollisionContext* tBoundContext = nullptr;
+
+} // anonymous namespace
+
+//==============================================================================
+DARTCollisionContext::DARTCollisionContext()
+  : mEntries(64), mOccupied(64, 0), mNumPairs(0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+CcdWarmStart& DARTCollisionContext::getWarmStart(
+    const CollisionObject* o1, const CollisionObject* o2)
+{
+  const std::size_t mask = mEntries.size() - 1;
+  std::size_t slot = hash(o1, o2);
+  while (mOccupied[slot])
+  {
+    Entry& entry = mEntries[slot];
+    if (entry.first == o1 && entry.second == o2)
+      return entry.warmStart;
+    slot = (slot + 1) & mask;
+  }
+
+  // Keep the table at most half full, so probe sequences stay short
+  if (2 * (mNumPairs + 1) > mEntries.size())
+  {
+    grow();
+    return getWarmStart(o1, o2);
+  }
+
+  mOccupied[slot] = 1;
+  mNumPairs++;
+  Entry& entry = mEntries[slot];
+  entry.first = o1;
+  entry.second = o2;
+  std::memset(&entry.warmStart, 0, sizeof(CcdWarmStart));
+  return entry.warmStart;
+}
+
+//==============================================================================
+void DARTCollisionContext::clear()
+{
+  std::fill(mOccupied.begin(), mOccupied.end(), 0);
+  mNumPairs = 0;
+}
+
+//==============================================================================
+std::size_t DARTCollisionContext::getNumPairs() const
+{
+  return mNumPairs;
+}
+
+//==============================================================================
+DARTCollisionContext& DARTCollisionContext::getCurrent()
+{
+  if (tBoundContext != nullptr)
+    return *tBoundContext;
+  static thread_local DARTCollisionContext defaultContext;
+  return defaultContext;
+}
+
+//==============================================================================
+DARTCollisionContext::ScopedBind::ScopedBind(DARTCollisionContext& context)
+  : mPrevious(tBoundContext)
+{
+  tBoundContext = &context;
+}
+
+//==============================================================================
+DARTCollisionContext::ScopedBind::~ScopedBind()
+{
+  tBoundContext = mPrevious;
+}
+
+//==============================================================================
+std::size_t DARTCollisionContext::hash(
+    const CollisionObject* o1, const CollisionObject* o2) const
+{
+  // Objects are heap allocated, so the low bits of their addresses carry
+  // little information. Multiplying by large odd constants spreads the high
+  // bits down, and we keep the top bits of the result.
+  const std::uint64_t a = reinterpret_cast<std::uintptr_t>(o1);
+  const std::uint64_t b = reinterpret_cast<std::uintptr_t>(o2);
+  const std::uint64_t h
+      = (a * 0x9E3779B97F4A7C15ULL) ^ (b * 0xC2B2AE3D27D4EB4FULL);
+  return static_cast<std::size_t>((h ^ (h >> 29)) & (mEntries.size() - 1));
+}
+
+//==============================================================================
+void DARTCollisionContext::grow()
+{
+  std::vector<Entry> oldEntries(mEntries.size() * 2);
+  std::vector<std::uint8_t> oldOccupied(mOccupied.size() * 2, 0);
+  oldEntries.swap(mEntries);
+  oldOccupied.swap(mOccupied);
+
+  const std::size_t mask = mEntries.size() - 1;
+  for (std::size_t i = 0; i < oldEntries.size(); i++)
+  {
+    if (!oldOccupied[i])
+      continue;
+    std::size_t slot = hash(oldEntries[i].first, oldEntries[i].second);
+    while (mOccupied[slot])
+    {
+      slot = (slot + 1) & mask;
+    }
+    mOccupied[slot] = 1;
+    mEntries[slot] = oldEntries[i];
+  }
+}
+
+} // namespace collision
+} // namespace dart
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COLLISION_DART_DARTCOLLISIONCONTEXT_HPP_
+#define DART_COLLISION_DART_DARTCOLLISIONCONTEXT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <ccd/vec3.h>
+
+namespace dart {
+namespace collision {
+
+class CollisionObject;
+
+/// The per-pair scratch space that libccd's MPR writes its penetration
+/// direction and position into
+struct CcdWarmStart
+{
+  ccd_vec3_t dir;
+  ccd_vec3_t pos;
+};
+
+/// This holds the per-pair libccd state for the DART narrowphase, in a flat
+/// open-addressing hash table keyed by the (ordered) pair of CollisionObjects.
+///
+/// Each DARTCollisionGroup owns one, which DARTCollisionDetector binds to the
+/// calling thread for the duration of each collide() call, so the narrowphase
+/// in DARTCollide.cpp finds it with a single thread_local read. Narrowphase
+/// calls made outside of a collide() (for example, calling collideBoxBox()
+/// directly) use a default context that belongs to the calling thread.
+///
+/// A context isn't safe to use from several threads at once, which is already
+/// true of the DARTCollisionGroup that owns it.
+class DARTCollisionContext
+{
+public:
+  DARTCollisionContext();
+
+  /// Returns the slot for the pair (o1, o2), creating a zeroed one if we
+  /// haven't seen this pair before. The reference stays valid until a
+  /// different pair is looked up.
+  CcdWarmStart& getWarmStart(
+      const CollisionObject* o1, const CollisionObject* o2);
+
+  /// Drops every pair. Call this when objects are removed, since a new object
+  /// could be allocated at the same address as a removed one.
+  void clear();
+
+  /// Returns the number of pairs we're holding
+  std::size_t getNumPairs() const;
+
+  /// Returns the context that the narrowphase on this thread should use: the
+  /// innermost one bound by a live ScopedBind, or else this thread's default
+  /// context.
+  static DARTCollisionContext& getCurrent();
+
+  /// This binds a context to the current thread for as long as it's alive,
+  /// and restores whatever was bound before when it goes out of scope.
+  class ScopedBind
+  {
+  public:
+    explicit ScopedBind(DARTCollisionContext& context);
+    ~ScopedBind();
+
+    ScopedBind(const ScopedBind&) = delete;
+    ScopedBind& operator=(const ScopedBind&) = delete;
+
+  private:
+    DARTCollisionContext* mPrevious;
+  };
+
+protected:
+  struct Entry
+  {
+    const CollisionObject* first;
+    const CollisionObject* second;
+    CcdWarmStart warmStart;
+  };
+
+  /// Returns the home slot for a pair, in a table of mEntries.size() slots
+  std::size_t hash(const CollisionObject* o1, const CollisionObject* o2) const;
+
+  /// Doubles the size of the table, and re-inserts every pair
+  void grow();
+
+  /// Always a power of two in size
+  std::vector<Entry> mEntries;
+  /// Whether each slot of mEntries is in use. We can't use a sentinel pointer
+  /// for this, because (nullptr, nullptr) is a legitimate pair.
+  std::vector<std::uint8_t> mOccupied;
+  std::size_t mNumPairs;
+};
+
+} // namespace collision
+} // namespace dart
+
+#endif // DART_COLLISION_DART_DARTCOLLISIONCONTEXT_HPP_
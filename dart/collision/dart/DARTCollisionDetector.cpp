@@ -32,13 +32,20 @@
 
 #include "dart/collision/dart/DARTCollisionDetector.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
 #include "dart/collision/CollisionFilter.hpp"
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/DistanceFilter.hpp"
+#include "dart/collision/RaycastResult.hpp"
 #include "dart/collision/dart/DARTCollide.hpp"
 #include "dart/collision/dart/DARTCollisionGroup.hpp"
 #include "dart/collision/dart/DARTCollisionObject.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/CylinderShape.hpp"
 #include "dart/dynamics/EllipsoidShape.hpp"
 #include "dart/dynamics/MeshShape.hpp"
 #include "dart/dynamics/ShapeFrame.hpp"
@@ -58,6 +65,46 @@ bool checkPair(
 bool isClose(
     const Eigen::Vector3s& pos1, const Eigen::Vector3s& pos2, double tol);
 
+bool raycastObject(
+    const CollisionObject* object,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    RayHit& hit);
+
+/// The closest pair of objects a distance query has found so far
+struct ClosestPair
+{
+  s_t distance = std::numeric_limits<s_t>::infinity();
+  CollisionObject* object1 = nullptr;
+  CollisionObject* object2 = nullptr;
+  Eigen::Vector3s point1 = Eigen::Vector3s::Zero();
+  Eigen::Vector3s point2 = Eigen::Vector3s::Zero();
+};
+
+bool distanceObjects(
+    const CollisionObject* o1,
+    const CollisionObject* o2,
+    s_t& distance,
+    Eigen::Vector3s& point1,
+    Eigen::Vector3s& point2);
+
+void distancePair(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const DistanceOption& option,
+    ClosestPair& closest);
+
+void findCloseObjects(
+    const DARTBroadphase& broadphase,
+    const CollisionObject* object,
+    s_t distance,
+    std::vector<CollisionObject*>& objects);
+
+double reportDistance(
+    const ClosestPair& closest,
+    const DistanceOption& option,
+    DistanceResult* result);
+
 void postProcess(
     CollisionObject* o1,
     CollisionObject* o2,
@@ -144,34 +191,72 @@ bool DARTCollisionDetector::collide(
   if (objects.empty())
     return false;
 
+  // The narrowphase keeps its per-pair libccd state in the group's context
+  DARTCollisionContext::ScopedBind bindContext(casted->mCollisionContext);
+
   auto collisionFound = false;
   const auto& filter = option.collisionFilter;
 
-  for (auto i = 0u; i < objects.size() - 1; ++i)
+  if (!mUseBroadphase)
   {
-    auto* collObj1 = objects[i];
-
-    for (auto j = i + 1u; j < objects.size(); ++j)
+    for (auto i = 0u; i < objects.size() - 1; ++i)
     {
-      auto* collObj2 = objects[j];
-
-      if (filter && filter->ignoresCollision(collObj1, collObj2))
-        continue;
+      auto* collObj1 = objects[i];
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
-
-      if (result)
-      {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
-      }
-      else
+      for (auto j = i + 1u; j < objects.size(); ++j)
       {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
-          return true;
+        auto* collObj2 = objects[j];
+
+        if (filter && filter->ignoresCollision(collObj1, collObj2))
+          continue;
+
+        if (checkPair(collObj1, collObj2, option, result))
+          collisionFound = true;
+
+        if (result)
+        {
+          if (result->getNumContacts() >= option.maxNumContacts)
+            return true;
+        }
+        else
+        {
+          // If no result is passed, stop checking when the first contact is
+          // found
+          if (collisionFound)
+            return true;
+        }
       }
     }
+
+    // Either no collision found or not reached the maximum number of contacts
+    return collisionFound;
+  }
+
+  // Only run the narrowphase on pairs whose bounding boxes overlap. The pairs
+  // come back in the same order the loop above would visit them.
+  casted->updateEngineData();
+  auto& pairs = casted->mOverlappingPairs;
+  casted->mBroadphase.computeOverlappingPairs(pairs);
+
+  for (const auto& pair : pairs)
+  {
+    if (filter && filter->ignoresCollision(pair.first, pair.second))
+      continue;
+
+    if (checkPair(pair.first, pair.second, option, result))
+      collisionFound = true;
+
+    if (result)
+    {
+      if (result->getNumContacts() >= option.maxNumContacts)
+        return true;
+    }
+    else
+    {
+      // If no result is passed, stop checking when the first contact is found
+      if (collisionFound)
+        return true;
+    }
   }
 
   // Either no collision found or not reached the maximum number of contacts
@@ -206,67 +291,287 @@ bool DARTCollisionDetector::collide(
   if (objects1.empty() || objects2.empty())
     return false;
 
+  // Pairs across two groups keep their libccd state in the first group's
+  // context
+  DARTCollisionContext::ScopedBind bindContext(casted1->mCollisionContext);
+
   auto collisionFound = false;
   const auto& filter = option.collisionFilter;
 
-  for (auto i = 0u; i < objects1.size(); ++i)
+  if (!mUseBroadphase)
+  {
+    for (auto i = 0u; i < objects1.size(); ++i)
+    {
+      auto* collObj1 = objects1[i];
+
+      for (auto j = 0u; j < objects2.size(); ++j)
+      {
+        auto* collObj2 = objects2[j];
+
+        if (filter && filter->ignoresCollision(collObj1, collObj2))
+          continue;
+
+        if (checkPair(collObj1, collObj2, option, result))
+          collisionFound = true;
+
+        if (result)
+        {
+          if (result->getNumContacts() >= option.maxNumContacts)
+            return true;
+        }
+        else
+        {
+          // If no result is passed, stop checking when the first contact is
+          // found
+          if (collisionFound)
+            return true;
+        }
+      }
+    }
+
+    // Either no collision found or not reached the maximum number of contacts
+    return collisionFound;
+  }
+
+  casted1->updateEngineData();
+  if (casted2 != casted1)
+    casted2->updateEngineData();
+  auto& pairs = casted1->mOverlappingPairs;
+  casted1->mBroadphase.computeOverlappingPairs(casted2->mBroadphase, pairs);
+
+  for (const auto& pair : pairs)
   {
-    auto* collObj1 = objects1[i];
+    if (filter && filter->ignoresCollision(pair.first, pair.second))
+      continue;
 
-    for (auto j = 0u; j < objects2.size(); ++j)
+    if (checkPair(pair.first, pair.second, option, result))
+      collisionFound = true;
+
+    if (result)
+    {
+      if (result->getNumContacts() >= option.maxNumContacts)
+        return true;
+    }
+    else
     {
-      auto* collObj2 = objects2[j];
+      // If no result is passed, stop checking when the first contact is found
+      if (collisionFound)
+        return true;
+    }
+  }
 
-      if (filter && filter->ignoresCollision(collObj1, collObj2))
-        continue;
+  // Either no collision found or not reached the maximum number of contacts
+  return collisionFound;
+}
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+//==============================================================================
+double DARTCollisionDetector::distance(
+    CollisionGroup* group, const DistanceOption& option, DistanceResult* result)
+{
+  if (result)
+    result->clear();
+
+  if (!checkGroupValidity(this, group))
+    return 0.0;
+
+  auto casted = static_cast<DARTCollisionGroup*>(group);
+  const auto& objects = casted->mCollisionObjects;
+
+  ClosestPair closest;
 
-      if (result)
+  if (!mUseBroadphase)
+  {
+    for (auto i = 0u; i < objects.size(); ++i)
+    {
+      for (auto j = i + 1u; j < objects.size(); ++j)
       {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
+        distancePair(objects[i], objects[j], option, closest);
+
+        if (closest.distance <= option.distanceLowerBound)
+          return reportDistance(closest, option, result);
       }
-      else
+    }
+
+    return reportDistance(closest, option, result);
+  }
+
+  casted->updateEngineData();
+
+  std::vector<CollisionObject*> candidates;
+  for (auto* collObj1 : objects)
+  {
+    // Anything farther away than the best distance so far can't beat it
+    findCloseObjects(
+        casted->mBroadphase, collObj1, closest.distance, candidates);
+
+    // The candidates come back in the order they were added, which is the
+    // order of `objects`, so the pairs we haven't checked yet are the ones
+    // after collObj1. Pairs culled here couldn't have beaten the best distance.
+    auto it = std::find(candidates.begin(), candidates.end(), collObj1);
+    if (it == candidates.end())
+      continue;
+
+    for (++it; it != candidates.end(); ++it)
+    {
+      distancePair(collObj1, *it, option, closest);
+
+      if (closest.distance <= option.distanceLowerBound)
+        return reportDistance(closest, option, result);
+    }
+  }
+
+  return reportDistance(closest, option, result);
+}
+
+//==============================================================================
+double DARTCollisionDetector::distance(
+    CollisionGroup* group1,
+    CollisionGroup* group2,
+    const DistanceOption& option,
+    DistanceResult* result)
+{
+  if (result)
+    result->clear();
+
+  if (!checkGroupValidity(this, group1))
+    return 0.0;
+
+  if (!checkGroupValidity(this, group2))
+    return 0.0;
+
+  auto casted1 = static_cast<DARTCollisionGroup*>(group1);
+  auto casted2 = static_cast<DARTCollisionGroup*>(group2);
+
+  const auto& objects1 = casted1->mCollisionObjects;
+  const auto& objects2 = casted2->mCollisionObjects;
+
+  ClosestPair closest;
+
+  if (!mUseBroadphase)
+  {
+    for (auto* collObj1 : objects1)
+    {
+      for (auto* collObj2 : objects2)
       {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
-          return true;
+        if (collObj1 == collObj2)
+          continue;
+
+        distancePair(collObj1, collObj2, option, closest);
+
+        if (closest.distance <= option.distanceLowerBound)
+          return reportDistance(closest, option, result);
       }
     }
+
+    return reportDistance(closest, option, result);
   }
 
-  // Either no collision found or not reached the maximum number of contacts
-  return collisionFound;
+  casted2->updateEngineData();
+
+  std::vector<CollisionObject*> candidates;
+  for (auto* collObj1 : objects1)
+  {
+    findCloseObjects(
+        casted2->mBroadphase, collObj1, closest.distance, candidates);
+
+    for (auto* collObj2 : candidates)
+    {
+      if (collObj1 == collObj2)
+        continue;
+
+      distancePair(collObj1, collObj2, option, closest);
+
+      if (closest.distance <= option.distanceLowerBound)
+        return reportDistance(closest, option, result);
+    }
+  }
+
+  return reportDistance(closest, option, result);
 }
 
 //==============================================================================
-double DARTCollisionDetector::distance(
-    CollisionGroup* /*group*/,
-    const DistanceOption& /*option*/,
-    DistanceResult* /*result*/)
+bool DARTCollisionDetector::raycast(
+    CollisionGroup* group,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    const RaycastOption& option,
+    RaycastResult* result)
 {
-  dtwarn << "[DARTCollisionDetector::distance] This collision detector does "
-         << "not support (signed) distance queries. Returning 0.0.\n";
+  if (result)
+    result->clear();
+
+  if (!checkGroupValidity(this, group))
+    return false;
 
-  return 0.0;
+  auto casted = static_cast<DARTCollisionGroup*>(group);
+
+  // Only the objects whose bounding boxes the ray passes through can be hit
+  std::vector<CollisionObject*> candidates;
+  if (mUseBroadphase)
+  {
+    casted->updateEngineData();
+    casted->mBroadphase.raycast(from, to, candidates);
+  }
+  else
+  {
+    candidates = casted->mCollisionObjects;
+  }
+
+  auto hasHit = false;
+  RayHit closestHit;
+  closestHit.mFraction = std::numeric_limits<double>::infinity();
+
+  for (auto* object : candidates)
+  {
+    RayHit hit;
+    if (!raycastObject(object, from, to, hit))
+      continue;
+
+    hasHit = true;
+
+    if (!result)
+      return true;
+
+    if (option.mEnableAllHits)
+      result->mRayHits.push_back(hit);
+    else if (hit.mFraction < closestHit.mFraction)
+      closestHit = hit;
+  }
+
+  if (result)
+  {
+    if (hasHit && !option.mEnableAllHits)
+      result->mRayHits.push_back(closestHit);
+
+    if (option.mSortByClosest)
+    {
+      std::sort(
+          result->mRayHits.begin(),
+          result->mRayHits.end(),
+          [](const RayHit& a, const RayHit& b) {
+            return a.mFraction < b.mFraction;
+          });
+    }
+  }
+
+  return hasHit;
 }
 
 //==============================================================================
-double DARTCollisionDetector::distance(
-    CollisionGroup* /*group1*/,
-    CollisionGroup* /*group2*/,
-    const DistanceOption& /*option*/,
-    DistanceResult* /*result*/)
+void DARTCollisionDetector::setUseBroadphase(bool useBroadphase)
 {
-  dtwarn << "[DARTCollisionDetector::distance] This collision detector does "
-         << "not support (signed) distance queries. Returning 0.0.\n";
+  mUseBroadphase = useBroadphase;
+}
 
-  return 0.0;
+//==============================================================================
+bool DARTCollisionDetector::getUseBroadphase() const
+{
+  return mUseBroadphase;
 }
 
 //==============================================================================
-DARTCollisionDetector::DARTCollisionDetector() : CollisionDetector()
+DARTCollisionDetector::DARTCollisionDetector()
+  : CollisionDetector(), mUseBroadphase(true)
 {
   mCollisionObjectManager.reset(new ManagerForSharableCollisionObjects(this));
 }
@@ -356,6 +661,842 @@ bool isClose(
   return (pos1 - pos2).norm() < tol;
 }
 
+//==============================================================================
+/// Everything we need to answer support queries on a convex shape in world
+/// coordinates
+struct ConvexShape
+{
+  const dynamics::Shape* shape;
+  const Eigen::Isometry3s* transform;
+
+  /// The mesh's scale and convex hull, if the shape is a mesh. We hill-climb
+  /// the hull from wherever the last query ended up.
+  Eigen::Vector3s scale;
+  std::shared_ptr<const math::ConvexHull3D> hull;
+  int supportHint;
+};
+
+//==============================================================================
+/// Returns false if we can't compute distances to this kind of shape
+bool makeConvexShape(const CollisionObject* object, ConvexShape& convex)
+{
+  const auto& shape = object->getShape();
+  const auto& shapeType = shape->getType();
+
+  convex.shape = shape.get();
+  convex.transform = &object->getTransform();
+  convex.scale = Eigen::Vector3s::Ones();
+  convex.hull = nullptr;
+  convex.supportHint = 0;
+
+  if (shapeType == dynamics::MeshShape::getStaticType())
+  {
+    const auto* mesh = static_cast<const dynamics::MeshShape*>(shape.get());
+    convex.scale = mesh->getScale();
+    convex.hull = mesh->getConvexHull();
+    return convex.hull != nullptr && convex.hull->getNumVertices() > 0;
+  }
+
+  return shapeType == dynamics::SphereShape::getStaticType()
+         || shapeType == dynamics::EllipsoidShape::getStaticType()
+         || shapeType == dynamics::BoxShape::getStaticType()
+         || shapeType == dynamics::CapsuleShape::getStaticType()
+         || shapeType == dynamics::CylinderShape::getStaticType();
+}
+
+//==============================================================================
+/// Returns the point on the shape farthest along the world direction `dir`
+Eigen::Vector3s computeSupport(ConvexShape& convex, const Eigen::Vector3s& dir)
+{
+  const Eigen::Isometry3s& T = *convex.transform;
+  const Eigen::Vector3s localDir = T.linear().transpose() * dir;
+  const auto& shapeType = convex.shape->getType();
+
+  Eigen::Vector3s local = Eigen::Vector3s::Zero();
+  if (shapeType == dynamics::SphereShape::getStaticType())
+  {
+    const s_t radius
+        = static_cast<const dynamics::SphereShape*>(convex.shape)->getRadius();
+    const s_t norm = localDir.norm();
+    if (norm > 0.0)
+      local = localDir * (radius / norm);
+  }
+  else if (shapeType == dynamics::EllipsoidShape::getStaticType())
+  {
+    // The support point of diag(r) * (unit sphere) is r^2 d / |r d|
+    const Eigen::Vector3s radii
+        = static_cast<const dynamics::EllipsoidShape*>(convex.shape)
+              ->getRadii();
+    const Eigen::Vector3s scaledDir = radii.cwiseProduct(localDir);
+    const s_t norm = scaledDir.norm();
+    if (norm > 0.0)
+      local = radii.cwiseProduct(scaledDir) / norm;
+  }
+  else if (shapeType == dynamics::BoxShape::getStaticType())
+  {
+    const Eigen::Vector3s halfSize
+        = static_cast<const dynamics::BoxShape*>(convex.shape)->getSize()
+          * 0.5;
+    for (int axis = 0; axis < 3; ++axis)
+      local(axis) = localDir(axis) < 0.0 ? -halfSize(axis) : halfSize(axis);
+  }
+  else if (shapeType == dynamics::CapsuleShape::getStaticType())
+  {
+    const auto* capsule
+        = static_cast<const dynamics::CapsuleShape*>(convex.shape);
+    const s_t norm = localDir.norm();
+    if (norm > 0.0)
+      local = localDir * (capsule->getRadius() / norm);
+    local(2) += localDir(2) < 0.0 ? -capsule->getHeight() * 0.5
+                                  : capsule->getHeight() * 0.5;
+  }
+  else if (shapeType == dynamics::CylinderShape::getStaticType())
+  {
+    const auto* cylinder
+        = static_cast<const dynamics::CylinderShape*>(convex.shape);
+    const s_t radialNorm = localDir.head<2>().norm();
+    if (radialNorm > 0.0)
+      local.head<2>()
+          = localDir.head<2>() * (cylinder->getRadius() / radialNorm);
+    local(2) = localDir(2) < 0.0 ? -cylinder->getHeight() * 0.5
+                                 : cylinder->getHeight() * 0.5;
+  }
+  else if (convex.hull != nullptr)
+  {
+    // max over v of (S v) . d is the same as max over v of v . (S d)
+    convex.supportHint = convex.hull->getSupportVertex(
+        convex.scale.cwiseProduct(localDir), convex.supportHint);
+    local = convex.scale.cwiseProduct(
+        convex.hull->getVertex(convex.supportHint));
+  }
+
+  return T * local;
+}
+
+//==============================================================================
+/// A vertex of the GJK simplex, which lives in the Minkowski difference of the
+/// two shapes. We keep the points on each shape it came from, so we can
+/// recover the nearest points at the end.
+struct SimplexVertex
+{
+  Eigen::Vector3s w;
+  Eigen::Vector3s a;
+  Eigen::Vector3s b;
+};
+
+//==============================================================================
+/// This finds the point closest to the origin on the triangle (or degenerate
+/// segment or point) `vertices[0..2]`, and writes the smallest face of the
+/// triangle that contains it to `out`, with barycentric weights. This follows
+/// Ericson's "Real-Time Collision Detection", section 5.1.5.
+void closestOnTriangle(
+    const SimplexVertex& A,
+    const SimplexVertex& B,
+    const SimplexVertex& C,
+    SimplexVertex* out,
+    s_t* lambdas,
+    int& n)
+{
+  const Eigen::Vector3s ab = B.w - A.w;
+  const Eigen::Vector3s ac = C.w - A.w;
+
+  const s_t d1 = -ab.dot(A.w);
+  const s_t d2 = -ac.dot(A.w);
+  if (d1 <= 0.0 && d2 <= 0.0)
+  {
+    out[0] = A;
+    lambdas[0] = 1.0;
+    n = 1;
+    return;
+  }
+
+  const s_t d3 = -ab.dot(B.w);
+  const s_t d4 = -ac.dot(B.w);
+  if (d3 >= 0.0 && d4 <= d3)
+  {
+    out[0] = B;
+    lambdas[0] = 1.0;
+    n = 1;
+    return;
+  }
+
+  const s_t vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+  {
+    const s_t v = d1 / (d1 - d3);
+    out[0] = A;
+    out[1] = B;
+    lambdas[0] = 1.0 - v;
+    lambdas[1] = v;
+    n = 2;
+    return;
+  }
+
+  const s_t d5 = -ab.dot(C.w);
+  const s_t d6 = -ac.dot(C.w);
+  if (d6 >= 0.0 && d5 <= d6)
+  {
+    out[0] = C;
+    lambdas[0] = 1.0;
+    n = 1;
+    return;
+  }
+
+  const s_t vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+  {
+    const s_t w = d2 / (d2 - d6);
+    out[0] = A;
+    out[1] = C;
+    lambdas[0] = 1.0 - w;
+    lambdas[1] = w;
+    n = 2;
+    return;
+  }
+
+  const s_t va = d3 * d6 - d5 * d4;
+  if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+  {
+    const s_t w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    out[0] = B;
+    out[1] = C;
+    lambdas[0] = 1.0 - w;
+    lambdas[1] = w;
+    n = 2;
+    return;
+  }
+
+  const s_t denom = 1.0 / (va + vb + vc);
+  const s_t v = vb * denom;
+  const s_t w = vc * denom;
+  out[0] = A;
+  out[1] = B;
+  out[2] = C;
+  lambdas[0] = 1.0 - v - w;
+  lambdas[1] = v;
+  lambdas[2] = w;
+  n = 3;
+}
+
+//==============================================================================
+/// This shrinks `simplex` to the smallest face containing its point closest to
+/// the origin, and writes that point's barycentric weights to `lambdas`.
+/// Returns true if the simplex is a tetrahedron containing the origin.
+bool reduceSimplex(SimplexVertex* simplex, s_t* lambdas, int& n)
+{
+  if (n == 1)
+  {
+    lambdas[0] = 1.0;
+    return false;
+  }
+
+  if (n == 2)
+  {
+    const Eigen::Vector3s ab = simplex[1].w - simplex[0].w;
+    const s_t t = -simplex[0].w.dot(ab);
+    const s_t denom = ab.squaredNorm();
+    if (t <= 0.0)
+    {
+      lambdas[0] = 1.0;
+      n = 1;
+    }
+    else if (t >= denom)
+    {
+      simplex[0] = simplex[1];
+      lambdas[0] = 1.0;
+      n = 1;
+    }
+    else
+    {
+      lambdas[0] = 1.0 - t / denom;
+      lambdas[1] = t / denom;
+    }
+    return false;
+  }
+
+  if (n == 3)
+  {
+    SimplexVertex reduced[3];
+    closestOnTriangle(simplex[0], simplex[1], simplex[2], reduced, lambdas, n);
+    std::copy(reduced, reduced + n, simplex);
+    return false;
+  }
+
+  // For a tetrahedron, the closest point is on one of the faces the origin is
+  // outside of. Faces of a flat tetrahedron don't have a well defined outside,
+  // so we check all of those.
+  static const int faces[4][4]
+      = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};
+  SimplexVertex best[3];
+  s_t bestLambdas[3];
+  int bestN = 0;
+  s_t bestDistance = std::numeric_limits<s_t>::infinity();
+  for (const auto& face : faces)
+  {
+    const Eigen::Vector3s& a = simplex[face[0]].w;
+    const Eigen::Vector3s normal
+        = (simplex[face[1]].w - a).cross(simplex[face[2]].w - a);
+    const s_t signOrigin = -a.dot(normal);
+    const s_t signOpposite = (simplex[face[3]].w - a).dot(normal);
+    const s_t flatness = 1e-10 * normal.norm()
+                         * (simplex[face[3]].w - a).norm();
+    if (signOrigin * signOpposite >= 0.0
+        && std::abs(signOpposite) > flatness)
+      continue;
+
+    SimplexVertex reduced[3];
+    s_t reducedLambdas[3];
+    int reducedN = 0;
+    closestOnTriangle(
+        simplex[face[0]],
+        simplex[face[1]],
+        simplex[face[2]],
+        reduced,
+        reducedLambdas,
+        reducedN);
+    Eigen::Vector3s closest = Eigen::Vector3s::Zero();
+    for (int i = 0; i < reducedN; ++i)
+      closest += reducedLambdas[i] * reduced[i].w;
+    if (closest.squaredNorm() < bestDistance)
+    {
+      bestDistance = closest.squaredNorm();
+      std::copy(reduced, reduced + reducedN, best);
+      std::copy(reducedLambdas, reducedLambdas + reducedN, bestLambdas);
+      bestN = reducedN;
+    }
+  }
+
+  if (bestN == 0)
+  {
+    // The origin is inside, so solve for its barycentric weights directly
+    Eigen::Matrix3s edges;
+    edges.col(0) = simplex[1].w - simplex[0].w;
+    edges.col(1) = simplex[2].w - simplex[0].w;
+    edges.col(2) = simplex[3].w - simplex[0].w;
+    const Eigen::Vector3s weights = edges.colPivHouseholderQr().solve(
+        -simplex[0].w);
+    lambdas[0] = 1.0 - weights.sum();
+    lambdas[1] = weights(0);
+    lambdas[2] = weights(1);
+    lambdas[3] = weights(2);
+    return true;
+  }
+
+  std::copy(best, best + bestN, simplex);
+  std::copy(bestLambdas, bestLambdas + bestN, lambdas);
+  n = bestN;
+  return false;
+}
+
+//==============================================================================
+/// This runs GJK to find the distance between two convex shapes, and the
+/// nearest points on each. Overlapping shapes get a distance of 0. Returns
+/// false if either shape isn't one we can compute distances to.
+bool distanceObjects(
+    const CollisionObject* o1,
+    const CollisionObject* o2,
+    s_t& distance,
+    Eigen::Vector3s& point1,
+    Eigen::Vector3s& point2)
+{
+  ConvexShape shape1;
+  ConvexShape shape2;
+  if (!makeConvexShape(o1, shape1) || !makeConvexShape(o2, shape2))
+    return false;
+
+  const int maxIterations = 64;
+  const s_t relativeTolerance = 1e-10;
+
+  auto makeVertex = [&](const Eigen::Vector3s& dir) {
+    SimplexVertex vertex;
+    vertex.a = computeSupport(shape1, dir);
+    vertex.b = computeSupport(shape2, -dir);
+    vertex.w = vertex.a - vertex.b;
+    return vertex;
+  };
+
+  Eigen::Vector3s v = o1->getTransform().translation()
+                      - o2->getTransform().translation();
+  if (v.squaredNorm() == 0.0)
+    v = Eigen::Vector3s::UnitX();
+
+  SimplexVertex simplex[4];
+  s_t lambdas[4];
+  int n = 1;
+  simplex[0] = makeVertex(-v);
+  lambdas[0] = 1.0;
+  v = simplex[0].w;
+
+  bool overlapping = false;
+  for (int iteration = 0; iteration < maxIterations; ++iteration)
+  {
+    const s_t vv = v.squaredNorm();
+    if (vv == 0.0)
+    {
+      overlapping = true;
+      break;
+    }
+
+    // Stop once no support point gets meaningfully closer to the origin
+    const SimplexVertex next = makeVertex(-v);
+    if (vv - v.dot(next.w) <= relativeTolerance * vv)
+      break;
+
+    bool repeated = false;
+    for (int i = 0; i < n; ++i)
+    {
+      if ((simplex[i].w - next.w).squaredNorm() <= relativeTolerance * vv)
+        repeated = true;
+    }
+    if (repeated)
+      break;
+
+    SimplexVertex previous[4];
+    s_t previousLambdas[4];
+    const int previousN = n;
+    std::copy(simplex, simplex + n, previous);
+    std::copy(lambdas, lambdas + n, previousLambdas);
+
+    simplex[n++] = next;
+    if (reduceSimplex(simplex, lambdas, n))
+    {
+      overlapping = true;
+      break;
+    }
+
+    Eigen::Vector3s closest = Eigen::Vector3s::Zero();
+    for (int i = 0; i < n; ++i)
+      closest += lambdas[i] * simplex[i].w;
+
+    // Rounding can stop us from making progress, in which case the last
+    // simplex was as good as it gets
+    if (closest.squaredNorm() >= vv)
+    {
+      std::copy(previous, previous + previousN, simplex);
+      std::copy(previousLambdas, previousLambdas + previousN, lambdas);
+      n = previousN;
+      break;
+    }
+    v = closest;
+  }
+
+  point1.setZero();
+  point2.setZero();
+  for (int i = 0; i < n; ++i)
+  {
+    point1 += lambdas[i] * simplex[i].a;
+    point2 += lambdas[i] * simplex[i].b;
+  }
+
+  if (overlapping)
+  {
+    distance = 0.0;
+    point2 = point1;
+  }
+  else
+  {
+    distance = (point1 - point2).norm();
+  }
+  return true;
+}
+
+//==============================================================================
+void distancePair(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const DistanceOption& option,
+    ClosestPair& closest)
+{
+  if (option.distanceFilter && !option.distanceFilter->needDistance(o1, o2))
+    return;
+
+  s_t distance;
+  Eigen::Vector3s point1;
+  Eigen::Vector3s point2;
+  if (!distanceObjects(o1, o2, distance, point1, point2))
+  {
+    static std::atomic<bool> warnedUnsupportedShape(false);
+    if (!warnedUnsupportedShape.exchange(true))
+    {
+      dtwarn << "[DARTCollisionDetector::distance] Distances are only "
+             << "computed between spheres, ellipsoids, boxes, capsules, "
+             << "cylinders and meshes. Pairs including shapes of type ["
+             << o1->getShape()->getType() << "] or ["
+             << o2->getShape()->getType() << "] (and any other unsupported "
+             << "types) are skipped.\n";
+    }
+    return;
+  }
+
+  if (distance < closest.distance)
+  {
+    closest.distance = distance;
+    closest.object1 = o1;
+    closest.object2 = o2;
+    closest.point1 = point1;
+    closest.point2 = point2;
+  }
+}
+
+//==============================================================================
+void findCloseObjects(
+    const DARTBroadphase& broadphase,
+    const CollisionObject* object,
+    s_t distance,
+    std::vector<CollisionObject*>& objects)
+{
+  Eigen::Vector3s min;
+  Eigen::Vector3s max;
+  DARTBroadphase::computeAabb(object, 0.0, min, max);
+  broadphase.queryAabb(min, max, distance, objects);
+}
+
+//==============================================================================
+double reportDistance(
+    const ClosestPair& closest,
+    const DistanceOption& option,
+    DistanceResult* result)
+{
+  if (!closest.object1)
+    return 0.0;
+
+  const double minDistance = std::max(
+      static_cast<double>(closest.distance), option.distanceLowerBound);
+
+  if (result)
+  {
+    result->minDistance = minDistance;
+    result->unclampedMinDistance = static_cast<double>(closest.distance);
+    result->shapeFrame1 = closest.object1->getShapeFrame();
+    result->shapeFrame2 = closest.object2->getShapeFrame();
+    if (option.enableNearestPoints)
+    {
+      result->nearestPoint1 = closest.point1;
+      result->nearestPoint2 = closest.point2;
+    }
+  }
+
+  return minDistance;
+}
+
+//==============================================================================
+/// Finds where the segment localFrom + t * dir, for t in [0, 1], enters the
+/// sphere of `radius` centered at `center`
+bool enterSphere(
+    const Eigen::Vector3s& localFrom,
+    const Eigen::Vector3s& dir,
+    const Eigen::Vector3s& center,
+    s_t radius,
+    s_t& t)
+{
+  const Eigen::Vector3s offset = localFrom - center;
+  const s_t a = dir.squaredNorm();
+  const s_t b = 2.0 * offset.dot(dir);
+  const s_t c = offset.squaredNorm() - radius * radius;
+  const s_t discriminant = b * b - 4.0 * a * c;
+  if (a <= 0.0 || discriminant < 0.0)
+    return false;
+  t = (-b - std::sqrt(discriminant)) / (2.0 * a);
+  return t >= 0.0 && t <= 1.0;
+}
+
+//==============================================================================
+/// Finds where the segment localFrom + t * dir, for t in [0, 1], enters the
+/// infinitely long cylinder of `radius` around the Z axis
+bool enterInfiniteCylinder(
+    const Eigen::Vector3s& localFrom,
+    const Eigen::Vector3s& dir,
+    s_t radius,
+    s_t& t)
+{
+  const s_t a = dir.head<2>().squaredNorm();
+  const s_t b = 2.0 * localFrom.head<2>().dot(dir.head<2>());
+  const s_t c = localFrom.head<2>().squaredNorm() - radius * radius;
+  const s_t discriminant = b * b - 4.0 * a * c;
+  if (a <= 0.0 || discriminant < 0.0)
+    return false;
+  t = (-b - std::sqrt(discriminant)) / (2.0 * a);
+  return t >= 0.0 && t <= 1.0;
+}
+
+//==============================================================================
+bool raycastObject(
+    const CollisionObject* object,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    RayHit& hit)
+{
+  const auto& shape = object->getShape();
+  const auto& shapeType = shape->getType();
+  const Eigen::Isometry3s& T = object->getTransform();
+
+  // Work in the shape's local frame
+  const Eigen::Vector3s localFrom = T.inverse() * from;
+  const Eigen::Vector3s dir = T.linear().transpose() * (to - from);
+
+  // Spheres are just ellipsoids with equal radii
+  Eigen::Vector3s radii = Eigen::Vector3s::Zero();
+  if (shapeType == dynamics::SphereShape::getStaticType())
+  {
+    radii.setConstant(
+        static_cast<const dynamics::SphereShape*>(shape.get())->getRadius());
+  }
+  else if (shapeType == dynamics::EllipsoidShape::getStaticType())
+  {
+    radii = static_cast<const dynamics::EllipsoidShape*>(shape.get())
+                ->getRadii();
+  }
+
+  if (radii.minCoeff() > 0.0)
+  {
+    // Scale the ellipsoid to the unit sphere and solve
+    // |scaledFrom + t * scaledDir| = 1 for the entry point. Rays that start
+    // inside the ellipsoid don't count as hitting it.
+    const Eigen::Vector3s scaledFrom = localFrom.cwiseQuotient(radii);
+    const Eigen::Vector3s scaledDir = dir.cwiseQuotient(radii);
+    const s_t a = scaledDir.squaredNorm();
+    const s_t b = 2.0 * scaledFrom.dot(scaledDir);
+    const s_t c = scaledFrom.squaredNorm() - 1.0;
+    if (a <= 0.0 || c < 0.0)
+      return false;
+    const s_t discriminant = b * b - 4.0 * a * c;
+    if (discriminant < 0.0)
+      return false;
+    const s_t t = (-b - std::sqrt(discriminant)) / (2.0 * a);
+    if (t < 0.0 || t > 1.0)
+      return false;
+
+    const Eigen::Vector3s localPoint = localFrom + t * dir;
+    hit.mCollisionObject = object;
+    hit.mFraction = static_cast<double>(t);
+    hit.mPoint = T * localPoint;
+    // The gradient of the implicit surface sum((x_i / r_i)^2) = 1
+    hit.mNormal = T.linear()
+                  * localPoint.cwiseQuotient(radii.cwiseProduct(radii))
+                        .normalized();
+    return true;
+  }
+
+  if (shapeType == dynamics::BoxShape::getStaticType())
+  {
+    const Eigen::Vector3s halfSize
+        = static_cast<const dynamics::BoxShape*>(shape.get())->getSize() * 0.5;
+
+    // Slab test, keeping track of which face we entered through
+    s_t tEnter = 0.0;
+    s_t tExit = 1.0;
+    int enterAxis = -1;
+    s_t enterSign = 0.0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (std::abs(dir(axis)) < std::numeric_limits<s_t>::epsilon())
+      {
+        if (std::abs(localFrom(axis)) > halfSize(axis))
+          return false;
+        continue;
+      }
+      s_t t1 = (-halfSize(axis) - localFrom(axis)) / dir(axis);
+      s_t t2 = (halfSize(axis) - localFrom(axis)) / dir(axis);
+      s_t sign = -1.0;
+      if (t1 > t2)
+      {
+        std::swap(t1, t2);
+        sign = 1.0;
+      }
+      if (t1 > tEnter)
+      {
+        tEnter = t1;
+        enterAxis = axis;
+        enterSign = sign;
+      }
+      tExit = std::min(tExit, t2);
+      if (tEnter > tExit)
+        return false;
+    }
+
+    // Rays that start inside the box don't count as hitting it
+    if (enterAxis < 0)
+      return false;
+
+    Eigen::Vector3s localNormal = Eigen::Vector3s::Zero();
+    localNormal(enterAxis) = enterSign;
+    hit.mCollisionObject = object;
+    hit.mFraction = static_cast<double>(tEnter);
+    hit.mPoint = T * (localFrom + tEnter * dir);
+    hit.mNormal = T.linear() * localNormal;
+    return true;
+  }
+
+  if (shapeType == dynamics::CapsuleShape::getStaticType())
+  {
+    const auto* capsule
+        = static_cast<const dynamics::CapsuleShape*>(shape.get());
+    const s_t radius = capsule->getRadius();
+    const s_t halfHeight = capsule->getHeight() * 0.5;
+
+    // Rays that start inside the capsule don't count as hitting it
+    const s_t closestZ
+        = std::max(-halfHeight, std::min(halfHeight, localFrom(2)));
+    if ((localFrom - Eigen::Vector3s(0, 0, closestZ)).norm() <= radius)
+      return false;
+
+    // We start outside, so the first surface we enter is the one we hit
+    s_t bestT = std::numeric_limits<s_t>::infinity();
+    Eigen::Vector3s localNormal = Eigen::Vector3s::Zero();
+    s_t t;
+    if (enterInfiniteCylinder(localFrom, dir, radius, t)
+        && std::abs(localFrom(2) + t * dir(2)) <= halfHeight)
+    {
+      bestT = t;
+      localNormal = localFrom + t * dir;
+      localNormal(2) = 0.0;
+    }
+    for (s_t side : {-1.0, 1.0})
+    {
+      const Eigen::Vector3s center(0, 0, side * halfHeight);
+      if (enterSphere(localFrom, dir, center, radius, t) && t < bestT
+          && side * (localFrom(2) + t * dir(2) - center(2)) >= 0.0)
+      {
+        bestT = t;
+        localNormal = localFrom + t * dir - center;
+      }
+    }
+    if (bestT > 1.0)
+      return false;
+
+    hit.mCollisionObject = object;
+    hit.mFraction = static_cast<double>(bestT);
+    hit.mPoint = T * (localFrom + bestT * dir);
+    hit.mNormal = T.linear() * localNormal.normalized();
+    return true;
+  }
+
+  if (shapeType == dynamics::CylinderShape::getStaticType())
+  {
+    const auto* cylinder
+        = static_cast<const dynamics::CylinderShape*>(shape.get());
+    const s_t radius = cylinder->getRadius();
+    const s_t halfHeight = cylinder->getHeight() * 0.5;
+
+    // Rays that start inside the cylinder don't count as hitting it
+    if (localFrom.head<2>().norm() <= radius
+        && std::abs(localFrom(2)) <= halfHeight)
+      return false;
+
+    // We start outside, so the first surface we enter is the one we hit
+    s_t bestT = std::numeric_limits<s_t>::infinity();
+    Eigen::Vector3s localNormal = Eigen::Vector3s::Zero();
+    s_t t;
+    if (enterInfiniteCylinder(localFrom, dir, radius, t)
+        && std::abs(localFrom(2) + t * dir(2)) <= halfHeight)
+    {
+      bestT = t;
+      localNormal = localFrom + t * dir;
+      localNormal(2) = 0.0;
+    }
+    if (std::abs(dir(2)) > std::numeric_limits<s_t>::epsilon())
+    {
+      for (s_t side : {-1.0, 1.0})
+      {
+        t = (side * halfHeight - localFrom(2)) / dir(2);
+        if (t < 0.0 || t > 1.0 || t >= bestT)
+          continue;
+        if ((localFrom + t * dir).head<2>().norm() > radius)
+          continue;
+        bestT = t;
+        localNormal = Eigen::Vector3s(0, 0, side);
+      }
+    }
+    if (bestT > 1.0)
+      return false;
+
+    hit.mCollisionObject = object;
+    hit.mFraction = static_cast<double>(bestT);
+    hit.mPoint = T * (localFrom + bestT * dir);
+    hit.mNormal = T.linear() * localNormal.normalized();
+    return true;
+  }
+
+  if (shapeType == dynamics::MeshShape::getStaticType())
+  {
+    const auto* mesh = static_cast<const dynamics::MeshShape*>(shape.get());
+    const aiScene* scene = mesh->getMesh();
+    if (scene == nullptr)
+      return false;
+    const Eigen::Vector3s& scale = mesh->getScale();
+    auto vertex = [&](const aiMesh* m, unsigned int index) {
+      return Eigen::Vector3s(
+          m->mVertices[index].x * scale(0),
+          m->mVertices[index].y * scale(1),
+          m->mVertices[index].z * scale(2));
+    };
+
+    // Moller-Trumbore against every triangle. Meshes don't have to be closed,
+    // so we can't tell if we start inside, and count hits from either side.
+    s_t bestT = std::numeric_limits<s_t>::infinity();
+    Eigen::Vector3s localNormal = Eigen::Vector3s::Zero();
+    for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+    {
+      const aiMesh* m = scene->mMeshes[i];
+      for (unsigned int j = 0; j < m->mNumFaces; ++j)
+      {
+        const aiFace& face = m->mFaces[j];
+        if (face.mNumIndices != 3)
+          continue;
+        const Eigen::Vector3s v0 = vertex(m, face.mIndices[0]);
+        const Eigen::Vector3s edge1 = vertex(m, face.mIndices[1]) - v0;
+        const Eigen::Vector3s edge2 = vertex(m, face.mIndices[2]) - v0;
+
+        const Eigen::Vector3s p = dir.cross(edge2);
+        const s_t det = edge1.dot(p);
+        if (std::abs(det) <= std::numeric_limits<s_t>::epsilon()
+                                 * edge1.norm() * edge2.norm() * dir.norm())
+          continue;
+        const s_t invDet = 1.0 / det;
+        const Eigen::Vector3s s = localFrom - v0;
+        const s_t u = s.dot(p) * invDet;
+        if (u < 0.0 || u > 1.0)
+          continue;
+        const Eigen::Vector3s q = s.cross(edge1);
+        const s_t v = dir.dot(q) * invDet;
+        if (v < 0.0 || u + v > 1.0)
+          continue;
+        const s_t t = edge2.dot(q) * invDet;
+        if (t < 0.0 || t > 1.0 || t >= bestT)
+          continue;
+        bestT = t;
+        localNormal = edge1.cross(edge2);
+      }
+    }
+    if (bestT > 1.0)
+      return false;
+
+    // Report the normal facing back along the ray
+    localNormal.normalize();
+    if (localNormal.dot(dir) > 0.0)
+      localNormal = -localNormal;
+
+    hit.mCollisionObject = object;
+    hit.mFraction = static_cast<double>(bestT);
+    hit.mPoint = T * (localFrom + bestT * dir);
+    hit.mNormal = T.linear() * localNormal;
+    return true;
+  }
+
+  // We don't have exact ray tests for the other shape types, and reporting
+  // hits against their bounding boxes would give wrong points and normals, so
+  // rays pass straight through them. Say so once, so this isn't silent.
+  static std::atomic<bool> warnedUnsupportedShape(false);
+  if (!warnedUnsupportedShape.exchange(true))
+  {
+    dtwarn << "[DARTCollisionDetector::raycast] Rays are only tested against "
+           << "spheres, ellipsoids, boxes, capsules, cylinders and meshes. "
+           << "Shapes of type [" << shapeType << "] (and any other "
+           << "unsupported types) are never hit.\n";
+  }
+  return false;
+}
+
 //==============================================================================
 void postProcess(
     CollisionObject* o1,
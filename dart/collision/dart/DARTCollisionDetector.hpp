@@ -74,19 +74,49 @@ public:
       const CollisionOption& option = CollisionOption(false, 1u, nullptr),
       CollisionResult* result = nullptr) override;
 
-  // Documentation inherited
+  /// Computes the smallest distance between any two objects in the group with
+  /// GJK. Spheres, ellipsoids, boxes, capsules and cylinders are exact, and
+  /// meshes are treated as their convex hulls. Overlapping objects are reported
+  /// at a distance of 0 rather than a negative penetration depth, and objects
+  /// of any other shape type are skipped. With the broadphase on, we only
+  /// check the objects whose bounding boxes are closer than the best distance
+  /// found so far.
   double distance(
       CollisionGroup* group,
       const DistanceOption& option = DistanceOption(false, 0.0, nullptr),
       DistanceResult* result = nullptr) override;
 
-  // Documentation inherited
+  /// Computes the smallest distance between an object in group1 and an object
+  /// in group2. This has the same limits as the single group version.
   double distance(
       CollisionGroup* group1,
       CollisionGroup* group2,
       const DistanceOption& option = DistanceOption(false, 0.0, nullptr),
       DistanceResult* result = nullptr) override;
 
+  /// Performs raycast to a collision group. Rays are tested exactly against
+  /// spheres, ellipsoids, boxes, capsules, cylinders and the triangles of
+  /// meshes. Rays that start inside a convex shape don't hit it, but since
+  /// meshes may not be closed, a ray hits the first mesh triangle it crosses
+  /// from either side. Other shape types (planes, soft meshes, etc.) are never
+  /// hit, and the first time one is skipped we print a warning.
+  bool raycast(
+      CollisionGroup* group,
+      const Eigen::Vector3s& from,
+      const Eigen::Vector3s& to,
+      const RaycastOption& option = RaycastOption(),
+      RaycastResult* result = nullptr) override;
+
+  /// By default, collide(), distance() and raycast() use each group's
+  /// sweep-and-prune broadphase to skip pairs of objects whose bounding boxes
+  /// don't overlap (or, for distance(), are too far apart). Turning this off
+  /// falls back to testing every pair of objects, which is mostly useful for
+  /// benchmarking and debugging.
+  void setUseBroadphase(bool useBroadphase);
+
+  /// Returns true if collide(), distance() and raycast() use the broadphase
+  bool getUseBroadphase() const;
+
 protected:
 
   /// Constructor
@@ -99,6 +129,10 @@ protected:
   // Documentation inherited
   void refreshCollisionObject(CollisionObject* object) override;
 
+  /// If false, we check every pair of objects instead of only the pairs whose
+  /// bounding boxes overlap
+  bool mUseBroadphase;
+
 private:
   static Registrar<DARTCollisionDetector> mRegistrar;
 };
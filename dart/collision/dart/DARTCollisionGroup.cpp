@@ -58,6 +58,7 @@ void DARTCollisionGroup::addCollisionObjectToEngine(CollisionObject* object)
       == mCollisionObjects.end())
   {
     mCollisionObjects.push_back(object);
+    mBroadphase.addObject(object);
   }
 }
 
@@ -75,18 +76,24 @@ void DARTCollisionGroup::removeCollisionObjectFromEngine(
 {
   mCollisionObjects.erase(
       std::remove(mCollisionObjects.begin(), mCollisionObjects.end(), object));
+  mBroadphase.removeObject(object);
+  // A new object could be allocated at the same address, and inherit the
+  // removed object's warm starts
+  mCollisionContext.clear();
 }
 
 //==============================================================================
 void DARTCollisionGroup::removeAllCollisionObjectsFromEngine()
 {
   mCollisionObjects.clear();
+  mBroadphase.clear();
+  mCollisionContext.clear();
 }
 
 //==============================================================================
 void DARTCollisionGroup::updateCollisionGroupEngineData()
 {
-  // Do nothing
+  mBroadphase.update();
 }
 
 }  // namespace collision
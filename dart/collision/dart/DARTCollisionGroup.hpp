@@ -34,6 +34,8 @@
 #define DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 
 #include "dart/collision/CollisionGroup.hpp"
+#include "dart/collision/dart/DARTBroadphase.hpp"
+#include "dart/collision/dart/DARTCollisionContext.hpp"
 
 namespace dart {
 namespace collision {
@@ -78,6 +80,20 @@ protected:
   /// CollisionObjects added to this DARTCollisionGroup
   std::vector<CollisionObject*> mCollisionObjects;
 
+  /// Sweep-and-prune over mCollisionObjects, kept in sync as objects are added
+  /// and removed, and re-sorted by the detector before each query
+  DARTBroadphase mBroadphase;
+
+  /// Scratch space for the broadphase's overlapping pairs, kept around so we
+  /// don't reallocate it on every collide() call
+  std::vector<DARTBroadphase::Pair> mOverlappingPairs;
+
+  /// The libccd warm start state for pairs of objects collided through this
+  /// group. The detector binds this to the calling thread during collide(), so
+  /// separate groups can be collided on separate threads without sharing any
+  /// narrowphase state.
+  DARTCollisionContext mCollisionContext;
+
 };
 
 }  // namespace collision
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/common/MemoryMappedFile.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include "dart/common/Console.hpp"
+#include "dart/common/Platform.hpp"
+
+#if DART_OS_LINUX || DART_OS_MACOS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dart {
+namespace common {
+
+//==============================================================================
+MemoryMappedFile::MemoryMappedFile(const std::string& path)
+  : mPath(path), mData(nullptr), mSize(0)
+{
+#if DART_OS_LINUX || DART_OS_MACOS
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    dtwarn << "[MemoryMappedFile::constructor] Failed opening file '" << path
+           << "' for reading: " << std::strerror(errno) << "\n";
+    return;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) == -1)
+  {
+    dtwarn << "[MemoryMappedFile::constructor] Failed getting the size of '"
+           << path << "': " << std::strerror(errno) << "\n";
+    ::close(fd);
+    return;
+  }
+
+  if (info.st_size <= 0)
+  {
+    dtwarn << "[MemoryMappedFile::constructor] Refusing to map empty file '"
+           << path << "'\n";
+    ::close(fd);
+    return;
+  }
+
+  void* mapped = ::mmap(
+      nullptr,
+      static_cast<std::size_t>(info.st_size),
+      PROT_READ,
+      MAP_PRIVATE,
+      fd,
+      0);
+  // The mapping holds its own reference to the file, so we can close the
+  // descriptor right away
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+  {
+    dtwarn << "[MemoryMappedFile::constructor] Failed mapping file '" << path
+           << "': " << std::strerror(errno) << "\n";
+    return;
+  }
+
+  mData = static_cast<const char*>(mapped);
+  mSize = static_cast<std::size_t>(info.st_size);
+#else
+  dtwarn << "[MemoryMappedFile::constructor] Memory mapped files are not "
+         << "supported on this platform, so '" << path
+         << "' will not be mapped\n";
+#endif
+}
+
+//==============================================================================
+MemoryMappedFile::~MemoryMappedFile()
+{
+#if DART_OS_LINUX || DART_OS_MACOS
+  if (mData == nullptr)
+    return;
+
+  if (::munmap(const_cast<char*>(mData), mSize) == -1)
+  {
+    dtwarn << "[MemoryMappedFile::destructor] Failed unmapping file '" << mPath
+           << "': " << std::strerror(errno) << "\n";
+  }
+#endif
+}
+
+//==============================================================================
+bool MemoryMappedFile::isGood() const
+{
+  return mData != nullptr;
+}
+
+//==============================================================================
+std::size_t MemoryMappedFile::getSize() const
+{
+  return mSize;
+}
+
+//==============================================================================
+const char* MemoryMappedFile::getData() const
+{
+  return mData;
+}
+
+//==============================================================================
+const char* MemoryMappedFile::getRange(std::size_t offset, std::size_t size) const
+{
+  if (mData == nullptr || offset > mSize || size > mSize - offset)
+    return nullptr;
+  return mData + offset;
+}
+
+} // namespace common
+} // namespace dart
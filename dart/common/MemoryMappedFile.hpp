@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COMMON_MEMORYMAPPEDFILE_HPP_
+#define DART_COMMON_MEMORYMAPPEDFILE_HPP_
+
+#include <cstddef>
+#include <string>
+
+namespace dart {
+namespace common {
+
+/// MemoryMappedFile is a RAII object wrapping a read-only memory map of an
+/// entire file. The mapping is created once in the constructor and released in
+/// the destructor, so readers can hand out pointers into the mapped pages
+/// instead of opening the file and copying bytes into a fresh buffer on every
+/// access.
+///
+/// Memory mapping is only supported on POSIX platforms. On other platforms
+/// isGood() will always return false, and callers are expected to fall back to
+/// regular buffered reads.
+class MemoryMappedFile
+{
+public:
+  explicit MemoryMappedFile(const std::string& path);
+  virtual ~MemoryMappedFile();
+
+  MemoryMappedFile(const MemoryMappedFile& other) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+
+  /// Returns true if the file was opened and mapped successfully.
+  bool isGood() const;
+
+  /// Returns the size of the mapped file, in bytes.
+  std::size_t getSize() const;
+
+  /// Returns a pointer to the first byte of the mapped file, or nullptr if
+  /// the mapping failed.
+  const char* getData() const;
+
+  /// Returns a pointer to `size` bytes starting at `offset` into the file, or
+  /// nullptr if that range does not lie entirely within the mapped file.
+  const char* getRange(std::size_t offset, std::size_t size) const;
+
+private:
+  std::string mPath;
+  const char* mData;
+  std::size_t mSize;
+};
+
+} // namespace common
+} // namespace dart
+
+#endif // ifndef DART_COMMON_MEMORYMAPPEDFILE_HPP_
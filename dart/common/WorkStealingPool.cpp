@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/common/WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+namespace dart {
+namespace common {
+
+namespace {
+
+//==============================================================================
+// The pool that getCurrentPool() returns on this thread, if it's been bound by
+// a ScopedPool or this thread is a pool worker. This is weak, so that workers
+// don't keep their own pool alive.
+thread_local std::weak_ptr<WorkStealingPool> tCurrentPool;
+
+double secondsSince(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+//==============================================================================
+/// This is the shared bookkeeping for a single parallelFor() call. It lives on
+/// the stack of the calling thread, which doesn't return until every chunk has
+/// finished with it.
+struct WorkStealingPool::Loop
+{
+  const std::function<void(int, int, int)>* body;
+  // Only workers with an index below this may run chunks of this loop
+  int numWorkers;
+  // Chunks that are still sitting in a deque, waiting to be picked up
+  std::atomic<int> unclaimed;
+  // Chunks that haven't finished running yet. Guarded by `mutex`.
+  int remaining;
+  // Time spent in the body on each slot. Each slot is only ever written by a
+  // single thread.
+  std::vector<double> slotBusySeconds;
+  std::atomic<long> numSteals;
+
+  std::mutex mutex;
+  std::condition_variable done;
+  std::exception_ptr error;
+};
+
+//==============================================================================
+WorkStealingPool::Stats WorkStealingPool::Stats::since(
+    const Stats& earlier) const
+{
+  Stats diff;
+  diff.numLoops = numLoops - earlier.numLoops;
+  diff.numChunks = numChunks - earlier.numChunks;
+  diff.numSteals = numSteals - earlier.numSteals;
+  diff.wallSeconds = wallSeconds - earlier.wallSeconds;
+  diff.busySeconds = busySeconds - earlier.busySeconds;
+  diff.overheadSeconds = overheadSeconds - earlier.overheadSeconds;
+  return diff;
+}
+
+//==============================================================================
+WorkStealingPool::WorkStealingPool(int numThreads)
+  : mNumThreads(std::max(0, numThreads)), mGeneration(0), mRunning(true)
+{
+  for (int i = 0; i < mNumThreads; i++)
+  {
+    mWorkers.push_back(std::make_unique<Worker>());
+  }
+  // Only start the threads once every deque exists, since workers steal from
+  // each other straight away
+  for (int i = 0; i < mNumThreads; i++)
+  {
+    mWorkers[i]->thread = std::thread(&WorkStealingPool::workerLoop, this, i);
+  }
+}
+
+//==============================================================================
+WorkStealingPool::~WorkStealingPool()
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mRunning = false;
+  }
+  mWorkAvailable.notify_all();
+  for (auto& worker : mWorkers)
+  {
+    worker->thread.join();
+  }
+}
+
+//==============================================================================
+static std::mutex& getGlobalPoolMutex()
+{
+  static std::mutex globalPoolMutex;
+  return globalPoolMutex;
+}
+
+//==============================================================================
+static std::shared_ptr<WorkStealingPool>& getGlobalPoolInstance()
+{
+  static std::shared_ptr<WorkStealingPool> globalPool;
+  return globalPool;
+}
+
+//==============================================================================
+std::shared_ptr<WorkStealingPool> WorkStealingPool::getGlobalPool()
+{
+  std::unique_lock<std::mutex> lock(getGlobalPoolMutex());
+  std::shared_ptr<WorkStealingPool>& pool = getGlobalPoolInstance();
+  if (!pool)
+  {
+    int numThreads = std::thread::hardware_concurrency();
+    if (numThreads <= 0)
+    {
+      numThreads = 4;
+    }
+    pool = std::make_shared<WorkStealingPool>(numThreads);
+  }
+  return pool;
+}
+
+//==============================================================================
+std::shared_ptr<WorkStealingPool> WorkStealingPool::getCurrentPool()
+{
+  std::shared_ptr<WorkStealingPool> pool = tCurrentPool.lock();
+  if (pool)
+  {
+    return pool;
+  }
+  return getGlobalPool();
+}
+
+//==============================================================================
+WorkStealingPool::ScopedPool::ScopedPool(std::shared_ptr<WorkStealingPool> pool)
+  : mPool(pool), mPrevious(tCurrentPool)
+{
+  tCurrentPool = mPool;
+}
+
+//==============================================================================
+WorkStealingPool::ScopedPool::~ScopedPool()
+{
+  tCurrentPool = mPrevious;
+}
+
+//==============================================================================
+void WorkStealingPool::setGlobalNumThreads(int numThreads)
+{
+  std::shared_ptr<WorkStealingPool> oldPool;
+  {
+    std::unique_lock<std::mutex> lock(getGlobalPoolMutex());
+    std::shared_ptr<WorkStealingPool>& pool = getGlobalPoolInstance();
+    if (pool && pool->getNumThreads() == std::max(0, numThreads))
+    {
+      return;
+    }
+    oldPool = pool;
+    pool = std::make_shared<WorkStealingPool>(numThreads);
+  }
+  // `oldPool` gets joined here, outside the lock, if we held the last
+  // reference to it
+}
+
+//==============================================================================
+int WorkStealingPool::getNumThreads() const
+{
+  return mNumThreads;
+}
+
+//==============================================================================
+int WorkStealingPool::getNumSlots(int maxWorkers) const
+{
+  const int numWorkers
+      = maxWorkers < 0 ? mNumThreads : std::min(maxWorkers, mNumThreads);
+  return numWorkers + 1;
+}
+
+//==============================================================================
+void WorkStealingPool::parallelFor(
+    int begin,
+    int end,
+    int grainSize,
+    const std::function<void(int slot, int chunkBegin, int chunkEnd)>& body,
+    int maxWorkers)
+{
+  if (end <= begin)
+  {
+    return;
+  }
+  const auto startTime = std::chrono::steady_clock::now();
+
+  const int numSlots = getNumSlots(maxWorkers);
+  const int numWorkers = numSlots - 1;
+  const int callerSlot = numWorkers;
+  const int n = end - begin;
+  if (grainSize <= 0)
+  {
+    // Aim for a few chunks per thread, so there's something left to steal
+    // when the chunks are uneven
+    grainSize = std::max(1, n / (4 * numSlots));
+  }
+  const int numChunks = (n + grainSize - 1) / grainSize;
+
+  if (numWorkers == 0 || numChunks == 1)
+  {
+    body(callerSlot, begin, end);
+    const double elapsed = secondsSince(startTime);
+    std::unique_lock<std::mutex> lock(mStatsMutex);
+    mStats.numLoops++;
+    mStats.numChunks++;
+    mStats.wallSeconds += elapsed;
+    mStats.busySeconds += elapsed;
+    return;
+  }
+
+  Loop loop;
+  loop.body = &body;
+  loop.numWorkers = numWorkers;
+  loop.unclaimed = numChunks;
+  loop.remaining = numChunks;
+  loop.slotBusySeconds.resize(numSlots, 0.0);
+  loop.numSteals = 0;
+
+  // Deal the chunks out round-robin, so every worker starts with a contiguous
+  // share of the range in its own deque
+  for (int i = 0; i < numChunks; i++)
+  {
+    Chunk chunk;
+    chunk.loop = &loop;
+    chunk.begin = begin + i * grainSize;
+    chunk.end = std::min(end, chunk.begin + grainSize);
+    chunk.queuedOn = i % numWorkers;
+    Worker& worker = *mWorkers[chunk.queuedOn];
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    worker.chunks.push_back(chunk);
+  }
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mGeneration++;
+  }
+  mWorkAvailable.notify_all();
+
+  // Help out with our own loop until there's nothing left to pick up. We never
+  // run chunks of other loops here, so a slow unrelated loop can't hold us up,
+  // and nested calls can't deadlock.
+  Chunk chunk;
+  while (loop.unclaimed.load() > 0 && findChunkOfLoop(&loop, chunk))
+  {
+    runChunk(chunk, callerSlot, true);
+  }
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(loop.mutex);
+    loop.done.wait(lock, [&] { return loop.remaining == 0; });
+    error = loop.error;
+  }
+
+  const double elapsed = secondsSince(startTime);
+  double busySeconds = 0.0;
+  double maxSlotBusySeconds = 0.0;
+  for (double slotBusySeconds : loop.slotBusySeconds)
+  {
+    busySeconds += slotBusySeconds;
+    maxSlotBusySeconds = std::max(maxSlotBusySeconds, slotBusySeconds);
+  }
+  {
+    std::unique_lock<std::mutex> lock(mStatsMutex);
+    mStats.numLoops++;
+    mStats.numChunks += numChunks;
+    mStats.numSteals += loop.numSteals.load();
+    mStats.wallSeconds += elapsed;
+    mStats.busySeconds += busySeconds;
+    mStats.overheadSeconds += std::max(0.0, elapsed - maxSlotBusySeconds);
+  }
+
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+//==============================================================================
+WorkStealingPool::Stats WorkStealingPool::getStats()
+{
+  std::unique_lock<std::mutex> lock(mStatsMutex);
+  return mStats;
+}
+
+//==============================================================================
+void WorkStealingPool::resetStats()
+{
+  std::unique_lock<std::mutex> lock(mStatsMutex);
+  mStats = Stats();
+}
+
+//==============================================================================
+void WorkStealingPool::workerLoop(int workerIdx)
+{
+  while (true)
+  {
+    long generation;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      if (!mRunning)
+      {
+        return;
+      }
+      generation = mGeneration;
+    }
+
+    Chunk chunk;
+    if (findChunk(workerIdx, chunk))
+    {
+      // Nested loops started from this chunk should stay on this pool. We
+      // can't do this before the first chunk, because the pool may still be
+      // being handed to its shared_ptr when the worker threads start.
+      if (tCurrentPool.expired())
+      {
+        tCurrentPool = weak_from_this();
+      }
+      runChunk(chunk, workerIdx, chunk.queuedOn != workerIdx);
+      continue;
+    }
+
+    // Nothing we're allowed to run right now, so sleep until more chunks get
+    // queued
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkAvailable.wait(
+        lock, [&] { return !mRunning || mGeneration != generation; });
+  }
+}
+
+//==============================================================================
+bool WorkStealingPool::findChunk(int workerIdx, Chunk& out)
+{
+  // Our own deque only ever holds chunks we're allowed to run, and popping
+  // off the back keeps us working on the most recently queued (and so most
+  // likely nested) loop first
+  {
+    Worker& worker = *mWorkers[workerIdx];
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    if (!worker.chunks.empty())
+    {
+      out = worker.chunks.back();
+      worker.chunks.pop_back();
+      out.loop->unclaimed--;
+      return true;
+    }
+  }
+
+  for (int offset = 1; offset < mNumThreads; offset++)
+  {
+    Worker& victim = *mWorkers[(workerIdx + offset) % mNumThreads];
+    std::unique_lock<std::mutex> lock(victim.mutex);
+    for (auto it = victim.chunks.begin(); it != victim.chunks.end(); ++it)
+    {
+      if (it->loop->numWorkers > workerIdx)
+      {
+        out = *it;
+        victim.chunks.erase(it);
+        out.loop->unclaimed--;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+bool WorkStealingPool::findChunkOfLoop(Loop* loop, Chunk& out)
+{
+  for (int i = 0; i < loop->numWorkers; i++)
+  {
+    Worker& victim = *mWorkers[i];
+    std::unique_lock<std::mutex> lock(victim.mutex);
+    for (auto it = victim.chunks.begin(); it != victim.chunks.end(); ++it)
+    {
+      if (it->loop == loop)
+      {
+        out = *it;
+        victim.chunks.erase(it);
+        loop->unclaimed--;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+void WorkStealingPool::runChunk(const Chunk& chunk, int slot, bool stolen)
+{
+  Loop* loop = chunk.loop;
+  const auto startTime = std::chrono::steady_clock::now();
+  std::exception_ptr error;
+  try
+  {
+    (*loop->body)(slot, chunk.begin, chunk.end);
+  }
+  catch (...)
+  {
+    error = std::current_exception();
+  }
+  loop->slotBusySeconds[slot] += secondsSince(startTime);
+  if (stolen)
+  {
+    loop->numSteals++;
+  }
+
+  // The caller may destroy the loop as soon as it sees the last chunk finish,
+  // so don't touch it again after releasing the lock
+  std::unique_lock<std::mutex> lock(loop->mutex);
+  if (error && !loop->error)
+  {
+    loop->error = error;
+  }
+  loop->remaining--;
+  if (loop->remaining == 0)
+  {
+    loop->done.notify_all();
+  }
+}
+
+} // namespace common
+} // namespace dart
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_COMMON_WORKSTEALINGPOOL_HPP_
+#define DART_COMMON_WORKSTEALINGPOOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dart {
+namespace common {
+
+/// WorkStealingPool is a persistent pool of worker threads that runs
+/// parallelFor() loops in chunks. Each worker owns a deque of chunks, pops work
+/// off the back of its own deque, and steals from the front of other workers'
+/// deques when it runs dry, so uneven chunks still keep every core busy.
+///
+/// Loops that need per-thread scratch state (like a cloned Skeleton) get a
+/// `slot` index passed to their body. Within a single parallelFor() call no two
+/// chunks ever run concurrently on the same slot, so the body can safely index
+/// into a vector of getNumSlots() copies of its state.
+///
+/// The calling thread always helps run the chunks of its own loop, so it is
+/// safe to call parallelFor() from inside another parallelFor() body, or from
+/// several threads at once.
+///
+/// Library code should run its loops on getCurrentPool(), rather than
+/// getGlobalPool(), so that callers can bind a dedicated pool (with its own
+/// thread budget) to a thread with a ScopedPool.
+class WorkStealingPool : public std::enable_shared_from_this<WorkStealingPool>
+{
+public:
+  /// Running totals describing how much time the pool spent scheduling,
+  /// compared with running loop bodies.
+  struct Stats
+  {
+    /// The number of parallelFor() calls
+    long numLoops = 0;
+    /// The number of chunks run
+    long numChunks = 0;
+    /// The number of chunks run by a thread other than the one they were
+    /// queued for
+    long numSteals = 0;
+    /// Total wall clock time spent inside parallelFor(), in seconds
+    double wallSeconds = 0.0;
+    /// Total time spent inside loop bodies, summed over all threads
+    double busySeconds = 0.0;
+    /// Total wall clock time of each parallelFor() beyond its busiest slot.
+    /// This is the time lost to waking workers, handing out chunks, waiting
+    /// on stragglers and joining, and is what a perfect scheduler would save.
+    double overheadSeconds = 0.0;
+
+    /// Returns the difference between these totals and an earlier snapshot,
+    /// which is handy for reporting overhead one iteration at a time.
+    Stats since(const Stats& earlier) const;
+  };
+
+  /// Creates a pool with `numThreads` worker threads. With zero threads every
+  /// loop runs inline on the calling thread.
+  explicit WorkStealingPool(int numThreads);
+
+  /// Stops and joins all the worker threads
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool& other) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool& other) = delete;
+
+  /// Returns the shared, process-wide pool. By default this has one worker
+  /// per hardware thread.
+  static std::shared_ptr<WorkStealingPool> getGlobalPool();
+
+  /// Returns the pool that parallel loops started from this thread should run
+  /// on. This is the pool bound by the innermost ScopedPool on this thread, or
+  /// the pool this thread is a worker of, or else getGlobalPool().
+  static std::shared_ptr<WorkStealingPool> getCurrentPool();
+
+  /// While one of these is alive, getCurrentPool() on the thread that created
+  /// it returns `pool`. Loop bodies that run on `pool`'s workers see `pool` as
+  /// their current pool too, so nested loops stay within the same pool.
+  class ScopedPool
+  {
+  public:
+    explicit ScopedPool(std::shared_ptr<WorkStealingPool> pool);
+    ~ScopedPool();
+
+    ScopedPool(const ScopedPool& other) = delete;
+    ScopedPool& operator=(const ScopedPool& other) = delete;
+
+  protected:
+    std::shared_ptr<WorkStealingPool> mPool;
+    std::weak_ptr<WorkStealingPool> mPrevious;
+  };
+
+  /// Replaces the process-wide pool with one that has `numThreads` workers.
+  /// Loops already running on the old pool finish on the old pool.
+  static void setGlobalNumThreads(int numThreads);
+
+  /// Returns the number of worker threads in the pool
+  int getNumThreads() const;
+
+  /// Returns the number of distinct `slot` values a loop body can be passed
+  /// when running with at most `maxWorkers` workers (or every worker, if
+  /// `maxWorkers` is negative). This is one per participating worker, plus one
+  /// for the calling thread.
+  int getNumSlots(int maxWorkers = -1) const;
+
+  /// This splits [begin, end) into chunks of `grainSize` indices (or picks a
+  /// chunk size automatically if `grainSize` <= 0), and calls
+  /// `body(slot, chunkBegin, chunkEnd)` on each chunk across the pool, blocking
+  /// until all the chunks have finished. At most `maxWorkers` workers (plus the
+  /// calling thread) will run chunks of this loop, or all of them if
+  /// `maxWorkers` is negative. If any chunk throws, the first exception is
+  /// rethrown here once the whole loop has finished.
+  void parallelFor(
+      int begin,
+      int end,
+      int grainSize,
+      const std::function<void(int slot, int chunkBegin, int chunkEnd)>& body,
+      int maxWorkers = -1);
+
+  /// Returns the scheduling totals accumulated since the pool was created, or
+  /// since the last resetStats()
+  Stats getStats();
+
+  /// Zeros the scheduling totals
+  void resetStats();
+
+protected:
+  struct Loop;
+
+  struct Chunk
+  {
+    Loop* loop;
+    int begin;
+    int end;
+    int queuedOn;
+  };
+
+  struct Worker
+  {
+    std::mutex mutex;
+    std::deque<Chunk> chunks;
+    std::thread thread;
+  };
+
+  void workerLoop(int workerIdx);
+
+  /// Pops a chunk off the back of the worker's own deque, or steals one off
+  /// the front of someone else's. Only chunks of loops that allow this worker
+  /// are considered.
+  bool findChunk(int workerIdx, Chunk& out);
+
+  /// Steals a chunk belonging to `loop` off the front of any deque, for the
+  /// calling thread to run while it waits.
+  bool findChunkOfLoop(Loop* loop, Chunk& out);
+
+  /// Runs a chunk on the given slot, and signals the loop if it was the last
+  /// one.
+  void runChunk(const Chunk& chunk, int slot, bool stolen);
+
+  int mNumThreads;
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+
+  std::mutex mMutex;
+  std::condition_variable mWorkAvailable;
+  // This increments every time chunks are queued, so that idle workers only
+  // wake up when there might be something new for them to do
+  long mGeneration;
+  bool mRunning;
+
+  std::mutex mStatsMutex;
+  Stats mStats;
+};
+
+} // namespace common
+} // namespace dart
+
+#endif // ifndef DART_COMMON_WORKSTEALINGPOOL_HPP_
@@ -225,6 +225,7 @@ void ArrowShape::configureArrow(
 
   // construct the head
   constructArrowTip(mesh->mMeshes[2], length - headLength, length, mProperties);
+  mMesh->clearConvexHull();
 
   Eigen::Isometry3s tf(Eigen::Isometry3s::Identity());
   tf.translation() = mTail;
@@ -0,0 +1,521 @@
+#include "dart/dynamics/BatchedFeatherstone.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+using LaneScalar = BatchedFeatherstone::LaneScalar;
+using LaneVector3 = BatchedFeatherstone::LaneVector3;
+using LaneVector6 = BatchedFeatherstone::LaneVector6;
+using LaneMatrix3 = BatchedFeatherstone::LaneMatrix3;
+using LaneMatrix6 = BatchedFeatherstone::LaneMatrix6;
+
+//==============================================================================
+/// a x b, for every lane
+inline LaneVector3 cross(const LaneVector3& a, const LaneVector3& b)
+{
+  LaneVector3 out;
+  out.col(0) = a.col(1) * b.col(2) - a.col(2) * b.col(1);
+  out.col(1) = a.col(2) * b.col(0) - a.col(0) * b.col(2);
+  out.col(2) = a.col(0) * b.col(1) - a.col(1) * b.col(0);
+  return out;
+}
+
+//==============================================================================
+/// R * v, for every lane
+inline LaneVector3 rotate(const LaneMatrix3& R, const LaneVector3& v)
+{
+  LaneVector3 out;
+  for (int r = 0; r < 3; r++)
+  {
+    out.col(r) = R.col(r) * v.col(0) + R.col(r + 3) * v.col(1)
+                 + R.col(r + 6) * v.col(2);
+  }
+  return out;
+}
+
+//==============================================================================
+/// R^T * v, for every lane
+inline LaneVector3 rotateTranspose(const LaneMatrix3& R, const LaneVector3& v)
+{
+  LaneVector3 out;
+  for (int c = 0; c < 3; c++)
+  {
+    out.col(c) = R.col(3 * c) * v.col(0) + R.col(3 * c + 1) * v.col(1)
+                 + R.col(3 * c + 2) * v.col(2);
+  }
+  return out;
+}
+
+//==============================================================================
+/// math::AdInvT(T, V), for every lane
+inline LaneVector6 AdInvT(
+    const LaneMatrix3& R, const LaneVector3& p, const LaneVector6& V)
+{
+  const LaneVector3 w = V.leftCols<3>();
+  const LaneVector3 v = V.rightCols<3>();
+  LaneVector6 out;
+  out.leftCols<3>() = rotateTranspose(R, w);
+  out.rightCols<3>() = rotateTranspose(R, v - cross(p, w));
+  return out;
+}
+
+//==============================================================================
+/// math::dAdInvT(T, F), for every lane
+inline LaneVector6 dAdInvT(
+    const LaneMatrix3& R, const LaneVector3& p, const LaneVector6& F)
+{
+  const LaneVector3 m = F.leftCols<3>();
+  const LaneVector3 f = F.rightCols<3>();
+  const LaneVector3 Rf = rotate(R, f);
+  LaneVector6 out;
+  out.leftCols<3>() = rotate(R, m) + cross(p, Rf);
+  out.rightCols<3>() = Rf;
+  return out;
+}
+
+//==============================================================================
+/// math::ad(V, W), for every lane
+inline LaneVector6 ad(const LaneVector6& V, const LaneVector6& W)
+{
+  const LaneVector3 w = V.leftCols<3>();
+  const LaneVector3 v = V.rightCols<3>();
+  const LaneVector3 w2 = W.leftCols<3>();
+  const LaneVector3 v2 = W.rightCols<3>();
+  LaneVector6 out;
+  out.leftCols<3>() = cross(w, w2);
+  out.rightCols<3>() = cross(w, v2) + cross(v, w2);
+  return out;
+}
+
+//==============================================================================
+/// math::dad(V, F), for every lane
+inline LaneVector6 dad(const LaneVector6& V, const LaneVector6& F)
+{
+  const LaneVector3 w = V.leftCols<3>();
+  const LaneVector3 v = V.rightCols<3>();
+  const LaneVector3 m = F.leftCols<3>();
+  const LaneVector3 f = F.rightCols<3>();
+  LaneVector6 out;
+  out.leftCols<3>() = cross(m, w) + cross(f, v);
+  out.rightCols<3>() = cross(f, w);
+  return out;
+}
+
+//==============================================================================
+/// I * V for a constant I, for every lane
+inline LaneVector6 multiply(const Eigen::Matrix6s& I, const LaneVector6& V)
+{
+  LaneVector6 out = LaneVector6::Zero();
+  for (int c = 0; c < 6; c++)
+  {
+    for (int r = 0; r < 6; r++)
+    {
+      out.col(r) += I(r, c) * V.col(c);
+    }
+  }
+  return out;
+}
+
+//==============================================================================
+/// I * V, for every lane
+inline LaneVector6 multiply(const LaneMatrix6& I, const LaneVector6& V)
+{
+  LaneVector6 out = LaneVector6::Zero();
+  for (int c = 0; c < 6; c++)
+  {
+    for (int r = 0; r < 6; r++)
+    {
+      out.col(r) += I.col(r + 6 * c) * V.col(c);
+    }
+  }
+  return out;
+}
+
+//==============================================================================
+/// a . b for a constant a, for every lane
+inline LaneScalar dot(const Eigen::Vector6s& a, const LaneVector6& b)
+{
+  LaneScalar out = a(0) * b.col(0);
+  for (int i = 1; i < 6; i++)
+  {
+    out += a(i) * b.col(i);
+  }
+  return out;
+}
+
+//==============================================================================
+/// a . b, for every lane
+inline LaneScalar dot(const LaneVector6& a, const LaneVector6& b)
+{
+  return (a * b).rowwise().sum();
+}
+
+//==============================================================================
+/// out += math::transformInertia(T.inverse(), I), for every lane. With
+/// X = Ad(T^-1), this is X^T * I * X, which we get by applying dAdInvT() (which
+/// is X^T) to the columns of I, and then to the rows of the result.
+inline void addTransformedInertia(
+    const LaneMatrix3& R,
+    const LaneVector3& p,
+    const LaneMatrix6& I,
+    /* OUT */ LaneMatrix6& out)
+{
+  LaneMatrix6 Z;
+  LaneVector6 column;
+  for (int c = 0; c < 6; c++)
+  {
+    column = I.middleCols<6>(6 * c);
+    Z.middleCols<6>(6 * c) = dAdInvT(R, p, column);
+  }
+  LaneVector6 row;
+  for (int r = 0; r < 6; r++)
+  {
+    for (int c = 0; c < 6; c++)
+    {
+      row.col(c) = Z.col(r + 6 * c);
+    }
+    // The result is symmetric, so this row is also a column
+    out.middleCols<6>(6 * r) += dAdInvT(R, p, row);
+  }
+}
+
+} // namespace
+
+//==============================================================================
+BatchedFeatherstone::BatchedFeatherstone(const SimpleFeatherstone& simple)
+{
+  const int n = simple.mJointsAndBodies.size();
+  for (int i = 0; i < n; i++)
+  {
+    const JointAndBody& joint = simple.mJointsAndBodies[i];
+    mParentIndex.push_back(joint.parentIndex);
+    mAxis.push_back(joint.axis);
+    mInertia.push_back(joint.inertia);
+
+    // SimpleFeatherstone uses A * expMap(axis * q) * B, which we rewrite as
+    // (A * B) * expMap(Ad(B^-1) * axis * q)
+    const Eigen::Isometry3s C
+        = joint.transformFromParent * joint.transformFromChildren;
+    const Eigen::Vector6s screw
+        = math::AdInvT(joint.transformFromChildren, joint.axis);
+    const Eigen::Vector3s w = screw.head<3>();
+    const Eigen::Vector3s v = screw.tail<3>();
+
+    s_t scale = w.norm();
+    Eigen::Matrix3s K = Eigen::Matrix3s::Zero();
+    Eigen::Vector3s unitV = v;
+    if (scale > 1e-12)
+    {
+      K = math::makeSkewSymmetric(w / scale);
+      unitV = v / scale;
+    }
+    else
+    {
+      // This is a prismatic axis, so theta = q, and the rotation terms vanish
+      scale = 1.0;
+    }
+    const Eigen::Matrix3s R = C.linear();
+    mAngleScale.push_back(scale);
+    mR0.push_back(R);
+    mR1.push_back(R * K);
+    mR2.push_back(R * K * K);
+    mP0.push_back(C.translation());
+    mP1.push_back(R * unitV);
+    mP2.push_back(R * K * unitV);
+    mP3.push_back(R * K * K * unitV);
+  }
+
+  mPos.resize(n);
+  mVel.resize(n);
+  mForce.resize(n);
+  mAccel.resize(n);
+  mRotation.resize(n);
+  mTranslation.resize(n);
+  mSpatialVelocity.resize(n);
+  mPartialAcceleration.resize(n);
+  mSpatialAcceleration.resize(n);
+  mBiasForce.resize(n);
+  mArticulatedInertia.resize(n);
+  mAIS.resize(n);
+  mPsi.resize(n);
+  mTotalForce.resize(n);
+}
+
+//==============================================================================
+int BatchedFeatherstone::len() const
+{
+  return mParentIndex.size();
+}
+
+//==============================================================================
+void BatchedFeatherstone::forwardDynamics(
+    const s_t* pos,
+    const s_t* vel,
+    const s_t* force,
+    int numInstances,
+    /* OUT */ s_t* accelerations)
+{
+  const int n = len();
+  for (int start = 0; start < numInstances; start += kLanes)
+  {
+    gather(pos, start, numInstances, mPos);
+    gather(vel, start, numInstances, mVel);
+    gather(force, start, numInstances, mForce);
+
+    // Forward pass
+    forwardKinematicsLanes();
+    for (int i = 0; i < n; i++)
+    {
+      mArticulatedInertia[i].setZero();
+      mBiasForce[i].setZero();
+    }
+
+    // Backward pass
+    for (int i = n - 1; i >= 0; i--)
+    {
+      LaneMatrix6& IA = mArticulatedInertia[i];
+      for (int k = 0; k < 36; k++)
+      {
+        IA.col(k) += mInertia[i](k % 6, k / 6);
+      }
+      mBiasForce[i] -= dad(
+          mSpatialVelocity[i], multiply(mInertia[i], mSpatialVelocity[i]));
+
+      // AIS = Articulated_Inertia_times_axiS
+      LaneVector6& AIS = mAIS[i];
+      for (int r = 0; r < 6; r++)
+      {
+        AIS.col(r) = IA.col(r) * mAxis[i](0);
+        for (int c = 1; c < 6; c++)
+        {
+          AIS.col(r) += IA.col(r + 6 * c) * mAxis[i](c);
+        }
+      }
+      mPsi[i] = dot(mAxis[i], AIS).inverse();
+
+      // Total force on the joint, see SimpleFeatherstone::forwardDynamics()
+      mTotalForce[i] = mForce[i] - dot(AIS, mPartialAcceleration[i])
+                       - dot(mAxis[i], mBiasForce[i]);
+
+      const int parent = mParentIndex[i];
+      if (parent == -1)
+        continue;
+
+      // Sum into our parents
+      LaneMatrix6 PI = IA;
+      for (int c = 0; c < 6; c++)
+      {
+        const LaneScalar scaled = mPsi[i] * AIS.col(c);
+        for (int r = 0; r < 6; r++)
+        {
+          PI.col(r + 6 * c) -= AIS.col(r) * scaled;
+        }
+      }
+      addTransformedInertia(
+          mRotation[i], mTranslation[i], PI, mArticulatedInertia[parent]);
+
+      LaneVector6 beta = mBiasForce[i]
+                         + multiply(IA, mPartialAcceleration[i]);
+      const LaneScalar psiTotalForce = mPsi[i] * mTotalForce[i];
+      for (int r = 0; r < 6; r++)
+      {
+        beta.col(r) += AIS.col(r) * psiTotalForce;
+      }
+      mBiasForce[parent] += dAdInvT(mRotation[i], mTranslation[i], beta);
+    }
+
+    // Last forward pass
+    for (int i = 0; i < n; i++)
+    {
+      const int parent = mParentIndex[i];
+      LaneVector6 parentAcceleration = LaneVector6::Zero();
+      if (parent != -1)
+      {
+        parentAcceleration = AdInvT(
+            mRotation[i], mTranslation[i], mSpatialAcceleration[parent]);
+      }
+      mAccel[i] = mPsi[i] * (mTotalForce[i] - dot(mAIS[i], parentAcceleration));
+      mSpatialAcceleration[i]
+          = parentAcceleration + mPartialAcceleration[i];
+      for (int r = 0; r < 6; r++)
+      {
+        mSpatialAcceleration[i].col(r) += mAxis[i](r) * mAccel[i];
+      }
+    }
+
+    scatter(mAccel, start, numInstances, accelerations);
+  }
+}
+
+//==============================================================================
+void BatchedFeatherstone::inverseDynamics(
+    const s_t* pos,
+    const s_t* vel,
+    const s_t* accelerations,
+    int numInstances,
+    /* OUT */ s_t* forces)
+{
+  const int n = len();
+  for (int start = 0; start < numInstances; start += kLanes)
+  {
+    gather(pos, start, numInstances, mPos);
+    gather(vel, start, numInstances, mVel);
+    gather(accelerations, start, numInstances, mAccel);
+
+    forwardKinematicsLanes();
+
+    // Forward pass, computing accelerations and the net force on each body
+    for (int i = 0; i < n; i++)
+    {
+      const int parent = mParentIndex[i];
+      LaneVector6 a = mPartialAcceleration[i];
+      if (parent != -1)
+      {
+        a += AdInvT(
+            mRotation[i], mTranslation[i], mSpatialAcceleration[parent]);
+      }
+      for (int r = 0; r < 6; r++)
+      {
+        a.col(r) += mAxis[i](r) * mAccel[i];
+      }
+      mSpatialAcceleration[i] = a;
+      mBiasForce[i] = multiply(mInertia[i], a)
+                      - dad(mSpatialVelocity[i],
+                            multiply(mInertia[i], mSpatialVelocity[i]));
+    }
+
+    // Backward pass, summing the forces from children into their parents
+    for (int i = n - 1; i >= 0; i--)
+    {
+      mForce[i] = dot(mAxis[i], mBiasForce[i]);
+      const int parent = mParentIndex[i];
+      if (parent != -1)
+      {
+        mBiasForce[parent]
+            += dAdInvT(mRotation[i], mTranslation[i], mBiasForce[i]);
+      }
+    }
+
+    scatter(mForce, start, numInstances, forces);
+  }
+}
+
+//==============================================================================
+Eigen::MatrixXs BatchedFeatherstone::forwardDynamics(
+    const Eigen::MatrixXs& pos,
+    const Eigen::MatrixXs& vel,
+    const Eigen::MatrixXs& force)
+{
+  assert(pos.rows() == len() && vel.rows() == len() && force.rows() == len());
+  assert(pos.cols() == vel.cols() && pos.cols() == force.cols());
+  Eigen::MatrixXs accelerations = Eigen::MatrixXs::Zero(len(), pos.cols());
+  forwardDynamics(
+      pos.data(), vel.data(), force.data(), pos.cols(), accelerations.data());
+  return accelerations;
+}
+
+//==============================================================================
+Eigen::MatrixXs BatchedFeatherstone::inverseDynamics(
+    const Eigen::MatrixXs& pos,
+    const Eigen::MatrixXs& vel,
+    const Eigen::MatrixXs& accelerations)
+{
+  assert(pos.rows() == len() && vel.rows() == len());
+  assert(accelerations.rows() == len());
+  assert(pos.cols() == vel.cols() && pos.cols() == accelerations.cols());
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Zero(len(), pos.cols());
+  inverseDynamics(
+      pos.data(), vel.data(), accelerations.data(), pos.cols(), forces.data());
+  return forces;
+}
+
+//==============================================================================
+void BatchedFeatherstone::gather(
+    const s_t* matrix,
+    int start,
+    int numInstances,
+    /* OUT */ common::aligned_vector<LaneScalar>& lanes)
+{
+  const int n = len();
+  for (int lane = 0; lane < kLanes; lane++)
+  {
+    const int instance = std::min(start + lane, numInstances - 1);
+    const s_t* column = matrix + (std::size_t)instance * n;
+    for (int i = 0; i < n; i++)
+    {
+      lanes[i](lane) = column[i];
+    }
+  }
+}
+
+//==============================================================================
+void BatchedFeatherstone::scatter(
+    const common::aligned_vector<LaneScalar>& lanes,
+    int start,
+    int numInstances,
+    /* OUT */ s_t* matrix)
+{
+  const int n = len();
+  const int numLanes = std::min(kLanes, numInstances - start);
+  for (int lane = 0; lane < numLanes; lane++)
+  {
+    s_t* column = matrix + (std::size_t)(start + lane) * n;
+    for (int i = 0; i < n; i++)
+    {
+      column[i] = lanes[i](lane);
+    }
+  }
+}
+
+//==============================================================================
+void BatchedFeatherstone::forwardKinematicsLanes()
+{
+  const int n = len();
+  for (int i = 0; i < n; i++)
+  {
+    const LaneScalar theta = mAngleScale[i] * mPos[i];
+    const LaneScalar sinTheta = theta.sin();
+    const LaneScalar oneMinusCos = 1.0 - theta.cos();
+
+    LaneMatrix3& R = mRotation[i];
+    for (int k = 0; k < 9; k++)
+    {
+      const int r = k % 3;
+      const int c = k / 3;
+      R.col(k)
+          = mR0[i](r, c) + mR1[i](r, c) * sinTheta + mR2[i](r, c) * oneMinusCos;
+    }
+    LaneVector3& p = mTranslation[i];
+    for (int r = 0; r < 3; r++)
+    {
+      p.col(r) = mP0[i](r) + mP1[i](r) * theta + mP2[i](r) * oneMinusCos
+                 + mP3[i](r) * (theta - sinTheta);
+    }
+
+    // The velocity contributed by our joint is axis * vel
+    LaneVector6 jointVelocity;
+    for (int r = 0; r < 6; r++)
+    {
+      jointVelocity.col(r) = mAxis[i](r) * mVel[i];
+    }
+    const int parent = mParentIndex[i];
+    if (parent != -1)
+    {
+      mSpatialVelocity[i]
+          = AdInvT(R, p, mSpatialVelocity[parent]) + jointVelocity;
+    }
+    else
+    {
+      mSpatialVelocity[i] = jointVelocity;
+    }
+    mPartialAcceleration[i] = ad(mSpatialVelocity[i], jointVelocity);
+  }
+}
+
+} // namespace dynamics
+} // namespace dart
@@ -0,0 +1,138 @@
+#ifndef DART_BATCHED_FEATHERSTONE
+#define DART_BATCHED_FEATHERSTONE
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/dynamics/SimpleFeatherstone.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace dynamics {
+
+/**
+ * This evaluates the same SimpleFeatherstone skeleton at many different states
+ * at once, which is what sampling MPC and line searches spend their time on.
+ *
+ * Instances are processed kLanes at a time. Every per-body quantity is stored
+ * as structure-of-arrays, with the kLanes values for each component next to
+ * each other in memory, so every spatial algebra operation is a handful of
+ * elementwise array operations that vectorize across instances, rather than
+ * small matrix products on one instance at a time.
+ *
+ * All the state matrices are column-major, with len() rows and one column per
+ * instance, so instance `n` of DOF `i` lives at `pos[n * len() + i]`.
+ */
+class BatchedFeatherstone
+{
+public:
+  // The number of instances that get evaluated together
+  static constexpr int kLanes = 8;
+
+  using LaneScalar = Eigen::Array<s_t, kLanes, 1>;
+  using LaneVector3 = Eigen::Array<s_t, kLanes, 3>;
+  using LaneVector6 = Eigen::Array<s_t, kLanes, 6>;
+  // A 3x3 matrix per lane, column-major, so entry (r, c) is column r + 3 * c
+  using LaneMatrix3 = Eigen::Array<s_t, kLanes, 9>;
+  // A 6x6 matrix per lane, column-major, so entry (r, c) is column r + 6 * c
+  using LaneMatrix6 = Eigen::Array<s_t, kLanes, 36>;
+
+  // This copies the joints and bodies out of a SimpleFeatherstone that has
+  // already been populated, usually by SimpleFeatherstone::populateFromSkeleton
+  BatchedFeatherstone(const SimpleFeatherstone& simple);
+
+  // The number of joints in this skeleton
+  int len() const;
+
+  // This computes accelerations for `numInstances` states at once. All the
+  // pointer arguments are assumed to point to len() x numInstances column-major
+  // matrices. Each column gets exactly the result that
+  // SimpleFeatherstone::forwardDynamics() would give for that column.
+  void forwardDynamics(
+      const s_t* pos,
+      const s_t* vel,
+      const s_t* force,
+      int numInstances,
+      /* OUT */ s_t* accelerations);
+
+  // This computes the forces required to produce the given accelerations, for
+  // `numInstances` states at once. This is the inverse of forwardDynamics().
+  void inverseDynamics(
+      const s_t* pos,
+      const s_t* vel,
+      const s_t* accelerations,
+      int numInstances,
+      /* OUT */ s_t* forces);
+
+  // These are convenience wrappers, with one column per instance
+  Eigen::MatrixXs forwardDynamics(
+      const Eigen::MatrixXs& pos,
+      const Eigen::MatrixXs& vel,
+      const Eigen::MatrixXs& force);
+
+  Eigen::MatrixXs inverseDynamics(
+      const Eigen::MatrixXs& pos,
+      const Eigen::MatrixXs& vel,
+      const Eigen::MatrixXs& accelerations);
+
+protected:
+  // This copies kLanes instances starting at `start` out of a len() x
+  // numInstances matrix, repeating the last instance to fill any lanes past the
+  // end
+  void gather(
+      const s_t* matrix,
+      int start,
+      int numInstances,
+      /* OUT */ common::aligned_vector<LaneScalar>& lanes);
+
+  void scatter(
+      const common::aligned_vector<LaneScalar>& lanes,
+      int start,
+      int numInstances,
+      /* OUT */ s_t* matrix);
+
+  // This computes transforms, spatial velocities and partial accelerations
+  void forwardKinematicsLanes();
+
+  // Constant properties of the joints and bodies. The transform from the
+  // parent is C * expMap(screw * pos), and we expand the exponential with
+  // Rodrigues' formula, so that
+  //
+  //   R = R0 + sin(theta) * R1 + (1 - cos(theta)) * R2
+  //   p = p0 + theta * p1 + (1 - cos(theta)) * p2 + (theta - sin(theta)) * p3
+  //
+  // where theta = mAngleScale * pos.
+  std::vector<int> mParentIndex;
+  common::aligned_vector<Eigen::Vector6s> mAxis;
+  common::aligned_vector<Eigen::Matrix6s> mInertia;
+  std::vector<s_t> mAngleScale;
+  common::aligned_vector<Eigen::Matrix3s> mR0;
+  common::aligned_vector<Eigen::Matrix3s> mR1;
+  common::aligned_vector<Eigen::Matrix3s> mR2;
+  common::aligned_vector<Eigen::Vector3s> mP0;
+  common::aligned_vector<Eigen::Vector3s> mP1;
+  common::aligned_vector<Eigen::Vector3s> mP2;
+  common::aligned_vector<Eigen::Vector3s> mP3;
+
+  // Scratch space, one entry per joint, each holding kLanes instances
+  common::aligned_vector<LaneScalar> mPos;
+  common::aligned_vector<LaneScalar> mVel;
+  common::aligned_vector<LaneScalar> mForce;
+  common::aligned_vector<LaneScalar> mAccel;
+  common::aligned_vector<LaneMatrix3> mRotation;
+  common::aligned_vector<LaneVector3> mTranslation;
+  common::aligned_vector<LaneVector6> mSpatialVelocity;
+  common::aligned_vector<LaneVector6> mPartialAcceleration;
+  common::aligned_vector<LaneVector6> mSpatialAcceleration;
+  common::aligned_vector<LaneVector6> mBiasForce;
+  common::aligned_vector<LaneMatrix6> mArticulatedInertia;
+  common::aligned_vector<LaneVector6> mAIS;
+  common::aligned_vector<LaneScalar> mPsi;
+  common::aligned_vector<LaneScalar> mTotalForce;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
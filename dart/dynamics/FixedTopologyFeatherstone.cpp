@@ -0,0 +1,242 @@
+#include "dart/dynamics/FixedTopologyFeatherstone.hpp"
+
+#include <cmath>
+#include <sstream>
+
+#include "dart/common/Console.hpp"
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+// We recover the screw for each DOF of a chain joint by moving only that DOF
+// this far, and taking the log of the resulting transform
+constexpr s_t kScrewProbe = 0.5;
+constexpr s_t kVerifyTolerance = 1e-8;
+
+//==============================================================================
+template <int K>
+bool verifyJointAt(
+    Joint* joint,
+    const FixedTopologyJoint& desc,
+    const Eigen::VectorXs& pos,
+    const Eigen::VectorXs& vel)
+{
+  joint->setPositions(pos);
+  joint->setVelocities(vel);
+
+  Eigen::MatrixXs screws = Eigen::MatrixXs::Zero(6, K);
+  for (int j = 0; j < desc.screws.size(); j++)
+  {
+    screws.col(j) = desc.screws[j];
+  }
+  Eigen::Isometry3s transform;
+  Eigen::Matrix<s_t, 6, K> S;
+  Eigen::Matrix<s_t, 6, K> dS;
+  computeFixedTopologyJoint<K>(
+      desc.type,
+      Eigen::Matrix<s_t, 6, K>(screws),
+      Eigen::Matrix<s_t, K, 1>(pos),
+      Eigen::Matrix<s_t, K, 1>(vel),
+      transform,
+      S,
+      dS);
+
+  const Eigen::Matrix6s AdT = math::getAdTMatrix(desc.transformFromChild);
+  const Eigen::Matrix4s expectedTransform
+      = (desc.transformFromParent * transform
+         * desc.transformFromChild.inverse())
+            .matrix();
+  const Eigen::MatrixXs expectedS = AdT * Eigen::MatrixXs(S);
+  const Eigen::MatrixXs expectedDS = AdT * Eigen::MatrixXs(dS);
+
+  const s_t transformError
+      = (expectedTransform - joint->getRelativeTransform().matrix())
+            .cwiseAbs()
+            .maxCoeff();
+  if (K == 0)
+  {
+    return transformError < kVerifyTolerance;
+  }
+  const s_t jacobianError
+      = (expectedS - joint->getRelativeJacobian()).cwiseAbs().maxCoeff();
+  const s_t jacobianDerivError
+      = (expectedDS - joint->getRelativeJacobianTimeDeriv())
+            .cwiseAbs()
+            .maxCoeff();
+  return transformError < kVerifyTolerance
+         && jacobianError < kVerifyTolerance
+         && jacobianDerivError < kVerifyTolerance;
+}
+
+//==============================================================================
+template <int K>
+bool verifyJoint(Joint* joint, const FixedTopologyJoint& desc)
+{
+  const Eigen::VectorXs originalPos = joint->getPositions();
+  const Eigen::VectorXs originalVel = joint->getVelocities();
+
+  // Check at the current state, and at an arbitrary (but deterministic) one,
+  // so that a joint that only happens to match at zero gets caught
+  Eigen::VectorXs probePos = Eigen::VectorXs::Zero(K);
+  Eigen::VectorXs probeVel = Eigen::VectorXs::Zero(K);
+  for (int j = 0; j < K; j++)
+  {
+    probePos(j) = 0.3 * std::sin(1.7 * (j + 1));
+    probeVel(j) = 0.6 * std::cos(2.3 * (j + 1));
+  }
+
+  bool matches = verifyJointAt<K>(joint, desc, originalPos, originalVel)
+                 && verifyJointAt<K>(joint, desc, probePos, probeVel);
+
+  joint->setPositions(originalPos);
+  joint->setVelocities(originalVel);
+  return matches;
+}
+
+} // namespace
+
+//==============================================================================
+bool extractFixedTopology(
+    const std::shared_ptr<Skeleton>& skeleton,
+    /* OUT */ std::vector<FixedTopologyJoint>& joints)
+{
+  joints.clear();
+  int dofOffset = 0;
+  for (std::size_t i = 0; i < skeleton->getNumBodyNodes(); i++)
+  {
+    BodyNode* body = skeleton->getBodyNode(i);
+    Joint* joint = body->getParentJoint();
+
+    FixedTopologyJoint desc;
+    desc.numDofs = joint->getNumDofs();
+    desc.dofOffset = dofOffset;
+    desc.parentIndex = -1;
+    if (body->getParentBodyNode() != nullptr)
+    {
+      desc.parentIndex = body->getParentBodyNode()->getIndexInSkeleton();
+    }
+    for (int j = 0; j < desc.numDofs; j++)
+    {
+      if (joint->getDof(j)->getIndexInSkeleton() != dofOffset + j)
+      {
+        dtwarn << "[extractFixedTopology] The DOFs of skeleton \""
+               << skeleton->getName()
+               << "\" aren't laid out in body order, which is not "
+               << "supported.\n";
+        return false;
+      }
+    }
+    dofOffset += desc.numDofs;
+    desc.transformFromParent = joint->getTransformFromParentBodyNode();
+    desc.transformFromChild = joint->getTransformFromChildBodyNode();
+    desc.inertia = body->getInertia().getSpatialTensor();
+
+    if (joint->getType() == BallJoint::getStaticType())
+    {
+      desc.type = FixedTopologyJointType::BALL;
+    }
+    else if (joint->getType() == FreeJoint::getStaticType())
+    {
+      desc.type = FixedTopologyJointType::FREE;
+    }
+    else
+    {
+      desc.type = FixedTopologyJointType::SCREW_CHAIN;
+      const Eigen::VectorXs originalPos = joint->getPositions();
+      const Eigen::Isometry3s parentToJointInv
+          = desc.transformFromParent.inverse();
+      for (int j = 0; j < desc.numDofs; j++)
+      {
+        Eigen::VectorXs probe = Eigen::VectorXs::Zero(desc.numDofs);
+        probe(j) = kScrewProbe;
+        joint->setPositions(probe);
+        const Eigen::Isometry3s Q = parentToJointInv
+                                    * joint->getRelativeTransform()
+                                    * desc.transformFromChild;
+        desc.screws.push_back(math::logMap(Q) / kScrewProbe);
+      }
+      joint->setPositions(originalPos);
+    }
+
+    bool matches = false;
+    switch (desc.numDofs)
+    {
+      case 0:
+        matches = verifyJoint<0>(joint, desc);
+        break;
+      case 1:
+        matches = verifyJoint<1>(joint, desc);
+        break;
+      case 2:
+        matches = verifyJoint<2>(joint, desc);
+        break;
+      case 3:
+        matches = verifyJoint<3>(joint, desc);
+        break;
+      case 4:
+        matches = verifyJoint<4>(joint, desc);
+        break;
+      case 5:
+        matches = verifyJoint<5>(joint, desc);
+        break;
+      case 6:
+        matches = verifyJoint<6>(joint, desc);
+        break;
+      default:
+        matches = false;
+    }
+    if (!matches)
+    {
+      dtwarn << "[extractFixedTopology] Joint \"" << joint->getName()
+             << "\" of type " << joint->getType()
+             << " can't be represented as a product of exponentials of "
+             << "constant screws, which is not supported.\n";
+      return false;
+    }
+
+    joints.push_back(desc);
+  }
+  return true;
+}
+
+//==============================================================================
+std::string getFixedTopologyFeatherstoneType(
+    const std::shared_ptr<Skeleton>& skeleton)
+{
+  std::vector<FixedTopologyJoint> joints;
+  if (!extractFixedTopology(skeleton, joints))
+  {
+    return "";
+  }
+
+  std::stringstream dofs;
+  std::stringstream parents;
+  for (int i = 0; i < joints.size(); i++)
+  {
+    if (i > 0)
+    {
+      dofs << ", ";
+      parents << ", ";
+    }
+    dofs << joints[i].numDofs;
+    parents << joints[i].parentIndex;
+  }
+
+  return "dart::dynamics::FixedTopologyFeatherstone<"
+         "dart::dynamics::DofsPerBody<"
+         + dofs.str()
+         + ">, "
+           "dart::dynamics::ParentIndices<"
+         + parents.str() + ">>";
+}
+
+} // namespace dynamics
+} // namespace dart
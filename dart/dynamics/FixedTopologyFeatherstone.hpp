@@ -0,0 +1,277 @@
+#ifndef DART_FIXED_TOPOLOGY_FEATHERSTONE
+#define DART_FIXED_TOPOLOGY_FEATHERSTONE
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace dynamics {
+
+class Skeleton;
+
+// These are the joint parameterizations the fixed-topology Featherstone knows
+// how to evaluate. Every joint in DART whose relative transform is a product
+// of exponentials of constant screws (revolute, prismatic, screw, universal,
+// euler, planar, translational, weld, etc) is treated as a SCREW_CHAIN. Ball
+// and free joints use the same exponential-coordinate parameterization as
+// BallJoint and FreeJoint.
+enum class FixedTopologyJointType
+{
+  SCREW_CHAIN,
+  BALL,
+  FREE
+};
+
+// This is the runtime description of a single joint and its child body, which
+// gets read out of a Skeleton and copied into the compile-time specialized
+// FixedTopologyFeatherstone.
+struct FixedTopologyJoint
+{
+  FixedTopologyJointType type;
+  int numDofs;
+  // This is the index of the first DOF of this joint in the skeleton
+  int dofOffset;
+  // -1 indicates this is the root body, otherwise this is the index of the
+  // parent body in the skeleton
+  int parentIndex;
+  // Joint::getTransformFromParentBodyNode()
+  Eigen::Isometry3s transformFromParent;
+  // Joint::getTransformFromChildBodyNode()
+  Eigen::Isometry3s transformFromChild;
+  // For SCREW_CHAIN joints, this is one screw per DOF, expressed in the joint
+  // frame, so that the joint transform is
+  // expMap(screws[0] * q[0]) * ... * expMap(screws[n-1] * q[n-1])
+  std::vector<Eigen::Vector6s> screws;
+  // This is the spatial inertia matrix for the child body node
+  Eigen::Matrix6s inertia;
+};
+
+// This reads the topology and the constant joint and body properties out of a
+// skeleton. This returns false (and prints why) if the skeleton has a joint
+// whose motion we can't reproduce exactly, or if its DOFs aren't laid out in
+// body order.
+bool extractFixedTopology(
+    const std::shared_ptr<Skeleton>& skeleton,
+    /* OUT */ std::vector<FixedTopologyJoint>& joints);
+
+// This generates the C++ type of the FixedTopologyFeatherstone specialization
+// that matches the skeleton, so that it can be pasted into a source file. This
+// returns an empty string if the skeleton isn't supported.
+std::string getFixedTopologyFeatherstoneType(
+    const std::shared_ptr<Skeleton>& skeleton);
+
+// These spell out the template arguments of FixedTopologyFeatherstone
+template <int... Dofs>
+using DofsPerBody = std::integer_sequence<int, Dofs...>;
+template <int... Parents>
+using ParentIndices = std::integer_sequence<int, Parents...>;
+
+// This evaluates the joint transform, and the motion subspace S (and its time
+// derivative dS) expressed in the joint frame, for a joint with K DOFs. The
+// screws are only used for SCREW_CHAIN joints.
+template <int K>
+void computeFixedTopologyJoint(
+    FixedTopologyJointType type,
+    const Eigen::Matrix<s_t, 6, K>& screws,
+    const Eigen::Matrix<s_t, K, 1>& pos,
+    const Eigen::Matrix<s_t, K, 1>& vel,
+    /* OUT */ Eigen::Isometry3s& transform,
+    /* OUT */ Eigen::Matrix<s_t, 6, K>& S,
+    /* OUT */ Eigen::Matrix<s_t, 6, K>& dS);
+
+// This returns the index of the first DOF of each body
+template <std::size_t N>
+constexpr std::array<int, N> getFixedTopologyDofOffsets(
+    const std::array<int, N>& dofs)
+{
+  std::array<int, N> offsets{};
+  int offset = 0;
+  for (std::size_t i = 0; i < N; i++)
+  {
+    offsets[i] = offset;
+    offset += dofs[i];
+  }
+  return offsets;
+}
+
+// This checks that every parent comes before its children
+template <std::size_t N>
+constexpr bool isFixedTopologySorted(const std::array<int, N>& parents)
+{
+  for (std::size_t i = 0; i < N; i++)
+  {
+    if (parents[i] < -1 || parents[i] >= (int)i)
+      return false;
+  }
+  return true;
+}
+
+template <typename DofsPerBodyT, typename ParentIndicesT>
+class FixedTopologyFeatherstone;
+
+/**
+ * This is a variant of SimpleFeatherstone where the shape of the skeleton is
+ * baked in at compile time: the number of DOFs on each body, and the index of
+ * each body's parent. For example, a double pendulum on a free-floating base
+ * would be:
+ *
+ *   FixedTopologyFeatherstone<DofsPerBody<6, 1, 1>, ParentIndices<-1, 0, 1>>
+ *
+ * You can get the type for an existing Skeleton from
+ * getFixedTopologyFeatherstoneType(), and then populateFromSkeleton() will
+ * check that the skeleton matches.
+ *
+ * Because every loop bound and every matrix size is known to the compiler, all
+ * the per-body passes are unrolled and all the scratch space is fixed-size and
+ * on the stack. The per-body state is stored as structure-of-arrays (one 6 x N
+ * matrix for all the spatial velocities, one for all the accelerations, etc)
+ * so consecutive bodies sit next to each other in memory.
+ *
+ * Like SimpleFeatherstone, this ignores joint springs, damping, friction and
+ * armature, and assumes every body feels gravity.
+ */
+template <int... Dofs, int... Parents>
+class FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>
+{
+public:
+  static constexpr int NumBodies = sizeof...(Dofs);
+  static constexpr int NumDofs = (0 + ... + Dofs);
+
+  static_assert(
+      sizeof...(Dofs) == sizeof...(Parents),
+      "FixedTopologyFeatherstone needs exactly one parent index per body");
+  static_assert(NumBodies > 0, "FixedTopologyFeatherstone needs a body");
+
+  using VectorDofs = Eigen::Matrix<s_t, NumDofs, 1>;
+  using MatrixDofs = Eigen::Matrix<s_t, NumDofs, NumDofs>;
+
+  FixedTopologyFeatherstone();
+
+  // This gets the values from a DART skeleton to populate our Featherstone
+  // implementation. This returns false if the skeleton doesn't match the
+  // compile-time topology, or has joints we can't represent.
+  bool populateFromSkeleton(const std::shared_ptr<Skeleton>& skeleton);
+
+  // This sets the joints and bodies directly, as read by
+  // extractFixedTopology(). This returns false on a topology mismatch.
+  bool setJoints(const std::vector<FixedTopologyJoint>& joints);
+
+  void setGravity(const Eigen::Vector3s& gravity);
+
+  const Eigen::Vector3s& getGravity() const;
+
+  // This computes accelerations, using the articulated body algorithm
+  void forwardDynamics(
+      const VectorDofs& pos,
+      const VectorDofs& vel,
+      const VectorDofs& force,
+      /* OUT */ VectorDofs& accelerations);
+
+  // This computes the forces required to produce the given accelerations,
+  // using the recursive Newton-Euler algorithm
+  void inverseDynamics(
+      const VectorDofs& pos,
+      const VectorDofs& vel,
+      const VectorDofs& accelerations,
+      /* OUT */ VectorDofs& forces);
+
+  // This computes the joint-space mass matrix, using the composite rigid body
+  // algorithm
+  void computeMassMatrix(const VectorDofs& pos, /* OUT */ MatrixDofs& M);
+
+  // This computes the Coriolis and gravity forces, which is the force
+  // required to hold the skeleton at zero acceleration
+  void computeCoriolisAndGravityForces(
+      const VectorDofs& pos,
+      const VectorDofs& vel,
+      /* OUT */ VectorDofs& forces);
+
+  static constexpr std::array<int, NumBodies> kDofs = {Dofs...};
+  static constexpr std::array<int, NumBodies> kParents = {Parents...};
+  static constexpr std::array<int, NumBodies> kOffsets
+      = getFixedTopologyDofOffsets<NumBodies>({Dofs...});
+
+  static_assert(
+      isFixedTopologySorted<NumBodies>({Parents...}),
+      "FixedTopologyFeatherstone needs every parent to come before its "
+      "children");
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+protected:
+  template <int I>
+  void updateKinematics(const VectorDofs& pos, const VectorDofs& vel);
+  template <int I>
+  void backwardArticulatedInertia(const VectorDofs& force);
+  template <int I>
+  void forwardAcceleration(/* OUT */ VectorDofs& accelerations);
+  template <int I>
+  void forwardNewtonEuler(const VectorDofs& accelerations);
+  template <int I>
+  void backwardNewtonEuler(/* OUT */ VectorDofs& forces);
+  template <int I>
+  void backwardCompositeInertia(/* OUT */ MatrixDofs& M);
+
+  template <std::size_t... Is>
+  void forwardDynamicsImpl(
+      std::index_sequence<Is...>,
+      const VectorDofs& pos,
+      const VectorDofs& vel,
+      const VectorDofs& force,
+      VectorDofs& accelerations);
+  template <std::size_t... Is>
+  void inverseDynamicsImpl(
+      std::index_sequence<Is...>,
+      const VectorDofs& pos,
+      const VectorDofs& vel,
+      const VectorDofs& accelerations,
+      VectorDofs& forces);
+  template <std::size_t... Is>
+  void computeMassMatrixImpl(
+      std::index_sequence<Is...>, const VectorDofs& pos, MatrixDofs& M);
+
+  // Constant properties of the joints and bodies
+  std::array<FixedTopologyJointType, NumBodies> mJointTypes;
+  std::array<Eigen::Isometry3s, NumBodies> mTransformFromParent;
+  std::array<Eigen::Isometry3s, NumBodies> mInverseTransformFromChild;
+  std::array<Eigen::Matrix6s, NumBodies> mAdTransformFromChild;
+  std::array<Eigen::Matrix6s, NumBodies> mInertia;
+  // The screws of SCREW_CHAIN joints, one column per DOF
+  Eigen::Matrix<s_t, 6, NumDofs> mScrews;
+  Eigen::Vector3s mGravity;
+
+  // Scratch space, one column (or one entry) per body
+  std::array<Eigen::Isometry3s, NumBodies> mTransforms;
+  Eigen::Matrix<s_t, 6, NumBodies> mSpatialVelocities;
+  Eigen::Matrix<s_t, 6, NumBodies> mPartialAccelerations;
+  Eigen::Matrix<s_t, 6, NumBodies> mSpatialAccelerations;
+  Eigen::Matrix<s_t, 6, NumBodies> mBiasForces;
+  std::array<Eigen::Matrix6s, NumBodies> mArticulatedInertias;
+
+  // Scratch space, one column (or one entry) per DOF
+  Eigen::Matrix<s_t, 6, NumDofs> mS;
+  Eigen::Matrix<s_t, 6, NumDofs> mdS;
+  // = I^A * S
+  Eigen::Matrix<s_t, 6, NumDofs> mU;
+  // = (S^T * I^A * S)^-1, stored as a K x K block in the top rows of the
+  // columns for each joint
+  Eigen::Matrix<s_t, 6, NumDofs> mDInv;
+  // = force - S^T * (I^A * c + p)
+  VectorDofs mTotalForce;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#include "dart/dynamics/detail/FixedTopologyFeatherstone.hpp"
+
+#endif
@@ -33,7 +33,10 @@
 #include "dart/dynamics/MeshShape.hpp"
 
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <assimp/DefaultLogger.hpp>
 #include <assimp/Importer.hpp>
@@ -160,6 +163,49 @@ SharedMeshWrapper::~SharedMeshWrapper()
   aiReleaseImport(mesh);
 }
 
+//==============================================================================
+/// This returns the convex hull of every vertex in the mesh, which collision
+/// detection uses for support queries. It's built on the first call and
+/// cached after that, so it's shared by every MeshShape using this mesh. This
+/// is safe to call from several threads at once.
+std::shared_ptr<const math::ConvexHull3D> SharedMeshWrapper::getConvexHull()
+{
+  std::shared_ptr<const math::ConvexHull3D> hull
+      = std::atomic_load(&mConvexHull);
+  if (hull || mesh == nullptr)
+    return hull;
+
+  // Only one thread builds the hull, and the others wait for it
+  const std::lock_guard<std::mutex> lock(mConvexHullMutex);
+  hull = std::atomic_load(&mConvexHull);
+  if (hull)
+    return hull;
+
+  std::vector<Eigen::Vector3s> vertices;
+  for (unsigned int s = 0; s < mesh->mNumMeshes; s++)
+  {
+    const aiMesh* m = mesh->mMeshes[s];
+    for (unsigned int v = 0; v < m->mNumVertices; v++)
+    {
+      vertices.emplace_back(
+          m->mVertices[v].x, m->mVertices[v].y, m->mVertices[v].z);
+    }
+  }
+  hull = std::make_shared<const math::ConvexHull3D>(vertices);
+  std::atomic_store(&mConvexHull, hull);
+  return hull;
+}
+
+//==============================================================================
+/// This drops the cached convex hull, so the next call to getConvexHull()
+/// rebuilds it. Call this after editing the vertices of the mesh in place.
+void SharedMeshWrapper::clearConvexHull()
+{
+  const std::lock_guard<std::mutex> lock(mConvexHullMutex);
+  std::atomic_store(
+      &mConvexHull, std::shared_ptr<const math::ConvexHull3D>(nullptr));
+}
+
 //==============================================================================
 MeshShape::MeshShape(
     const Eigen::Vector3s& scale,
@@ -233,6 +279,17 @@ std::vector<Eigen::Vector3s> MeshShape::getVertices() const
   return vertices;
 }
 
+//==============================================================================
+/// This returns the (unscaled) convex hull of the mesh vertices, which is
+/// built the first time it's asked for, and shared with every other
+/// MeshShape using the same mesh. Returns nullptr if there's no mesh.
+std::shared_ptr<const math::ConvexHull3D> MeshShape::getConvexHull() const
+{
+  if (!mMesh)
+    return nullptr;
+  return mMesh->getConvexHull();
+}
+
 //==============================================================================
 const aiScene* MeshShape::getMesh() const
 {
@@ -33,6 +33,8 @@
 #ifndef DART_DYNAMICS_MESHSHAPE_HPP_
 #define DART_DYNAMICS_MESHSHAPE_HPP_
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -40,6 +42,7 @@
 
 #include "dart/common/ResourceRetriever.hpp"
 #include "dart/dynamics/Shape.hpp"
+#include "dart/math/ConvexHull3D.hpp"
 
 namespace dart {
 namespace dynamics {
@@ -49,7 +52,21 @@ struct SharedMeshWrapper
   SharedMeshWrapper(const aiScene* mesh);
   ~SharedMeshWrapper();
 
+  /// This returns the convex hull of every vertex in the mesh, which collision
+  /// detection uses for support queries. It's built on the first call and
+  /// cached after that, so it's shared by every MeshShape using this mesh. This
+  /// is safe to call from several threads at once.
+  std::shared_ptr<const math::ConvexHull3D> getConvexHull();
+
+  /// This drops the cached convex hull, so the next call to getConvexHull()
+  /// rebuilds it. Call this after editing the vertices of the mesh in place.
+  void clearConvexHull();
+
   const aiScene* mesh;
+
+protected:
+  std::shared_ptr<const math::ConvexHull3D> mConvexHull;
+  std::mutex mConvexHullMutex;
 };
 
 class MeshShape : public Shape
@@ -112,6 +129,11 @@ public:
 
   std::vector<Eigen::Vector3s> getVertices() const;
 
+  /// This returns the (unscaled) convex hull of the mesh vertices, which is
+  /// built the first time it's asked for, and shared with every other
+  /// MeshShape using the same mesh. Returns nullptr if there's no mesh.
+  std::shared_ptr<const math::ConvexHull3D> getConvexHull() const;
+
   /// Updates positions of the vertices or the elements. By default, this does
   /// nothing; you must extend the MeshShape class and implement your own
   /// version of this function if you want the mesh data to get updated before
@@ -5882,6 +5882,111 @@ Eigen::VectorXs Skeleton::convertPositionsFromBallSpace(Eigen::VectorXs pos)
   return translated;
 }
 
+//==============================================================================
+void Skeleton::getBodyWorldTransforms(
+    std::vector<Eigen::Isometry3s>& worldTransforms)
+{
+  worldTransforms.resize(mSkelCache.mBodyNodes.size());
+  for (std::size_t i = 0; i < mSkelCache.mBodyNodes.size(); i++)
+  {
+    BodyNode* body = mSkelCache.mBodyNodes[i];
+    BodyNode* parent = body->getParentBodyNode();
+    // Parents are always registered before their children
+    assert(parent == nullptr || parent->getIndexInSkeleton() < i);
+    worldTransforms[i]
+        = (parent == nullptr
+               ? body->getParentFrame()->getWorldTransform()
+               : worldTransforms[parent->getIndexInSkeleton()])
+          * body->getRelativeTransform();
+  }
+}
+
+//==============================================================================
+int Skeleton::setPositionsAndUpdateBodyWorldTransforms(
+    const std::vector<std::size_t>& dofs,
+    const Eigen::VectorXs& positions,
+    std::vector<Eigen::Isometry3s>& worldTransforms)
+{
+  assert(dofs.size() == positions.size());
+  if (worldTransforms.size() != mSkelCache.mBodyNodes.size())
+  {
+    setPositions(dofs, positions);
+    getBodyWorldTransforms(worldTransforms);
+    return worldTransforms.size();
+  }
+
+  // 1. Set the DOFs, and note the child of every joint that actually moved.
+  // Setting a joint's position only dirties that joint's relative transform,
+  // so the joints we don't touch keep their cached ones.
+  std::vector<BodyNode*> movedBodies;
+  movedBodies.reserve(dofs.size());
+  for (std::size_t i = 0; i < dofs.size(); i++)
+  {
+    DegreeOfFreedom* dof = mSkelCache.mDofs[dofs[i]];
+    if (dof->getPosition() == positions(i))
+    {
+      continue;
+    }
+    dof->setPosition(positions(i));
+    movedBodies.push_back(dof->getChildBodyNode());
+  }
+
+  // 2. Recompute the subtree below each moved body, unless it's already inside
+  // another moved body's subtree
+  int numUpdated = 0;
+  for (std::size_t i = 0; i < movedBodies.size(); i++)
+  {
+    bool covered = false;
+    for (std::size_t j = 0; j < movedBodies.size() && !covered; j++)
+    {
+      if (j == i)
+      {
+        continue;
+      }
+      if (movedBodies[j] == movedBodies[i])
+      {
+        // A multi-DOF joint, which we only want to visit once
+        covered = j < i;
+        continue;
+      }
+      for (BodyNode* ancestor = movedBodies[i]->getParentBodyNode();
+           ancestor != nullptr;
+           ancestor = ancestor->getParentBodyNode())
+      {
+        if (ancestor == movedBodies[j])
+        {
+          covered = true;
+          break;
+        }
+      }
+    }
+    if (!covered)
+    {
+      numUpdated
+          += updateBodyWorldTransformSubtree(movedBodies[i], worldTransforms);
+    }
+  }
+  return numUpdated;
+}
+
+//==============================================================================
+int Skeleton::updateBodyWorldTransformSubtree(
+    BodyNode* body, std::vector<Eigen::Isometry3s>& worldTransforms)
+{
+  BodyNode* parent = body->getParentBodyNode();
+  worldTransforms[body->getIndexInSkeleton()]
+      = (parent == nullptr ? body->getParentFrame()->getWorldTransform()
+                           : worldTransforms[parent->getIndexInSkeleton()])
+        * body->getRelativeTransform();
+  int numUpdated = 1;
+  for (std::size_t i = 0; i < body->getNumChildBodyNodes(); i++)
+  {
+    numUpdated += updateBodyWorldTransformSubtree(
+        body->getChildBodyNode(i), worldTransforms);
+  }
+  return numUpdated;
+}
+
 //==============================================================================
 /// This returns the concatenated 3-vectors for world positions of each joint
 /// in 3D world space, for the registered source joints.
@@ -5966,6 +6071,57 @@ Eigen::MatrixXs Skeleton::getJointWorldPositionsJacobianWrtJointPositions(
   return jac;
 }
 
+//==============================================================================
+/// This fills in the 3 rows starting at `row` of a Jacobian of the world
+/// position `worldPoint`, rigidly attached to `body`, wrt joint positions. Only
+/// the DOFs that `body` depends on get entries.
+static void appendWorldPointJacobianWrtJointPositions(
+    const dynamics::BodyNode* body,
+    const Eigen::Vector3s& worldPoint,
+    int row,
+    std::vector<Eigen::Triplet<s_t>>& triplets)
+{
+  const Skeleton* skel = body->getSkeleton().get();
+  for (std::size_t dofIndex : body->getDependentGenCoordIndices())
+  {
+    const dynamics::DegreeOfFreedom* dof = skel->getDof(dofIndex);
+    const Eigen::Vector6s screw
+        = dof->getJoint()->getWorldAxisScrewForPosition(dof->getIndexInJoint());
+    const Eigen::Vector3s col
+        = screw.tail<3>() + screw.head<3>().cross(worldPoint);
+    for (int axis = 0; axis < 3; axis++)
+    {
+      triplets.emplace_back(row + axis, dofIndex, col(axis));
+    }
+  }
+}
+
+//==============================================================================
+/// This is the same as getJointWorldPositionsJacobianWrtJointPositions(), but
+/// only stores the entries for each joint's ancestor DOFs.
+Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+Skeleton::getSparseJointWorldPositionsJacobianWrtJointPositions(
+    const std::vector<dynamics::Joint*>& joints) const
+{
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  for (int i = 0; i < joints.size(); i++)
+  {
+    const dynamics::BodyNode* childBody = joints[i]->getChildBodyNode();
+    triplets.reserve(
+        triplets.size() + 3 * childBody->getNumDependentGenCoords());
+    const Eigen::Vector3s worldPos
+        = childBody->getWorldTransform()
+          * joints[i]->getTransformFromChildBodyNode().translation();
+    appendWorldPointJacobianWrtJointPositions(
+        childBody, worldPos, 3 * i, triplets);
+  }
+
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor> jac(
+      joints.size() * 3, getNumDofs());
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
 //==============================================================================
 /// This returns the Jacobian relating changes in source skeleton joint
 /// positions to changes in source joint world positions.
@@ -6112,6 +6268,72 @@ Eigen::MatrixXs Skeleton::getJointWorldPositionsJacobianWrtBodyScales(
   return jac;
 }
 
+//==============================================================================
+/// This fills in the 3 rows starting at `row` of a Jacobian wrt body scales,
+/// for a point that's attached downstream of `childJoint`. Scaling any body
+/// above `childJoint` moves the point by that body's parent joint offset plus
+/// its offset to the next joint down the chain, so only those bodies get
+/// entries.
+static void appendAncestorBodyScaleJacobian(
+    const dynamics::Joint* childJoint,
+    int row,
+    std::vector<Eigen::Triplet<s_t>>& triplets)
+{
+  const dynamics::BodyNode* bodyNode = childJoint->getParentBodyNode();
+  while (bodyNode != nullptr)
+  {
+    const int col = bodyNode->getIndexInSkeleton() * 3;
+    for (int axis = 0; axis < 3; axis++)
+    {
+      const Eigen::Vector3s offset
+          = bodyNode->getParentJoint()
+                ->getWorldTranslationOfChildBodyWrtChildScale(axis)
+            + childJoint->getWorldTranslationOfChildBodyWrtParentScale(axis);
+      for (int k = 0; k < 3; k++)
+      {
+        triplets.emplace_back(row + k, col + axis, offset(k));
+      }
+    }
+    childJoint = bodyNode->getParentJoint();
+    bodyNode = bodyNode->getParentBodyNode();
+  }
+}
+
+//==============================================================================
+/// This is the same as getJointWorldPositionsJacobianWrtBodyScales(), but only
+/// stores the entries for the bodies on each joint's ancestor chain.
+Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+Skeleton::getSparseJointWorldPositionsJacobianWrtBodyScales(
+    const std::vector<dynamics::Joint*>& joints)
+{
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  for (int j = 0; j < joints.size(); j++)
+  {
+    // The child body of the joint only moves the joint by scaling the offset
+    // from the parent body, since the joint isn't attached to the child offset
+    const dynamics::BodyNode* childBody = joints[j]->getChildBodyNode();
+    const int col = childBody->getIndexInSkeleton() * 3;
+    for (int axis = 0; axis < 3; axis++)
+    {
+      const Eigen::Vector3s offset
+          = joints[j]->getWorldTranslationOfChildBodyWrtChildScale(axis)
+            - joints[j]->Joint::getWorldTranslationOfChildBodyWrtChildScale(
+                axis);
+      for (int k = 0; k < 3; k++)
+      {
+        triplets.emplace_back(j * 3 + k, col + axis, offset(k));
+      }
+    }
+
+    appendAncestorBodyScaleJacobian(joints[j], j * 3, triplets);
+  }
+
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor> jac(
+      joints.size() * 3, getNumBodyNodes() * 3);
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
 //==============================================================================
 /// This returns the Jacobian relating changes in source skeleton body scales
 /// to changes in source joint world positions.
@@ -6567,6 +6789,21 @@ Eigen::VectorXs Skeleton::getMarkerWorldPositions(
   return positions;
 }
 
+//==============================================================================
+Eigen::VectorXs Skeleton::getMarkerWorldPositions(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const std::vector<Eigen::Isometry3s>& bodyWorldTransforms)
+{
+  Eigen::VectorXs positions = Eigen::VectorXs::Zero(markers.size() * 3);
+  for (int i = 0; i < markers.size(); i++)
+  {
+    positions.segment<3>(i * 3)
+        = bodyWorldTransforms[markers[i].first->getIndexInSkeleton()]
+          * markers[i].first->getScale().cwiseProduct(markers[i].second);
+  }
+  return positions;
+}
+
 //==============================================================================
 /// This returns the Jacobian relating changes in source skeleton joint
 /// positions to changes in source joint world positions.
@@ -6588,6 +6825,31 @@ Eigen::MatrixXs Skeleton::getMarkerWorldPositionsJacobianWrtJointPositions(
   return jac;
 }
 
+//==============================================================================
+/// This is the same as getMarkerWorldPositionsJacobianWrtJointPositions(), but
+/// only stores the entries for each marker's ancestor DOFs.
+Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+Skeleton::getSparseMarkerWorldPositionsJacobianWrtJointPositions(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+    const
+{
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  for (int i = 0; i < markers.size(); i++)
+  {
+    const dynamics::BodyNode* body = markers[i].first;
+    triplets.reserve(triplets.size() + 3 * body->getNumDependentGenCoords());
+    const Eigen::Vector3s worldPos
+        = body->getWorldTransform()
+          * body->getScale().cwiseProduct(markers[i].second);
+    appendWorldPointJacobianWrtJointPositions(body, worldPos, 3 * i, triplets);
+  }
+
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor> jac(
+      markers.size() * 3, getNumDofs());
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
 //==============================================================================
 /// This returns the Jacobian relating changes in source skeleton joint
 /// positions to changes in source joint world positions.
@@ -6684,6 +6946,42 @@ Eigen::MatrixXs Skeleton::getMarkerWorldPositionsJacobianWrtBodyScales(
   return jac;
 }
 
+//==============================================================================
+/// This is the same as getMarkerWorldPositionsJacobianWrtBodyScales(), but
+/// only stores the entries for the bodies on each marker's ancestor chain.
+Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+Skeleton::getSparseMarkerWorldPositionsJacobianWrtBodyScales(
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+{
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  for (int j = 0; j < markers.size(); j++)
+  {
+    // The body the marker is attached to also scales the marker offset
+    const dynamics::BodyNode* bodyNode = markers[j].first;
+    const Eigen::Matrix3s R = bodyNode->getWorldTransform().linear();
+    const int col = bodyNode->getIndexInSkeleton() * 3;
+    for (int axis = 0; axis < 3; axis++)
+    {
+      const Eigen::Vector3s offset
+          = (R.col(axis) * markers[j].second(axis))
+            + bodyNode->getParentJoint()
+                  ->getWorldTranslationOfChildBodyWrtChildScale(axis);
+      for (int k = 0; k < 3; k++)
+      {
+        triplets.emplace_back(j * 3 + k, col + axis, offset(k));
+      }
+    }
+
+    appendAncestorBodyScaleJacobian(
+        bodyNode->getParentJoint(), j * 3, triplets);
+  }
+
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor> jac(
+      markers.size() * 3, getNumBodyNodes() * 3);
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
 //==============================================================================
 /// This returns the Jacobian relating changes in body scales to changes in
 /// marker world positions.
@@ -7030,14 +7328,6 @@ Skeleton::getMarkerWorldPositionsSecondJacobianWrtJointWrtJointPositions(
     dofJointIndices.push_back(getJointIndex(dofJoints[j]));
   }
 
-  std::vector<dynamics::Joint*> markerSourceJoints;
-  std::vector<int> markerSourceJointIndices;
-  for (int i = 0; i < markers.size(); i++)
-  {
-    markerSourceJoints.push_back(markers[i].first->getParentJoint());
-    markerSourceJointIndices.push_back(getJointIndex(markerSourceJoints[i]));
-  }
-
   const Eigen::VectorXs worldMarkers = getMarkerWorldPositions(markers);
   const Eigen::MatrixXi& parentMap = getJointParentMap();
 
@@ -7046,122 +7336,91 @@ Skeleton::getMarkerWorldPositionsSecondJacobianWrtJointWrtJointPositions(
   // column vector, and building a Jacobian of how that vector changes as we
   // change joint positions.
 
-  for (int col = 0; col < getNumDofs(); col++)
+  // A marker only moves with the DOFs of its body's ancestor joints, so both
+  // the DOF we're differentiating wrt (`index`) and the column of the Jacobian
+  // (`j`) only ever need to range over those. Every other entry is exactly
+  // zero, so we never touch it. This keeps the cost proportional to the sum
+  // of the squared chain lengths, rather than markers * dofs^2.
+  for (int i = 0; i < markers.size(); i++)
   {
-    const int index = col;
+    const Eigen::Vector3s weight = leftMultiply.segment<3>(i * 3);
+    if (weight.isZero())
+    {
+      // This marker contributes nothing to J.transpose()*leftMultiply
+      continue;
+    }
 
-    // Here's the original version, not optimized
+    const Eigen::Vector3s worldMarker = worldMarkers.segment<3>(i * 3);
+    const std::vector<std::size_t>& markerDofs
+        = markers[i].first->getDependentGenCoordIndices();
 
-    // result.col(col)
-    //     = getMarkerWorldPositionsDerivativeOfJacobianWrtJointsWrtJoints(
-    //           markers, col)
-    //           .transpose()
-    //       * leftMultiply;
+    for (std::size_t index : markerDofs)
+    {
+      // Differentiating the whole mess wrt this joint
+      const dynamics::Joint* rootJoint = dofJoints[index];
+      const Eigen::Vector6s& rootScrew = dofScrews[index];
+      const int rootJointIndex = dofJointIndices[index];
 
-    // It turns out that calling
-    // getMarkerWorldPositionsDerivativeOfJacobianWrtJointsWrtJoints()
-    // in a tight inner loop actually wastes a lot of inefficient index
-    // lookups in Skeleton, so instead we can cache so data outside of the
-    // loop
+      // Every DOF in markerDofs is an ancestor of this marker, so rotating the
+      // root always moves the marker
+      const Eigen::Vector3s markerGradWrtRoot
+          = math::gradientWrtTheta(rootScrew, worldMarker, 0.0);
 
-    Eigen::MatrixXs jac
-        = Eigen::MatrixXs::Zero(markers.size() * 3, getNumDofs());
+      for (std::size_t j : markerDofs)
+      {
+        dynamics::Joint* parentJoint = dofJoints[j];
+        const Eigen::Vector6s& screw = dofScrews[j];
+        const int parentJointIndex = dofJointIndices[j];
 
-    // Differentiating the whole mess wrt this joint
-    const dynamics::Joint* rootJoint = dofJoints[index];
-    const Eigen::Vector6s rootScrew = dofScrews[index];
-    const int rootJointIndex = dofJointIndices[index];
+        // The original value in this cell of the Jacobian is the following
 
-    for (int j = 0; j < getNumDofs(); j++)
-    {
-      dynamics::Joint* parentJoint = dofJoints[j];
-      const Eigen::Vector6s screw = dofScrews[j];
-      const int parentJointIndex = dofJointIndices[j];
-      for (int i = 0; i < markers.size(); i++)
-      {
-        dynamics::Joint* sourceJoint = markerSourceJoints[i];
-        int sourceJointIndex = markerSourceJointIndices[i];
+        /*
+        jac.block<3, 1>(i * 3, j) = math::gradientWrtTheta(
+            screw, worldMarkers.segment<3>(i * 3), 0.0);
+        */
+
+        Eigen::Vector3s entry;
 
-        /// getDofParentMap(i,j) == 1: Dof[i] is a parent of Dof[j]
-        /// getDofParentMap(i,j) == 0: Dof[i] is NOT a parent of Dof[j]
-        if (parentMap(parentJointIndex, sourceJointIndex) == 1
-            || sourceJoint == parentJoint)
+        // There's a special case if the root is the parent of both the DOF
+        // for this column of the Jac, _and_ of the marker. That means that
+        // all we're doing is rotating (and translating, but that's
+        // irrelevant) the joint-marker system. So all we need is the gradient
+        // of the rotation.
+        if (parentMap(rootJointIndex, parentJointIndex) == 1)
         {
-          // The original value in this cell is the following
+          Eigen::Vector3s originalJac
+              = math::gradientWrtTheta(screw, worldMarker, 0.0);
+          entry = math::gradientWrtThetaPureRotation(
+              rootScrew.head<3>(), originalJac, 0);
+        }
+        else
+        {
+          // We'll use the sum-product rule, so we need to individually
+          // differentiate both terms (`screw` and `markerPos`) wrt the root
+          // joint's theta term.
 
-          /*
-          jac.block<3, 1>(i * 3, j) = math::gradientWrtTheta(
-              screw, worldMarkers.segment<3>(i * 3), 0.0);
-          */
-
-          // There's a special case if the root is the parent of both the DOF
-          // for this column of the Jac, _and_ of the marker. That means that
-          // all we're doing is rotating (and translating, but that's
-          // irrelevant) the joint-marker system. So all we need is the gradient
-          // of the rotation.
-          if (parentMap(rootJointIndex, parentJointIndex) == 1)
+          // Make `screwGrad` hold the gradient of the screw with respect to
+          // root. Rotating the root joint only effects parentJoint's screw if
+          // they're the same joint.
+          Eigen::Vector6s screwGrad = Eigen::Vector6s::Zero();
+          if (rootJoint == parentJoint)
           {
-            Eigen::Vector3s originalJac = math::gradientWrtTheta(
-                screw, worldMarkers.segment<3>(i * 3), 0.0);
-            jac.block<3, 1>(i * 3, j) = math::gradientWrtThetaPureRotation(
-                rootScrew.head<3>(), originalJac, 0);
+            screwGrad = parentJoint->getScrewAxisGradientForPosition(
+                dofIndexInJoint[j], dofIndexInJoint[index]);
           }
-          else
-          {
-            // We'll use the sum-product rule, so we need to individually
-            // differentiate both terms (`screw` and `markerPos`) wrt the root
-            // joint's theta term.
-
-            // Make `screwGrad` hold the gradient of the screw with respect to
-            // root
-
-            Eigen::Vector6s screwGrad = Eigen::Vector6s::Zero();
-
-            if (rootJoint == parentJoint)
-            {
-              int axisIndex
-                  = dofIndexInJoint[j]; // getDof(j)->getIndexInJoint();
-              int rotateIndex
-                  = dofIndexInJoint[index]; // getDof(index)->getIndexInJoint();
-              screwGrad = parentJoint->getScrewAxisGradientForPosition(
-                  axisIndex, rotateIndex);
-            }
-            else
-            {
-              // Otherwise rotating the root joint doesn't effect parentJoint's
-              // screw
-              screwGrad.setZero();
-            }
-
-            // `screwGrad` now holds the gradient of the screw with respect to
-            // root.
 
-            // Now we need the marker position's gradient wrt the root axis
-
-            Eigen::Vector3s markerGradWrtRoot = Eigen::Vector3s::Zero();
-
-            if (parentMap(rootJointIndex, sourceJointIndex) == 1
-                || (rootJoint == sourceJoint))
-            {
-              markerGradWrtRoot = math::gradientWrtTheta(
-                  rootScrew, worldMarkers.segment<3>(i * 3), 0.0);
-            }
-
-            // Now we just need to apply the product rule to get the final
-            // result
-
-            Eigen::Vector3s partA = math::gradientWrtTheta(
-                screwGrad, worldMarkers.segment<3>(i * 3), 0.0);
-            Eigen::Vector3s partB = math::gradientWrtThetaPureRotation(
-                screw.head<3>(), markerGradWrtRoot, 0.0);
-
-            jac.block<3, 1>(i * 3, j) = partA + partB;
-          }
+          // Now we just need to apply the product rule to get the final
+          // result
+          Eigen::Vector3s partA
+              = math::gradientWrtTheta(screwGrad, worldMarker, 0.0);
+          Eigen::Vector3s partB = math::gradientWrtThetaPureRotation(
+              screw.head<3>(), markerGradWrtRoot, 0.0);
+          entry = partA + partB;
         }
+
+        result(j, index) += entry.dot(weight);
       }
     }
-
-    result.col(col) = jac.transpose() * leftMultiply;
   }
 
   return result;
@@ -37,6 +37,8 @@
 #include <memory>
 #include <mutex>
 
+#include <Eigen/Sparse>
+
 #include "dart/common/NameManager.hpp"
 #include "dart/common/VersionCounter.hpp"
 #include "dart/dynamics/EndEffector.hpp"
@@ -1319,6 +1321,29 @@ public:
   // skeletons)
   //----------------------------------------------------------------------------
 
+  /// This fills `worldTransforms` with the world transform of every BodyNode,
+  /// indexed by getIndexInSkeleton(), computing each one from its parent's
+  /// entry in the buffer.
+  void getBodyWorldTransforms(std::vector<Eigen::Isometry3s>& worldTransforms);
+
+  /// This sets just the DOFs at `dofs` (indices into the skeleton) to
+  /// `positions`, and brings `worldTransforms` up to date by recomputing only
+  /// the subtrees below joints whose positions actually changed. Each
+  /// recomputed body costs one product of its parent's entry in the buffer
+  /// with its joint's relative transform, and the rest of the buffer is left
+  /// alone. This is meant for IK loops that nudge a few DOFs at a time, like
+  /// coordinate sweeps and finite differencing.
+  ///
+  /// `worldTransforms` must hold the result of the last call to this or to
+  /// getBodyWorldTransforms(), with no other position or scale changes in
+  /// between. If it's the wrong size, it's filled from scratch instead.
+  ///
+  /// Returns the number of BodyNode transforms that were recomputed.
+  int setPositionsAndUpdateBodyWorldTransforms(
+      const std::vector<std::size_t>& dofs,
+      const Eigen::VectorXs& positions,
+      std::vector<Eigen::Isometry3s>& worldTransforms);
+
   /// This returns the concatenated 3-vectors for world positions of each joint
   /// in 3D world space, for the registered joints.
   Eigen::VectorXs getJointWorldPositions(
@@ -1341,6 +1366,14 @@ public:
   Eigen::MatrixXs getJointWorldPositionsJacobianWrtJointPositions(
       const std::vector<dynamics::Joint*>& joints) const;
 
+  /// This is the same as getJointWorldPositionsJacobianWrtJointPositions(),
+  /// but only stores the entries for each joint's ancestor DOFs, which are the
+  /// only ones that can move it. Rows are stored contiguously (CSR), so
+  /// products with the transpose stay cheap on large skeletons.
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+  getSparseJointWorldPositionsJacobianWrtJointPositions(
+      const std::vector<dynamics::Joint*>& joints) const;
+
   /// This returns the Jacobian relating changes in source skeleton joint
   /// positions to changes in source joint world positions.
   Eigen::MatrixXs finiteDifferenceJointWorldPositionsJacobianWrtJointPositions(
@@ -1362,6 +1395,12 @@ public:
   Eigen::MatrixXs getJointWorldPositionsJacobianWrtBodyScales(
       const std::vector<dynamics::Joint*>& joints);
 
+  /// This is the same as getJointWorldPositionsJacobianWrtBodyScales(), but
+  /// only stores the entries for the bodies on each joint's ancestor chain.
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+  getSparseJointWorldPositionsJacobianWrtBodyScales(
+      const std::vector<dynamics::Joint*>& joints);
+
   /// This returns the Jacobian relating changes in source skeleton body scales
   /// to changes in source joint world positions.
   Eigen::MatrixXs finiteDifferenceJointWorldPositionsJacobianWrtBodyScales(
@@ -1477,12 +1516,30 @@ public:
       const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
           markers);
 
+  /// This is the same as getMarkerWorldPositions(), but reads the body
+  /// transforms out of a buffer kept up to date by getBodyWorldTransforms() or
+  /// setPositionsAndUpdateBodyWorldTransforms()
+  Eigen::VectorXs getMarkerWorldPositions(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const std::vector<Eigen::Isometry3s>& bodyWorldTransforms);
+
   /// This returns the Jacobian relating changes in joint
   /// positions to changes in marker world positions.
   Eigen::MatrixXs getMarkerWorldPositionsJacobianWrtJointPositions(
       const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
           markers) const;
 
+  /// This is the same as getMarkerWorldPositionsJacobianWrtJointPositions(),
+  /// but only stores the entries for each marker's ancestor DOFs, which are
+  /// the only ones that can move it. Rows are stored contiguously (CSR), so
+  /// products with this and its transpose cost time proportional to the
+  /// number of nonzeros, rather than markers * DOFs.
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+  getSparseMarkerWorldPositionsJacobianWrtJointPositions(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers) const;
+
   /// This returns the Jacobian relating changes in joint
   /// positions to changes in marker world positions.
   Eigen::MatrixXs finiteDifferenceMarkerWorldPositionsJacobianWrtJointPositions(
@@ -1495,6 +1552,13 @@ public:
       const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
           markers);
 
+  /// This is the same as getMarkerWorldPositionsJacobianWrtBodyScales(), but
+  /// only stores the entries for the bodies on each marker's ancestor chain.
+  Eigen::SparseMatrix<s_t, Eigen::RowMajor>
+  getSparseMarkerWorldPositionsJacobianWrtBodyScales(
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers);
+
   /// This returns the Jacobian relating changes in body scales to changes in
   /// marker world positions.
   Eigen::MatrixXs finiteDifferenceMarkerWorldPositionsJacobianWrtBodyScales(
@@ -2692,6 +2756,12 @@ protected:
   /// Register a BodyNode with the Skeleton. Internal use only.
   void registerBodyNode(BodyNode* _newBodyNode);
 
+  /// This recomputes the entries of `worldTransforms` for `body` and everything
+  /// below it, from the entry for its parent, and returns how many it
+  /// recomputed
+  int updateBodyWorldTransformSubtree(
+      BodyNode* body, std::vector<Eigen::Isometry3s>& worldTransforms);
+
   /// Register a Joint with the Skeleton. Internal use only.
   void registerJoint(Joint* _newJoint);
 
@@ -0,0 +1,550 @@
+#ifndef DART_DYNAMICS_DETAIL_FIXED_TOPOLOGY_FEATHERSTONE
+#define DART_DYNAMICS_DETAIL_FIXED_TOPOLOGY_FEATHERSTONE
+
+#include "dart/common/Console.hpp"
+#include "dart/dynamics/FixedTopologyFeatherstone.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace dart {
+namespace dynamics {
+
+//==============================================================================
+template <int K>
+void computeFixedTopologyJoint(
+    FixedTopologyJointType type,
+    const Eigen::Matrix<s_t, 6, K>& screws,
+    const Eigen::Matrix<s_t, K, 1>& pos,
+    const Eigen::Matrix<s_t, K, 1>& vel,
+    /* OUT */ Eigen::Isometry3s& transform,
+    /* OUT */ Eigen::Matrix<s_t, 6, K>& S,
+    /* OUT */ Eigen::Matrix<s_t, 6, K>& dS)
+{
+  if constexpr (K == 3)
+  {
+    if (type == FixedTopologyJointType::BALL)
+    {
+      // See BallJoint::getRelativeJacobianStatic()
+      transform.setIdentity();
+      transform.linear() = math::expMapRot(pos);
+      S.template topRows<3>() = math::so3RightJacobian(pos);
+      S.template bottomRows<3>().setZero();
+      dS.template topRows<3>() = math::so3RightJacobianTimeDeriv(pos, vel);
+      dS.template bottomRows<3>().setZero();
+      return;
+    }
+  }
+  if constexpr (K == 6)
+  {
+    if (type == FixedTopologyJointType::FREE)
+    {
+      // See FreeJoint::getRelativeJacobianStatic()
+      const Eigen::Vector3s w = pos.template head<3>();
+      const Eigen::Matrix3s R = math::expMapRot(w);
+      const Eigen::Matrix3s Jr = math::so3RightJacobian(w);
+      transform.setIdentity();
+      transform.linear() = R;
+      transform.translation() = pos.template tail<3>();
+      S.setZero();
+      S.template topLeftCorner<3, 3>() = Jr;
+      S.template bottomRightCorner<3, 3>() = R.transpose();
+      dS.setZero();
+      dS.template topLeftCorner<3, 3>()
+          = math::so3RightJacobianTimeDeriv(w, vel.template head<3>());
+      dS.template bottomRightCorner<3, 3>()
+          = math::makeSkewSymmetric(Jr * -vel.template head<3>())
+            * R.transpose();
+      return;
+    }
+  }
+
+  // Everything else is a product of exponentials,
+  // G = exp(A_0 q_0) * ... * exp(A_n q_n). We walk from the distal end, so
+  // that `transform` holds everything after DOF j. Then the j'th column of the
+  // body Jacobian is Ad(transform^-1) A_j, and its time derivative is
+  // -ad(V, S_j), where V is the velocity that the DOFs after j contribute.
+  // Weld joints have no DOFs, and never move.
+  transform.setIdentity();
+  if constexpr (K > 0)
+  {
+    Eigen::Vector6s distalVelocity = Eigen::Vector6s::Zero();
+    for (int j = K - 1; j >= 0; j--)
+    {
+      const Eigen::Vector6s screw = screws.col(j);
+      const Eigen::Vector6s column = math::AdInvT(transform, screw);
+      S.col(j) = column;
+      dS.col(j) = -math::ad(distalVelocity, column);
+      distalVelocity += column * vel(j);
+      transform = math::expMap(screw * pos(j)) * transform;
+    }
+  }
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::FixedTopologyFeatherstone()
+{
+  for (int i = 0; i < NumBodies; i++)
+  {
+    mJointTypes[i] = FixedTopologyJointType::SCREW_CHAIN;
+    mTransformFromParent[i].setIdentity();
+    mInverseTransformFromChild[i].setIdentity();
+    mAdTransformFromChild[i].setIdentity();
+    mInertia[i].setIdentity();
+    mTransforms[i].setIdentity();
+    mArticulatedInertias[i].setZero();
+  }
+  mScrews.setZero();
+  mGravity.setZero();
+  mSpatialVelocities.setZero();
+  mPartialAccelerations.setZero();
+  mSpatialAccelerations.setZero();
+  mBiasForces.setZero();
+  mS.setZero();
+  mdS.setZero();
+  mU.setZero();
+  mDInv.setZero();
+  mTotalForce.setZero();
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+bool FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    populateFromSkeleton(const std::shared_ptr<Skeleton>& skeleton)
+{
+  std::vector<FixedTopologyJoint> joints;
+  if (!extractFixedTopology(skeleton, joints))
+  {
+    return false;
+  }
+  if (!setJoints(joints))
+  {
+    dtwarn << "[FixedTopologyFeatherstone::populateFromSkeleton] Skeleton \""
+           << skeleton->getName()
+           << "\" doesn't match this topology. The matching type is "
+           << getFixedTopologyFeatherstoneType(skeleton) << "\n";
+    return false;
+  }
+  setGravity(skeleton->getGravity());
+  return true;
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+bool FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    setJoints(const std::vector<FixedTopologyJoint>& joints)
+{
+  if (joints.size() != NumBodies)
+  {
+    return false;
+  }
+  for (int i = 0; i < NumBodies; i++)
+  {
+    const FixedTopologyJoint& joint = joints[i];
+    if (joint.numDofs != kDofs[i] || joint.parentIndex != kParents[i]
+        || joint.dofOffset != kOffsets[i])
+    {
+      return false;
+    }
+    if ((joint.type == FixedTopologyJointType::BALL && joint.numDofs != 3)
+        || (joint.type == FixedTopologyJointType::FREE && joint.numDofs != 6)
+        || (joint.type == FixedTopologyJointType::SCREW_CHAIN
+            && joint.screws.size() != joint.numDofs))
+    {
+      return false;
+    }
+  }
+
+  for (int i = 0; i < NumBodies; i++)
+  {
+    const FixedTopologyJoint& joint = joints[i];
+    mJointTypes[i] = joint.type;
+    mTransformFromParent[i] = joint.transformFromParent;
+    mInverseTransformFromChild[i] = joint.transformFromChild.inverse();
+    mAdTransformFromChild[i] = math::getAdTMatrix(joint.transformFromChild);
+    mInertia[i] = joint.inertia;
+    for (int j = 0; j < joint.screws.size(); j++)
+    {
+      mScrews.col(kOffsets[i] + j) = joint.screws[j];
+    }
+  }
+  return true;
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    setGravity(const Eigen::Vector3s& gravity)
+{
+  mGravity = gravity;
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+const Eigen::Vector3s& FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::getGravity() const
+{
+  return mGravity;
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    forwardDynamics(
+        const VectorDofs& pos,
+        const VectorDofs& vel,
+        const VectorDofs& force,
+        /* OUT */ VectorDofs& accelerations)
+{
+  forwardDynamicsImpl(
+      std::make_index_sequence<NumBodies>(), pos, vel, force, accelerations);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    inverseDynamics(
+        const VectorDofs& pos,
+        const VectorDofs& vel,
+        const VectorDofs& accelerations,
+        /* OUT */ VectorDofs& forces)
+{
+  inverseDynamicsImpl(
+      std::make_index_sequence<NumBodies>(), pos, vel, accelerations, forces);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    computeMassMatrix(const VectorDofs& pos, /* OUT */ MatrixDofs& M)
+{
+  computeMassMatrixImpl(std::make_index_sequence<NumBodies>(), pos, M);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    computeCoriolisAndGravityForces(
+        const VectorDofs& pos,
+        const VectorDofs& vel,
+        /* OUT */ VectorDofs& forces)
+{
+  inverseDynamics(pos, vel, VectorDofs::Zero(), forces);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <std::size_t... Is>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    forwardDynamicsImpl(
+        std::index_sequence<Is...>,
+        const VectorDofs& pos,
+        const VectorDofs& vel,
+        const VectorDofs& force,
+        VectorDofs& accelerations)
+{
+  // Forward pass
+  (updateKinematics<Is>(pos, vel), ...);
+  // Backward pass
+  (backwardArticulatedInertia<NumBodies - 1 - (int)Is>(force), ...);
+  // Last forward pass
+  (forwardAcceleration<Is>(accelerations), ...);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <std::size_t... Is>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    inverseDynamicsImpl(
+        std::index_sequence<Is...>,
+        const VectorDofs& pos,
+        const VectorDofs& vel,
+        const VectorDofs& accelerations,
+        VectorDofs& forces)
+{
+  (updateKinematics<Is>(pos, vel), ...);
+  (forwardNewtonEuler<Is>(accelerations), ...);
+  (backwardNewtonEuler<NumBodies - 1 - (int)Is>(forces), ...);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <std::size_t... Is>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    computeMassMatrixImpl(
+        std::index_sequence<Is...>, const VectorDofs& pos, MatrixDofs& M)
+{
+  const VectorDofs vel = VectorDofs::Zero();
+  (updateKinematics<Is>(pos, vel), ...);
+  M.setZero();
+  (backwardCompositeInertia<NumBodies - 1 - (int)Is>(M), ...);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <int I>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    updateKinematics(const VectorDofs& pos, const VectorDofs& vel)
+{
+  constexpr int K = kDofs[I];
+  constexpr int O = kOffsets[I];
+  constexpr int P = kParents[I];
+
+  Eigen::Isometry3s jointTransform = Eigen::Isometry3s::Identity();
+  Eigen::Vector6s jointVelocity = Eigen::Vector6s::Zero();
+  Eigen::Vector6s partialAcceleration = Eigen::Vector6s::Zero();
+  if constexpr (K > 0)
+  {
+    const Eigen::Matrix<s_t, 6, K> screws = mScrews.template middleCols<K>(O);
+    const Eigen::Matrix<s_t, K, 1> q = pos.template segment<K>(O);
+    const Eigen::Matrix<s_t, K, 1> dq = vel.template segment<K>(O);
+    Eigen::Matrix<s_t, 6, K> S;
+    Eigen::Matrix<s_t, 6, K> dS;
+    computeFixedTopologyJoint<K>(
+        mJointTypes[I], screws, q, dq, jointTransform, S, dS);
+    mS.template middleCols<K>(O).noalias() = mAdTransformFromChild[I] * S;
+    mdS.template middleCols<K>(O).noalias() = mAdTransformFromChild[I] * dS;
+    jointVelocity.noalias() = mS.template middleCols<K>(O) * dq;
+    partialAcceleration.noalias() = mdS.template middleCols<K>(O) * dq;
+  }
+
+  mTransforms[I] = mTransformFromParent[I] * jointTransform
+                   * mInverseTransformFromChild[I];
+
+  Eigen::Vector6s V = jointVelocity;
+  if constexpr (P >= 0)
+  {
+    V += math::AdInvT(mTransforms[I], mSpatialVelocities.col(P));
+  }
+  mSpatialVelocities.col(I) = V;
+  mPartialAccelerations.col(I)
+      = partialAcceleration + math::ad(V, jointVelocity);
+
+  // Zero out scratch space to prepare for sums in backwards pass
+  mArticulatedInertias[I].setZero();
+  mBiasForces.col(I).setZero();
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <int I>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    backwardArticulatedInertia(const VectorDofs& force)
+{
+  constexpr int K = kDofs[I];
+  constexpr int O = kOffsets[I];
+  constexpr int P = kParents[I];
+
+  Eigen::Matrix6s& IA = mArticulatedInertias[I];
+  IA += mInertia[I];
+  const Eigen::Vector6s V = mSpatialVelocities.col(I);
+  mBiasForces.col(I) -= math::dad(V, mInertia[I] * V);
+
+  const Eigen::Vector6s c = mPartialAccelerations.col(I);
+  const Eigen::Vector6s p = mBiasForces.col(I);
+  Eigen::Vector6s beta = p + IA * c;
+  Eigen::Matrix6s projectedIA = IA;
+
+  if constexpr (K > 0)
+  {
+    const Eigen::Matrix<s_t, 6, K> S = mS.template middleCols<K>(O);
+    const Eigen::Matrix<s_t, 6, K> U = IA * S;
+    const Eigen::Matrix<s_t, K, K> D = S.transpose() * U;
+    const Eigen::Matrix<s_t, K, K> DInv = D.inverse();
+    // Total force on the joint, see GenericJoint::updateTotalForceDynamic()
+    const Eigen::Matrix<s_t, K, 1> u
+        = force.template segment<K>(O) - S.transpose() * beta;
+
+    mU.template middleCols<K>(O) = U;
+    mDInv.template block<K, K>(0, O) = DInv;
+    mTotalForce.template segment<K>(O) = u;
+
+    projectedIA.noalias() -= U * DInv * U.transpose();
+    beta.noalias() += U * (DInv * u);
+  }
+
+  if constexpr (P >= 0)
+  {
+    // Sum into our parents, see GenericJoint::addChildArtInertiaToDynamic()
+    mArticulatedInertias[P]
+        += math::transformInertia(mTransforms[I].inverse(), projectedIA);
+    mBiasForces.col(P) += math::dAdInvT(mTransforms[I], beta);
+  }
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <int I>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    forwardAcceleration(/* OUT */ VectorDofs& accelerations)
+{
+  constexpr int K = kDofs[I];
+  constexpr int O = kOffsets[I];
+  constexpr int P = kParents[I];
+
+  // Gravity is handled by accelerating the world upwards
+  Eigen::Vector6s a;
+  if constexpr (P >= 0)
+  {
+    a = math::AdInvT(mTransforms[I], mSpatialAccelerations.col(P));
+  }
+  else
+  {
+    Eigen::Vector6s worldAcceleration = Eigen::Vector6s::Zero();
+    worldAcceleration.tail<3>() = -mGravity;
+    a = math::AdInvT(mTransforms[I], worldAcceleration);
+  }
+
+  if constexpr (K > 0)
+  {
+    const Eigen::Matrix<s_t, K, 1> ddq
+        = mDInv.template block<K, K>(0, O)
+          * (mTotalForce.template segment<K>(O)
+             - mU.template middleCols<K>(O).transpose() * a);
+    accelerations.template segment<K>(O) = ddq;
+    a.noalias() += mS.template middleCols<K>(O) * ddq;
+  }
+  mSpatialAccelerations.col(I) = a + mPartialAccelerations.col(I);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <int I>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    forwardNewtonEuler(const VectorDofs& accelerations)
+{
+  constexpr int K = kDofs[I];
+  constexpr int O = kOffsets[I];
+  constexpr int P = kParents[I];
+
+  Eigen::Vector6s a;
+  if constexpr (P >= 0)
+  {
+    a = math::AdInvT(mTransforms[I], mSpatialAccelerations.col(P));
+  }
+  else
+  {
+    Eigen::Vector6s worldAcceleration = Eigen::Vector6s::Zero();
+    worldAcceleration.tail<3>() = -mGravity;
+    a = math::AdInvT(mTransforms[I], worldAcceleration);
+  }
+  if constexpr (K > 0)
+  {
+    a.noalias()
+        += mS.template middleCols<K>(O) * accelerations.template segment<K>(O);
+  }
+  a += mPartialAccelerations.col(I);
+  mSpatialAccelerations.col(I) = a;
+
+  const Eigen::Vector6s V = mSpatialVelocities.col(I);
+  mBiasForces.col(I) = mInertia[I] * a - math::dad(V, mInertia[I] * V);
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <int I>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    backwardNewtonEuler(/* OUT */ VectorDofs& forces)
+{
+  constexpr int K = kDofs[I];
+  constexpr int O = kOffsets[I];
+  constexpr int P = kParents[I];
+
+  // By the time we get here, all our children have summed into our column
+  const Eigen::Vector6s f = mBiasForces.col(I);
+  if constexpr (K > 0)
+  {
+    forces.template segment<K>(O).noalias()
+        = mS.template middleCols<K>(O).transpose() * f;
+  }
+  if constexpr (P >= 0)
+  {
+    mBiasForces.col(P) += math::dAdInvT(mTransforms[I], f);
+  }
+}
+
+//==============================================================================
+template <int... Dofs, int... Parents>
+template <int I>
+void FixedTopologyFeatherstone<
+    std::integer_sequence<int, Dofs...>,
+    std::integer_sequence<int, Parents...>>::
+    backwardCompositeInertia(/* OUT */ MatrixDofs& M)
+{
+  constexpr int K = kDofs[I];
+  constexpr int O = kOffsets[I];
+  constexpr int P = kParents[I];
+
+  // We reuse the articulated inertia scratch space for the composite inertia
+  Eigen::Matrix6s& IC = mArticulatedInertias[I];
+  IC += mInertia[I];
+
+  if constexpr (K > 0)
+  {
+    Eigen::Matrix<s_t, 6, K> F = IC * mS.template middleCols<K>(O);
+    M.template block<K, K>(O, O).noalias()
+        = mS.template middleCols<K>(O).transpose() * F;
+
+    // Walk up to the root, filling in the off-diagonal blocks for each of our
+    // ancestors
+    int j = I;
+    while (kParents[j] >= 0)
+    {
+      for (int col = 0; col < K; col++)
+      {
+        F.col(col) = math::dAdInvT(mTransforms[j], F.col(col));
+      }
+      j = kParents[j];
+      if (kDofs[j] > 0)
+      {
+        M.block(kOffsets[j], O, kDofs[j], K).noalias()
+            = mS.middleCols(kOffsets[j], kDofs[j]).transpose() * F;
+        M.block(O, kOffsets[j], K, kDofs[j])
+            = M.block(kOffsets[j], O, kDofs[j], K).transpose();
+      }
+    }
+  }
+
+  if constexpr (P >= 0)
+  {
+    mArticulatedInertias[P]
+        += math::transformInertia(mTransforms[I].inverse(), IC);
+  }
+}
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
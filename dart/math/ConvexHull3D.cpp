@@ -0,0 +1,497 @@
+#include "dart/math/ConvexHull3D.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+namespace {
+
+/// A triangle of the hull under construction. Edge i runs from v[i] to
+/// v[(i + 1) % 3], and adj[i] is the face on the other side of it. Vertices
+/// are wound counter-clockwise when seen from outside the hull.
+struct HullFace
+{
+  int v[3];
+  int adj[3];
+  Eigen::Vector3s normal;
+  s_t offset;
+  /// The points that are above this face, and haven't been added to the hull
+  std::vector<int> outside;
+  bool alive;
+  bool visible;
+};
+
+s_t distanceAbove(const HullFace& face, const Eigen::Vector3s& point)
+{
+  return face.normal.dot(point) - face.offset;
+}
+
+HullFace makeFace(
+    const std::vector<Eigen::Vector3s>& points, int a, int b, int c)
+{
+  HullFace face;
+  face.v[0] = a;
+  face.v[1] = b;
+  face.v[2] = c;
+  face.adj[0] = face.adj[1] = face.adj[2] = -1;
+  face.normal = (points[b] - points[a]).cross(points[c] - points[a]);
+  face.normal.normalize();
+  face.offset = face.normal.dot(points[a]);
+  face.alive = true;
+  face.visible = false;
+  return face;
+}
+
+/// This finds which edge of `face` runs from `a` to `b`, or -1
+int findEdge(const HullFace& face, int a, int b)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    if (face.v[i] == a && face.v[(i + 1) % 3] == b)
+      return i;
+  }
+  return -1;
+}
+
+/// This hands each point in `candidates` to the first of `faces[first..]` that
+/// it's above. Points that aren't above any of them are inside the hull, and
+/// get dropped.
+void assignOutsidePoints(
+    const std::vector<Eigen::Vector3s>& points,
+    const std::vector<int>& candidates,
+    std::vector<HullFace>& faces,
+    int first,
+    s_t eps)
+{
+  for (int p : candidates)
+  {
+    for (int f = first; f < faces.size(); f++)
+    {
+      if (faces[f].alive && distanceAbove(faces[f], points[p]) > eps)
+      {
+        faces[f].outside.push_back(p);
+        break;
+      }
+    }
+  }
+}
+
+/// This runs Quickhull on `points`, and returns the surviving faces. Returns
+/// false if the points are degenerate, or if numerical trouble leaves us with
+/// a horizon that isn't a single loop.
+bool buildQuickhull(
+    const std::vector<Eigen::Vector3s>& points, std::vector<HullFace>& faces)
+{
+  const int n = points.size();
+  if (n < 4)
+    return false;
+
+  // Scale the tolerance to the size of the cloud
+  s_t maxCoord = 0;
+  for (const Eigen::Vector3s& p : points)
+  {
+    maxCoord = std::max(maxCoord, p.cwiseAbs().maxCoeff());
+  }
+  if (!std::isfinite(maxCoord))
+    return false;
+  const s_t eps = std::max(maxCoord, (s_t)1e-6) * 1e-10;
+
+  // 1. Find a starting tetrahedron, from the extreme points of the cloud
+  int extremes[6] = {0, 0, 0, 0, 0, 0};
+  for (int i = 0; i < n; i++)
+  {
+    for (int axis = 0; axis < 3; axis++)
+    {
+      if (points[i](axis) < points[extremes[axis * 2]](axis))
+        extremes[axis * 2] = i;
+      if (points[i](axis) > points[extremes[axis * 2 + 1]](axis))
+        extremes[axis * 2 + 1] = i;
+    }
+  }
+  int i0 = extremes[0];
+  int i1 = extremes[1];
+  s_t bestDist = (points[i1] - points[i0]).squaredNorm();
+  for (int axis = 1; axis < 3; axis++)
+  {
+    const s_t dist
+        = (points[extremes[axis * 2 + 1]] - points[extremes[axis * 2]])
+              .squaredNorm();
+    if (dist > bestDist)
+    {
+      bestDist = dist;
+      i0 = extremes[axis * 2];
+      i1 = extremes[axis * 2 + 1];
+    }
+  }
+  if (std::sqrt(bestDist) <= eps)
+    return false;
+
+  const Eigen::Vector3s lineDir = (points[i1] - points[i0]).normalized();
+  int i2 = -1;
+  bestDist = eps;
+  for (int i = 0; i < n; i++)
+  {
+    const Eigen::Vector3s offset = points[i] - points[i0];
+    const s_t dist = (offset - lineDir * lineDir.dot(offset)).norm();
+    if (dist > bestDist)
+    {
+      bestDist = dist;
+      i2 = i;
+    }
+  }
+  if (i2 == -1)
+    return false;
+
+  const Eigen::Vector3s planeNormal
+      = (points[i1] - points[i0]).cross(points[i2] - points[i0]).normalized();
+  int i3 = -1;
+  bestDist = eps;
+  for (int i = 0; i < n; i++)
+  {
+    const s_t dist = std::abs(planeNormal.dot(points[i] - points[i0]));
+    if (dist > bestDist)
+    {
+      bestDist = dist;
+      i3 = i;
+    }
+  }
+  if (i3 == -1)
+    return false;
+
+  // Wind the tetrahedron so every face points away from its centroid
+  faces.clear();
+  const Eigen::Vector3s centroid
+      = (points[i0] + points[i1] + points[i2] + points[i3]) / 4;
+  const int tet[4][3]
+      = {{i0, i1, i2}, {i0, i3, i1}, {i1, i3, i2}, {i2, i3, i0}};
+  for (int f = 0; f < 4; f++)
+  {
+    HullFace face = makeFace(points, tet[f][0], tet[f][1], tet[f][2]);
+    if (distanceAbove(face, centroid) > 0)
+    {
+      face = makeFace(points, tet[f][0], tet[f][2], tet[f][1]);
+    }
+    faces.push_back(face);
+  }
+  for (int f = 0; f < 4; f++)
+  {
+    for (int e = 0; e < 3; e++)
+    {
+      const int a = faces[f].v[e];
+      const int b = faces[f].v[(e + 1) % 3];
+      for (int g = 0; g < 4; g++)
+      {
+        if (g != f && findEdge(faces[g], b, a) != -1)
+        {
+          faces[f].adj[e] = g;
+          break;
+        }
+      }
+    }
+  }
+
+  std::vector<int> candidates;
+  for (int i = 0; i < n; i++)
+  {
+    if (i != i0 && i != i1 && i != i2 && i != i3)
+      candidates.push_back(i);
+  }
+  assignOutsidePoints(points, candidates, faces, 0, eps);
+
+  // 2. Repeatedly add the furthest outside point of a face to the hull. New
+  // faces go on the end of the list, so one pass over it handles everything.
+  std::vector<int> visibleFaces;
+  std::vector<int> stack;
+  // Each horizon edge (a, b), and the face on the far side of it
+  std::vector<std::pair<std::pair<int, int>, int>> horizon;
+  std::vector<int> faceStartingAt(n, -1);
+  std::vector<int> faceEndingAt(n, -1);
+  for (int f = 0; f < faces.size(); f++)
+  {
+    if (!faces[f].alive || faces[f].outside.empty())
+      continue;
+
+    int eye = faces[f].outside[0];
+    s_t eyeDist = distanceAbove(faces[f], points[eye]);
+    for (int p : faces[f].outside)
+    {
+      const s_t dist = distanceAbove(faces[f], points[p]);
+      if (dist > eyeDist)
+      {
+        eyeDist = dist;
+        eye = p;
+      }
+    }
+
+    // Flood out across every face the eye can see, and collect the edges
+    // between visible and hidden faces
+    visibleFaces.clear();
+    horizon.clear();
+    stack.clear();
+    faces[f].visible = true;
+    stack.push_back(f);
+    while (!stack.empty())
+    {
+      const int current = stack.back();
+      stack.pop_back();
+      visibleFaces.push_back(current);
+      for (int e = 0; e < 3; e++)
+      {
+        const int neighbor = faces[current].adj[e];
+        if (faces[neighbor].visible)
+          continue;
+        if (distanceAbove(faces[neighbor], points[eye]) > eps)
+        {
+          faces[neighbor].visible = true;
+          stack.push_back(neighbor);
+        }
+        else
+        {
+          horizon.emplace_back(
+              std::make_pair(
+                  faces[current].v[e], faces[current].v[(e + 1) % 3]),
+              neighbor);
+        }
+      }
+    }
+
+    // Cone the horizon up to the eye. Every horizon vertex should start
+    // exactly one horizon edge and end exactly one, otherwise the visible
+    // region wasn't a disk and we can't trust the hull.
+    const int firstNewFace = faces.size();
+    bool validHorizon = true;
+    for (const auto& edge : horizon)
+    {
+      const int a = edge.first.first;
+      const int b = edge.first.second;
+      if (faceStartingAt[a] != -1 || faceEndingAt[b] != -1)
+      {
+        validHorizon = false;
+        break;
+      }
+      faceStartingAt[a] = faces.size();
+      faceEndingAt[b] = faces.size();
+      faces.push_back(makeFace(points, a, b, eye));
+    }
+    for (int k = 0; validHorizon && k < horizon.size(); k++)
+    {
+      const int a = horizon[k].first.first;
+      const int b = horizon[k].first.second;
+      const int hidden = horizon[k].second;
+      HullFace& face = faces[firstNewFace + k];
+      face.adj[0] = hidden;
+      face.adj[1] = faceStartingAt[b];
+      face.adj[2] = faceEndingAt[a];
+      const int hiddenEdge = findEdge(faces[hidden], b, a);
+      if (face.adj[1] == -1 || face.adj[2] == -1 || hiddenEdge == -1)
+      {
+        validHorizon = false;
+        break;
+      }
+      faces[hidden].adj[hiddenEdge] = firstNewFace + k;
+    }
+    for (const auto& edge : horizon)
+    {
+      faceStartingAt[edge.first.first] = -1;
+      faceEndingAt[edge.first.second] = -1;
+    }
+    if (!validHorizon)
+      return false;
+
+    // Hand the orphaned outside points to the new faces
+    candidates.clear();
+    for (int visible : visibleFaces)
+    {
+      for (int p : faces[visible].outside)
+      {
+        if (p != eye)
+          candidates.push_back(p);
+      }
+      faces[visible].outside.clear();
+      faces[visible].outside.shrink_to_fit();
+      faces[visible].alive = false;
+    }
+    assignOutsidePoints(points, candidates, faces, firstNewFace, eps);
+  }
+
+  return true;
+}
+
+} // namespace
+
+//==============================================================================
+ConvexHull3D::ConvexHull3D(const std::vector<Eigen::Vector3s>& points)
+  : mNumFaces(0), mDegenerate(false)
+{
+  std::vector<HullFace> faces;
+  if (!buildQuickhull(points, faces))
+  {
+    mDegenerate = true;
+    for (const Eigen::Vector3s& p : points)
+    {
+      mX.push_back(p(0));
+      mY.push_back(p(1));
+      mZ.push_back(p(2));
+    }
+    return;
+  }
+
+  // Keep only the vertices that made it onto the hull
+  std::vector<int> hullIndex(points.size(), -1);
+  std::vector<std::pair<int, int>> edges;
+  for (const HullFace& face : faces)
+  {
+    if (!face.alive)
+      continue;
+    mNumFaces++;
+    for (int e = 0; e < 3; e++)
+    {
+      const int a = face.v[e];
+      const int b = face.v[(e + 1) % 3];
+      if (hullIndex[a] == -1)
+      {
+        hullIndex[a] = mX.size();
+        mX.push_back(points[a](0));
+        mY.push_back(points[a](1));
+        mZ.push_back(points[a](2));
+      }
+      // Every edge shows up once in each direction, so this keeps one copy
+      if (a < b)
+      {
+        edges.emplace_back(a, b);
+      }
+    }
+  }
+
+  // Build the adjacency lists
+  const int numVertices = mX.size();
+  mNeighborStart.assign(numVertices + 1, 0);
+  for (const auto& edge : edges)
+  {
+    mNeighborStart[hullIndex[edge.first] + 1]++;
+    mNeighborStart[hullIndex[edge.second] + 1]++;
+  }
+  for (int i = 0; i < numVertices; i++)
+  {
+    mNeighborStart[i + 1] += mNeighborStart[i];
+  }
+  mNeighbors.resize(mNeighborStart[numVertices]);
+  std::vector<int> cursor(mNeighborStart.begin(), mNeighborStart.end() - 1);
+  for (const auto& edge : edges)
+  {
+    const int a = hullIndex[edge.first];
+    const int b = hullIndex[edge.second];
+    mNeighbors[cursor[a]++] = b;
+    mNeighbors[cursor[b]++] = a;
+  }
+}
+
+//==============================================================================
+/// The number of vertices on the hull
+int ConvexHull3D::getNumVertices() const
+{
+  return mX.size();
+}
+
+//==============================================================================
+/// This returns a vertex of the hull
+Eigen::Vector3s ConvexHull3D::getVertex(int index) const
+{
+  return Eigen::Vector3s(mX[index], mY[index], mZ[index]);
+}
+
+//==============================================================================
+/// The number of triangles on the hull. This is 0 if the hull is degenerate.
+int ConvexHull3D::getNumFaces() const
+{
+  return mNumFaces;
+}
+
+//==============================================================================
+/// This returns the number of hull edges that touch a vertex
+int ConvexHull3D::getNumNeighbors(int index) const
+{
+  if (mDegenerate)
+    return 0;
+  return mNeighborStart[index + 1] - mNeighborStart[index];
+}
+
+//==============================================================================
+/// This returns the index of the `k`th vertex that shares a hull edge with
+/// vertex `index`
+int ConvexHull3D::getNeighbor(int index, int k) const
+{
+  return mNeighbors[mNeighborStart[index] + k];
+}
+
+//==============================================================================
+/// This returns true if the input points were (nearly) coplanar, in which
+/// case we didn't build a 3D hull, and support queries scan every point
+bool ConvexHull3D::isDegenerate() const
+{
+  return mDegenerate;
+}
+
+//==============================================================================
+/// This returns the index of the hull vertex that is furthest along `dir`,
+/// hill-climbing from vertex `startHint`. Passing the result of the last
+/// query in a similar direction as `startHint` makes this much faster.
+int ConvexHull3D::getSupportVertex(
+    const Eigen::Vector3s& dir, int startHint) const
+{
+  const int numVertices = mX.size();
+  if (numVertices == 0)
+    return -1;
+  const s_t dx = dir(0);
+  const s_t dy = dir(1);
+  const s_t dz = dir(2);
+
+  if (mDegenerate)
+  {
+    int best = 0;
+    s_t bestDot = -std::numeric_limits<s_t>::infinity();
+    for (int i = 0; i < numVertices; i++)
+    {
+      const s_t dot = mX[i] * dx + mY[i] * dy + mZ[i] * dz;
+      if (dot > bestDot)
+      {
+        bestDot = dot;
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  int current = (startHint >= 0 && startHint < numVertices) ? startHint : 0;
+  s_t currentDot = mX[current] * dx + mY[current] * dy + mZ[current] * dz;
+  // Each step strictly increases the dot product, so this can't cycle
+  while (true)
+  {
+    int next = -1;
+    for (int k = mNeighborStart[current]; k < mNeighborStart[current + 1];
+         k++)
+    {
+      const int neighbor = mNeighbors[k];
+      const s_t dot
+          = mX[neighbor] * dx + mY[neighbor] * dy + mZ[neighbor] * dz;
+      if (dot > currentDot)
+      {
+        currentDot = dot;
+        next = neighbor;
+      }
+    }
+    if (next == -1)
+      return current;
+    current = next;
+  }
+}
+
+} // namespace math
+} // namespace dart
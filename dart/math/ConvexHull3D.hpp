@@ -0,0 +1,77 @@
+#ifndef MATH_CONVEX_HULL_3D_H_
+#define MATH_CONVEX_HULL_3D_H_
+
+#include <vector>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/**
+ * This is the convex hull of a 3D point cloud, preprocessed for fast support
+ * queries (finding the point furthest along a direction), which is what GJK
+ * and MPR spend most of their time doing.
+ *
+ * The hull is built once, with Quickhull. We keep only the vertices that are
+ * on the hull, in flat x/y/z arrays, along with the edges of the hull as a
+ * vertex adjacency list. A support query then hill-climbs from a starting
+ * vertex to whichever neighbor is furthest along the direction, until no
+ * neighbor is any further. On a convex polytope that local maximum is also the
+ * global one, and if the starting vertex is the answer to a previous query in
+ * a nearby direction (which is the common case inside GJK/MPR) it only takes a
+ * few steps.
+ *
+ * If the points are all (nearly) coplanar or collinear, there's no 3D hull to
+ * climb, so we keep all the points and support queries fall back to scanning
+ * them.
+ */
+class ConvexHull3D
+{
+public:
+  ConvexHull3D(const std::vector<Eigen::Vector3s>& points);
+
+  /// The number of vertices on the hull
+  int getNumVertices() const;
+
+  /// This returns a vertex of the hull
+  Eigen::Vector3s getVertex(int index) const;
+
+  /// The number of triangles on the hull. This is 0 if the hull is degenerate.
+  int getNumFaces() const;
+
+  /// This returns the number of hull edges that touch a vertex
+  int getNumNeighbors(int index) const;
+
+  /// This returns the index of the `k`th vertex that shares a hull edge with
+  /// vertex `index`
+  int getNeighbor(int index, int k) const;
+
+  /// This returns true if the input points were (nearly) coplanar, in which
+  /// case we didn't build a 3D hull, and support queries scan every point
+  bool isDegenerate() const;
+
+  /// This returns the index of the hull vertex that is furthest along `dir`,
+  /// hill-climbing from vertex `startHint`. Passing the result of the last
+  /// query in a similar direction as `startHint` makes this much faster.
+  int getSupportVertex(const Eigen::Vector3s& dir, int startHint = 0) const;
+
+protected:
+  /// Vertex positions, stored as separate coordinate arrays
+  std::vector<s_t> mX;
+  std::vector<s_t> mY;
+  std::vector<s_t> mZ;
+
+  /// The neighbors of vertex i are
+  /// mNeighbors[mNeighborStart[i]..mNeighborStart[i+1]]
+  std::vector<int> mNeighborStart;
+  std::vector<int> mNeighbors;
+
+  int mNumFaces;
+  bool mDegenerate;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -39,6 +39,7 @@ BackpropSnapshot::BackpropSnapshot(
     Eigen::VectorXs preStepLCPCache)
   : mUseFDOverride(world->getUseFDOverride()),
     mSlowDebugResultsAgainstFD(world->getSlowDebugResultsAgainstFD()),
+    mUseVJPBackprop(world->getUseVJPBackprop()),
     mNumDOFs(0),
     mNumConstraintDim(0),
     mNumClamping(0),
@@ -105,6 +106,8 @@ BackpropSnapshot::BackpropSnapshot(
   mCachedMassVelDirty = true;
   mCachedVelCDirty = true;
   mCachedPosCDirty = true;
+  mCachedInvMassMatrixDirty = true;
+  mCachedClampingFactorizationDirty = true;
 
   /*
   if (!areResultsStandardized())
@@ -127,10 +130,8 @@ void BackpropSnapshot::backprop(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun("BackpropSnapshot.backprop");
-  }
+  ScopedPerformanceLog scopedThisLog(perfLog, "BackpropSnapshot.backprop");
+  thisLog = scopedThisLog.get();
 #endif
 
   LossGradient groupThisTimestepLoss;
@@ -156,6 +157,27 @@ void BackpropSnapshot::backprop(
   // using ConstrainedGroups directly. Currently it's redundant to construct
   // Jacobians _both_ in the ConstrainedGroups and in the BackpropSnapshot, so
   // it's better overall to just use one.
+  if (exploreAlternateStrategies == false && mUseVJPBackprop && !mUseFDOverride
+      && !mSlowDebugResultsAgainstFD)
+  {
+    backpropWithVJPs(world, thisTimestepLoss, nextTimestepLoss, thisLog);
+
+    clipLossGradientsToBounds(
+        world,
+        thisTimestepLoss.lossWrtPosition,
+        thisTimestepLoss.lossWrtVelocity,
+        thisTimestepLoss.lossWrtTorque);
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+    if (thisLog != nullptr)
+    {
+      thisLog->end();
+    }
+#endif
+    snapshot.restore();
+    return;
+  }
+
   if (exploreAlternateStrategies == false)
   {
     const Eigen::MatrixXs& posPos = getPosPosJacobian(world, thisLog);
@@ -376,6 +398,169 @@ void BackpropSnapshot::backprop(
 #endif
 }
 
+//==============================================================================
+/// This is the body of backprop() when mUseVJPBackprop is set. Writing g for
+/// the loss wrt v_t+1, we never form Minv or any of the step Jacobians. The
+/// derivatives of C and of Minv * x wrt position are still dense nDofs x nDofs
+/// matrices, which we multiply by vectors. The clamping constraints enter
+/// through
+///
+///   u = A_c * B * Q^{-T} * (A_c + A_ub * E)^T * Minv * g
+///
+/// which is the part of g that gets absorbed by the contact impulses. With
+/// r = g - u, force-vel^T * g = dt * Minv * r and vel-vel^T * g = r - dt *
+/// (dC/dv + D + dt * K)^T * Minv * r. Pos-vel is the transpose of the same
+/// terms getVelJacobianWrt(POSITION) sums up.
+void BackpropSnapshot::backpropWithVJPs(
+    simulation::WorldPtr world,
+    LossGradient& thisTimestepLoss,
+    const LossGradient& nextTimestepLoss,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "BackpropSnapshot.backpropWithVJPs");
+  thisLog = scopedThisLog.get();
+#endif
+
+  const Eigen::VectorXs& lossWrtNextPos = nextTimestepLoss.lossWrtPosition;
+  const Eigen::VectorXs& lossWrtNextVel = nextTimestepLoss.lossWrtVelocity;
+  const s_t dt = world->getTimeStep();
+
+  // p_t --> p_t+1 and v_t --> p_t+1 only go through the integrator and the
+  // bounce approximation, which is the identity if nothing bounced
+  Eigen::VectorXs lossWrtPos
+      = world->getPosPosJacobian().transpose() * lossWrtNextPos;
+  Eigen::VectorXs lossWrtVel
+      = world->getVelPosJacobian().transpose() * lossWrtNextPos;
+  if (mNumBouncing > 0)
+  {
+    const Eigen::MatrixXs& bounce
+        = getBounceApproximationJacobian(world, thisLog);
+    lossWrtPos = bounce.transpose() * lossWrtPos;
+    lossWrtVel = bounce.transpose() * lossWrtVel;
+  }
+
+  const Eigen::VectorXs Minv_g
+      = implicitMultiplyByInvMassMatrix(world, lossWrtNextVel);
+
+  // Project the loss through the clamping constraints
+  Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
+  Eigen::MatrixXs A_ub;
+  Eigen::MatrixXs E;
+  Eigen::MatrixXs A_c_ub_E;
+  Eigen::VectorXs z;
+  Eigen::VectorXs s;
+  Eigen::VectorXs u = Eigen::VectorXs::Zero(mNumDOFs);
+  Eigen::VectorXs Minv_u = Eigen::VectorXs::Zero(mNumDOFs);
+  const bool anyClamping = A_c.cols() > 0;
+  if (anyClamping)
+  {
+    A_ub = getUpperBoundConstraintMatrix(world);
+    E = getUpperBoundMappingMatrix();
+    A_c_ub_E = A_c + A_ub * E;
+
+    // Q only has one row and column per clamping constraint, so we build it
+    // one implicit Minv multiply at a time
+    Eigen::MatrixXs Minv_A_c_ub_E(mNumDOFs, A_c_ub_E.cols());
+    for (int i = 0; i < A_c_ub_E.cols(); i++)
+    {
+      Minv_A_c_ub_E.col(i)
+          = implicitMultiplyByInvMassMatrix(world, A_c_ub_E.col(i));
+    }
+    Eigen::MatrixXs Q = A_c.transpose() * Minv_A_c_ub_E;
+    Q.diagonal() += getConstraintForceMixingDiagonal();
+
+    z = A_c_ub_E.transpose() * Minv_g;
+    s = getBounceDiagonals().cwiseProduct(
+        Q.transpose().completeOrthogonalDecomposition().solve(z));
+    u = A_c * s;
+    Minv_u = implicitMultiplyByInvMassMatrix(world, u);
+  }
+  const Eigen::VectorXs Minv_r = Minv_g - Minv_u;
+
+  const Eigen::VectorXs damping = getDampingVector(world);
+  const Eigen::VectorXs springStiffs = getSpringStiffVector(world);
+
+  // f_t --> v_t+1
+  thisTimestepLoss.lossWrtTorque = dt * Minv_r;
+
+  // v_t --> v_t+1
+  thisTimestepLoss.lossWrtVelocity
+      = lossWrtVel + (lossWrtNextVel - u)
+        - dt
+              * (getJacobianOfC(world, WithRespectTo::VELOCITY).transpose()
+                     * Minv_r
+                 + damping.cwiseProduct(Minv_r)
+                 + dt * springStiffs.cwiseProduct(Minv_r));
+
+  // p_t --> v_t+1
+  const Eigen::VectorXs tau = world->getControlForces();
+  const Eigen::VectorXs C = world->getCoriolisAndGravityAndExternalForces();
+  const Eigen::VectorXs p_rest = getRestPositions(world);
+  const Eigen::VectorXs v_t = world->getVelocities();
+  const Eigen::VectorXs p_t = world->getPositions();
+  const Eigen::VectorXs f
+      = tau - C - damping.cwiseProduct(v_t)
+        - springStiffs.cwiseProduct(p_t - p_rest + dt * v_t);
+  const Eigen::MatrixXs dC = getJacobianOfC(world, WithRespectTo::POSITION);
+
+  Eigen::VectorXs impulses = dt * f;
+  Eigen::VectorXs f_c;
+  if (anyClamping)
+  {
+    f_c = getClampingConstraintImpulses();
+    impulses += A_c_ub_E * f_c;
+  }
+  lossWrtPos += getJacobianOfMinv(world, impulses, WithRespectTo::POSITION)
+                    .transpose()
+                * lossWrtNextVel;
+  lossWrtPos -= dt
+                * (dC.transpose() * Minv_g
+                   + springStiffs.cwiseProduct(Minv_g));
+
+  if (anyClamping)
+  {
+    // The constraint matrices move with position
+    lossWrtPos
+        += getJacobianOfClampingConstraints(world, f_c).transpose() * Minv_g
+           + getJacobianOfUpperBoundConstraints(world, E * f_c).transpose()
+                 * Minv_g;
+
+    // And so do the constraint impulses, through both Q and b
+    lossWrtPos += getJacobianOfLCPConstraintMatrixClampingSubset(
+                      world,
+                      getClampingConstraintRelativeVels(),
+                      WithRespectTo::POSITION)
+                      .transpose()
+                  * z;
+    lossWrtPos
+        -= getJacobianOfClampingConstraintsTranspose(
+               world, getPreConstraintVelocity())
+                   .transpose()
+               * s
+           + dt
+                 * (getJacobianOfMinv(world, f, WithRespectTo::POSITION)
+                            .transpose()
+                        * u
+                    - dC.transpose() * Minv_u
+                    - springStiffs.cwiseProduct(Minv_u));
+  }
+  thisTimestepLoss.lossWrtPosition = lossWrtPos;
+
+  // mass --> v_t+1
+  thisTimestepLoss.lossWrtMass
+      = getMassVelJacobian(world, thisLog).transpose() * lossWrtNextVel;
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 /// This computes backprop in the high-level RL API's space, use `state` and
 /// `action` as the primitives we're taking gradients wrt to.
@@ -490,21 +675,18 @@ const Eigen::MatrixXs& BackpropSnapshot::getControlForceVelJacobian(
 
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun("BackpropSnapshot.getControlForceVelJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "BackpropSnapshot.getControlForceVelJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mCachedForceVelDirty)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-    if (thisLog != nullptr)
-    {
-      refreshLog = thisLog->startRun(
-          "BackpropSnapshot.getControlForceVelJacobian#refreshCache");
-    }
+    ScopedPerformanceLog scopedRefreshLog(
+        thisLog, "BackpropSnapshot.getControlForceVelJacobian#refreshCache");
+    refreshLog = scopedRefreshLog.get();
 #endif
     if (mUseFDOverride)
     {
@@ -588,21 +770,18 @@ const Eigen::MatrixXs& BackpropSnapshot::getMassVelJacobian(
 
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun("BackpropSnapshot.getMassVelJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "BackpropSnapshot.getMassVelJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mCachedMassVelDirty)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-    if (thisLog != nullptr)
-    {
-      refreshLog = thisLog->startRun(
-          "BackpropSnapshot.getMassVelJacobian#refreshCache");
-    }
+    ScopedPerformanceLog scopedRefreshLog(
+        thisLog, "BackpropSnapshot.getMassVelJacobian#refreshCache");
+    refreshLog = scopedRefreshLog.get();
 #endif
 
     if (mUseFDOverride)
@@ -651,21 +830,18 @@ const Eigen::MatrixXs& BackpropSnapshot::getVelVelJacobian(
 
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun("BackpropSnapshot.getVelVelJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "BackpropSnapshot.getVelVelJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mCachedVelVelDirty)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-    if (thisLog != nullptr)
-    {
-      refreshLog = thisLog->startRun(
-          "BackpropSnapshot.getVelVelJacobian#refreshCache");
-    }
+    ScopedPerformanceLog scopedRefreshLog(
+        thisLog, "BackpropSnapshot.getVelVelJacobian#refreshCache");
+    refreshLog = scopedRefreshLog.get();
 #endif
 
     if (mUseFDOverride)
@@ -770,21 +946,18 @@ const Eigen::MatrixXs& BackpropSnapshot::getPosVelJacobian(
 
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun("BackpropSnapshot.getPosVelJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "BackpropSnapshot.getPosVelJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mCachedPosVelDirty)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-    if (thisLog != nullptr)
-    {
-      refreshLog = thisLog->startRun(
-          "BackpropSnapshot.getPosVelJacobian#refreshCache");
-    }
+    ScopedPerformanceLog scopedRefreshLog(
+        thisLog, "BackpropSnapshot.getPosVelJacobian#refreshCache");
+    refreshLog = scopedRefreshLog.get();
 #endif
 
     if (mUseFDOverride)
@@ -1133,22 +1306,18 @@ const Eigen::MatrixXs& BackpropSnapshot::getBounceApproximationJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog
-        = perfLog->startRun("BackpropSnapshot.getBounceApproximationJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "BackpropSnapshot.getBounceApproximationJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mCachedBounceApproximationDirty)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-    if (thisLog != nullptr)
-    {
-      refreshLog = thisLog->startRun(
-          "BackpropSnapshot.getBounceApproximationJacobian#refreshCache");
-    }
+    ScopedPerformanceLog scopedRefreshLog(
+        thisLog, "BackpropSnapshot.getBounceApproximationJacobian#refreshCache");
+    refreshLog = scopedRefreshLog.get();
 #endif
 
     /*
@@ -1271,21 +1440,18 @@ const Eigen::MatrixXs& BackpropSnapshot::getPosPosJacobian(
 
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun("BackpropSnapshot.getPosPosJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "BackpropSnapshot.getPosPosJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mCachedPosPosDirty)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-    if (thisLog != nullptr)
-    {
-      refreshLog = thisLog->startRun(
-          "BackpropSnapshot.getPosPosJacobian#refreshCache");
-    }
+    ScopedPerformanceLog scopedRefreshLog(
+        thisLog, "BackpropSnapshot.getPosPosJacobian#refreshCache");
+    refreshLog = scopedRefreshLog.get();
 #endif
 
     if (mUseFDOverride)
@@ -1346,21 +1512,18 @@ const Eigen::MatrixXs& BackpropSnapshot::getVelPosJacobian(
 
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun("BackpropSnapshot.getVelPosJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "BackpropSnapshot.getVelPosJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mCachedVelPosDirty)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
-    if (thisLog != nullptr)
-    {
-      refreshLog = thisLog->startRun(
-          "BackpropSnapshot.getVelPosJacobian#refreshCache");
-    }
+    ScopedPerformanceLog scopedRefreshLog(
+        thisLog, "BackpropSnapshot.getVelPosJacobian#refreshCache");
+    refreshLog = scopedRefreshLog.get();
 #endif
 
     if (mUseFDOverride)
@@ -1537,6 +1700,44 @@ Eigen::MatrixXs BackpropSnapshot::getInvMassMatrix(
       forFiniteDifferencing);
 }
 
+//==============================================================================
+const Eigen::MatrixXs& BackpropSnapshot::getCachedInvMassMatrix(WorldPtr world)
+{
+  if (mCachedInvMassMatrixDirty)
+  {
+    mCachedInvMassMatrix = getInvMassMatrix(world);
+    mCachedInvMassMatrixDirty = false;
+  }
+  return mCachedInvMassMatrix;
+}
+
+//==============================================================================
+std::shared_ptr<const ClampingFactorization>
+BackpropSnapshot::getClampingFactorization(WorldPtr world)
+{
+  if (mCachedClampingFactorizationDirty)
+  {
+    Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
+    Eigen::MatrixXs A_ub = getUpperBoundConstraintMatrix(world);
+    Eigen::MatrixXs E = getUpperBoundMappingMatrix();
+    const Eigen::MatrixXs& Minv = getCachedInvMassMatrix(world);
+
+    Eigen::MatrixXs Q = A_c.transpose() * Minv * (A_c + A_ub * E);
+    Q.diagonal() += getConstraintForceMixingDiagonal();
+
+    ClampingPatternKey key;
+    key.add(static_cast<long>(mNumDOFs));
+    for (auto gradientMatrices : mGradientMatrices)
+    {
+      key.add(gradientMatrices->getClampingPatternKey());
+    }
+    mCachedClampingFactorization
+        = world->getClampingFactorizationCache()->getFactorization(key, Q);
+    mCachedClampingFactorizationDirty = false;
+  }
+  return mCachedClampingFactorization;
+}
+
 Eigen::VectorXs BackpropSnapshot::getDampingVector(WorldPtr world)
 {
   Eigen::VectorXs result = Eigen::VectorXs::Zero(mNumDOFs);
@@ -2020,6 +2221,18 @@ void BackpropSnapshot::setSlowDebugResultsAgainstFD(bool slowDebug)
   mSlowDebugResultsAgainstFD = slowDebug;
 }
 
+//==============================================================================
+void BackpropSnapshot::setUseVJPBackprop(bool useVJPs)
+{
+  mUseVJPBackprop = useVJPs;
+}
+
+//==============================================================================
+bool BackpropSnapshot::getUseVJPBackprop() const
+{
+  return mUseVJPBackprop;
+}
+
 //==============================================================================
 /// This does a battery of tests comparing the speeds to compute all the
 /// different Jacobians, both with finite differencing and analytically, and
@@ -2730,14 +2943,11 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfConstraintForce(
   assert(world->getCachedLCPSolution() == mPreStepLCPCache);
 #endif
 
-  Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
-  if (A_c.cols() == 0)
+  if (mNumClamping == 0)
   {
     int wrtDim = wrt->dim(world.get());
     return Eigen::MatrixXs::Zero(0, wrtDim);
   }
-  Eigen::MatrixXs A_ub = getUpperBoundConstraintMatrix(world);
-  Eigen::MatrixXs E = getUpperBoundMappingMatrix();
 
   /*
   RestorableSnapshot snapshot(world);
@@ -2747,13 +2957,8 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfConstraintForce(
   world->setCachedLCPSolution(mPreStepLCPCache);
   */
 
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
-  Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
-  Eigen::MatrixXs Q = A_c.transpose() * Minv * A_c_ub_E;
-  Q.diagonal() += getConstraintForceMixingDiagonal();
-
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfac
-      = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const ClampingFactorization> factorization
+      = getClampingFactorization(world);
 
   Eigen::MatrixXs dB = getJacobianOfLCPOffsetClampingSubset(world, wrt);
 
@@ -2761,7 +2966,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfConstraintForce(
   {
     // dQ_b is 0, so don't compute it
     // snapshot.restore();
-    return Qfac.solve(dB);
+    return factorization->solve(dB);
   }
 
   Eigen::VectorXs b = getClampingConstraintRelativeVels();
@@ -2770,7 +2975,7 @@ Eigen::MatrixXs BackpropSnapshot::getJacobianOfConstraintForce(
 
   // snapshot.restore();
 
-  return dQ_b + Qfac.solve(dB);
+  return dQ_b + factorization->solve(dB);
 }
 
 //==============================================================================
@@ -2919,17 +3124,16 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
   Eigen::MatrixXs E = getUpperBoundMappingMatrix();
   Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
 
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
-  Eigen::MatrixXs Q = A_c.transpose() * Minv * (A_c + A_ub * E);
-  Q.diagonal() += getConstraintForceMixingDiagonal();
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfactored
-      = Q.completeOrthogonalDecomposition();
+  const Eigen::MatrixXs& Minv = getCachedInvMassMatrix(world);
+  std::shared_ptr<const ClampingFactorization> factorization
+      = getClampingFactorization(world);
+  const Eigen::MatrixXs& Q = factorization->getQ();
 
-  Eigen::VectorXs Qinv_b = Qfactored.solve(b);
+  Eigen::VectorXs Qinv_b = factorization->solve(b);
 
   if (wrt == WithRespectTo::POSITION)
   {
-    Eigen::MatrixXs Qinv = Qfactored.pseudoInverse();
+    const Eigen::MatrixXs& Qinv = factorization->getPseudoInverse();
     Eigen::MatrixXs I = Eigen::MatrixXs::Identity(Q.rows(), Q.cols());
 
     // Position is the only term that affects A_c and A_ub. We use the full
@@ -2971,16 +3175,18 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
         // of 3 times like the below formula. That's actually a pretty big speed
         // advantage. When we can, we should use this formula instead.
         // return -Qinv * dQ(Qinv * b);
-        return -Qfactored.solve(dQ(Qfactored.solve(b)));
+        return -factorization->solve(dQ(factorization->solve(b)));
       }
       // Otherwise fall back to the exact Jacobian of the pseudo-inverse
       else
       {
         // This is the gradient of the pseudoinverse, see
         // https://mathoverflow.net/a/29511/163259
-        return -Qfactored.solve(dQ(Qfactored.solve(b)))
-               + Qfactored.solve(Qinv.transpose() * dQT(imprecisionMap * b))
-               + (I - Qinv * Q) * dQT(Qinv.transpose() * Qfactored.solve(b));
+        return -factorization->solve(dQ(factorization->solve(b)))
+               + factorization->solve(
+                   Qinv.transpose() * dQT(imprecisionMap * b))
+               + (I - Qinv * Q)
+                     * dQT(Qinv.transpose() * factorization->solve(b));
       }
 
 #undef dQ
@@ -3009,15 +3215,17 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
         // of 3 times like the below formula. That's actually a pretty big speed
         // advantage. When we can, we should use this formula instead.
         // return -Qinv * dQ(Qinv * b);
-        return -Qfactored.solve(dQ(Qfactored.solve(b)));
+        return -factorization->solve(dQ(factorization->solve(b)));
       }
       else
       {
         // This is the gradient of the pseudoinverse, see
         // https://mathoverflow.net/a/29511/163259
-        return -Qfactored.solve(dQ(Qfactored.solve(b)))
-               + Qfactored.solve(Qinv.transpose() * dQT(imprecisionMap * b))
-               + (I - Qinv * Q) * dQT(Qinv.transpose() * Qfactored.solve(b));
+        return -factorization->solve(dQ(factorization->solve(b)))
+               + factorization->solve(
+                   Qinv.transpose() * dQT(imprecisionMap * b))
+               + (I - Qinv * Q)
+                     * dQT(Qinv.transpose() * factorization->solve(b));
       }
 
 #undef dQ
@@ -3029,7 +3237,7 @@ BackpropSnapshot::getJacobianOfLCPConstraintMatrixClampingSubset(
     // All other terms get to treat A_c as constant
     Eigen::MatrixXs innerTerms
         = A_c.transpose() * getJacobianOfMinv(world, A_c * Qinv_b, wrt);
-    Eigen::MatrixXs result = -Qfactored.solve(innerTerms);
+    Eigen::MatrixXs result = -factorization->solve(innerTerms);
 
     // snapshot.restore();
     return result;
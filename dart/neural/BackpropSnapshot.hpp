@@ -1,11 +1,13 @@
 #ifndef DART_NEURAL_SNAPSHOT_HPP_
 #define DART_NEURAL_SNAPSHOT_HPP_
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
 
+#include "dart/neural/ClampingFactorizationCache.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -646,6 +648,23 @@ public:
   /// instructions.
   void setSlowDebugResultsAgainstFD(bool slowDebug);
 
+  /// If this is true, backprop() multiplies the loss through the pieces the
+  /// step Jacobians (pos-pos, vel-vel, force-vel, pos-vel, ...) are built
+  /// from, rather than assembling those Jacobians and multiplying by their
+  /// transposes. That saves forming Minv, which is only ever applied to vectors
+  /// by the articulated body algorithm, and all of the dense products with it.
+  /// It does NOT avoid every nDofs x nDofs matrix: the derivatives of C and of
+  /// Minv times a vector (and, with clamping contacts, the constraint matrix
+  /// derivatives) are still formed densely, and then multiplied by vectors.
+  ///
+  /// The results agree with the dense path up to round-off.
+  /// verifyAnalyticalBackprop() in the gradient tests checks them against each
+  /// other to within 1e-8 of the largest gradient entry. This defaults to the
+  /// value from World::getUseVJPBackprop().
+  void setUseVJPBackprop(bool useVJPs);
+
+  bool getUseVJPBackprop() const;
+
   /// This does a battery of tests comparing the speeds to compute all the
   /// different Jacobians, both with finite differencing and analytically, and
   /// prints the results to std out.
@@ -664,6 +683,10 @@ protected:
   /// instructions.
   bool mSlowDebugResultsAgainstFD;
 
+  /// If this is true, backprop() never assembles the step Jacobians, and only
+  /// multiplies the loss through the pieces they're built from.
+  bool mUseVJPBackprop;
+
   /// This is the global timestep length. This is included here because it shows
   /// up as a constant in some of the matrices.
   s_t mTimeStep;
@@ -739,6 +762,30 @@ private:
   bool mCachedVelCDirty;
   Eigen::MatrixXs mCachedVelC;
 
+  /// These are the pre-step inverse mass matrix, and the factorization of the
+  /// clamping Q that the constraint force Jacobians solve against
+  bool mCachedInvMassMatrixDirty;
+  Eigen::MatrixXs mCachedInvMassMatrix;
+  bool mCachedClampingFactorizationDirty;
+  std::shared_ptr<const ClampingFactorization> mCachedClampingFactorization;
+
+  /// This returns getInvMassMatrix(world), only computing it the first time
+  const Eigen::MatrixXs& getCachedInvMassMatrix(simulation::WorldPtr world);
+
+  /// This returns a factorization of Q, going through the world's
+  /// ClampingFactorizationCache, keyed on the clamping patterns of all our
+  /// constrained groups. This is only computed the first time.
+  std::shared_ptr<const ClampingFactorization> getClampingFactorization(
+      simulation::WorldPtr world);
+
+  /// This is the body of backprop() when mUseVJPBackprop is set. It expects the
+  /// world to already be in the pre-step state.
+  void backpropWithVJPs(
+      simulation::WorldPtr world,
+      LossGradient& thisTimestepLoss,
+      const LossGradient& nextTimestepLoss,
+      PerformanceLog* perfLog);
+
   Eigen::VectorXs scratch(simulation::WorldPtr world);
 
   enum MatrixToAssemble
@@ -0,0 +1,343 @@
+#include "dart/neural/ClampingFactorizationCache.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+
+namespace dart {
+namespace neural {
+
+namespace {
+
+void hashCombine(std::size_t& seed, std::size_t value)
+{
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// A warm started solve has converged once its residual is this small relative
+// to the size of the problem, which is about what an exact factorization gets
+constexpr double kRefinementTolerance = 1e-13;
+
+} // namespace
+
+//==============================================================================
+ClampingPatternKey::ClampingPatternKey() : mHash(0)
+{
+}
+
+//==============================================================================
+void ClampingPatternKey::add(long value)
+{
+  mValues.push_back(value);
+  hashCombine(mHash, std::hash<long>()(value));
+}
+
+//==============================================================================
+void ClampingPatternKey::add(const std::string& name)
+{
+  add(static_cast<long>(std::hash<std::string>()(name)));
+}
+
+//==============================================================================
+void ClampingPatternKey::add(const ClampingPatternKey& other)
+{
+  // Mark where the other key starts, so [a, b] + [c] and [a] + [b, c] differ
+  add(static_cast<long>(other.mValues.size()));
+  for (long value : other.mValues)
+  {
+    add(value);
+  }
+}
+
+//==============================================================================
+std::size_t ClampingPatternKey::getHash() const
+{
+  return mHash;
+}
+
+//==============================================================================
+bool ClampingPatternKey::operator==(const ClampingPatternKey& other) const
+{
+  return mHash == other.mHash && mValues == other.mValues;
+}
+
+//==============================================================================
+std::size_t ClampingPatternKey::Hasher::operator()(
+    const ClampingPatternKey& key) const
+{
+  return key.getHash();
+}
+
+//==============================================================================
+ClampingFactorization::ClampingFactorization(const Eigen::MatrixXs& Q)
+  : mQ(Q), mRefinementFailed(false)
+{
+  // Factor eagerly, since this is the factorization that warm started solves
+  // get refined against
+  getExactFactorization();
+}
+
+//==============================================================================
+ClampingFactorization::ClampingFactorization(
+    const Eigen::MatrixXs& Q,
+    std::shared_ptr<const ClampingFactorization> base,
+    std::shared_ptr<std::atomic<long>> numFallbacks)
+  : mQ(Q),
+    mBase(base),
+    mNumFallbacks(numFallbacks),
+    mRefinementFailed(false)
+{
+  assert(mBase != nullptr);
+  assert(!mBase->isWarmStarted());
+  assert(mBase->getQ().rows() == Q.rows() && mBase->getQ().cols() == Q.cols());
+}
+
+//==============================================================================
+const Eigen::MatrixXs& ClampingFactorization::getQ() const
+{
+  return mQ;
+}
+
+//==============================================================================
+bool ClampingFactorization::isWarmStarted() const
+{
+  return mBase != nullptr;
+}
+
+//==============================================================================
+Eigen::MatrixXs ClampingFactorization::solve(const Eigen::MatrixXs& B) const
+{
+  if (mBase != nullptr && !mRefinementFailed.load())
+  {
+    Eigen::MatrixXs X;
+    if (solveByRefinement(B, X))
+    {
+      return X;
+    }
+    if (!mRefinementFailed.exchange(true) && mNumFallbacks != nullptr)
+    {
+      (*mNumFallbacks)++;
+    }
+  }
+  return getExactFactorization().solve(B);
+}
+
+//==============================================================================
+const Eigen::MatrixXs& ClampingFactorization::getPseudoInverse() const
+{
+  std::call_once(mPseudoInverseOnce, [this]() {
+    if (mBase != nullptr)
+    {
+      // If refinement converges, Q is invertible, so this is the inverse
+      mPseudoInverse = solve(Eigen::MatrixXs::Identity(mQ.rows(), mQ.cols()));
+      if (!mRefinementFailed.load())
+      {
+        return;
+      }
+    }
+    mPseudoInverse = getExactFactorization().pseudoInverse();
+  });
+  return mPseudoInverse;
+}
+
+//==============================================================================
+const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>&
+ClampingFactorization::getExactFactorization() const
+{
+  std::call_once(mFactoredOnce, [this]() { mFactored.compute(mQ); });
+  return mFactored;
+}
+
+//==============================================================================
+bool ClampingFactorization::solveByRefinement(
+    const Eigen::MatrixXs& B, Eigen::MatrixXs& X) const
+{
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>& base
+      = mBase->getExactFactorization();
+  const s_t QNorm = mQ.norm();
+  const s_t BNorm = B.norm();
+
+  X = base.solve(B);
+  for (int i = 0; i <= kMaxRefinementSteps; i++)
+  {
+    Eigen::MatrixXs residual = B - mQ * X;
+    if (residual.norm()
+        <= kRefinementTolerance * (BNorm + QNorm * X.norm())
+               + std::numeric_limits<s_t>::min())
+    {
+      return true;
+    }
+    if (i < kMaxRefinementSteps)
+    {
+      X += base.solve(residual);
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+ClampingFactorizationCache::ClampingFactorizationCache(int capacity)
+  : mCapacity(capacity),
+    mMaxWarmStartDrift(kDefaultMaxWarmStartDrift),
+    mNumHits(0),
+    mNumWarmStarts(0),
+    mNumMisses(0),
+    mNumWarmStartFallbacks(std::make_shared<std::atomic<long>>(0))
+{
+}
+
+//==============================================================================
+std::shared_ptr<const ClampingFactorization>
+ClampingFactorizationCache::getFactorization(
+    const ClampingPatternKey& key, const Eigen::MatrixXs& Q)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mEntries.find(key);
+    if (it != mEntries.end())
+    {
+      const std::shared_ptr<const ClampingFactorization>& cached
+          = it->second.factorization;
+      const Eigen::MatrixXs& cachedQ = cached->getQ();
+      if (cachedQ.rows() == Q.rows() && cachedQ.cols() == Q.cols())
+      {
+        if (cachedQ == Q)
+        {
+          mLRU.splice(mLRU.begin(), mLRU, it->second.lruPosition);
+          mNumHits++;
+          return cached;
+        }
+        const s_t drift = (Q - cachedQ).norm();
+        if (drift <= mMaxWarmStartDrift * cachedQ.norm())
+        {
+          // We don't cache warm started factorizations, so that drift is always
+          // measured from a Q that was actually factored
+          mLRU.splice(mLRU.begin(), mLRU, it->second.lruPosition);
+          mNumWarmStarts++;
+          return std::make_shared<ClampingFactorization>(
+              Q, cached, mNumWarmStartFallbacks);
+        }
+      }
+    }
+  }
+
+  // Factor outside the lock, so that threads with different contact sets don't
+  // wait on each other
+  mNumMisses++;
+  std::shared_ptr<const ClampingFactorization> factorization
+      = std::make_shared<ClampingFactorization>(Q);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mCapacity <= 0)
+  {
+    return factorization;
+  }
+  auto it = mEntries.find(key);
+  if (it != mEntries.end())
+  {
+    it->second.factorization = factorization;
+    mLRU.splice(mLRU.begin(), mLRU, it->second.lruPosition);
+  }
+  else
+  {
+    mLRU.push_front(key);
+    Entry entry;
+    entry.factorization = factorization;
+    entry.lruPosition = mLRU.begin();
+    mEntries[key] = entry;
+    evictToCapacity();
+  }
+  return factorization;
+}
+
+//==============================================================================
+void ClampingFactorizationCache::setCapacity(int capacity)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mCapacity = capacity;
+  evictToCapacity();
+}
+
+//==============================================================================
+int ClampingFactorizationCache::getCapacity()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mCapacity;
+}
+
+//==============================================================================
+void ClampingFactorizationCache::setMaxWarmStartDrift(s_t drift)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mMaxWarmStartDrift = std::max(drift, static_cast<s_t>(0.0));
+}
+
+//==============================================================================
+s_t ClampingFactorizationCache::getMaxWarmStartDrift()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mMaxWarmStartDrift;
+}
+
+//==============================================================================
+int ClampingFactorizationCache::getNumEntries()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mEntries.size();
+}
+
+//==============================================================================
+long ClampingFactorizationCache::getNumHits() const
+{
+  return mNumHits.load();
+}
+
+//==============================================================================
+long ClampingFactorizationCache::getNumWarmStarts() const
+{
+  return mNumWarmStarts.load();
+}
+
+//==============================================================================
+long ClampingFactorizationCache::getNumWarmStartFallbacks() const
+{
+  return mNumWarmStartFallbacks->load();
+}
+
+//==============================================================================
+long ClampingFactorizationCache::getNumMisses() const
+{
+  return mNumMisses.load();
+}
+
+//==============================================================================
+void ClampingFactorizationCache::resetCounters()
+{
+  mNumHits = 0;
+  mNumWarmStarts = 0;
+  mNumMisses = 0;
+  *mNumWarmStartFallbacks = 0;
+}
+
+//==============================================================================
+void ClampingFactorizationCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mEntries.clear();
+  mLRU.clear();
+  resetCounters();
+}
+
+//==============================================================================
+void ClampingFactorizationCache::evictToCapacity()
+{
+  while (mLRU.size() > static_cast<std::size_t>(std::max(mCapacity, 0)))
+  {
+    mEntries.erase(mLRU.back());
+    mLRU.pop_back();
+  }
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,219 @@
+#ifndef DART_NEURAL_CLAMPING_FACTORIZATION_CACHE_HPP_
+#define DART_NEURAL_CLAMPING_FACTORIZATION_CACHE_HPP_
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace neural {
+
+/// This identifies a clamping pattern: which skeletons are involved, which
+/// constraints are clamping, which are at their upper bound, and how the upper
+/// bounds map onto clamping constraints. Two Q matrices with the same pattern
+/// have the same shape and meaning, so a factorization of one is a good
+/// starting point for solving against the other.
+///
+/// This is a flat list of integers with a running hash, so building a key and
+/// looking it up doesn't allocate strings.
+class ClampingPatternKey
+{
+public:
+  ClampingPatternKey();
+
+  /// This appends a value to the pattern
+  void add(long value);
+
+  /// This appends a name (e.g. of a skeleton) to the pattern
+  void add(const std::string& name);
+
+  /// This appends every value from another key, e.g. to combine the patterns
+  /// of several constrained groups
+  void add(const ClampingPatternKey& other);
+
+  std::size_t getHash() const;
+
+  bool operator==(const ClampingPatternKey& other) const;
+
+  struct Hasher
+  {
+    std::size_t operator()(const ClampingPatternKey& key) const;
+  };
+
+protected:
+  std::vector<long> mValues;
+  std::size_t mHash;
+};
+
+/// This solves against Q = A_c^T * Minv * (A_c + A_ub * E) + CFM, the matrix
+/// we need to solve against to differentiate through the clamping constraint
+/// impulses. It's safe to share between threads.
+///
+/// A ClampingFactorization is either an exact factorization of its Q, or it's
+/// warm started from the exact factorization of a nearby Q with the same
+/// clamping pattern. A warm started one solves by iterative refinement against
+/// the nearby factorization, and only factors its own Q if refinement fails to
+/// converge, so both kinds give the same answers up to round-off.
+class ClampingFactorization
+{
+public:
+  /// The most refinement steps a warm started solve takes before giving up
+  /// and factoring Q
+  static constexpr int kMaxRefinementSteps = 4;
+
+  /// This factors Q from scratch
+  ClampingFactorization(const Eigen::MatrixXs& Q);
+
+  /// This warm starts from `base`, which must be an exact factorization of a Q
+  /// of the same size. Every time refinement fails and we have to factor Q
+  /// after all, we increment `numFallbacks`, if it's not null.
+  ClampingFactorization(
+      const Eigen::MatrixXs& Q,
+      std::shared_ptr<const ClampingFactorization> base,
+      std::shared_ptr<std::atomic<long>> numFallbacks = nullptr);
+
+  /// This is the matrix we solve against
+  const Eigen::MatrixXs& getQ() const;
+
+  /// This returns true if we're solving by refinement against the
+  /// factorization of another Q
+  bool isWarmStarted() const;
+
+  /// This returns X, the minimum norm least squares solution of Q * X = B
+  Eigen::MatrixXs solve(const Eigen::MatrixXs& B) const;
+
+  /// This returns the pseudoinverse of getQ(). It's only computed the first
+  /// time it's asked for, since most callers only ever need to solve().
+  const Eigen::MatrixXs& getPseudoInverse() const;
+
+protected:
+  /// This returns the exact factorization of getQ(), factoring it the first
+  /// time it's needed if we were warm started
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>&
+  getExactFactorization() const;
+
+  /// This tries to solve Q * X = B by refinement against mBase, and returns
+  /// false if it doesn't converge
+  bool solveByRefinement(const Eigen::MatrixXs& B, Eigen::MatrixXs& X) const;
+
+  Eigen::MatrixXs mQ;
+  std::shared_ptr<const ClampingFactorization> mBase;
+  std::shared_ptr<std::atomic<long>> mNumFallbacks;
+
+  /// Once refinement has failed once, we stop trying
+  mutable std::atomic<bool> mRefinementFailed;
+
+  mutable std::once_flag mFactoredOnce;
+  mutable Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> mFactored;
+
+  mutable std::once_flag mPseudoInverseOnce;
+  mutable Eigen::MatrixXs mPseudoInverse;
+};
+
+/// During MPC re-planning, and across optimizer iterations that revisit nearby
+/// trajectories, we end up differentiating through the same clamping contact
+/// set over and over, with Q only drifting a little each time. This holds on
+/// to the most recent exact factorization of Q for each clamping pattern.
+///
+/// If the Q being asked about is exactly the cached one, that's a hit. If it's
+/// within getMaxWarmStartDrift() of the cached one (in relative Frobenius
+/// norm), we hand back a warm started ClampingFactorization that refines
+/// against the cached factorization instead of factoring Q. Anything else is a
+/// miss, which gets factored and replaces the cached entry.
+///
+/// This is safe to share between threads, and World::clone() shares it, so the
+/// counters cover every thread of a parallel MultiShot.
+class ClampingFactorizationCache
+{
+public:
+  /// The default number of clamping patterns we keep factorizations for
+  static constexpr int kDefaultCapacity = 64;
+
+  /// The default largest relative change in Q we'll warm start across
+  static constexpr double kDefaultMaxWarmStartDrift = 1e-3;
+
+  ClampingFactorizationCache(int capacity = kDefaultCapacity);
+
+  /// This returns a factorization of Q, reusing or warm starting from the
+  /// cached one for `key` where we can, and otherwise factoring Q and caching
+  /// the result under `key`.
+  std::shared_ptr<const ClampingFactorization> getFactorization(
+      const ClampingPatternKey& key, const Eigen::MatrixXs& Q);
+
+  /// This sets how many clamping patterns we hold on to. Setting this to 0
+  /// disables caching, so every call to getFactorization() is a miss.
+  void setCapacity(int capacity);
+
+  int getCapacity();
+
+  /// This sets the largest relative change in Q, ||Q - Q_cached|| /
+  /// ||Q_cached||, that we'll warm start across. Setting this to 0 only ever
+  /// reuses exactly equal Qs.
+  void setMaxWarmStartDrift(s_t drift);
+
+  s_t getMaxWarmStartDrift();
+
+  /// This returns how many clamping patterns we're currently holding on to
+  int getNumEntries();
+
+  /// This is the number of calls to getFactorization() that reused a cached
+  /// factorization of exactly the same Q
+  long getNumHits() const;
+
+  /// This is the number of calls to getFactorization() that warm started from
+  /// a cached factorization of a nearby Q
+  long getNumWarmStarts() const;
+
+  /// This is the number of warm started factorizations whose refinement didn't
+  /// converge, so they had to factor Q after all
+  long getNumWarmStartFallbacks() const;
+
+  /// This is the number of calls to getFactorization() that had to factor Q
+  long getNumMisses() const;
+
+  /// This resets all the counters to 0, without clearing the cache
+  void resetCounters();
+
+  /// This drops all the cached factorizations, and resets the counters
+  void clear();
+
+protected:
+  /// This drops the least recently used entries until we're within capacity.
+  /// This must be called while holding mMutex.
+  void evictToCapacity();
+
+  typedef std::list<ClampingPatternKey> LRUList;
+
+  struct Entry
+  {
+    std::shared_ptr<const ClampingFactorization> factorization;
+    LRUList::iterator lruPosition;
+  };
+
+  std::mutex mMutex;
+  int mCapacity;
+  s_t mMaxWarmStartDrift;
+  std::unordered_map<ClampingPatternKey, Entry, ClampingPatternKey::Hasher>
+      mEntries;
+  /// The keys of mEntries, from most to least recently used
+  LRUList mLRU;
+
+  std::atomic<long> mNumHits;
+  std::atomic<long> mNumWarmStarts;
+  std::atomic<long> mNumMisses;
+  /// This is shared with the warm started factorizations we hand out
+  std::shared_ptr<std::atomic<long>> mNumWarmStartFallbacks;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
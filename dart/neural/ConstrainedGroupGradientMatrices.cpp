@@ -67,6 +67,8 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
   }
 
   mMassedImpulseTests.reserve(mNumConstraintDim);
+  invalidateClampingPatternCaches();
+  mCachedInvMassMatrixDirty = true;
 
   // Cache an inverse mass matrix for later use
   mMinv = Eigen::MatrixXs::Zero(mNumDOFs, mNumDOFs);
@@ -100,6 +102,8 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
   mTimeStep = timeStep;
 
   mMassedImpulseTests.reserve(mNumConstraintDim);
+  invalidateClampingPatternCaches();
+  mCachedInvMassMatrixDirty = true;
 }
 
 //==============================================================================
@@ -490,6 +494,8 @@ void ConstrainedGroupGradientMatrices::constructMatrices(
   // inter-penetration, so we're leaving it disabled.
   // deduplicateConstraints();
 
+  invalidateClampingPatternCaches();
+
   mContactConstraintMappings = mFIndex;
   // Group the constraints based on their solution values into three buckets:
   //
@@ -877,15 +883,13 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getControlForceVelJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_CONSTRAINED_GROUP
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun(
-        "ConstrainedGroupGradientMatrices.getControlForceVelJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "ConstrainedGroupGradientMatrices.getControlForceVelJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   const Eigen::MatrixXs& A_c = getClampingConstraintMatrix();
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
+  const Eigen::MatrixXs& Minv = getCachedInvMassMatrix(world);
 
   Eigen::MatrixXs jac;
 
@@ -916,11 +920,9 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getVelVelJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_CONSTRAINED_GROUP
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun(
-        "ConstrainedGroupGradientMatrices.getVelVelJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "ConstrainedGroupGradientMatrices.getVelVelJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   const Eigen::MatrixXs& A_c = getClampingConstraintMatrix();
@@ -928,7 +930,7 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getVelVelJacobian(
 
   // If there are no clamping constraints, then vel-vel is just the identity
   Eigen::VectorXs ddamp = getDampingVector(world);
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
+  const Eigen::MatrixXs& Minv = getCachedInvMassMatrix(world);
   Eigen::VectorXs spring_stiffs = getSpringStiffVector(world);
   s_t dt = world->getTimeStep();
   if (A_c.size() == 0)
@@ -961,11 +963,9 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getPosVelJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_CONSTRAINED_GROUP
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun(
-        "ConstrainedGroupGradientMatrices.getPosVelJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "ConstrainedGroupGradientMatrices.getPosVelJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   Eigen::MatrixXs jac = getVelJacobianWrt(world, WithRespectTo::POSITION);
@@ -985,11 +985,9 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getPosPosJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_CONSTRAINED_GROUP
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun(
-        "ConstrainedGroupGradientMatrices.getPosPosJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "ConstrainedGroupGradientMatrices.getPosPosJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   Eigen::MatrixXs jac = getJointsPosPosJacobian(world)
@@ -1010,11 +1008,9 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getVelPosJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_CONSTRAINED_GROUP
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun(
-        "ConstrainedGroupGradientMatrices.getVelPosJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "ConstrainedGroupGradientMatrices.getVelPosJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   Eigen::MatrixXs jac = getJointsVelPosJacobian(world)
@@ -1098,6 +1094,25 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getInvMassMatrix(
   return invMassMatrix;
 }
 
+//==============================================================================
+const Eigen::MatrixXs&
+ConstrainedGroupGradientMatrices::getCachedInvMassMatrix(WorldPtr world)
+{
+  if (mCachedInvMassMatrixDirty)
+  {
+    mCachedInvMassMatrix = getInvMassMatrix(world);
+    mCachedInvMassMatrixDirty = false;
+  }
+  return mCachedInvMassMatrix;
+}
+
+//==============================================================================
+void ConstrainedGroupGradientMatrices::invalidateClampingPatternCaches()
+{
+  mCachedClampingPatternKeyDirty = true;
+  mCachedClampingFactorization = nullptr;
+}
+
 Eigen::VectorXs ConstrainedGroupGradientMatrices::getDampingVector(
     WorldPtr world)
 {
@@ -1232,11 +1247,9 @@ ConstrainedGroupGradientMatrices::getBounceApproximationJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_CONSTRAINED_GROUP
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun(
-        "ConstrainedGroupGradientMatrices.getBounceApproximationJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "ConstrainedGroupGradientMatrices.getBounceApproximationJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   const Eigen::MatrixXs& A_b = getBouncingConstraintMatrix();
@@ -1337,7 +1350,7 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getVelJacobianWrt(
       dt * (tau - C - damping_forces - spring_forces) + A_c_ub_E * f_c,
       wrt);
 
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
+  const Eigen::MatrixXs& Minv = getCachedInvMassMatrix(world);
 
   Eigen::MatrixXs dF_c = getJacobianOfConstraintForce(world, wrt);
 
@@ -1380,30 +1393,22 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getJacobianOfConstraintForce(
     int wrtDim = wrt->dim(world.get());
     return Eigen::MatrixXs::Zero(0, wrtDim);
   }
-  const Eigen::MatrixXs& A_ub = getUpperBoundConstraintMatrix();
-  const Eigen::MatrixXs& E = getUpperBoundMappingMatrix();
-
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
-  Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
-  Eigen::MatrixXs Q = A_c.transpose() * Minv * A_c_ub_E;
-  Q.diagonal() += getConstraintForceMixingDiagonal();
-
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfac
-      = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const ClampingFactorization> factorization
+      = getClampingFactorization(world);
 
   Eigen::MatrixXs dB = getJacobianOfLCPOffsetClampingSubset(world, wrt);
 
   if (wrt == WithRespectTo::VELOCITY || wrt == WithRespectTo::FORCE)
   {
     // dQ_b is 0, so don't compute it
-    return Qfac.solve(dB);
+    return factorization->solve(dB);
   }
 
   Eigen::VectorXs b = getClampingConstraintRelativeVels();
   Eigen::MatrixXs dQ_b
       = getJacobianOfLCPConstraintMatrixClampingSubset(world, b, wrt);
 
-  return dQ_b + Qfac.solve(dB);
+  return dQ_b + factorization->solve(dB);
 }
 
 //==============================================================================
@@ -1476,6 +1481,58 @@ ConstrainedGroupGradientMatrices::getConstraintForceMixingDiagonal()
   return mConstraintForceMixingDiagonal;
 }
 
+//==============================================================================
+/// This identifies which constraints are clamping, which are upper bounded,
+/// and which clamping constraints the upper bounds are tied to. Two groups
+/// with the same key have Q matrices of the same shape and meaning.
+const ClampingPatternKey&
+ConstrainedGroupGradientMatrices::getClampingPatternKey()
+{
+  if (mCachedClampingPatternKeyDirty)
+  {
+    mCachedClampingPatternKey = ClampingPatternKey();
+    for (const std::string& name : mSkeletonNames)
+    {
+      mCachedClampingPatternKey.add(name);
+    }
+    mCachedClampingPatternKey.add(static_cast<long>(mNumDOFs));
+    for (std::size_t i = 0; i < mClampingIndex.size(); i++)
+    {
+      mCachedClampingPatternKey.add(static_cast<long>(mClampingIndex[i]));
+      mCachedClampingPatternKey.add(static_cast<long>(mUpperBoundIndex[i]));
+      if (mUpperBoundIndex[i] != -1 && i < (std::size_t)mFIndex.size())
+      {
+        mCachedClampingPatternKey.add(static_cast<long>(mFIndex(i)));
+      }
+    }
+    mCachedClampingPatternKeyDirty = false;
+  }
+  return mCachedClampingPatternKey;
+}
+
+//==============================================================================
+/// This returns a factorization of Q, going through the world's
+/// ClampingFactorizationCache so that we don't factor the same Q twice.
+std::shared_ptr<const ClampingFactorization>
+ConstrainedGroupGradientMatrices::getClampingFactorization(
+    simulation::WorldPtr world)
+{
+  if (mCachedClampingFactorization == nullptr)
+  {
+    const Eigen::MatrixXs& A_c = getClampingConstraintMatrix();
+    const Eigen::MatrixXs& A_ub = getUpperBoundConstraintMatrix();
+    const Eigen::MatrixXs& E = getUpperBoundMappingMatrix();
+    const Eigen::MatrixXs& Minv = getCachedInvMassMatrix(world);
+
+    Eigen::MatrixXs Q = A_c.transpose() * Minv * (A_c + A_ub * E);
+    Q.diagonal() += getConstraintForceMixingDiagonal();
+    mCachedClampingFactorization
+        = world->getClampingFactorizationCache()->getFactorization(
+            getClampingPatternKey(), Q);
+  }
+  return mCachedClampingFactorization;
+}
+
 //==============================================================================
 /// This returns the jacobian of Q^{-1}b, holding b constant, with respect to
 /// wrt
@@ -1497,17 +1554,16 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::
   const Eigen::MatrixXs& E = getUpperBoundMappingMatrix();
   Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
 
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
-  Eigen::MatrixXs Q = A_c.transpose() * Minv * (A_c + A_ub * E);
-  Q.diagonal() += getConstraintForceMixingDiagonal();
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfactored
-      = Q.completeOrthogonalDecomposition();
+  const Eigen::MatrixXs& Minv = getCachedInvMassMatrix(world);
+  std::shared_ptr<const ClampingFactorization> factorization
+      = getClampingFactorization(world);
+  const Eigen::MatrixXs& Q = factorization->getQ();
 
-  Eigen::VectorXs Qinv_b = Qfactored.solve(b);
+  Eigen::VectorXs Qinv_b = factorization->solve(b);
 
   if (wrt == WithRespectTo::POSITION)
   {
-    Eigen::MatrixXs Qinv = Qfactored.pseudoInverse();
+    const Eigen::MatrixXs& Qinv = factorization->getPseudoInverse();
     Eigen::MatrixXs I = Eigen::MatrixXs::Identity(Q.rows(), Q.cols());
 
     // Position is the only term that affects A_c and A_ub. We use the full
@@ -1546,16 +1602,18 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::
         // Note: this formula only asks for the Jacobian of Minv once, instead
         // of 3 times like the below formula. That's actually a pretty big speed
         // advantage. When we can, we should use this formula instead.
-        return -Qfactored.solve(dQ(Qfactored.solve(b)));
+        return -factorization->solve(dQ(factorization->solve(b)));
       }
       // Otherwise fall back to the exact Jacobian of the pseudo-inverse
       else
       {
         // This is the gradient of the pseudoinverse, see
         // https://mathoverflow.net/a/29511/163259
-        return -Qfactored.solve(dQ(Qfactored.solve(b)))
-               + Qfactored.solve(Qinv.transpose() * dQT(imprecisionMap * b))
-               + (I - Qinv * Q) * dQT(Qinv.transpose() * Qfactored.solve(b));
+        return -factorization->solve(dQ(factorization->solve(b)))
+               + factorization->solve(
+                   Qinv.transpose() * dQT(imprecisionMap * b))
+               + (I - Qinv * Q)
+                     * dQT(Qinv.transpose() * factorization->solve(b));
       }
 
 #undef dQ
@@ -1584,7 +1642,7 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::
         // of 3 times like the below formula. That's actually a pretty big speed
         // advantage. When we can, we should use this formula instead.
         // return -Qinv * dQ(Qinv * b);
-        return -Qfactored.solve(dQ(Qfactored.solve(b)));
+        return -factorization->solve(dQ(factorization->solve(b)));
       }
       else
       {
@@ -1595,9 +1653,11 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::
                + Qinv * Qinv.transpose() * dQT(imprecisionMap * b)
                + (I - Qinv * Q) * dQT(Qinv.transpose() * Qinv * b);
         */
-        return -Qfactored.solve(dQ(Qfactored.solve(b)))
-               + Qfactored.solve(Qinv.transpose() * dQT(imprecisionMap * b))
-               + (I - Qinv * Q) * dQT(Qinv.transpose() * Qfactored.solve(b));
+        return -factorization->solve(dQ(factorization->solve(b)))
+               + factorization->solve(
+                   Qinv.transpose() * dQT(imprecisionMap * b))
+               + (I - Qinv * Q)
+                     * dQT(Qinv.transpose() * factorization->solve(b));
       }
 
 #undef dQ
@@ -1609,7 +1669,7 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::
     // All other terms get to treat A_c as constant
     Eigen::MatrixXs innerTerms
         = A_c.transpose() * getJacobianOfMinv(world, A_c * Qinv_b, wrt);
-    Eigen::MatrixXs result = -Qfactored.solve(innerTerms);
+    Eigen::MatrixXs result = -factorization->solve(innerTerms);
 
     return result;
   }
@@ -1624,7 +1684,7 @@ ConstrainedGroupGradientMatrices::getJacobianOfLCPOffsetClampingSubset(
     simulation::WorldPtr world, WithRespectTo* wrt)
 {
   s_t dt = world->getTimeStep();
-  Eigen::MatrixXs Minv = getInvMassMatrix(world);
+  const Eigen::MatrixXs& Minv = getCachedInvMassMatrix(world);
   const Eigen::MatrixXs& A_c = getClampingConstraintMatrix();
   Eigen::MatrixXs dC = getJacobianOfC(world, wrt);
   Eigen::MatrixXs spring_stiffs = getSpringStiffVector(world).asDiagonal();
@@ -9,6 +9,7 @@
 #include <Eigen/Dense>
 
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/ClampingFactorizationCache.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -251,6 +252,19 @@ public:
   /// to guarantee that Q is full-rank
   Eigen::VectorXs& getConstraintForceMixingDiagonal();
 
+  /// This identifies which constraints are clamping, which are upper bounded,
+  /// and which clamping constraints the upper bounds are tied to. Two groups
+  /// with the same key have Q matrices of the same shape and meaning. This is
+  /// only built once per clamping pattern.
+  const ClampingPatternKey& getClampingPatternKey();
+
+  /// This returns a factorization of Q, going through the world's
+  /// ClampingFactorizationCache so that we don't factor the same Q twice. Q
+  /// itself is available from getQ() on the result. This is only computed
+  /// once per clamping pattern.
+  std::shared_ptr<const ClampingFactorization> getClampingFactorization(
+      simulation::WorldPtr world);
+
   /// This returns the jacobian of Q^{-1}b, holding b constant, with respect to
   /// wrt
   Eigen::MatrixXs getJacobianOfLCPConstraintMatrixClampingSubset(
@@ -451,6 +465,12 @@ private:
   std::vector<std::shared_ptr<dynamics::Skeleton>> getSkeletons(
       simulation::WorldPtr world);
 
+  /// This returns getInvMassMatrix(world), only computing it the first time
+  const Eigen::MatrixXs& getCachedInvMassMatrix(simulation::WorldPtr world);
+
+  /// This throws away everything that depends on the clamping pattern
+  void invalidateClampingPatternCaches();
+
 public:
   /// This is only true after we've called constructMatrices(). It's a useful
   /// flag to ensure we don't call it twice.
@@ -624,6 +644,14 @@ public:
   /// mImpulseTests[k] holds the k'th constraint's impulse test, which is
   /// a concatenated vector of the results for each skeleton in the group.
   std::vector<Eigen::VectorXs> mMassedImpulseTests;
+
+  /// These are lazily computed the first time we need them for gradients, and
+  /// thrown away whenever the clamping pattern changes
+  bool mCachedInvMassMatrixDirty;
+  Eigen::MatrixXs mCachedInvMassMatrix;
+  bool mCachedClampingPatternKeyDirty;
+  ClampingPatternKey mCachedClampingPatternKey;
+  std::shared_ptr<const ClampingFactorization> mCachedClampingFactorization;
 };
 
 } // namespace neural
@@ -205,10 +205,9 @@ void MappedBackpropSnapshot::backprop(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MAPPED_BACKPROP_SNAPSHOT
-  if (perfLog != nullptr)
-  {
-    thisLog = perfLog->startRun("MappedBackpropSnapshot.backprop");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      perfLog, "MappedBackpropSnapshot.backprop");
+  thisLog = scopedThisLog.get();
 #endif
 
   /*
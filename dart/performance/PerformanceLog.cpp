@@ -1,13 +1,19 @@
 #include "dart/performance/PerformanceLog.hpp"
 
-#include <ctime>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <deque>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <mutex>
-#include <random>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #ifdef HAVE_PERF_UTILS
@@ -19,129 +25,542 @@
 namespace dart {
 namespace performance {
 
-std::unordered_map<std::string, int> PerformanceLog::globalPerfStringIndex;
-std::deque<PerformanceLog*> PerformanceLog::globalPerfLogsList;
-std::unordered_map<int, std::string>
-    PerformanceLog::globalPerfStringReverseIndex;
-std::mutex PerformanceLog::globalPerfLogListMutex;
+namespace {
+
+// Every distinct path of names gets an index into these fixed-size chunks of
+// histograms, which each thread allocates as it first sees paths
+constexpr int kPathsPerChunk = 64;
+constexpr int kMaxChunks = 1024;
+constexpr int kMaxPaths = kPathsPerChunk * kMaxChunks;
 
 //==============================================================================
-void PerformanceLog::initialize()
+inline uint64_t getClock()
+{
+#ifdef HAVE_PERF_UTILS
+  return PerfUtils::Cycles::rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+//==============================================================================
+inline s_t clockToMicroseconds(uint64_t ticks)
+{
+#ifdef HAVE_PERF_UTILS
+  return static_cast<s_t>(PerfUtils::Cycles::toSeconds(ticks) * 1e6);
+#else
+  return static_cast<s_t>(ticks) / 1000.0;
+#endif
+}
+
+//==============================================================================
+std::string escapeJson(const std::string& str)
 {
-  globalPerfStringIndex = std::unordered_map<std::string, int>(30);
-  globalPerfLogsList = std::deque<PerformanceLog*>();
-  globalPerfStringReverseIndex = std::unordered_map<int, std::string>(30);
+  std::stringstream stream;
+  for (char c : str)
+  {
+    switch (c)
+    {
+      case '"':
+        stream << "\\\"";
+        break;
+      case '\\':
+        stream << "\\\\";
+        break;
+      case '\n':
+        stream << "\\n";
+        break;
+      case '\t':
+        stream << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          stream << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                 << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else
+        {
+          stream << c;
+        }
+    }
+  }
+  return stream.str();
+}
+
+/// This is a PerformanceHistogram that only its owning thread writes, but that
+/// finalize() can read from any thread at any time.
+struct ThreadHistogram
+{
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> total{0};
+  std::atomic<uint64_t> min{std::numeric_limits<uint64_t>::max()};
+  std::atomic<uint64_t> max{0};
+  std::array<std::atomic<uint64_t>, PerformanceHistogram::kNumBuckets> buckets;
+
+  ThreadHistogram()
+  {
+    for (auto& bucket : buckets)
+      bucket.store(0, std::memory_order_relaxed);
+  }
+
+  // There's only ever one writer, so we don't need read-modify-write atomics
+  void record(uint64_t duration)
+  {
+    count.store(
+        count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    total.store(
+        total.load(std::memory_order_relaxed) + duration,
+        std::memory_order_relaxed);
+    if (duration < min.load(std::memory_order_relaxed))
+      min.store(duration, std::memory_order_relaxed);
+    if (duration > max.load(std::memory_order_relaxed))
+      max.store(duration, std::memory_order_relaxed);
+    std::atomic<uint64_t>& bucket
+        = buckets[PerformanceHistogram::getBucket(duration)];
+    bucket.store(
+        bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  void clear()
+  {
+    count.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    min.store(
+        std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+    for (auto& bucket : buckets)
+      bucket.store(0, std::memory_order_relaxed);
+  }
+};
+
+/// This is one run kept for the Chrome trace. The fields are atomic so that
+/// toChromeTrace() can read the ring while its owner is overwriting it.
+struct TraceEvent
+{
+  std::atomic<uint64_t> start{0};
+  std::atomic<uint64_t> duration{0};
+  std::atomic<int> pathId{-1};
+};
+
+/// This is everything a single thread records into. These are never freed:
+/// when a thread exits its buffer gets handed to the next new thread, so the
+/// number of buffers is bounded by the number of threads alive at once.
+struct ThreadBuffer
+{
+  // This is the tid we report in Chrome traces
+  int tid;
+
+  // Written only by the owning thread
+  std::array<std::atomic<ThreadHistogram*>, kMaxChunks> chunks;
+  std::unique_ptr<TraceEvent[]> trace;
+  std::atomic<uint64_t> traceHead{0};
+
+  // If this doesn't match the global generation, initialize() has been called
+  // since we last recorded, and everything above is stale
+  std::atomic<uint64_t> generation{0};
+
+  // These are only ever touched by the owning thread. Only logs handed back
+  // by ScopedPerformanceLog end up in freeLogs.
+  std::vector<PerformanceLog*> freeLogs;
+  std::unordered_map<const char*, std::pair<int, const std::string*>>
+      nameCache;
+  std::unordered_map<uint64_t, int> pathCache;
+  s_t samplingAccumulator = 0.0;
+
+  ThreadBuffer(int tid)
+    : tid(tid), trace(new TraceEvent[PerformanceLog::kTraceEventsPerThread])
+  {
+    for (auto& chunk : chunks)
+      chunk.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ThreadHistogram* getHistogram(int pathId)
+  {
+    std::atomic<ThreadHistogram*>& chunk = chunks[pathId / kPathsPerChunk];
+    ThreadHistogram* histograms = chunk.load(std::memory_order_relaxed);
+    if (histograms == nullptr)
+    {
+      histograms = new ThreadHistogram[kPathsPerChunk];
+      chunk.store(histograms, std::memory_order_release);
+    }
+    return &histograms[pathId % kPathsPerChunk];
+  }
+};
+
+struct PathEntry
+{
+  int parentPathId;
+  int nameIndex;
+};
+
+/// This is the shared state. It's intentionally leaked, so that threads still
+/// running while static destructors run never see it destroyed.
+struct Registry
+{
+  // Guards everything in the registry other than the atomics
+  std::mutex mutex;
+
+  // Interned names. A deque keeps the strings at stable addresses.
+  std::deque<std::string> names;
+  std::unordered_map<std::string, int> nameIndex;
+
+  // Interned paths, where each path is a name under a parent path
+  std::vector<PathEntry> paths;
+  std::map<std::pair<int, int>, int> pathIndex;
+
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  std::vector<ThreadBuffer*> retiredBuffers;
+
+  std::atomic<uint64_t> generation{1};
+  std::atomic<uint64_t> epochClock{getClock()};
+  std::atomic<s_t> samplingRate{1.0};
+
+  static Registry& instance()
+  {
+    static Registry* registry = new Registry();
+    return *registry;
+  }
+};
+
+/// This hands a thread's buffer back to the registry when the thread exits
+struct ThreadBufferHandle
+{
+  ThreadBuffer* buffer = nullptr;
+
+  ~ThreadBufferHandle()
+  {
+    if (buffer != nullptr)
+    {
+      Registry& registry = Registry::instance();
+      const std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.retiredBuffers.push_back(buffer);
+    }
+  }
+};
+
+//==============================================================================
+ThreadBuffer& getThreadBuffer()
+{
+  thread_local ThreadBufferHandle handle;
+  if (handle.buffer == nullptr)
+  {
+    Registry& registry = Registry::instance();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    if (!registry.retiredBuffers.empty())
+    {
+      handle.buffer = registry.retiredBuffers.back();
+      registry.retiredBuffers.pop_back();
+    }
+    else
+    {
+      registry.buffers.push_back(
+          std::make_unique<ThreadBuffer>(registry.buffers.size() + 1));
+      handle.buffer = registry.buffers.back().get();
+    }
+  }
+
+  // If initialize() has been called since we last recorded, throw everything
+  // away before we record anything new
+  ThreadBuffer& buffer = *handle.buffer;
+  const uint64_t generation
+      = Registry::instance().generation.load(std::memory_order_acquire);
+  if (buffer.generation.load(std::memory_order_relaxed) != generation)
+  {
+    for (auto& chunk : buffer.chunks)
+    {
+      ThreadHistogram* histograms = chunk.load(std::memory_order_relaxed);
+      if (histograms == nullptr)
+        continue;
+      for (int i = 0; i < kPathsPerChunk; i++)
+        histograms[i].clear();
+    }
+    buffer.traceHead.store(0, std::memory_order_relaxed);
+    buffer.generation.store(generation, std::memory_order_release);
+  }
+  return buffer;
 }
 
 //==============================================================================
-int PerformanceLog::mapStringToIndex(const char* c_str)
+int internName(ThreadBuffer& buffer, const char* name)
 {
-  std::string str(c_str);
-  // Key is not present
-  auto value = PerformanceLog::globalPerfStringIndex.find(str);
-  if (value == PerformanceLog::globalPerfStringIndex.end())
+  // Names are almost always string literals, so we cache by pointer, but check
+  // the contents in case the pointer has been reused for a different string
+  auto cached = buffer.nameCache.find(name);
+  if (cached != buffer.nameCache.end()
+      && std::strcmp(cached->second.second->c_str(), name) == 0)
   {
-    int newKey = PerformanceLog::globalPerfStringIndex.size();
-    PerformanceLog::globalPerfStringIndex[str] = newKey;
-    return newKey;
+    return cached->second.first;
+  }
+
+  Registry& registry = Registry::instance();
+  const std::lock_guard<std::mutex> lock(registry.mutex);
+  std::string str(name);
+  int index;
+  auto value = registry.nameIndex.find(str);
+  if (value == registry.nameIndex.end())
+  {
+    index = registry.names.size();
+    registry.names.push_back(str);
+    registry.nameIndex[str] = index;
   }
   else
   {
-    return value->second;
+    index = value->second;
   }
+  buffer.nameCache[name] = std::make_pair(index, &registry.names[index]);
+  return index;
 }
 
 //==============================================================================
-inline uint64_t getClock()
+/// This returns -1 if we've run out of room for new paths
+int internPath(ThreadBuffer& buffer, int parentPathId, const char* name)
 {
-#ifdef HAVE_PERF_UTILS
-  return PerfUtils::Cycles::rdtsc();
-#else
-  std::cout << "Trying to use PerformanceLog::getClock() on an unsupported architecture!" << std::endl;
-  return 0;
-#endif
+  const int nameIndex = internName(buffer, name);
+  const uint64_t key = (static_cast<uint64_t>(parentPathId + 1) << 32)
+                       | static_cast<uint32_t>(nameIndex);
+  auto cached = buffer.pathCache.find(key);
+  if (cached != buffer.pathCache.end())
+  {
+    return cached->second;
+  }
+
+  Registry& registry = Registry::instance();
+  const std::lock_guard<std::mutex> lock(registry.mutex);
+  int pathId;
+  auto value = registry.pathIndex.find(std::make_pair(parentPathId, nameIndex));
+  if (value == registry.pathIndex.end())
+  {
+    if (registry.paths.size() >= kMaxPaths)
+    {
+      static bool warned = false;
+      if (!warned)
+      {
+        std::cout << "PerformanceLog has run out of room after " << kMaxPaths
+                  << " distinct paths of names, and will ignore new ones"
+                  << std::endl;
+        warned = true;
+      }
+      return -1;
+    }
+    pathId = registry.paths.size();
+    registry.paths.push_back(PathEntry{parentPathId, nameIndex});
+    registry.pathIndex[std::make_pair(parentPathId, nameIndex)] = pathId;
+  }
+  else
+  {
+    pathId = value->second;
+  }
+  buffer.pathCache[key] = pathId;
+  return pathId;
 }
 
 //==============================================================================
-/// Default constructor
-PerformanceLog::PerformanceLog(int nameIndex, int parentId)
-  : mNameIndex(nameIndex),
-    mStartClock(getClock()),
-    mEndClock(0),
-    mId(rand()),
-    mParentId(parentId)
+/// This is handed out for runs that aren't being sampled. It's never written
+/// to, so it's safe to share between threads.
+PerformanceLog& getUnsampledLog()
 {
+  static PerformanceLog* unsampled = new PerformanceLog();
+  return *unsampled;
 }
 
+} // namespace
+
 //==============================================================================
-PerformanceLog* PerformanceLog::startRoot(char const* name)
+PerformanceHistogram::PerformanceHistogram()
 {
-  PerformanceLog* newRoot = new PerformanceLog(mapStringToIndex(name), -1);
-  // Serialize our access to the log list
-  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
-  globalPerfLogsList.push_back(newRoot);
-  return newRoot;
+  clear();
 }
 
 //==============================================================================
-/// This looks through all the PerformanceLogs in the system and builds a
-/// report
-std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
-PerformanceLog::finalize()
+int PerformanceHistogram::getBucket(uint64_t duration)
 {
-  // First we need to set up the reverse index so we can rapidly look up strings
-  globalPerfStringReverseIndex.clear();
-  for (auto pair : globalPerfStringIndex)
+  int bucket = 0;
+  while (duration != 0)
   {
-    globalPerfStringReverseIndex[pair.second] = pair.first;
+    duration >>= 1;
+    bucket++;
   }
+  return bucket;
+}
 
-  // Next we need to look through for all the root names:
-  std::unordered_set<int> rootNameIds;
-  for (PerformanceLog* log : globalPerfLogsList)
+//==============================================================================
+void PerformanceHistogram::record(uint64_t duration)
+{
+  mCount++;
+  mTotal += duration;
+  mMin = std::min(mMin, duration);
+  mMax = std::max(mMax, duration);
+  mBuckets[getBucket(duration)]++;
+}
+
+//==============================================================================
+void PerformanceHistogram::merge(const PerformanceHistogram& other)
+{
+  mCount += other.mCount;
+  mTotal += other.mTotal;
+  mMin = std::min(mMin, other.mMin);
+  mMax = std::max(mMax, other.mMax);
+  for (int i = 0; i < kNumBuckets; i++)
+    mBuckets[i] += other.mBuckets[i];
+}
+
+//==============================================================================
+void PerformanceHistogram::clear()
+{
+  mCount = 0;
+  mTotal = 0;
+  mMin = std::numeric_limits<uint64_t>::max();
+  mMax = 0;
+  mBuckets.fill(0);
+}
+
+//==============================================================================
+uint64_t PerformanceHistogram::getCount() const
+{
+  return mCount;
+}
+
+//==============================================================================
+uint64_t PerformanceHistogram::getTotal() const
+{
+  return mTotal;
+}
+
+//==============================================================================
+uint64_t PerformanceHistogram::getMin() const
+{
+  return mCount == 0 ? 0 : mMin;
+}
+
+//==============================================================================
+uint64_t PerformanceHistogram::getMax() const
+{
+  return mMax;
+}
+
+//==============================================================================
+s_t PerformanceHistogram::getMean() const
+{
+  if (mCount == 0)
+    return 0.0;
+  return static_cast<s_t>(mTotal) / mCount;
+}
+
+//==============================================================================
+s_t PerformanceHistogram::getPercentile(s_t percentile) const
+{
+  if (mCount == 0)
+    return 0.0;
+  percentile = std::max(static_cast<s_t>(0.0), std::min(percentile, 1.0));
+  const s_t rank = percentile * mCount;
+  uint64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; i++)
   {
-    if (log->mParentId == -1)
-      rootNameIds.insert(log->mNameIndex);
+    if (mBuckets[i] == 0)
+      continue;
+    if (seen + mBuckets[i] >= rank)
+    {
+      // Interpolate linearly within [2^(i-1), 2^i)
+      const s_t lower = i == 0 ? 0.0 : std::ldexp(1.0, i - 1);
+      const s_t upper = i == 0 ? 0.0 : std::ldexp(1.0, i);
+      const s_t fraction = (rank - seen) / mBuckets[i];
+      const s_t estimate = lower + fraction * (upper - lower);
+      return std::max(
+          static_cast<s_t>(getMin()),
+          std::min(estimate, static_cast<s_t>(mMax)));
+    }
+    seen += mBuckets[i];
   }
+  return static_cast<s_t>(mMax);
+}
 
-  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
-      rootLogs;
-  for (int nameId : rootNameIds)
+//==============================================================================
+const std::array<uint64_t, PerformanceHistogram::kNumBuckets>&
+PerformanceHistogram::getBuckets() const
+{
+  return mBuckets;
+}
+
+//==============================================================================
+void PerformanceLog::initialize()
+{
+  // Each thread clears its own buffers the next time it records, and
+  // finalize() ignores buffers that haven't caught up yet
+  Registry& registry = Registry::instance();
+  registry.epochClock.store(getClock(), std::memory_order_relaxed);
+  registry.generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+//==============================================================================
+void PerformanceLog::setSamplingRate(s_t rate)
+{
+  Registry::instance().samplingRate.store(
+      std::max(static_cast<s_t>(0.0), std::min(rate, 1.0)),
+      std::memory_order_relaxed);
+}
+
+//==============================================================================
+s_t PerformanceLog::getSamplingRate()
+{
+  return Registry::instance().samplingRate.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+PerformanceLog::PerformanceLog()
+  : mPathId(-1), mStartClock(0), mSampled(false), mEnded(true)
+{
+}
+
+//==============================================================================
+PerformanceLog* PerformanceLog::start(int pathId, bool sampled)
+{
+  if (!sampled || pathId < 0)
   {
-    std::vector<int> nameIdStack;
-    nameIdStack.push_back(nameId);
-    // Next we look through for all the
-    // This will recursively look through all the PerformanceLog's and construct
-    // what we need.
-    rootLogs[globalPerfStringReverseIndex[nameId]]
-        = FinalizedPerformanceLog::recursivelyConstruct(nameIdStack);
+    return &getUnsampledLog();
   }
 
-  return rootLogs;
+  ThreadBuffer& buffer = getThreadBuffer();
+  PerformanceLog* log;
+  if (buffer.freeLogs.empty())
+  {
+    log = new PerformanceLog();
+  }
+  else
+  {
+    log = buffer.freeLogs.back();
+    buffer.freeLogs.pop_back();
+  }
+  log->mPathId = pathId;
+  log->mSampled = true;
+  log->mEnded = false;
+  // Read the clock last, so that our own overhead isn't counted
+  log->mStartClock = getClock();
+  return log;
 }
 
 //==============================================================================
-/// This checks if a given PerformanceLog object matches a stack of nameIds
-bool PerformanceLog::matches(std::vector<int> nameIdStack)
+PerformanceLog* PerformanceLog::startRoot(char const* name)
 {
-  if (nameIdStack[nameIdStack.size() - 1] != mNameIndex)
-    return false;
-  if (nameIdStack.size() == 1)
-    return true;
-  assert(mParentId != -1);
+  ThreadBuffer& buffer = getThreadBuffer();
 
-  std::vector<int> subStack = nameIdStack;
-  subStack.pop_back();
-  // Find parent and recurse
-  for (PerformanceLog* log : globalPerfLogsList)
+  bool sampled = true;
+  const s_t rate = getSamplingRate();
+  if (rate < 1.0)
   {
-    if (log->mId == mParentId)
-    {
-      return log->matches(subStack);
-    }
+    buffer.samplingAccumulator += rate;
+    sampled = buffer.samplingAccumulator >= 1.0;
+    if (sampled)
+      buffer.samplingAccumulator -= 1.0;
+  }
+  if (!sampled)
+  {
+    return &getUnsampledLog();
   }
 
-  return false;
+  return start(internPath(buffer, -1, name), true);
 }
 
 //==============================================================================
@@ -150,11 +569,11 @@ bool PerformanceLog::matches(std::vector<int> nameIdStack)
 /// objects into something sensible.
 PerformanceLog* PerformanceLog::startRun(char const* name)
 {
-  PerformanceLog* log = new PerformanceLog(mapStringToIndex(name), mId);
-  // Serialize our access to the log list
-  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
-  globalPerfLogsList.push_back(log);
-  return log;
+  if (!mSampled)
+  {
+    return &getUnsampledLog();
+  }
+  return start(internPath(getThreadBuffer(), mPathId, name), true);
 }
 
 //==============================================================================
@@ -162,62 +581,255 @@ PerformanceLog* PerformanceLog::startRun(char const* name)
 /// object.
 void PerformanceLog::end()
 {
-  mEndClock = getClock();
+  if (!mSampled || mEnded)
+  {
+    return;
+  }
+  const uint64_t endClock = getClock();
+  mEnded = true;
+
+  ThreadBuffer& buffer = getThreadBuffer();
+  const uint64_t duration = endClock - mStartClock;
+  buffer.getHistogram(mPathId)->record(duration);
+
+  const uint64_t head = buffer.traceHead.load(std::memory_order_relaxed);
+  TraceEvent& event = buffer.trace[head % kTraceEventsPerThread];
+  event.start.store(mStartClock, std::memory_order_relaxed);
+  event.duration.store(duration, std::memory_order_relaxed);
+  event.pathId.store(mPathId, std::memory_order_relaxed);
+  buffer.traceHead.store(head + 1, std::memory_order_release);
+}
+
+//==============================================================================
+void PerformanceLog::recycle(PerformanceLog* log)
+{
+  // The shared log for unsampled runs isn't ours to hand out
+  if (log == nullptr || !log->mSampled)
+  {
+    return;
+  }
+  assert(log->mEnded);
+  // Make sure that end() on a stale pointer can't record anything before the
+  // log is handed out again
+  log->mSampled = false;
+  getThreadBuffer().freeLogs.push_back(log);
+}
+
+//==============================================================================
+ScopedPerformanceLog::ScopedPerformanceLog(char const* name)
+  : mLog(PerformanceLog::startRoot(name))
+{
 }
 
 //==============================================================================
-/// This will look through the global static lists and recursively construct
-/// all the FinalizedPerformanceLogs to unify everything.
-std::shared_ptr<FinalizedPerformanceLog>
-FinalizedPerformanceLog::recursivelyConstruct(std::vector<int> nameIdStack)
+ScopedPerformanceLog::ScopedPerformanceLog(
+    PerformanceLog* parent, char const* name)
+  : mLog(parent == nullptr ? nullptr : parent->startRun(name))
 {
-  std::shared_ptr<FinalizedPerformanceLog> log
-      = std::make_shared<FinalizedPerformanceLog>(
-          PerformanceLog::globalPerfStringReverseIndex
-              [nameIdStack[nameIdStack.size() - 1]]);
+}
 
-  std::unordered_set<int> selfIds;
+//==============================================================================
+ScopedPerformanceLog::ScopedPerformanceLog(ScopedPerformanceLog&& other)
+  : mLog(other.mLog)
+{
+  other.mLog = nullptr;
+}
 
-  // Scan through once looking for instances of us
+//==============================================================================
+ScopedPerformanceLog::~ScopedPerformanceLog()
+{
+  if (mLog != nullptr)
+  {
+    mLog->end();
+    PerformanceLog::recycle(mLog);
+  }
+}
 
-  for (int i = 0; i < PerformanceLog::globalPerfLogsList.size(); i++)
+//==============================================================================
+void ScopedPerformanceLog::end()
+{
+  if (mLog != nullptr)
   {
-    PerformanceLog* rawLog = PerformanceLog::globalPerfLogsList[i];
-    if (rawLog->matches(nameIdStack))
-    {
-      uint64_t diff = rawLog->mEndClock - rawLog->mStartClock;
-      log->registerRun(diff);
-      selfIds.insert(rawLog->mId);
-    }
+    mLog->end();
   }
+}
 
-  // Scan through again looking for child names
+//==============================================================================
+PerformanceLog* ScopedPerformanceLog::get() const
+{
+  return mLog;
+}
 
-  std::unordered_set<int> childNameIds;
-  for (int i = 0; i < PerformanceLog::globalPerfLogsList.size(); i++)
+//==============================================================================
+PerformanceLog* ScopedPerformanceLog::operator->() const
+{
+  return mLog;
+}
+
+//==============================================================================
+/// This looks through all the PerformanceLogs in the system and builds a
+/// report
+std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+PerformanceLog::finalize()
+{
+  Registry& registry = Registry::instance();
+  const std::lock_guard<std::mutex> lock(registry.mutex);
+  const uint64_t generation
+      = registry.generation.load(std::memory_order_acquire);
+
+  // First we merge every thread's histograms, path by path
+  std::vector<PerformanceHistogram> merged(registry.paths.size());
+  for (auto& buffer : registry.buffers)
   {
-    PerformanceLog* rawLog = PerformanceLog::globalPerfLogsList[i];
-    // Found a child!
-    if (selfIds.find(rawLog->mParentId) != selfIds.end())
+    if (buffer->generation.load(std::memory_order_acquire) != generation)
+      continue;
+    for (int chunkIndex = 0; chunkIndex < kMaxChunks; chunkIndex++)
     {
-      childNameIds.insert(rawLog->mNameIndex);
+      ThreadHistogram* histograms
+          = buffer->chunks[chunkIndex].load(std::memory_order_acquire);
+      if (histograms == nullptr)
+        continue;
+      for (int i = 0; i < kPathsPerChunk; i++)
+      {
+        const int pathId = chunkIndex * kPathsPerChunk + i;
+        if (pathId >= merged.size())
+          break;
+        const ThreadHistogram& source = histograms[i];
+        // We might catch the owning thread halfway through a record(), so we
+        // count runs from the buckets, to keep percentiles self-consistent
+        PerformanceHistogram histogram;
+        for (int b = 0; b < PerformanceHistogram::kNumBuckets; b++)
+        {
+          histogram.mBuckets[b]
+              = source.buckets[b].load(std::memory_order_relaxed);
+          histogram.mCount += histogram.mBuckets[b];
+        }
+        if (histogram.mCount == 0)
+          continue;
+        histogram.mTotal = source.total.load(std::memory_order_relaxed);
+        histogram.mMin = source.min.load(std::memory_order_relaxed);
+        histogram.mMax = source.max.load(std::memory_order_relaxed);
+        merged[pathId].merge(histogram);
+      }
     }
   }
 
-  // Create all the children
+  // Then we build a FinalizedPerformanceLog for every path that has any runs,
+  // along with all its ancestors
+  std::vector<std::shared_ptr<FinalizedPerformanceLog>> nodes(
+      registry.paths.size());
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      rootLogs;
+  std::function<std::shared_ptr<FinalizedPerformanceLog>(int)> getNode
+      = [&](int pathId) {
+          if (nodes[pathId] != nullptr)
+            return nodes[pathId];
+          const PathEntry& entry = registry.paths[pathId];
+          const std::string& name = registry.names[entry.nameIndex];
+          std::shared_ptr<FinalizedPerformanceLog> node
+              = std::make_shared<FinalizedPerformanceLog>(name);
+          node->registerRuns(merged[pathId]);
+          nodes[pathId] = node;
+          if (entry.parentPathId == -1)
+            rootLogs[name] = node;
+          else
+            getNode(entry.parentPathId)->setChild(name, node);
+          return node;
+        };
+  for (int pathId = 0; pathId < registry.paths.size(); pathId++)
+  {
+    if (merged[pathId].getCount() > 0)
+      getNode(pathId);
+  }
 
-  for (int childNameId : childNameIds)
+  return rootLogs;
+}
+
+//==============================================================================
+std::string PerformanceLog::toChromeTrace()
+{
+  Registry& registry = Registry::instance();
+  const std::lock_guard<std::mutex> lock(registry.mutex);
+  const uint64_t generation
+      = registry.generation.load(std::memory_order_acquire);
+  const uint64_t epoch = registry.epochClock.load(std::memory_order_relaxed);
+
+  // The full path of names is more useful than just the leaf name when the
+  // same name shows up under several parents
+  std::vector<std::string> pathNames(registry.paths.size());
+  for (int pathId = 0; pathId < registry.paths.size(); pathId++)
   {
-    std::vector<int> childNameIdStack = nameIdStack;
-    childNameIdStack.push_back(childNameId);
-    log->setChild(
-        PerformanceLog::globalPerfStringReverseIndex[childNameId],
-        recursivelyConstruct(childNameIdStack));
+    const PathEntry& entry = registry.paths[pathId];
+    // Parents are always interned before their children
+    pathNames[pathId] = entry.parentPathId == -1
+                            ? ""
+                            : pathNames[entry.parentPathId] + "/";
+    pathNames[pathId] += registry.names[entry.nameIndex];
   }
 
-  // And we're done!
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(3);
+  stream << "{\"traceEvents\":[";
+  bool first = true;
+  for (auto& buffer : registry.buffers)
+  {
+    if (buffer->generation.load(std::memory_order_acquire) != generation)
+      continue;
+    const uint64_t head = buffer->traceHead.load(std::memory_order_acquire);
+    if (head == 0)
+      continue;
+
+    if (!first)
+      stream << ",";
+    first = false;
+    stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+           << buffer->tid << ",\"args\":{\"name\":\"thread " << buffer->tid
+           << "\"}}";
+
+    const uint64_t numEvents
+        = std::min(head, static_cast<uint64_t>(kTraceEventsPerThread));
+    for (uint64_t i = head - numEvents; i < head; i++)
+    {
+      const TraceEvent& event = buffer->trace[i % kTraceEventsPerThread];
+      const uint64_t start = event.start.load(std::memory_order_relaxed);
+      const uint64_t duration = event.duration.load(std::memory_order_relaxed);
+      const int pathId = event.pathId.load(std::memory_order_relaxed);
+      // If the owning thread has lapped us while we were reading, this slot
+      // may hold a mix of two events, so we skip it
+      const uint64_t newHead
+          = buffer->traceHead.load(std::memory_order_acquire);
+      if (newHead - i > kTraceEventsPerThread || pathId < 0
+          || pathId >= pathNames.size())
+        continue;
+
+      const s_t ts = start >= epoch ? clockToMicroseconds(start - epoch)
+                                    : -clockToMicroseconds(epoch - start);
+      const PathEntry& entry = registry.paths[pathId];
+      stream << ",{\"name\":\""
+             << escapeJson(registry.names[entry.nameIndex])
+             << "\",\"cat\":\"nimble\",\"ph\":\"X\",\"ts\":" << ts
+             << ",\"dur\":" << clockToMicroseconds(duration)
+             << ",\"pid\":1,\"tid\":" << buffer->tid
+             << ",\"args\":{\"path\":\"" << escapeJson(pathNames[pathId])
+             << "\"}}";
+    }
+  }
+  stream << "],\"displayTimeUnit\":\"ms\"}";
+  return stream.str();
+}
 
-  return log;
+//==============================================================================
+bool PerformanceLog::writeChromeTrace(const std::string& path)
+{
+  std::ofstream file(path);
+  if (!file.is_open())
+  {
+    std::cout << "PerformanceLog::writeChromeTrace() failed to open \"" << path
+              << "\"" << std::endl;
+    return false;
+  }
+  file << toChromeTrace();
+  return file.good();
 }
 
 //==============================================================================
@@ -240,34 +852,64 @@ void FinalizedPerformanceLog::setChild(
   mChildren[name] = child;
 }
 
+//==============================================================================
+const std::string& FinalizedPerformanceLog::getName() const
+{
+  return mName;
+}
+
 //==============================================================================
 void FinalizedPerformanceLog::registerRun(uint64_t duration)
 {
-  mRuns.push_back(duration);
+  mRuns.record(duration);
+}
+
+//==============================================================================
+void FinalizedPerformanceLog::registerRuns(const PerformanceHistogram& runs)
+{
+  mRuns.merge(runs);
+}
+
+//==============================================================================
+const PerformanceHistogram& FinalizedPerformanceLog::getHistogram() const
+{
+  return mRuns;
 }
 
 //==============================================================================
 int FinalizedPerformanceLog::getNumRuns()
 {
-  return mRuns.size();
+  return mRuns.getCount();
 }
 
 //==============================================================================
 s_t FinalizedPerformanceLog::getMeanRuntime()
 {
-  s_t sum = 0.0;
-  for (uint64_t run : mRuns)
-    sum += run;
-  return sum / mRuns.size();
+  return mRuns.getMean();
 }
 
 //==============================================================================
 uint64_t FinalizedPerformanceLog::getTotalRuntime()
 {
-  uint64_t sum = 0.0;
-  for (uint64_t run : mRuns)
-    sum += run;
-  return sum;
+  return mRuns.getTotal();
+}
+
+//==============================================================================
+uint64_t FinalizedPerformanceLog::getMinRuntime()
+{
+  return mRuns.getMin();
+}
+
+//==============================================================================
+uint64_t FinalizedPerformanceLog::getMaxRuntime()
+{
+  return mRuns.getMax();
+}
+
+//==============================================================================
+s_t FinalizedPerformanceLog::getPercentileRuntime(s_t percentile)
+{
+  return mRuns.getPercentile(percentile);
 }
 
 //==============================================================================
@@ -287,7 +929,7 @@ std::string FinalizedPerformanceLog::prettyPrint()
 std::string FinalizedPerformanceLog::toJson()
 {
   std::stringstream stream;
-  recursivePrettyPrint(0, getTotalRuntime(), static_cast<s_t>(1.0), stream);
+  recursiveToJson(stream);
   return stream.str();
 }
 
@@ -306,7 +948,9 @@ void FinalizedPerformanceLog::recursivePrettyPrint(
       = (static_cast<s_t>(totalCycles) / parentTotalCycles) * parentPercentage;
 
   stream << (percentage * 100) << "%: " << mName << " (" << getNumRuns()
-         << " runs at mean " << getMeanRuntime() << " cycles = " << totalCycles
+         << " runs at mean " << getMeanRuntime() << " cycles, p50 "
+         << getPercentileRuntime(0.5) << ", p99 " << getPercentileRuntime(0.99)
+         << ", max " << getMaxRuntime() << " = " << totalCycles
          << " total)\n";
 
   for (auto pair : mChildren)
@@ -316,5 +960,36 @@ void FinalizedPerformanceLog::recursivePrettyPrint(
   }
 }
 
+//==============================================================================
+/// This writes this node and its children as a JSON object
+void FinalizedPerformanceLog::recursiveToJson(std::stringstream& stream)
+{
+  stream << "{\"name\":\"" << escapeJson(mName)
+         << "\",\"runs\":" << getNumRuns()
+         << ",\"total\":" << getTotalRuntime()
+         << ",\"mean\":" << getMeanRuntime() << ",\"min\":" << getMinRuntime()
+         << ",\"max\":" << getMaxRuntime()
+         << ",\"p50\":" << getPercentileRuntime(0.5)
+         << ",\"p90\":" << getPercentileRuntime(0.9)
+         << ",\"p99\":" << getPercentileRuntime(0.99) << ",\"buckets\":[";
+  const auto& buckets = mRuns.getBuckets();
+  for (int i = 0; i < buckets.size(); i++)
+  {
+    if (i > 0)
+      stream << ",";
+    stream << buckets[i];
+  }
+  stream << "],\"children\":[";
+  bool first = true;
+  for (auto pair : mChildren)
+  {
+    if (!first)
+      stream << ",";
+    first = false;
+    pair.second->recursiveToJson(stream);
+  }
+  stream << "]}";
+}
+
 } // namespace performance
-} // namespace dart
\ No newline at end of file
+} // namespace dart
@@ -1,9 +1,8 @@
 #ifndef DART_PERFORMANCE_LOG_HPP_
 #define DART_PERFORMANCE_LOG_HPP_
 
-#include <deque>
+#include <array>
 #include <memory>
-#include <mutex>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -17,14 +16,58 @@
 namespace dart {
 namespace performance {
 
-class FinalizedPerformanceLog
+/// This is a fixed-size summary of a set of run durations (in clock ticks),
+/// which replaces keeping every run around. Bucket 0 counts runs of 0 ticks,
+/// and bucket b > 0 counts runs in [2^(b-1), 2^b).
+class PerformanceHistogram
 {
 public:
-  /// This will look through the global static lists and recursively construct
-  /// all the FinalizedPerformanceLogs to unify everything.
-  static std::shared_ptr<FinalizedPerformanceLog> recursivelyConstruct(
-      std::vector<int> nameIdStack);
+  static constexpr int kNumBuckets = 65;
+
+  PerformanceHistogram();
+
+  /// This records a single run
+  void record(uint64_t duration);
+
+  /// This adds all the runs recorded by another histogram into this one
+  void merge(const PerformanceHistogram& other);
+
+  void clear();
+
+  uint64_t getCount() const;
+
+  uint64_t getTotal() const;
+
+  /// This returns 0 if there have been no runs
+  uint64_t getMin() const;
+
+  uint64_t getMax() const;
+
+  s_t getMean() const;
+
+  /// This estimates the `percentile` (between 0 and 1) run duration, by
+  /// interpolating within the bucket that holds it. The result is always
+  /// clamped to [getMin(), getMax()].
+  s_t getPercentile(s_t percentile) const;
+
+  const std::array<uint64_t, kNumBuckets>& getBuckets() const;
 
+  /// This returns which bucket a given duration belongs in
+  static int getBucket(uint64_t duration);
+
+protected:
+  friend class PerformanceLog;
+
+  uint64_t mCount;
+  uint64_t mTotal;
+  uint64_t mMin;
+  uint64_t mMax;
+  std::array<uint64_t, kNumBuckets> mBuckets;
+};
+
+class FinalizedPerformanceLog
+{
+public:
   FinalizedPerformanceLog(const std::string& name);
 
   std::shared_ptr<FinalizedPerformanceLog> getChild(const std::string& name);
@@ -32,14 +75,29 @@ public:
   void setChild(
       const std::string& name, std::shared_ptr<FinalizedPerformanceLog> child);
 
+  const std::string& getName() const;
+
   void registerRun(uint64_t duration);
 
+  /// This adds a whole batch of runs, usually from one thread
+  void registerRuns(const PerformanceHistogram& runs);
+
+  const PerformanceHistogram& getHistogram() const;
+
   int getNumRuns();
 
   s_t getMeanRuntime();
 
   uint64_t getTotalRuntime();
 
+  uint64_t getMinRuntime();
+
+  uint64_t getMaxRuntime();
+
+  /// This estimates the `percentile` (between 0 and 1) runtime from the
+  /// histogram
+  s_t getPercentileRuntime(s_t percentile);
+
   /// This will print the results in human readable format, which we can pipe to
   /// a file or to std::out
   std::string prettyPrint();
@@ -52,7 +110,7 @@ protected:
   std::string mName;
   std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
       mChildren;
-  std::vector<uint64_t> mRuns;
+  PerformanceHistogram mRuns;
 
   /// This pretty prints to a stream
   void recursivePrettyPrint(
@@ -60,31 +118,74 @@ protected:
       long parentTotalCycles,
       s_t parentPercentage,
       std::stringstream& stream);
+
+  /// This writes this node and its children as a JSON object
+  void recursiveToJson(std::stringstream& stream);
 };
 
+/// This times nested runs of named sections of code. Usage looks like:
+///
+///   PerformanceLog* log = PerformanceLog::startRoot("optimize");
+///   PerformanceLog* child = log->startRun("step");
+///   ...
+///   child->end();
+///   log->end();
+///
+/// Every thread records into its own buffers, so starting and ending runs
+/// never takes a lock once a thread has seen a given name under a given
+/// parent. Each distinct path of names from a root gets one fixed-size
+/// PerformanceHistogram per thread, so memory doesn't grow with the number of
+/// runs. A bounded ring of the most recent individual runs on each thread is
+/// also kept, which can be exported with toChromeTrace().
+///
+/// A PerformanceLog returned by startRoot() or startRun() stays valid after
+/// end() is called on it, and calling end() twice only records the run once.
+/// Those objects are never freed, so code that gets called more than a handful
+/// of times should start its runs with ScopedPerformanceLog instead, which
+/// hands its PerformanceLog back to be reused once it goes out of scope. Runs
+/// that aren't sampled never allocate anything.
 class PerformanceLog
 {
   friend class FinalizedPerformanceLog;
+  friend class ScopedPerformanceLog;
 
 public:
-  /// Default constructor
-  PerformanceLog(int nameIndex, int parentId);
+  /// The number of most recent runs each thread keeps for toChromeTrace()
+  static constexpr int kTraceEventsPerThread = 1 << 14;
+
+  /// Use startRoot() or startRun() instead
+  PerformanceLog();
 
   /// Disable the copy constructor
-  // PerformanceLog(const PerformanceLog&) = delete;
+  PerformanceLog(const PerformanceLog&) = delete;
 
   /// This returns a new root PerformanceLog instance, which can spawn children
   static PerformanceLog* startRoot(char const* name);
 
-  /// This looks through all the PerformanceLogs in the system and builds a
-  /// report. This is not concerned about efficiency, and we attempt to offload
-  /// as much slowness from elsewhere into here as possible.
+  /// This merges what every thread has recorded so far into a report, with one
+  /// entry for each root name. Runs that haven't been end()'ed yet aren't
+  /// included.
   static std::
       unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
       finalize();
 
-  /// This checks if a given PerformanceLog object matches a stack of nameIds
-  bool matches(std::vector<int> nameIdStack);
+  /// This exports the most recent runs on every thread in the Chrome trace
+  /// event format, which can be loaded in chrome://tracing or Perfetto. Each
+  /// run is a complete ("X") event, with timestamps in microseconds and one
+  /// tid per recording thread.
+  static std::string toChromeTrace();
+
+  /// This writes toChromeTrace() to a file, and returns false if we couldn't
+  static bool writeChromeTrace(const std::string& path);
+
+  /// This sets the fraction of root runs (between 0 and 1) that get timed. A
+  /// root that isn't sampled, and every run started under it, skips reading
+  /// the clock and recording entirely, so a low rate makes logging nearly
+  /// free. The choice is deterministic: a rate of 0.1 times every tenth root on
+  /// each thread. This defaults to 1.
+  static void setSamplingRate(s_t rate);
+
+  static s_t getSamplingRate();
 
   /// This starts a sub-run within this PerformanceLog, giving it a specific
   /// name. After the fact we can use these names to coalesce PerformanceLog
@@ -92,7 +193,7 @@ public:
   PerformanceLog* startRun(char const* name);
 
   /// This terminates the run that we're logging with this PerformanceLog
-  /// object.
+  /// object. Calling this more than once does nothing.
   void end();
 
   /// This needs to be called once at the beginning of execution, and if it's
@@ -100,30 +201,65 @@ public:
   static void initialize();
 
 protected:
-  /// Don't store a whole copy of the name, just a numerical key
-  int mNameIndex;
+  /// This is the interned path of names from the root down to this run
+  int mPathId;
 
   /// This is the clock at the start of our existence
   uint64_t mStartClock;
 
-  /// This is the clock when we called end()
-  uint64_t mEndClock;
+  /// If false, this run (and everything under it) isn't being timed
+  bool mSampled;
+
+  /// This is set once end() is called
+  bool mEnded;
+
+  /// This pulls a recycled PerformanceLog out of this thread's pool, or makes
+  /// a new one
+  static PerformanceLog* start(int pathId, bool sampled);
+
+  /// This hands an ended PerformanceLog back to this thread's pool. Only
+  /// ScopedPerformanceLog calls this, because it's the only owner that knows
+  /// nobody else is still holding on to the log.
+  static void recycle(PerformanceLog* log);
+};
+
+/// This owns a single run. It starts the run when it's constructed, and when
+/// it's destroyed it ends the run and hands its PerformanceLog back to be
+/// reused, so pointers from get() are only valid while this is in scope.
+///
+///   ScopedPerformanceLog step(log, "step");
+///   doWork(step.get());
+class ScopedPerformanceLog
+{
+public:
+  /// This starts a new root run
+  explicit ScopedPerformanceLog(char const* name);
+
+  /// This starts a run under `parent`. If `parent` is nullptr, this doesn't
+  /// time anything and get() returns nullptr.
+  ScopedPerformanceLog(PerformanceLog* parent, char const* name);
+
+  ScopedPerformanceLog(ScopedPerformanceLog&& other);
 
-  /// This is the ID which we'll use to reassemble the graph after the fact
-  int mId;
+  ScopedPerformanceLog(const ScopedPerformanceLog&) = delete;
 
-  /// This is the parent's ID
-  int mParentId;
+  ScopedPerformanceLog& operator=(const ScopedPerformanceLog&) = delete;
 
-  static int mapStringToIndex(const char* str);
+  ~ScopedPerformanceLog();
 
-  static std::unordered_map<std::string, int> globalPerfStringIndex;
-  static std::deque<PerformanceLog*> globalPerfLogsList;
-  static std::unordered_map<int, std::string> globalPerfStringReverseIndex;
-  static std::mutex globalPerfLogListMutex;
+  /// This ends the run early. The log stays valid until this goes out of
+  /// scope.
+  void end();
+
+  PerformanceLog* get() const;
+
+  PerformanceLog* operator->() const;
+
+protected:
+  PerformanceLog* mLog;
 };
 
 } // namespace performance
 } // namespace dart
 
-#endif
\ No newline at end of file
+#endif
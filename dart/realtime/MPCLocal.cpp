@@ -191,17 +191,17 @@ void MPCLocal::optimizePlan(long startTime)
   if (mSolution == nullptr || variableChange())
   {
     PerformanceLog::initialize();
-    PerformanceLog* log = PerformanceLog::startRoot("MPCLocal loop");
+    ScopedPerformanceLog log("MPCLocal loop");
 
     std::shared_ptr<simulation::World> worldClone = mWorld->clone();
-    PerformanceLog* estimateState = log->startRun("Estimate State");
+    ScopedPerformanceLog estimateState(log.get(), "Estimate State");
 
     mBuffer.estimateWorldStateAt(worldClone, &mObservationLog, startTime);
-    estimateState->end();
+    estimateState.end();
     std::cout<<"Optimization Stage"<<std::endl;
     if (!mOptimizer)
     {
-      PerformanceLog* createOpt = log->startRun("Create Default IPOPT");
+      ScopedPerformanceLog createOpt(log.get(), "Create Default IPOPT");
 
       std::shared_ptr<IPOptOptimizer> ipoptOptimizer
           = std::make_shared<IPOptOptimizer>();
@@ -219,7 +219,7 @@ void MPCLocal::optimizePlan(long startTime)
       }
       mOptimizer = ipoptOptimizer;
 
-      createOpt->end();
+      createOpt.end();
     }
 
     if (!mProblem || variableChange())
@@ -231,11 +231,11 @@ void MPCLocal::optimizePlan(long startTime)
       mVarchange = false;
     }
 
-    PerformanceLog* optimizeTrack = log->startRun("Optimize");
+    ScopedPerformanceLog optimizeTrack(log.get(), "Optimize");
     //std::cout<<"MPC Optimization Start"<<std::endl;
     mSolution = mOptimizer->optimize(mProblem.get());
     //std::cout<<"MPC Optimization end"<<std::endl;
-    optimizeTrack->end();
+    optimizeTrack.end();
 
     mLastOptimizedTime = startTime;
 
@@ -244,7 +244,7 @@ void MPCLocal::optimizePlan(long startTime)
         timeSinceEpochMillis(),
         mProblem->getRolloutCache(worldClone)->getControlForcesConst());
 
-    log->end();
+    log.end();
 
     std::cout << PerformanceLog::finalize()["MPCLocal loop"]->prettyPrint()
               << std::endl;
@@ -1,6 +1,8 @@
 #include "dart/server/GUIRecording.hpp"
 
+#include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
@@ -24,17 +26,94 @@ class TrajectoryRollout;
 
 namespace server {
 
+namespace {
+
+// Streamed recordings are laid out as:
+//
+//   header:  "NIMBLREC", uint32 version, uint32 keyframe interval
+//   records: uint32 size, then `size` bytes of CommandList. Keyframe records
+//            have kKeyframeFlag set in their size.
+//   end:     uint32 kEndOfRecords
+//   index:   uint64 offset of every frame record, then uint64 offset of every
+//            keyframe record
+//   trailer: uint64 index offset, uint32 num frames, uint32 num keyframes,
+//            uint32 keyframe interval, uint32 reserved, "NIMBLIDX"
+//
+// Integers are written in native (little-endian) byte order, like
+// writeFramesJson(). Keyframe k recreates the state just before frame
+// k * interval, and is written immediately before that frame's record, so the
+// bytes needed to recreate any frame are a single contiguous range.
+const char kStreamMagic[8] = {'N', 'I', 'M', 'B', 'L', 'R', 'E', 'C'};
+const char kIndexMagic[8] = {'N', 'I', 'M', 'B', 'L', 'I', 'D', 'X'};
+const std::uint32_t kStreamVersion = 1;
+const std::uint32_t kKeyframeFlag = 0x80000000u;
+const std::uint32_t kEndOfRecords = 0xFFFFFFFFu;
+const int kTrailerSize = 32;
+
+struct StreamTrailer
+{
+  std::uint64_t indexOffset;
+  std::uint32_t numFrames;
+  std::uint32_t numKeyframes;
+  std::uint32_t keyframeInterval;
+};
+
+/// This reads the trailer of a streamed recording, returning false if the
+/// file doesn't have one
+bool readStreamTrailer(std::ifstream& file, StreamTrailer& trailer)
+{
+  file.seekg(-kTrailerSize, std::ios::end);
+  char bytes[kTrailerSize];
+  if (!file.read(bytes, kTrailerSize))
+    return false;
+  if (std::memcmp(bytes + 24, kIndexMagic, 8) != 0)
+    return false;
+  std::memcpy(&trailer.indexOffset, bytes, 8);
+  std::memcpy(&trailer.numFrames, bytes + 8, 4);
+  std::memcpy(&trailer.numKeyframes, bytes + 12, 4);
+  std::memcpy(&trailer.keyframeInterval, bytes + 16, 4);
+  return trailer.keyframeInterval > 0;
+}
+
+/// This reads the `i`th uint64 of the index
+std::uint64_t readIndexEntry(
+    std::ifstream& file, const StreamTrailer& trailer, std::uint64_t i)
+{
+  std::uint64_t entry = 0;
+  file.seekg(trailer.indexOffset + 8 * i, std::ios::beg);
+  file.read(reinterpret_cast<char*>(&entry), 8);
+  return entry;
+}
+
+} // namespace
+
 GUIRecording::GUIRecording()
+  : mStreamFile(nullptr),
+    mKeyframeInterval(300),
+    mStreamOffset(0)
 {
 }
 
 GUIRecording::~GUIRecording()
 {
+  finishStreaming();
 }
 
 void GUIRecording::saveFrame()
 {
-  mFrames.push_back(flushJson());
+  if (mStreamFile == nullptr)
+  {
+    mFrames.push_back(flushJson());
+    return;
+  }
+
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+  mFrameOffsets.push_back(writeStreamRecord(flushJson(), false));
+  // The keyframe for the next frame is the state as of the end of this one
+  if (mFrameOffsets.size() % mKeyframeInterval == 0)
+  {
+    writeStreamKeyframe();
+  }
 }
 
 int GUIRecording::getNumFrames()
@@ -42,6 +121,143 @@ int GUIRecording::getNumFrames()
   return mFrames.size();
 }
 
+bool GUIRecording::startStreaming(
+    const std::string& path, int keyframeInterval)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  finishStreaming();
+
+  mStreamFile = fopen(path.c_str(), "wb");
+  if (mStreamFile == nullptr)
+  {
+    std::cout << "ERROR: Could not open \"" << path << "\" for writing"
+              << std::endl;
+    return false;
+  }
+
+  mKeyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+  mFrameOffsets.clear();
+  mKeyframeOffsets.clear();
+
+  const std::uint32_t interval = mKeyframeInterval;
+  fwrite(kStreamMagic, 8, 1, mStreamFile);
+  fwrite(&kStreamVersion, 4, 1, mStreamFile);
+  fwrite(&interval, 4, 1, mStreamFile);
+  mStreamOffset = 16;
+
+  // The first keyframe captures anything that was already in the GUI before
+  // we started streaming
+  writeStreamKeyframe();
+  return true;
+}
+
+void GUIRecording::finishStreaming()
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  if (mStreamFile == nullptr)
+    return;
+
+  fwrite(&kEndOfRecords, 4, 1, mStreamFile);
+  const std::uint64_t indexOffset = mStreamOffset + 4;
+  fwrite(mFrameOffsets.data(), 8, mFrameOffsets.size(), mStreamFile);
+  fwrite(mKeyframeOffsets.data(), 8, mKeyframeOffsets.size(), mStreamFile);
+
+  const std::uint32_t numFrames = mFrameOffsets.size();
+  const std::uint32_t numKeyframes = mKeyframeOffsets.size();
+  const std::uint32_t interval = mKeyframeInterval;
+  const std::uint32_t reserved = 0;
+  fwrite(&indexOffset, 8, 1, mStreamFile);
+  fwrite(&numFrames, 4, 1, mStreamFile);
+  fwrite(&numKeyframes, 4, 1, mStreamFile);
+  fwrite(&interval, 4, 1, mStreamFile);
+  fwrite(&reserved, 4, 1, mStreamFile);
+  fwrite(kIndexMagic, 8, 1, mStreamFile);
+
+  fclose(mStreamFile);
+  mStreamFile = nullptr;
+}
+
+bool GUIRecording::isStreaming()
+{
+  return mStreamFile != nullptr;
+}
+
+int GUIRecording::getNumStreamedFrames()
+{
+  return mFrameOffsets.size();
+}
+
+int GUIRecording::readNumStreamedFrames(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  StreamTrailer trailer;
+  if (!file || !readStreamTrailer(file, trailer))
+    return -1;
+  return trailer.numFrames;
+}
+
+std::string GUIRecording::readStreamedFrameJson(
+    const std::string& path, int frame)
+{
+  std::ifstream file(path, std::ios::binary);
+  StreamTrailer trailer;
+  if (!file || !readStreamTrailer(file, trailer))
+    return "";
+  if (frame < 0 || frame >= (int)trailer.numFrames)
+    return "";
+
+  const std::uint64_t keyframe = frame / trailer.keyframeInterval;
+  if (keyframe >= trailer.numKeyframes)
+    return "";
+  const std::uint64_t start
+      = readIndexEntry(file, trailer, trailer.numFrames + keyframe);
+  const std::uint64_t last = readIndexEntry(file, trailer, frame);
+
+  // Serialized CommandLists concatenate into a single CommandList, so we just
+  // strip the size prefixes off of every record from the keyframe to `frame`
+  std::string result;
+  std::string record;
+  std::uint64_t offset = start;
+  file.seekg(start, std::ios::beg);
+  while (offset <= last)
+  {
+    std::uint32_t size = 0;
+    if (!file.read(reinterpret_cast<char*>(&size), 4) || size == kEndOfRecords)
+      return "";
+    size &= ~kKeyframeFlag;
+    record.resize(size);
+    if (size > 0 && !file.read(&record[0], size))
+      return "";
+    result += record;
+    offset += 4 + size;
+  }
+  return result;
+}
+
+std::uint64_t GUIRecording::writeStreamRecord(
+    const std::string& bytes, bool keyframe)
+{
+  const std::uint64_t offset = mStreamOffset;
+  assert(bytes.size() < kKeyframeFlag);
+  std::uint32_t size = bytes.size();
+  if (keyframe)
+    size |= kKeyframeFlag;
+  fwrite(&size, 4, 1, mStreamFile);
+  fwrite(bytes.c_str(), bytes.size(), 1, mStreamFile);
+  mStreamOffset += 4 + bytes.size();
+  return offset;
+}
+
+void GUIRecording::writeStreamKeyframe()
+{
+  proto::CommandList clear;
+  clear.add_command()->mutable_clear_all()->set_dummy(true);
+  mKeyframeOffsets.push_back(writeStreamRecord(
+      clear.SerializeAsString() + getCurrentStateAsJson(), true));
+}
+
 std::string GUIRecording::getFramesJson(int startFrame)
 {
   std::stringstream stream;
@@ -2,6 +2,8 @@
 #define DART_GUI_RECORDING
 
 #include <condition_variable>
+#include <cstdint>
+#include <cstdio>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -40,10 +42,52 @@ public:
 
   ~GUIRecording();
 
+  /// This saves the commands queued since the last frame as a new frame. If
+  /// we're streaming, the frame goes straight to disk, otherwise it's kept in
+  /// memory.
   void saveFrame();
 
+  /// This returns the number of frames held in memory. Frames that were
+  /// streamed to disk are counted by getNumStreamedFrames().
   int getNumFrames();
 
+  /// This starts streaming every frame saved from now on to the file at
+  /// `path`, rather than keeping it in memory, so long recordings don't grow
+  /// without bound.
+  ///
+  /// The file is a header, then one size-prefixed CommandList per frame with
+  /// only the commands issued during that frame (the same bytes
+  /// getFrameJson() would return). Before every `keyframeInterval` frames we
+  /// also write a keyframe record, which is a ClearAll followed by the full
+  /// state of the GUI. When streaming finishes, we append an index of the byte
+  /// offset of every frame and keyframe, so a reader can recreate any frame
+  /// from its nearest keyframe without reading the rest of the file. See
+  /// readStreamedFrameJson().
+  ///
+  /// Returns false if the file can't be opened.
+  bool startStreaming(const std::string& path, int keyframeInterval = 300);
+
+  /// This writes the seek index and closes the file we're streaming to. This
+  /// is called automatically when the recording is destroyed.
+  void finishStreaming();
+
+  /// This returns true if we're currently streaming frames to disk
+  bool isStreaming();
+
+  /// This returns the number of frames streamed to disk so far
+  int getNumStreamedFrames();
+
+  /// This reads the number of frames in a finished streamed recording, or
+  /// returns -1 if `path` isn't one
+  static int readNumStreamedFrames(const std::string& path);
+
+  /// This reads a CommandList from a finished streamed recording that
+  /// recreates `frame` from scratch: it starts with a ClearAll, then has the
+  /// nearest keyframe at or before `frame`, then the commands of every frame
+  /// from that keyframe up to and including `frame`. Returns "" if `frame` is
+  /// out of bounds or `path` isn't a streamed recording.
+  static std::string readStreamedFrameJson(const std::string& path, int frame);
+
   std::string getFramesJson(int startFrame = 0);
 
   std::string getFrameJson(int frame);
@@ -53,7 +97,24 @@ public:
   void writeFrameJson(const std::string& path, int frame);
 
 protected:
+  /// This writes a size-prefixed record to the file we're streaming to, and
+  /// returns the offset it was written at
+  std::uint64_t writeStreamRecord(const std::string& bytes, bool keyframe);
+
+  /// This writes a keyframe of the current GUI state to the file we're
+  /// streaming to
+  void writeStreamKeyframe();
+
   std::vector<std::string> mFrames;
+
+  FILE* mStreamFile;
+  int mKeyframeInterval;
+  /// The number of bytes written to mStreamFile so far
+  std::uint64_t mStreamOffset;
+  /// The offset of every frame's record, and every keyframe's record, in
+  /// mStreamFile. These become the seek index when streaming finishes.
+  std::vector<std::uint64_t> mFrameOffsets;
+  std::vector<std::uint64_t> mKeyframeOffsets;
 };
 
 } // namespace server
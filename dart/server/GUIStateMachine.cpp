@@ -33,7 +33,8 @@
 namespace dart {
 namespace server {
 
-GUIStateMachine::GUIStateMachine() : mMessagesQueued(0)
+GUIStateMachine::GUIStateMachine()
+  : mMessagesQueued(0), mCoalesceObjectUpdates(false), mChangeTolerance(0)
 {
 }
 
@@ -133,6 +134,8 @@ std::string GUIStateMachine::flushJson()
 {
   const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
 
+  flushObjectUpdates();
+
   mCommandListOutputBuffer.clear();
   mCommandList.SerializeToString(&mCommandListOutputBuffer);
 
@@ -737,6 +740,12 @@ void GUIStateMachine::clear()
     command->mutable_clear_all()->set_dummy(true);
   });
 
+  {
+    const std::lock_guard<std::recursive_mutex> protoLock(mProtoMutex);
+    mObjectUpdates.clear();
+    mObjectsWithPendingUpdates.clear();
+  }
+
   mBoxes.clear();
   mSpheres.clear();
   mCylinders.clear();
@@ -789,6 +798,8 @@ void GUIStateMachine::createBox(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  discardObjectUpdates(key);
+
   Box& box = mBoxes[key];
   box.key = key;
   box.size = size;
@@ -830,6 +841,8 @@ void GUIStateMachine::createSphere(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  discardObjectUpdates(key);
+
   Sphere& sphere = mSpheres[key];
   sphere.key = key;
   sphere.radii = radii;
@@ -858,6 +871,8 @@ void GUIStateMachine::createCone(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  discardObjectUpdates(key);
+
   Cone& cone = mCones[key];
   cone.key = key;
   cone.radius = radius;
@@ -886,6 +901,8 @@ void GUIStateMachine::createCylinder(
     bool castShadows,
     bool receiveShadows)
 {
+  discardObjectUpdates(key);
+
   Cylinder& cylinder = mCylinders[key];
   cylinder.key = key;
   cylinder.radius = radius;
@@ -916,6 +933,8 @@ void GUIStateMachine::createCapsule(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  discardObjectUpdates(key);
+
   Capsule& capsule = mCapsules[key];
   capsule.key = key;
   capsule.radius = radius;
@@ -942,6 +961,8 @@ void GUIStateMachine::createLine(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  discardObjectUpdates(key);
+
   Line& line = mLines[key];
   line.key = key;
   line.points = points;
@@ -985,6 +1006,8 @@ void GUIStateMachine::createMesh(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  discardObjectUpdates(key);
+
   Mesh& mesh = mMeshes[key];
   mesh.key = key;
   mesh.vertices = vertices;
@@ -1022,6 +1045,8 @@ void GUIStateMachine::createMeshASSIMP(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  discardObjectUpdates(key);
+
   std::vector<Eigen::Vector3s> vertices;
   std::vector<Eigen::Vector3s> vertexNormals;
   std::vector<Eigen::Vector3i> faces;
@@ -1296,13 +1321,8 @@ void GUIStateMachine::setObjectPosition(
     mMeshes.at(key).pos = pos;
   }
 
-  queueCommand([&](proto::CommandList& list) {
-    proto::Command* command = list.add_command();
-    command->mutable_set_object_position()->set_key(getStringCode(key));
-    command->mutable_set_object_position()->add_data((double)pos(0));
-    command->mutable_set_object_position()->add_data((double)pos(1));
-    command->mutable_set_object_position()->add_data((double)pos(2));
-  });
+  queueObjectUpdate(
+      key, OBJECT_POSITION, Eigen::Vector4s(pos(0), pos(1), pos(2), 0));
 }
 
 /// This moves an object (e.g. box, sphere, line) to a specified orientation
@@ -1332,13 +1352,8 @@ void GUIStateMachine::setObjectRotation(
     mMeshes.at(key).euler = euler;
   }
 
-  queueCommand([&](proto::CommandList& list) {
-    proto::Command* command = list.add_command();
-    command->mutable_set_object_rotation()->set_key(getStringCode(key));
-    command->mutable_set_object_rotation()->add_data((double)euler(0));
-    command->mutable_set_object_rotation()->add_data((double)euler(1));
-    command->mutable_set_object_rotation()->add_data((double)euler(2));
-  });
+  queueObjectUpdate(
+      key, OBJECT_ROTATION, Eigen::Vector4s(euler(0), euler(1), euler(2), 0));
 }
 
 /// This changes an object (e.g. box, sphere, line) color
@@ -1376,14 +1391,7 @@ void GUIStateMachine::setObjectColor(
     mCones.at(key).color = color;
   }
 
-  queueCommand([&](proto::CommandList& list) {
-    proto::Command* command = list.add_command();
-    command->mutable_set_object_color()->set_key(getStringCode(key));
-    command->mutable_set_object_color()->add_data((double)color(0));
-    command->mutable_set_object_color()->add_data((double)color(1));
-    command->mutable_set_object_color()->add_data((double)color(2));
-    command->mutable_set_object_color()->add_data((double)color(3));
-  });
+  queueObjectUpdate(key, OBJECT_COLOR, color);
 }
 
 /// This changes an object (e.g. box, sphere, mesh) size. Has no effect on
@@ -1421,13 +1429,8 @@ void GUIStateMachine::setObjectScale(
     mCones.at(key).radius = scale(0);
   }
 
-  queueCommand([&](proto::CommandList& list) {
-    proto::Command* command = list.add_command();
-    command->mutable_set_object_scale()->set_key(getStringCode(key));
-    command->mutable_set_object_scale()->add_data((double)scale(0));
-    command->mutable_set_object_scale()->add_data((double)scale(1));
-    command->mutable_set_object_scale()->add_data((double)scale(2));
-  });
+  queueObjectUpdate(
+      key, OBJECT_SCALE, Eigen::Vector4s(scale(0), scale(1), scale(2), 0));
 }
 
 /// This sets a tooltip for the object at key.
@@ -1543,6 +1546,8 @@ void GUIStateMachine::deleteObject(const std::string& key)
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
+  discardObjectUpdates(key);
+
   // We actually want to delete objects even if they don't currently exist,
   // because people may skip frames in the visualizer and we want to properly
   // clean up. if (!hasObject(key))
@@ -2169,6 +2174,39 @@ std::string GUIStateMachine::getCodeString(int code)
   }
 }
 
+/// This turns on holding object updates until the next flush, and only
+/// sending the ones that changed
+void GUIStateMachine::setCoalesceObjectUpdates(bool coalesce)
+{
+  const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
+  if (coalesce == mCoalesceObjectUpdates)
+    return;
+  // Send anything we're holding, in case we're turning coalescing off, and
+  // forget what we last sent, since direct updates don't keep track of it
+  flushObjectUpdates();
+  mObjectUpdates.clear();
+  mCoalesceObjectUpdates = coalesce;
+}
+
+/// This returns whether object updates are coalesced between flushes
+bool GUIStateMachine::getCoalesceObjectUpdates()
+{
+  return mCoalesceObjectUpdates;
+}
+
+/// Updates to objects smaller than this tolerance aren't sent
+void GUIStateMachine::setChangeTolerance(s_t tolerance)
+{
+  const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
+  mChangeTolerance = tolerance;
+}
+
+/// This returns the tolerance set by setChangeTolerance()
+s_t GUIStateMachine::getChangeTolerance()
+{
+  return mChangeTolerance;
+}
+
 void GUIStateMachine::queueCommand(
     std::function<void(proto::CommandList&)> writeCommand)
 {
@@ -2178,6 +2216,116 @@ void GUIStateMachine::queueCommand(
   mMessagesQueued++;
 }
 
+void GUIStateMachine::queueObjectUpdate(
+    const std::string& key, ObjectField field, const Eigen::Vector4s& value)
+{
+  const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
+
+  if (!mCoalesceObjectUpdates)
+  {
+    queueCommand([&](proto::CommandList& list) {
+      encodeObjectUpdate(list, getStringCode(key), field, value);
+    });
+    return;
+  }
+
+  auto it = mObjectUpdates.find(key);
+  if (it == mObjectUpdates.end())
+  {
+    ObjectUpdates updates;
+    updates.code = getStringCode(key);
+    updates.pending = 0;
+    updates.sent = 0;
+    it = mObjectUpdates.emplace(key, updates).first;
+  }
+  ObjectUpdates& updates = it->second;
+  if (updates.pending == 0)
+  {
+    mObjectsWithPendingUpdates.push_back(key);
+    mMessagesQueued++;
+  }
+  updates.pending |= (1 << field);
+  updates.values[field] = value;
+}
+
+void GUIStateMachine::discardObjectUpdates(const std::string& key)
+{
+  const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
+
+  // This leaves `key` in mObjectsWithPendingUpdates, but flushObjectUpdates()
+  // skips keys it can't find
+  mObjectUpdates.erase(key);
+}
+
+void GUIStateMachine::flushObjectUpdates()
+{
+  const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
+
+  for (const std::string& key : mObjectsWithPendingUpdates)
+  {
+    auto it = mObjectUpdates.find(key);
+    if (it == mObjectUpdates.end())
+      continue;
+    ObjectUpdates& updates = it->second;
+
+    for (int field = 0; field < NUM_OBJECT_FIELDS; field++)
+    {
+      const int bit = 1 << field;
+      if ((updates.pending & bit) == 0)
+        continue;
+      const Eigen::Vector4s& value = updates.values[field];
+      if ((updates.sent & bit) != 0
+          && (value - updates.sentValues[field]).cwiseAbs().maxCoeff()
+                 <= mChangeTolerance)
+        continue;
+
+      encodeObjectUpdate(
+          mCommandList, updates.code, (ObjectField)field, value);
+
+      updates.sentValues[field] = value;
+      updates.sent |= bit;
+    }
+    updates.pending = 0;
+  }
+  mObjectsWithPendingUpdates.clear();
+}
+
+void GUIStateMachine::encodeObjectUpdate(
+    proto::CommandList& list,
+    int code,
+    ObjectField field,
+    const Eigen::Vector4s& value)
+{
+  proto::Command* command = list.add_command();
+  google::protobuf::RepeatedField<float>* data = nullptr;
+  int size = 3;
+  if (field == OBJECT_POSITION)
+  {
+    command->mutable_set_object_position()->set_key(code);
+    data = command->mutable_set_object_position()->mutable_data();
+  }
+  else if (field == OBJECT_ROTATION)
+  {
+    command->mutable_set_object_rotation()->set_key(code);
+    data = command->mutable_set_object_rotation()->mutable_data();
+  }
+  else if (field == OBJECT_COLOR)
+  {
+    command->mutable_set_object_color()->set_key(code);
+    data = command->mutable_set_object_color()->mutable_data();
+    size = 4;
+  }
+  else
+  {
+    command->mutable_set_object_scale()->set_key(code);
+    data = command->mutable_set_object_scale()->mutable_data();
+  }
+  for (int i = 0; i < size; i++)
+  {
+    data->Add((double)value(i));
+  }
+}
+
 void GUIStateMachine::encodeSetFramesPerSecond(
     proto::CommandList& list, int framesPerSecond)
 {
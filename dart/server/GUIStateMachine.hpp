@@ -461,6 +461,26 @@ public:
   /// This gets a string code for an integer
   std::string getCodeString(int code);
 
+  /// If this is on, updates to the position, rotation, color or scale of an
+  /// object are held until the next flush, so only the latest value for each
+  /// object is sent, and only if it changed (see setChangeTolerance()). This
+  /// is off by default, so every update goes out in the frame it was made in.
+  /// Only turn it on if the receiver keeps state between frames, like a live
+  /// websocket client, and not for recordings a viewer may seek through.
+  void setCoalesceObjectUpdates(bool coalesce);
+
+  /// This returns whether object updates are coalesced between flushes
+  bool getCoalesceObjectUpdates();
+
+  /// When object updates are coalesced, an update is only sent on flush if
+  /// some component of it differs from the last value we sent by more than
+  /// this tolerance. The default of 0 only skips updates that don't change
+  /// anything.
+  void setChangeTolerance(s_t tolerance);
+
+  /// This returns the tolerance set by setChangeTolerance()
+  s_t getChangeTolerance();
+
 protected:
   // protects the buffered JSON message (mJson) from getting
   // corrupted if we queue messages while trying to flush()
@@ -688,8 +708,56 @@ protected:
   };
   std::unordered_map<std::string, RichPlot> mRichPlots;
 
+  /// The properties of an object whose updates we coalesce between flushes
+  enum ObjectField
+  {
+    OBJECT_POSITION = 0,
+    OBJECT_ROTATION = 1,
+    OBJECT_COLOR = 2,
+    OBJECT_SCALE = 3,
+    NUM_OBJECT_FIELDS = 4
+  };
+
+  /// The coalesced updates for a single object. Every field is stored as a
+  /// Vector4s, with unused trailing components left at zero.
+  struct ObjectUpdates
+  {
+    int code;
+    /// Bitmasks of (1 << ObjectField): fields with an update waiting for the
+    /// next flush, and fields we've sent at least once
+    int pending;
+    int sent;
+    Eigen::Vector4s values[NUM_OBJECT_FIELDS];
+    Eigen::Vector4s sentValues[NUM_OBJECT_FIELDS];
+  };
+  /// These are guarded by mProtoMutex, like mCommandList
+  std::unordered_map<std::string, ObjectUpdates> mObjectUpdates;
+  std::vector<std::string> mObjectsWithPendingUpdates;
+  bool mCoalesceObjectUpdates;
+  s_t mChangeTolerance;
+
   void queueCommand(std::function<void(proto::CommandList&)> writeCommand);
 
+  /// This records an update to an object, to be sent on the next flush. If
+  /// we're not coalescing updates, this queues the command right away.
+  void queueObjectUpdate(
+      const std::string& key, ObjectField field, const Eigen::Vector4s& value);
+
+  /// This drops any updates waiting to be sent for an object, and forgets what
+  /// we last sent for it. We call this when an object is created or deleted,
+  /// so an old update can't be sent after the create or delete command.
+  void discardObjectUpdates(const std::string& key);
+
+  /// This appends the pending object updates that changed by more than
+  /// mChangeTolerance to mCommandList
+  void flushObjectUpdates();
+
+  void encodeObjectUpdate(
+      proto::CommandList& list,
+      int code,
+      ObjectField field,
+      const Eigen::Vector4s& value);
+
   void encodeSetFramesPerSecond(proto::CommandList& list, int framesPerSecond);
   void encodeCreateLayer(proto::CommandList& list, Layer& layer);
   void encodeCreateBox(proto::CommandList& list, Box& box);
@@ -31,8 +31,14 @@ GUIWebsocketServer::GUIWebsocketServer()
   : mPort(-1),
     mServing(false),
     mStartingServer(false),
-    mScreenSize(Eigen::Vector2i(680, 420))
+    mScreenSize(Eigen::Vector2i(680, 420)),
+    mServer(nullptr),
+    mMaxClientBufferBytes(8 * 1024 * 1024),
+    mUseBinaryFrames(false)
 {
+  // Live clients keep the scene between messages, so we only need to send
+  // them the objects that moved
+  setCoalesceObjectUpdates(true);
 }
 
 GUIWebsocketServer::~GUIWebsocketServer()
@@ -73,6 +79,7 @@ void GUIWebsocketServer::serve(int port)
     mStartingServer = true;
   }
   mServer = new WebsocketServer();
+  mServer->setMaxBufferedBytes(mMaxClientBufferBytes);
 
   // Register our network callbacks, ensuring the logic is run on the main
   // thread's event loop
@@ -89,12 +96,13 @@ void GUIWebsocketServer::serve(int port)
       std::string jsonStr = getCurrentStateAsJson();
       try
       {
-        mServer->send(conn, base64_encode(jsonStr));
+        mServer->sendShared(conn, prepareUpdate(std::move(jsonStr)));
       }
       catch (...)
       {
-        dterr << "GUIWebsocketServer caught an error broadcasting message \""
-              << jsonStr << "\"" << std::endl;
+        dterr << "GUIWebsocketServer caught an error sending the current "
+                 "state to a new client"
+              << std::endl;
       }
       // mServer->broadcast("{\"type\": 1}");
       /*
@@ -407,19 +415,92 @@ bool GUIWebsocketServer::isKeyDown(const std::string& key) const
 /// This sends the current list of commands to the web GUI
 void GUIWebsocketServer::flush()
 {
-  if (mServing && mMessagesQueued > 0)
+  // Flushes have to reach each client in order, and resyncing a client has to
+  // happen between two flushes, so only flush from one thread at a time
+  const std::lock_guard<std::mutex> lock(mFlushMutex);
+
+  if (!mServing)
+    return;
+
+  if (mMessagesQueued > 0)
   {
     std::string json = flushJson();
-    try
+    // Every queued object update may have been within the change tolerance
+    if (!json.empty())
     {
-      mServer->broadcast(base64_encode(json));
+      const size_t numBytes = json.size();
+      try
+      {
+        // Frame the update once, and queue the same bytes for every client
+        mServer->broadcastShared(prepareUpdate(std::move(json)));
+      }
+      catch (...)
+      {
+        dterr << "GUIWebsocketServer caught an error broadcasting a "
+              << numBytes << " byte update" << std::endl;
+      }
     }
-    catch (...)
+  }
+
+  resyncLaggingClients();
+}
+
+/// This sets how many bytes of updates can be waiting to go out to a client
+/// before we start dropping updates for it
+void GUIWebsocketServer::setMaxClientBufferBytes(size_t bytes)
+{
+  mMaxClientBufferBytes = bytes;
+  if (mServer != nullptr)
+  {
+    mServer->setMaxBufferedBytes(bytes);
+  }
+}
+
+/// This sets whether updates go out as raw binary frames, or as base64 encoded
+/// text frames
+void GUIWebsocketServer::setUseBinaryFrames(bool binary)
+{
+  mUseBinaryFrames = binary;
+}
+
+/// This frames a serialized CommandList the way the web GUI expects it
+SharedMessage GUIWebsocketServer::prepareUpdate(std::string update)
+{
+  if (mUseBinaryFrames)
+  {
+    return WebsocketServer::prepareBinaryMessage(std::move(update));
+  }
+  return WebsocketServer::prepareTextMessage(base64_encode(update));
+}
+
+/// This sends a fresh copy of the whole GUI state to any clients that dropped
+/// updates, once they've caught up on what was already queued for them
+void GUIWebsocketServer::resyncLaggingClients()
+{
+  std::vector<ClientConnection> clients = mServer->takeClientsToResync();
+  if (clients.empty())
+    return;
+
+  std::string state;
+  {
+    const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+    proto::CommandList clear;
+    clear.add_command()->mutable_clear_all()->set_dummy(true);
+    state = clear.SerializeAsString() + getCurrentStateAsJson();
+  }
+  try
+  {
+    SharedMessage message = prepareUpdate(std::move(state));
+    for (ClientConnection conn : clients)
     {
-      dterr << "GUIWebsocketServer caught an error broadcasting message \""
-            << json << "\"" << std::endl;
+      mServer->sendShared(conn, message);
     }
   }
+  catch (...)
+  {
+    dterr << "GUIWebsocketServer caught an error resyncing "
+          << clients.size() << " lagging clients" << std::endl;
+  }
 }
 
 /// This completely resets the web GUI, deleting all objects, UI elements, and
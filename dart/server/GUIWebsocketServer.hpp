@@ -85,9 +85,24 @@ public:
   /// Returns true if a key is currently being pressed
   bool isKeyDown(const std::string& key) const;
 
-  /// This sends the current list of commands to the web GUI
+  /// This sends the current list of commands to the web GUI. The update is
+  /// serialized and framed once, and the same buffer is queued for every
+  /// client.
   void flush();
 
+  /// By default, updates go out as base64 encoded text frames, which is what
+  /// the prebuilt web GUI bundle understands. Setting this to true sends them
+  /// as binary frames instead, which skips the encoding and makes each update
+  /// a quarter smaller, but needs a web GUI built from the current
+  /// javascript/ sources. Set this before calling serve().
+  void setUseBinaryFrames(bool binary);
+
+  /// This sets how many bytes of updates can be waiting to go out to a single
+  /// client before we start dropping updates for it, instead of letting its
+  /// queue grow without bound. A client that dropped updates gets sent the
+  /// whole GUI state again once it catches up. The default is 8MB.
+  void setMaxClientBufferBytes(size_t bytes);
+
   /// This completely resets the web GUI, deleting all objects, UI elements, and
   /// listeners
   void clear() override;
@@ -114,6 +129,13 @@ public:
       std::function<void(Eigen::Vector2i)> listener);
 
 protected:
+  /// This sends a fresh copy of the whole GUI state to any clients that dropped
+  /// updates, once they've caught up on what was already queued for them
+  void resyncLaggingClients();
+
+  /// This frames a serialized CommandList the way the web GUI expects it
+  SharedMessage prepareUpdate(std::string update);
+
   int mPort;
   bool mServing;
   bool mStartingServer;
@@ -124,6 +146,9 @@ protected:
   WebsocketServer* mServer;
   std::mutex mServingMutex;
   std::condition_variable mServingConditionValue;
+  std::mutex mFlushMutex;
+  size_t mMaxClientBufferBytes;
+  bool mUseBinaryFrames;
 
   // Listeners
   std::vector<std::function<void()>> mConnectionListeners;
@@ -29,7 +29,8 @@ string WebsocketServer::stringifyJson(const Json::Value& val)
   return Json::writeString(wbuilder, val);
 }
 
-WebsocketServer::WebsocketServer() : mRunning(false)
+WebsocketServer::WebsocketServer()
+  : mRunning(false), maxBufferedBytes(8 * 1024 * 1024)
 {
   // Wire up our event handlers
   this->endpoint.set_open_handler(
@@ -174,6 +175,120 @@ void WebsocketServer::broadcast(const string& message)
   }
 }
 
+SharedMessage WebsocketServer::prepareBinaryMessage(string payload)
+{
+  return prepareMessage(std::move(payload), websocketpp::frame::opcode::binary);
+}
+
+SharedMessage WebsocketServer::prepareTextMessage(string payload)
+{
+  return prepareMessage(std::move(payload), websocketpp::frame::opcode::text);
+}
+
+SharedMessage WebsocketServer::prepareMessage(
+    string payload, websocketpp::frame::opcode::value opcode)
+{
+  // Server to client frames are never masked, so the framed bytes are the same
+  // for every client, and we can write the header ourselves instead of having
+  // each connection's protocol processor copy the payload into its own frame
+  SharedMessage msg = std::make_shared<websocketpp::config::asio::message_type>(
+      nullptr, opcode, 0);
+  websocketpp::frame::basic_header header(opcode, payload.size(), true, false);
+  websocketpp::frame::extended_header extendedHeader(payload.size());
+  msg->set_header(websocketpp::frame::prepare_header(header, extendedHeader));
+  msg->get_raw_payload() = std::move(payload);
+  msg->set_prepared(true);
+  return msg;
+}
+
+void WebsocketServer::sendShared(
+    ClientConnection conn, const SharedMessage& message)
+{
+  try
+  {
+    websocketpp::lib::error_code error;
+    this->endpoint.send(conn, message, error);
+  }
+  catch (websocketpp::exception const& e)
+  {
+    dterr << e.what() << std::endl;
+    dterr << "Exception thrown from endpoint.send(). Continuing." << std::endl;
+  }
+  catch (...)
+  {
+    dterr << "Hit unknown error in endpoint.send(). Continuing." << std::endl;
+  }
+}
+
+void WebsocketServer::broadcastShared(const SharedMessage& message)
+{
+  // Prevent concurrent access to the list of open connections from multiple
+  // threads
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  for (auto conn : this->openConnections)
+  {
+    // Once a client has dropped a message, the rest of the stream is useless
+    // to it until it gets resynced, so don't bother queueing anything more
+    if (this->laggingConnections.count(conn)
+        || this->getBufferedBytes(conn) > this->maxBufferedBytes)
+    {
+      this->laggingConnections.insert(conn);
+      continue;
+    }
+    this->sendShared(conn, message);
+  }
+}
+
+void WebsocketServer::setMaxBufferedBytes(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+  this->maxBufferedBytes = bytes;
+}
+
+size_t WebsocketServer::getMaxBufferedBytes()
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+  return this->maxBufferedBytes;
+}
+
+vector<ClientConnection> WebsocketServer::takeClientsToResync()
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  vector<ClientConnection> caughtUp;
+  for (auto it = this->laggingConnections.begin();
+       it != this->laggingConnections.end();)
+  {
+    if (it->expired())
+    {
+      it = this->laggingConnections.erase(it);
+    }
+    else if (this->getBufferedBytes(*it) <= this->maxBufferedBytes / 2)
+    {
+      caughtUp.push_back(*it);
+      it = this->laggingConnections.erase(it);
+    }
+    else
+    {
+      it++;
+    }
+  }
+  return caughtUp;
+}
+
+size_t WebsocketServer::getBufferedBytes(ClientConnection conn)
+{
+  websocketpp::lib::error_code error;
+  WebsocketEndpoint::connection_ptr con
+      = this->endpoint.get_con_from_hdl(conn, error);
+  if (error || con == nullptr)
+  {
+    return 0;
+  }
+  return con->get_buffered_amount();
+}
+
 void WebsocketServer::onOpen(ClientConnection conn)
 {
   {
@@ -225,6 +340,8 @@ void WebsocketServer::onClose(ClientConnection conn)
     // Truncate the connections vector to erase the removed elements
     this->openConnections.resize(
         std::distance(openConnections.begin(), newEnd));
+
+    this->laggingConnections.erase(conn);
   }
 
   // Invoke any registered handlers
@@ -6,7 +6,9 @@
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -19,11 +21,15 @@ using std::vector;
 
 typedef websocketpp::server<websocketpp::config::asio> WebsocketEndpoint;
 typedef websocketpp::connection_hdl ClientConnection;
+// A message that's already been framed, so it can be queued on any number of
+// connections without copying it
+typedef WebsocketEndpoint::message_ptr SharedMessage;
 
 class WebsocketServer
 {
 public:
   WebsocketServer();
+  virtual ~WebsocketServer() = default;
   bool run(int port);
   void stop();
 
@@ -77,6 +83,35 @@ public:
   // Broadcast a raw text message to all clients
   void broadcast(const string& message);
 
+  // Frames `payload` as a single binary websocket message, taking ownership
+  // of it. The result can be passed to sendShared() and broadcastShared() as
+  // many times as you like, and the payload is never copied again.
+  static SharedMessage prepareBinaryMessage(string payload);
+
+  // The same as prepareBinaryMessage(), but frames `payload` as a text message
+  static SharedMessage prepareTextMessage(string payload);
+
+  // Queues an already framed message for a specific client, no matter how
+  // much is already queued for it
+  virtual void sendShared(ClientConnection conn, const SharedMessage& message);
+
+  // Queues an already framed message for every connected client. Clients that
+  // already have more than getMaxBufferedBytes() waiting to go out skip this
+  // message, and are remembered as having dropped messages.
+  void broadcastShared(const SharedMessage& message);
+
+  // Sets how many bytes we let pile up, waiting to be sent to a slow client,
+  // before broadcastShared() starts dropping messages for it
+  void setMaxBufferedBytes(size_t bytes);
+
+  size_t getMaxBufferedBytes();
+
+  // Returns the clients that have dropped broadcastShared() messages, but that
+  // have since caught up to at most half of getMaxBufferedBytes() waiting
+  // to go out. The caller is expected to send them something that resyncs
+  // their state. This forgets that they dropped messages.
+  vector<ClientConnection> takeClientsToResync();
+
 protected:
   static Json::Value parseJson(const string& json);
   static string stringifyJson(const Json::Value& val);
@@ -85,6 +120,13 @@ protected:
   void onClose(ClientConnection conn);
   void onMessage(ClientConnection conn, WebsocketEndpoint::message_ptr msg);
 
+  static SharedMessage prepareMessage(
+      string payload, websocketpp::frame::opcode::value opcode);
+
+  // Returns the number of bytes waiting to be sent to a client, or 0 if the
+  // connection is already gone
+  virtual size_t getBufferedBytes(ClientConnection conn);
+
   bool mRunning;
 
 public:
@@ -94,6 +136,11 @@ protected:
   WebsocketEndpoint endpoint;
   vector<ClientConnection> openConnections;
   std::mutex connectionListMutex;
+  // These are the clients that have dropped broadcastShared() messages, and
+  // are also guarded by connectionListMutex
+  std::set<ClientConnection, std::owner_less<ClientConnection>>
+      laggingConnections;
+  size_t maxBufferedBytes;
   asio::signal_set* mSignalSet;
 
   vector<std::function<void(ClientConnection)>> connectHandlers;
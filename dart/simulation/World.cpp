@@ -46,12 +46,14 @@
 
 #include "dart/collision/CollisionGroup.hpp"
 #include "dart/common/Console.hpp"
+#include "dart/common/WorkStealingPool.hpp"
 #include "dart/constraint/BoxedLcpConstraintSolver.hpp"
 #include "dart/constraint/ConstrainedGroup.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/ClampingFactorizationCache.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
@@ -88,12 +90,16 @@ World::World(const std::string& _name)
     mWrtMass(std::make_shared<neural::WithRespectToMass>()),
     mUseFDOverride(false),
     mSlowDebugResultsAgainstFD(false),
+    mUseVJPBackprop(false),
     mConstraintEngineFn([this](bool _resetCommand) {
       return runLcpConstraintEngine(_resetCommand);
     })
 {
   mIndices.push_back(0);
 
+  mClampingFactorizationCache
+      = std::make_shared<neural::ClampingFactorizationCache>();
+
   auto solver = std::make_unique<constraint::BoxedLcpConstraintSolver>();
   setConstraintSolver(std::move(solver));
 }
@@ -127,6 +133,10 @@ WorldPtr World::clone() const
   // Copy the WithRespectToMass pointer, so we have the same object
   worldClone->mWrtMass = mWrtMass;
 
+  // Share the factorization cache, so parallel clones reuse each other's work
+  worldClone->mClampingFactorizationCache = mClampingFactorizationCache;
+  worldClone->setUseVJPBackprop(mUseVJPBackprop);
+
   auto cd = getConstraintSolver()->getCollisionDetector();
   worldClone->getConstraintSolver()->setCollisionDetector(
       cd->cloneWithoutCollisionObjects());
@@ -398,6 +408,15 @@ std::shared_ptr<neural::WithRespectToMass> World::getWrtMass()
   return mWrtMass;
 }
 
+//==============================================================================
+/// This returns the cache of clamping constraint factorizations that backprop
+/// shares across timesteps
+std::shared_ptr<neural::ClampingFactorizationCache>
+World::getClampingFactorizationCache()
+{
+  return mClampingFactorizationCache;
+}
+
 //==============================================================================
 /// This returns the world state as a JSON blob that we can render
 std::string World::toJson()
@@ -629,6 +648,21 @@ bool World::getSlowDebugResultsAgainstFD()
   return mSlowDebugResultsAgainstFD;
 }
 
+//==============================================================================
+/// If this is true, the BackpropSnapshots we create compute backprop()
+/// directly as vector-Jacobian products, without forming any of the nDofs x
+/// nDofs Jacobians.
+void World::setUseVJPBackprop(bool useVJPs)
+{
+  mUseVJPBackprop = useVJPs;
+}
+
+//==============================================================================
+bool World::getUseVJPBackprop()
+{
+  return mUseVJPBackprop;
+}
+
 void World::DisableWrtMass()
 {
   mWrtMass = nullptr;
@@ -2242,6 +2276,105 @@ Eigen::MatrixXs World::getActionJacobian()
   return actionJac;
 }
 
+//==============================================================================
+Eigen::MatrixXs World::stepBatch(
+    const Eigen::MatrixXs& states,
+    const Eigen::MatrixXs& actions,
+    std::vector<std::shared_ptr<neural::BackpropSnapshot>>* snapshots,
+    int maxThreads)
+{
+  const int numCopies = states.cols();
+  if (states.rows() != getStateSize() || actions.rows() != getActionSize()
+      || actions.cols() != numCopies)
+  {
+    std::cerr << "World::stepBatch() expected a " << getStateSize()
+              << " x N states matrix and a " << getActionSize()
+              << " x N actions matrix, but got " << states.rows() << " x "
+              << states.cols() << " states and " << actions.rows() << " x "
+              << actions.cols() << " actions. Ignoring call." << std::endl;
+    return Eigen::MatrixXs::Zero(getStateSize(), 0);
+  }
+
+  std::shared_ptr<common::WorkStealingPool> pool
+      = common::WorkStealingPool::getCurrentPool();
+  prepareBatchReplicas(pool->getNumSlots(maxThreads));
+
+  if (snapshots != nullptr)
+  {
+    snapshots->clear();
+    snapshots->resize(numCopies);
+  }
+
+  const Eigen::VectorXs lcpCache = getCachedLCPSolution();
+  Eigen::MatrixXs nextStates = Eigen::MatrixXs::Zero(states.rows(), numCopies);
+
+  auto stepCopies = [&](int slot, int begin, int end) {
+    std::shared_ptr<World> replica = mBatchReplicas[slot];
+    for (int i = begin; i < end; i++)
+    {
+      replica->setState(states.col(i));
+      replica->setAction(actions.col(i));
+      replica->setCachedLCPSolution(lcpCache);
+      if (snapshots != nullptr)
+      {
+        (*snapshots)[i] = neural::forwardPass(replica);
+      }
+      else
+      {
+        replica->step();
+      }
+      nextStates.col(i) = replica->getState();
+    }
+  };
+  pool->parallelFor(0, numCopies, 0, stepCopies, maxThreads);
+
+  return nextStates;
+}
+
+//==============================================================================
+void World::clearBatchReplicas()
+{
+  mBatchReplicas.clear();
+}
+
+//==============================================================================
+void World::prepareBatchReplicas(int numReplicas)
+{
+  // Re-clone if our structure has changed since we made the replicas
+  if (!mBatchReplicas.empty()
+      && (mBatchReplicas[0]->getNumSkeletons() != getNumSkeletons()
+          || mBatchReplicas[0]->getNumDofs() != getNumDofs()))
+  {
+    mBatchReplicas.clear();
+  }
+
+  while (mBatchReplicas.size() < numReplicas)
+  {
+    mBatchReplicas.push_back(clone());
+  }
+
+  // Cheap settings that are commonly tweaked between batches
+  for (std::shared_ptr<World>& replica : mBatchReplicas)
+  {
+    replica->setGravity(mGravity);
+    replica->setTimeStep(mTimeStep);
+    replica->setActionSpace(mActionSpace);
+    replica->setFallbackConstraintForceMixingConstant(
+        mFallbackConstraintForceMixingConstant);
+    replica->setContactClippingDepth(mContactClippingDepth);
+    replica->setPenetrationCorrectionEnabled(mPenetrationCorrectionEnabled);
+    replica->setParallelVelocityAndPositionUpdates(
+        mParallelVelocityAndPositionUpdates);
+    for (std::size_t i = 0; i < mSkeletons.size(); ++i)
+    {
+      dynamics::SkeletonPtr skel = replica->getSkeleton(i);
+      skel->setLinkMasses(mSkeletons[i]->getLinkMasses());
+      skel->setLinkCOMs(mSkeletons[i]->getLinkCOMs());
+      skel->setLinkMOIs(mSkeletons[i]->getLinkMOIs());
+    }
+  }
+}
+
 //==============================================================================
 Eigen::MatrixXs World::finiteDifferenceStateJacobian()
 {
@@ -79,6 +79,7 @@ class CollisionResult;
 namespace neural {
 class WithRespectToMass;
 class BackpropSnapshot;
+class ClampingFactorizationCache;
 } // namespace neural
 
 namespace simulation {
@@ -522,6 +523,33 @@ public:
   Eigen::MatrixXs finiteDifferenceStateJacobian();
   Eigen::MatrixXs finiteDifferenceActionJacobian();
 
+  // This steps N independent copies of this world at once. Each column of
+  // `states` (getStateSize() x N) and `actions` (getActionSize() x N) is one
+  // copy, and this returns the next states as a getStateSize() x N matrix.
+  // Each copy starts from this world's cached LCP solution, so results don't
+  // depend on how the copies get spread across threads. This world's own state
+  // is left untouched.
+  //
+  // The copies are stepped on the shared WorkStealingPool, using up to
+  // `maxThreads` pool workers (-1 for all of them) plus the calling thread.
+  // Each thread steps its copies on its own replica of this world, which is
+  // cloned the first time it's needed and kept around for later calls.
+  //
+  // If `snapshots` isn't null, it's filled with one BackpropSnapshot per copy.
+  // Pass this world (not a replica) when using them to compute Jacobians.
+  Eigen::MatrixXs stepBatch(
+      const Eigen::MatrixXs& states,
+      const Eigen::MatrixXs& actions,
+      std::vector<std::shared_ptr<neural::BackpropSnapshot>>* snapshots
+      = nullptr,
+      int maxThreads = -1);
+
+  // stepBatch() keeps its replicas in sync with this world's gravity, time
+  // step, action space and link inertias, but not with structural changes
+  // (like adding skeletons or changing shapes). Call this after changes like
+  // that, to force the replicas to be re-cloned.
+  void clearBatchReplicas();
+
   //--------------------------------------------------------------------------
   // Collision checking
   //--------------------------------------------------------------------------
@@ -676,6 +704,12 @@ public:
   /// the world need gradients through which kinds of mass.
   std::shared_ptr<neural::WithRespectToMass> getWrtMass();
 
+  /// This returns the cache of clamping constraint factorizations that
+  /// backprop shares across timesteps. It's shared with our clones, so its
+  /// hit and miss counters cover every world in a parallel MultiShot.
+  std::shared_ptr<neural::ClampingFactorizationCache>
+  getClampingFactorizationCache();
+
   /// This returns the world state as a JSON blob that we can render
   std::string toJson();
 
@@ -712,6 +746,16 @@ public:
 
   bool getSlowDebugResultsAgainstFD();
 
+  /// If this is true, the BackpropSnapshots we create compute backprop()
+  /// without assembling the step Jacobians or forming Minv, which is faster
+  /// when all you need is the gradient of a loss. Some nDofs x nDofs
+  /// derivative matrices are still formed along the way. See
+  /// BackpropSnapshot::setUseVJPBackprop() for exactly what's saved. The
+  /// gradients match the dense path up to round-off.
+  void setUseVJPBackprop(bool useVJPs);
+
+  bool getUseVJPBackprop();
+
   void DisableWrtMass();
 
 protected:
@@ -726,6 +770,10 @@ protected:
   /// instructions.
   bool mSlowDebugResultsAgainstFD;
 
+  /// If this is true, the BackpropSnapshots we create compute backprop()
+  /// without assembling the step Jacobians
+  bool mUseVJPBackprop;
+
   /// Register when a Skeleton's name is changed
   void handleSkeletonNameChange(
       const dynamics::ConstMetaSkeletonPtr& _skeleton);
@@ -836,6 +884,9 @@ protected:
 
   std::shared_ptr<neural::WithRespectToMass> mWrtMass;
 
+  std::shared_ptr<neural::ClampingFactorizationCache>
+      mClampingFactorizationCache;
+
   //--------------------------------------------------------------------------
   // High-level RL-style API
   //--------------------------------------------------------------------------
@@ -850,6 +901,13 @@ protected:
   Eigen::VectorXs mCachedSnapshotVel;
   Eigen::VectorXs mCachedSnapshotForce;
 
+  /// This makes sure we have at least `numReplicas` replicas for
+  /// stepBatch(), and that they match our current settings
+  void prepareBatchReplicas(int numReplicas);
+
+  /// One clone of this world per thread that stepBatch() uses
+  std::vector<std::shared_ptr<World>> mBatchReplicas;
+
 public:
   //--------------------------------------------------------------------------
   // Slot registers
@@ -33,7 +33,8 @@ IPOptOptimizer::IPOptOptimizer()
     mSuppressOutput(false),
     mSilenceOutput(false),
     mDisableLinesearch(false),
-    mRecordIterations(true)
+    mRecordIterations(true),
+    mUseGaussNewtonHessian(false)
 {
 }
 
@@ -55,8 +56,17 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
       "linear_solver",
       "mumps"); // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
 
+  const bool useHessian = mUseGaussNewtonHessian && shot->hasHessian();
+  if (mUseGaussNewtonHessian && !shot->hasHessian() && !mSilenceOutput)
+  {
+    std::cout << "IPOptOptimizer was asked to use a Gauss-Newton Hessian, but "
+                 "the problem's loss doesn't supply one. Falling back to "
+                 "L-BFGS."
+              << std::endl;
+  }
   app->Options()->SetStringValue(
-      "hessian_approximation", "limited-memory"); // limited-memory, exacty
+      "hessian_approximation",
+      useHessian ? "exact" : "limited-memory"); // limited-memory, exact
 
   /*
   app->Options()->SetStringValue(
@@ -123,7 +133,8 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
       mRecoverBest,
       mRecordFullDebugInfo,
       mSuppressOutput && !mSilenceOutput,
-      mRecordIterations);
+      mRecordIterations,
+      useHessian);
   for (auto& callback : mIntermediateCallbacks)
   {
     problem->registerIntermediateCallback(callback);
@@ -225,5 +236,17 @@ void IPOptOptimizer::setRecordIterations(bool recordIterations)
   mRecordIterations = recordIterations;
 }
 
+//==============================================================================
+void IPOptOptimizer::setUseGaussNewtonHessian(bool useGaussNewtonHessian)
+{
+  mUseGaussNewtonHessian = useGaussNewtonHessian;
+}
+
+//==============================================================================
+bool IPOptOptimizer::getUseGaussNewtonHessian() const
+{
+  return mUseGaussNewtonHessian;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -61,6 +61,16 @@ public:
 
   void setRecordIterations(bool recordIterations);
 
+  /// If this is set, and the Problem's loss supplies second-order terms (see
+  /// LossFn::hasHessian()), we give IPOPT the Gauss-Newton Hessian of the
+  /// loss, with the block-sparse structure from
+  /// Problem::getHessianSparsityStructure(), instead of having it build an
+  /// L-BFGS approximation. Problems whose loss doesn't supply a Hessian still
+  /// use L-BFGS. This defaults to false.
+  void setUseGaussNewtonHessian(bool useGaussNewtonHessian);
+
+  bool getUseGaussNewtonHessian() const;
+
 protected:
   int mIterationLimit;
   s_t mTolerance;
@@ -74,6 +84,7 @@ protected:
   bool mSilenceOutput;
   bool mDisableLinesearch;
   bool mRecordIterations;
+  bool mUseGaussNewtonHessian;
 };
 
 } // namespace trajectory
@@ -33,12 +33,14 @@ IPOptShotWrapper::IPOptShotWrapper(
     bool recoverBest,
     bool recordFullDebugInfo,
     bool printIterations,
-    bool recordIterations)
+    bool recordIterations,
+    bool useHessian)
   : mWrapped(wrapped),
     mRecord(record),
     mRecoverBest(recoverBest),
     mRecordFullDebugInfo(recordFullDebugInfo),
     mRecordIterations(recordIterations),
+    mUseHessian(useHessian),
     mBestIter(-1),
     mBestFeasibleObjectiveValue(std::numeric_limits<double>::infinity()),
     mBestFeasibleState(Eigen::VectorXd::Zero(0)),
@@ -80,8 +82,16 @@ bool IPOptShotWrapper::get_nlp_info(
   // Set the number of entries in the constraint Jacobian
   nnz_jac_g = mWrapped->getNumberNonZeroJacobian(mWrapped->mWorld);
 
-  // Set the number of entries in the Hessian
-  nnz_h_lag = n * n;
+  // Set the number of entries in the Hessian. This is ignored when IPOPT is
+  // building its own limited-memory approximation.
+  if (mUseHessian)
+  {
+    nnz_h_lag = mWrapped->getNumberNonZeroHessian(mWrapped->mWorld);
+  }
+  else
+  {
+    nnz_h_lag = n * n;
+  }
 
   // use the C style indexing (0-based)
   index_style = Ipopt::TNLP::C_STYLE;
@@ -100,11 +110,9 @@ bool IPOptShotWrapper::get_bounds_info(
 {
   PerformanceLog* perflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (mRecord->getPerfLog() != nullptr)
-  {
-    perflog
-        = mRecord->getPerfLog()->startRun("IPOptShotWrapper.get_bound_info");
-  }
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.get_bound_info");
+  perflog = scopedPerflog.get();
 #endif
 
   // here, the n and m we gave IPOPT in get_nlp_info are passed back to us.
@@ -180,11 +188,9 @@ bool IPOptShotWrapper::get_starting_point(
 {
   PerformanceLog* perflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (mRecord->getPerfLog() != nullptr)
-  {
-    perflog = mRecord->getPerfLog()->startRun(
-        "IPOptShotWrapper.get_starting_point");
-  }
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.get_starting_point");
+  perflog = scopedPerflog.get();
 #endif
 
   // If init_x is true, this method must provide an initial value for x.
@@ -249,10 +255,9 @@ bool IPOptShotWrapper::eval_f(
 
   PerformanceLog* perflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (mRecord->getPerfLog() != nullptr)
-  {
-    perflog = mRecord->getPerfLog()->startRun("IPOptShotWrapper.eval_f");
-  }
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.eval_f");
+  perflog = scopedPerflog.get();
 #endif
 
   assert(_n == mWrapped->getFlatProblemDim(mWrapped->mWorld));
@@ -309,10 +314,9 @@ bool IPOptShotWrapper::eval_grad_f(
 
   PerformanceLog* perflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (mRecord->getPerfLog() != nullptr)
-  {
-    perflog = mRecord->getPerfLog()->startRun("IPOptShotWrapper.eval_grad_f");
-  }
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.eval_grad_f");
+  perflog = scopedPerflog.get();
 #endif
 
   assert(_n == mWrapped->getFlatProblemDim(mWrapped->mWorld));
@@ -382,10 +386,9 @@ bool IPOptShotWrapper::eval_g(
 
   PerformanceLog* perflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (mRecord->getPerfLog() != nullptr)
-  {
-    perflog = mRecord->getPerfLog()->startRun("IPOptShotWrapper.eval_g");
-  }
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.eval_g");
+  perflog = scopedPerflog.get();
 #endif
 
   assert(_n == mWrapped->getFlatProblemDim(mWrapped->mWorld));
@@ -459,10 +462,9 @@ bool IPOptShotWrapper::eval_jac_g(
 
   PerformanceLog* perflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (mRecord->getPerfLog() != nullptr)
-  {
-    perflog = mRecord->getPerfLog()->startRun("IPOptShotWrapper.eval_jac_g");
-  }
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.eval_jac_g");
+  perflog = scopedPerflog.get();
 #endif
 
   // If the iRow and jCol arguments are not nullptr, then IPOPT wants you to
@@ -569,36 +571,76 @@ bool IPOptShotWrapper::eval_jac_g(
 
 //==============================================================================
 bool IPOptShotWrapper::eval_h(
-    Ipopt::Index /* _n */,
-    const Ipopt::Number* /* _x */,
-    bool /* _new_x */,
-    Ipopt::Number /* _obj_factor */,
+    Ipopt::Index _n,
+    const Ipopt::Number* _x,
+    bool _new_x,
+    Ipopt::Number _obj_factor,
     Ipopt::Index /* _m */,
     const Ipopt::Number* /* _lambda */,
     bool /* _new_lambda */,
-    Ipopt::Index /* _nele_hess */,
-    Ipopt::Index* /* _iRow */,
-    Ipopt::Index* /* _jCol */,
-    Ipopt::Number* /* _values */)
+    Ipopt::Index _nele_hess,
+    Ipopt::Index* _iRow,
+    Ipopt::Index* _jCol,
+    Ipopt::Number* _values)
 {
-  // TODO(JS): Not implemented yet.
-  std::cout << "[IPOptShotWrapper::eval_h] Not implemented yet.\n";
+  if (!mUseHessian)
+  {
+    // IPOPT only asks for this if it isn't using a limited-memory
+    // approximation, and IPOptOptimizer only turns that off with useHessian
+    std::cout << "[IPOptShotWrapper::eval_h] Called without useHessian.\n";
+    return false;
+  }
 
-  /*
-  return TNLP::eval_h(
-      _n,
-      _x,
-      _new_x,
-      _obj_factor,
-      _m,
-      _lambda,
-      _new_lambda,
-      _nele_hess,
-      _iRow,
-      _jCol,
-      _values);
-      */
-  return false;
+  PerformanceLog* perflog = nullptr;
+#ifdef LOG_PERFORMANCE_IPOPT
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.eval_h");
+  perflog = scopedPerflog.get();
+#endif
+
+  assert(_n == mWrapped->getFlatProblemDim(mWrapped->mWorld));
+  assert(_nele_hess == mWrapped->getNumberNonZeroHessian(mWrapped->mWorld));
+
+  if (nullptr == _values)
+  {
+    // return the structure of the lower triangle of the Hessian
+    Eigen::Map<Eigen::VectorXi> rows(_iRow, _nele_hess);
+    Eigen::Map<Eigen::VectorXi> cols(_jCol, _nele_hess);
+    mWrapped->getHessianSparsityStructure(
+        mWrapped->mWorld, rows, cols, perflog);
+  }
+  else
+  {
+    if (_new_x && _n > 0)
+    {
+      Eigen::Map<const Eigen::VectorXd> flat(_x, _n);
+#ifdef DART_USE_ARBITRARY_PRECISION
+      Eigen::VectorXs flat_s = flat.cast<s_t>();
+      mWrapped->unflatten(mWrapped->mWorld, flat_s, perflog);
+#else
+      mWrapped->unflatten(mWrapped->mWorld, flat, perflog);
+#endif
+    }
+    Eigen::Map<Eigen::VectorXd> sparse(_values, _nele_hess);
+#ifdef DART_USE_ARBITRARY_PRECISION
+    Eigen::VectorXs sparse_s(_nele_hess);
+    mWrapped->getSparseHessian(mWrapped->mWorld, sparse_s, perflog);
+    sparse = sparse_s.cast<double>();
+#else
+    mWrapped->getSparseHessian(mWrapped->mWorld, sparse, perflog);
+#endif
+    // We don't have second-order terms for the constraints, so the Hessian of
+    // the Lagrangian is just the scaled Hessian of the objective
+    sparse *= _obj_factor;
+  }
+
+#ifdef LOG_PERFORMANCE_IPOPT
+  if (perflog != nullptr)
+  {
+    perflog->end();
+  }
+#endif
+  return true;
 }
 
 //==============================================================================
@@ -617,11 +659,9 @@ void IPOptShotWrapper::finalize_solution(
 {
   PerformanceLog* perflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (mRecord->getPerfLog() != nullptr)
-  {
-    perflog
-        = mRecord->getPerfLog()->startRun("IPOptShotWrapper.finalize_solution");
-  }
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.finalize_solution");
+  perflog = scopedPerflog.get();
 #endif
 
   Eigen::Map<const Eigen::VectorXd> flat(_x, _n);
@@ -684,11 +724,9 @@ bool IPOptShotWrapper::intermediate_callback(
 
   PerformanceLog* perflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (mRecord->getPerfLog() != nullptr)
-  {
-    perflog = mRecord->getPerfLog()->startRun(
-        "IPOptShotWrapper.intermediate_callback");
-  }
+  ScopedPerformanceLog scopedPerflog(
+      mRecord->getPerfLog(), "IPOptShotWrapper.intermediate_callback");
+  perflog = scopedPerflog.get();
 #endif
 
   // Always record the iteration
@@ -728,11 +766,9 @@ bool IPOptShotWrapper::intermediate_callback(
 
   PerformanceLog* childPerflog = nullptr;
 #ifdef LOG_PERFORMANCE_IPOPT
-  if (perflog != nullptr)
-  {
-    childPerflog = perflog->startRun(
-        "IPOptShotWrapper.intermediate_callback#callingRegisteredCallbacks");
-  }
+  ScopedPerformanceLog scopedChildPerflog(
+      perflog, "IPOptShotWrapper.intermediate_callback#callingRegisteredCallbacks");
+  childPerflog = scopedChildPerflog.get();
 #endif
 
   bool allCallbacksReturnedTrue = true;
@@ -36,7 +36,8 @@ public:
       bool recoverBest = true,
       bool recordFullDebugInfo = false,
       bool printIterations = false,
-      bool recordIterations = true);
+      bool recordIterations = true,
+      bool useHessian = false);
 
   /// Destructor
   ~IPOptShotWrapper();
@@ -111,6 +112,9 @@ public:
   ///           nullptr)
   ///        2) The values of the hessian of the lagrangian (if "values" is not
   ///           nullptr)
+  ///        This is only called if we were constructed with useHessian, and
+  ///        returns the Gauss-Newton Hessian of the objective from
+  ///        Problem::getSparseHessian(), ignoring the constraint curvature.
   bool eval_h(
       Ipopt::Index _n,
       const Ipopt::Number* _x,
@@ -193,6 +197,7 @@ private:
   bool mRecoverBest;
   bool mRecordFullDebugInfo;
   bool mRecordIterations;
+  bool mUseHessian;
   int mBestIter;
   double mBestFeasibleObjectiveValue;
   Eigen::VectorXd mBestFeasibleState;
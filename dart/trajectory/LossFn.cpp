@@ -2,6 +2,9 @@
 
 #include "dart/utils/tl_optional.hpp"
 
+// Make production builds happy with asserts
+#define _unused(x) ((void)(x))
+
 #define LOG_PERFORMANCE_LOSS_FN
 
 using namespace dart;
@@ -13,6 +16,7 @@ namespace trajectory {
 LossFn::LossFn()
   : mLoss(tl::nullopt),
     mLossAndGrad(tl::nullopt),
+    mLossHessian(tl::nullopt),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
     mUpperBound(std::numeric_limits<s_t>::infinity())
 {
@@ -22,6 +26,7 @@ LossFn::LossFn()
 LossFn::LossFn(TrajectoryLossFn loss)
   : mLoss(loss),
     mLossAndGrad(tl::nullopt),
+    mLossHessian(tl::nullopt),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
     mUpperBound(std::numeric_limits<s_t>::infinity())
 {
@@ -31,6 +36,20 @@ LossFn::LossFn(TrajectoryLossFn loss)
 LossFn::LossFn(TrajectoryLossFn loss, TrajectoryLossFnAndGrad lossAndGrad)
   : mLoss(loss),
     mLossAndGrad(lossAndGrad),
+    mLossHessian(tl::nullopt),
+    mLowerBound(-std::numeric_limits<s_t>::infinity()),
+    mUpperBound(std::numeric_limits<s_t>::infinity())
+{
+}
+
+//==============================================================================
+LossFn::LossFn(
+    TrajectoryLossFn loss,
+    TrajectoryLossFnAndGrad lossAndGrad,
+    TrajectoryLossFnHessian lossHessian)
+  : mLoss(loss),
+    mLossAndGrad(lossAndGrad),
+    mLossHessian(lossHessian),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
     mUpperBound(std::numeric_limits<s_t>::infinity())
 {
@@ -47,10 +66,8 @@ s_t LossFn::getLoss(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_LOSS_FN
-  if (perflog != nullptr)
-  {
-    thisLog = perflog->startRun("LossFn.getLoss");
-  }
+  ScopedPerformanceLog scopedThisLog(perflog, "LossFn.getLoss");
+  thisLog = scopedThisLog.get();
 #endif
 
   s_t loss = 0.0;
@@ -78,10 +95,8 @@ s_t LossFn::getLossAndGradient(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_LOSS_FN
-  if (perflog != nullptr)
-  {
-    thisLog = perflog->startRun("LossFn.getLossAndGradient");
-  }
+  ScopedPerformanceLog scopedThisLog(perflog, "LossFn.getLossAndGradient");
+  thisLog = scopedThisLog.get();
 #endif
 
   s_t loss = 0.0;
@@ -186,6 +201,52 @@ s_t LossFn::getLossAndGradient(
   return loss;
 }
 
+//==============================================================================
+bool LossFn::hasHessian() const
+{
+  return mLossHessian.has_value();
+}
+
+//==============================================================================
+std::vector<Eigen::MatrixXs> LossFn::getLossHessian(
+    const TrajectoryRollout* rollout, PerformanceLog* perflog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_LOSS_FN
+  ScopedPerformanceLog scopedThisLog(perflog, "LossFn.getLossHessian");
+  thisLog = scopedThisLog.get();
+#endif
+
+  int steps = rollout->getPosesConst().cols();
+  int dim = rollout->getPosesConst().rows() + rollout->getVelsConst().rows()
+            + rollout->getControlForcesConst().rows();
+
+  std::vector<Eigen::MatrixXs> hessians;
+  if (mLossHessian)
+  {
+    hessians = mLossHessian.value()(rollout);
+    assert(static_cast<int>(hessians.size()) == steps);
+    for (const Eigen::MatrixXs& hessian : hessians)
+    {
+      assert(hessian.rows() == dim && hessian.cols() == dim);
+      _unused(hessian);
+    }
+  }
+  else
+  {
+    hessians.resize(steps, Eigen::MatrixXs::Zero(dim, dim));
+  }
+
+#ifdef LOG_PERFORMANCE_LOSS_FN
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return hessians;
+}
+
 //==============================================================================
 /// If this LossFn is being used as a constraint, this gets the lower bound
 /// it's allowed to reach
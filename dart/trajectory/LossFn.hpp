@@ -2,6 +2,7 @@
 #define DART_TRAJECTORY_LOSS_FUNCTION_HPP_
 
 #include <memory>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -24,6 +25,16 @@ typedef std::function<s_t(
     /* OUT */ TrajectoryRollout* gradWrtRollout)>
     TrajectoryLossFnAndGrad;
 
+/// This returns the Hessian of the loss with respect to each timestep of the
+/// rollout, as one square matrix per timestep over the concatenation of the
+/// "identity" mapping's (pos, vel, force) at that timestep. Terms coupling
+/// different timesteps, masses, or other mappings aren't representable, and
+/// are treated as 0. For least-squares losses, the Gauss-Newton
+/// approximation (J^T J of the residuals) is a good choice here.
+typedef std::function<std::vector<Eigen::MatrixXs>(
+    const TrajectoryRollout* rollout)>
+    TrajectoryLossFnHessian;
+
 class LossFn
 {
 public:
@@ -33,6 +44,11 @@ public:
 
   LossFn(TrajectoryLossFn loss, TrajectoryLossFnAndGrad lossAndGrad);
 
+  LossFn(
+      TrajectoryLossFn loss,
+      TrajectoryLossFnAndGrad lossAndGrad,
+      TrajectoryLossFnHessian lossHessian);
+
   virtual ~LossFn();
 
   virtual s_t getLoss(
@@ -43,6 +59,18 @@ public:
       /* OUT */ TrajectoryRollout* gradWrtRollout,
       PerformanceLog* perflog = nullptr);
 
+  /// This returns true if this LossFn can supply second-order terms through
+  /// getLossHessian(). By default that's only when a TrajectoryLossFnHessian
+  /// was passed to the constructor, so subclasses that override
+  /// getLossHessian() should override this too.
+  virtual bool hasHessian() const;
+
+  /// This returns the Hessian of the loss with respect to each timestep of the
+  /// rollout, as described in TrajectoryLossFnHessian. If we don't have a
+  /// Hessian, every timestep gets a block of 0s.
+  virtual std::vector<Eigen::MatrixXs> getLossHessian(
+      const TrajectoryRollout* rollout, PerformanceLog* perflog = nullptr);
+
   /// If this LossFn is being used as a constraint, this gets the lower bound
   /// it's allowed to reach
   s_t getLowerBound() const;
@@ -62,6 +90,7 @@ public:
 protected:
   tl::optional<TrajectoryLossFn> mLoss;
   tl::optional<TrajectoryLossFnAndGrad> mLossAndGrad;
+  tl::optional<TrajectoryLossFnHessian> mLossHessian;
   // If this loss function is being used as a constraint, this is the lower
   // bound it's allowed to reach
   s_t mLowerBound;
@@ -1,8 +1,9 @@
 #include "dart/trajectory/MultiShot.hpp"
 
-#include <future>
+#include <algorithm>
 #include <vector>
 
+#include "dart/common/WorkStealingPool.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -64,11 +65,92 @@ void MultiShot::setParallelOperationsEnabled(bool enabled)
     Eigen::initParallel();
 
     mParallelWorlds.clear();
-    for (int i = 0; i < mShots.size(); i++)
+    prepareParallelWorlds(
+        common::WorkStealingPool::getCurrentPool()->getNumSlots());
+  }
+}
+
+//==============================================================================
+/// This splits the shots [firstShot, numShots) into at most `numChunks`
+/// contiguous chunks with roughly equal numbers of timesteps. It returns the
+/// index of the first shot of each chunk, followed by the number of shots.
+std::vector<int> MultiShot::getBalancedShotChunks(
+    int firstShot, int numChunks) const
+{
+  const int numShots = mShots.size();
+  std::vector<int> boundaries;
+  if (firstShot >= numShots)
+  {
+    boundaries.push_back(numShots);
+    return boundaries;
+  }
+  numChunks = std::max(1, std::min(numChunks, numShots - firstShot));
+
+  int totalSteps = 0;
+  for (int i = firstShot; i < numShots; i++)
+  {
+    totalSteps += mShots[i]->getNumSteps();
+  }
+
+  // Start a new chunk as soon as the chunks so far have covered their share of
+  // the timesteps, so a short last shot doesn't get a chunk to itself
+  boundaries.push_back(firstShot);
+  int stepsSoFar = 0;
+  for (int i = firstShot; i < numShots - 1; i++)
+  {
+    stepsSoFar += mShots[i]->getNumSteps();
+    const int chunksStarted = boundaries.size();
+    if (chunksStarted < numChunks
+        && stepsSoFar * numChunks >= totalSteps * chunksStarted)
     {
-      mParallelWorlds.push_back(mWorld->clone());
+      boundaries.push_back(i + 1);
     }
   }
+  boundaries.push_back(numShots);
+  return boundaries;
+}
+
+//==============================================================================
+/// This makes sure we have a world clone for each of `numSlots` pool slots
+void MultiShot::prepareParallelWorlds(int numSlots)
+{
+  while ((int)mParallelWorlds.size() < numSlots)
+  {
+    mParallelWorlds.push_back(mWorld->clone());
+  }
+}
+
+//==============================================================================
+/// This calls `fn(world, shot)` for every shot in [firstShot, numShots) on the
+/// shared pool, where `world` is the clone pinned to whichever slot runs that
+/// shot, and blocks until they've all finished.
+void MultiShot::parallelForShots(
+    int firstShot,
+    const std::function<void(std::shared_ptr<simulation::World>, int)>& fn)
+{
+  std::shared_ptr<common::WorkStealingPool> pool
+      = common::WorkStealingPool::getCurrentPool();
+  prepareParallelWorlds(pool->getNumSlots());
+  // Never hand out more slots than we have worlds for
+  const int maxWorkers = (int)mParallelWorlds.size() - 1;
+
+  // A couple of chunks per slot leaves something to steal if a shot runs long
+  std::vector<int> chunks
+      = getBalancedShotChunks(firstShot, 2 * pool->getNumSlots(maxWorkers));
+  pool->parallelFor(
+      0,
+      chunks.size() - 1,
+      1,
+      [&](int slot, int chunkBegin, int chunkEnd) {
+        for (int chunk = chunkBegin; chunk < chunkEnd; chunk++)
+        {
+          for (int shot = chunks[chunk]; shot < chunks[chunk + 1]; shot++)
+          {
+            fn(mParallelWorlds[slot], shot);
+          }
+        }
+      },
+      maxWorkers);
 }
 
 //==============================================================================
@@ -168,10 +250,8 @@ void MultiShot::computeConstraints(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.computeConstraints");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.computeConstraints");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursor = 0;
@@ -182,23 +262,16 @@ void MultiShot::computeConstraints(
 
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    std::vector<int> cursors(mShots.size(), 0);
     for (int i = 1; i < mShots.size(); i++)
     {
-      futures.push_back(std::async(
-          &MultiShot::asyncPartComputeConstraints,
-          this,
-          i,
-          mParallelWorlds[i],
-          constraints,
-          cursor,
-          thisLog));
+      cursors[i] = cursor;
       cursor += getRepresentationStateSize();
     }
-    for (int i = 0; i < futures.size(); i++)
-    {
-      futures[i].wait();
-    }
+    parallelForShots(1, [&](simulation::WorldPtr shotWorld, int i) {
+      asyncPartComputeConstraints(
+          i, shotWorld, constraints, cursors[i], thisLog);
+    });
   }
   else
   {
@@ -244,10 +317,8 @@ void MultiShot::flatten(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.flatten");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.flatten");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursor = 0;
@@ -276,10 +347,8 @@ void MultiShot::unflatten(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.unflatten");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.unflatten");
+  thisLog = scopedThisLog.get();
 #endif
 
   // Set any static values on the main world that's been passed in
@@ -291,7 +360,19 @@ void MultiShot::unflatten(
       flatDynamic.segment(0, abstractNumDynamic),
       thisLog);
 
-  // Now set the values for all the parallel world objects
+  // Now set the values for all the parallel world objects. Any of them could
+  // end up running any shot, so they all get the static values.
+  if (mParallelOperationsEnabled)
+  {
+    for (std::shared_ptr<simulation::World>& parallelWorld : mParallelWorlds)
+    {
+      Problem::unflatten(
+          parallelWorld,
+          flatStatic.segment(0, abstractNumStatic),
+          flatDynamic.segment(0, abstractNumDynamic),
+          thisLog);
+    }
+  }
   mRolloutCacheDirty = true;
   int cursor = 0;
   for (int i = 0; i < mShots.size(); i++)
@@ -299,10 +380,7 @@ void MultiShot::unflatten(
     std::shared_ptr<SingleShot>& shot = mShots[i];
     int dim = shot->getFlatDynamicProblemDim(world);
     shot->unflatten(
-        mParallelOperationsEnabled ? mParallelWorlds[i] : world,
-        flatStatic,
-        flatDynamic.segment(cursor, dim),
-        thisLog);
+        world, flatStatic, flatDynamic.segment(cursor, dim), thisLog);
     cursor += dim;
   }
 
@@ -325,10 +403,8 @@ void MultiShot::getUpperBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getUpperBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.getUpperBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursor = 0;
@@ -359,10 +435,8 @@ void MultiShot::getLowerBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getLowerBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.getLowerBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursor = 0;
@@ -390,10 +464,8 @@ void MultiShot::getConstraintUpperBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getConstraintUpperBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.getConstraintUpperBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   flat.setZero();
@@ -416,10 +488,8 @@ void MultiShot::getConstraintLowerBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getConstraintLowerBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.getConstraintLowerBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   flat.setZero();
@@ -445,10 +515,8 @@ void MultiShot::getInitialGuess(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getInitialGuess");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.getInitialGuess");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursor = 0;
@@ -480,10 +548,8 @@ void MultiShot::backpropJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.backpropJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.backpropJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   assert(jacStatic.cols() == getFlatStaticProblemDim(world));
@@ -512,23 +578,26 @@ void MultiShot::backpropJacobian(
   int stateDim = getRepresentationStateSize();
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    std::vector<int> rowCursors(mShots.size(), 0);
+    std::vector<int> colCursors(mShots.size(), 0);
     for (int i = 1; i < mShots.size(); i++)
     {
       int dynamicDim = mShots[i - 1]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropJacobian,
-          this,
-          i,
-          mParallelWorlds[i],
-          jacStatic,
-          jacDynamic,
-          rowCursor,
-          colCursor,
-          thisLog));
+      rowCursors[i] = rowCursor;
+      colCursors[i] = colCursor;
       colCursor += dynamicDim;
       rowCursor += stateDim;
     }
+    parallelForShots(1, [&](simulation::WorldPtr shotWorld, int i) {
+      asyncPartBackpropJacobian(
+          i,
+          shotWorld,
+          jacStatic,
+          jacDynamic,
+          rowCursors[i],
+          colCursors[i],
+          thisLog);
+    });
   }
   else
   {
@@ -637,10 +706,9 @@ void MultiShot::getJacobianSparsityStructureStatic(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getJacobianSparsityStructure");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      log, "MultiShot.getJacobianSparsityStructure");
+  thisLog = scopedThisLog.get();
 #endif
 
   int sparseCursor = 0;
@@ -683,10 +751,9 @@ void MultiShot::getJacobianSparsityStructureDynamic(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getJacobianSparsityStructure");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      log, "MultiShot.getJacobianSparsityStructure");
+  thisLog = scopedThisLog.get();
 #endif
 
   int sparseCursor = 0;
@@ -748,10 +815,8 @@ void MultiShot::getSparseJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getSparseJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.getSparseJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursorStatic = Problem::getNumberNonZeroJacobianStatic(world);
@@ -767,30 +832,29 @@ void MultiShot::getSparseJacobian(
 
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    std::vector<int> cursorsStatic(mShots.size(), 0);
+    std::vector<int> cursorsDynamic(mShots.size(), 0);
     for (int i = 1; i < mShots.size(); i++)
     {
       int dimStatic = mShots[i - 1]->getFlatStaticProblemDim(world);
       int dimDynamic = mShots[i - 1]->getFlatDynamicProblemDim(world);
 
-      futures.push_back(std::async(
-          &MultiShot::asyncPartGetSparseJacobian,
-          this,
-          i,
-          mParallelWorlds[i],
-          sparseStatic,
-          sparseDynamic,
-          cursorStatic,
-          cursorDynamic,
-          thisLog));
+      cursorsStatic[i] = cursorStatic;
+      cursorsDynamic[i] = cursorDynamic;
 
       cursorDynamic += (dimDynamic + 1) * stateDim;
       cursorStatic += dimStatic * stateDim;
     }
-    for (int i = 0; i < futures.size(); i++)
-    {
-      futures[i].wait();
-    }
+    parallelForShots(1, [&](simulation::WorldPtr shotWorld, int i) {
+      asyncPartGetSparseJacobian(
+          i,
+          shotWorld,
+          sparseStatic,
+          sparseDynamic,
+          cursorsStatic[i],
+          cursorsDynamic[i],
+          thisLog);
+    });
   }
   else
   {
@@ -907,10 +971,8 @@ void MultiShot::getStates(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getStates");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.getStates");
+  thisLog = scopedThisLog.get();
 #endif
 
   int posDim = world->getNumDofs();
@@ -930,25 +992,21 @@ void MultiShot::getStates(
   {
     if (mParallelOperationsEnabled)
     {
-      std::vector<std::future<void>> futures;
+      std::vector<int> cursors(mShots.size(), 0);
       for (int i = 0; i < mShots.size(); i++)
       {
-        int steps = mShots[i]->getNumSteps();
-        futures.push_back(std::async(
-            &MultiShot::asyncPartGetStates,
-            this,
+        cursors[i] = cursor;
+        cursor += mShots[i]->getNumSteps();
+      }
+      parallelForShots(0, [&](simulation::WorldPtr shotWorld, int i) {
+        asyncPartGetStates(
             i,
-            mParallelWorlds[i],
+            shotWorld,
             rollout,
-            cursor,
-            steps,
-            thisLog));
-        cursor += steps;
-      }
-      for (int i = 0; i < futures.size(); i++)
-      {
-        futures[i].wait();
-      }
+            cursors[i],
+            mShots[i]->getNumSteps(),
+            thisLog);
+      });
     }
     else
     {
@@ -1010,10 +1068,8 @@ void MultiShot::setStates(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.setStates");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.setStates");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursor = 0;
@@ -1039,10 +1095,8 @@ void MultiShot::setControlForcesRaw(Eigen::MatrixXs forces, PerformanceLog* log)
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.setControlForcesRaw");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.setControlForcesRaw");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursor = 0;
@@ -1176,10 +1230,8 @@ Eigen::VectorXs MultiShot::getFinalState(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.getFinalState");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.getFinalState");
+  thisLog = scopedThisLog.get();
 #endif
 
   Eigen::VectorXs ret
@@ -1234,43 +1286,43 @@ void MultiShot::backpropGradientWrt(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_MULTI_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("MultiShot.backpropGradientWrt");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.backpropGradientWrt");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursorDynamicDims = 0;
   int cursorSteps = 0;
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    // Each shot gets its own scratch space for the static gradient, and we sum
+    // them in order afterwards, so the result doesn't depend on scheduling
     Eigen::VectorXs gradStaticScratch
         = Eigen::VectorXs::Zero(gradStatic.size() * mShots.size());
+    std::vector<int> cursorsSteps(mShots.size(), 0);
+    std::vector<int> cursorsDynamicDims(mShots.size(), 0);
     for (int i = 0; i < mShots.size(); i++)
     {
-      int steps = mShots[i]->getNumSteps();
-      int dynamicDim = mShots[i]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropGradientWrt,
-          this,
+      cursorsSteps[i] = cursorSteps;
+      cursorsDynamicDims[i] = cursorDynamicDims;
+      cursorSteps += mShots[i]->getNumSteps();
+      cursorDynamicDims += mShots[i]->getFlatDynamicProblemDim(world);
+    }
+    const int staticDim = gradStatic.size();
+    parallelForShots(0, [&](simulation::WorldPtr shotWorld, int i) {
+      asyncPartBackpropGradientWrt(
           i,
-          mParallelWorlds[i],
+          shotWorld,
           gradWrtRollout,
-          gradStaticScratch.segment(i * gradStatic.size(), gradStatic.size()),
+          gradStaticScratch.segment(i * staticDim, staticDim),
           gradDynamic,
-          cursorDynamicDims,
-          cursorSteps,
-          thisLog));
-      cursorSteps += steps;
-      cursorDynamicDims += dynamicDim;
-    }
+          cursorsDynamicDims[i],
+          cursorsSteps[i],
+          thisLog);
+    });
     gradStatic.setZero();
-    for (int i = 0; i < futures.size(); i++)
+    for (int i = 0; i < mShots.size(); i++)
     {
-      futures[i].wait();
-      gradStatic += gradStaticScratch.segment(
-          i * gradStatic.size(), gradStatic.size());
+      gradStatic += gradStaticScratch.segment(i * staticDim, staticDim);
     }
   }
   else
@@ -1333,5 +1385,67 @@ void MultiShot::asyncPartBackpropGradientWrt(
       log);
 }
 
+//==============================================================================
+std::vector<int> MultiShot::getHessianBlockSizes(
+    std::shared_ptr<simulation::World> world) const
+{
+  std::vector<int> sizes;
+  sizes.reserve(mShots.size());
+  for (const std::shared_ptr<SingleShot>& shot : mShots)
+  {
+    sizes.push_back(shot->getFlatDynamicProblemDim(world));
+  }
+  return sizes;
+}
+
+//==============================================================================
+/// This computes the Hessian block for each shot
+void MultiShot::computeHessianBlocks(
+    std::shared_ptr<simulation::World> world,
+    const std::vector<Eigen::MatrixXs>& hessWrtTimesteps,
+    /* OUT */ std::vector<Eigen::MatrixXs>& blocks,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  ScopedPerformanceLog scopedThisLog(log, "MultiShot.computeHessianBlocks");
+  thisLog = scopedThisLog.get();
+#endif
+
+  blocks.resize(mShots.size());
+  std::vector<int> cursorsSteps(mShots.size(), 0);
+  int cursorSteps = 0;
+  for (int i = 0; i < mShots.size(); i++)
+  {
+    int dim = mShots[i]->getFlatDynamicProblemDim(world);
+    blocks[i] = Eigen::MatrixXs::Zero(dim, dim);
+    cursorsSteps[i] = cursorSteps;
+    cursorSteps += mShots[i]->getNumSteps();
+  }
+
+  if (mParallelOperationsEnabled)
+  {
+    parallelForShots(0, [&](simulation::WorldPtr shotWorld, int i) {
+      mShots[i]->computeHessianBlock(
+          shotWorld, hessWrtTimesteps, cursorsSteps[i], blocks[i], thisLog);
+    });
+  }
+  else
+  {
+    for (int i = 0; i < mShots.size(); i++)
+    {
+      mShots[i]->computeHessianBlock(
+          world, hessWrtTimesteps, cursorsSteps[i], blocks[i], thisLog);
+    }
+  }
+
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef DART_NEURAL_MULTI_SHOT_HPP_
 #define DART_NEURAL_MULTI_SHOT_HPP_
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -37,6 +38,10 @@ public:
   /// If TRUE, this will use multiple independent threads to compute each
   /// SingleShot's values internally. Currently defaults to FALSE. This should
   /// be considered EXPERIMENTAL! Expect bugs.
+  ///
+  /// Shots run on the shared common::WorkStealingPool, in chunks of roughly
+  /// equal numbers of timesteps, and each pool slot gets its own clone of the
+  /// world that it keeps across calls.
   void setParallelOperationsEnabled(bool enabled);
 
   /// This adds a mapping through which the loss function can interpret the
@@ -278,8 +283,39 @@ public:
   // For Testing
   //////////////////////////////////////////////////////////////////////////////
 
+  /// This splits the shots [firstShot, numShots) into at most `numChunks`
+  /// contiguous chunks with roughly equal numbers of timesteps. It returns the
+  /// index of the first shot of each chunk, followed by the number of shots.
+  std::vector<int> getBalancedShotChunks(int firstShot, int numChunks) const;
+
+protected:
+  /// Each shot only depends on its own variables (plus the masses, which get
+  /// no second-order terms), so we get one dense block per shot, and the
+  /// Hessian is banded along the trajectory.
+  std::vector<int> getHessianBlockSizes(
+      std::shared_ptr<simulation::World> world) const override;
+
+  /// This computes the Hessian block for each shot, in parallel if parallel
+  /// operations are enabled
+  void computeHessianBlocks(
+      std::shared_ptr<simulation::World> world,
+      const std::vector<Eigen::MatrixXs>& hessWrtTimesteps,
+      /* OUT */ std::vector<Eigen::MatrixXs>& blocks,
+      PerformanceLog* log = nullptr) override;
+
 private:
+  /// This makes sure we have a world clone for each of `numSlots` pool slots
+  void prepareParallelWorlds(int numSlots);
+
+  /// This calls `fn(world, shot)` for every shot in [firstShot, numShots) on
+  /// the shared pool, where `world` is the clone pinned to whichever slot runs
+  /// that shot, and blocks until they've all finished.
+  void parallelForShots(
+      int firstShot,
+      const std::function<void(std::shared_ptr<simulation::World>, int)>& fn);
+
   std::vector<std::shared_ptr<SingleShot>> mShots;
+  /// One clone of the world per WorkStealingPool slot
   std::vector<simulation::WorldPtr> mParallelWorlds;
   int mShotLength;
   bool mParallelOperationsEnabled;
@@ -11,6 +11,9 @@
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/simulation/World.hpp"
 
+// Make production builds happy with asserts
+#define _unused(x) ((void)(x))
+
 #define LOG_PERFORMANCE_PROBLEM
 
 namespace dart {
@@ -167,10 +170,8 @@ void Problem::flatten(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.flatten");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.flatten");
+  thisLog = scopedThisLog.get();
 #endif
 
   flatStatic.segment(0, world->getMassDims()) = world->getMasses();
@@ -211,10 +212,8 @@ void Problem::unflatten(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.unflatten");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.unflatten");
+  thisLog = scopedThisLog.get();
 #endif
 
   world->setMasses(flatStatic.segment(0, world->getMassDims()));
@@ -290,10 +289,8 @@ void Problem::getUpperBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getUpperBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getUpperBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   flatStatic.segment(0, world->getMassDims()) = world->getMassUpperLimits();
@@ -319,10 +316,8 @@ void Problem::getLowerBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getLowerBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getLowerBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   flatStatic.segment(0, world->getMassDims()) = world->getMassLowerLimits();
@@ -348,10 +343,8 @@ void Problem::getInitialGuess(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getInitialGuess");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getInitialGuess");
+  thisLog = scopedThisLog.get();
 #endif
 
   flatStatic.segment(0, world->getMassDims()) = world->getMasses();
@@ -372,10 +365,8 @@ void Problem::getConstraintUpperBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getConstraintUpperBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getConstraintUpperBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   assert(flat.size() == mConstraints.size());
@@ -400,10 +391,8 @@ void Problem::getConstraintLowerBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getConstraintLowerBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getConstraintLowerBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   assert(flat.size() == mConstraints.size());
@@ -459,10 +448,8 @@ void Problem::computeConstraints(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.computeConstraints");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.computeConstraints");
+  thisLog = scopedThisLog.get();
 #endif
 
   assert(constraints.size() == mConstraints.size());
@@ -512,10 +499,8 @@ void Problem::backpropJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.backpropJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.backpropJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   assert(jacStatic.rows() == mConstraints.size());
@@ -605,10 +590,9 @@ void Problem::getJacobianSparsityStructureDynamic(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getJacobianSparsityStructure");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      log, "Problem.getJacobianSparsityStructure");
+  thisLog = scopedThisLog.get();
 #endif
 
   assert(rows.size() == Problem::getNumberNonZeroJacobianDynamic(world));
@@ -644,10 +628,9 @@ void Problem::getJacobianSparsityStructureStatic(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getJacobianSparsityStructure");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      log, "Problem.getJacobianSparsityStructure");
+  thisLog = scopedThisLog.get();
 #endif
 
   assert(rows.size() == Problem::getNumberNonZeroJacobianStatic(world));
@@ -684,10 +667,8 @@ void Problem::getSparseJacobian(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getSparseJacobian");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getSparseJacobian");
+  thisLog = scopedThisLog.get();
 #endif
 
   assert(sparseStatic.size() == Problem::getNumberNonZeroJacobianStatic(world));
@@ -755,10 +736,8 @@ void Problem::backpropGradient(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.backpropGradient");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.backpropGradient");
+  thisLog = scopedThisLog.get();
 #endif
 
   int staticDim = getFlatStaticProblemDim(world);
@@ -809,10 +788,8 @@ s_t Problem::getLoss(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getLoss");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getLoss");
+  thisLog = scopedThisLog.get();
 #endif
 
   s_t val = mLoss.getLoss(getRolloutCache(world, thisLog), thisLog);
@@ -838,10 +815,8 @@ void Problem::initializeStaticGradient(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.initializeStaticGradient");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.initializeStaticGradient");
+  thisLog = scopedThisLog.get();
 #endif
 
   gradStatic.segment(0, world->getMassDims()).setZero();
@@ -865,10 +840,8 @@ void Problem::accumulateStaticGradient(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.accumulateStaticGradient");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.accumulateStaticGradient");
+  thisLog = scopedThisLog.get();
 #endif
 
   gradStatic.segment(0, world->getMassDims()) += thisTimestep.lossWrtMass;
@@ -892,10 +865,9 @@ void Problem::initializeStaticJacobianOfFinalState(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.initializeStaticJacobianOfFinalState");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      log, "Problem.initializeStaticJacobianOfFinalState");
+  thisLog = scopedThisLog.get();
 #endif
 
   jacStatic.setZero();
@@ -920,10 +892,9 @@ void Problem::accumulateStaticJacobianOfFinalState(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.accumulateStaticJacobianOfFinalState");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      log, "Problem.accumulateStaticJacobianOfFinalState");
+  thisLog = scopedThisLog.get();
 #endif
 
   jacStatic.block(
@@ -956,10 +927,8 @@ Eigen::VectorXi Problem::updateWithForces(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.updateWithForces");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.updateWithForces");
+  thisLog = scopedThisLog.get();
 #endif
 
   Eigen::VectorXi mapping = Eigen::VectorXi::Zero(getFlatProblemDim(world));
@@ -1005,10 +974,8 @@ const TrajectoryRollout* Problem::getRolloutCache(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getRolloutCache");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getRolloutCache");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mRolloutCacheDirty)
@@ -1040,10 +1007,8 @@ TrajectoryRollout* Problem::getGradientWrtRolloutCache(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_PROBLEM
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("Problem.getGradientWrtRolloutCache");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getGradientWrtRolloutCache");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mRolloutCacheDirty)
@@ -1157,5 +1122,180 @@ void Problem::finiteDifferenceJacobian(
   unflatten(world, flat, nullptr);
 }
 
+//==============================================================================
+bool Problem::hasHessian() const
+{
+  return mLoss.hasHessian();
+}
+
+//==============================================================================
+/// This gets the number of non-zero entries in the lower triangle of the
+/// Hessian
+int Problem::getNumberNonZeroHessian(std::shared_ptr<simulation::World> world)
+{
+  int sum = 0;
+  for (int size : getHessianBlockSizes(world))
+  {
+    sum += size * (size + 1) / 2;
+  }
+  return sum;
+}
+
+//==============================================================================
+/// This gets the structure of the non-zero entries in the lower triangle of
+/// the Hessian
+void Problem::getHessianSparsityStructure(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXi> rows,
+    Eigen::Ref<Eigen::VectorXi> cols,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_PROBLEM
+  ScopedPerformanceLog scopedThisLog(
+      log, "Problem.getHessianSparsityStructure");
+  thisLog = scopedThisLog.get();
+#endif
+
+  assert(rows.size() == getNumberNonZeroHessian(world));
+  assert(cols.size() == getNumberNonZeroHessian(world));
+
+  // The dynamic variables come after all the static ones
+  int offset = getFlatStaticProblemDim(world);
+  int cursor = 0;
+  for (int size : getHessianBlockSizes(world))
+  {
+    for (int row = 0; row < size; row++)
+    {
+      for (int col = 0; col <= row; col++)
+      {
+        rows(cursor) = offset + row;
+        cols(cursor) = offset + col;
+        cursor++;
+      }
+    }
+    offset += size;
+  }
+  assert(cursor == rows.size());
+
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This writes the lower triangle of the Gauss-Newton Hessian of the loss to
+/// a sparse vector
+void Problem::getSparseHessian(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXs> sparse,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_PROBLEM
+  ScopedPerformanceLog scopedThisLog(log, "Problem.getSparseHessian");
+  thisLog = scopedThisLog.get();
+#endif
+
+  assert(sparse.size() == getNumberNonZeroHessian(world));
+
+  std::vector<Eigen::MatrixXs> hessWrtTimesteps
+      = mLoss.getLossHessian(getRolloutCache(world, thisLog), thisLog);
+  std::vector<Eigen::MatrixXs> blocks;
+  computeHessianBlocks(world, hessWrtTimesteps, blocks, thisLog);
+
+  int cursor = 0;
+  for (const Eigen::MatrixXs& block : blocks)
+  {
+    for (int row = 0; row < block.rows(); row++)
+    {
+      sparse.segment(cursor, row + 1)
+          = block.row(row).head(row + 1).transpose();
+      cursor += row + 1;
+    }
+  }
+  assert(cursor == sparse.size());
+
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This computes the dense version of getSparseHessian()
+void Problem::getHessian(
+    std::shared_ptr<simulation::World> world,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> hess)
+{
+  int dim = getFlatProblemDim(world);
+  assert(hess.rows() == dim && hess.cols() == dim);
+  _unused(dim);
+
+  int nnz = getNumberNonZeroHessian(world);
+  Eigen::VectorXi rows = Eigen::VectorXi::Zero(nnz);
+  Eigen::VectorXi cols = Eigen::VectorXi::Zero(nnz);
+  Eigen::VectorXs sparse = Eigen::VectorXs::Zero(nnz);
+  getHessianSparsityStructure(world, rows, cols);
+  getSparseHessian(world, sparse);
+
+  hess.setZero();
+  for (int i = 0; i < nnz; i++)
+  {
+    hess(rows(i), cols(i)) = sparse(i);
+    hess(cols(i), rows(i)) = sparse(i);
+  }
+}
+
+//==============================================================================
+/// This computes the Hessian of the loss by finite differencing
+/// backpropGradient()
+void Problem::finiteDifferenceHessian(
+    std::shared_ptr<simulation::World> world,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> hess)
+{
+  int dim = getFlatProblemDim(world);
+  assert(hess.rows() == dim && hess.cols() == dim);
+
+  Eigen::VectorXs flat = Eigen::VectorXs::Zero(dim);
+  flatten(world, flat, nullptr);
+
+  const s_t EPS = 1e-6;
+
+  Eigen::VectorXs positiveGrad = Eigen::VectorXs::Zero(dim);
+  Eigen::VectorXs negativeGrad = Eigen::VectorXs::Zero(dim);
+  for (int i = 0; i < dim; i++)
+  {
+    flat(i) += EPS;
+    unflatten(world, flat, nullptr);
+    backpropGradient(world, positiveGrad, nullptr);
+    flat(i) -= EPS;
+
+    flat(i) -= EPS;
+    unflatten(world, flat, nullptr);
+    backpropGradient(world, negativeGrad, nullptr);
+    flat(i) += EPS;
+
+    hess.col(i) = (positiveGrad - negativeGrad) / (2 * EPS);
+  }
+
+  // Reset to original state
+  unflatten(world, flat, nullptr);
+}
+
+//==============================================================================
+/// This returns the sizes of the dense blocks along the diagonal of the
+/// dynamic part of the Hessian
+std::vector<int> Problem::getHessianBlockSizes(
+    std::shared_ptr<simulation::World> world) const
+{
+  return std::vector<int>(1, getFlatDynamicProblemDim(world));
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
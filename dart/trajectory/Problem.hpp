@@ -297,6 +297,36 @@ public:
       std::shared_ptr<simulation::World> world, PerformanceLog* log = nullptr)
       = 0;
 
+  /// This returns true if our loss supplies second-order terms (see
+  /// LossFn::hasHessian()), so we can give the optimizer a Gauss-Newton
+  /// Hessian instead of having it build a quasi-Newton approximation.
+  bool hasHessian() const;
+
+  /// This gets the number of non-zero entries in the lower triangle of the
+  /// Hessian. The Hessian is block diagonal, with one dense block per shot
+  /// over that shot's dynamic variables, so this grows linearly with the
+  /// length of the trajectory.
+  int getNumberNonZeroHessian(std::shared_ptr<simulation::World> world);
+
+  /// This gets the structure of the non-zero entries in the lower triangle of
+  /// the Hessian
+  void getHessianSparsityStructure(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXi> rows,
+      Eigen::Ref<Eigen::VectorXi> cols,
+      PerformanceLog* log = nullptr);
+
+  /// This writes the lower triangle of the Gauss-Newton Hessian of the loss to
+  /// a sparse vector, in the order given by getHessianSparsityStructure(). We
+  /// push the loss's per-timestep Hessian through the first-order sensitivity
+  /// of the rollout to each shot's variables, so second derivatives of the
+  /// dynamics and of the constraints are dropped, and the static (mass)
+  /// variables get no second-order terms.
+  void getSparseHessian(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXs> sparse,
+      PerformanceLog* log = nullptr);
+
   //////////////////////////////////////////////////////////////////////////////
   // For Testing
   //////////////////////////////////////////////////////////////////////////////
@@ -312,6 +342,19 @@ public:
       std::shared_ptr<simulation::World> world,
       /* OUT */ Eigen::Ref<Eigen::VectorXs> grad);
 
+  /// This computes the dense version of getSparseHessian(), which is a
+  /// matrix that's (getFlatProblemDim(), getFlatProblemDim()).
+  void getHessian(
+      std::shared_ptr<simulation::World> world,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> hess);
+
+  /// This computes the Hessian of the loss by finite differencing
+  /// backpropGradient(). This only matches getHessian() when the dynamics are
+  /// linear, since getHessian() drops their second derivatives.
+  void finiteDifferenceHessian(
+      std::shared_ptr<simulation::World> world,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> hess);
+
   /// This computes the Jacobians that relate each timestep to the endpoint of
   /// the trajectory. For a timestep at time t, this will relate quantities like
   /// v_t -> p_end, for example.
@@ -439,6 +482,21 @@ protected:
       PerformanceLog* log = nullptr)
       = 0;
 
+  /// This returns the sizes of the dense blocks along the diagonal of the
+  /// dynamic part of the Hessian, in order. Together they cover the whole flat
+  /// dynamic problem vector.
+  virtual std::vector<int> getHessianBlockSizes(
+      std::shared_ptr<simulation::World> world) const;
+
+  /// This computes each of the dense blocks from getHessianBlockSizes(), given
+  /// the Hessian of the loss wrt each timestep of the rollout.
+  virtual void computeHessianBlocks(
+      std::shared_ptr<simulation::World> world,
+      const std::vector<Eigen::MatrixXs>& hessWrtTimesteps,
+      /* OUT */ std::vector<Eigen::MatrixXs>& blocks,
+      PerformanceLog* log = nullptr)
+      = 0;
+
 protected:
   std::shared_ptr<simulation::World> mWorld;
   LossFn mLoss;
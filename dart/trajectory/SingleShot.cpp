@@ -92,10 +92,8 @@ void SingleShot::flatten(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.flatten");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.flatten");
+  thisLog = scopedThisLog.get();
 #endif
 
   // Run the AbstractShot flattening, and set our cursors forward to ignore
@@ -149,10 +147,8 @@ void SingleShot::unflatten(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.unflatten");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.unflatten");
+  thisLog = scopedThisLog.get();
 #endif
 
   mRolloutCacheDirty = true;
@@ -209,10 +205,8 @@ void SingleShot::getUpperBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.getUpperBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.getUpperBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursorDynamic = Problem::getFlatDynamicProblemDim(world);
@@ -268,10 +262,8 @@ void SingleShot::getLowerBounds(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.getLowerBounds");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.getLowerBounds");
+  thisLog = scopedThisLog.get();
 #endif
 
   int cursorDynamic = Problem::getFlatDynamicProblemDim(world);
@@ -327,10 +319,8 @@ void SingleShot::getInitialGuess(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.getInitialGuess");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.getInitialGuess");
+  thisLog = scopedThisLog.get();
 #endif
 
   flatten(world, flatStatic, flatDynamic, thisLog);
@@ -371,10 +361,9 @@ void SingleShot::backpropJacobianOfFinalState(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.backpropJacobianOfFinalState");
-  }
+  ScopedPerformanceLog scopedThisLog(
+      log, "SingleShot.backpropJacobianOfFinalState");
+  thisLog = scopedThisLog.get();
 #endif
 
   Problem::initializeStaticJacobianOfFinalState(world, jacStatic, thisLog);
@@ -545,10 +534,8 @@ void SingleShot::backpropGradientWrt(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.backpropGradientWrt");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.backpropGradientWrt");
+  thisLog = scopedThisLog.get();
 #endif
 
   Problem::initializeStaticGradient(world, gradStatic, thisLog);
@@ -630,6 +617,117 @@ void SingleShot::backpropGradientWrt(
 #endif
 }
 
+//==============================================================================
+/// This computes our single dense Hessian block, over all our dynamic
+/// variables
+void SingleShot::computeHessianBlocks(
+    std::shared_ptr<simulation::World> world,
+    const std::vector<Eigen::MatrixXs>& hessWrtTimesteps,
+    /* OUT */ std::vector<Eigen::MatrixXs>& blocks,
+    PerformanceLog* log)
+{
+  int dim = getFlatDynamicProblemDim(world);
+  blocks.resize(1);
+  blocks[0] = Eigen::MatrixXs::Zero(dim, dim);
+  computeHessianBlock(world, hessWrtTimesteps, 0, blocks[0], log);
+}
+
+//==============================================================================
+/// This computes the Gauss-Newton Hessian of the loss wrt our dynamic
+/// variables
+void SingleShot::computeHessianBlock(
+    std::shared_ptr<simulation::World> world,
+    const std::vector<Eigen::MatrixXs>& hessWrtTimesteps,
+    int startStep,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> hess,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.computeHessianBlock");
+  thisLog = scopedThisLog.get();
+#endif
+
+  int dofs = world->getNumDofs();
+  int dim = getFlatDynamicProblemDim(world);
+  assert(hess.rows() == dim && hess.cols() == dim);
+  assert(startStep + mSteps <= static_cast<int>(hessWrtTimesteps.size()));
+  hess.setZero();
+
+  std::vector<MappedBackpropSnapshotPtr> snapshots
+      = getSnapshots(world, thisLog);
+
+  // These are the Jacobians of the current (pos, vel, force) wrt our dynamic
+  // variables. Variables for timesteps we haven't reached yet can't have any
+  // effect, so we only ever touch the leftmost columns.
+  Eigen::MatrixXs posSens = Eigen::MatrixXs::Zero(dofs, dim);
+  Eigen::MatrixXs velSens = Eigen::MatrixXs::Zero(dofs, dim);
+  Eigen::MatrixXs stepSens = Eigen::MatrixXs::Zero(3 * dofs, dim);
+
+  int cursorDynamic = 0;
+  if (mTuneStartingState)
+  {
+    posSens.block(0, 0, dofs, dofs).setIdentity();
+    velSens.block(0, dofs, dofs, dofs).setIdentity();
+    cursorDynamic = 2 * dofs;
+  }
+
+  RestorableSnapshot restoreSnapshot(world);
+
+  for (int i = 0; i < mSteps; i++)
+  {
+    MappedBackpropSnapshotPtr ptr = snapshots[i];
+
+    world->setPositions(ptr->getPreStepPosition());
+    world->setVelocities(ptr->getPreStepVelocity());
+    world->setControlForces(ptr->getPreStepTorques());
+    world->setCachedLCPSolution(ptr->getPreStepLCPCache());
+
+    const Eigen::MatrixXs& forceVel
+        = ptr->getControlForceVelJacobian(world, thisLog);
+    const Eigen::MatrixXs& posPos = ptr->getPosPosJacobian(world, thisLog);
+    const Eigen::MatrixXs& posVel = ptr->getPosVelJacobian(world, thisLog);
+    const Eigen::MatrixXs& velPos = ptr->getVelPosJacobian(world, thisLog);
+    const Eigen::MatrixXs& velVel = ptr->getVelVelJacobian(world, thisLog);
+
+    int cols = cursorDynamic + dofs;
+    // p_t+1 = (p_t+1 <- p_t * p_t) + (p_t+1 <- v_t * v_t)
+    Eigen::MatrixXs nextPosSens
+        = posPos * posSens.leftCols(cols) + velPos * velSens.leftCols(cols);
+    // v_t+1 = (v_t+1 <- p_t * p_t) + (v_t+1 <- v_t * v_t)
+    //         + (v_t+1 <- f_t * f_t)
+    Eigen::MatrixXs nextVelSens
+        = posVel * posSens.leftCols(cols) + velVel * velSens.leftCols(cols);
+    nextVelSens.block(0, cursorDynamic, dofs, dofs) += forceVel;
+    posSens.leftCols(cols) = nextPosSens;
+    velSens.leftCols(cols) = nextVelSens;
+
+    // The rollout records the post-step (pos, vel), and the pre-step force
+    stepSens.block(0, 0, dofs, cols) = nextPosSens;
+    stepSens.block(dofs, 0, dofs, cols) = nextVelSens;
+    stepSens.block(2 * dofs, cursorDynamic, dofs, dofs).setIdentity();
+
+    const Eigen::MatrixXs& stepHess = hessWrtTimesteps[startStep + i];
+    assert(stepHess.rows() == 3 * dofs && stepHess.cols() == 3 * dofs);
+    hess.topLeftCorner(cols, cols).noalias()
+        += stepSens.leftCols(cols).transpose() * stepHess
+           * stepSens.leftCols(cols);
+
+    stepSens.block(2 * dofs, cursorDynamic, dofs, dofs).setZero();
+    cursorDynamic += dofs;
+  }
+  assert(cursorDynamic == dim);
+
+  restoreSnapshot.restore();
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 /// This returns the snapshots from a fresh unroll
 std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
@@ -637,20 +735,17 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.getSnapshots");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.getSnapshots");
+  thisLog = scopedThisLog.get();
 #endif
 
   if (mSnapshotsCacheDirty)
   {
     PerformanceLog* refreshLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-    if (thisLog != nullptr)
-    {
-      refreshLog = thisLog->startRun("SingleShot.getSnapshots#refreshCache");
-    }
+    ScopedPerformanceLog scopedRefreshLog(
+        thisLog, "SingleShot.getSnapshots#refreshCache");
+    refreshLog = scopedRefreshLog.get();
 #endif
     RestorableSnapshot snapshot(world);
 
@@ -695,10 +790,8 @@ void SingleShot::getStates(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.getStates");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.getStates");
+  thisLog = scopedThisLog.get();
 #endif
 
   std::vector<MappedBackpropSnapshotPtr> snapshots
@@ -743,10 +836,8 @@ void SingleShot::setStates(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.setStates");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.setStates");
+  thisLog = scopedThisLog.get();
 #endif
 
   mStartPos = rollout->getPosesConst().col(0);
@@ -769,10 +860,8 @@ void SingleShot::setControlForcesRaw(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.setControlForcesRaw");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.setControlForcesRaw");
+  thisLog = scopedThisLog.get();
 #endif
 
   mForces = forces;
@@ -858,10 +947,8 @@ Eigen::VectorXs SingleShot::getFinalState(
 {
   PerformanceLog* thisLog = nullptr;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
-  if (log != nullptr)
-  {
-    thisLog = log->startRun("SingleShot.getFinalState");
-  }
+  ScopedPerformanceLog scopedThisLog(log, "SingleShot.getFinalState");
+  thisLog = scopedThisLog.get();
 #endif
 
   std::vector<MappedBackpropSnapshotPtr> snapshots
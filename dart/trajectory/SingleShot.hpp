@@ -190,6 +190,27 @@ public:
   TimestepJacobians finiteDifferenceStartStateJacobians(
       std::shared_ptr<simulation::World> world, s_t EPS);
 
+protected:
+  /// This computes our single dense Hessian block, over all our dynamic
+  /// variables
+  void computeHessianBlocks(
+      std::shared_ptr<simulation::World> world,
+      const std::vector<Eigen::MatrixXs>& hessWrtTimesteps,
+      /* OUT */ std::vector<Eigen::MatrixXs>& blocks,
+      PerformanceLog* log = nullptr) override;
+
+  /// This computes the Gauss-Newton Hessian of the loss wrt our dynamic
+  /// variables, given the Hessian of the loss wrt each timestep of a rollout
+  /// that this shot starts at `startStep` of. We carry the sensitivity of the
+  /// state to our variables forward through the snapshot Jacobians, and add
+  /// J_t^T * H_t * J_t at each timestep.
+  void computeHessianBlock(
+      std::shared_ptr<simulation::World> world,
+      const std::vector<Eigen::MatrixXs>& hessWrtTimesteps,
+      int startStep,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> hess,
+      PerformanceLog* log = nullptr);
+
 private:
   Eigen::VectorXs mStartPos;
   Eigen::VectorXs mStartVel;
@@ -19,7 +19,7 @@ namespace dart {
 namespace trajectory {
 
 //==============================================================================
-Solution::Solution() : mSuccess(false), mPerfLog(nullptr)
+Solution::Solution() : mSuccess(false)
 {
 }
 
@@ -27,14 +27,15 @@ Solution::Solution() : mSuccess(false), mPerfLog(nullptr)
 /// This returns a reference to the PerformanceLog for this Optimization
 void Solution::startPerfLog()
 {
-  mPerfLog = performance::PerformanceLog::startRoot("IPOptOptimizer.optimize");
+  mPerfLog = std::make_shared<performance::ScopedPerformanceLog>(
+      "IPOptOptimizer.optimize");
 }
 
 //==============================================================================
 /// This returns a reference to the PerformanceLog for this Optimization
 performance::PerformanceLog* Solution::getPerfLog()
 {
-  return mPerfLog;
+  return mPerfLog == nullptr ? nullptr : mPerfLog->get();
 }
 
 //==============================================================================
@@ -128,7 +128,7 @@ public:
 protected:
   bool mSuccess;
   std::vector<OptimizationStep> mSteps;
-  performance::PerformanceLog* mPerfLog;
+  std::shared_ptr<performance::ScopedPerformanceLog> mPerfLog;
   std::vector<Eigen::VectorXs> mXs;
   std::vector<s_t> mLosses;
   std::vector<Eigen::VectorXs> mGradients;
@@ -128,6 +128,9 @@ class DARTRemote {
    */
   trySocket = () => {
     this.socket = new WebSocket(this.url);
+    // The server sends each update as a protobuf CommandList, either base64
+    // encoded in a text frame (the default), or raw in a binary frame
+    this.socket.binaryType = "arraybuffer";
 
     // Connection opened
     this.socket.addEventListener("open", (event) => {
@@ -140,7 +143,8 @@ class DARTRemote {
     // Listen for messages
     this.socket.addEventListener("message", (event) => {
       try {
-        const list: dart.proto.CommandList = dart.proto.CommandList.deserialize(event.data);
+        const bytes = typeof event.data === "string" ? event.data : new Uint8Array(event.data);
+        const list: dart.proto.CommandList = dart.proto.CommandList.deserialize(bytes);
         list.command.forEach(this.handleCommand);
         this.view.render();
       } catch (e) {
@@ -8,6 +8,23 @@ import playSvg from "!!raw-loader!./play.svg";
 import pauseSvg from "!!raw-loader!./pause.svg";
 import warningSvg from "!!raw-loader!./warning.svg";
 
+// Recordings written by GUIRecording.startStreaming() start with "NIMBLREC",
+// which reads as this if we treat the first 4 bytes as a frame size.
+const STREAM_MAGIC_START = 0x424d494e;
+// Records in a streamed recording that are keyframes have this bit set in their size
+const KEYFRAME_FLAG = 0x80000000;
+// This marks the end of the records in a streamed recording, before the seek index
+const END_OF_RECORDS = 0xffffffff;
+// Streamed recordings end with a fixed size trailer that locates the seek index
+const TRAILER_SIZE = 32;
+const INDEX_MAGIC = "NIMBLIDX";
+// When seeking around a streamed recording, we keep this many segments (a keyframe and the frames after it) on either side of the current one
+const MAX_SEGMENTS_KEPT = 8;
+
+function readUint64(view: DataView, offset: number): number {
+  return view.getUint32(offset, true) + view.getUint32(offset + 4, true) * 4294967296;
+}
+
 class WarningSpan {
   standalone: NimbleStandalone;
   warningKey: number;
@@ -96,6 +113,23 @@ class NimbleStandalone {
   rawFrameBytes: Uint8Array[];
   estimatedTotalFrames: number;
 
+  // Recordings written by GUIRecording.startStreaming() only have the changes
+  // for each frame, plus a keyframe (the full state of the GUI) every
+  // keyframeInterval frames. This is 0 for older recordings, where every frame
+  // stands on its own.
+  keyframeInterval: number;
+  rawKeyframeBytes: Map<number, Uint8Array>;
+
+  // If the server supports range requests, we load streamed recordings a
+  // segment (a keyframe and the frames that follow it) at a time, as they're
+  // needed, rather than downloading the whole file.
+  seekableUrl: string | null;
+  seekableSignal: AbortSignal | null;
+  segmentStarts: number[];
+  segmentsEnd: number;
+  loadingSegments: Set<number>;
+  wantedFrame: number;
+
   playing: boolean;
   everPaused: boolean;
   scrubbing: boolean;
@@ -291,6 +325,14 @@ class NimbleStandalone {
 
     this.lastRecordingHash = "";
     this.rawFrameBytes = [];
+    this.keyframeInterval = 0;
+    this.rawKeyframeBytes = new Map();
+    this.seekableUrl = null;
+    this.seekableSignal = null;
+    this.segmentStarts = [];
+    this.segmentsEnd = 0;
+    this.loadingSegments = new Set();
+    this.wantedFrame = 0;
     this.estimatedTotalFrames = 100;
     this.animationKey = 0;
     this.playing = false;
@@ -456,6 +498,11 @@ class NimbleStandalone {
     }
 
     this.rawFrameBytes = [];
+    this.keyframeInterval = 0;
+    this.rawKeyframeBytes = new Map();
+    this.seekableUrl = null;
+    this.seekableSignal = null;
+    this.loadingSegments = new Set();
 
     this.setLoadedProgress(0.0);
 
@@ -463,6 +510,177 @@ class NimbleStandalone {
     this.setLoadingType('loading');
     this.setLoadingProgress(0.0);
 
+    // Compressed recordings can't be loaded piece by piece, so we always stream those
+    const seekable: Promise<boolean> = url.endsWith('gz') ? Promise.resolve(false) : this.loadSeekableIndex(url, abortSignal);
+    seekable.then((isSeekable) => {
+      if (isSeekable) {
+        this.loadSegment(0);
+      }
+      else {
+        this.streamRecording(url, abortSignal);
+      }
+    }).catch((reason) => {
+      console.error(reason);
+      this.setLoadingProgressError();
+    });
+  };
+
+  /**
+   * This tries to load the seek index of a recording written by GUIRecording.startStreaming(), using range requests.
+   *
+   * @returns A promise that resolves to false if the recording isn't one, or the server doesn't support range requests.
+   */
+  loadSeekableIndex = (url: string, abortSignal: AbortSignal): Promise<boolean> => {
+    return fetch(url, {
+      method: 'get',
+      signal: abortSignal,
+      headers: { Range: 'bytes=-' + TRAILER_SIZE }
+    }).then((response) => {
+      // Servers that don't support range requests send the whole file, which we'd rather stream
+      if (response.status !== 206) {
+        if (response.body != null) {
+          response.body.cancel();
+        }
+        return null;
+      }
+      return response.arrayBuffer();
+    }).then((trailerBuffer: ArrayBuffer | null) => {
+      if (trailerBuffer == null || trailerBuffer.byteLength !== TRAILER_SIZE) {
+        return false;
+      }
+      const trailer = new DataView(trailerBuffer);
+      for (let i = 0; i < INDEX_MAGIC.length; i++) {
+        if (trailer.getUint8(24 + i) !== INDEX_MAGIC.charCodeAt(i)) {
+          return false;
+        }
+      }
+      const indexOffset = readUint64(trailer, 0);
+      const numFrames = trailer.getUint32(8, true);
+      const numKeyframes = trailer.getUint32(12, true);
+      const keyframeInterval = trailer.getUint32(16, true);
+      if (numKeyframes == 0 || keyframeInterval == 0) {
+        return false;
+      }
+
+      // We only need the keyframe offsets, which come after the frame offsets in the index
+      const keyframeOffsetsStart = indexOffset + 8 * numFrames;
+      return fetch(url, {
+        method: 'get',
+        signal: abortSignal,
+        headers: { Range: 'bytes=' + keyframeOffsetsStart + '-' + (keyframeOffsetsStart + 8 * numKeyframes - 1) }
+      }).then((response) => {
+        if (response.status !== 206) {
+          return false;
+        }
+        return response.arrayBuffer().then((indexBuffer) => {
+          if (indexBuffer.byteLength !== 8 * numKeyframes) {
+            return false;
+          }
+          const index = new DataView(indexBuffer);
+          this.segmentStarts = [];
+          for (let i = 0; i < numKeyframes; i++) {
+            this.segmentStarts.push(readUint64(index, 8 * i));
+          }
+          // The records end with a 4 byte marker, just before the index
+          this.segmentsEnd = indexOffset - 4;
+          this.keyframeInterval = keyframeInterval;
+          this.rawFrameBytes = new Array(numFrames);
+          this.estimatedTotalFrames = numFrames;
+          this.seekableUrl = url;
+          this.seekableSignal = abortSignal;
+          return true;
+        });
+      });
+    });
+  };
+
+  /**
+   * This loads a segment of a seekable recording (a keyframe, and the frames up to the next keyframe), if we don't already have it.
+   */
+  loadSegment = (segment: number) => {
+    if (this.seekableUrl == null || segment < 0 || segment >= this.segmentStarts.length) {
+      return;
+    }
+    if (this.rawKeyframeBytes.has(segment) || this.loadingSegments.has(segment)) {
+      return;
+    }
+    this.loadingSegments.add(segment);
+
+    const start = this.segmentStarts[segment];
+    const end = segment + 1 < this.segmentStarts.length ? this.segmentStarts[segment + 1] : this.segmentsEnd;
+    fetch(this.seekableUrl, {
+      method: 'get',
+      signal: this.seekableSignal,
+      headers: { Range: 'bytes=' + start + '-' + (end - 1) }
+    }).then((response) => {
+      if (response.status !== 206) {
+        throw new Error("Server stopped honoring range requests, got status " + response.status);
+      }
+      return response.arrayBuffer();
+    }).then((buffer: ArrayBuffer) => {
+      this.loadingSegments.delete(segment);
+
+      // Drop segments far from this one, so long recordings don't fill up memory
+      this.rawKeyframeBytes.forEach((_, loaded) => {
+        if (Math.abs(loaded - segment) > MAX_SEGMENTS_KEPT) {
+          this.rawKeyframeBytes.delete(loaded);
+          const firstFrame = loaded * this.keyframeInterval;
+          for (let i = firstFrame; i < firstFrame + this.keyframeInterval && i < this.rawFrameBytes.length; i++) {
+            delete this.rawFrameBytes[i];
+          }
+        }
+      });
+
+      const bytes = new Uint8Array(buffer);
+      const view = new DataView(buffer);
+      let cursor = 0;
+      let frame = segment * this.keyframeInterval;
+      while (cursor + 4 <= bytes.length) {
+        let size = view.getUint32(cursor, true);
+        cursor += 4;
+        const isKeyframe = size >= KEYFRAME_FLAG;
+        if (isKeyframe) {
+          size -= KEYFRAME_FLAG;
+        }
+        const record = bytes.slice(cursor, cursor + size);
+        cursor += size;
+        if (isKeyframe) {
+          this.rawKeyframeBytes.set(segment, record);
+        }
+        else if (frame < this.rawFrameBytes.length) {
+          this.rawFrameBytes[frame] = record;
+          frame++;
+        }
+      }
+
+      if (segment == 0 && this.lastFrame == -1) {
+        // Clear the loading bar, and show the first frame
+        this.setLoadingProgress(1.0);
+        this.hideLoadingBar();
+        for (const span of this.warningSpans) {
+          span.update();
+        }
+        this.setFrame(0);
+        this.view.view.onWindowResize();
+        this.setLoadedProgress(1.0);
+      }
+      else if (this.wantedFrame != this.lastFrame) {
+        // We were waiting on this segment to show a frame
+        this.setFrame(this.wantedFrame);
+      }
+    }).catch((reason) => {
+      this.loadingSegments.delete(segment);
+      console.error(reason);
+      if (segment == 0) {
+        this.setLoadingProgressError();
+      }
+    });
+  };
+
+  /**
+   * This downloads a whole recording, and plays it back as it arrives.
+   */
+  streamRecording = (url: string, abortSignal: AbortSignal) => {
     fetch(url, {
       method: 'get',
       signal: abortSignal
@@ -485,21 +703,30 @@ class NimbleStandalone {
         let currentFrameCursor: number[] = [0];
         let currentFrameBytes: Uint8Array[] = [new Uint8Array(4)];
         let isSizeFrame: boolean[] = [true];
+        // Streamed recordings (see GUIRecording.startStreaming()) have a header, keyframe records, and an end marker
+        let isFirstRecord: boolean[] = [true];
+        let isStreamedRecording: boolean[] = [false];
+        let recordType: string[] = ['frame'];
+        let reachedEnd: boolean[] = [false];
+
+        const finishLoading = () => {
+          this.estimatedTotalFrames = this.rawFrameBytes.length;
+          // Update the spans now that we know exactly how many frames we have
+          for (const span of this.warningSpans) {
+            span.update();
+          }
+          this.setLoadedProgress(1.0);
+          if (!this.playing && !this.everPaused) {
+            this.togglePlay();
+          }
+        };
 
         const processBytes = ({ done, value }) => {
             // Result objects contain two properties:
             // done  - true if the stream has already given all its data.
             // value - some data. 'undefined' if the reader is canceled.
             if (value == null) {
-              this.estimatedTotalFrames = this.rawFrameBytes.length;
-              // Update the spans now that we know exactly how many frames we have
-              for (const span of this.warningSpans) {
-                span.update();
-              }
-              this.setLoadedProgress(1.0);
-              if (!this.playing && !this.everPaused) {
-                this.togglePlay();
-              }
+              finishLoading();
               return;
             }
 
@@ -518,14 +745,52 @@ class NimbleStandalone {
 
                 if (isSizeFrame[0]) {
                   const u32bytes = currentFrameBytes[0].buffer.slice(0, 4);
-                  const size = new Uint32Array(u32bytes)[0];
-                  if (size == 0) {
-                    break;
+                  let size = new Uint32Array(u32bytes)[0];
+                  if (isFirstRecord[0] && size == STREAM_MAGIC_START) {
+                    // This is a streamed recording, and the rest of its header follows
+                    recordType[0] = 'header';
+                    size = 12;
                   }
+                  else if (isStreamedRecording[0]) {
+                    // Frames with no changes are empty, so we have an explicit end marker
+                    if (size == END_OF_RECORDS) {
+                      reachedEnd[0] = true;
+                      break;
+                    }
+                    recordType[0] = size >= KEYFRAME_FLAG ? 'keyframe' : 'frame';
+                    if (size >= KEYFRAME_FLAG) {
+                      size -= KEYFRAME_FLAG;
+                    }
+                  }
+                  else {
+                    if (size == 0) {
+                      break;
+                    }
+                    recordType[0] = 'frame';
+                  }
+                  isFirstRecord[0] = false;
                   currentFrameBytes[0] = new Uint8Array(size);
                   currentFrameCursor[0] = 0;
                   isSizeFrame[0] = false;
                 }
+                else if (recordType[0] == 'header') {
+                  // The header continues with "LREC", the format version, and the keyframe interval
+                  const header = new DataView(currentFrameBytes[0].buffer);
+                  this.keyframeInterval = header.getUint32(8, true);
+                  isStreamedRecording[0] = true;
+
+                  currentFrameBytes[0] = new Uint8Array(4);
+                  currentFrameCursor[0] = 0;
+                  isSizeFrame[0] = true;
+                }
+                else if (recordType[0] == 'keyframe') {
+                  // Keyframes arrive in order, so the nth one we see is for frame n * keyframeInterval
+                  this.rawKeyframeBytes.set(this.rawKeyframeBytes.size, currentFrameBytes[0]);
+
+                  currentFrameBytes[0] = new Uint8Array(4);
+                  currentFrameCursor[0] = 0;
+                  isSizeFrame[0] = true;
+                }
                 else {
                   this.rawFrameBytes.push(currentFrameBytes[0]);
 
@@ -575,6 +840,13 @@ class NimbleStandalone {
 
             bytesReceived += value.byteLength;
 
+            // Everything after the end marker of a streamed recording is the seek index, which we don't need
+            if (reachedEnd[0]) {
+              reader.cancel();
+              finishLoading();
+              return;
+            }
+
             if (done) {
               this.estimatedTotalFrames = this.rawFrameBytes.length;
               this.setLoadedProgress(1.0);
@@ -607,6 +879,58 @@ class NimbleStandalone {
     return command;
   };
 
+  getRecordingKeyframe: (number) => dart.proto.CommandList = (index: number) => {
+    let command: dart.proto.CommandList = dart.proto.CommandList.deserialize(this.rawKeyframeBytes.get(index));
+    return command;
+  };
+
+  /**
+   * If we have a keyframe every keyframeInterval frames, then we can either
+   * roll forward from the frame we're showing, or we have to start from the
+   * last keyframe at or before the frame we want. This returns the first frame
+   * whose changes we need to apply to show `frameNumber`, or -1 if we need to
+   * start from a keyframe.
+   */
+  getFirstFrameToApply = (frameNumber: number) => {
+    if (this.keyframeInterval == 0) {
+      return frameNumber;
+    }
+    const segmentStart = Math.floor(frameNumber / this.keyframeInterval) * this.keyframeInterval;
+    if (this.lastFrame >= 0 && this.lastFrame < frameNumber && this.lastFrame >= segmentStart - 1) {
+      return this.lastFrame + 1;
+    }
+    return -1;
+  };
+
+  /**
+   * Returns true if we have everything we need to show `frameNumber`
+   */
+  isFrameLoaded = (frameNumber: number) => {
+    if (frameNumber >= this.rawFrameBytes.length || this.rawFrameBytes[frameNumber] == null) {
+      return false;
+    }
+    if (this.getFirstFrameToApply(frameNumber) == -1) {
+      return this.rawKeyframeBytes.has(Math.floor(frameNumber / this.keyframeInterval));
+    }
+    // Frames load a whole segment at a time, or in order, so if we have this frame we have the ones before it
+    return true;
+  };
+
+  /**
+   * This applies the commands to show `frameNumber`, which must be loaded
+   */
+  applyFrame = (frameNumber: number) => {
+    let firstFrame = this.getFirstFrameToApply(frameNumber);
+    if (firstFrame == -1) {
+      const segment = Math.floor(frameNumber / this.keyframeInterval);
+      this.getRecordingKeyframe(segment).command.forEach(this.handleCommand);
+      firstFrame = segment * this.keyframeInterval;
+    }
+    for (let i = firstFrame; i <= frameNumber; i++) {
+      this.getRecordingFrame(i).command.forEach(this.handleCommand);
+    }
+  };
+
   registerPlayPauseListener = (playPausedListener: ((playing: boolean) => void) | null) => {
     this.playPausedListener = playPausedListener;
   };
@@ -680,11 +1004,13 @@ class NimbleStandalone {
 
   setFrame = (frameNumber: number) => {
     if (frameNumber != this.lastFrame) {
+      this.wantedFrame = frameNumber;
       this.warningSpans.forEach((span) => {
         span.updateTimestep(frameNumber);
       });
 
-      if (frameNumber < this.lastFrame) {
+      // Recordings with keyframes jump back to a keyframe on their own, in applyFrame()
+      if (frameNumber < this.lastFrame && this.keyframeInterval == 0) {
         // Reset at the beginning
         this.lastFrame = -1;
         // Deliberately skip the first frame when looping back, for efficiency. The first frame usually has a bunch of creation of meshes and stuff, which is expensive to decode and hangs the browser.
@@ -695,8 +1021,19 @@ class NimbleStandalone {
       
       this.setProgress(frameNumber / this.estimatedTotalFrames);
       if (this.view != null) {
-        if (frameNumber < this.rawFrameBytes.length) {
-          this.getRecordingFrame(frameNumber).command.forEach(this.handleCommand);
+        if (this.seekableUrl != null && frameNumber < this.rawFrameBytes.length) {
+          const segment = Math.floor(frameNumber / this.keyframeInterval);
+          if (!this.isFrameLoaded(frameNumber)) {
+            // Wait for this frame's segment to arrive, which will call setFrame() again
+            this.loadSegment(segment);
+            return;
+          }
+          this.applyFrame(frameNumber);
+          // Fetch the next segment ahead of time, so playback doesn't stall
+          this.loadSegment(segment + 1);
+        }
+        else if (this.isFrameLoaded(frameNumber)) {
+          this.applyFrame(frameNumber);
         }
         else {
           // Stop playing, if we've reached the end of our loaded content
@@ -737,7 +1074,11 @@ class NimbleStandalone {
       this.msPerFrame = this.originalMsPerFrame / this.playbackMultiple;
     }
     else if (command.set_span_warning) {
-      this.addSpanWarning(command.set_span_warning.warning_key, command.set_span_warning.start_timestep, command.set_span_warning.end_timestep, command.set_span_warning.warning);
+      // Keyframes repeat every span warning, so we only add the ones we haven't seen before
+      const warningKey = command.set_span_warning.warning_key;
+      if (!this.warningSpans.some((span) => span.warningKey === warningKey)) {
+        this.addSpanWarning(warningKey, command.set_span_warning.start_timestep, command.set_span_warning.end_timestep, command.set_span_warning.warning);
+      }
     }
     else {
       this.view.handleCommand(command);
@@ -585,7 +585,10 @@ class DARTView {
    * This reads and handles a command sent from the backend
    */
   handleCommand = (command: dart.proto.Command) => {
-    if (command.layer != null) {
+    if (command.clear_all != null) {
+      this.clear();
+    }
+    else if (command.layer != null) {
       const key = command.layer.key;
       const name = command.layer.name;
       const color = command.layer.color;
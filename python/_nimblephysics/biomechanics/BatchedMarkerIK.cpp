@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/biomechanics/BatchedMarkerIK.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void BatchedMarkerIK(py::module& m)
+{
+  ::py::class_<
+      dart::biomechanics::BatchedMarkerIK,
+      std::shared_ptr<dart::biomechanics::BatchedMarkerIK>>(
+      m, "BatchedMarkerIK")
+      .def(
+          ::py::init<
+              std::shared_ptr<dynamics::Skeleton>,
+              const dynamics::MarkerMap&>(),
+          ::py::arg("skeleton"),
+          ::py::arg("markers"))
+      .def_static(
+          "isSupported",
+          &dart::biomechanics::BatchedMarkerIK::isSupported,
+          ::py::arg("skeleton"))
+      .def(
+          "refreshFromSkeleton",
+          &dart::biomechanics::BatchedMarkerIK::refreshFromSkeleton)
+      .def(
+          "getMarkerNames",
+          &dart::biomechanics::BatchedMarkerIK::getMarkerNames)
+      .def(
+          "setMarkerWeights",
+          &dart::biomechanics::BatchedMarkerIK::setMarkerWeights,
+          ::py::arg("weights"))
+      .def(
+          "setMarkerWeight",
+          &dart::biomechanics::BatchedMarkerIK::setMarkerWeight,
+          ::py::arg("name"),
+          ::py::arg("weight"))
+      .def(
+          "setMaxIterations",
+          &dart::biomechanics::BatchedMarkerIK::setMaxIterations,
+          ::py::arg("iterations"))
+      .def(
+          "setMaxColdStartIterations",
+          &dart::biomechanics::BatchedMarkerIK::setMaxColdStartIterations,
+          ::py::arg("iterations"))
+      .def(
+          "setConvergenceTolerance",
+          &dart::biomechanics::BatchedMarkerIK::setConvergenceTolerance,
+          ::py::arg("tolerance"))
+      .def(
+          "setMinFramesPerChunk",
+          &dart::biomechanics::BatchedMarkerIK::setMinFramesPerChunk,
+          ::py::arg("frames"))
+      .def(
+          "setIgnoreJointLimits",
+          &dart::biomechanics::BatchedMarkerIK::setIgnoreJointLimits,
+          ::py::arg("ignore"))
+      .def(
+          "flattenObservations",
+          &dart::biomechanics::BatchedMarkerIK::flattenObservations,
+          ::py::arg("observations"))
+      .def(
+          "solve",
+          [](dart::biomechanics::BatchedMarkerIK* self,
+             const Eigen::MatrixXs& markerObservations,
+             const Eigen::VectorXs& initialGuess) {
+            return self->solve(markerObservations, initialGuess);
+          },
+          ::py::arg("markerObservations"),
+          ::py::arg("initialGuess"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "solve",
+          [](dart::biomechanics::BatchedMarkerIK* self,
+             const std::vector<std::map<std::string, Eigen::Vector3s>>&
+                 observations,
+             const Eigen::VectorXs& initialGuess) {
+            return self->solve(observations, initialGuess);
+          },
+          ::py::arg("observations"),
+          ::py::arg("initialGuess"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getMarkerWorldPositions",
+          &dart::biomechanics::BatchedMarkerIK::getMarkerWorldPositions,
+          ::py::arg("positions"))
+      .def(
+          "getMarkerWorldPositionsJacobianWrtJointPositions",
+          &dart::biomechanics::BatchedMarkerIK::
+              getMarkerWorldPositionsJacobianWrtJointPositions,
+          ::py::arg("positions"));
+}
+
+} // namespace python
+} // namespace dart
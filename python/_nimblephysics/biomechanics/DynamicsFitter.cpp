@@ -88,6 +88,10 @@ void DynamicsFitter(py::module& m)
           ::py::init<std::shared_ptr<dynamics::Skeleton>, std::vector<int>>(),
           ::py::arg("skeleton"),
           ::py::arg("forceBodies"))
+      .def(
+          "setNumThreads",
+          &dart::biomechanics::ResidualForceHelper::setNumThreads,
+          ::py::arg("numThreads"))
       .def(
           "calculateResidual",
           &dart::biomechanics::ResidualForceHelper::calculateResidual,
@@ -542,6 +546,11 @@ protected:
       .def(
           "setNumThreads",
           &dart::biomechanics::DynamicsFitProblemConfig::setNumThreads,
+          ::py::arg("value"))
+      .def(
+          "setLogSchedulingOverhead",
+          &dart::biomechanics::DynamicsFitProblemConfig::
+              setLogSchedulingOverhead,
           ::py::arg("value"));
   ;
 
@@ -70,7 +70,13 @@ void StreamingIK(py::module& m)
           "state, though at a much lower framerate than the IK solver.")
       .def(
           "observeMarkers",
-          &dart::biomechanics::StreamingIK::observeMarkers,
+          [](dart::biomechanics::StreamingIK* self,
+             std::vector<Eigen::Vector3s>& markers,
+             std::vector<int> classes,
+             long timestamp,
+             std::vector<Eigen::Vector9s>& copTorqueForces) {
+            self->observeMarkers(markers, classes, timestamp, copTorqueForces);
+          },
           ::py::arg("markers"),
           ::py::arg("classes"),
           ::py::arg("timestamp"),
@@ -85,6 +91,34 @@ void StreamingIK(py::module& m)
           ::py::arg("priorWeight") = 1.0,
           "This sets an anthropometric prior used to help condition the body "
           "to keep reasonable scalings.")
+      .def(
+          "setRealTimeMode",
+          &dart::biomechanics::StreamingIK::setRealTimeMode,
+          ::py::arg("frameBudgetMicros"),
+          ::py::arg("staleFrameMicros") = 50000,
+          "This puts the solver into real time mode, where each frame gets a "
+          "fixed time budget measured from when it arrived. Pass a budget of "
+          "0 to go back to free running. This takes effect immediately, even "
+          "if the solver is already running.")
+      .def(
+          "getLatencyHistogram",
+          &dart::biomechanics::StreamingIK::getLatencyHistogram,
+          "This returns a copy of the histogram of latencies, in microseconds, "
+          "from when each frame arrived to the first pose we published after "
+          "it.")
+      .def(
+          "getLastPose",
+          &dart::biomechanics::StreamingIK::getLastPose,
+          "This returns the most recent pose the solver has published.")
+      .def(
+          "getNumFramesSolved",
+          &dart::biomechanics::StreamingIK::getNumFramesSolved)
+      .def(
+          "getNumFramesDropped",
+          &dart::biomechanics::StreamingIK::getNumFramesDropped)
+      .def(
+          "resetLatencyStats",
+          &dart::biomechanics::StreamingIK::resetLatencyStats)
       .def(
           "estimateState",
           &dart::biomechanics::StreamingIK::estimateState,
@@ -122,6 +122,20 @@ void StreamingMocapLab(py::module& m)
           ::py::arg("gui") = nullptr,
           "This method resets the state of the mocap lab, including the IK "
           "and the marker traces.")
+      .def(
+          "setRealTimeMode",
+          &dart::biomechanics::StreamingMocapLab::setRealTimeMode,
+          ::py::arg("frameBudgetMicros"),
+          ::py::arg("staleFrameMicros") = 50000,
+          "This puts the IK solver into real time mode, where each frame gets "
+          "a fixed time budget measured from when it arrived. This takes "
+          "effect immediately, even if the solver is already running.")
+      .def(
+          "getLatencyHistogram",
+          &dart::biomechanics::StreamingMocapLab::getLatencyHistogram,
+          "This returns the histogram of latencies, in microseconds, from "
+          "when a frame of markers arrived to when the IK first published a "
+          "pose after it.")
       .def(
           "getMarkerTraces",
           &dart::biomechanics::StreamingMocapLab::getMarkerTraces)
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/biomechanics/SubjectBatchProcessor.hpp"
+
+#include <memory>
+
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "dart/biomechanics/SkeletonClonePool.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void SubjectBatchProcessor(py::module& m)
+{
+  ::py::class_<
+      dart::biomechanics::SkeletonClonePool,
+      std::shared_ptr<dart::biomechanics::SkeletonClonePool>>(
+      m, "SkeletonClonePool")
+      .def(
+          ::py::init<int>(),
+          ::py::arg("maxIdlePerSkeleton") = 64)
+      .def_static(
+          "getGlobalPool",
+          &dart::biomechanics::SkeletonClonePool::getGlobalPool)
+      .def(
+          "acquire",
+          &dart::biomechanics::SkeletonClonePool::acquire,
+          ::py::arg("source"))
+      .def("clear", &dart::biomechanics::SkeletonClonePool::clear)
+      .def(
+          "getNumClonesCreated",
+          &dart::biomechanics::SkeletonClonePool::getNumClonesCreated)
+      .def(
+          "getNumClonesReused",
+          &dart::biomechanics::SkeletonClonePool::getNumClonesReused)
+      .def(
+          "getNumIdleClones",
+          &dart::biomechanics::SkeletonClonePool::getNumIdleClones);
+
+  ::py::class_<dart::biomechanics::SubjectBatchResult>(m, "SubjectBatchResult")
+      .def_readonly("name", &dart::biomechanics::SubjectBatchResult::name)
+      .def_readonly(
+          "success", &dart::biomechanics::SubjectBatchResult::success)
+      .def_readonly("error", &dart::biomechanics::SubjectBatchResult::error)
+      .def_readonly(
+          "kinematicsSeconds",
+          &dart::biomechanics::SubjectBatchResult::kinematicsSeconds)
+      .def_readonly(
+          "dynamicsSeconds",
+          &dart::biomechanics::SubjectBatchResult::dynamicsSeconds);
+
+  ::py::class_<
+      dart::biomechanics::SubjectBatchProcessor,
+      std::shared_ptr<dart::biomechanics::SubjectBatchProcessor>>(
+      m, "SubjectBatchProcessor")
+      .def(
+          ::py::init<int, int>(),
+          ::py::arg("numCores") = -1,
+          ::py::arg("maxSubjectsInFlight") = -1)
+      .def(
+          "addSubject",
+          ::py::overload_cast<
+              std::string,
+              std::function<void()>,
+              std::function<void()>>(
+              &dart::biomechanics::SubjectBatchProcessor::addSubject),
+          ::py::arg("name"),
+          ::py::arg("kinematics"),
+          ::py::arg("dynamics"))
+      .def(
+          "getNumSubjects",
+          &dart::biomechanics::SubjectBatchProcessor::getNumSubjects)
+      .def(
+          "getNumCores",
+          &dart::biomechanics::SubjectBatchProcessor::getNumCores)
+      .def(
+          "getMaxSubjectsInFlight",
+          &dart::biomechanics::SubjectBatchProcessor::getMaxSubjectsInFlight)
+      .def(
+          "run",
+          &dart::biomechanics::SubjectBatchProcessor::run,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getNumSucceeded",
+          &dart::biomechanics::SubjectBatchProcessor::getNumSucceeded)
+      .def(
+          "getWallSeconds",
+          &dart::biomechanics::SubjectBatchProcessor::getWallSeconds)
+      .def(
+          "getSubjectsPerHour",
+          &dart::biomechanics::SubjectBatchProcessor::getSubjectsPerHour)
+      .def(
+          "getSchedulingStats",
+          &dart::biomechanics::SubjectBatchProcessor::getSchedulingStats);
+}
+
+} // namespace python
+} // namespace dart
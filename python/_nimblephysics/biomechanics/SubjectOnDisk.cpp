@@ -1160,7 +1160,14 @@ Note that these are specified in the local body frame, acting on the body at its
                 "writeB3D",
                 &dart::biomechanics::SubjectOnDisk::writeB3D,
                 ::py::arg("path"),
-                ::py::arg("header"))
+                ::py::arg("header"),
+                ::py::arg("columnar") = false,
+                "This will write a B3D file to disk. If :code:`columnar` is "
+                "true, this writes a version 5 file where each channel of each "
+                "trial and processing pass is stored as a contiguous column, "
+                "so that :code:`readProcessingPassColumn()` and "
+                ":code:`readSensorColumn()` can read a window of a single "
+                "channel with one contiguous read.")
             //   /// This will read the skeleton from the binary, and optionally
             //   use the passed
             //   /// in Geometry folder.
@@ -1177,6 +1184,22 @@ Note that these are specified in the local body frame, acting on the body at its
                 &dart::biomechanics::SubjectOnDisk::hasLoadedAllFrames,
                 "This returns true if all the frames have been loaded into "
                 "memory.")
+            .def(
+                "setUseMemoryMap",
+                &dart::biomechanics::SubjectOnDisk::setUseMemoryMap,
+                ::py::arg("useMemoryMap"),
+                "This opts in to (or out of) reading frames from a read-only "
+                "memory map of the B3D file. When enabled, the file is mapped "
+                "once, and :code:`readFrames()` parses frames straight out of "
+                "the mapped pages, without reopening the file on every call. "
+                "Returns true if memory mapped reads are now active, or false "
+                "if the file couldn't be mapped and regular reads will be "
+                "used instead.")
+            .def(
+                "getUseMemoryMap",
+                &dart::biomechanics::SubjectOnDisk::getUseMemoryMap,
+                "This returns true if :code:`readFrames()` is reading out of a "
+                "memory map.")
             .def(
                 "getHeaderProto",
                 &dart::biomechanics::SubjectOnDisk::getHeaderProto,
@@ -1275,6 +1298,43 @@ Note that these are specified in the local body frame, acting on the body at its
                 "immediately allow the frames to go out of scope and be "
                 "released after the batch backpropagates gradient and loss."
                 " On OOB access, prints an error and returns an empty vector.")
+            .def(
+                "readProcessingPassColumn",
+                &dart::biomechanics::SubjectOnDisk::readProcessingPassColumn,
+                ::py::arg("trial"),
+                ::py::arg("processingPass"),
+                ::py::arg("columnName"),
+                ::py::arg("startFrame"),
+                ::py::arg("numFramesToRead") = 1,
+                ::py::arg("stride") = 1,
+                "This reads a window of a single processing pass channel for a "
+                "trial, as a matrix with one column per frame. The "
+                ":code:`columnName` is the name of the field on "
+                ":code:`SubjectOnDiskProcessingPassFrame` in "
+                "SubjectOnDisk.proto, like \"pos\", \"vel\", \"acc\" or "
+                "\"tau\". On columnar files this is a single contiguous read "
+                "that doesn't decode any other channel. On OOB access or an "
+                "unknown column, prints an error and returns an empty matrix.")
+            .def(
+                "readSensorColumn",
+                &dart::biomechanics::SubjectOnDisk::readSensorColumn,
+                ::py::arg("trial"),
+                ::py::arg("columnName"),
+                ::py::arg("startFrame"),
+                ::py::arg("numFramesToRead") = 1,
+                ::py::arg("stride") = 1,
+                "This reads a window of a single raw sensor channel for a "
+                "trial, as a matrix with one column per frame. The "
+                ":code:`columnName` is the name of the field on "
+                ":code:`SubjectOnDiskSensorFrame` in SubjectOnDisk.proto, like "
+                "\"marker_obs\" or \"raw_force_plate_force\". On OOB access or "
+                "an unknown column, prints an error and returns an empty "
+                "matrix.")
+            .def(
+                "isColumnar",
+                &dart::biomechanics::SubjectOnDisk::isColumnar,
+                "This returns true if this subject was loaded from a columnar "
+                "(version 5+) B3D file.")
             //   /// This returns the number of trials on the subject
             //   int getNumTrials();
             .def(
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/biomechanics/SubjectOnDiskBatchLoader.hpp"
+
+#include <memory>
+
+#include <Eigen/Dense>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void SubjectOnDiskBatchLoader(py::module& m)
+{
+  ::py::class_<dart::biomechanics::SubjectOnDiskSample>(
+      m, "SubjectOnDiskSample")
+      .def(
+          ::py::init([](int subject, int trial, int startFrame) {
+            dart::biomechanics::SubjectOnDiskSample sample;
+            sample.subject = subject;
+            sample.trial = trial;
+            sample.startFrame = startFrame;
+            return sample;
+          }),
+          ::py::arg("subject"),
+          ::py::arg("trial"),
+          ::py::arg("startFrame"))
+      .def_readwrite(
+          "subject", &dart::biomechanics::SubjectOnDiskSample::subject)
+      .def_readwrite("trial", &dart::biomechanics::SubjectOnDiskSample::trial)
+      .def_readwrite(
+          "startFrame", &dart::biomechanics::SubjectOnDiskSample::startFrame);
+
+  ::py::class_<
+      dart::biomechanics::SubjectOnDiskBatch,
+      std::shared_ptr<dart::biomechanics::SubjectOnDiskBatch>>(
+      m, "SubjectOnDiskBatch")
+      .def_readonly(
+          "samples", &dart::biomechanics::SubjectOnDiskBatch::samples)
+      .def(
+          "getNumPassColumns",
+          [](dart::biomechanics::SubjectOnDiskBatch& self) {
+            return (int)self.passColumns.size();
+          })
+      .def(
+          "getNumSensorColumns",
+          [](dart::biomechanics::SubjectOnDiskBatch& self) {
+            return (int)self.sensorColumns.size();
+          })
+      .def(
+          "getPassColumn",
+          [](dart::biomechanics::SubjectOnDiskBatch& self,
+             int index) -> Eigen::MatrixXs& {
+            if (index < 0 || index >= self.passColumns.size())
+            {
+              throw ::py::index_error("Pass column index out of bounds");
+            }
+            return self.passColumns[index];
+          },
+          ::py::arg("index"),
+          ::py::return_value_policy::reference_internal,
+          "This returns the matrix for the `index`-th requested processing "
+          "pass column, with one column per sample. This is a view into the "
+          "batch's memory, not a copy, so it stays valid only as long as the "
+          "batch does.")
+      .def(
+          "getSensorColumn",
+          [](dart::biomechanics::SubjectOnDiskBatch& self,
+             int index) -> Eigen::MatrixXs& {
+            if (index < 0 || index >= self.sensorColumns.size())
+            {
+              throw ::py::index_error("Sensor column index out of bounds");
+            }
+            return self.sensorColumns[index];
+          },
+          ::py::arg("index"),
+          ::py::return_value_policy::reference_internal,
+          "This returns the matrix for the `index`-th requested sensor column, "
+          "with one column per sample. This is a view into the batch's memory, "
+          "not a copy, so it stays valid only as long as the batch does.");
+
+  ::py::class_<
+      dart::biomechanics::SubjectOnDiskBatchLoader,
+      std::shared_ptr<dart::biomechanics::SubjectOnDiskBatchLoader>>(
+      m, "SubjectOnDiskBatchLoader")
+      .def(
+          ::py::init<
+              std::vector<std::shared_ptr<dart::biomechanics::SubjectOnDisk>>,
+              std::vector<dart::biomechanics::SubjectOnDiskSample>,
+              int,
+              int,
+              int,
+              int,
+              std::vector<std::string>,
+              std::vector<std::string>,
+              int,
+              int>(),
+          ::py::arg("subjects"),
+          ::py::arg("samplingPlan"),
+          ::py::arg("batchSize"),
+          ::py::arg("windowSize"),
+          ::py::arg("stride") = 1,
+          ::py::arg("processingPass") = 0,
+          ::py::arg("passColumns")
+          = std::vector<std::string>({"pos", "vel", "acc", "tau"}),
+          ::py::arg("sensorColumns") = std::vector<std::string>(),
+          ::py::arg("numThreads") = 4,
+          ::py::arg("maxReadyBatches") = 8)
+      .def(
+          "start",
+          &dart::biomechanics::SubjectOnDiskBatchLoader::start,
+          "This starts the worker threads decoding batches in the background.")
+      .def(
+          "nextBatch",
+          &dart::biomechanics::SubjectOnDiskBatchLoader::nextBatch,
+          ::py::call_guard<py::gil_scoped_release>(),
+          "This blocks (without holding the GIL) until the next batch in the "
+          "sampling plan is ready, and returns it. Returns None once the whole "
+          "sampling plan has been returned.")
+      .def(
+          "stop",
+          &dart::biomechanics::SubjectOnDiskBatchLoader::stop,
+          ::py::call_guard<py::gil_scoped_release>(),
+          "This stops the worker threads, discarding any batches that have "
+          "been decoded but not returned yet.")
+      .def(
+          "getNumBatches",
+          &dart::biomechanics::SubjectOnDiskBatchLoader::getNumBatches)
+      .def(
+          "getPassColumnDims",
+          &dart::biomechanics::SubjectOnDiskBatchLoader::getPassColumnDims)
+      .def(
+          "getSensorColumnDims",
+          &dart::biomechanics::SubjectOnDiskBatchLoader::getSensorColumnDims)
+      .def(
+          "decodeBatch",
+          &dart::biomechanics::SubjectOnDiskBatchLoader::decodeBatch,
+          ::py::arg("batchIndex"),
+          ::py::call_guard<py::gil_scoped_release>());
+}
+
+} // namespace python
+} // namespace dart
@@ -53,6 +53,9 @@ void IKErrorReport(py::module& sm);
 void Anthropometrics(py::module& sm);
 void C3DLoader(py::module& sm);
 void SubjectOnDisk(py::module& sm);
+void SubjectOnDiskBatchLoader(py::module& sm);
+void SubjectBatchProcessor(py::module& sm);
+void BatchedMarkerIK(py::module& sm);
 void CortexStreaming(py::module& sm);
 void StreamingMarkerTraces(py::module& sm);
 void StreamingIK(py::module& sm);
@@ -82,6 +85,9 @@ void dart_biomechanics(py::module& m)
   MarkerLabeller(sm);
   IKErrorReport(sm);
   SubjectOnDisk(sm);
+  SubjectOnDiskBatchLoader(sm);
+  SubjectBatchProcessor(sm);
+  BatchedMarkerIK(sm);
   CortexStreaming(sm);
   StreamingMarkerTraces(sm);
   StreamingIK(sm);
@@ -65,6 +65,13 @@ void DARTCollisionDetector(py::module& m)
               -> std::unique_ptr<dart::collision::CollisionGroup> {
             return self->createCollisionGroup();
           })
+      .def(
+          "setUseBroadphase",
+          &dart::collision::DARTCollisionDetector::setUseBroadphase,
+          ::py::arg("useBroadphase"))
+      .def(
+          "getUseBroadphase",
+          &dart::collision::DARTCollisionDetector::getUseBroadphase)
       .def_static(
           "getStaticType",
           +[]() -> const std::string& {
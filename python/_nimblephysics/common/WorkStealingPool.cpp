@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <memory>
+
+#include <dart/common/WorkStealingPool.hpp>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void WorkStealingPool(py::module& m)
+{
+  ::py::class_<dart::common::WorkStealingPool::Stats>(
+      m, "WorkStealingPoolStats")
+      .def(::py::init<>())
+      .def_readwrite(
+          "numLoops", &dart::common::WorkStealingPool::Stats::numLoops)
+      .def_readwrite(
+          "numChunks", &dart::common::WorkStealingPool::Stats::numChunks)
+      .def_readwrite(
+          "numSteals", &dart::common::WorkStealingPool::Stats::numSteals)
+      .def_readwrite(
+          "wallSeconds", &dart::common::WorkStealingPool::Stats::wallSeconds)
+      .def_readwrite(
+          "busySeconds", &dart::common::WorkStealingPool::Stats::busySeconds)
+      .def_readwrite(
+          "overheadSeconds",
+          &dart::common::WorkStealingPool::Stats::overheadSeconds)
+      .def(
+          "since",
+          &dart::common::WorkStealingPool::Stats::since,
+          ::py::arg("earlier"));
+
+  ::py::class_<
+      dart::common::WorkStealingPool,
+      std::shared_ptr<dart::common::WorkStealingPool>>(m, "WorkStealingPool")
+      .def_static(
+          "getGlobalPool", &dart::common::WorkStealingPool::getGlobalPool)
+      .def_static(
+          "getCurrentPool", &dart::common::WorkStealingPool::getCurrentPool)
+      .def_static(
+          "setGlobalNumThreads",
+          &dart::common::WorkStealingPool::setGlobalNumThreads,
+          ::py::arg("numThreads"))
+      .def("getNumThreads", &dart::common::WorkStealingPool::getNumThreads)
+      .def(
+          "getNumSlots",
+          &dart::common::WorkStealingPool::getNumSlots,
+          ::py::arg("maxWorkers") = -1)
+      .def("getStats", &dart::common::WorkStealingPool::getStats)
+      .def("resetStats", &dart::common::WorkStealingPool::resetStats);
+}
+
+} // namespace python
+} // namespace dart
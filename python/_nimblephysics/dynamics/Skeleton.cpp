@@ -1043,6 +1043,16 @@ void Skeleton(
           &dart::dynamics::Skeleton::
               getJointWorldPositionsJacobianWrtBodyScales,
           ::py::arg("joints"))
+      .def(
+          "getSparseJointWorldPositionsJacobianWrtJointPositions",
+          &dart::dynamics::Skeleton::
+              getSparseJointWorldPositionsJacobianWrtJointPositions,
+          ::py::arg("joints"))
+      .def(
+          "getSparseJointWorldPositionsJacobianWrtBodyScales",
+          &dart::dynamics::Skeleton::
+              getSparseJointWorldPositionsJacobianWrtBodyScales,
+          ::py::arg("joints"))
       .def(
           "getMarkerWorldPositions",
           &dart::dynamics::Skeleton::getMarkerWorldPositions,
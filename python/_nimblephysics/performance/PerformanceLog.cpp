@@ -43,8 +43,58 @@ namespace python {
 
 void PerformanceLog(py::module& m)
 {
-  ::py::class_<dart::performance::FinalizedPerformanceLog>(
+  ::py::class_<dart::performance::PerformanceHistogram>(
+      m, "PerformanceHistogram")
+      .def(::py::init<>())
+      .def(
+          "record",
+          &dart::performance::PerformanceHistogram::record,
+          ::py::arg("duration"))
+      .def(
+          "merge",
+          &dart::performance::PerformanceHistogram::merge,
+          ::py::arg("other"))
+      .def("clear", &dart::performance::PerformanceHistogram::clear)
+      .def("getCount", &dart::performance::PerformanceHistogram::getCount)
+      .def("getTotal", &dart::performance::PerformanceHistogram::getTotal)
+      .def("getMin", &dart::performance::PerformanceHistogram::getMin)
+      .def("getMax", &dart::performance::PerformanceHistogram::getMax)
+      .def("getMean", &dart::performance::PerformanceHistogram::getMean)
+      .def(
+          "getPercentile",
+          &dart::performance::PerformanceHistogram::getPercentile,
+          ::py::arg("percentile"),
+          "This estimates the `percentile` (between 0 and 1) duration.")
+      .def("getBuckets", &dart::performance::PerformanceHistogram::getBuckets);
+
+  ::py::class_<
+      dart::performance::FinalizedPerformanceLog,
+      std::shared_ptr<dart::performance::FinalizedPerformanceLog>>(
       m, "FinalizedPerformanceLog")
+      .def("getName", &dart::performance::FinalizedPerformanceLog::getName)
+      .def(
+          "getChild",
+          &dart::performance::FinalizedPerformanceLog::getChild,
+          ::py::arg("name"))
+      .def(
+          "getNumRuns",
+          &dart::performance::FinalizedPerformanceLog::getNumRuns)
+      .def(
+          "getMeanRuntime",
+          &dart::performance::FinalizedPerformanceLog::getMeanRuntime)
+      .def(
+          "getTotalRuntime",
+          &dart::performance::FinalizedPerformanceLog::getTotalRuntime)
+      .def(
+          "getMinRuntime",
+          &dart::performance::FinalizedPerformanceLog::getMinRuntime)
+      .def(
+          "getMaxRuntime",
+          &dart::performance::FinalizedPerformanceLog::getMaxRuntime)
+      .def(
+          "getPercentileRuntime",
+          &dart::performance::FinalizedPerformanceLog::getPercentileRuntime,
+          ::py::arg("percentile"))
       .def(
           "prettyPrint",
           &dart::performance::FinalizedPerformanceLog::prettyPrint)
@@ -58,7 +108,22 @@ void PerformanceLog(py::module& m)
                   std::string,
                   std::shared_ptr<dart::performance::FinalizedPerformanceLog>> {
             return self->finalize();
-          });
+          })
+      .def_static(
+          "initialize", &dart::performance::PerformanceLog::initialize)
+      .def_static(
+          "setSamplingRate",
+          &dart::performance::PerformanceLog::setSamplingRate,
+          ::py::arg("rate"))
+      .def_static(
+          "getSamplingRate",
+          &dart::performance::PerformanceLog::getSamplingRate)
+      .def_static(
+          "toChromeTrace", &dart::performance::PerformanceLog::toChromeTrace)
+      .def_static(
+          "writeChromeTrace",
+          &dart::performance::PerformanceLog::writeChromeTrace,
+          ::py::arg("path"));
 }
 
 } // namespace python
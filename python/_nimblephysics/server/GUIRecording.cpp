@@ -69,6 +69,28 @@ void GUIRecording(py::module& m)
           "writeFrameJson",
           &dart::server::GUIRecording::writeFrameJson,
           ::py::arg("path"),
+          ::py::arg("frame"))
+      .def(
+          "startStreaming",
+          &dart::server::GUIRecording::startStreaming,
+          ::py::arg("path"),
+          ::py::arg("keyframeInterval") = 300)
+      .def("finishStreaming", &dart::server::GUIRecording::finishStreaming)
+      .def("isStreaming", &dart::server::GUIRecording::isStreaming)
+      .def(
+          "getNumStreamedFrames",
+          &dart::server::GUIRecording::getNumStreamedFrames)
+      .def_static(
+          "readNumStreamedFrames",
+          &dart::server::GUIRecording::readNumStreamedFrames,
+          ::py::arg("path"))
+      .def_static(
+          "readStreamedFrameJson",
+          [](const std::string& path, int frame) -> py::bytes {
+            return py::bytes(
+                dart::server::GUIRecording::readStreamedFrameJson(path, frame));
+          },
+          ::py::arg("path"),
           ::py::arg("frame"));
 }
 
@@ -466,7 +466,21 @@ void GUIStateMachine(py::module& m)
           &dart::server::GUIStateMachine::clearBodyWrench,
           ::py::arg("body"),
           ::py::arg("prefix") = "wrench",
-          ::py::call_guard<py::gil_scoped_release>());
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "setCoalesceObjectUpdates",
+          &dart::server::GUIStateMachine::setCoalesceObjectUpdates,
+          ::py::arg("coalesce"))
+      .def(
+          "getCoalesceObjectUpdates",
+          &dart::server::GUIStateMachine::getCoalesceObjectUpdates)
+      .def(
+          "setChangeTolerance",
+          &dart::server::GUIStateMachine::setChangeTolerance,
+          ::py::arg("tolerance"))
+      .def(
+          "getChangeTolerance",
+          &dart::server::GUIStateMachine::getChangeTolerance);
 }
 
 } // namespace python
@@ -81,6 +81,14 @@ void GUIWebsocketServer(py::module& m)
           ::py::arg("key"))
       .def("clear", &dart::server::GUIWebsocketServer::clear)
       .def("flush", &dart::server::GUIWebsocketServer::flush)
+      .def(
+          "setMaxClientBufferBytes",
+          &dart::server::GUIWebsocketServer::setMaxClientBufferBytes,
+          ::py::arg("bytes"))
+      .def(
+          "setUseBinaryFrames",
+          &dart::server::GUIWebsocketServer::setUseBinaryFrames,
+          ::py::arg("binary"))
       .def(
           "registerConnectionListener",
           &dart::server::GUIWebsocketServer::registerConnectionListener,
@@ -33,6 +33,8 @@
 #include <dart/collision/CollisionResult.hpp>
 #include <dart/constraint/ConstraintSolver.hpp>
 #include <dart/dynamics/Skeleton.hpp>
+#include <dart/neural/BackpropSnapshot.hpp>
+#include <dart/neural/ClampingFactorizationCache.hpp>
 #include <dart/neural/WithRespectToMass.hpp>
 #include <dart/simulation/World.hpp>
 #include <dart/utils/UniversalLoader.hpp>
@@ -477,6 +479,9 @@ void World(
           &dart::simulation::World::setFallbackConstraintForceMixingConstant,
           ::py::arg("constant") = 1e-3)
       .def("getWrtMass", &dart::simulation::World::getWrtMass)
+      .def(
+          "getClampingFactorizationCache",
+          &dart::simulation::World::getClampingFactorizationCache)
       .def("toJson", &dart::simulation::World::toJson)
       .def("positionsToJson", &dart::simulation::World::positionsToJson)
       .def("colorsToJson", &dart::simulation::World::colorsToJson)
@@ -485,6 +490,11 @@ void World(
           &dart::simulation::World::setUseFDOverride,
           ::py::arg("useFDOverride"))
       .def("getUseFDOverride", &dart::simulation::World::getUseFDOverride)
+      .def(
+          "setUseVJPBackprop",
+          &dart::simulation::World::setUseVJPBackprop,
+          ::py::arg("useVJPs"))
+      .def("getUseVJPBackprop", &dart::simulation::World::getUseVJPBackprop)
       .def(
           "getCachedLCPSolution",
           &dart::simulation::World::getCachedLCPSolution)
@@ -520,7 +530,39 @@ void World(
           &dart::simulation::World::addDofToActionSpace,
           ::py::arg("dofIndex"))
       .def("getStateJacobian", &dart::simulation::World::getStateJacobian)
-      .def("getActionJacobian", &dart::simulation::World::getActionJacobian);
+      .def("getActionJacobian", &dart::simulation::World::getActionJacobian)
+      .def(
+          "stepBatch",
+          +[](dart::simulation::World* self,
+              Eigen::MatrixXs states,
+              Eigen::MatrixXs actions,
+              int maxThreads) -> Eigen::MatrixXs {
+            return self->stepBatch(states, actions, nullptr, maxThreads);
+          },
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::arg("maxThreads") = -1,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "stepBatchWithSnapshots",
+          +[](dart::simulation::World* self,
+              Eigen::MatrixXs states,
+              Eigen::MatrixXs actions,
+              int maxThreads)
+              -> std::pair<
+                  Eigen::MatrixXs,
+                  std::vector<std::shared_ptr<dart::neural::BackpropSnapshot>>> {
+            std::vector<std::shared_ptr<dart::neural::BackpropSnapshot>>
+                snapshots;
+            Eigen::MatrixXs nextStates
+                = self->stepBatch(states, actions, &snapshots, maxThreads);
+            return std::make_pair(nextStates, snapshots);
+          },
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::arg("maxThreads") = -1,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def("clearBatchReplicas", &dart::simulation::World::clearBatchReplicas);
 }
 
 } // namespace python
@@ -45,6 +45,7 @@ namespace python {
 void WithRespectTo(
     py::module& sm, ::py::class_<dart::neural::WithRespectTo>& withRespectTo);
 void WithRespectToMass(py::module& sm);
+void ClampingFactorizationCache(py::module& sm);
 void NeuralUtils(py::module& sm);
 void NeuralGlobalMethods(py::module& sm);
 void Mapping(py::module& sm);
@@ -78,6 +79,7 @@ void dart_simulation_and_neural(
   NeuralUtils(neural);
   WithRespectTo(neural, withRespectTo);
   WithRespectToMass(neural);
+  ClampingFactorizationCache(neural);
   Mapping(neural);
   IKMapping(neural);
   IdentityMapping(neural);
@@ -96,7 +96,14 @@ void IPOptOptimizer(py::module& m)
       .def(
           "setRecordIterations",
           &dart::trajectory::IPOptOptimizer::setRecordIterations,
-          ::py::arg("recordIterations") = true);
+          ::py::arg("recordIterations") = true)
+      .def(
+          "setUseGaussNewtonHessian",
+          &dart::trajectory::IPOptOptimizer::setUseGaussNewtonHessian,
+          ::py::arg("useGaussNewtonHessian") = true)
+      .def(
+          "getUseGaussNewtonHessian",
+          &dart::trajectory::IPOptOptimizer::getUseGaussNewtonHessian);
   /*
   .def(
       "registerIntermediateCallback",
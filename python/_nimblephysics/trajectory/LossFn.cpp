@@ -36,6 +36,7 @@
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -55,6 +56,14 @@ void LossFn(py::module& m)
               dart::trajectory::TrajectoryLossFnAndGrad>(),
           ::py::arg("loss"),
           ::py::arg("lossFnAndGrad"))
+      .def(
+          ::py::init<
+              dart::trajectory::TrajectoryLossFn,
+              dart::trajectory::TrajectoryLossFnAndGrad,
+              dart::trajectory::TrajectoryLossFnHessian>(),
+          ::py::arg("loss"),
+          ::py::arg("lossFnAndGrad"),
+          ::py::arg("lossHessian"))
       .def(
           "getLoss",
           &dart::trajectory::LossFn::getLoss,
@@ -66,6 +75,12 @@ void LossFn(py::module& m)
           ::py::arg("rollout"),
           ::py::arg("gradWrtRollout"),
           ::py::arg("perfLog") = nullptr)
+      .def("hasHessian", &dart::trajectory::LossFn::hasHessian)
+      .def(
+          "getLossHessian",
+          &dart::trajectory::LossFn::getLossHessian,
+          ::py::arg("rollout"),
+          ::py::arg("perfLog") = nullptr)
       .def(
           "setUpperBound",
           &dart::trajectory::LossFn::setUpperBound,
@@ -315,7 +315,23 @@ void Problem(py::module& m)
           &dart::trajectory::Problem::updateWithForces,
           ::py::arg("world"),
           ::py::arg("forces"),
-          ::py::arg("perfLog") = nullptr);
+          ::py::arg("perfLog") = nullptr)
+      .def("hasHessian", &dart::trajectory::Problem::hasHessian)
+      .def(
+          "getNumberNonZeroHessian",
+          &dart::trajectory::Problem::getNumberNonZeroHessian,
+          ::py::arg("world"))
+      .def(
+          "getHessian",
+          +[](dart::trajectory::Problem* self,
+              std::shared_ptr<dart::simulation::World> world)
+              -> Eigen::MatrixXs {
+            int dim = self->getFlatProblemDim(world);
+            Eigen::MatrixXs hess = Eigen::MatrixXs::Zero(dim, dim);
+            self->getHessian(world, hess);
+            return hess;
+          },
+          ::py::arg("world"));
   /*
 .def(
   "getRepresentation",
@@ -3013,6 +3013,71 @@ std::cout << "v_t --> p_t+1:" << std::endl
   return true;
 }
 
+bool verifyVJPBackprop(
+    WorldPtr world,
+    const neural::BackpropSnapshotPtr& classicPtr,
+    const VectorXs& phaseSpace)
+{
+  LossGradient nextTimeStep;
+  nextTimeStep.lossWrtPosition = phaseSpace.segment(0, phaseSpace.size() / 2);
+  nextTimeStep.lossWrtVelocity
+      = phaseSpace.segment(phaseSpace.size() / 2, phaseSpace.size() / 2);
+
+  bool oldUseVJPs = classicPtr->getUseVJPBackprop();
+
+  LossGradient dense;
+  classicPtr->setUseVJPBackprop(false);
+  classicPtr->backprop(world, dense, nextTimeStep);
+
+  LossGradient vjp;
+  classicPtr->setUseVJPBackprop(true);
+  classicPtr->backprop(world, vjp, nextTimeStep);
+
+  classicPtr->setUseVJPBackprop(oldUseVJPs);
+
+  const s_t threshold = 1e-8;
+  const s_t scale = std::max(
+      (s_t)1.0,
+      std::max(
+          dense.lossWrtPosition.cwiseAbs().maxCoeff(),
+          std::max(
+              dense.lossWrtVelocity.cwiseAbs().maxCoeff(),
+              dense.lossWrtTorque.cwiseAbs().maxCoeff())));
+  if (!equals(dense.lossWrtPosition, vjp.lossWrtPosition, threshold * scale)
+      || !equals(
+          dense.lossWrtVelocity, vjp.lossWrtVelocity, threshold * scale)
+      || !equals(dense.lossWrtTorque, vjp.lossWrtTorque, threshold * scale)
+      || !equals(dense.lossWrtMass, vjp.lossWrtMass, threshold * scale))
+  {
+    std::cout << "VJP backprop doesn't match dense backprop!" << std::endl;
+    std::cout << "Loss wrt p_t+1:" << std::endl
+              << nextTimeStep.lossWrtPosition << std::endl;
+    std::cout << "Loss wrt v_t+1:" << std::endl
+              << nextTimeStep.lossWrtVelocity << std::endl;
+    Eigen::MatrixXs posCompare(dense.lossWrtPosition.size(), 3);
+    posCompare.col(0) = dense.lossWrtPosition;
+    posCompare.col(1) = vjp.lossWrtPosition;
+    posCompare.col(2) = dense.lossWrtPosition - vjp.lossWrtPosition;
+    std::cout << "Loss wrt p_t (dense - vjp - diff):" << std::endl
+              << posCompare << std::endl;
+    Eigen::MatrixXs velCompare(dense.lossWrtVelocity.size(), 3);
+    velCompare.col(0) = dense.lossWrtVelocity;
+    velCompare.col(1) = vjp.lossWrtVelocity;
+    velCompare.col(2) = dense.lossWrtVelocity - vjp.lossWrtVelocity;
+    std::cout << "Loss wrt v_t (dense - vjp - diff):" << std::endl
+              << velCompare << std::endl;
+    Eigen::MatrixXs torqueCompare(dense.lossWrtTorque.size(), 3);
+    torqueCompare.col(0) = dense.lossWrtTorque;
+    torqueCompare.col(1) = vjp.lossWrtTorque;
+    torqueCompare.col(2) = dense.lossWrtTorque - vjp.lossWrtTorque;
+    std::cout << "Loss wrt f_t (dense - vjp - diff):" << std::endl
+              << torqueCompare << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 bool verifyAnalyticalBackprop(WorldPtr world)
 {
   neural::BackpropSnapshotPtr classicPtr = neural::forwardPass(world, true);
@@ -3040,6 +3105,8 @@ bool verifyAnalyticalBackprop(WorldPtr world)
       phaseSpace(i - 1) = 0;
     if (!verifyAnalyticalBackpropInstance(world, classicPtr, phaseSpace))
       return false;
+    if (!verifyVJPBackprop(world, classicPtr, phaseSpace))
+      return false;
   }
 
   // Test all "0"s
@@ -3051,6 +3118,8 @@ bool verifyAnalyticalBackprop(WorldPtr world)
   phaseSpace = VectorXs::Ones(world->getNumDofs() * 2);
   if (!verifyAnalyticalBackpropInstance(world, classicPtr, phaseSpace))
     return false;
+  if (!verifyVJPBackprop(world, classicPtr, phaseSpace))
+    return false;
 
   return true;
 }
@@ -4353,6 +4422,60 @@ bool verifySkeletonMarkerJacobians(
     return false;
   }
 
+  // The sparse Jacobians should match the dense ones exactly, just skipping
+  // the structural zeros
+  Eigen::MatrixXs sparsePosJac = Eigen::MatrixXs(
+      skel->getSparseMarkerWorldPositionsJacobianWrtJointPositions(markers));
+  if (!equals(sparsePosJac, posJac, 1e-12))
+  {
+    EXPECT_TRUE(equals(sparsePosJac, posJac, 1e-12));
+    std::cout << "Error on sparse Jac of markers wrt joint positions"
+              << std::endl
+              << "Diff:" << std::endl
+              << sparsePosJac - posJac << std::endl;
+    return false;
+  }
+  Eigen::MatrixXs sparseScaleJac = Eigen::MatrixXs(
+      skel->getSparseMarkerWorldPositionsJacobianWrtBodyScales(markers));
+  if (!equals(sparseScaleJac, scaleJac, 1e-12))
+  {
+    EXPECT_TRUE(equals(sparseScaleJac, scaleJac, 1e-12));
+    std::cout << "Error on sparse Jac of markers wrt body scales" << std::endl
+              << "Diff:" << std::endl
+              << sparseScaleJac - scaleJac << std::endl;
+    return false;
+  }
+  std::vector<dynamics::Joint*> joints;
+  for (int i = 0; i < skel->getNumJoints(); i++)
+  {
+    joints.push_back(skel->getJoint(i));
+  }
+  Eigen::MatrixXs jointPosJac
+      = skel->getJointWorldPositionsJacobianWrtJointPositions(joints);
+  Eigen::MatrixXs sparseJointPosJac = Eigen::MatrixXs(
+      skel->getSparseJointWorldPositionsJacobianWrtJointPositions(joints));
+  if (!equals(sparseJointPosJac, jointPosJac, 1e-12))
+  {
+    EXPECT_TRUE(equals(sparseJointPosJac, jointPosJac, 1e-12));
+    std::cout << "Error on sparse Jac of joints wrt joint positions"
+              << std::endl
+              << "Diff:" << std::endl
+              << sparseJointPosJac - jointPosJac << std::endl;
+    return false;
+  }
+  Eigen::MatrixXs jointScaleJac
+      = skel->getJointWorldPositionsJacobianWrtBodyScales(joints);
+  Eigen::MatrixXs sparseJointScaleJac = Eigen::MatrixXs(
+      skel->getSparseJointWorldPositionsJacobianWrtBodyScales(joints));
+  if (!equals(sparseJointScaleJac, jointScaleJac, 1e-12))
+  {
+    EXPECT_TRUE(equals(sparseJointScaleJac, jointScaleJac, 1e-12));
+    std::cout << "Error on sparse Jac of joints wrt body scales" << std::endl
+              << "Diff:" << std::endl
+              << sparseJointScaleJac - jointScaleJac << std::endl;
+    return false;
+  }
+
   Eigen::MatrixXs groupScaleJac
       = skel->getMarkerWorldPositionsJacobianWrtGroupScales(markers);
   Eigen::MatrixXs groupScaleJac_fd
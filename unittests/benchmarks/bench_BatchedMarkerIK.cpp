@@ -0,0 +1,192 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/biomechanics/BatchedMarkerIK.hpp"
+#include "dart/biomechanics/MarkerFitter.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/common/WorkStealingPool.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+static const std::string kArnoldPrefix
+    = "dart://sample/regression/Arnold2013Synthetic/subject01/";
+
+/// This loads the scaled subject01 model, and the walk2 marker trial trimmed
+/// to `numFrames` frames, keeping only markers that are on the model
+static void loadArnoldSubject01(
+    int numFrames,
+    OpenSimFile& osim,
+    std::vector<std::map<std::string, Eigen::Vector3s>>& observations)
+{
+  osim = OpenSimParser::parseOsim(kArnoldPrefix + "subject01.osim");
+  OpenSimTRC trc
+      = OpenSimParser::loadTRC(kArnoldPrefix + "trials/walk2/markers.trc");
+
+  observations.clear();
+  for (int t = 0; t < numFrames && t < trc.markerTimesteps.size(); t++)
+  {
+    observations.emplace_back();
+    for (auto& pair : trc.markerTimesteps[t])
+    {
+      if (osim.markersMap.count(pair.first))
+      {
+        observations.back()[pair.first] = pair.second;
+      }
+    }
+  }
+}
+
+/// This runs the per-frame IK that runKinematicsPipeline() uses, on the first
+/// state.range(0) frames of the trial, and reports frames per second
+static void BM_Arnold_FitTrajectory(benchmark::State& state)
+{
+  OpenSimFile osim;
+  std::vector<std::map<std::string, Eigen::Vector3s>> observations;
+  loadArnoldSubject01(state.range(0), osim, observations);
+  std::shared_ptr<dynamics::Skeleton> skel = osim.skeleton;
+  MarkerFitter fitter(skel, osim.markersMap);
+
+  const int numFrames = observations.size();
+  std::vector<dynamics::Joint*> allJoints;
+  for (int i = 0; i < skel->getNumJoints(); i++)
+  {
+    allJoints.push_back(skel->getJoint(i));
+  }
+  // No joint center or axis observations, so this is just marker IK
+  std::vector<Eigen::VectorXs> emptyPerFrame(numFrames, Eigen::VectorXs());
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(skel->getNumDofs(), numFrames);
+  Eigen::VectorXs scores = Eigen::VectorXs::Zero(numFrames);
+
+  long frames = 0;
+  for (auto _ : state)
+  {
+    MarkerFitter::fitTrajectory(
+        &fitter,
+        skel->getGroupScales(),
+        skel->getPositions(),
+        observations,
+        std::map<std::string, s_t>(),
+        std::map<std::string, Eigen::Vector3s>(),
+        std::vector<dynamics::Joint*>(),
+        emptyPerFrame,
+        Eigen::VectorXs::Zero(0),
+        emptyPerFrame,
+        Eigen::VectorXs::Zero(0),
+        allJoints,
+        poses,
+        scores);
+    frames += numFrames;
+  }
+
+  state.counters["frames/s"]
+      = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Arnold_FitTrajectory)
+    ->Arg(50)
+    ->Arg(200)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// This runs BatchedMarkerIK on the first state.range(0) frames of the trial,
+/// and reports frames per second
+static void BM_Arnold_BatchedMarkerIK(benchmark::State& state)
+{
+  OpenSimFile osim;
+  std::vector<std::map<std::string, Eigen::Vector3s>> observations;
+  loadArnoldSubject01(state.range(0), osim, observations);
+  std::shared_ptr<dynamics::Skeleton> skel = osim.skeleton;
+
+  BatchedMarkerIK ik(skel, osim.markersMap);
+  const Eigen::MatrixXs flat = ik.flattenObservations(observations);
+  const Eigen::VectorXs initialGuess = skel->getPositions();
+
+  long frames = 0;
+  for (auto _ : state)
+  {
+    Eigen::MatrixXs poses = ik.solve(flat, initialGuess);
+    benchmark::DoNotOptimize(poses.data());
+    frames += flat.cols();
+  }
+
+  state.counters["frames/s"]
+      = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+  state.counters["threads"]
+      = common::WorkStealingPool::getGlobalPool()->getNumThreads();
+}
+BENCHMARK(BM_Arnold_BatchedMarkerIK)
+    ->Arg(50)
+    ->Arg(200)
+    ->Arg(1000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// This nudges each DOF of the subject01 model in turn, the way coordinate
+/// sweeps and finite differencing do, and reads back every marker. With
+/// state.range(0) == 0 it goes through setPositions() and
+/// getMarkerWorldPositions(). With state.range(0) == 1 it goes through
+/// setPositionsAndUpdateBodyWorldTransforms(), which only recomputes the bodies
+/// below the DOF that moved.
+static void BM_Arnold_CoordinateSweep(benchmark::State& state)
+{
+  OpenSimFile osim;
+  std::vector<std::map<std::string, Eigen::Vector3s>> observations;
+  loadArnoldSubject01(1, osim, observations);
+  std::shared_ptr<dynamics::Skeleton> skel = osim.skeleton;
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  for (auto& pair : osim.markersMap)
+  {
+    markers.push_back(pair.second);
+  }
+  const bool sparse = state.range(0) == 1;
+
+  const Eigen::VectorXs originalPos = skel->getPositions();
+  Eigen::VectorXs pos = originalPos;
+  std::vector<Eigen::Isometry3s> bodyTransforms;
+  skel->getBodyWorldTransforms(bodyTransforms);
+  std::vector<std::size_t> dofs(1);
+  Eigen::VectorXs value = Eigen::VectorXs::Zero(1);
+
+  long updates = 0;
+  for (auto _ : state)
+  {
+    for (int i = 0; i < skel->getNumDofs(); i++)
+    {
+      for (s_t offset : {0.01, 0.0})
+      {
+        if (sparse)
+        {
+          dofs[0] = i;
+          value(0) = originalPos(i) + offset;
+          skel->setPositionsAndUpdateBodyWorldTransforms(
+              dofs, value, bodyTransforms);
+          Eigen::VectorXs markerPos
+              = skel->getMarkerWorldPositions(markers, bodyTransforms);
+          benchmark::DoNotOptimize(markerPos.data());
+        }
+        else
+        {
+          pos(i) = originalPos(i) + offset;
+          skel->setPositions(pos);
+          Eigen::VectorXs markerPos = skel->getMarkerWorldPositions(markers);
+          benchmark::DoNotOptimize(markerPos.data());
+        }
+        updates++;
+      }
+    }
+  }
+
+  state.counters["updates/s"]
+      = benchmark::Counter(updates, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Arnold_CoordinateSweep)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,196 @@
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/collision/CollisionGroup.hpp"
+#include "dart/collision/CollisionOption.hpp"
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/collision/dart/DARTCollide.hpp"
+#include "dart/collision/dart/DARTCollisionDetector.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/SimpleFrame.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/math/Geometry.hpp"
+
+using namespace dart;
+
+/// This scatters `numShapes` spheres and boxes at a constant density, so the
+/// number of actually touching pairs grows linearly with the number of shapes
+static std::vector<std::shared_ptr<dynamics::SimpleFrame>> createShapes(
+    int numShapes)
+{
+  std::srand(42);
+  const s_t halfWidth = 0.5 * std::cbrt((s_t)numShapes);
+  std::vector<std::shared_ptr<dynamics::SimpleFrame>> frames;
+  for (int i = 0; i < numShapes; i++)
+  {
+    Eigen::Isometry3s tf = Eigen::Isometry3s::Identity();
+    tf.translation() = Eigen::Vector3s::Random() * halfWidth;
+    auto frame = std::make_shared<dynamics::SimpleFrame>(
+        dynamics::Frame::World(), "shape" + std::to_string(i), tf);
+    if (i % 2 == 0)
+      frame->setShape(std::make_shared<dynamics::SphereShape>(0.2));
+    else
+      frame->setShape(std::make_shared<dynamics::BoxShape>(
+          Eigen::Vector3s::Constant(0.35)));
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+static void collideGroup(benchmark::State& state, bool useBroadphase)
+{
+  auto cd = collision::DARTCollisionDetector::create();
+  cd->setUseBroadphase(useBroadphase);
+  auto frames = createShapes(state.range(0));
+  auto group = cd->createCollisionGroup();
+  for (auto& frame : frames)
+    group->addShapeFrame(frame.get());
+
+  collision::CollisionOption option(true, 100000u);
+  for (auto _ : state)
+  {
+    // Jiggle everything a little, like a simulation step would
+    state.PauseTiming();
+    for (auto& frame : frames)
+    {
+      Eigen::Isometry3s tf = frame->getRelativeTransform();
+      tf.translation() += Eigen::Vector3s::Random() * 0.01;
+      frame->setRelativeTransform(tf);
+    }
+    state.ResumeTiming();
+
+    collision::CollisionResult result;
+    group->collide(option, &result);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+static void BM_DARTCollide_BruteForce(benchmark::State& state)
+{
+  collideGroup(state, false);
+}
+BENCHMARK(BM_DARTCollide_BruteForce)->RangeMultiplier(4)->Range(16, 1024);
+
+static void BM_DARTCollide_Broadphase(benchmark::State& state)
+{
+  collideGroup(state, true);
+}
+BENCHMARK(BM_DARTCollide_Broadphase)->RangeMultiplier(4)->Range(16, 4096);
+
+/// This builds a lumpy, bone-sized ellipsoid with `numVertices` vertices. The
+/// lumps put a good fraction of the vertices inside the convex hull, like a
+/// real bone mesh.
+static std::shared_ptr<dynamics::SharedMeshWrapper> createLumpyMesh(
+    int numVertices)
+{
+  aiScene* scene = new aiScene;
+  scene->mNumMeshes = 1;
+  scene->mMeshes = new aiMesh*[1];
+  aiMesh* mesh = new aiMesh;
+  mesh->mNumVertices = numVertices;
+  mesh->mVertices = new aiVector3D[numVertices];
+  scene->mMeshes[0] = mesh;
+
+  // Spread the vertices evenly over a sphere with a Fibonacci lattice
+  const s_t goldenAngle = M_PI * (3.0 - std::sqrt(5.0));
+  for (int i = 0; i < numVertices; i++)
+  {
+    const s_t y = 1.0 - 2.0 * (i + 0.5) / numVertices;
+    const s_t r = std::sqrt(1.0 - y * y);
+    const s_t theta = goldenAngle * i;
+    const s_t lump = 1.0 + 0.05 * std::sin(7 * theta) * std::cos(11 * y);
+    mesh->mVertices[i].x = 0.03 * lump * r * std::cos(theta);
+    mesh->mVertices[i].y = 0.2 * lump * y;
+    mesh->mVertices[i].z = 0.03 * lump * r * std::sin(theta);
+  }
+  return std::make_shared<dynamics::SharedMeshWrapper>(scene);
+}
+
+/// This collides two overlapping meshes with state.range(0) vertices each,
+/// using the cached convex hulls if state.range(1) is 1, and scanning every
+/// vertex otherwise
+static void BM_DARTCollide_MeshMesh(benchmark::State& state)
+{
+  std::shared_ptr<dynamics::SharedMeshWrapper> mesh
+      = createLumpyMesh(state.range(0));
+  const bool useHull = state.range(1) == 1;
+  // Build the hull outside the timed loop, like a simulation would
+  const math::ConvexHull3D* hull
+      = useHull ? mesh->getConvexHull().get() : nullptr;
+
+  const Eigen::Vector3s scale = Eigen::Vector3s::Ones();
+  Eigen::Isometry3s T0 = Eigen::Isometry3s::Identity();
+  Eigen::Isometry3s T1 = Eigen::Isometry3s::Identity();
+  T1.linear() = math::expMapRot(Eigen::Vector3s(0.3, 0.2, 1.2));
+  T1.translation() = Eigen::Vector3s(0.05, 0.01, 0.0);
+
+  collision::CollisionOption option;
+  for (auto _ : state)
+  {
+    collision::CollisionResult result;
+    collision::collideMeshMesh(
+        nullptr,
+        nullptr,
+        mesh->mesh,
+        scale,
+        T0,
+        mesh->mesh,
+        scale,
+        T1,
+        option,
+        result,
+        hull,
+        hull);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DARTCollide_MeshMesh)
+    ->ArgsProduct({{256, 1024, 4096, 16384}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+/// This collides a mesh with state.range(0) vertices against an overlapping
+/// box, using the cached convex hull if state.range(1) is 1, and scanning
+/// every vertex otherwise
+static void BM_DARTCollide_MeshBox(benchmark::State& state)
+{
+  std::shared_ptr<dynamics::SharedMeshWrapper> mesh
+      = createLumpyMesh(state.range(0));
+  const bool useHull = state.range(1) == 1;
+  const math::ConvexHull3D* hull
+      = useHull ? mesh->getConvexHull().get() : nullptr;
+
+  const Eigen::Vector3s scale = Eigen::Vector3s::Ones();
+  const Eigen::Vector3s boxSize = Eigen::Vector3s(0.5, 0.1, 0.5);
+  Eigen::Isometry3s T0 = Eigen::Isometry3s::Identity();
+  T0.linear() = math::expMapRot(Eigen::Vector3s(0.1, 0.4, 0.2));
+  Eigen::Isometry3s T1 = Eigen::Isometry3s::Identity();
+  T1.translation() = Eigen::Vector3s(0.0, -0.24, 0.0);
+
+  collision::CollisionOption option;
+  for (auto _ : state)
+  {
+    collision::CollisionResult result;
+    collision::collideMeshBox(
+        nullptr,
+        nullptr,
+        mesh->mesh,
+        scale,
+        T0,
+        boxSize,
+        T1,
+        option,
+        result,
+        hull);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DARTCollide_MeshBox)
+    ->ArgsProduct({{256, 1024, 4096, 16384}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
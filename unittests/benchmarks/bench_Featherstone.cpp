@@ -7,7 +7,9 @@
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
+#include "dart/dynamics/BatchedFeatherstone.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FixedTopologyFeatherstone.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
@@ -29,6 +31,7 @@
 #include "dart/trajectory/Solution.hpp"
 #include "dart/trajectory/TrajectoryConstants.hpp"
 #include "dart/trajectory/TrajectoryRollout.hpp"
+#include "dart/utils/SkelParser.hpp"
 
 #include "GradientTestUtils.hpp"
 #include "TestHelpers.hpp"
@@ -142,4 +145,252 @@ static void BM_20_Joint_Simple_Featherstone(benchmark::State& state)
 }
 BENCHMARK(BM_20_Joint_Simple_Featherstone);
 
+static void BM_20_Joint_Simple_Featherstone_Loop(benchmark::State& state)
+{
+  SkeletonPtr arm = createMultiarmRobot(20, 0.2);
+  SimpleFeatherstone simple;
+  simple.populateFromSkeleton(arm);
+
+  const int numInstances = state.range(0);
+  Eigen::MatrixXs pos = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs vel = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs force = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs accel = Eigen::MatrixXs::Zero(simple.len(), numInstances);
+
+  for (auto _ : state)
+  {
+    for (int i = 0; i < numInstances; i++)
+    {
+      simple.forwardDynamics(
+          pos.col(i).data(),
+          vel.col(i).data(),
+          force.col(i).data(),
+          accel.col(i).data());
+    }
+    benchmark::DoNotOptimize(accel.data());
+  }
+  state.SetItemsProcessed(state.iterations() * numInstances);
+}
+BENCHMARK(BM_20_Joint_Simple_Featherstone_Loop)->Arg(64)->Arg(1024);
+
+static void BM_20_Joint_Batched_Featherstone(benchmark::State& state)
+{
+  SkeletonPtr arm = createMultiarmRobot(20, 0.2);
+  SimpleFeatherstone simple;
+  simple.populateFromSkeleton(arm);
+  BatchedFeatherstone batched(simple);
+
+  const int numInstances = state.range(0);
+  Eigen::MatrixXs pos = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs vel = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs force = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs accel = Eigen::MatrixXs::Zero(simple.len(), numInstances);
+
+  for (auto _ : state)
+  {
+    batched.forwardDynamics(
+        pos.data(), vel.data(), force.data(), numInstances, accel.data());
+    benchmark::DoNotOptimize(accel.data());
+  }
+  state.SetItemsProcessed(state.iterations() * numInstances);
+}
+BENCHMARK(BM_20_Joint_Batched_Featherstone)->Arg(64)->Arg(1024);
+
+static void BM_20_Joint_Batched_Inverse_Dynamics(benchmark::State& state)
+{
+  SkeletonPtr arm = createMultiarmRobot(20, 0.2);
+  SimpleFeatherstone simple;
+  simple.populateFromSkeleton(arm);
+  BatchedFeatherstone batched(simple);
+
+  const int numInstances = state.range(0);
+  Eigen::MatrixXs pos = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs vel = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs accel = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs force = Eigen::MatrixXs::Zero(simple.len(), numInstances);
+
+  for (auto _ : state)
+  {
+    batched.inverseDynamics(
+        pos.data(), vel.data(), accel.data(), numInstances, force.data());
+    benchmark::DoNotOptimize(force.data());
+  }
+  state.SetItemsProcessed(state.iterations() * numInstances);
+}
+BENCHMARK(BM_20_Joint_Batched_Inverse_Dynamics)->Arg(64)->Arg(1024);
+
+// These are the outputs of getFixedTopologyFeatherstoneType() for
+// createMultiarmRobot(20, 0.2) and biped.skel
+using TwentyJointFeatherstone = FixedTopologyFeatherstone<
+    DofsPerBody<1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1>,
+    ParentIndices<
+        -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18>>;
+using HumanoidFeatherstone = FixedTopologyFeatherstone<
+    DofsPerBody<6, 3, 1, 2, 1, 3, 1, 2, 1, 2, 1, 2, 1, 3, 1, 1, 1, 3, 1, 1>,
+    ParentIndices<
+        -1, 0, 1, 2, 3, 0, 5, 6, 7, 0, 9, 10, 10, 12, 13, 14, 10, 16, 17, 18>>;
+
+SkeletonPtr createHumanoid()
+{
+  return utils::SkelParser::readSkeleton("dart://sample/skel/biped.skel");
+}
+
+template <typename FixedTopology>
+void runFixedTopologyForwardDynamics(
+    benchmark::State& state, SkeletonPtr skel)
+{
+  FixedTopology fixed;
+  if (!fixed.populateFromSkeleton(skel))
+  {
+    state.SkipWithError("Skeleton doesn't match the fixed topology");
+    return;
+  }
+
+  typename FixedTopology::VectorDofs pos = skel->getPositions();
+  typename FixedTopology::VectorDofs vel = skel->getVelocities();
+  typename FixedTopology::VectorDofs force = skel->getControlForces();
+  typename FixedTopology::VectorDofs accel;
+
+  s_t dt = 0.001;
+  for (auto _ : state)
+  {
+    fixed.forwardDynamics(pos, vel, force, accel);
+    pos += vel * dt;
+    vel += accel * dt;
+  }
+}
+
+template <typename FixedTopology>
+void runFixedTopologyInverseDynamics(
+    benchmark::State& state, SkeletonPtr skel)
+{
+  FixedTopology fixed;
+  if (!fixed.populateFromSkeleton(skel))
+  {
+    state.SkipWithError("Skeleton doesn't match the fixed topology");
+    return;
+  }
+
+  typename FixedTopology::VectorDofs pos = skel->getPositions();
+  typename FixedTopology::VectorDofs vel = skel->getVelocities();
+  typename FixedTopology::VectorDofs accel
+      = FixedTopology::VectorDofs::Constant(0.1);
+  typename FixedTopology::VectorDofs force;
+
+  for (auto _ : state)
+  {
+    fixed.inverseDynamics(pos, vel, accel, force);
+    benchmark::DoNotOptimize(force);
+  }
+}
+
+template <typename FixedTopology>
+void runFixedTopologyMassMatrix(benchmark::State& state, SkeletonPtr skel)
+{
+  FixedTopology fixed;
+  if (!fixed.populateFromSkeleton(skel))
+  {
+    state.SkipWithError("Skeleton doesn't match the fixed topology");
+    return;
+  }
+
+  typename FixedTopology::VectorDofs pos = skel->getPositions();
+  typename FixedTopology::MatrixDofs massMatrix;
+
+  for (auto _ : state)
+  {
+    fixed.computeMassMatrix(pos, massMatrix);
+    benchmark::DoNotOptimize(massMatrix);
+  }
+}
+
+static void BM_20_Joint_Fixed_Topology_Featherstone(benchmark::State& state)
+{
+  runFixedTopologyForwardDynamics<TwentyJointFeatherstone>(
+      state, createMultiarmRobot(20, 0.2));
+}
+BENCHMARK(BM_20_Joint_Fixed_Topology_Featherstone);
+
+static void BM_20_Joint_DART_Inverse_Dynamics(benchmark::State& state)
+{
+  SkeletonPtr arm = createMultiarmRobot(20, 0.2);
+  arm->setAccelerations(Eigen::VectorXs::Constant(arm->getNumDofs(), 0.1));
+
+  for (auto _ : state)
+  {
+    arm->computeInverseDynamics();
+  }
+}
+BENCHMARK(BM_20_Joint_DART_Inverse_Dynamics);
+
+static void BM_20_Joint_Fixed_Topology_Inverse_Dynamics(
+    benchmark::State& state)
+{
+  runFixedTopologyInverseDynamics<TwentyJointFeatherstone>(
+      state, createMultiarmRobot(20, 0.2));
+}
+BENCHMARK(BM_20_Joint_Fixed_Topology_Inverse_Dynamics);
+
+static void BM_Humanoid_DART_Featherstone(benchmark::State& state)
+{
+  SkeletonPtr humanoid = createHumanoid();
+
+  s_t dt = 0.001;
+  for (auto _ : state)
+  {
+    humanoid->computeForwardDynamics();
+    humanoid->integrateVelocities(dt);
+    humanoid->integratePositions(dt);
+  }
+}
+BENCHMARK(BM_Humanoid_DART_Featherstone);
+
+static void BM_Humanoid_Fixed_Topology_Featherstone(benchmark::State& state)
+{
+  runFixedTopologyForwardDynamics<HumanoidFeatherstone>(
+      state, createHumanoid());
+}
+BENCHMARK(BM_Humanoid_Fixed_Topology_Featherstone);
+
+static void BM_Humanoid_DART_Inverse_Dynamics(benchmark::State& state)
+{
+  SkeletonPtr humanoid = createHumanoid();
+  humanoid->setAccelerations(
+      Eigen::VectorXs::Constant(humanoid->getNumDofs(), 0.1));
+
+  for (auto _ : state)
+  {
+    humanoid->computeInverseDynamics();
+  }
+}
+BENCHMARK(BM_Humanoid_DART_Inverse_Dynamics);
+
+static void BM_Humanoid_Fixed_Topology_Inverse_Dynamics(
+    benchmark::State& state)
+{
+  runFixedTopologyInverseDynamics<HumanoidFeatherstone>(
+      state, createHumanoid());
+}
+BENCHMARK(BM_Humanoid_Fixed_Topology_Inverse_Dynamics);
+
+static void BM_Humanoid_DART_Mass_Matrix(benchmark::State& state)
+{
+  SkeletonPtr humanoid = createHumanoid();
+  Eigen::VectorXs pos = humanoid->getPositions();
+
+  for (auto _ : state)
+  {
+    // Setting the positions dirties the cached mass matrix
+    humanoid->setPositions(pos);
+    benchmark::DoNotOptimize(humanoid->getMassMatrix());
+  }
+}
+BENCHMARK(BM_Humanoid_DART_Mass_Matrix);
+
+static void BM_Humanoid_Fixed_Topology_Mass_Matrix(benchmark::State& state)
+{
+  runFixedTopologyMassMatrix<HumanoidFeatherstone>(state, createHumanoid());
+}
+BENCHMARK(BM_Humanoid_Fixed_Topology_Mass_Matrix);
+
 BENCHMARK_MAIN();
\ No newline at end of file
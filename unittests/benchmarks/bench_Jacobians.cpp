@@ -288,7 +288,7 @@ static void BM_Jumpworm_Finite_Difference(benchmark::State& state)
 // Register the function as a benchmark
 BENCHMARK(BM_Jumpworm_Finite_Difference);
 
-static void BM_Atlas(benchmark::State& state)
+WorldPtr createAtlasWorld()
 {
   // Create a world
   std::shared_ptr<simulation::World> world = simulation::World::create();
@@ -309,6 +309,13 @@ static void BM_Atlas(benchmark::State& state)
   atlas->setPosition(0, -0.5 * dart::math::constantsd::pi());
   atlas->setPosition(4, -0.01);
 
+  return world;
+}
+
+static void BM_Atlas(benchmark::State& state)
+{
+  WorldPtr world = createAtlasWorld();
+
   for (auto _ : state)
   {
     std::shared_ptr<BackpropSnapshot> snapshot
@@ -323,6 +330,61 @@ static void BM_Atlas(benchmark::State& state)
 // Register the function as a benchmark
 BENCHMARK(BM_Atlas);
 
+/// This times a single step of backprop, starting from the same state every
+/// iteration. With `useVJPs`, the snapshot never assembles the step Jacobians.
+/// The forward pass isn't timed, only backprop() on a fresh snapshot, since the
+/// snapshot caches the Jacobians it builds.
+static void benchmarkBackprop(
+    benchmark::State& state, WorldPtr world, bool useVJPs)
+{
+  world->setUseVJPBackprop(useVJPs);
+
+  Eigen::VectorXs pos = world->getPositions();
+  Eigen::VectorXs vel = world->getVelocities();
+
+  LossGradient nextTimestepLoss;
+  nextTimestepLoss.lossWrtPosition = Eigen::VectorXs::Ones(world->getNumDofs());
+  nextTimestepLoss.lossWrtVelocity = Eigen::VectorXs::Ones(world->getNumDofs());
+  LossGradient thisTimestepLoss;
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    world->setPositions(pos);
+    world->setVelocities(vel);
+    std::shared_ptr<BackpropSnapshot> snapshot
+        = neural::forwardPass(world, true);
+    state.ResumeTiming();
+
+    snapshot->backprop(world, thisTimestepLoss, nextTimestepLoss);
+    benchmark::DoNotOptimize(thisTimestepLoss.lossWrtPosition.data());
+  }
+}
+
+static void BM_Jumpworm_Backprop(benchmark::State& state)
+{
+  benchmarkBackprop(state, createJumpwormWorld(), false);
+}
+BENCHMARK(BM_Jumpworm_Backprop);
+
+static void BM_Jumpworm_Backprop_VJP(benchmark::State& state)
+{
+  benchmarkBackprop(state, createJumpwormWorld(), true);
+}
+BENCHMARK(BM_Jumpworm_Backprop_VJP);
+
+static void BM_Atlas_Backprop(benchmark::State& state)
+{
+  benchmarkBackprop(state, createAtlasWorld(), false);
+}
+BENCHMARK(BM_Atlas_Backprop);
+
+static void BM_Atlas_Backprop_VJP(benchmark::State& state)
+{
+  benchmarkBackprop(state, createAtlasWorld(), true);
+}
+BENCHMARK(BM_Atlas_Backprop_VJP);
+
 /*
 static void BM_Atlas_Finite_Difference(benchmark::State& state)
 {
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/common/WorkStealingPool.hpp"
+#include "dart/neural/ClampingFactorizationCache.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/IPOptOptimizer.hpp"
+#include "dart/trajectory/LossFn.hpp"
+#include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+#include "dart/utils/UniversalLoader.hpp"
+
+using namespace dart;
+using namespace simulation;
+using namespace trajectory;
+
+// Every shot is this many timesteps long, so the number of shots sets the
+// length of the trajectory
+static const int kShotLength = 10;
+
+// We only time a few IPOPT iterations, since we care about how fast each one
+// is rather than how well they converge
+static const int kIterationLimit = 5;
+
+static std::shared_ptr<World> loadHalfCheetah()
+{
+  std::shared_ptr<World> world = utils::UniversalLoader::loadWorld(
+      "dart://sample/skel/half_cheetah.skel");
+  world->setPositions(Eigen::VectorXs::Zero(world->getNumDofs()));
+  world->setVelocities(Eigen::VectorXs::Zero(world->getNumDofs()));
+  Eigen::VectorXs forceLimits
+      = Eigen::VectorXs::Ones(world->getNumDofs()) * 100;
+  forceLimits(0) = 0;
+  forceLimits(1) = 0;
+  world->setControlForceUpperLimits(forceLimits);
+  world->setControlForceLowerLimits(-1 * forceLimits);
+  return world;
+}
+
+static std::shared_ptr<World> loadKR5()
+{
+  std::shared_ptr<World> world = World::create();
+  world->setGravity(Eigen::Vector3s(0.0, -9.81, 0.0));
+  utils::UniversalLoader::loadSkeleton(
+      world.get(), "dart://sample/urdf/KR5/KR5 sixx R650.urdf");
+  const int dofs = world->getNumDofs();
+  world->setPositionUpperLimits(Eigen::VectorXs::Ones(dofs) * 5);
+  world->setPositionLowerLimits(Eigen::VectorXs::Ones(dofs) * -5);
+  world->setControlForceUpperLimits(Eigen::VectorXs::Ones(dofs) * 20);
+  world->setControlForceLowerLimits(Eigen::VectorXs::Ones(dofs) * -20);
+  world->setVelocityUpperLimits(Eigen::VectorXs::Ones(dofs) * 20);
+  world->setVelocityLowerLimits(Eigen::VectorXs::Ones(dofs) * -20);
+  return world;
+}
+
+/// This runs kIterationLimit IPOPT iterations on a MultiShot with
+/// state.range(0) shots, with parallel operations on if state.range(1) is 1,
+/// and reports IPOPT iterations per second
+static void optimizeMultiShot(
+    benchmark::State& state, std::shared_ptr<World> world)
+{
+  const int numShots = state.range(0);
+  const bool parallel = state.range(1) == 1;
+
+  // Drive the final pose towards an arbitrary target, so there's a gradient
+  const Eigen::VectorXs target
+      = Eigen::VectorXs::Ones(world->getNumDofs()) * 0.5;
+  LossFn loss([target](const TrajectoryRollout* rollout) {
+    const Eigen::VectorXs lastPos
+        = rollout->getPosesConst().col(rollout->getPosesConst().cols() - 1);
+    return (lastPos - target).squaredNorm();
+  });
+
+  const Eigen::VectorXs startPos = world->getPositions();
+  const Eigen::VectorXs startVel = world->getVelocities();
+
+  // Clones of the world share its cache, so this counts every shot's lookups
+  std::shared_ptr<neural::ClampingFactorizationCache> cache
+      = world->getClampingFactorizationCache();
+  cache->clear();
+
+  long iterations = 0;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    world->setPositions(startPos);
+    world->setVelocities(startVel);
+    std::shared_ptr<MultiShot> shot = std::make_shared<MultiShot>(
+        world, loss, numShots * kShotLength, kShotLength, false);
+    shot->setParallelOperationsEnabled(parallel);
+
+    IPOptOptimizer optimizer;
+    optimizer.setLBFGSHistoryLength(5);
+    optimizer.setIterationLimit(kIterationLimit);
+    optimizer.setSilenceOutput(true);
+    optimizer.setSuppressOutput(true);
+    optimizer.setRecordIterations(false);
+    optimizer.registerIntermediateCallback(
+        [&](Problem* /* problem */,
+            int /* step */,
+            s_t /* primal */,
+            s_t /* dual */) {
+          iterations++;
+          return true;
+        });
+    state.ResumeTiming();
+
+    optimizer.optimize(shot.get());
+  }
+
+  state.counters["iterations/s"]
+      = benchmark::Counter(iterations, benchmark::Counter::kIsRate);
+  state.counters["threads"]
+      = common::WorkStealingPool::getGlobalPool()->getNumThreads();
+
+  const double lookups = std::max(
+      cache->getNumHits() + cache->getNumWarmStarts() + cache->getNumMisses(),
+      1L);
+  state.counters["factorization_hit_rate"] = cache->getNumHits() / lookups;
+  state.counters["factorization_warm_start_rate"]
+      = cache->getNumWarmStarts() / lookups;
+  state.counters["factorization_miss_rate"] = cache->getNumMisses() / lookups;
+  state.counters["factorization_warm_start_fallbacks"]
+      = cache->getNumWarmStartFallbacks();
+}
+
+/// This solves a 4-shot MultiShot to convergence (or 100 IPOPT iterations),
+/// using the Gauss-Newton Hessian if state.range(0) is 1, and L-BFGS
+/// otherwise. It reports how many iterations each solve took, so it can be
+/// read alongside the wall clock.
+static void solveMultiShot(
+    benchmark::State& state, std::shared_ptr<World> world)
+{
+  const bool useHessian = state.range(0) == 1;
+  const int dofs = world->getNumDofs();
+
+  const Eigen::VectorXs target = Eigen::VectorXs::Ones(dofs) * 0.5;
+  LossFn loss(
+      [target](const TrajectoryRollout* rollout) {
+        const Eigen::VectorXs lastPos = rollout->getPosesConst().col(
+            rollout->getPosesConst().cols() - 1);
+        return (lastPos - target).squaredNorm();
+      },
+      [target](
+          const TrajectoryRollout* rollout,
+          /* OUT */ TrajectoryRollout* gradWrtRollout) {
+        const int last = rollout->getPosesConst().cols() - 1;
+        const Eigen::VectorXs lastPos = rollout->getPosesConst().col(last);
+        gradWrtRollout->getPoses().setZero();
+        gradWrtRollout->getVels().setZero();
+        gradWrtRollout->getControlForces().setZero();
+        gradWrtRollout->getMasses().setZero();
+        gradWrtRollout->getPoses().col(last) = 2 * (lastPos - target);
+        return (lastPos - target).squaredNorm();
+      },
+      [dofs](const TrajectoryRollout* rollout) {
+        std::vector<Eigen::MatrixXs> hessians(
+            rollout->getPosesConst().cols(),
+            Eigen::MatrixXs::Zero(3 * dofs, 3 * dofs));
+        hessians.back().topLeftCorner(dofs, dofs)
+            = 2 * Eigen::MatrixXs::Identity(dofs, dofs);
+        return hessians;
+      });
+
+  const Eigen::VectorXs startPos = world->getPositions();
+  const Eigen::VectorXs startVel = world->getVelocities();
+
+  long iterations = 0;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    world->setPositions(startPos);
+    world->setVelocities(startVel);
+    std::shared_ptr<MultiShot> shot = std::make_shared<MultiShot>(
+        world, loss, 4 * kShotLength, kShotLength, false);
+
+    IPOptOptimizer optimizer;
+    optimizer.setLBFGSHistoryLength(5);
+    optimizer.setIterationLimit(100);
+    optimizer.setUseGaussNewtonHessian(useHessian);
+    optimizer.setSilenceOutput(true);
+    optimizer.setSuppressOutput(true);
+    optimizer.setRecordIterations(false);
+    optimizer.registerIntermediateCallback(
+        [&](Problem* /* problem */,
+            int /* step */,
+            s_t /* primal */,
+            s_t /* dual */) {
+          iterations++;
+          return true;
+        });
+    state.ResumeTiming();
+
+    optimizer.optimize(shot.get());
+  }
+
+  state.counters["iterations"] = benchmark::Counter(
+      iterations, benchmark::Counter::kAvgIterations);
+}
+
+static void BM_HalfCheetah_MultiShot(benchmark::State& state)
+{
+  optimizeMultiShot(state, loadHalfCheetah());
+}
+BENCHMARK(BM_HalfCheetah_MultiShot)
+    ->ArgsProduct({{2, 4, 8, 16, 32}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_KR5_MultiShot(benchmark::State& state)
+{
+  optimizeMultiShot(state, loadKR5());
+}
+BENCHMARK(BM_KR5_MultiShot)
+    ->ArgsProduct({{2, 4, 8, 16, 32}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_HalfCheetah_MultiShot_Solve(benchmark::State& state)
+{
+  solveMultiShot(state, loadHalfCheetah());
+}
+BENCHMARK(BM_HalfCheetah_MultiShot_Solve)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_KR5_MultiShot_Solve(benchmark::State& state)
+{
+  solveMultiShot(state, loadKR5());
+}
+BENCHMARK(BM_KR5_MultiShot_Solve)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
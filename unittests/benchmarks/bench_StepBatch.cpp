@@ -0,0 +1,96 @@
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/simulation/World.hpp"
+#include "dart/utils/UniversalLoader.hpp"
+
+using namespace dart;
+using namespace simulation;
+
+static std::shared_ptr<World> loadCartpole()
+{
+  std::shared_ptr<World> world = World::create();
+  utils::UniversalLoader::loadSkeleton(
+      world.get(), "dart://sample/urdf/cartpole.urdf");
+  return world;
+}
+
+static std::shared_ptr<World> loadHalfCheetah()
+{
+  return utils::UniversalLoader::loadWorld(
+      "dart://sample/skel/half_cheetah.skel");
+}
+
+/// Random states near the world's starting state, like a batch of RL envs
+static Eigen::MatrixXs randomStates(std::shared_ptr<World> world, int n)
+{
+  Eigen::MatrixXs states = Eigen::MatrixXs::Zero(world->getStateSize(), n);
+  for (int i = 0; i < n; i++)
+  {
+    states.col(i) = world->getState()
+                    + Eigen::VectorXs::Random(world->getStateSize()) * 0.01;
+  }
+  return states;
+}
+
+/// This is what stepping a batch from Python looks like today
+static void stepLoop(benchmark::State& state, std::shared_ptr<World> world)
+{
+  const int n = state.range(0);
+  Eigen::MatrixXs states = randomStates(world, n);
+  Eigen::MatrixXs actions = Eigen::MatrixXs::Random(world->getActionSize(), n);
+  Eigen::MatrixXs nextStates = Eigen::MatrixXs::Zero(states.rows(), n);
+  for (auto _ : state)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      world->setState(states.col(i));
+      world->setAction(actions.col(i));
+      world->step();
+      nextStates.col(i) = world->getState();
+    }
+    benchmark::DoNotOptimize(nextStates);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void stepBatch(benchmark::State& state, std::shared_ptr<World> world)
+{
+  const int n = state.range(0);
+  Eigen::MatrixXs states = randomStates(world, n);
+  Eigen::MatrixXs actions = Eigen::MatrixXs::Random(world->getActionSize(), n);
+  for (auto _ : state)
+  {
+    Eigen::MatrixXs nextStates = world->stepBatch(states, actions);
+    benchmark::DoNotOptimize(nextStates);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_Cartpole_StepLoop(benchmark::State& state)
+{
+  stepLoop(state, loadCartpole());
+}
+BENCHMARK(BM_Cartpole_StepLoop)->Arg(64)->Arg(1024);
+
+static void BM_Cartpole_StepBatch(benchmark::State& state)
+{
+  stepBatch(state, loadCartpole());
+}
+BENCHMARK(BM_Cartpole_StepBatch)->Arg(64)->Arg(1024)->UseRealTime();
+
+static void BM_HalfCheetah_StepLoop(benchmark::State& state)
+{
+  stepLoop(state, loadHalfCheetah());
+}
+BENCHMARK(BM_HalfCheetah_StepLoop)->Arg(64)->Arg(1024);
+
+static void BM_HalfCheetah_StepBatch(benchmark::State& state)
+{
+  stepBatch(state, loadHalfCheetah());
+}
+BENCHMARK(BM_HalfCheetah_StepBatch)->Arg(64)->Arg(1024)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/biomechanics/CortexStreaming.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/biomechanics/StreamingIK.hpp"
+#include "dart/external/cortex/cortex_intern.h"
+#include "dart/performance/PerformanceLog.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+// We stream this many frames per run, at a fixed rate, like Cortex would
+static const int kNumFrames = 300;
+static const int kFramesPerSecond = 100;
+
+/// This streams kNumFrames frames of a recorded trial through the Cortex
+/// packet encoder and parser, into a StreamingIK at kFramesPerSecond. The
+/// solver runs in real time mode with a budget of state.range(0) microseconds
+/// per frame, or free running if that's 0. It reports the latency from marker
+/// arrival to the first pose published after it, along with how many frames
+/// were solved and dropped.
+static void BM_StreamingIK_Latency(benchmark::State& state)
+{
+  OpenSimFile standard = OpenSimParser::parseOsim(
+      "dart://sample/osim/IncompleteIK/Models/"
+      "optimized_scale_and_markers.osim");
+  OpenSimTRC trc = OpenSimParser::loadTRC(
+      "dart://sample/osim/IncompleteIK/MarkerData/markers_smpl.trc");
+
+  // Stream every model marker that the trial has, in a fixed order, so the
+  // Cortex body defs never change from frame to frame
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  std::vector<std::string> markerNames;
+  std::map<std::string, int> markerNameToClass;
+  for (auto& pair : standard.markersMap)
+  {
+    if (trc.markerLines.count(pair.first) == 0)
+    {
+      continue;
+    }
+    markerNameToClass[pair.first]
+        = standard.skeleton->getNumBodyNodes() + markers.size();
+    markers.push_back(pair.second);
+    markerNames.push_back(pair.first);
+  }
+  const int numFrames = std::min<int>(kNumFrames, trc.timestamps.size());
+  auto getFrame = [&](int t) {
+    std::vector<Eigen::Vector3s> poses;
+    for (const std::string& name : markerNames)
+    {
+      poses.push_back(trc.markerLines.at(name)[t]);
+    }
+    return poses;
+  };
+
+  performance::PerformanceHistogram latencies;
+  long solved = 0;
+  long dropped = 0;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    StreamingIK ik(standard.skeleton, markers);
+    ik.setRealTimeMode(state.range(0));
+    ik.startSolverThread();
+
+    CortexStreaming server("127.0.0.1");
+    CortexStreaming receiver("127.0.0.1");
+    long timestamp = 0;
+    receiver.setFrameHandler(
+        [&](std::vector<std::string> names,
+            std::vector<Eigen::Vector3s> poses,
+            std::vector<Eigen::MatrixXs> copTorqueForces) {
+          (void)copTorqueForces;
+          std::vector<int> classes;
+          for (const std::string& name : names)
+          {
+            classes.push_back(markerNameToClass.at(name));
+          }
+          std::vector<Eigen::Vector9s> noForces;
+          ik.observeMarkers(poses, classes, timestamp, noForces);
+        });
+
+    sockaddr_in address;
+    sPacket packet;
+    server.mockServerSetData(
+        markerNames, getFrame(0), std::vector<Eigen::MatrixXs>());
+    std::vector<unsigned char> bodyDefs
+        = server.createBodyDefsPacket(server.getCurrentBodyDefs());
+    memcpy(&packet, bodyDefs.data(), bodyDefs.size());
+    receiver.parseCortexPacket(&packet, address, false);
+    state.ResumeTiming();
+
+    std::chrono::steady_clock::time_point nextFrame
+        = std::chrono::steady_clock::now();
+    for (int t = 0; t < numFrames; t++)
+    {
+      server.mockServerSetData(
+          markerNames, getFrame(t), std::vector<Eigen::MatrixXs>());
+      std::vector<unsigned char> frame
+          = server.createFrameOfDataPacket(server.getCurrentFrameOfData());
+      memcpy(&packet, frame.data(), frame.size());
+      timestamp = t * 1000 / kFramesPerSecond;
+      receiver.parseCortexPacket(&packet, address, true);
+
+      nextFrame += std::chrono::microseconds(1000000 / kFramesPerSecond);
+      std::this_thread::sleep_until(nextFrame);
+    }
+
+    // Percentiles are reported from the last run, since they don't average
+    latencies = ik.getLatencyHistogram();
+    solved += ik.getNumFramesSolved();
+    dropped += ik.getNumFramesDropped();
+  }
+
+  state.counters["p50_us"] = latencies.getPercentile(0.5);
+  state.counters["p99_us"] = latencies.getPercentile(0.99);
+  state.counters["max_us"] = latencies.getMax();
+  state.counters["solved"]
+      = benchmark::Counter(solved, benchmark::Counter::kAvgIterations);
+  state.counters["dropped"]
+      = benchmark::Counter(dropped, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_StreamingIK_Latency)
+    ->Arg(0)
+    ->Arg(2000)
+    ->Arg(5000)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
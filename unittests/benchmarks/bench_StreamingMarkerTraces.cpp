@@ -0,0 +1,70 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/biomechanics/StreamingMarkerTraces.hpp"
+#include "dart/math/MathTypes.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+/// This streams a noisy cloud of state.range(0) markers into
+/// StreamingMarkerTraces, and reports the latency of each observeMarkers()
+/// call. The markers are scattered through a 2m x 2m x 1m volume, roughly the
+/// density of a few subjects in a capture volume, and each one drifts a bit
+/// every frame.
+static void BM_StreamingMarkerTraces_ObserveMarkers(benchmark::State& state)
+{
+  const int numMarkers = state.range(0);
+  // Frames are 10ms apart, like a 100Hz Cortex stream
+  const long frameMillis = 10;
+
+  srand(42);
+  std::vector<Eigen::Vector3s> markers;
+  std::vector<Eigen::Vector3s> velocities;
+  for (int i = 0; i < numMarkers; i++)
+  {
+    markers.push_back(
+        (Eigen::Vector3s::Random() + Eigen::Vector3s::Ones())
+            .cwiseProduct(Eigen::Vector3s(1.0, 0.5, 1.0)));
+    // Up to 1m/s, in meters per millisecond
+    velocities.push_back(Eigen::Vector3s::Random() * 0.001);
+  }
+
+  StreamingMarkerTraces traces(20, 10);
+  long now = 0;
+  // Warm up the traces, so we're timing the steady state
+  for (int t = 0; t < 10; t++)
+  {
+    traces.observeMarkers(markers, now);
+    for (int i = 0; i < numMarkers; i++)
+    {
+      markers[i] += velocities[i] * frameMillis;
+    }
+    now += frameMillis;
+  }
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    std::vector<Eigen::Vector3s> noisy = markers;
+    for (int i = 0; i < numMarkers; i++)
+    {
+      markers[i] += velocities[i] * frameMillis;
+      noisy[i] += Eigen::Vector3s::Random() * 0.002;
+    }
+    now += frameMillis;
+    state.ResumeTiming();
+
+    auto result = traces.observeMarkers(noisy, now);
+    benchmark::DoNotOptimize(result.first.data());
+  }
+
+  state.counters["traces"] = traces.getNumTraces();
+}
+BENCHMARK(BM_StreamingMarkerTraces_ObserveMarkers)
+    ->RangeMultiplier(2)
+    ->Range(16, 1024)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
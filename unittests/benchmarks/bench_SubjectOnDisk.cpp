@@ -0,0 +1,68 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/biomechanics/SubjectOnDisk.hpp"
+#include "dart/utils/CompositeResourceRetriever.hpp"
+#include "dart/utils/DartResourceRetriever.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+static std::string getSubjectPath()
+{
+  auto retriever = std::make_shared<utils::CompositeResourceRetriever>();
+  retriever->addSchemaRetriever("dart", utils::DartResourceRetriever::create());
+  return retriever->getFilePath("dart://sample/b3d/results.b3d");
+}
+
+/// This mimics what a training data loader does: read a short window from
+/// every trial on the subject, walking the window start forward each time.
+static void readWindowsAcrossTrials(
+    SubjectOnDisk& subject, int& cursor, benchmark::State& state)
+{
+  const int windowSize = state.range(0);
+  for (int trial = 0; trial < subject.getNumTrials(); trial++)
+  {
+    const int len = subject.getTrialLength(trial);
+    if (len <= windowSize)
+      continue;
+    const int start = cursor % (len - windowSize);
+    std::vector<std::shared_ptr<Frame>> frames
+        = subject.readFrames(trial, start, windowSize);
+    benchmark::DoNotOptimize(frames);
+  }
+  cursor += 7;
+}
+
+static void BM_SubjectOnDisk_ReadFrames_Buffered(benchmark::State& state)
+{
+  SubjectOnDisk subject(getSubjectPath());
+  int cursor = 0;
+  for (auto _ : state)
+  {
+    readWindowsAcrossTrials(subject, cursor, state);
+  }
+}
+BENCHMARK(BM_SubjectOnDisk_ReadFrames_Buffered)->Arg(1)->Arg(10)->Arg(50);
+
+static void BM_SubjectOnDisk_ReadFrames_MemoryMapped(benchmark::State& state)
+{
+  SubjectOnDisk subject(getSubjectPath());
+  if (!subject.setUseMemoryMap(true))
+  {
+    state.SkipWithError("Unable to memory map the subject");
+    return;
+  }
+  int cursor = 0;
+  for (auto _ : state)
+  {
+    readWindowsAcrossTrials(subject, cursor, state);
+  }
+}
+BENCHMARK(BM_SubjectOnDisk_ReadFrames_MemoryMapped)->Arg(1)->Arg(10)->Arg(50);
+
+BENCHMARK_MAIN();
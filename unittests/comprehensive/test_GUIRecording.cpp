@@ -152,3 +152,164 @@ TEST(RECORDING, GUI_SERVER)
   // recording.saveFramesJson("./atlas_recording.json");
 }
 #endif
+
+TEST(RECORDING, STREAMED_KEYFRAMES_RECREATE_FRAMES)
+{
+  const std::string path = "./streamed_recording_test.bin";
+
+  GUIRecording recording;
+  recording.createBox(
+      "box",
+      Eigen::Vector3s::Ones(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+  ASSERT_TRUE(recording.startStreaming(path, 4));
+  for (int i = 0; i < 10; i++)
+  {
+    recording.setObjectPosition("box", Eigen::Vector3s::UnitX() * i);
+    if (i == 6)
+    {
+      recording.createSphere("sphere", 1.0, Eigen::Vector3s::Zero());
+    }
+    recording.saveFrame();
+  }
+  EXPECT_EQ(recording.getNumFrames(), 0);
+  EXPECT_EQ(recording.getNumStreamedFrames(), 10);
+  recording.finishStreaming();
+  EXPECT_FALSE(recording.isStreaming());
+
+  ASSERT_EQ(GUIRecording::readNumStreamedFrames(path), 10);
+  const int boxKey = recording.getStringCode("box");
+  const int sphereKey = recording.getStringCode("sphere");
+  for (int i = 0; i < 10; i++)
+  {
+    proto::CommandList list;
+    ASSERT_TRUE(
+        list.ParseFromString(GUIRecording::readStreamedFrameJson(path, i)));
+    ASSERT_GT(list.command_size(), 0);
+    EXPECT_TRUE(list.command(0).has_clear_all());
+
+    // Replay the commands, and check that they leave the GUI how it was on
+    // frame i
+    s_t boxX = -1;
+    bool hasSphere = false;
+    for (const proto::Command& command : list.command())
+    {
+      if (command.has_clear_all())
+      {
+        boxX = -1;
+        hasSphere = false;
+      }
+      if (command.has_box() && command.box().key() == boxKey)
+        boxX = command.box().data(3);
+      if (command.has_set_object_position()
+          && command.set_object_position().key() == boxKey)
+        boxX = command.set_object_position().data(0);
+      if (command.has_sphere() && command.sphere().key() == sphereKey)
+        hasSphere = true;
+    }
+    EXPECT_EQ(boxX, i);
+    EXPECT_EQ(hasSphere, i >= 6);
+  }
+  EXPECT_EQ(GUIRecording::readStreamedFrameJson(path, 10), "");
+  EXPECT_EQ(GUIRecording::readNumStreamedFrames("./does_not_exist.bin"), -1);
+
+  std::remove(path.c_str());
+}
+
+TEST(RECORDING, NON_KEYFRAMED_REPLAY_WITH_SKIPPED_FRAMES)
+{
+  GUIRecording recording;
+  recording.createBox(
+      "moving",
+      Eigen::Vector3s::Ones(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+  recording.createBox(
+      "still",
+      Eigen::Vector3s::Ones(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+  recording.saveFrame();
+  // Like renderSkeleton(), we set every pose on every frame, even though
+  // "still" only moves once
+  for (int i = 1; i < 10; i++)
+  {
+    recording.setObjectPosition("moving", Eigen::Vector3s::UnitX() * i);
+    recording.setObjectPosition(
+        "still", Eigen::Vector3s::UnitX() * (i < 4 ? 3 : 5));
+    recording.saveFrame();
+  }
+  ASSERT_EQ(recording.getNumFrames(), 10);
+  const int movingKey = recording.getStringCode("moving");
+  const int stillKey = recording.getStringCode("still");
+
+  // Without keyframes, the viewer only applies the commands of the frame it
+  // jumps to, so skipping ahead or looping back needs every pose in that frame
+  s_t movingX = 0;
+  s_t stillX = 0;
+  for (int frame : {3, 7, 9, 2, 5})
+  {
+    proto::CommandList list;
+    ASSERT_TRUE(list.ParseFromString(recording.getFrameJson(frame)));
+    for (const proto::Command& command : list.command())
+    {
+      if (!command.has_set_object_position())
+        continue;
+      if (command.set_object_position().key() == movingKey)
+        movingX = command.set_object_position().data(0);
+      if (command.set_object_position().key() == stillKey)
+        stillX = command.set_object_position().data(0);
+    }
+    EXPECT_EQ(movingX, frame);
+    EXPECT_EQ(stillX, frame < 4 ? 3 : 5);
+  }
+}
+
+TEST(RECORDING, COALESCES_OBJECT_UPDATES)
+{
+  GUIRecording recording;
+  recording.setCoalesceObjectUpdates(true);
+  recording.createBox(
+      "box",
+      Eigen::Vector3s::Ones(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+  recording.saveFrame();
+  const int boxKey = recording.getStringCode("box");
+
+  // Only the last of several updates between frames is sent
+  recording.setObjectPosition("box", Eigen::Vector3s(1, 0, 0));
+  recording.setObjectPosition("box", Eigen::Vector3s(2, 0, 0));
+  recording.saveFrame();
+  // Setting the value we already sent doesn't send anything
+  recording.setObjectPosition("box", Eigen::Vector3s(2, 0, 0));
+  recording.saveFrame();
+  // Changes within the tolerance aren't sent, but they add up
+  recording.setChangeTolerance(0.1);
+  recording.setObjectPosition("box", Eigen::Vector3s(2.06, 0, 0));
+  recording.saveFrame();
+  recording.setObjectPosition("box", Eigen::Vector3s(2.12, 0, 0));
+  recording.saveFrame();
+  // Updates to an object that's deleted before the next frame are dropped
+  recording.setObjectPosition("box", Eigen::Vector3s(5, 0, 0));
+  recording.deleteObject("box");
+  recording.saveFrame();
+
+  ASSERT_EQ(recording.getNumFrames(), 6);
+  std::vector<proto::CommandList> frames(6);
+  for (int i = 0; i < 6; i++)
+  {
+    ASSERT_TRUE(frames[i].ParseFromString(recording.getFrameJson(i)));
+  }
+
+  ASSERT_EQ(frames[1].command_size(), 1);
+  EXPECT_EQ(frames[1].command(0).set_object_position().key(), boxKey);
+  EXPECT_EQ(frames[1].command(0).set_object_position().data(0), 2.0);
+  EXPECT_EQ(frames[2].command_size(), 0);
+  EXPECT_EQ(frames[3].command_size(), 0);
+  ASSERT_EQ(frames[4].command_size(), 1);
+  EXPECT_NEAR(frames[4].command(0).set_object_position().data(0), 2.12, 1e-6);
+  ASSERT_EQ(frames[5].command_size(), 1);
+  EXPECT_TRUE(frames[5].command(0).has_delete_object());
+}
@@ -820,4 +820,26 @@ TEST(TRAJECTORY, JUMP_WORM)
       std::cout << "Off on force-vel Jac at step " << i << std::endl;
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(TRAJECTORY, BALANCED_SHOT_CHUNKS)
+{
+  WorldPtr world = World::create();
+  SkeletonPtr pendulum = Skeleton::create("pendulum");
+  pendulum->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  world->addSkeleton(pendulum);
+
+  // This gives shots of 10, 10, 10, 10 and 5 timesteps
+  LossFn lossFn;
+  MultiShot shot(world, lossFn, 45, 10, false);
+
+  // One chunk gets everything
+  EXPECT_EQ(shot.getBalancedShotChunks(0, 1), std::vector<int>({0, 5}));
+  // Asking for more chunks than shots gives one shot per chunk
+  EXPECT_EQ(
+      shot.getBalancedShotChunks(0, 100), std::vector<int>({0, 1, 2, 3, 4, 5}));
+  // Shots 1-4 have 35 timesteps, and the first chunk stops once it has half
+  EXPECT_EQ(shot.getBalancedShotChunks(1, 2), std::vector<int>({1, 3, 5}));
+  // No shots means no chunks
+  EXPECT_EQ(shot.getBalancedShotChunks(5, 2), std::vector<int>({5}));
+}
@@ -4,10 +4,15 @@
 
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BatchedFeatherstone.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FixedTopologyFeatherstone.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/SimpleFeatherstone.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/UniversalJoint.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
@@ -17,6 +22,7 @@
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
 #include "dart/simulation/World.hpp"
+#include "dart/utils/SkelParser.hpp"
 
 #include "GradientTestUtils.hpp"
 #include "TestHelpers.hpp"
@@ -142,6 +148,157 @@ TEST(FEATHERSTONE, LINK_5)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, BATCHED_MATCHES_SIMPLE)
+{
+  SkeletonPtr arm = createMultiarmRobot(5, 0.2);
+  dynamics::SimpleFeatherstone simple;
+  simple.populateFromSkeleton(arm);
+  dynamics::BatchedFeatherstone batched(simple);
+
+  // Not a multiple of the lane width, so the last batch is partially full
+  const int numInstances = 2 * BatchedFeatherstone::kLanes + 3;
+  Eigen::MatrixXs pos = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs vel = Eigen::MatrixXs::Random(simple.len(), numInstances);
+  Eigen::MatrixXs force = Eigen::MatrixXs::Random(simple.len(), numInstances);
+
+  Eigen::MatrixXs batchedAccel = batched.forwardDynamics(pos, vel, force);
+  for (int i = 0; i < numInstances; i++)
+  {
+    Eigen::VectorXs p = pos.col(i);
+    Eigen::VectorXs v = vel.col(i);
+    Eigen::VectorXs f = force.col(i);
+    Eigen::VectorXs simpleAccel = Eigen::VectorXs::Zero(simple.len());
+    simple.forwardDynamics(p.data(), v.data(), f.data(), simpleAccel.data());
+    Eigen::VectorXs col = batchedAccel.col(i);
+    EXPECT_TRUE(equals(simpleAccel, col, 1e-10));
+  }
+
+  Eigen::MatrixXs batchedForce
+      = batched.inverseDynamics(pos, vel, batchedAccel);
+  EXPECT_TRUE(equals(force, batchedForce, 1e-8));
+}
+#endif
+
+template <typename FixedTopology>
+void verifyFixedTopology(SkeletonPtr skel)
+{
+  FixedTopology fixed;
+  ASSERT_TRUE(fixed.populateFromSkeleton(skel))
+      << "Expected type " << getFixedTopologyFeatherstoneType(skel);
+
+  typename FixedTopology::VectorDofs pos;
+  typename FixedTopology::VectorDofs vel;
+  typename FixedTopology::VectorDofs force;
+  typename FixedTopology::VectorDofs accel;
+  typename FixedTopology::VectorDofs inverseForce;
+  typename FixedTopology::MatrixDofs massMatrix;
+
+  for (int j = 0; j < 10; j++)
+  {
+    skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()));
+    skel->setVelocities(Eigen::VectorXs::Random(skel->getNumDofs()));
+    skel->setControlForces(Eigen::VectorXs::Random(skel->getNumDofs()));
+
+    pos = skel->getPositions();
+    vel = skel->getVelocities();
+    force = skel->getControlForces();
+
+    fixed.forwardDynamics(pos, vel, force, accel);
+    skel->computeForwardDynamics();
+    Eigen::VectorXs realAccel = skel->getAccelerations();
+    Eigen::VectorXs fixedAccel = accel;
+    if (!equals(fixedAccel, realAccel, 1e-8))
+    {
+      std::cout << "Expected acceleration: " << std::endl
+                << realAccel << std::endl;
+      std::cout << "Got acceleration: " << std::endl
+                << fixedAccel << std::endl;
+    }
+    EXPECT_TRUE(equals(fixedAccel, realAccel, 1e-8));
+
+    fixed.inverseDynamics(pos, vel, accel, inverseForce);
+    Eigen::VectorXs fixedForce = inverseForce;
+    Eigen::VectorXs realForce = force;
+    EXPECT_TRUE(equals(fixedForce, realForce, 1e-8));
+
+    fixed.computeMassMatrix(pos, massMatrix);
+    Eigen::MatrixXs fixedMassMatrix = massMatrix;
+    Eigen::MatrixXs realMassMatrix = skel->getMassMatrix();
+    EXPECT_TRUE(equals(fixedMassMatrix, realMassMatrix, 1e-8));
+  }
+}
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, FIXED_TOPOLOGY_LINK_5)
+{
+  SkeletonPtr arm = createMultiarmRobot(5, 0.2);
+  EXPECT_EQ(
+      getFixedTopologyFeatherstoneType(arm),
+      "dart::dynamics::FixedTopologyFeatherstone<"
+      "dart::dynamics::DofsPerBody<1, 1, 1, 1, 1>, "
+      "dart::dynamics::ParentIndices<-1, 0, 1, 2, 3>>");
+  verifyFixedTopology<FixedTopologyFeatherstone<
+      DofsPerBody<1, 1, 1, 1, 1>,
+      ParentIndices<-1, 0, 1, 2, 3>>>(arm);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, FIXED_TOPOLOGY_MIXED_JOINTS)
+{
+  // A floating base, with a ball joint and a universal joint hanging off of
+  // it, and offsets on both sides of every joint
+  SkeletonPtr skel = Skeleton::create("mixed");
+  std::pair<FreeJoint*, BodyNode*> root
+      = skel->createJointAndBodyNodePair<FreeJoint>();
+  std::pair<BallJoint*, BodyNode*> ball
+      = skel->createJointAndBodyNodePair<BallJoint>(root.second);
+  std::pair<UniversalJoint*, BodyNode*> universal
+      = skel->createJointAndBodyNodePair<UniversalJoint>(ball.second);
+  universal.first->setAxis1(Eigen::Vector3s(1, 0, 0));
+  universal.first->setAxis2(Eigen::Vector3s(0, 1, 1).normalized());
+  std::pair<RevoluteJoint*, BodyNode*> revolute
+      = skel->createJointAndBodyNodePair<RevoluteJoint>(root.second);
+
+  for (Joint* joint : std::vector<Joint*>{
+           root.first, ball.first, universal.first, revolute.first})
+  {
+    Eigen::Isometry3s fromParent = Eigen::Isometry3s::Identity();
+    fromParent.linear() = math::expMapRot(Eigen::Vector3s::Random());
+    fromParent.translation() = Eigen::Vector3s::Random();
+    Eigen::Isometry3s fromChild = Eigen::Isometry3s::Identity();
+    fromChild.linear() = math::expMapRot(Eigen::Vector3s::Random());
+    fromChild.translation() = Eigen::Vector3s::Random();
+    joint->setTransformFromParentBodyNode(fromParent);
+    joint->setTransformFromChildBodyNode(fromChild);
+  }
+  for (int i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    skel->getBodyNode(i)->setMass(1.0 + i);
+    skel->getBodyNode(i)->setLocalCOM(Eigen::Vector3s::Random() * 0.2);
+  }
+
+  verifyFixedTopology<FixedTopologyFeatherstone<
+      DofsPerBody<6, 3, 2, 1>,
+      ParentIndices<-1, 0, 1, 0>>>(skel);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(FEATHERSTONE, FIXED_TOPOLOGY_BIPED)
+{
+  SkeletonPtr biped
+      = utils::SkelParser::readSkeleton("dart://sample/skel/biped.skel");
+  ASSERT_TRUE(biped != nullptr);
+  verifyFixedTopology<FixedTopologyFeatherstone<
+      DofsPerBody<6, 3, 1, 2, 1, 3, 1, 2, 1, 2, 1, 2, 1, 3, 1, 1, 1, 3, 1, 1>,
+      ParentIndices<
+          -1, 0, 1, 2, 3, 0, 5, 6, 7, 0, 9, 10, 10, 12, 13, 14, 10, 16, 17,
+          18>>>(biped);
+}
+#endif
+
 /*
 template <class ConfigSpaceT>
 void GenericJoint<ConfigSpaceT>::addChildArtInertiaImplicitToDynamic(
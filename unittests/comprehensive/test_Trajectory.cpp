@@ -1426,4 +1426,107 @@ TEST(TRAJECTORY, REOPTIMIZATION)
     record->reoptimize();
   }
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, GAUSS_NEWTON_HESSIAN)
+{
+  // With no gravity or contact, two prismatic joints have linear dynamics, so
+  // the Gauss-Newton Hessian of a quadratic loss is exact
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s::Zero());
+
+  SkeletonPtr sled = Skeleton::create("sled");
+  std::pair<PrismaticJoint*, BodyNode*> xPair
+      = sled->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  xPair.first->setAxis(Eigen::Vector3s::UnitX());
+  std::pair<PrismaticJoint*, BodyNode*> yPair
+      = sled->createJointAndBodyNodePair<PrismaticJoint>(xPair.second);
+  yPair.first->setAxis(Eigen::Vector3s::UnitY());
+  world->addSkeleton(sled);
+
+  Eigen::VectorXs target = Eigen::Vector2s(1.0, -0.5);
+  LossFn loss(
+      [target](const TrajectoryRollout* rollout) {
+        return (rollout->getPosesConst().colwise() - target).squaredNorm()
+               + 0.1 * rollout->getVelsConst().squaredNorm()
+               + 0.01 * rollout->getControlForcesConst().squaredNorm();
+      },
+      [target](
+          const TrajectoryRollout* rollout,
+          /* OUT */ TrajectoryRollout* gradWrtRollout) {
+        gradWrtRollout->getMasses().setZero();
+        gradWrtRollout->getPoses()
+            = 2 * (rollout->getPosesConst().colwise() - target);
+        gradWrtRollout->getVels() = 0.2 * rollout->getVelsConst();
+        gradWrtRollout->getControlForces()
+            = 0.02 * rollout->getControlForcesConst();
+        return (rollout->getPosesConst().colwise() - target).squaredNorm()
+               + 0.1 * rollout->getVelsConst().squaredNorm()
+               + 0.01 * rollout->getControlForcesConst().squaredNorm();
+      },
+      [](const TrajectoryRollout* rollout) {
+        Eigen::VectorXs diagonal = Eigen::VectorXs::Zero(6);
+        diagonal << 2, 2, 0.2, 0.2, 0.02, 0.02;
+        return std::vector<Eigen::MatrixXs>(
+            rollout->getPosesConst().cols(), diagonal.asDiagonal());
+      });
+
+  MultiShot shot(world, loss, 12, 4, false);
+  EXPECT_TRUE(shot.hasHessian());
+
+  int dim = shot.getFlatProblemDim(world);
+  int staticDim = dim - shot.getFlatDynamicProblemDim(world);
+  // Shots after the first tune their starting state, and each shot gets one
+  // dense lower triangle over its own variables
+  int firstShot = 4 * 2;
+  int laterShot = 2 * 2 + 4 * 2;
+  EXPECT_EQ(
+      firstShot * (firstShot + 1) / 2 + 2 * laterShot * (laterShot + 1) / 2,
+      shot.getNumberNonZeroHessian(world));
+
+  Eigen::MatrixXs analytical = Eigen::MatrixXs::Zero(dim, dim);
+  shot.getHessian(world, analytical);
+  Eigen::MatrixXs bruteForce = Eigen::MatrixXs::Zero(dim, dim);
+  shot.finiteDifferenceHessian(world, bruteForce);
+
+  // The masses get no second-order terms, so only compare the dynamic part
+  int dynamicDim = dim - staticDim;
+  Eigen::MatrixXs analyticalDynamic
+      = analytical.bottomRightCorner(dynamicDim, dynamicDim);
+  Eigen::MatrixXs bruteForceDynamic
+      = bruteForce.bottomRightCorner(dynamicDim, dynamicDim);
+  if (!equals(analyticalDynamic, bruteForceDynamic, 1e-6))
+  {
+    std::cout << "Analytical Hessian:" << std::endl
+              << analyticalDynamic << std::endl;
+    std::cout << "Brute force Hessian:" << std::endl
+              << bruteForceDynamic << std::endl;
+    std::cout << "Diff:" << std::endl
+              << analyticalDynamic - bruteForceDynamic << std::endl;
+  }
+  EXPECT_TRUE(equals(analyticalDynamic, bruteForceDynamic, 1e-6));
+
+  // Compare against L-BFGS, optimizing from the same starting point
+  std::vector<int> iterations;
+  for (bool useHessian : {false, true})
+  {
+    MultiShot freshShot(world, loss, 12, 4, false);
+    IPOptOptimizer optimizer;
+    optimizer.setIterationLimit(200);
+    optimizer.setLBFGSHistoryLength(5);
+    optimizer.setSuppressOutput(true);
+    optimizer.setUseGaussNewtonHessian(useHessian);
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<Solution> record = optimizer.optimize(&freshShot);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << (useHessian ? "Gauss-Newton" : "L-BFGS") << ": "
+              << record->getNumSteps() << " iterations, "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     end - start)
+                     .count()
+              << "ms" << std::endl;
+    iterations.push_back(record->getNumSteps());
+  }
+  EXPECT_LE(iterations[1], iterations[0]);
+}
+#endif
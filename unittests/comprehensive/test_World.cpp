@@ -255,6 +255,18 @@ TEST(World, Cloning)
   }
 }
 
+//==============================================================================
+TEST(World, CloningKeepsVJPBackprop)
+{
+  WorldPtr world = World::create();
+  EXPECT_FALSE(world->clone()->getUseVJPBackprop());
+
+  world->setUseVJPBackprop(true);
+  WorldPtr clone = world->clone();
+  EXPECT_TRUE(clone->getUseVJPBackprop());
+  EXPECT_TRUE(clone->clone()->getUseVJPBackprop());
+}
+
 //==============================================================================
 TEST(World, ValidatingClones)
 {
@@ -266,6 +266,12 @@ void testAtlas(bool withGroundContact)
   std::cout << "Passed pos" << std::endl;
   EXPECT_TRUE(verifyWrtMass(world));
   std::cout << "Passed mass" << std::endl;
+  // The VJP backprop path has to match the dense one, even though checking the
+  // dense one against finite differences is too slow to do here
+  neural::BackpropSnapshotPtr snapshot = neural::forwardPass(world, true);
+  EXPECT_TRUE(verifyVJPBackprop(
+      world, snapshot, Eigen::VectorXs::Ones(world->getNumDofs() * 2)));
+  std::cout << "Passed VJP backprop" << std::endl;
   std::cout << "Passed everything except backprop" << std::endl;
   // This is outrageously slow
   // EXPECT_TRUE(verifyAnalyticalBackprop(world));
@@ -0,0 +1,103 @@
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/biomechanics/BatchedMarkerIK.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/MathTypes.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+static const std::string kArnoldPrefix
+    = "dart://sample/regression/Arnold2013Synthetic/";
+
+//==============================================================================
+TEST(BatchedMarkerIK, MATCHES_SKELETON_KINEMATICS)
+{
+  OpenSimFile osim = OpenSimParser::parseOsim(
+      kArnoldPrefix + "subject01/subject01.osim");
+  std::shared_ptr<dynamics::Skeleton> skel = osim.skeleton;
+  EXPECT_TRUE(BatchedMarkerIK::isSupported(skel));
+
+  // Scale the skeleton first, so we check that scales get picked up
+  skel->setBodyScales(
+      Eigen::VectorXs::Ones(skel->getNumBodyNodes() * 3)
+      + Eigen::VectorXs::Random(skel->getNumBodyNodes() * 3) * 0.1);
+  BatchedMarkerIK ik(skel, osim.markersMap);
+
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  for (const std::string& name : ik.getMarkerNames())
+  {
+    markers.push_back(osim.markersMap.at(name));
+  }
+
+  for (int i = 0; i < 5; i++)
+  {
+    Eigen::VectorXs pos = skel->getRandomPose();
+    skel->setPositions(pos);
+
+    Eigen::VectorXs expected = skel->getMarkerWorldPositions(markers);
+    Eigen::VectorXs actual = ik.getMarkerWorldPositions(pos);
+    EXPECT_TRUE(equals(actual, expected, 1e-10));
+
+    Eigen::MatrixXs expectedJac
+        = skel->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+    Eigen::MatrixXs actualJac
+        = ik.getMarkerWorldPositionsJacobianWrtJointPositions(pos);
+    if (!equals(actualJac, expectedJac, 1e-8))
+    {
+      std::cout << "Diff:" << std::endl
+                << actualJac - expectedJac << std::endl;
+    }
+    EXPECT_TRUE(equals(actualJac, expectedJac, 1e-8));
+  }
+}
+
+//==============================================================================
+TEST(BatchedMarkerIK, RECOVERS_GOLD_IK)
+{
+  OpenSimFile osim = OpenSimParser::parseOsim(
+      kArnoldPrefix + "subject01/subject01.osim");
+  std::shared_ptr<dynamics::Skeleton> skel = osim.skeleton;
+  OpenSimMot mot = OpenSimParser::loadMot(
+      skel, kArnoldPrefix + "subject01/coordinates.sto");
+
+  BatchedMarkerIK ik(skel, osim.markersMap);
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  for (const std::string& name : ik.getMarkerNames())
+  {
+    markers.push_back(osim.markersMap.at(name));
+  }
+
+  // Synthesize markers from the gold IK, and drop a few of them here and there
+  const int numFrames = std::min<int>(100, mot.poses.cols());
+  Eigen::MatrixXs observations(markers.size() * 3, numFrames);
+  for (int t = 0; t < numFrames; t++)
+  {
+    skel->setPositions(mot.poses.col(t));
+    observations.col(t) = skel->getMarkerWorldPositions(markers);
+    observations.block<3, 1>(((t * 7) % markers.size()) * 3, t)
+        .setConstant(std::numeric_limits<s_t>::quiet_NaN());
+  }
+
+  // The gold IK isn't guaranteed to respect our joint limits
+  ik.setIgnoreJointLimits(true);
+  ik.setMinFramesPerChunk(25);
+  Eigen::VectorXs losses;
+  Eigen::MatrixXs poses = ik.solve(observations, mot.poses.col(0), &losses);
+  EXPECT_EQ(poses.cols(), numFrames);
+  for (int t = 0; t < numFrames; t++)
+  {
+    // Under a millimeter of RMS error on every marker
+    EXPECT_LT(losses(t), markers.size() * 1e-6);
+  }
+}
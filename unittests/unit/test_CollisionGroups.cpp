@@ -31,13 +31,22 @@
  */
 
 #include <iostream>
+#include <thread>
 
 #include <dart/dynamics/SphereShape.hpp>
 #include <gtest/gtest.h>
 
+#include "dart/collision/RaycastResult.hpp"
+#include "dart/collision/dart/DARTCollisionContext.hpp"
+#include "dart/collision/dart/DARTCollisionDetector.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
 #include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/CylinderShape.hpp"
+#include "dart/dynamics/EllipsoidShape.hpp"
 #include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/SimpleFrame.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
 #include "dart/simulation/World.hpp"
@@ -275,3 +284,493 @@ INSTANTIATE_TEST_CASE_P(
     CollisionEngine,
     CollisionGroupsTest,
     testing::Values("dart", "fcl", "bullet", "ode"));
+
+//==============================================================================
+static std::vector<std::shared_ptr<dart::dynamics::SimpleFrame>>
+createRandomFrames(int numFrames)
+{
+  std::srand(42);
+  std::vector<std::shared_ptr<dart::dynamics::SimpleFrame>> frames;
+  for (int i = 0; i < numFrames; i++)
+  {
+    Eigen::Isometry3s tf = Eigen::Isometry3s::Identity();
+    tf.translation() = Eigen::Vector3s::Random() * 1.5;
+    tf.linear() = Eigen::Quaternion<s_t>::UnitRandom().toRotationMatrix();
+    auto frame = std::make_shared<dart::dynamics::SimpleFrame>(
+        dart::dynamics::Frame::World(), "frame" + std::to_string(i), tf);
+    const s_t size = 0.3 + 0.3 * std::abs(Eigen::Vector2s::Random()(0));
+    if (i % 2 == 0)
+    {
+      frame->setShape(std::make_shared<dart::dynamics::SphereShape>(size / 2));
+    }
+    else
+    {
+      frame->setShape(std::make_shared<dart::dynamics::BoxShape>(
+          Eigen::Vector3s::Constant(size)));
+    }
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+//==============================================================================
+TEST(DARTBroadphase, MATCHES_BRUTE_FORCE)
+{
+  auto cd = dart::collision::DARTCollisionDetector::create();
+  auto frames = createRandomFrames(60);
+  auto group = cd->createCollisionGroup();
+  auto groupA = cd->createCollisionGroup();
+  auto groupB = cd->createCollisionGroup();
+  for (int i = 0; i < frames.size(); i++)
+  {
+    group->addShapeFrame(frames[i].get());
+    if (i < frames.size() / 2)
+      groupA->addShapeFrame(frames[i].get());
+    else
+      groupB->addShapeFrame(frames[i].get());
+  }
+
+  dart::collision::CollisionOption option(true, 100000u);
+  for (int step = 0; step < 3; step++)
+  {
+    dart::collision::CollisionResult bruteForce;
+    dart::collision::CollisionResult broadphase;
+    dart::collision::CollisionResult bruteForceAB;
+    dart::collision::CollisionResult broadphaseAB;
+
+    cd->setUseBroadphase(false);
+    bool bruteForceHit = group->collide(option, &bruteForce);
+    bool bruteForceHitAB = groupA->collide(groupB.get(), option, &bruteForceAB);
+    cd->setUseBroadphase(true);
+    bool broadphaseHit = group->collide(option, &broadphase);
+    bool broadphaseHitAB = groupA->collide(groupB.get(), option, &broadphaseAB);
+
+    EXPECT_EQ(bruteForceHit, broadphaseHit);
+    EXPECT_EQ(bruteForceHitAB, broadphaseHitAB);
+
+    EXPECT_GT(bruteForce.getNumContacts(), 0);
+    ASSERT_EQ(bruteForce.getNumContacts(), broadphase.getNumContacts());
+    for (int i = 0; i < bruteForce.getNumContacts(); i++)
+    {
+      EXPECT_EQ(
+          bruteForce.getContact(i).collisionObject1,
+          broadphase.getContact(i).collisionObject1);
+      EXPECT_EQ(
+          bruteForce.getContact(i).collisionObject2,
+          broadphase.getContact(i).collisionObject2);
+      EXPECT_TRUE(bruteForce.getContact(i).point.isApprox(
+          broadphase.getContact(i).point));
+    }
+    ASSERT_EQ(bruteForceAB.getNumContacts(), broadphaseAB.getNumContacts());
+    for (int i = 0; i < bruteForceAB.getNumContacts(); i++)
+    {
+      EXPECT_TRUE(bruteForceAB.getContact(i).point.isApprox(
+          broadphaseAB.getContact(i).point));
+    }
+
+    // Move everything a bit, so the broadphase has to re-sort
+    for (auto& frame : frames)
+    {
+      Eigen::Isometry3s tf = frame->getRelativeTransform();
+      tf.translation() += Eigen::Vector3s::Random() * 0.2;
+      frame->setRelativeTransform(tf);
+    }
+  }
+}
+
+//==============================================================================
+TEST(DARTBroadphase, RAYCAST)
+{
+  auto cd = dart::collision::DARTCollisionDetector::create();
+  auto group = cd->createCollisionGroup();
+
+  Eigen::Isometry3s tf = Eigen::Isometry3s::Identity();
+  tf.translation() = Eigen::Vector3s(2, 0, 0);
+  auto sphere = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "sphere", tf);
+  sphere->setShape(std::make_shared<dart::dynamics::SphereShape>(0.5));
+  tf.translation() = Eigen::Vector3s(4, 0, 0);
+  auto box = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "box", tf);
+  box->setShape(
+      std::make_shared<dart::dynamics::BoxShape>(Eigen::Vector3s::Ones()));
+  tf.translation() = Eigen::Vector3s(0, 5, 0);
+  auto outOfTheWay = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "outOfTheWay", tf);
+  outOfTheWay->setShape(std::make_shared<dart::dynamics::SphereShape>(0.5));
+  group->addShapeFrame(sphere.get());
+  group->addShapeFrame(box.get());
+  group->addShapeFrame(outOfTheWay.get());
+
+  const Eigen::Vector3s from = Eigen::Vector3s::Zero();
+  const Eigen::Vector3s to = Eigen::Vector3s(10, 0, 0);
+
+  dart::collision::RaycastResult closest;
+  EXPECT_TRUE(
+      group->raycast(from, to, dart::collision::RaycastOption(), &closest));
+  ASSERT_EQ(closest.mRayHits.size(), 1);
+  EXPECT_NEAR(closest.mRayHits[0].mFraction, 0.15, 1e-9);
+  EXPECT_TRUE(closest.mRayHits[0].mPoint.isApprox(Eigen::Vector3s(1.5, 0, 0)));
+  EXPECT_TRUE(
+      closest.mRayHits[0].mNormal.isApprox(Eigen::Vector3s(-1, 0, 0)));
+
+  dart::collision::RaycastResult all;
+  EXPECT_TRUE(group->raycast(
+      from, to, dart::collision::RaycastOption(true, true), &all));
+  ASSERT_EQ(all.mRayHits.size(), 2);
+  EXPECT_NEAR(all.mRayHits[1].mFraction, 0.35, 1e-9);
+  EXPECT_TRUE(all.mRayHits[1].mNormal.isApprox(Eigen::Vector3s(-1, 0, 0)));
+
+  EXPECT_FALSE(
+      group->raycast(Eigen::Vector3s(0, -1, 0), Eigen::Vector3s(10, -1, 0)));
+}
+
+//==============================================================================
+TEST(DARTCollisionContext, WARM_START_TABLE)
+{
+  dart::collision::DARTCollisionContext context;
+  std::vector<int> storage(1000);
+  auto object = [&](int i) {
+    return reinterpret_cast<const dart::collision::CollisionObject*>(
+        &storage[i]);
+  };
+
+  // Pairs are ordered, so (a, b) and (b, a) get separate slots
+  context.getWarmStart(object(0), object(1)).dir.v[0] = 1.0;
+  context.getWarmStart(object(1), object(0)).dir.v[0] = 2.0;
+  EXPECT_EQ(context.getNumPairs(), 2);
+  EXPECT_EQ(context.getWarmStart(object(0), object(1)).dir.v[0], 1.0);
+  EXPECT_EQ(context.getWarmStart(object(1), object(0)).dir.v[0], 2.0);
+
+  // New slots start zeroed, and survive the table growing many times
+  for (int i = 0; i < 999; i++)
+  {
+    auto& warmStart = context.getWarmStart(object(i), object(i + 1));
+    if (i > 0)
+    {
+      EXPECT_EQ(warmStart.dir.v[0], 0.0);
+      EXPECT_EQ(warmStart.pos.v[2], 0.0);
+    }
+    warmStart.pos.v[2] = i;
+  }
+  EXPECT_EQ(context.getNumPairs(), 1000);
+  for (int i = 0; i < 999; i++)
+  {
+    EXPECT_EQ(context.getWarmStart(object(i), object(i + 1)).pos.v[2], i);
+  }
+  EXPECT_EQ(context.getNumPairs(), 1000);
+
+  context.clear();
+  EXPECT_EQ(context.getNumPairs(), 0);
+  EXPECT_EQ(context.getWarmStart(object(0), object(1)).dir.v[0], 0.0);
+}
+
+//==============================================================================
+TEST(DARTCollisionContext, SCOPED_BIND)
+{
+  using dart::collision::DARTCollisionContext;
+  DARTCollisionContext& defaultContext = DARTCollisionContext::getCurrent();
+  DARTCollisionContext outer;
+  DARTCollisionContext inner;
+  {
+    DARTCollisionContext::ScopedBind bindOuter(outer);
+    EXPECT_EQ(&DARTCollisionContext::getCurrent(), &outer);
+    {
+      DARTCollisionContext::ScopedBind bindInner(inner);
+      EXPECT_EQ(&DARTCollisionContext::getCurrent(), &inner);
+    }
+    EXPECT_EQ(&DARTCollisionContext::getCurrent(), &outer);
+  }
+  EXPECT_EQ(&DARTCollisionContext::getCurrent(), &defaultContext);
+
+  // Other threads don't see this thread's bindings
+  DARTCollisionContext::ScopedBind bindOuter(outer);
+  DARTCollisionContext* otherThreadContext = nullptr;
+  std::thread thread([&]() {
+    otherThreadContext = &DARTCollisionContext::getCurrent();
+  });
+  thread.join();
+  EXPECT_NE(otherThreadContext, &outer);
+  EXPECT_NE(otherThreadContext, &defaultContext);
+}
+
+//==============================================================================
+TEST(DARTCollisionContext, PARALLEL_GROUPS_MATCH_SERIAL)
+{
+  auto cd = dart::collision::DARTCollisionDetector::create();
+  const int numGroups = 4;
+  std::vector<std::vector<std::shared_ptr<dart::dynamics::SimpleFrame>>> frames;
+  std::vector<std::shared_ptr<dart::collision::CollisionGroup>> groups;
+  for (int i = 0; i < numGroups; i++)
+  {
+    frames.push_back(createRandomFrames(40));
+    groups.push_back(cd->createCollisionGroup());
+    for (auto& frame : frames.back())
+    {
+      groups.back()->addShapeFrame(frame.get());
+    }
+  }
+
+  dart::collision::CollisionOption option(true, 100000u);
+  std::vector<dart::collision::CollisionResult> serial(numGroups);
+  for (int i = 0; i < numGroups; i++)
+  {
+    groups[i]->collide(option, &serial[i]);
+  }
+
+  // Each group has its own context, so colliding separate groups at the same
+  // time shouldn't change anything
+  std::vector<dart::collision::CollisionResult> parallel(numGroups);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numGroups; i++)
+  {
+    threads.emplace_back(
+        [&, i]() { groups[i]->collide(option, &parallel[i]); });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  for (int i = 0; i < numGroups; i++)
+  {
+    EXPECT_GT(serial[i].getNumContacts(), 0);
+    ASSERT_EQ(serial[i].getNumContacts(), parallel[i].getNumContacts());
+    for (int j = 0; j < serial[i].getNumContacts(); j++)
+    {
+      EXPECT_TRUE(serial[i].getContact(j).point.isApprox(
+          parallel[i].getContact(j).point));
+    }
+  }
+}
+
+//==============================================================================
+TEST(DARTBroadphase, RAYCAST_ELLIPSOID)
+{
+  auto cd = dart::collision::DARTCollisionDetector::create();
+  auto group = cd->createCollisionGroup();
+
+  Eigen::Isometry3s tf = Eigen::Isometry3s::Identity();
+  tf.translation() = Eigen::Vector3s(0, 3, 0);
+  auto ellipsoid = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "ellipsoid", tf);
+  ellipsoid->setShape(std::make_shared<dart::dynamics::EllipsoidShape>(
+      Eigen::Vector3s(1, 2, 1)));
+  group->addShapeFrame(ellipsoid.get());
+
+  for (bool useBroadphase : {true, false})
+  {
+    cd->setUseBroadphase(useBroadphase);
+
+    dart::collision::RaycastResult alongY;
+    EXPECT_TRUE(group->raycast(
+        Eigen::Vector3s::Zero(),
+        Eigen::Vector3s(0, 10, 0),
+        dart::collision::RaycastOption(),
+        &alongY));
+    ASSERT_EQ(alongY.mRayHits.size(), 1);
+    EXPECT_NEAR(alongY.mRayHits[0].mFraction, 0.2, 1e-9);
+    EXPECT_TRUE(alongY.mRayHits[0].mNormal.isApprox(Eigen::Vector3s(0, -1, 0)));
+
+    dart::collision::RaycastResult alongX;
+    EXPECT_TRUE(group->raycast(
+        Eigen::Vector3s(-5, 3, 0),
+        Eigen::Vector3s(5, 3, 0),
+        dart::collision::RaycastOption(),
+        &alongX));
+    ASSERT_EQ(alongX.mRayHits.size(), 1);
+    EXPECT_NEAR(alongX.mRayHits[0].mFraction, 0.45, 1e-9);
+    EXPECT_TRUE(alongX.mRayHits[0].mNormal.isApprox(Eigen::Vector3s(-1, 0, 0)));
+
+    // Passes beside the ellipsoid, but through its bounding box
+    EXPECT_FALSE(group->raycast(
+        Eigen::Vector3s(-5, 3.9, 0.4), Eigen::Vector3s(5, 3.9, 0.4)));
+  }
+}
+
+//==============================================================================
+TEST(DARTCollisionDetector, DISTANCE)
+{
+  auto cd = dart::collision::DARTCollisionDetector::create();
+  auto group = cd->createCollisionGroup();
+
+  Eigen::Isometry3s tf = Eigen::Isometry3s::Identity();
+  auto sphere = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "sphere", tf);
+  sphere->setShape(std::make_shared<dart::dynamics::SphereShape>(0.5));
+  tf.translation() = Eigen::Vector3s(3, 0, 0);
+  auto box = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "box", tf);
+  box->setShape(
+      std::make_shared<dart::dynamics::BoxShape>(Eigen::Vector3s::Ones()));
+  tf.translation() = Eigen::Vector3s(0, 10, 0);
+  auto capsule = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "capsule", tf);
+  capsule->setShape(std::make_shared<dart::dynamics::CapsuleShape>(0.5, 1.0));
+  group->addShapeFrame(sphere.get());
+  group->addShapeFrame(box.get());
+  group->addShapeFrame(capsule.get());
+
+  // The cylinder's bottom cap is at z = 2
+  auto otherGroup = cd->createCollisionGroup();
+  tf.translation() = Eigen::Vector3s(0, 0, 3);
+  auto cylinder = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "cylinder", tf);
+  cylinder->setShape(
+      std::make_shared<dart::dynamics::CylinderShape>(0.5, 2.0));
+  otherGroup->addShapeFrame(cylinder.get());
+
+  for (bool useBroadphase : {true, false})
+  {
+    cd->setUseBroadphase(useBroadphase);
+
+    dart::collision::DistanceOption option(true, 0.0, nullptr);
+    dart::collision::DistanceResult result;
+    EXPECT_NEAR(group->distance(option, &result), 2.0, 1e-6);
+    ASSERT_TRUE(result.found());
+    EXPECT_NEAR(result.unclampedMinDistance, 2.0, 1e-6);
+    EXPECT_EQ(result.shapeFrame1, sphere.get());
+    EXPECT_EQ(result.shapeFrame2, box.get());
+    EXPECT_TRUE(result.nearestPoint1.isApprox(
+        Eigen::Vector3s(0.5, 0, 0), 1e-6));
+    EXPECT_TRUE(result.nearestPoint2.isApprox(
+        Eigen::Vector3s(2.5, 0, 0), 1e-6));
+
+    // Distances below the lower bound get clamped
+    dart::collision::DistanceOption clamped(false, 5.0, nullptr);
+    EXPECT_NEAR(group->distance(clamped, &result), 5.0, 1e-6);
+    EXPECT_NEAR(result.minDistance, 5.0, 1e-6);
+    EXPECT_NEAR(result.unclampedMinDistance, 2.0, 1e-6);
+
+    EXPECT_NEAR(group->distance(otherGroup.get(), option, &result), 1.5, 1e-6);
+    EXPECT_EQ(result.shapeFrame1, sphere.get());
+    EXPECT_EQ(result.shapeFrame2, cylinder.get());
+    EXPECT_TRUE(result.nearestPoint1.isApprox(
+        Eigen::Vector3s(0, 0, 0.5), 1e-6));
+    EXPECT_TRUE(result.nearestPoint2.isApprox(
+        Eigen::Vector3s(0, 0, 2), 1e-6));
+  }
+
+  // Overlapping shapes are reported as touching
+  tf.translation() = Eigen::Vector3s(0.8, 0, 0);
+  box->setRelativeTransform(tf);
+  for (bool useBroadphase : {true, false})
+  {
+    cd->setUseBroadphase(useBroadphase);
+
+    dart::collision::DistanceResult result;
+    EXPECT_NEAR(
+        group->distance(dart::collision::DistanceOption(), &result),
+        0.0,
+        1e-6);
+    EXPECT_TRUE(result.found());
+  }
+}
+
+//==============================================================================
+TEST(DARTBroadphase, RAYCAST_CAPSULE_CYLINDER_MESH)
+{
+  auto cd = dart::collision::DARTCollisionDetector::create();
+
+  Eigen::Isometry3s tf = Eigen::Isometry3s::Identity();
+  tf.translation() = Eigen::Vector3s(0, 3, 0);
+  auto capsule = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "capsule", tf);
+  capsule->setShape(std::make_shared<dart::dynamics::CapsuleShape>(0.5, 1.0));
+  auto capsuleGroup = cd->createCollisionGroup(capsule.get());
+
+  tf.translation() = Eigen::Vector3s(5, 0, 0);
+  auto cylinder = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "cylinder", tf);
+  cylinder->setShape(
+      std::make_shared<dart::dynamics::CylinderShape>(0.5, 1.0));
+  auto cylinderGroup = cd->createCollisionGroup(cylinder.get());
+
+  // A single triangle in the z = 0 plane, scaled up by 2
+  aiScene* scene = new aiScene;
+  scene->mNumMeshes = 1;
+  scene->mMeshes = new aiMesh*[1];
+  aiMesh* triangle = new aiMesh;
+  triangle->mNumVertices = 3;
+  triangle->mVertices = new aiVector3D[3];
+  triangle->mVertices[0] = aiVector3D(-1, -1, 0);
+  triangle->mVertices[1] = aiVector3D(1, -1, 0);
+  triangle->mVertices[2] = aiVector3D(0, 1, 0);
+  triangle->mNumFaces = 1;
+  triangle->mFaces = new aiFace[1];
+  triangle->mFaces[0].mNumIndices = 3;
+  triangle->mFaces[0].mIndices = new unsigned int[3]{0, 1, 2};
+  scene->mMeshes[0] = triangle;
+  tf.translation() = Eigen::Vector3s(0, 0, -10);
+  auto mesh = std::make_shared<dart::dynamics::SimpleFrame>(
+      dart::dynamics::Frame::World(), "mesh", tf);
+  mesh->setShape(std::make_shared<dart::dynamics::MeshShape>(
+      Eigen::Vector3s::Constant(2),
+      std::make_shared<dart::dynamics::SharedMeshWrapper>(scene),
+      "",
+      nullptr,
+      true));
+  auto meshGroup = cd->createCollisionGroup(mesh.get());
+
+  for (bool useBroadphase : {true, false})
+  {
+    cd->setUseBroadphase(useBroadphase);
+
+    // Into the side of the capsule, then into one of its caps
+    dart::collision::RaycastResult result;
+    EXPECT_TRUE(capsuleGroup->raycast(
+        Eigen::Vector3s::Zero(),
+        Eigen::Vector3s(0, 10, 0),
+        dart::collision::RaycastOption(),
+        &result));
+    ASSERT_EQ(result.mRayHits.size(), 1);
+    EXPECT_NEAR(result.mRayHits[0].mFraction, 0.25, 1e-9);
+    EXPECT_TRUE(result.mRayHits[0].mNormal.isApprox(Eigen::Vector3s(0, -1, 0)));
+    EXPECT_TRUE(capsuleGroup->raycast(
+        Eigen::Vector3s(0, 3, -5),
+        Eigen::Vector3s(0, 3, 5),
+        dart::collision::RaycastOption(),
+        &result));
+    ASSERT_EQ(result.mRayHits.size(), 1);
+    EXPECT_NEAR(result.mRayHits[0].mFraction, 0.4, 1e-9);
+    EXPECT_TRUE(result.mRayHits[0].mNormal.isApprox(Eigen::Vector3s(0, 0, -1)));
+    // Starts inside the capsule
+    EXPECT_FALSE(capsuleGroup->raycast(
+        Eigen::Vector3s(0, 3, 0), Eigen::Vector3s(0, 3, 10)));
+
+    // Into the side of the cylinder, then into its bottom cap
+    EXPECT_TRUE(cylinderGroup->raycast(
+        Eigen::Vector3s::Zero(),
+        Eigen::Vector3s(10, 0, 0),
+        dart::collision::RaycastOption(),
+        &result));
+    ASSERT_EQ(result.mRayHits.size(), 1);
+    EXPECT_NEAR(result.mRayHits[0].mFraction, 0.45, 1e-9);
+    EXPECT_TRUE(result.mRayHits[0].mNormal.isApprox(Eigen::Vector3s(-1, 0, 0)));
+    EXPECT_TRUE(cylinderGroup->raycast(
+        Eigen::Vector3s(5, 0, -5),
+        Eigen::Vector3s(5, 0, 5),
+        dart::collision::RaycastOption(),
+        &result));
+    ASSERT_EQ(result.mRayHits.size(), 1);
+    EXPECT_NEAR(result.mRayHits[0].mFraction, 0.45, 1e-9);
+    EXPECT_TRUE(result.mRayHits[0].mNormal.isApprox(Eigen::Vector3s(0, 0, -1)));
+    // Passes by the cylinder's edge, but through its bounding box
+    EXPECT_FALSE(cylinderGroup->raycast(
+        Eigen::Vector3s(5.45, 0.45, -5), Eigen::Vector3s(5.45, 0.45, 5)));
+
+    // Through the triangle, then beside it
+    EXPECT_TRUE(meshGroup->raycast(
+        Eigen::Vector3s(0, 0, -5),
+        Eigen::Vector3s(0, 0, -15),
+        dart::collision::RaycastOption(),
+        &result));
+    ASSERT_EQ(result.mRayHits.size(), 1);
+    EXPECT_NEAR(result.mRayHits[0].mFraction, 0.5, 1e-9);
+    EXPECT_TRUE(
+        result.mRayHits[0].mPoint.isApprox(Eigen::Vector3s(0, 0, -10)));
+    EXPECT_TRUE(result.mRayHits[0].mNormal.isApprox(Eigen::Vector3s(0, 0, 1)));
+    EXPECT_FALSE(meshGroup->raycast(
+        Eigen::Vector3s(1.5, 0, -5), Eigen::Vector3s(1.5, 0, -15)));
+  }
+}
@@ -34,6 +34,7 @@
 
 #include <gtest/gtest.h>
 
+#include "dart/neural/ClampingFactorizationCache.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 
 #include "TestHelpers.hpp"
@@ -125,4 +126,142 @@ TEST(ConstrainedGroupGradientMatrices, SIMPLE_MERGE)
   Eigen::VectorXs newACols(2);
   newACols << 1.0, 1.0;
   EXPECT_TRUE(equals(newACols, matrices.mAColNorms));
-}
\ No newline at end of file
+}
+
+ClampingPatternKey patternKey(const std::string& name)
+{
+  ClampingPatternKey key;
+  key.add(name);
+  return key;
+}
+
+TEST(ConstrainedGroupGradientMatrices, FACTORIZATION_CACHE_REUSES_SAME_Q)
+{
+  ClampingFactorizationCache cache;
+
+  Eigen::MatrixXs Q = Eigen::MatrixXs::Random(4, 4);
+  Q = Q * Q.transpose() + Eigen::MatrixXs::Identity(4, 4);
+  Eigen::VectorXs b = Eigen::VectorXs::Random(4);
+
+  std::shared_ptr<const ClampingFactorization> first
+      = cache.getFactorization(patternKey("pattern"), Q);
+  EXPECT_EQ(cache.getNumHits(), 0);
+  EXPECT_EQ(cache.getNumMisses(), 1);
+
+  std::shared_ptr<const ClampingFactorization> second
+      = cache.getFactorization(patternKey("pattern"), Q);
+  EXPECT_EQ(cache.getNumHits(), 1);
+  EXPECT_EQ(cache.getNumMisses(), 1);
+  EXPECT_EQ(first.get(), second.get());
+
+  Eigen::VectorXs expected = Q.completeOrthogonalDecomposition().solve(b);
+  EXPECT_TRUE(equals(
+      expected, Eigen::VectorXs(second->solve(b)), 1e-12));
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(Q.completeOrthogonalDecomposition().pseudoInverse()),
+      second->getPseudoInverse(),
+      1e-12));
+
+  cache.resetCounters();
+  EXPECT_EQ(cache.getNumHits(), 0);
+  EXPECT_EQ(cache.getNumMisses(), 0);
+  EXPECT_EQ(cache.getNumEntries(), 1);
+}
+
+TEST(ConstrainedGroupGradientMatrices, FACTORIZATION_CACHE_REFACTORS_NEW_Q)
+{
+  ClampingFactorizationCache cache;
+
+  Eigen::MatrixXs Q = Eigen::MatrixXs::Identity(3, 3);
+  std::shared_ptr<const ClampingFactorization> first
+      = cache.getFactorization(patternKey("pattern"), Q);
+
+  // The same pattern with a different Q has to be factored again
+  Eigen::MatrixXs Q2 = 2 * Q;
+  std::shared_ptr<const ClampingFactorization> second
+      = cache.getFactorization(patternKey("pattern"), Q2);
+  EXPECT_EQ(cache.getNumHits(), 0);
+  EXPECT_EQ(cache.getNumMisses(), 2);
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_TRUE(equals(Q2, second->getQ()));
+
+  // So does a different pattern with the same Q, and a different size Q
+  cache.getFactorization(patternKey("other"), Q2);
+  cache.getFactorization(
+      patternKey("pattern"), Eigen::MatrixXs::Identity(2, 2));
+  EXPECT_EQ(cache.getNumHits(), 0);
+  EXPECT_EQ(cache.getNumMisses(), 4);
+  EXPECT_EQ(cache.getNumEntries(), 2);
+}
+
+TEST(ConstrainedGroupGradientMatrices, FACTORIZATION_CACHE_WARM_STARTS)
+{
+  ClampingFactorizationCache cache;
+
+  Eigen::MatrixXs Q = Eigen::MatrixXs::Random(5, 5);
+  Q = Q * Q.transpose() + Eigen::MatrixXs::Identity(5, 5);
+  Eigen::MatrixXs B = Eigen::MatrixXs::Random(5, 3);
+  std::shared_ptr<const ClampingFactorization> first
+      = cache.getFactorization(patternKey("pattern"), Q);
+  EXPECT_FALSE(first->isWarmStarted());
+
+  // A Q that's only drifted a little warm starts from the cached one
+  Eigen::MatrixXs Q2 = Q + 1e-5 * Eigen::MatrixXs::Random(5, 5);
+  std::shared_ptr<const ClampingFactorization> second
+      = cache.getFactorization(patternKey("pattern"), Q2);
+  EXPECT_TRUE(second->isWarmStarted());
+  EXPECT_EQ(cache.getNumHits(), 0);
+  EXPECT_EQ(cache.getNumWarmStarts(), 1);
+  EXPECT_EQ(cache.getNumMisses(), 1);
+  EXPECT_TRUE(equals(Q2, second->getQ()));
+
+  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> exact
+      = Q2.completeOrthogonalDecomposition();
+  EXPECT_TRUE(
+      equals(Eigen::MatrixXs(exact.solve(B)), second->solve(B), 1e-12));
+  EXPECT_TRUE(equals(
+      Eigen::MatrixXs(exact.pseudoInverse()),
+      second->getPseudoInverse(),
+      1e-12));
+  EXPECT_EQ(cache.getNumWarmStartFallbacks(), 0);
+
+  // Warm started factorizations aren't cached, so we still drift from Q
+  cache.getFactorization(patternKey("pattern"), Q);
+  EXPECT_EQ(cache.getNumHits(), 1);
+
+  // A drift of 0 only reuses exactly equal Qs
+  cache.setMaxWarmStartDrift(0.0);
+  std::shared_ptr<const ClampingFactorization> third
+      = cache.getFactorization(patternKey("pattern"), Q2);
+  EXPECT_FALSE(third->isWarmStarted());
+  EXPECT_EQ(cache.getNumWarmStarts(), 1);
+  EXPECT_EQ(cache.getNumMisses(), 2);
+}
+
+TEST(ConstrainedGroupGradientMatrices, FACTORIZATION_CACHE_EVICTS_OLDEST)
+{
+  ClampingFactorizationCache cache(2);
+
+  Eigen::MatrixXs Q = Eigen::MatrixXs::Identity(2, 2);
+  cache.getFactorization(patternKey("a"), Q);
+  cache.getFactorization(patternKey("b"), Q);
+  // Touch "a", so "b" is now the least recently used
+  cache.getFactorization(patternKey("a"), Q);
+  cache.getFactorization(patternKey("c"), Q);
+  EXPECT_EQ(cache.getNumEntries(), 2);
+
+  cache.resetCounters();
+  cache.getFactorization(patternKey("a"), Q);
+  cache.getFactorization(patternKey("c"), Q);
+  EXPECT_EQ(cache.getNumHits(), 2);
+  cache.getFactorization(patternKey("b"), Q);
+  EXPECT_EQ(cache.getNumMisses(), 1);
+
+  // A capacity of 0 turns the cache off
+  cache.setCapacity(0);
+  EXPECT_EQ(cache.getNumEntries(), 0);
+  cache.getFactorization(patternKey("a"), Q);
+  cache.getFactorization(patternKey("a"), Q);
+  EXPECT_EQ(cache.getNumEntries(), 0);
+  EXPECT_EQ(cache.getNumMisses(), 3);
+}
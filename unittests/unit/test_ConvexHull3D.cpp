@@ -0,0 +1,111 @@
+#include <limits>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/math/ConvexHull3D.hpp"
+#include "dart/math/MathTypes.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+
+/// This checks that hill-climbing the hull gets the same support value as
+/// scanning every point, for a bunch of random directions
+void verifySupportMatchesScan(
+    const math::ConvexHull3D& hull, const std::vector<Eigen::Vector3s>& points)
+{
+  int hint = 0;
+  for (int i = 0; i < 500; i++)
+  {
+    Eigen::Vector3s dir = Eigen::Vector3s::Random();
+    s_t bestDot = -std::numeric_limits<s_t>::infinity();
+    for (const Eigen::Vector3s& point : points)
+    {
+      bestDot = std::max(bestDot, point.dot(dir));
+    }
+    hint = hull.getSupportVertex(dir, hint);
+    EXPECT_NEAR(hull.getVertex(hint).dot(dir), bestDot, 1e-12);
+  }
+}
+
+/// This checks V - E + F = 2, which only holds for a closed, watertight hull
+void verifyEulerCharacteristic(const math::ConvexHull3D& hull)
+{
+  int numEdgeEnds = 0;
+  for (int i = 0; i < hull.getNumVertices(); i++)
+  {
+    numEdgeEnds += hull.getNumNeighbors(i);
+  }
+  EXPECT_EQ(numEdgeEnds % 2, 0);
+  EXPECT_EQ(
+      hull.getNumVertices() - numEdgeEnds / 2 + hull.getNumFaces(), 2);
+}
+
+TEST(ConvexHull3D, RANDOM_CLOUD)
+{
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 2000; i++)
+  {
+    points.push_back(Eigen::Vector3s::Random());
+  }
+  math::ConvexHull3D hull(points);
+  EXPECT_FALSE(hull.isDegenerate());
+  EXPECT_LT(hull.getNumVertices(), points.size());
+  verifyEulerCharacteristic(hull);
+  verifySupportMatchesScan(hull, points);
+}
+
+TEST(ConvexHull3D, EVERY_POINT_ON_HULL)
+{
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 1000; i++)
+  {
+    points.push_back(Eigen::Vector3s::Random().normalized() * 0.1);
+  }
+  math::ConvexHull3D hull(points);
+  EXPECT_FALSE(hull.isDegenerate());
+  EXPECT_EQ(hull.getNumVertices(), points.size());
+  verifyEulerCharacteristic(hull);
+  verifySupportMatchesScan(hull, points);
+}
+
+TEST(ConvexHull3D, COPLANAR_AND_DUPLICATE_POINTS)
+{
+  // A 5x5x5 lattice, which has lots of points that lie exactly on the faces
+  // and edges of the hull, and every point twice
+  std::vector<Eigen::Vector3s> points;
+  for (int copy = 0; copy < 2; copy++)
+  {
+    for (int x = 0; x < 5; x++)
+    {
+      for (int y = 0; y < 5; y++)
+      {
+        for (int z = 0; z < 5; z++)
+        {
+          points.push_back(Eigen::Vector3s(x, y, z) * 0.25);
+        }
+      }
+    }
+  }
+  math::ConvexHull3D hull(points);
+  EXPECT_FALSE(hull.isDegenerate());
+  verifyEulerCharacteristic(hull);
+  verifySupportMatchesScan(hull, points);
+}
+
+TEST(ConvexHull3D, FLAT_CLOUD_FALLS_BACK_TO_SCAN)
+{
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 100; i++)
+  {
+    Eigen::Vector3s point = Eigen::Vector3s::Random();
+    point(2) = 0.3;
+    points.push_back(point);
+  }
+  math::ConvexHull3D hull(points);
+  EXPECT_TRUE(hull.isDegenerate());
+  EXPECT_EQ(hull.getNumVertices(), points.size());
+  verifySupportMatchesScan(hull, points);
+}
@@ -1,5 +1,8 @@
+#include <chrono>
+#include <cmath>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -971,4 +974,254 @@ TEST(CORTEX_STREAMING, TEST_GENERATE_AND_RECOVER_PACKETS)
     }
   }
 }
+#endif
+
+#ifdef ALL_TESTS
+TEST(CORTEX_STREAMING, TEST_FRAME_BUFFER_THROUGHPUT)
+{
+  CortexStreaming cortexServer("127.0.0.1");
+
+  // A large lab: lots of markers, a few of them occluded, and 4 force plates
+  // sampled at 10x the marker rate
+  std::vector<std::string> markerNames;
+  std::vector<Eigen::Vector3s> markerPoses;
+  std::vector<Eigen::MatrixXs> forcePlateCopTorqueForce;
+  for (int i = 0; i < 120; i++)
+  {
+    markerNames.push_back("marker" + std::to_string(i));
+    markerPoses.push_back(Eigen::Vector3s::Random());
+    if (i % 17 == 0)
+    {
+      markerPoses.back().setConstant(std::nan(""));
+    }
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    forcePlateCopTorqueForce.push_back(Eigen::MatrixXs::Random(10, 9));
+    forcePlateCopTorqueForce[i].col(3).setZero();
+    forcePlateCopTorqueForce[i].col(4).setZero();
+  }
+  cortexServer.mockServerSetData(
+      markerNames, markerPoses, forcePlateCopTorqueForce);
+
+  std::vector<unsigned char> generatedBodyDefsPacket
+      = cortexServer.createBodyDefsPacket(cortexServer.getCurrentBodyDefs());
+  std::vector<unsigned char> generatedFramePacket
+      = cortexServer.createFrameOfDataPacket(
+          cortexServer.getCurrentFrameOfData());
+
+  sockaddr_in address;
+  sPacket bodyDefsPacket;
+  memcpy(
+      &bodyDefsPacket,
+      generatedBodyDefsPacket.data(),
+      generatedBodyDefsPacket.size());
+  sPacket framePacket;
+  memcpy(
+      &framePacket, generatedFramePacket.data(), generatedFramePacket.size());
+
+  const int numFrames = 20000;
+
+  // 1. The original path, which builds nested vectors for every frame
+  CortexStreaming vectorReceiver("127.0.0.1");
+  std::vector<std::string> vectorNames;
+  std::vector<Eigen::Vector3s> vectorMarkers;
+  std::vector<Eigen::MatrixXs> vectorPlates;
+  vectorReceiver.setFrameHandler(
+      [&](std::vector<std::string> names,
+          std::vector<Eigen::Vector3s> markers,
+          std::vector<Eigen::MatrixXs> plates) {
+        vectorNames = names;
+        vectorMarkers = markers;
+        vectorPlates = plates;
+      });
+  vectorReceiver.parseCortexPacket(&bodyDefsPacket, address, false);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numFrames; i++)
+  {
+    vectorReceiver.parseCortexPacket(&framePacket, address, true);
+  }
+  s_t vectorSeconds = std::chrono::duration<s_t>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+
+  // 2. The frame buffer path
+  CortexStreaming bufferReceiver("127.0.0.1");
+  int numHandled = 0;
+  bool matches = true;
+  bufferReceiver.setFrameBufferHandler([&](const CortexFrameBuffer& frame) {
+    numHandled++;
+    // Only check the first frame, so we're timing the parsing
+    if (numHandled > 1)
+    {
+      return;
+    }
+    matches = matches && frame.numMarkers == vectorMarkers.size()
+              && frame.numForcePlates == vectorPlates.size();
+    for (int i = 0; matches && i < frame.numMarkers; i++)
+    {
+      matches = *frame.markerNames[i] == vectorNames[i]
+                && frame.markers.col(i) == vectorMarkers[i];
+    }
+    for (int i = 0; matches && i < frame.numForcePlates; i++)
+    {
+      matches = frame.plateCopTorqueForce[i] == vectorPlates[i];
+    }
+  });
+  bufferReceiver.parseCortexPacket(&bodyDefsPacket, address, false);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numFrames; i++)
+  {
+    bufferReceiver.parseCortexPacket(&framePacket, address, true);
+  }
+  s_t bufferSeconds = std::chrono::duration<s_t>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+
+  EXPECT_EQ(numHandled, numFrames);
+  EXPECT_TRUE(matches);
+  std::cout << "Parsed " << numFrames << " frames of " << markerNames.size()
+            << " markers and " << forcePlateCopTorqueForce.size()
+            << " force plates:" << std::endl
+            << "  vectors: " << numFrames / vectorSeconds << " frames/s"
+            << std::endl
+            << "  frame buffer: " << numFrames / bufferSeconds << " frames/s"
+            << std::endl;
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(CORTEX_STREAMING, TEST_FRAME_BUFFER_REJECTS_BAD_SEGMENT_COUNTS)
+{
+  CortexStreaming cortexServer("127.0.0.1");
+  std::vector<std::string> markerNames;
+  std::vector<Eigen::Vector3s> markerPoses;
+  for (int i = 0; i < 3; i++)
+  {
+    markerNames.push_back("marker" + std::to_string(i));
+    markerPoses.push_back(Eigen::Vector3s::Random());
+  }
+  std::vector<Eigen::MatrixXs> forcePlateCopTorqueForce;
+  forcePlateCopTorqueForce.push_back(Eigen::MatrixXs::Zero(10, 9));
+  cortexServer.mockServerSetData(
+      markerNames, markerPoses, forcePlateCopTorqueForce);
+
+  std::vector<unsigned char> generatedFramePacket
+      = cortexServer.createFrameOfDataPacket(
+          cortexServer.getCurrentFrameOfData());
+  sPacket framePacket;
+  memcpy(
+      &framePacket, generatedFramePacket.data(), generatedFramePacket.size());
+
+  CortexStreaming receiver("127.0.0.1");
+  CortexFrameBuffer buffer;
+  EXPECT_TRUE(receiver.parseFrameOfDataIntoBuffer(
+      framePacket.Data.cData, framePacket.nBytes, buffer));
+
+  // Find the segment count of the first body, which comes after the frame
+  // number, the body count, the body name and the body's markers
+  int nBodies = 0;
+  memcpy(&nBodies, framePacket.Data.cData + 4, 4);
+  ASSERT_GE(nBodies, 1);
+  int offset = 8;
+  offset += strlen(framePacket.Data.cData + offset) + 1;
+  int nMarkers = 0;
+  memcpy(&nMarkers, framePacket.Data.cData + offset, 4);
+  offset += 4 + nMarkers * 12;
+
+  int numHandled = 0;
+  receiver.setFrameBufferHandler(
+      [&](const CortexFrameBuffer& /* frame */) { numHandled++; });
+  sockaddr_in address;
+  // These would overflow an int when multiplied by the size of a segment
+  for (int nSegments : {-1, 1 << 26, std::numeric_limits<int>::max()})
+  {
+    sPacket corruptPacket = framePacket;
+    memcpy(corruptPacket.Data.cData + offset, &nSegments, 4);
+    EXPECT_FALSE(receiver.parseFrameOfDataIntoBuffer(
+        corruptPacket.Data.cData, corruptPacket.nBytes, buffer));
+    receiver.parseCortexPacket(&corruptPacket, address, true);
+  }
+  // Malformed frames shouldn't reach the handler
+  EXPECT_EQ(numHandled, 0);
+
+  receiver.parseCortexPacket(&framePacket, address, true);
+  EXPECT_EQ(numHandled, 1);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(CORTEX_STREAMING, TEST_FRAME_BUFFER_REJECTS_BAD_FORCE_PLATE_COUNTS)
+{
+  CortexStreaming cortexServer("127.0.0.1");
+  std::vector<std::string> markerNames;
+  std::vector<Eigen::Vector3s> markerPoses;
+  for (int i = 0; i < 3; i++)
+  {
+    markerNames.push_back("marker" + std::to_string(i));
+    markerPoses.push_back(Eigen::Vector3s::Random());
+  }
+  std::vector<Eigen::MatrixXs> forcePlateCopTorqueForce;
+  forcePlateCopTorqueForce.push_back(Eigen::MatrixXs::Zero(10, 9));
+  cortexServer.mockServerSetData(
+      markerNames, markerPoses, forcePlateCopTorqueForce);
+
+  std::vector<unsigned char> generatedFramePacket
+      = cortexServer.createFrameOfDataPacket(
+          cortexServer.getCurrentFrameOfData());
+  sPacket framePacket;
+  memcpy(
+      &framePacket, generatedFramePacket.data(), generatedFramePacket.size());
+
+  CortexStreaming receiver("127.0.0.1");
+  CortexFrameBuffer buffer;
+  ASSERT_TRUE(receiver.parseFrameOfDataIntoBuffer(
+      framePacket.Data.cData, framePacket.nBytes, buffer));
+  ASSERT_EQ(buffer.plateCopTorqueForce.size(), 1);
+  ASSERT_EQ(buffer.plateCopTorqueForce[0].rows(), 10);
+
+  // Find the force plate and sample counts, which are the last pair of ints
+  // that read (1, 10)
+  const int expectedCounts[2] = {1, 10};
+  int offset = -1;
+  for (int i = framePacket.nBytes - 8; i >= 0; i--)
+  {
+    if (memcmp(framePacket.Data.cData + i, expectedCounts, 8) == 0)
+    {
+      offset = i;
+      break;
+    }
+  }
+  ASSERT_GE(offset, 0);
+
+  int numHandled = 0;
+  receiver.setFrameBufferHandler(
+      [&](const CortexFrameBuffer& /* frame */) { numHandled++; });
+  sockaddr_in address;
+  // Each of these is either negative, or needs more bytes than are left in
+  // the packet. The last pair only runs out when the counts are multiplied.
+  const int corruptCounts[][2] = {
+      {-1, 10},
+      {1, -1},
+      {std::numeric_limits<int>::max(), 10},
+      {1, std::numeric_limits<int>::max()},
+      {1 << 20, 1 << 20},
+      {5, 5}};
+  for (const int* counts : corruptCounts)
+  {
+    sPacket corruptPacket = framePacket;
+    memcpy(corruptPacket.Data.cData + offset, counts, 8);
+    EXPECT_FALSE(receiver.parseFrameOfDataIntoBuffer(
+        corruptPacket.Data.cData, corruptPacket.nBytes, buffer));
+    // The buffers are checked before they're resized
+    EXPECT_EQ(buffer.plateCopTorqueForce.size(), 1);
+    EXPECT_EQ(buffer.plateCopTorqueForce[0].rows(), 10);
+    receiver.parseCortexPacket(&corruptPacket, address, true);
+  }
+  // Malformed frames shouldn't reach the handler
+  EXPECT_EQ(numHandled, 0);
+
+  receiver.parseCortexPacket(&framePacket, address, true);
+  EXPECT_EQ(numHandled, 1);
+}
 #endif
\ No newline at end of file
@@ -1363,6 +1363,95 @@ TEST(DARTCollide, MESH_RANDOM_SUPPORT_PLANES)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(DARTCollide, MESH_HULL_SUPPORT_MATCHES_SCAN)
+{
+  Eigen::Vector3s boxSize = Eigen::Vector3s(2.0, 4.0, 1.0);
+  aiScene* boxMesh = createBoxMeshUnsafe();
+  Eigen::Isometry3s boxTransform = Eigen::Isometry3s::Identity();
+  boxTransform.linear() = math::expMapRot(Eigen::Vector3s::Random());
+  boxTransform.translation() = Eigen::Vector3s::Random();
+
+  std::vector<Eigen::Vector3s> vertices;
+  for (int i = 0; i < boxMesh->mMeshes[0]->mNumVertices; i++)
+  {
+    const aiVector3D& v = boxMesh->mMeshes[0]->mVertices[i];
+    vertices.emplace_back(v.x, v.y, v.z);
+  }
+  math::ConvexHull3D hull(vertices);
+
+  ccdMesh scanMesh;
+  scanMesh.mesh = boxMesh;
+  scanMesh.transform = &boxTransform;
+  scanMesh.scale = &boxSize;
+
+  ccdMesh hullMesh;
+  hullMesh.mesh = boxMesh;
+  hullMesh.transform = &boxTransform;
+  hullMesh.scale = &boxSize;
+  hullMesh.hull = &hull;
+
+  for (int i = 0; i < 50; i++)
+  {
+    Eigen::Vector3s dirVec = Eigen::Vector3s::Random();
+
+    ccd_vec3_t dir;
+    dir.v[0] = static_cast<double>(dirVec(0));
+    dir.v[1] = static_cast<double>(dirVec(1));
+    dir.v[2] = static_cast<double>(dirVec(2));
+
+    ccd_vec3_t outScan;
+    ccd_vec3_t outHull;
+    ccdSupportMesh(&scanMesh, &dir, &outScan);
+    ccdSupportMesh(&hullMesh, &dir, &outHull);
+
+    EXPECT_EQ(outScan.v[0], outHull.v[0]);
+    EXPECT_EQ(outScan.v[1], outHull.v[1]);
+    EXPECT_EQ(outScan.v[2], outHull.v[2]);
+  }
+
+  // Colliding with the hull should find exactly the same contacts as scanning
+  Eigen::Isometry3s otherTransform = Eigen::Isometry3s::Identity();
+  otherTransform.translation() = boxTransform.translation()
+                                 + Eigen::Vector3s::UnitY() * 2.5;
+  CollisionOption option;
+  CollisionResult scanResult;
+  collideMeshMesh(
+      nullptr,
+      nullptr,
+      boxMesh,
+      boxSize,
+      boxTransform,
+      boxMesh,
+      boxSize,
+      otherTransform,
+      option,
+      scanResult);
+  CollisionResult hullResult;
+  collideMeshMesh(
+      nullptr,
+      nullptr,
+      boxMesh,
+      boxSize,
+      boxTransform,
+      boxMesh,
+      boxSize,
+      otherTransform,
+      option,
+      hullResult,
+      &hull,
+      &hull);
+  EXPECT_EQ(scanResult.getNumContacts(), hullResult.getNumContacts());
+  for (int i = 0; i < std::min(
+                      scanResult.getNumContacts(), hullResult.getNumContacts());
+       i++)
+  {
+    EXPECT_TRUE(equals(
+        scanResult.getContact(i).point, hullResult.getContact(i).point, 1e-9));
+  }
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(DARTCollide, MESH_WITNESS_POINTS)
 {
@@ -31,17 +31,20 @@
  */
 
 #include <iostream>
+#include <thread>
 
-#ifdef HAVE_PERF_UTILS
-
-#include <PerfUtils/TimeTrace.h>
 #include <gtest/gtest.h>
 
 #include "dart/performance/PerformanceLog.hpp"
 
+#ifdef HAVE_PERF_UTILS
+#include <PerfUtils/TimeTrace.h>
+#endif
+
 using namespace dart;
 using namespace dart::performance;
 
+#ifdef HAVE_PERF_UTILS
 TEST(PERFORMANCE, TIME_TRACE)
 {
   uint64_t start = PerfUtils::Cycles::rdtsc();
@@ -53,6 +56,7 @@ TEST(PERFORMANCE, TIME_TRACE)
   std::cout << PerfUtils::TimeTrace::getTrace() << std::endl;
   std::cout << "Cycles: " << (end - start) << std::endl;
 }
+#endif
 
 TEST(PERFORMANCE, TWO_ROOTS)
 {
@@ -98,4 +102,178 @@ TEST(PERFORMANCE, NESTED)
   std::cout << finalizedRoot->prettyPrint() << std::endl;
 }
 
-#endif
\ No newline at end of file
+TEST(PERFORMANCE, HISTOGRAM)
+{
+  PerformanceHistogram histogram;
+  EXPECT_EQ(histogram.getCount(), 0);
+  EXPECT_EQ(histogram.getMin(), 0);
+  EXPECT_EQ(histogram.getPercentile(0.5), 0.0);
+
+  for (uint64_t i = 1; i <= 1000; i++)
+  {
+    histogram.record(i);
+  }
+  EXPECT_EQ(histogram.getCount(), 1000);
+  EXPECT_EQ(histogram.getTotal(), 500500);
+  EXPECT_EQ(histogram.getMin(), 1);
+  EXPECT_EQ(histogram.getMax(), 1000);
+  EXPECT_DOUBLE_EQ(histogram.getMean(), 500.5);
+  EXPECT_EQ(PerformanceHistogram::getBucket(0), 0);
+  EXPECT_EQ(PerformanceHistogram::getBucket(1), 1);
+  EXPECT_EQ(PerformanceHistogram::getBucket(1000), 10);
+  EXPECT_EQ(histogram.getBuckets()[10], 1000 - 511);
+
+  // The buckets are powers of two, so percentiles are only good to within a
+  // factor of two
+  EXPECT_GE(histogram.getPercentile(0.5), 250);
+  EXPECT_LE(histogram.getPercentile(0.5), 1000);
+  EXPECT_EQ(histogram.getPercentile(0.0), 1);
+  EXPECT_EQ(histogram.getPercentile(1.0), 1000);
+
+  PerformanceHistogram other;
+  other.record(5000);
+  histogram.merge(other);
+  EXPECT_EQ(histogram.getCount(), 1001);
+  EXPECT_EQ(histogram.getMax(), 5000);
+}
+
+TEST(PERFORMANCE, RECYCLES_SCOPED_LOGS)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  PerformanceLog* first;
+  {
+    ScopedPerformanceLog child(root, "child");
+    first = child.get();
+  }
+  for (int i = 0; i < 10000; i++)
+  {
+    ScopedPerformanceLog child(root, "child");
+    // We should keep getting the same object back, rather than allocating
+    EXPECT_EQ(child.get(), first);
+  }
+  root->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  EXPECT_EQ(finalizedRoots["root"]->getChild("child")->getNumRuns(), 10001);
+}
+
+TEST(PERFORMANCE, ENDED_LOGS_STAY_VALID)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  PerformanceLog* first = root->startRun("child");
+  first->end();
+  PerformanceLog* second = root->startRun("child");
+  // Ending a log doesn't hand it out again, so a pointer kept around after
+  // end() never aliases a later run
+  EXPECT_NE(first, second);
+  second->end();
+  second->end();
+  first->end();
+  root->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  EXPECT_EQ(finalizedRoots["root"]->getNumRuns(), 1);
+  EXPECT_EQ(finalizedRoots["root"]->getChild("child")->getNumRuns(), 2);
+}
+
+TEST(PERFORMANCE, SAMPLING)
+{
+  PerformanceLog::initialize();
+  PerformanceLog::setSamplingRate(0.25);
+  for (int i = 0; i < 100; i++)
+  {
+    PerformanceLog* root = PerformanceLog::startRoot("sampledRoot");
+    PerformanceLog* child = root->startRun("child");
+    child->startRun("grandchild")->end();
+    child->end();
+    root->end();
+  }
+  PerformanceLog::setSamplingRate(1.0);
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  std::shared_ptr<FinalizedPerformanceLog> root
+      = finalizedRoots["sampledRoot"];
+  ASSERT_NE(root, nullptr);
+  // Children follow the decision made for their root
+  EXPECT_EQ(root->getNumRuns(), 25);
+  EXPECT_EQ(root->getChild("child")->getNumRuns(), 25);
+  EXPECT_EQ(
+      root->getChild("child")->getChild("grandchild")->getNumRuns(), 25);
+}
+
+TEST(PERFORMANCE, MULTITHREADED)
+{
+  PerformanceLog::initialize();
+  const int numThreads = 4;
+  const int numRuns = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++)
+  {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < numRuns; i++)
+      {
+        PerformanceLog* root = PerformanceLog::startRoot("threadedRoot");
+        root->startRun("child")->end();
+        root->end();
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  EXPECT_EQ(finalizedRoots.size(), 1);
+  std::shared_ptr<FinalizedPerformanceLog> root
+      = finalizedRoots["threadedRoot"];
+  EXPECT_EQ(root->getNumRuns(), numThreads * numRuns);
+  EXPECT_EQ(root->getChild("child")->getNumRuns(), numThreads * numRuns);
+  EXPECT_LE(
+      root->getChild("child")->getMaxRuntime(), root->getMaxRuntime());
+}
+
+TEST(PERFORMANCE, CHROME_TRACE)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("traceRoot");
+  root->startRun("traceChild")->end();
+  root->end();
+  std::thread([]() {
+    PerformanceLog::startRoot("otherThread")->end();
+  }).join();
+
+  std::string trace = PerformanceLog::toChromeTrace();
+  EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+  EXPECT_NE(trace.find("\"name\":\"traceChild\""), std::string::npos);
+  EXPECT_NE(
+      trace.find("\"path\":\"traceRoot/traceChild\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"otherThread\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"M\""), std::string::npos);
+
+  std::string json = PerformanceLog::finalize()["traceRoot"]->toJson();
+  EXPECT_EQ(json.find("{\"name\":\"traceRoot\",\"runs\":1,"), 0);
+  EXPECT_NE(
+      json.find("\"children\":[{\"name\":\"traceChild\""),
+      std::string::npos);
+
+  // Each thread should have been given its own tid
+  std::size_t firstTid = trace.find("\"name\":\"thread_name\"");
+  ASSERT_NE(firstTid, std::string::npos);
+  EXPECT_NE(
+      trace.find("\"name\":\"thread_name\"", firstTid + 1),
+      std::string::npos);
+
+  // A fresh initialize() should throw away the old events
+  PerformanceLog::initialize();
+  trace = PerformanceLog::toChromeTrace();
+  EXPECT_EQ(trace.find("traceChild"), std::string::npos);
+  EXPECT_EQ(PerformanceLog::finalize().size(), 0);
+}
@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 
 #include "dart/dart.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/utils/utils.hpp"
 
 #include "TestHelpers.hpp"
@@ -251,4 +252,51 @@ TEST(RL_API, TEST_REMOVE_NON_EXISTENT_CUSTOM_ACTION)
   std::vector<int> recoveredActionSpace = world->getActionSpace();
   EXPECT_EQ(1, recoveredActionSpace.size());
   EXPECT_EQ(5, recoveredActionSpace[0]);
-}
\ No newline at end of file
+}
+
+//==============================================================================
+TEST(RL_API, TEST_STEP_BATCH_MATCHES_STEP)
+{
+  std::shared_ptr<simulation::World> world
+      = UniversalLoader::loadWorld("dart://sample/skel/half_cheetah.skel");
+  std::vector<int> actionSpace;
+  for (int i = 3; i < world->getNumDofs(); i++)
+    actionSpace.push_back(i);
+  world->setActionSpace(actionSpace);
+
+  const int numCopies = 20;
+  Eigen::MatrixXs states
+      = Eigen::MatrixXs::Zero(world->getStateSize(), numCopies);
+  Eigen::MatrixXs actions
+      = Eigen::MatrixXs::Random(world->getActionSize(), numCopies);
+  for (int i = 0; i < numCopies; i++)
+  {
+    states.col(i) = world->getState();
+    states.col(i).tail(world->getNumDofs())
+        = Eigen::VectorXs::Random(world->getNumDofs());
+  }
+  const Eigen::VectorXs originalState = world->getState();
+
+  std::vector<std::shared_ptr<neural::BackpropSnapshot>> snapshots;
+  Eigen::MatrixXs nextStates = world->stepBatch(states, actions, &snapshots);
+  EXPECT_EQ(snapshots.size(), numCopies);
+  // Stepping the batch shouldn't change the world itself
+  EXPECT_TRUE(equals(world->getState(), originalState, 0));
+
+  // Doing it again should reuse the replicas, and get the same answers
+  Eigen::MatrixXs nextStatesAgain = world->stepBatch(states, actions);
+  EXPECT_TRUE(equals(nextStates, nextStatesAgain, 1e-12));
+
+  std::shared_ptr<simulation::World> clone = world->clone();
+  for (int i = 0; i < numCopies; i++)
+  {
+    clone->setState(states.col(i));
+    clone->setAction(actions.col(i));
+    clone->setCachedLCPSolution(world->getCachedLCPSolution());
+    clone->step();
+    Eigen::VectorXs nextState = nextStates.col(i);
+    EXPECT_TRUE(equals(clone->getState(), nextState, 1e-12));
+    Eigen::VectorXs nextPos = nextState.head(world->getNumDofs());
+    EXPECT_TRUE(equals(snapshots[i]->getPostStepPosition(), nextPos, 1e-12));
+  }
+}
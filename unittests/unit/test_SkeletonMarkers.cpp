@@ -206,4 +206,94 @@ TEST(SkeletonConverter, MARKER_DISTANCE)
     EXPECT_TRUE(equals(axisGroupGrad, axisGroupGrad_fd, 1e-10));
   }
 }
+#endif
+
+#ifdef ALL_TESTS
+TEST(SkeletonMarkers, INCREMENTAL_BODY_WORLD_TRANSFORMS)
+{
+  std::shared_ptr<dynamics::Skeleton> osim
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+  osim->setBodyScales(
+      Eigen::VectorXs::Ones(osim->getNumBodyNodes() * 3)
+      + Eigen::VectorXs::Random(osim->getNumBodyNodes() * 3) * 0.1);
+
+  std::vector<Eigen::Isometry3s> transforms;
+  std::vector<std::size_t> dofs;
+  dofs.push_back(0);
+  Eigen::VectorXs positions = Eigen::VectorXs::Zero(1);
+
+  // An empty buffer gets filled from scratch
+  EXPECT_EQ(
+      osim->setPositionsAndUpdateBodyWorldTransforms(
+          dofs, positions, transforms),
+      osim->getNumBodyNodes());
+
+  // Setting a DOF to the value it already has doesn't recompute anything
+  positions(0) = osim->getPosition(0);
+  EXPECT_EQ(
+      osim->setPositionsAndUpdateBodyWorldTransforms(
+          dofs, positions, transforms),
+      0);
+
+  // Moving a single joint only recomputes the bodies below it
+  dynamics::Joint* knee = osim->getJoint("walker_knee_r");
+  int numBelowKnee = 0;
+  for (int i = 0; i < osim->getNumBodyNodes(); i++)
+  {
+    if (osim->getBodyNode(i)->descendsFrom(knee->getChildBodyNode()))
+    {
+      numBelowKnee++;
+    }
+  }
+  dofs[0] = knee->getDof(0)->getIndexInSkeleton();
+  positions(0) = 0.5;
+  EXPECT_EQ(
+      osim->setPositionsAndUpdateBodyWorldTransforms(
+          dofs, positions, transforms),
+      numBelowKnee);
+  EXPECT_LT(numBelowKnee, osim->getNumBodyNodes());
+
+  // Moving a joint and one of its ancestors only visits the shared subtree
+  // once
+  dynamics::Joint* hip = osim->getJoint("hip_r");
+  int numBelowHip = 0;
+  for (int i = 0; i < osim->getNumBodyNodes(); i++)
+  {
+    if (osim->getBodyNode(i)->descendsFrom(hip->getChildBodyNode()))
+    {
+      numBelowHip++;
+    }
+  }
+  dofs.clear();
+  dofs.push_back(knee->getDof(0)->getIndexInSkeleton());
+  dofs.push_back(hip->getDof(0)->getIndexInSkeleton());
+  dofs.push_back(hip->getDof(1)->getIndexInSkeleton());
+  positions = Eigen::VectorXs::Constant(3, 0.2);
+  EXPECT_EQ(
+      osim->setPositionsAndUpdateBodyWorldTransforms(
+          dofs, positions, transforms),
+      numBelowHip);
+
+  for (int i = 0; i < 10; i++)
+  {
+    dofs.clear();
+    for (int j = 0; j < 3; j++)
+    {
+      dofs.push_back(rand() % osim->getNumDofs());
+    }
+    positions = Eigen::VectorXs::Random(3);
+    osim->setPositionsAndUpdateBodyWorldTransforms(dofs, positions, transforms);
+
+    // The buffer should match what DART computes from scratch
+    for (int b = 0; b < osim->getNumBodyNodes(); b++)
+    {
+      EXPECT_TRUE(equals(
+          transforms[b].matrix(),
+          osim->getBodyNode(b)->getWorldTransform().matrix(),
+          1e-12));
+    }
+  }
+}
 #endif
\ No newline at end of file
@@ -1,7 +1,12 @@
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -69,4 +74,96 @@ TEST(StreamingIK, LIMIT_TEST)
   }
   // }
 }
-// #endif
\ No newline at end of file
+// #endif
+
+/// This loads a model with markers into a StreamingIK, and the first frame of a
+/// recorded trial, ready to pass to observeMarkers()
+std::shared_ptr<StreamingIK> createStreamingIK(
+    std::vector<Eigen::Vector3s>& frameMarkers, std::vector<int>& classes)
+{
+  OpenSimFile standard = OpenSimParser::parseOsim(
+      "dart://sample/osim/IncompleteIK/Models/"
+      "optimized_scale_and_markers.osim");
+  OpenSimTRC trc = OpenSimParser::loadTRC(
+      "dart://sample/osim/IncompleteIK/MarkerData/markers_smpl.trc");
+
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  std::map<std::string, int> markerNameToIndex;
+  for (auto& pair : standard.markersMap)
+  {
+    markerNameToIndex[pair.first]
+        = standard.skeleton->getNumBodyNodes() + markers.size();
+    markers.push_back(pair.second);
+  }
+  for (auto& marker : trc.markerTimesteps[0])
+  {
+    if (markerNameToIndex.count(marker.first) > 0)
+    {
+      frameMarkers.push_back(marker.second);
+      classes.push_back(markerNameToIndex[marker.first]);
+    }
+  }
+  return std::make_shared<StreamingIK>(standard.skeleton, markers);
+}
+
+TEST(StreamingIK, REAL_TIME_STOPS_AT_BUDGET)
+{
+  std::vector<Eigen::Vector3s> frameMarkers;
+  std::vector<int> classes;
+  std::shared_ptr<StreamingIK> ik = createStreamingIK(frameMarkers, classes);
+  ik->setRealTimeMode(2000);
+  ik->startSolverThread();
+
+  std::vector<Eigen::Vector9s> copTorqueForces;
+  ik->observeMarkers(frameMarkers, classes, 0, copTorqueForces);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  EXPECT_EQ(ik->getNumFramesSolved(), 1);
+  EXPECT_EQ(ik->getNumFramesDropped(), 0);
+  EXPECT_EQ(ik->getLatencyHistogram().getCount(), 1);
+
+  // Once the budget has run out, the solver idles until the next frame, so the
+  // pose stops changing
+  Eigen::VectorXs pose = ik->getLastPose();
+  EXPECT_GT(pose.size(), 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(pose, ik->getLastPose());
+}
+
+TEST(StreamingIK, REAL_TIME_DROPS_STALE_FRAMES)
+{
+  std::vector<Eigen::Vector3s> frameMarkers;
+  std::vector<int> classes;
+  std::shared_ptr<StreamingIK> ik = createStreamingIK(frameMarkers, classes);
+  ik->startSolverThread();
+
+  // Switching modes applies to a solver that's already running
+  ik->setRealTimeMode(2000, 10000);
+
+  // This frame arrived long before it reaches the IK, so it's already stale
+  std::vector<Eigen::Vector9s> copTorqueForces;
+  ik->observeMarkers(
+      frameMarkers,
+      classes,
+      0,
+      copTorqueForces,
+      std::chrono::steady_clock::now() - std::chrono::seconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(ik->getNumFramesSolved(), 0);
+  EXPECT_EQ(ik->getNumFramesDropped(), 1);
+  EXPECT_EQ(ik->getLatencyHistogram().getCount(), 0);
+
+  // A burst of frames faster than the solver can keep up with gets some frames
+  // overwritten, but every frame is either solved or dropped exactly once
+  ik->setRealTimeMode(2000);
+  ik->resetLatencyStats();
+  const int numFrames = 20;
+  for (int i = 0; i < numFrames; i++)
+  {
+    ik->observeMarkers(frameMarkers, classes, i + 1, copTorqueForces);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_GE(ik->getNumFramesSolved(), 1);
+  EXPECT_EQ(ik->getNumFramesSolved() + ik->getNumFramesDropped(), numFrames);
+  EXPECT_EQ(ik->getLatencyHistogram().getCount(), ik->getNumFramesSolved());
+}
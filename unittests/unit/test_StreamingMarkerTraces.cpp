@@ -135,4 +135,70 @@ TEST(MARKER_TRACES_BASICS, MAKING_MIXED_FEATURES)
   // std::endl; std::cout << "Trace IDs: " << std::endl << traceIDs <<
   // std::endl;
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(MARKER_TRACES_BASICS, DENSE_CLOUD_KEEPS_TRACES)
+{
+  int numClasses = 5;
+  StreamingMarkerTraces markerTraces(numClasses, 20);
+
+  // A 6x5x5 lattice of markers 5cm apart, which is well inside the default
+  // join distance, all moving together
+  std::vector<Eigen::Vector3s> lattice;
+  for (int x = 0; x < 6; x++)
+  {
+    for (int y = 0; y < 5; y++)
+    {
+      for (int z = 0; z < 5; z++)
+      {
+        lattice.push_back(Eigen::Vector3s(x, y, z) * 0.05);
+      }
+    }
+  }
+
+  std::vector<int> firstTags;
+  for (int t = 0; t < 20; t++)
+  {
+    std::vector<Eigen::Vector3s> markers;
+    for (int m = 0; m < lattice.size(); m++)
+    {
+      markers.push_back(
+          lattice[m] + Eigen::Vector3s(0.01, 0.005, 0.0) * t
+          + Eigen::Vector3s::Random() * 0.001);
+    }
+    // Shuffle the order the markers arrive in, so we can't just rely on it
+    std::vector<int> order;
+    for (int m = 0; m < markers.size(); m++)
+    {
+      order.push_back((m * 37 + t * 11) % markers.size());
+    }
+    std::vector<Eigen::Vector3s> shuffled;
+    for (int m : order)
+    {
+      shuffled.push_back(markers[m]);
+    }
+
+    std::vector<int> tags
+        = markerTraces.observeMarkers(shuffled, t * 10).second;
+    EXPECT_EQ(tags.size(), lattice.size());
+    EXPECT_EQ(markerTraces.getNumTraces(), lattice.size());
+
+    std::vector<int> unshuffledTags(lattice.size());
+    for (int k = 0; k < order.size(); k++)
+    {
+      unshuffledTags[order[k]] = tags[k];
+    }
+    if (t == 1)
+    {
+      firstTags = unshuffledTags;
+    }
+    else if (t > 1)
+    {
+      for (int m = 0; m < lattice.size(); m++)
+      {
+        EXPECT_EQ(unshuffledTags[m], firstTags[m]);
+      }
+    }
+  }
+}
+#endif
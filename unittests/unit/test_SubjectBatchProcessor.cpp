@@ -0,0 +1,202 @@
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/biomechanics/SkeletonClonePool.hpp"
+#include "dart/biomechanics/SubjectBatchProcessor.hpp"
+#include "dart/common/WorkStealingPool.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/MathTypes.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+//==============================================================================
+TEST(SubjectBatchProcessor, CLONE_POOL_REUSES_AND_SYNCS)
+{
+  std::shared_ptr<dynamics::Skeleton> skel
+      = OpenSimParser::parseOsim("dart://sample/osim/FBLSmodel.osim").skeleton;
+  std::shared_ptr<SkeletonClonePool> pool
+      = std::make_shared<SkeletonClonePool>();
+
+  std::shared_ptr<dynamics::Skeleton> first = pool->acquire(skel);
+  std::shared_ptr<dynamics::Skeleton> second = pool->acquire(skel);
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(pool->getNumClonesCreated(), 2);
+  EXPECT_EQ(pool->getNumIdleClones(), 0);
+
+  dynamics::Skeleton* firstRaw = first.get();
+  first->setPositions(Eigen::VectorXs::Random(first->getNumDofs()));
+  first = nullptr;
+  second = nullptr;
+  EXPECT_EQ(pool->getNumIdleClones(), 2);
+
+  // Change the source, and check that the reused clone picks up the changes
+  skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setGroupScales(Eigen::VectorXs::Ones(skel->getGroupScaleDim()) * 1.1);
+  skel->setGroupMasses(skel->getGroupMasses() * 1.2);
+
+  std::shared_ptr<dynamics::Skeleton> reused = pool->acquire(skel);
+  std::shared_ptr<dynamics::Skeleton> reusedAgain = pool->acquire(skel);
+  EXPECT_TRUE(reused.get() == firstRaw || reusedAgain.get() == firstRaw);
+  EXPECT_EQ(pool->getNumClonesCreated(), 2);
+  EXPECT_EQ(pool->getNumClonesReused(), 2);
+  EXPECT_TRUE(reused->getPositions().isApprox(skel->getPositions()));
+  EXPECT_TRUE(reused->getGroupScales().isApprox(skel->getGroupScales()));
+  EXPECT_TRUE(reused->getGroupMasses().isApprox(skel->getGroupMasses()));
+
+  // A clone that's only held through its own getPtr() is still in use
+  std::shared_ptr<dynamics::Skeleton> selfHeld = reused->getPtr();
+  dynamics::Skeleton* selfHeldRaw = reused.get();
+  reused = nullptr;
+  EXPECT_EQ(pool->getNumIdleClones(), 0);
+  std::shared_ptr<dynamics::Skeleton> third = pool->acquire(skel);
+  EXPECT_NE(third.get(), selfHeldRaw);
+  EXPECT_EQ(pool->getNumClonesCreated(), 3);
+  third = nullptr;
+  selfHeld = nullptr;
+  EXPECT_EQ(pool->getNumIdleClones(), 2);
+
+  // Restructuring the source (even keeping the same counts) means the old
+  // clones can't be reused
+  skel->getBodyNode(0)->setName("renamed_root");
+  std::shared_ptr<dynamics::Skeleton> restructured = pool->acquire(skel);
+  EXPECT_EQ(pool->getNumClonesCreated(), 4);
+  EXPECT_EQ(restructured->getBodyNode(0)->getName(), "renamed_root");
+
+  // Clones of a destroyed source are dropped, not handed out again
+  restructured = nullptr;
+  reusedAgain = nullptr;
+  skel = nullptr;
+  std::shared_ptr<dynamics::Skeleton> other
+      = OpenSimParser::parseOsim("dart://sample/osim/FBLSmodel.osim").skeleton;
+  std::shared_ptr<dynamics::Skeleton> otherClone = pool->acquire(other);
+  EXPECT_EQ(pool->getNumClonesCreated(), 5);
+  EXPECT_EQ(pool->getNumIdleClones(), 0);
+}
+
+//==============================================================================
+TEST(SubjectBatchProcessor, CLONE_POOL_SYNCS_PER_LINK_STATE)
+{
+  std::shared_ptr<dynamics::Skeleton> skel
+      = OpenSimParser::parseOsim("dart://sample/osim/FBLSmodel.osim").skeleton;
+  skel->getBodyNode(0)->createMarker(std::string("test_marker"));
+  std::shared_ptr<SkeletonClonePool> pool
+      = std::make_shared<SkeletonClonePool>();
+
+  dynamics::Skeleton* firstRaw = pool->acquire(skel).get();
+  EXPECT_EQ(pool->getNumIdleClones(), 1);
+
+  // Change the source one link, joint and DOF at a time, rather than through
+  // the scale groups
+  Eigen::VectorXs masses = skel->getLinkMasses();
+  masses(1) *= 1.5;
+  skel->setLinkMasses(masses);
+  skel->setLinkCOMs(
+      skel->getLinkCOMs()
+      + Eigen::VectorXs::Constant(skel->getLinkCOMDims(), 0.01));
+  skel->setLinkMOIs(skel->getLinkMOIs() * 1.1);
+  Eigen::Isometry3s jointOffset
+      = skel->getJoint(1)->getTransformFromParentBodyNode();
+  jointOffset.translation() += Eigen::Vector3s(0.01, 0.02, 0.03);
+  skel->getJoint(1)->setTransformFromParentBodyNode(jointOffset);
+  skel->getDof(0)->setDampingCoefficient(0.3);
+  skel->getDof(0)->setSpringStiffness(2.0);
+  skel->getDof(0)->setRestPosition(0.1);
+  skel->getDof(0)->setCoulombFriction(0.05);
+  skel->getMarker(0)->setLocalPosition(Eigen::Vector3s(0.1, 0.2, 0.3));
+
+  std::shared_ptr<dynamics::Skeleton> reused = pool->acquire(skel);
+  EXPECT_EQ(reused.get(), firstRaw);
+  EXPECT_EQ(pool->getNumClonesCreated(), 1);
+  EXPECT_TRUE(reused->getLinkMasses().isApprox(skel->getLinkMasses()));
+  EXPECT_TRUE(reused->getLinkCOMs().isApprox(skel->getLinkCOMs()));
+  EXPECT_TRUE(reused->getLinkMOIs().isApprox(skel->getLinkMOIs()));
+  EXPECT_TRUE(reused->getLinkBetas().isApprox(skel->getLinkBetas()));
+  EXPECT_TRUE(reused->getJoint(1)->getTransformFromParentBodyNode().isApprox(
+      skel->getJoint(1)->getTransformFromParentBodyNode()));
+  EXPECT_EQ(reused->getDof(0)->getDampingCoefficient(), 0.3);
+  EXPECT_EQ(reused->getDof(0)->getSpringStiffness(), 2.0);
+  EXPECT_EQ(reused->getDof(0)->getRestPosition(), 0.1);
+  EXPECT_EQ(reused->getDof(0)->getCoulombFriction(), 0.05);
+  EXPECT_TRUE(reused->getMarker(0)->getLocalPosition().isApprox(
+      Eigen::Vector3s(0.1, 0.2, 0.3)));
+  for (int i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    EXPECT_TRUE(reused->getBodyNode(i)->getWorldTransform().isApprox(
+        skel->getBodyNode(i)->getWorldTransform()));
+  }
+  reused = nullptr;
+
+  // Adding a marker changes the structure, so the old clone isn't reused
+  skel->getBodyNode(1)->createMarker(std::string("another_marker"));
+  std::shared_ptr<dynamics::Skeleton> fresh = pool->acquire(skel);
+  EXPECT_EQ(pool->getNumClonesCreated(), 2);
+  EXPECT_EQ(fresh->getNumMarkers(), 2);
+}
+
+//==============================================================================
+TEST(SubjectBatchProcessor, RUNS_ALL_SUBJECTS_ON_SHARED_POOL)
+{
+  std::shared_ptr<common::WorkStealingPool> globalPool
+      = common::WorkStealingPool::getGlobalPool();
+  const int previousThreads = globalPool->getNumThreads();
+
+  SubjectBatchProcessor processor(4, 2);
+  EXPECT_EQ(processor.getNumCores(), 4);
+  EXPECT_EQ(processor.getMaxSubjectsInFlight(), 2);
+
+  const int numSubjects = 6;
+  std::vector<std::atomic<int>> sums(numSubjects);
+  std::vector<int> poolThreads(numSubjects, -1);
+  for (int i = 0; i < numSubjects; i++)
+  {
+    sums[i] = 0;
+    auto kinematics = [&, i]() {
+      // 4 cores, minus 2 coordinators
+      poolThreads[i]
+          = common::WorkStealingPool::getCurrentPool()->getNumThreads();
+      // Stand in for the IK blocks
+      common::WorkStealingPool::getCurrentPool()->parallelFor(
+          0, 100, 1, [&](int, int begin, int end) {
+            for (int j = begin; j < end; j++)
+            {
+              sums[i] += j;
+            }
+          });
+    };
+    auto dynamics = [&, i]() {
+      if (i == 3)
+      {
+        throw std::runtime_error("bad subject");
+      }
+      sums[i] += 1;
+    };
+    processor.addSubject("subject" + std::to_string(i), kinematics, dynamics);
+  }
+  EXPECT_EQ(processor.getNumSubjects(), numSubjects);
+
+  std::vector<SubjectBatchResult> results = processor.run();
+  ASSERT_EQ(results.size(), numSubjects);
+  for (int i = 0; i < numSubjects; i++)
+  {
+    EXPECT_EQ(results[i].name, "subject" + std::to_string(i));
+    EXPECT_EQ(sums[i], i == 3 ? 4950 : 4951);
+    EXPECT_EQ(poolThreads[i], 2);
+    EXPECT_EQ(results[i].success, i != 3);
+  }
+  EXPECT_EQ(results[3].error, "bad subject");
+  EXPECT_EQ(processor.getNumSucceeded(), numSubjects - 1);
+  EXPECT_GT(processor.getSubjectsPerHour(), 0);
+  EXPECT_EQ(processor.getSchedulingStats().numLoops, numSubjects);
+
+  // The global pool is never touched
+  EXPECT_EQ(common::WorkStealingPool::getGlobalPool(), globalPool);
+  EXPECT_EQ(globalPool->getNumThreads(), previousThreads);
+  EXPECT_EQ(common::WorkStealingPool::getCurrentPool(), globalPool);
+}
@@ -13,6 +13,7 @@
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/biomechanics/SkeletonConverter.hpp"
 #include "dart/biomechanics/SubjectOnDisk.hpp"
+#include "dart/biomechanics/SubjectOnDiskBatchLoader.hpp"
 #include "dart/biomechanics/enums.hpp"
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/BodyNode.hpp"
@@ -1183,6 +1184,262 @@ TEST(SubjectOnDisk, READ_BACK_DATA)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(SubjectOnDisk, MEMORY_MAPPED_READS_MATCH_BUFFERED_READS)
+{
+  auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
+  newRetriever->addSchemaRetriever(
+      "dart", utils::DartResourceRetriever::create());
+  std::string path = newRetriever->getFilePath("dart://sample/b3d/results.b3d");
+
+  SubjectOnDisk buffered(path);
+  SubjectOnDisk mapped(path);
+  EXPECT_FALSE(mapped.getUseMemoryMap());
+  EXPECT_TRUE(mapped.setUseMemoryMap(true));
+  EXPECT_TRUE(mapped.getUseMemoryMap());
+
+  for (int trial = 0; trial < buffered.getNumTrials(); trial++)
+  {
+    const int len = buffered.getTrialLength(trial);
+    for (int start : {0, len / 2, std::max(0, len - 3)})
+    {
+      std::vector<std::shared_ptr<Frame>> expected
+          = buffered.readFrames(trial, start, 5, true, true, 2);
+      std::vector<std::shared_ptr<Frame>> actual
+          = mapped.readFrames(trial, start, 5, true, true, 2);
+      ASSERT_EQ(expected.size(), actual.size());
+      for (int i = 0; i < expected.size(); i++)
+      {
+        EXPECT_EQ(expected[i]->t, actual[i]->t);
+        EXPECT_EQ(
+            expected[i]->markerObservations.size(),
+            actual[i]->markerObservations.size());
+        ASSERT_EQ(
+            expected[i]->processingPasses.size(),
+            actual[i]->processingPasses.size());
+        for (int pass = 0; pass < expected[i]->processingPasses.size(); pass++)
+        {
+          EXPECT_TRUE(equals(
+              expected[i]->processingPasses[pass]->pos,
+              actual[i]->processingPasses[pass]->pos));
+          EXPECT_TRUE(equals(
+              expected[i]->processingPasses[pass]->tau,
+              actual[i]->processingPasses[pass]->tau));
+        }
+      }
+    }
+  }
+
+  // Turning the map back off should fall back to buffered reads
+  EXPECT_FALSE(mapped.setUseMemoryMap(false));
+  EXPECT_FALSE(mapped.getUseMemoryMap());
+  EXPECT_EQ(
+      buffered.readFrames(0, 0, 3).size(), mapped.readFrames(0, 0, 3).size());
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(SubjectOnDisk, COLUMNAR_READS_MATCH_ROW_READS)
+{
+  auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
+  newRetriever->addSchemaRetriever(
+      "dart", utils::DartResourceRetriever::create());
+  std::string path = newRetriever->getFilePath("dart://sample/b3d/results.b3d");
+
+  SubjectOnDisk rows(path);
+  EXPECT_FALSE(rows.isColumnar());
+
+  // Re-write the same subject in the columnar format
+  SubjectOnDisk loaded(path);
+  loaded.loadAllFrames(true);
+  std::string columnarPath = "./testSubjectColumnar.b3d";
+  SubjectOnDisk::writeB3D(columnarPath, loaded.getHeaderProto(), true);
+
+  SubjectOnDisk columns(columnarPath);
+  EXPECT_TRUE(columns.isColumnar());
+  ASSERT_EQ(rows.getNumTrials(), columns.getNumTrials());
+
+  for (int trial = 0; trial < rows.getNumTrials(); trial++)
+  {
+    ASSERT_EQ(rows.getTrialLength(trial), columns.getTrialLength(trial));
+    const int len = rows.getTrialLength(trial);
+    for (int start : {0, len / 2})
+    {
+      // readFrames() should assemble the same frames out of the columns
+      std::vector<std::shared_ptr<Frame>> expected
+          = rows.readFrames(trial, start, 4, true, true, 3);
+      std::vector<std::shared_ptr<Frame>> actual
+          = columns.readFrames(trial, start, 4, true, true, 3);
+      ASSERT_EQ(expected.size(), actual.size());
+      for (int i = 0; i < expected.size(); i++)
+      {
+        EXPECT_EQ(expected[i]->t, actual[i]->t);
+        EXPECT_EQ(
+            expected[i]->markerObservations.size(),
+            actual[i]->markerObservations.size());
+        ASSERT_EQ(
+            expected[i]->processingPasses.size(),
+            actual[i]->processingPasses.size());
+        for (int pass = 0; pass < expected[i]->processingPasses.size(); pass++)
+        {
+          EXPECT_TRUE(equals(
+              expected[i]->processingPasses[pass]->pos,
+              actual[i]->processingPasses[pass]->pos));
+          EXPECT_TRUE(equals(
+              expected[i]->processingPasses[pass]->tau,
+              actual[i]->processingPasses[pass]->tau));
+          EXPECT_TRUE(equals(
+              expected[i]->processingPasses[pass]->groundContactWrenches,
+              actual[i]->processingPasses[pass]->groundContactWrenches));
+        }
+      }
+
+      // Single column reads should agree between the two layouts
+      for (int pass = 0; pass < rows.getTrialNumProcessingPasses(trial);
+           pass++)
+      {
+        for (std::string column : {"pos", "vel", "tau", "com_acc"})
+        {
+          Eigen::MatrixXs expectedColumn
+              = rows.readProcessingPassColumn(trial, pass, column, start, 10);
+          Eigen::MatrixXs actualColumn = columns.readProcessingPassColumn(
+              trial, pass, column, start, 10);
+          EXPECT_GT(expectedColumn.cols(), 0);
+          EXPECT_TRUE(equals(expectedColumn, actualColumn));
+        }
+      }
+      Eigen::MatrixXs expectedMarkers
+          = rows.readSensorColumn(trial, "marker_obs", start, 10, 2);
+      Eigen::MatrixXs actualMarkers
+          = columns.readSensorColumn(trial, "marker_obs", start, 10, 2);
+      EXPECT_EQ(expectedMarkers.rows(), actualMarkers.rows());
+      EXPECT_EQ(expectedMarkers.cols(), actualMarkers.cols());
+    }
+  }
+
+  // Unknown columns return an empty matrix
+  EXPECT_EQ(columns.readProcessingPassColumn(0, 0, "not_a_column", 0).size(), 0);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(SubjectOnDisk, BATCH_LOADER_MATCHES_DIRECT_READS)
+{
+  auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
+  newRetriever->addSchemaRetriever(
+      "dart", utils::DartResourceRetriever::create());
+  std::string path = newRetriever->getFilePath("dart://sample/b3d/results.b3d");
+
+  std::vector<std::shared_ptr<SubjectOnDisk>> subjects;
+  subjects.push_back(std::make_shared<SubjectOnDisk>(path));
+  subjects.push_back(std::make_shared<SubjectOnDisk>(path));
+  subjects[1]->setUseMemoryMap(true);
+
+  const int windowSize = 5;
+  const int stride = 2;
+  srand(42);
+  std::vector<SubjectOnDiskSample> plan;
+  for (int i = 0; i < 23; i++)
+  {
+    SubjectOnDiskSample sample;
+    sample.subject = i % 2;
+    sample.trial = rand() % subjects[0]->getNumTrials();
+    const int len = subjects[0]->getTrialLength(sample.trial);
+    sample.startFrame
+        = rand() % std::max(1, len - (windowSize * stride));
+    plan.push_back(sample);
+  }
+
+  SubjectOnDiskBatchLoader loader(
+      subjects,
+      plan,
+      4,
+      windowSize,
+      stride,
+      0,
+      std::vector<std::string>({"pos", "tau"}),
+      std::vector<std::string>(),
+      3,
+      2);
+  EXPECT_EQ(loader.getNumBatches(), 6);
+  std::vector<int> dims = loader.getPassColumnDims();
+  ASSERT_EQ(dims.size(), 2);
+  EXPECT_EQ(dims[0], subjects[0]->getNumDofs());
+
+  int sampleIndex = 0;
+  std::shared_ptr<SubjectOnDiskBatch> batch;
+  while ((batch = loader.nextBatch()) != nullptr)
+  {
+    ASSERT_EQ(batch->passColumns.size(), 2);
+    for (int s = 0; s < batch->samples.size(); s++)
+    {
+      const SubjectOnDiskSample& sample = plan[sampleIndex];
+      EXPECT_EQ(batch->samples[s].trial, sample.trial);
+      EXPECT_EQ(batch->samples[s].startFrame, sample.startFrame);
+      Eigen::MatrixXs expected = subjects[0]->readProcessingPassColumn(
+          sample.trial, 0, "pos", sample.startFrame, windowSize, stride);
+      Eigen::MatrixXs actual = Eigen::Map<Eigen::MatrixXs>(
+          batch->passColumns[0].col(s).data(), dims[0], windowSize);
+      EXPECT_TRUE(equals(expected, actual));
+      sampleIndex++;
+    }
+  }
+  EXPECT_EQ(sampleIndex, plan.size());
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(SubjectOnDisk, BATCH_LOADER_RETHROWS_DECODE_ERRORS)
+{
+  auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
+  newRetriever->addSchemaRetriever(
+      "dart", utils::DartResourceRetriever::create());
+  std::string path = newRetriever->getFilePath("dart://sample/b3d/results.b3d");
+
+  SubjectOnDisk loaded(path);
+  loaded.loadAllFrames(true);
+  std::string corruptPath = "./testSubjectCorrupt.b3d";
+  SubjectOnDisk::writeB3D(corruptPath, loaded.getHeaderProto(), true);
+
+  std::vector<std::shared_ptr<SubjectOnDisk>> subjects;
+  subjects.push_back(std::make_shared<SubjectOnDisk>(corruptPath));
+  std::vector<SubjectOnDiskSample> plan;
+  for (int i = 0; i < 3; i++)
+  {
+    SubjectOnDiskSample sample;
+    sample.subject = 0;
+    sample.trial = 0;
+    sample.startFrame = i;
+    plan.push_back(sample);
+  }
+  SubjectOnDiskBatchLoader loader(
+      subjects,
+      plan,
+      1,
+      2,
+      1,
+      0,
+      std::vector<std::string>({"pos"}),
+      std::vector<std::string>(),
+      2,
+      2);
+
+  // Cut the data section off the file after the header has been read, so
+  // every column read on the workers fails
+  FILE* file = fopen(corruptPath.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  fclose(file);
+
+  // Each failed batch is rethrown on this thread, rather than taking down the
+  // process from a worker
+  for (int i = 0; i < loader.getNumBatches(); i++)
+  {
+    EXPECT_ANY_THROW(loader.nextBatch());
+  }
+  EXPECT_EQ(loader.nextBatch(), nullptr);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(SubjectOnDisk, READ_RUNNING_TRIAL)
 {
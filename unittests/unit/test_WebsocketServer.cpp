@@ -0,0 +1,144 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/server/WebsocketServer.hpp"
+
+/// This lets us control how many bytes each client has waiting to go out,
+/// and records what gets sent to whom, without any real sockets
+class BufferedBytesWebsocketServer : public WebsocketServer
+{
+public:
+  void addClient(ClientConnection conn)
+  {
+    openConnections.push_back(conn);
+  }
+
+  void sendShared(ClientConnection conn, const SharedMessage& message) override
+  {
+    sent[conn].push_back(message);
+  }
+
+  std::map<ClientConnection, size_t, std::owner_less<ClientConnection>>
+      bufferedBytes;
+  std::map<
+      ClientConnection,
+      std::vector<SharedMessage>,
+      std::owner_less<ClientConnection>>
+      sent;
+
+protected:
+  size_t getBufferedBytes(ClientConnection conn) override
+  {
+    auto it = bufferedBytes.find(conn);
+    return it == bufferedBytes.end() ? 0 : it->second;
+  }
+};
+
+bool containsClient(
+    const std::vector<ClientConnection>& clients, ClientConnection conn)
+{
+  for (ClientConnection client : clients)
+  {
+    if (!client.owner_before(conn) && !conn.owner_before(client))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+TEST(WEBSOCKET_SERVER, PREPARED_MESSAGE_FRAMING)
+{
+  SharedMessage binary = WebsocketServer::prepareBinaryMessage("hello");
+  EXPECT_TRUE(binary->get_prepared());
+  EXPECT_EQ(binary->get_opcode(), websocketpp::frame::opcode::binary);
+  EXPECT_EQ(binary->get_header(), std::string("\x82\x05", 2));
+  EXPECT_EQ(binary->get_payload(), "hello");
+
+  SharedMessage text = WebsocketServer::prepareTextMessage("hello");
+  EXPECT_TRUE(text->get_prepared());
+  EXPECT_EQ(text->get_opcode(), websocketpp::frame::opcode::text);
+  EXPECT_EQ(text->get_header(), std::string("\x81\x05", 2));
+  EXPECT_EQ(text->get_payload(), "hello");
+
+  // Longer payloads get a 16 bit extended length
+  SharedMessage longer
+      = WebsocketServer::prepareBinaryMessage(std::string(300, 'x'));
+  EXPECT_EQ(longer->get_header(), std::string("\x82\x7e\x01\x2c", 4));
+  EXPECT_EQ(longer->get_payload().size(), 300);
+}
+
+//==============================================================================
+TEST(WEBSOCKET_SERVER, BROADCAST_SHARED_RESYNCS_LAGGING_CLIENTS)
+{
+  BufferedBytesWebsocketServer server;
+  server.setMaxBufferedBytes(100);
+  EXPECT_EQ(server.getMaxBufferedBytes(), 100);
+
+  std::shared_ptr<int> fast = std::make_shared<int>(0);
+  std::shared_ptr<int> slow = std::make_shared<int>(1);
+  ClientConnection fastConn = fast;
+  ClientConnection slowConn = slow;
+  server.addClient(fastConn);
+  server.addClient(slowConn);
+
+  SharedMessage message = WebsocketServer::prepareBinaryMessage("update");
+
+  // Nobody is behind yet, and both clients get the same buffer
+  server.broadcastShared(message);
+  EXPECT_TRUE(server.takeClientsToResync().empty());
+  ASSERT_EQ(server.sent[fastConn].size(), 1);
+  ASSERT_EQ(server.sent[slowConn].size(), 1);
+  EXPECT_EQ(server.sent[fastConn][0], message);
+  EXPECT_EQ(server.sent[slowConn][0], message);
+
+  // Once the slow client goes over the cap, it drops the broadcast, but it
+  // isn't resynced until it's drained to half the cap
+  server.bufferedBytes[slowConn] = 101;
+  server.broadcastShared(message);
+  EXPECT_TRUE(server.takeClientsToResync().empty());
+
+  // Being back under the cap isn't enough, since it's already missed an update
+  server.bufferedBytes[slowConn] = 60;
+  server.broadcastShared(message);
+  EXPECT_TRUE(server.takeClientsToResync().empty());
+  EXPECT_EQ(server.sent[fastConn].size(), 3);
+  EXPECT_EQ(server.sent[slowConn].size(), 1);
+
+  server.bufferedBytes[slowConn] = 50;
+  std::vector<ClientConnection> resync = server.takeClientsToResync();
+  EXPECT_EQ(resync.size(), 1);
+  EXPECT_TRUE(containsClient(resync, slowConn));
+  EXPECT_FALSE(containsClient(resync, fastConn));
+
+  // Taking the clients forgets that they dropped messages
+  EXPECT_TRUE(server.takeClientsToResync().empty());
+  server.broadcastShared(message);
+  EXPECT_TRUE(server.takeClientsToResync().empty());
+  EXPECT_EQ(server.sent[fastConn].size(), 4);
+  EXPECT_EQ(server.sent[slowConn].size(), 2);
+}
+
+//==============================================================================
+TEST(WEBSOCKET_SERVER, CLOSED_LAGGING_CLIENTS_ARE_FORGOTTEN)
+{
+  BufferedBytesWebsocketServer server;
+  server.setMaxBufferedBytes(100);
+
+  std::shared_ptr<int> slow = std::make_shared<int>(0);
+  ClientConnection slowConn = slow;
+  server.addClient(slowConn);
+
+  server.bufferedBytes[slowConn] = 200;
+  server.broadcastShared(WebsocketServer::prepareBinaryMessage("update"));
+
+  // The connection goes away before it catches up
+  slow.reset();
+  server.bufferedBytes.clear();
+  EXPECT_TRUE(server.takeClientsToResync().empty());
+}
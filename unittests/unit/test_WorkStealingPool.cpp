@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/common/WorkStealingPool.hpp"
+
+using namespace dart;
+using namespace common;
+
+//==============================================================================
+TEST(WorkStealingPool, COVERS_RANGE_EXACTLY_ONCE)
+{
+  WorkStealingPool pool(4);
+  std::vector<std::atomic<int>> visits(1000);
+  for (auto& v : visits)
+  {
+    v = 0;
+  }
+  pool.parallelFor(
+      0, visits.size(), 7, [&](int, int chunkBegin, int chunkEnd) {
+        for (int i = chunkBegin; i < chunkEnd; i++)
+        {
+          visits[i]++;
+        }
+      });
+  for (auto& v : visits)
+  {
+    EXPECT_EQ(v.load(), 1);
+  }
+}
+
+//==============================================================================
+TEST(WorkStealingPool, SLOTS_ARE_NEVER_SHARED)
+{
+  WorkStealingPool pool(4);
+  const int maxWorkers = 2;
+  const int numSlots = pool.getNumSlots(maxWorkers);
+  EXPECT_EQ(numSlots, 3);
+
+  std::vector<std::atomic<int>> inUse(numSlots);
+  std::vector<long> sums(numSlots, 0);
+  for (auto& v : inUse)
+  {
+    v = 0;
+  }
+  std::atomic<int> conflicts(0);
+  pool.parallelFor(
+      0,
+      10000,
+      1,
+      [&](int slot, int chunkBegin, int chunkEnd) {
+        ASSERT_LT(slot, numSlots);
+        if (inUse[slot]++ != 0)
+        {
+          conflicts++;
+        }
+        for (int i = chunkBegin; i < chunkEnd; i++)
+        {
+          sums[slot] += i;
+        }
+        inUse[slot]--;
+      },
+      maxWorkers);
+
+  EXPECT_EQ(conflicts.load(), 0);
+  long total = 0;
+  for (long sum : sums)
+  {
+    total += sum;
+  }
+  EXPECT_EQ(total, 10000L * 9999L / 2);
+}
+
+//==============================================================================
+TEST(WorkStealingPool, NESTED_LOOPS_FINISH)
+{
+  WorkStealingPool pool(2);
+  std::atomic<long> total(0);
+  pool.parallelFor(0, 16, 1, [&](int, int chunkBegin, int chunkEnd) {
+    for (int i = chunkBegin; i < chunkEnd; i++)
+    {
+      pool.parallelFor(0, 100, 10, [&](int, int innerBegin, int innerEnd) {
+        total += innerEnd - innerBegin;
+      });
+    }
+  });
+  EXPECT_EQ(total.load(), 1600);
+}
+
+//==============================================================================
+TEST(WorkStealingPool, RETHROWS_EXCEPTIONS)
+{
+  WorkStealingPool pool(3);
+  EXPECT_THROW(
+      pool.parallelFor(
+          0,
+          100,
+          1,
+          [&](int, int chunkBegin, int) {
+            if (chunkBegin == 42)
+            {
+              throw std::runtime_error("chunk 42 failed");
+            }
+          }),
+      std::runtime_error);
+
+  // The pool should still be usable afterwards
+  std::atomic<int> count(0);
+  pool.parallelFor(0, 100, 1, [&](int, int chunkBegin, int chunkEnd) {
+    count += chunkEnd - chunkBegin;
+  });
+  EXPECT_EQ(count.load(), 100);
+}
+
+//==============================================================================
+TEST(WorkStealingPool, ZERO_THREADS_RUNS_INLINE)
+{
+  WorkStealingPool pool(0);
+  EXPECT_EQ(pool.getNumSlots(), 1);
+  int count = 0;
+  pool.parallelFor(0, 50, 5, [&](int slot, int chunkBegin, int chunkEnd) {
+    EXPECT_EQ(slot, 0);
+    count += chunkEnd - chunkBegin;
+  });
+  EXPECT_EQ(count, 50);
+}
+
+//==============================================================================
+TEST(WorkStealingPool, TRACKS_STATS)
+{
+  WorkStealingPool pool(2);
+  WorkStealingPool::Stats before = pool.getStats();
+  pool.parallelFor(0, 100, 10, [&](int, int, int) {});
+  WorkStealingPool::Stats diff = pool.getStats().since(before);
+  EXPECT_EQ(diff.numLoops, 1);
+  EXPECT_EQ(diff.numChunks, 10);
+  EXPECT_GE(diff.wallSeconds, 0.0);
+  EXPECT_GE(diff.overheadSeconds, 0.0);
+  EXPECT_LE(diff.overheadSeconds, diff.wallSeconds);
+
+  pool.resetStats();
+  EXPECT_EQ(pool.getStats().numLoops, 0);
+}
+
+//==============================================================================
+TEST(WorkStealingPool, SCOPED_POOL_BINDS_CURRENT_POOL)
+{
+  std::shared_ptr<WorkStealingPool> global = WorkStealingPool::getGlobalPool();
+  EXPECT_EQ(WorkStealingPool::getCurrentPool(), global);
+
+  std::shared_ptr<WorkStealingPool> pool
+      = std::make_shared<WorkStealingPool>(3);
+  {
+    WorkStealingPool::ScopedPool scoped(pool);
+    EXPECT_EQ(WorkStealingPool::getCurrentPool(), pool);
+
+    // Loop bodies see the same pool, whether they run on this thread or on
+    // one of the pool's workers
+    std::atomic<int> numOnOtherPools(0);
+    WorkStealingPool::getCurrentPool()->parallelFor(
+        0, 64, 1, [&](int, int, int) {
+          if (WorkStealingPool::getCurrentPool() != pool)
+          {
+            numOnOtherPools++;
+          }
+        });
+    EXPECT_EQ(numOnOtherPools.load(), 0);
+
+    // Other threads are unaffected
+    std::shared_ptr<WorkStealingPool> otherThreadPool;
+    std::thread other(
+        [&]() { otherThreadPool = WorkStealingPool::getCurrentPool(); });
+    other.join();
+    EXPECT_EQ(otherThreadPool, global);
+  }
+  EXPECT_EQ(WorkStealingPool::getCurrentPool(), global);
+
+  // Workers only hold weak references to their pool, so it can still be
+  // destroyed
+  std::weak_ptr<WorkStealingPool> weakPool = pool;
+  pool = nullptr;
+  EXPECT_TRUE(weakPool.expired());
+}